@@ -1,8 +1,14 @@
 from aiohttp import web
+import asyncio
+import hashlib
 import re
 import json
+import time
 
-from controller import LIGHTSENSOR_RESOURCE, get_lightsensor_resource, set_lightsensor_threshold
+from controller import LIGHTSENSOR_ID, LIGHTSENSOR_RESOURCE, REQUEST_TIMEOUT, set_lightsensor_threshold
+from coapcache import CoapCache
+from timeseries import TimeSeriesStore, MAX_BUCKETS
+import metrics
 
 
 '''
@@ -14,6 +20,149 @@ FILE_MAC_CONFIG = 'mac.conf'
 FILE_MAC_AVAILABLE = 'mac_available.txt'
 FILE_STATE = 'controllerState.txt'
 
+# default span and bucket count of a history query
+HISTORY_SPAN = 86400
+HISTORY_BUCKETS = 200
+
+# quiet time after the last threshold write before it is sent, s
+WRITE_QUIET = 0.3
+
+# the store the controller writes, read in place
+history = TimeSeriesStore()
+
+# the metrics of the server, served with the controller's
+httpMetrics = metrics.Registry()
+HTTP_SECONDS = httpMetrics.histogram('http_request_seconds', 'Time of the HTTP handlers',
+                                     ('route', 'status'))
+THRESHOLD_WRITES = httpMetrics.counter('threshold_writes_total',
+                                       'Threshold writes taken from the web page', ('resource',))
+THRESHOLD_SENDS = httpMetrics.counter('threshold_coap_writes_total',
+                                      'Threshold writes sent to the light sensor', ('resource',))
+
+# the resources read from the nodes, see coapcache.py
+coapCache = CoapCache(httpMetrics)
+
+
+class WriteSlot:
+    """The pending write of one resource. A write replaces the value still
+    pending, so the last one wins, and the value is sent once no write came
+    for WRITE_QUIET, with one request at a time. A slider drag is one CoAP
+    write of where it stopped."""
+
+    def __init__(self, name, send):
+        self.name = name
+        self.send = send
+        self.pending = None     # value not sent yet
+        self.inflight = None    # value being sent
+        self.confirmed = None   # value the sensor took last
+        self.failed = False
+        self.version = 0        # writes taken
+        self.confirmedVersion = 0
+        self.timer = None
+
+    def put(self, value):
+        self.version += 1
+        self.pending = value
+        self.failed = False
+        THRESHOLD_WRITES.inc(self.name)
+        if self.timer is not None:
+            self.timer.cancel()
+        self.timer = asyncio.get_event_loop().call_later(WRITE_QUIET, self._quiet)
+
+    def value(self):
+        """The value the resource will have, the last one written."""
+        for value in (self.pending, self.inflight, self.confirmed):
+            if value is not None:
+                return value
+        return None
+
+    def _quiet(self):
+        self.timer = None
+        if self.inflight is None and self.pending is not None:
+            asyncio.ensure_future(self._flush())
+
+    async def _flush(self):
+        # A write that comes during a request is sent after it, once quiet
+        while self.pending is not None and self.timer is None:
+            value, version = self.pending, self.version
+            self.pending, self.inflight = None, value
+            THRESHOLD_SENDS.inc(self.name)
+            try:
+                ok = await asyncio.wait_for(self.send(value), REQUEST_TIMEOUT)
+            except asyncio.TimeoutError:
+                ok = False
+            self.inflight = None
+            if ok:
+                self.confirmed = value
+                self.confirmedVersion = version
+            self.failed = not ok and self.pending is None
+
+    def state(self):
+        if self.pending is not None or self.inflight is not None:
+            state = 'pending'
+        elif self.failed:
+            state = 'failed'
+        else:
+            state = 'confirmed'
+        return {'state': state, 'value': self.value(), 'confirmed': self.confirmed,
+                'version': self.version, 'confirmedVersion': self.confirmedVersion}
+
+
+# pending threshold writes, by resource
+writeSlots = {}
+
+
+def get_write_slot(resource, resource_uri):
+    slot = writeSlots.get(resource)
+    if slot is None:
+        async def send(value):
+            # the cached value is stale whether or not the write took
+            coapCache.invalidate(coap_uri(resource_uri))
+            try:
+                return await set_lightsensor_threshold(resource_uri, value)
+            finally:
+                coapCache.invalidate(coap_uri(resource_uri))
+        slot = WriteSlot(resource, send)
+        writeSlots[resource] = slot
+    return slot
+
+
+def coap_uri(resource_uri):
+    return 'coap://' + LIGHTSENSOR_ID + resource_uri.value[0]
+
+
+def cached_response(request, payload, etag, max_age):
+    """A response the browser keeps and revalidates: 304 if its
+    If-None-Match has the ETag, the one of the node or of the payload."""
+    if payload is None:
+        return web.Response(text='', headers={'Cache-Control': 'no-store'})
+    if etag is None:
+        etag = hashlib.sha1(payload.encode('utf-8')).digest()[:4]
+    etag = '"%s"' % etag.hex()
+    headers = {'ETag': etag, 'Cache-Control': 'max-age=%d, must-revalidate' % max_age}
+    tags = request.headers.get('If-None-Match', '')
+    if etag in (t.strip() for t in tags.split(',')) or tags.strip() == '*':
+        return web.Response(status=304, headers=headers)
+    return web.Response(text=payload, headers=headers)
+
+
+# times each handler, by the route it matched
+@web.middleware
+async def timed(request, handler):
+    route = request.match_info.route.resource
+    route = route.canonical if route is not None else 'unmatched'
+    start = time.monotonic()
+    status = 500
+    try:
+        response = await handler(request)
+        status = response.status
+        return response
+    except web.HTTPException as e:
+        status = e.status
+        raise
+    finally:
+        HTTP_SECONDS.observe(time.monotonic() - start, route, status)
+
 '''
 ------------------- GET ------------------
 '''
@@ -58,6 +207,39 @@ async def get_macs(request):
     return web.Response(text=html)
 
 
+# metrics of the controller, as it last wrote them, and of the server
+async def get_metrics(request):
+    try:
+        with open(metrics.METRICS_FILE) as f:
+            text = f.read()
+    except OSError:
+        text = ''
+    return web.Response(text=text + httpMetrics.render(),
+                        headers={'Content-Type': 'text/plain; version=0.0.4; charset=utf-8'})
+
+
+# list of the recorded series
+async def get_history_series(request):
+    return web.Response(text=json.dumps({'series': history.names()}))
+
+
+# one series, downsampled: ?from=<s>&to=<s>&buckets=<n>, times in s since
+# the epoch. Each bucket with records is [start, min, max, avg, count].
+async def get_history(request):
+    series = request.match_info.get('series', None)
+    try:
+        end = float(request.query.get('to', time.time()))
+        start = float(request.query.get('from', end - HISTORY_SPAN))
+        buckets = max(1, min(int(request.query.get('buckets', HISTORY_BUCKETS)), MAX_BUCKETS))
+        initial, out = history.query(series, start, end, buckets)
+    except ValueError as e:
+        return web.Response(status=400, text=str(e))
+
+    return web.Response(text=json.dumps({'series': series, 'from': start, 'to': end,
+                                         'step': (end - start) / buckets,
+                                         'initial': initial, 'buckets': out}))
+
+
 def get_threshold_uri_from_resource(resource):
     if resource == 'min':
         return LIGHTSENSOR_RESOURCE.THRESHOLD_MIN
@@ -72,8 +254,22 @@ async def get_threshold(request):
     if resource_uri is None:
         return web.Response(text="ERROR")
 
-    html = await get_lightsensor_resource(resource_uri)
-    return web.Response(text=html)
+    # a write not confirmed yet is read back as written, and not kept
+    slot = writeSlots.get(resource)
+    if slot is not None and slot.state()['state'] == 'pending':
+        return web.Response(text=slot.value(), headers={'Cache-Control': 'no-store'})
+
+    return cached_response(request, *await coapCache.get(coap_uri(resource_uri)))
+
+
+# state of the writes of a threshold: pending, confirmed or failed
+async def get_threshold_write(request):
+    resource = request.match_info.get('resource', None)
+    resource_uri = get_threshold_uri_from_resource(resource)
+    if resource_uri is None:
+        return web.Response(text="ERROR")
+
+    return web.Response(text=json.dumps(get_write_slot(resource, resource_uri).state()))
 
 
 '''
@@ -94,11 +290,12 @@ async def post_threshold(request):
 
     resource = request.match_info.get('resource', None)
     resource_uri = get_threshold_uri_from_resource(resource)
-    if resource_uri is None:
+    if resource_uri is None or newTreshold is None or not newTreshold.isdigit():
         return web.Response(text="ERROR")
 
-    await set_lightsensor_threshold(resource_uri, newTreshold)
-    return web.Response(text='')
+    slot = get_write_slot(resource, resource_uri)
+    slot.put(newTreshold)
+    return web.Response(text=json.dumps(slot.state()))
 
 
 '''
@@ -106,12 +303,16 @@ async def post_threshold(request):
 '''
 
 if __name__ == "__main__":
-    app = web.Application()
+    app = web.Application(middlewares=[timed])
     app.add_routes([web.get('/', get_index),
                     web.get('/state', get_controller_state),
                     web.get('/devices', get_macs),
                     web.get('/device', get_current_mac),
                     web.get('/lightsensor/threshold/{resource}', get_threshold),
+                    web.get('/lightsensor/threshold/{resource}/write', get_threshold_write),
+                    web.get('/metrics', get_metrics),
+                    web.get('/history', get_history_series),
+                    web.get('/history/{series:.+}', get_history),
 
                     web.post('/device&mac={macAddress}', post_mac),
                     web.post('/lightsensor/threshold/{resource}&val={thresholdValue}', post_threshold),
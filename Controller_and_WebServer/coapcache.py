@@ -0,0 +1,97 @@
+# Cache of the CoAP resources the web server reads
+# PR Sensor Networks, TU Berlin
+#
+# A response is kept for its Max-Age, as the node set it, and served from
+# the cache until then. Past it, the entry is revalidated with a GET that
+# carries its ETag, which a node answers 2.03 without the payload if it
+# still holds. Concurrent reads of a resource share one request. A write
+# through the server invalidates the entry, and a read started before the
+# write does not store what it got.
+
+import asyncio
+import time
+
+from aiocoap import Message, GET, VALID
+from controller import REQUEST_TIMEOUT, get_context
+
+# Max-Age of a response without the option (RFC 7252, 5.10.5)
+DEFAULT_MAX_AGE = 60
+
+
+class _Entry:
+    def __init__(self):
+        self.payload = None
+        self.etag = None        # the CoAP ETag, bytes
+        self.expires = 0.0      # time.monotonic() the payload is fresh until
+        self.generation = 0     # bumped by a write
+        self.fetch = None       # the request in flight, a future
+
+
+class CoapCache:
+    def __init__(self, registry):
+        self.entries = {}
+        self.requests = registry.counter(
+            'coap_cache_requests_total',
+            'Reads of the gateway cache: hit, miss, revalidated, shared or failed',
+            ('result',))
+
+    def _entry(self, uri):
+        entry = self.entries.get(uri)
+        if entry is None:
+            entry = self.entries[uri] = _Entry()
+        return entry
+
+    async def get(self, uri):
+        """The payload of a resource, its ETag and the s it is fresh for;
+        (None, None, 0) if the node did not answer."""
+        entry = self._entry(uri)
+        if entry.payload is not None and time.monotonic() < entry.expires:
+            self.requests.inc('hit')
+            return self._result(entry)
+        if entry.fetch is not None:
+            self.requests.inc('shared')
+        else:
+            entry.fetch = asyncio.ensure_future(self._fetch(uri, entry))
+        return await asyncio.shield(entry.fetch)
+
+    def invalidate(self, uri):
+        """Drops an entry, for a write to its resource."""
+        entry = self._entry(uri)
+        entry.payload = entry.etag = None
+        entry.expires = 0.0
+        entry.generation += 1
+
+    def _result(self, entry):
+        return entry.payload, entry.etag, max(0, int(entry.expires - time.monotonic()))
+
+    async def _fetch(self, uri, entry):
+        generation, held = entry.generation, entry.payload
+        request = Message(code=GET, uri=uri)
+        if entry.etag is not None:
+            request.opt.etags = (entry.etag,)
+        try:
+            protocol = await get_context()
+            response = await asyncio.wait_for(protocol.request(request).response,
+                                              REQUEST_TIMEOUT)
+        except Exception as e:
+            self.requests.inc('failed')
+            print('Failed to fetch resource', uri)
+            print(e)
+            return None, None, 0
+        finally:
+            entry.fetch = None
+
+        max_age = response.opt.max_age
+        expires = time.monotonic() + (DEFAULT_MAX_AGE if max_age is None else max_age)
+        if response.code == VALID and held is not None:
+            self.requests.inc('revalidated')
+            payload, etag = held, request.opt.etags[0]
+        else:
+            self.requests.inc('miss')
+            payload, etag = response.payload.decode('utf-8'), response.opt.etag
+
+        if generation != entry.generation:
+            # written meanwhile, the response may be from before the write
+            return payload, etag, 0
+        entry.payload, entry.etag, entry.expires = payload, etag, expires
+        return self._result(entry)
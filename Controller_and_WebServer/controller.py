@@ -8,11 +8,17 @@
 
 import time
 from sniffer import MACSniffer
+from registry import Registry, RT_DAYLIGHT, RT_DOOR, RT_LAMP, RT_GROUP, RT_ZONES
+import registry as reg
+from timeseries import TimeSeriesStore
+import metrics
 import logging
 import asyncio
+import os
 import signal
 import sys
 from enum import Enum
+from urllib.parse import urlsplit
 
 from aiocoap import *
 
@@ -24,77 +30,113 @@ class LIGHTSENSOR_RESOURCE(Enum):
     THRESHOLD_MAX = "/lightsensor/threshold/max",
     UNDEFINED = "UNDEFINED"
 
-LIGHTSENSOR_ID  = "[fd11:22::4]"
+# The IDs can be set from the environment, see sim_host/README.md
+LIGHTSENSOR_ID  = os.environ.get("LIGHTSENSOR_ID", "[fd11:22::4]")
 LIGHTSENSOR_BRIGHT = "bright"
 LIGHTSENSOR_DARK = "dark"
 
-LIGHTSWITCH_ID  = "[fd11:22::3]"
+LIGHTSWITCH_ID  = os.environ.get("LIGHTSWITCH_ID", "[fd11:22::3]")
 LIGHTSWITCH_RESOURCE = "/lamp/state"
 CMD_LIGHT_ON = 'on'
 CMD_LIGHT_OFF = 'off'
 
-DOOR_ID  = "[fd11:22::9]"
+DOOR_ID  = os.environ.get("DOOR_ID", "[fd11:22::9]")
 DOOR_RESOURCE = "/door/state"
 DOOR_OPEN = "open"
 
 DOOR_TIMEOUT = 15
 
+# Rooms of the devices, lines of "<address> <room>"
+ROOMS_FILE = 'rooms.conf'
 
+# Devices are discovered again every DISCOVERY_PERIOD s
+DISCOVERY_PERIOD = 300
+
+# Requests in flight at once over all rooms, and the time a request may
+# take, s. A sleepy node answers at its next data poll.
+MAX_REQUESTS = int(os.environ.get("MAX_REQUESTS", "32"))
+REQUEST_TIMEOUT = 20
+
+# Periods an input of a room is read at, s: FAST_PERIOD while the door is
+# open or just closed, or the daylight has just changed (SETTLE_PERIOD),
+# PERIOD otherwise. An input that cannot change the lamps of the room is
+# read at twice the period of the read before, up to MAX_PERIOD.
+FAST_PERIOD = 1
+PERIOD = 5
+MAX_PERIOD = 120
+SETTLE_PERIOD = 60
+
+# Time the acknowledgements of a zone command are collected for, s, past
+# the leisure of the relays (LIGHTRELAYS_GROUP_LEISURE_MS)
+GROUP_ACK_WINDOW = float(os.environ.get("GROUP_ACK_WINDOW", "1.0"))
 
 macsniff = None
+registry = Registry(ROOMS_FILE)
 
-async def get_lightsensor_resource(RESOURCE):
-    protocol = await Context.create_client_context()
-    print('Request GET', 'coap://' + LIGHTSENSOR_ID + RESOURCE.value[0])
-    request = Message(code=GET, uri='coap://' + LIGHTSENSOR_ID + RESOURCE.value[0])
-    try:
-        response = await protocol.request(request).response
-    except Exception as e:
-        print('Failed to fetch resource:')
-        print(e)
-    else:
-        return response.payload.decode("utf-8")
-    return None
+# History of the inputs, on change, and of the actuations, see timeseries.py
+history = TimeSeriesStore()
 
-async def get_doorstate():
-    protocol = await Context.create_client_context()
-    request = Message(code=GET, uri='coap://' + DOOR_ID + DOOR_RESOURCE)
-    try:
-        response = await protocol.request(request).response
-    except Exception as e:
-        print('Failed to fetch resource:')
-        print(e)
-    else:
-        return response.payload.decode("utf-8")
-    return None
+# Served at /metrics by asynchttpserver.py, see metrics.py
+CYCLE_SECONDS = metrics.registry.histogram(
+    "controller_cycle_seconds", "Time of a control cycle over all rooms")
+COAP_RTT = metrics.registry.histogram(
+    "controller_coap_rtt_seconds", "Round trip of the CoAP requests", ("device",))
+COAP_FAILURES = metrics.registry.counter(
+    "controller_coap_failures_total", "CoAP requests without a response", ("device",))
+ACTUATION_SECONDS = metrics.registry.histogram(
+    "controller_actuation_seconds",
+    "Time from a switch decision until the relays of the room acknowledged or were retried",
+    ("room",))
+RELAY_TOGGLES = metrics.registry.counter(
+    "controller_relay_toggles_total", "Switches of the lamps of a room", ("room", "state"))
+RELAY_RETRIES = metrics.registry.counter(
+    "controller_relay_retries_total", "Relays switched by unicast after a zone command", ("room",))
+PRESENCE_FLAPS = metrics.registry.counter(
+    "controller_presence_flaps_total", "Changes of the smartphone detection")
 
-async def set_lightsensor_threshold(RESOURCE, payload):
-    protocol = await Context.create_client_context()
-    request = Message(code=POST, uri='coap://' + LIGHTSENSOR_ID + RESOURCE.value[0], payload=payload.encode('utf-8'))
-    try:
-        response = await protocol.request(request).response
-    except Exception as e:
-        print('Failed to fetch resource:')
-        print(e)
-    else:
-        return True
-    return False
+# Sequence number of the zone commands. Started from the clock, so that
+# the relays take the commands of a restarted controller as newer.
+_commandSeq = int(time.time()) & 0xffffffff
 
-async def set_light_on():
-    protocol = await Context.create_client_context()
-    request = Message(code=POST, uri='coap://' + LIGHTSWITCH_ID + LIGHTSWITCH_RESOURCE, payload=CMD_LIGHT_ON.encode('utf-8'))
-    try:
-        response = await protocol.request(request).response
-    except Exception as e:
-        print('Failed to fetch resource:')
-        print(e)
-    else:
-        return True
-    return False
+_context = None
+_requests = None
 
-async def set_light_off():
+# Set to run the rooms at once, reading all their inputs
+_wakeup = None
+
+def wake():
+    """Wakes the control loop, for an input that was pushed."""
+    if _wakeup is not None:
+        _wakeup.set()
+
+async def get_context():
+    """One client context for all requests, bounded to MAX_REQUESTS."""
+    global _context, _requests
+    if _context is None:
+        _context = await Context.create_client_context()
+        _requests = asyncio.Semaphore(MAX_REQUESTS)
+    return _context
+
+async def request_payload(message):
+    """Payload of the response to a request, None on an error."""
+    protocol = await get_context()
+    device = urlsplit(message.get_request_uri()).netloc
+    async with _requests:
+        start = time.monotonic()
+        try:
+            response = await asyncio.wait_for(protocol.request(message).response,
+                                              REQUEST_TIMEOUT)
+        except Exception as e:
+            COAP_FAILURES.inc(device)
+            print('Failed to fetch resource', message.get_request_uri())
+            print(e)
+            return None
+        COAP_RTT.observe(time.monotonic() - start, device)
+    return response.payload.decode("utf-8")
+
+async def set_lightsensor_threshold(RESOURCE, payload):
     protocol = await Context.create_client_context()
-    request = Message(code=POST, uri='coap://' + LIGHTSWITCH_ID + LIGHTSWITCH_RESOURCE, payload=CMD_LIGHT_OFF.encode('utf-8'))
+    request = Message(code=POST, uri='coap://' + LIGHTSENSOR_ID + RESOURCE.value[0], payload=payload.encode('utf-8'))
     try:
         response = await protocol.request(request).response
     except Exception as e:
@@ -118,6 +160,181 @@ def calculate_new_state(lightOutside, smartphoneDetection, lastState, doorState)
     return False
 
 
+def record(series, value, changes_only=True):
+    """Appends to the history, a failing store does not stop the control."""
+    if value is None:
+        return
+    try:
+        history.append(series, value, changes_only=changes_only)
+    except (OSError, ValueError) as e:
+        print('Failed to record', series, e)
+
+def next_command_seq():
+    global _commandSeq
+    _commandSeq = (_commandSeq + 1) & 0xffffffff
+    return _commandSeq
+
+async def configure_zones():
+    """Has the relays of each room join the zone of the room."""
+    lamps = [(room, d) for room in registry.rooms() for d in room.having(RT_ZONES)
+             if d.zone != registry.zone(room.name)]
+    results = await asyncio.gather(*[
+        request_payload(Message(code=POST, uri=d.uri(RT_ZONES),
+                                payload=reg.zone_group(registry.zone(room.name)).encode('utf-8')))
+        for room, d in lamps])
+    for (room, d), result in zip(lamps, results):
+        if result is not None:
+            d.zone = registry.zone(room.name)
+
+async def switch_room(room, on):
+    """Switches the lamps of a room: one command to its zone, then unicast
+    retries to the relays whose acknowledgement did not come."""
+    state = CMD_LIGHT_ON if on else CMD_LIGHT_OFF
+    lamps = room.having(RT_LAMP)
+    zone = registry.zone(room.name)
+    grouped = [d for d in lamps if d.resource(RT_GROUP) and d.zone == zone]
+    seq = next_command_seq()
+    command = "{} {}".format(seq, state).encode('utf-8')
+
+    acked = set()
+    if grouped:
+        answers = await reg.group_request(reg.zone_address(zone), grouped[0].resource(RT_GROUP),
+                                          code=reg.POST, payload=command, window=GROUP_ACK_WINDOW)
+        for address, responses in answers.items():
+            for code, payload in responses:
+                ackSeq = payload.split(b' ')[0]
+                # A newer command than this one has applied as well
+                if (code == reg.CHANGED and ackSeq.isdigit() and
+                        ((int(ackSeq) - seq) & 0xffffffff) < 0x80000000):
+                    acked.add(address)
+
+    missed = [d for d in lamps if d.address not in acked]
+    results = await asyncio.gather(*[
+        request_payload(Message(code=POST, uri=d.uri(RT_GROUP), payload=command)
+                        if d.resource(RT_GROUP) else
+                        Message(code=POST, uri=d.uri(RT_LAMP), payload=state.encode('utf-8')))
+        for d in missed])
+    for d in missed:
+        # It may have lost its zone, it is told again at the next discovery
+        d.zone = None
+    record(room.name + "/lamps", 1 if on else 0, changes_only=False)
+    RELAY_TOGGLES.inc(room.name, state)
+    RELAY_RETRIES.inc(room.name, amount=len(missed))
+    print("\t{}: switch {} {} lamps, {} by zone {}, {} retried, {} failed".format(
+        room.name, state, len(lamps), len(acked), zone, len(missed),
+        sum(1 for r in results if r is None)))
+
+class RoomState:
+    def __init__(self):
+        self.lightState = False
+        self.lastDoorTime = 0
+        # last value of each input, when it was read and its period
+        self.lightOutside = None
+        self.door = None
+        self.lightChanged = 0
+        self.read = {RT_DOOR: 0, RT_DAYLIGHT: 0}
+        self.period = {RT_DOOR: PERIOD, RT_DAYLIGHT: PERIOD}
+
+    def due(self, rt):
+        return self.read[rt] + self.period[rt]
+
+    def next_due(self):
+        return min(self.due(rt) for rt in self.read)
+
+    def schedule(self, smartphoneDetection, doorOpenState, read):
+        """Picks the period of each input from what a change of it would
+        do to the lamps. The backoff grows with the inputs just read."""
+        now = time.monotonic()
+        flippedLight = {LIGHTSENSOR_BRIGHT: LIGHTSENSOR_DARK,
+                        LIGHTSENSOR_DARK: LIGHTSENSOR_BRIGHT}.get(self.lightOutside)
+        outcomes = {
+            RT_DAYLIGHT: (calculate_new_state(flippedLight, smartphoneDetection,
+                                              self.lightState, doorOpenState),
+                          now - self.lightChanged < SETTLE_PERIOD),
+            RT_DOOR: (calculate_new_state(self.lightOutside, smartphoneDetection,
+                                          self.lightState, not doorOpenState),
+                      doorOpenState),
+        }
+        for rt, (outcome, active) in outcomes.items():
+            if outcome is not None and outcome == self.lightState:
+                if rt in read:
+                    self.period[rt] = min(MAX_PERIOD, 2 * self.period[rt])
+            elif active:
+                self.period[rt] = FAST_PERIOD
+            else:
+                self.period[rt] = PERIOD
+
+def merge_daylight(values):
+    """Bright if a sensor of the room sees daylight."""
+    if LIGHTSENSOR_BRIGHT in values:
+        return LIGHTSENSOR_BRIGHT
+    if LIGHTSENSOR_DARK in values:
+        return LIGHTSENSOR_DARK
+    return None
+
+async def control_room(room, state, smartphoneDetection, readAll=False):
+    """One decision for a room, from one GET per door and light sensor whose
+    input is due, or all of them. The other inputs keep their last value."""
+    now = time.monotonic()
+    doors = room.having(RT_DOOR) if readAll or state.due(RT_DOOR) <= now else []
+    sensors = room.having(RT_DAYLIGHT) if readAll or state.due(RT_DAYLIGHT) <= now else []
+
+    values = await asyncio.gather(
+        *[request_payload(Message(code=GET, uri=d.uri(RT_DOOR))) for d in doors],
+        *[request_payload(Message(code=GET, uri=d.uri(RT_DAYLIGHT))) for d in sensors])
+    if doors:
+        doorValues = values[:len(doors)]
+        state.door = DOOR_OPEN if DOOR_OPEN in doorValues else next(
+            (v for v in doorValues if v is not None), None)
+        state.read[RT_DOOR] = now
+        if state.door == DOOR_OPEN:
+            state.lastDoorTime = time.time()
+    if sensors:
+        lightOutside = merge_daylight(values[len(doors):])
+        if lightOutside != state.lightOutside:
+            state.lightChanged = now
+        state.lightOutside = lightOutside
+        state.read[RT_DAYLIGHT] = now
+    lightOutside, door = state.lightOutside, state.door
+    doorOpenState = (state.lastDoorTime + DOOR_TIMEOUT) > time.time()
+
+    record(room.name + "/daylight", {LIGHTSENSOR_BRIGHT: 1, LIGHTSENSOR_DARK: 0}.get(lightOutside))
+    record(room.name + "/door", None if door is None else int(door == DOOR_OPEN))
+    record(room.name + "/phone", int(bool(smartphoneDetection)))
+
+    newLigtstate = calculate_new_state(lightOutside, smartphoneDetection, state.lightState, doorOpenState)
+    print("\t{}: light {}, door {}, lamps {}".format(room.name, lightOutside, door, newLigtstate))
+
+    if (newLigtstate is not None) and (newLigtstate != state.lightState):
+        state.lightState = newLigtstate
+        with ACTUATION_SECONDS.time(room.name):
+            await switch_room(room, newLigtstate)
+    state.schedule(smartphoneDetection, doorOpenState,
+                   ([RT_DOOR] if doors else []) + ([RT_DAYLIGHT] if sensors else []))
+
+    return (lightOutside, smartphoneDetection, door, doorOpenState, newLigtstate)
+
+async def discover_devices():
+    """Discovers the devices, the static IDs stand in if none answer."""
+    try:
+        count = await registry.discover()
+    except OSError as e:
+        print('Discovery failed:', e)
+        count = 0
+    print("\tdiscovered {} devices in {} rooms".format(count, len(registry.rooms())))
+    if not registry.devices:
+        for address, uri, rt in ((LIGHTSENSOR_ID, LIGHTSENSOR_RESOURCE.DAYLIGHT.value[0], RT_DAYLIGHT),
+                                 (DOOR_ID, DOOR_RESOURCE, RT_DOOR),
+                                 (LIGHTSWITCH_ID, LIGHTSWITCH_RESOURCE, RT_LAMP)):
+            registry.add(address, [(uri, {'rt': rt})])
+    await configure_zones()
+
+async def discovery_loop():
+    while True:
+        await asyncio.sleep(DISCOVERY_PERIOD)
+        await discover_devices()
+        wake()
+
 def signal_handler(sig, frame):
         print('Controller wird beendet')
         if(macsniff):
@@ -136,55 +353,66 @@ async def main():
     
     signal.signal(signal.SIGINT, signal_handler)
     
-    macsniff = MACSniffer('mac.conf', 'mac_available.txt')
-    lightState = False
-    lastDoorTime = 0#time.time() - 40
-    
+    global _wakeup
+    _wakeup = asyncio.Event()
+    loop = asyncio.get_event_loop()
+    # the sniffer threads push the changes of the detection
+    macsniff = MACSniffer('mac.conf', 'mac_available.txt',
+                          lambda: loop.call_soon_threadsafe(wake))
+    roomStates = {}
+    roomResults = {}
+    lastDetection = None
+
+    await discover_devices()
+    asyncio.ensure_future(discovery_loop())
+
     while True:
-        # request light sensor
-        print("new controller run")
-        door = await get_doorstate()
-        
-        
-        #mint = await get_lightsensor_resource(LIGHTSENSOR_RESOURCE.THRESHOLD_MIN)
-        #maxt = await get_lightsensor_resource(LIGHTSENSOR_RESOURCE.THRESHOLD_MAX)
-        #print("\tget light threshold:",mint, maxt)
-        
-        if door == DOOR_OPEN:
-            lastDoorTime = time.time()
-            print("\tGet open door")
-        
-        lightOutside = await get_lightsensor_resource(LIGHTSENSOR_RESOURCE.DAYLIGHT)
-        print("\tget light value:",lightOutside)
+        woken = _wakeup.is_set()
+        _wakeup.clear()
+        print("new controller run", "(woken)" if woken else "")
         smartphoneDetection = macsniff.detect_mac()
-        doorOpenState = (lastDoorTime + DOOR_TIMEOUT) > time.time()
-        
         print("\tconneted smart phone:", smartphoneDetection)
-        print("\tdoor trigger:", doorOpenState)
-        
-        
-        newLigtstate = calculate_new_state(lightOutside, smartphoneDetection, lightState, doorOpenState)
-        
-        with open("controllerState.txt", 'w') as f:
-            f.write("Light outsite: \t{}\n".format(lightOutside))
-            f.write("Smart phone detection: \t{}\n".format(smartphoneDetection))
-            f.write("Door current action: \t{}\n".format(door))
-            f.write("Door state: \t{}\n".format(doorOpenState))
-            f.write("Light relays: \t{}\n".format(newLigtstate))
-            f.close()
-        
-        if (newLigtstate is not None) and (newLigtstate != lightState):
-            lightState = newLigtstate
-            print("\tstate changes")
-            if lightState:
-                print("\tswitch on the light")
-                await set_light_on()
-            else:
-                print("\tswitch off the light")
-                await set_light_off()
-        print("\tGo to sleep for 5 seconds\n")
-        
-        await asyncio.sleep(5)
+        if lastDetection is not None and smartphoneDetection != lastDetection:
+            PRESENCE_FLAPS.inc()
+        lastDetection = smartphoneDetection
+
+        now = time.monotonic()
+        rooms = registry.rooms()
+        for room in rooms:
+            roomStates.setdefault(room.name, RoomState())
+        due = [room for room in rooms
+               if woken or roomStates[room.name].next_due() <= now]
+        with CYCLE_SECONDS.time():
+            results = await asyncio.gather(*[
+                control_room(room, roomStates[room.name], smartphoneDetection, woken)
+                for room in due])
+        roomResults.update((room.name, result) for room, result in zip(due, results))
+
+        # The web page shows the first room
+        if rooms and rooms[0].name in roomResults:
+            lightOutside, smartphoneDetection, door, doorOpenState, newLigtstate = roomResults[rooms[0].name]
+            with open("controllerState.txt", 'w') as f:
+                f.write("Light outsite: \t{}\n".format(lightOutside))
+                f.write("Smart phone detection: \t{}\n".format(smartphoneDetection))
+                f.write("Door current action: \t{}\n".format(door))
+                f.write("Door state: \t{}\n".format(doorOpenState))
+                f.write("Light relays: \t{}\n".format(newLigtstate))
+                f.close()
+        try:
+            metrics.registry.write()
+        except OSError as e:
+            print('Failed to write the metrics', e)
+
+        # Until the next input is due, or something wakes the loop
+        nextDue = min((roomStates[room.name].next_due() for room in rooms),
+                      default=time.monotonic() + PERIOD)
+        delay = max(0, nextDue - time.monotonic())
+        print("\tGo to sleep for {:.1f} seconds\n".format(delay))
+
+        try:
+            await asyncio.wait_for(_wakeup.wait(), delay)
+        except asyncio.TimeoutError:
+            pass
 
 if __name__ == "__main__":
     asyncio.get_event_loop().run_until_complete(main())
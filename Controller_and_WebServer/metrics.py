@@ -0,0 +1,136 @@
+# Counters and histograms of the controller, in the Prometheus text format
+# PR Sensor Networks, TU Berlin
+#
+# An update is an addition under a lock, the sniffer threads update them
+# as well as the event loop. The controller writes its metrics to
+# METRICS_FILE once a cycle, and asynchttpserver.py serves them at /metrics
+# with its own, since the two run as separate processes.
+
+import os
+import threading
+import time
+
+METRICS_FILE = os.environ.get("METRICS_FILE", "controllerMetrics.prom")
+
+# Upper bounds of the buckets, s: from a relay's RTT to a sleepy node's poll
+DEFAULT_BUCKETS = (0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 20)
+
+_lock = threading.Lock()
+
+
+def _labels(names, values):
+    if not names:
+        return ""
+    return "{" + ",".join('%s="%s"' % (n, str(v).replace("\\", "\\\\").replace('"', '\\"'))
+                          for n, v in zip(names, values)) + "}"
+
+
+class _Metric:
+    kind = None
+
+    def __init__(self, registry, name, help, labels=()):
+        self.name = name
+        self.help = help
+        self.labelnames = tuple(labels)
+        self.values = {}
+        registry.metrics.append(self)
+
+    def render(self):
+        lines = ["# HELP %s %s" % (self.name, self.help),
+                 "# TYPE %s %s" % (self.name, self.kind)]
+        with _lock:
+            items = sorted(self.values.items())
+            lines += self._render(items)
+        return lines
+
+
+class Counter(_Metric):
+    kind = "counter"
+
+    def inc(self, *labels, amount=1):
+        with _lock:
+            self.values[labels] = self.values.get(labels, 0) + amount
+
+    def _render(self, items):
+        return ["%s%s %s" % (self.name, _labels(self.labelnames, k), v) for k, v in items]
+
+
+class Histogram(_Metric):
+    kind = "histogram"
+
+    def __init__(self, registry, name, help, labels=(), buckets=DEFAULT_BUCKETS):
+        super().__init__(registry, name, help, labels)
+        self.bounds = tuple(buckets)
+
+    def observe(self, value, *labels):
+        with _lock:
+            state = self.values.get(labels)
+            if state is None:
+                # counts per bucket, not cumulative, then sum and count
+                state = self.values[labels] = [[0] * len(self.bounds), 0.0, 0]
+            for i, bound in enumerate(self.bounds):
+                if value <= bound:
+                    state[0][i] += 1
+                    break
+            state[1] += value
+            state[2] += 1
+
+    def time(self, *labels):
+        """A context manager that observes the time it encloses."""
+        return _Timer(self, labels)
+
+    def _render(self, items):
+        lines = []
+        for k, (counts, total, count) in items:
+            cumulative = 0
+            for bound, n in zip(self.bounds, counts):
+                cumulative += n
+                lines.append("%s_bucket%s %d" % (
+                    self.name, _labels(self.labelnames + ("le",), k + ("%g" % bound,)), cumulative))
+            lines.append("%s_bucket%s %d" % (
+                self.name, _labels(self.labelnames + ("le",), k + ("+Inf",)), count))
+            lines.append("%s_sum%s %r" % (self.name, _labels(self.labelnames, k), total))
+            lines.append("%s_count%s %d" % (self.name, _labels(self.labelnames, k), count))
+        return lines
+
+
+class _Timer:
+    def __init__(self, histogram, labels):
+        self.histogram = histogram
+        self.labels = labels
+
+    def __enter__(self):
+        self.start = time.monotonic()
+        return self
+
+    def __exit__(self, *exc):
+        self.histogram.observe(time.monotonic() - self.start, *self.labels)
+        return False
+
+
+class Registry:
+    def __init__(self):
+        self.metrics = []
+
+    def counter(self, name, help, labels=()):
+        return Counter(self, name, help, labels)
+
+    def histogram(self, name, help, labels=(), buckets=DEFAULT_BUCKETS):
+        return Histogram(self, name, help, labels, buckets)
+
+    def render(self):
+        lines = []
+        for metric in self.metrics:
+            lines += metric.render()
+        return "\n".join(lines) + "\n"
+
+    def write(self, path=METRICS_FILE):
+        """Replaces the file at once, a reader never sees half of it."""
+        temp = path + ".tmp"
+        with open(temp, "w") as f:
+            f.write(self.render())
+        os.replace(temp, path)
+
+
+# The metrics of the controller process
+registry = Registry()
@@ -0,0 +1,314 @@
+# Registry of the devices of the network, by room
+# PR Sensor Networks, TU Berlin
+#
+# The nodes list their resources at /.well-known/core, in the CoRE link
+# format (RFC 6690). The registry sends one multicast GET for it to all
+# nodes and keeps the devices that answer, with their resources, in the
+# room rooms.conf gives them. Each room gets a zone, a multicast group its
+# relays join so that one datagram switches them all.
+
+import asyncio
+import ipaddress
+import logging
+import os
+import random
+import socket
+import struct
+import time
+
+logger = logging.getLogger("registry")
+
+# Where the discovery goes: "[ff03::1]" (all nodes of the mesh, realm local)
+# or "<host>:<port>". DISCOVERY_INTERFACE is the interface name for IPv6,
+# the local address for IPv4.
+DISCOVERY_ADDRESS = os.environ.get("DISCOVERY_ADDRESS", "[ff03::1]")
+DISCOVERY_INTERFACE = os.environ.get("DISCOVERY_INTERFACE", "")
+
+# Time the answers are collected for, s. A sleepy node answers at its
+# next data poll.
+DISCOVERY_WINDOW = float(os.environ.get("DISCOVERY_WINDOW", "16"))
+
+# Rounds a device may miss before it is dropped
+DISCOVERY_MISSES = 3
+
+DEFAULT_ROOM = "default"
+
+# Multicast group of zone n, as the relays join it, and as the controller
+# sends to it. Both are the same on the mesh; they differ in the
+# simulation, where the group is mapped to a host group.
+ZONE_GROUP = os.environ.get("ZONE_GROUP", "ff05::1:{:x}")
+ZONE_ADDRESS = os.environ.get("ZONE_ADDRESS", "[ff05::1:{:x}]")
+
+COAP_PORT = 5683
+
+# Resource types of the firmware, see the coreLinks tables
+RT_DAYLIGHT = "light.daylight"
+RT_DOOR = "door.state"
+RT_LAMP = "lamp.state"
+RT_GROUP = "lamp.group"
+RT_ZONES = "lamp.zones"
+RT_BANK = "lamp.bank"
+
+GET, POST = 0x01, 0x02
+CHANGED, CONTENT = 0x44, 0x45
+
+
+def zone_group(zone):
+    """The group the relays of a zone join."""
+    return ZONE_GROUP.format(zone)
+
+
+def zone_address(zone):
+    """Where the commands to a zone are sent."""
+    return ZONE_ADDRESS.format(zone)
+
+
+def split_address(address):
+    """Host and port of "[v6]", "[v6]:port", "v4" or "v4:port"."""
+    if address.startswith("["):
+        host, _, rest = address[1:].partition("]")
+        port = int(rest[1:]) if rest.startswith(":") else COAP_PORT
+    elif address.count(":") == 1:
+        host, port = address.split(":")
+        port = int(port)
+    else:
+        host, port = address, COAP_PORT
+    return host, port
+
+
+def join_address(host, port):
+    """The authority of the coap:// URIs, as split_address() takes it."""
+    if ipaddress.ip_address(host).version == 6:
+        host = "[" + host + "]"
+    return host if port == COAP_PORT else "%s:%d" % (host, port)
+
+
+def parse_link_format(text):
+    """Links of a link format payload, as (uri path, {attribute: value})."""
+    links = []
+    for link in split_outside_quotes(text, ","):
+        link = link.strip()
+        if not link.startswith("<") or ">" not in link:
+            continue
+        uri, _, params = link[1:].partition(">")
+        attrs = {}
+        for param in split_outside_quotes(params, ";"):
+            name, _, value = param.strip().partition("=")
+            if name:
+                attrs[name] = value.strip('"')
+        links.append(("/" + uri.lstrip("/"), attrs))
+    return links
+
+
+def split_outside_quotes(text, sep):
+    parts, start, quoted = [], 0, False
+    for i, c in enumerate(text):
+        if c == '"':
+            quoted = not quoted
+        elif c == sep and not quoted:
+            parts.append(text[start:i])
+            start = i + 1
+    parts.append(text[start:])
+    return parts
+
+
+def coap_request(code, mid, token, path, query=None, payload=b""):
+    """A NON request, as multicasts are sent."""
+    out = bytearray([0x50 | len(token), code]) + struct.pack(">H", mid) + token
+    options = [(11, s.encode()) for s in path.strip("/").split("/")]
+    if query:
+        options.append((15, query.encode()))
+    last = 0
+    for number, value in options:
+        out += coap_option(number - last, value)
+        last = number
+    if payload:
+        out += b"\xff" + payload
+    return bytes(out)
+
+
+def coap_option(delta, value):
+    def nibble(n):
+        if n < 13:
+            return n, b""
+        if n < 269:
+            return 13, bytes([n - 13])
+        return 14, struct.pack(">H", n - 269)
+    d, dext = nibble(delta)
+    l, lext = nibble(len(value))
+    return bytes([(d << 4) | l]) + dext + lext + value
+
+
+def coap_response(data, token):
+    """Code and payload of a response to token, None for other datagrams."""
+    if len(data) < 4 or data[0] >> 6 != 1:
+        return None
+    tkl = data[0] & 0xf
+    if data[4:4 + tkl] != token or data[1] < 0x40:
+        return None
+    marker = data.find(b"\xff", 4 + tkl)
+    return data[1], (data[marker + 1:] if marker >= 0 else b"")
+
+
+class Device:
+    def __init__(self, address, links, room=DEFAULT_ROOM):
+        self.address = address
+        self.links = links
+        self.room = room
+        self.misses = 0
+        self.zone = None    # zone the relay was told to join
+
+    def resource(self, rt):
+        """URI path of the resource of a type, None if it has none."""
+        for uri, attrs in self.links:
+            if rt in attrs.get("rt", "").split():
+                return uri
+        return None
+
+    def uri(self, rt):
+        return "coap://" + self.address + self.resource(rt)
+
+    def __repr__(self):
+        return "Device(%s, %s)" % (self.address, self.room)
+
+
+class Room:
+    def __init__(self, name):
+        self.name = name
+        self.devices = []
+
+    def having(self, rt):
+        """The devices of the room with a resource of a type."""
+        return [d for d in self.devices if d.resource(rt) is not None]
+
+
+class _Collector(asyncio.DatagramProtocol):
+    def __init__(self, token):
+        self.token = token
+        self.answers = {}
+
+    def datagram_received(self, data, addr):
+        response = coap_response(data, self.token)
+        if response is not None:
+            address = join_address(addr[0], addr[1])
+            self.answers.setdefault(address, []).append(response)
+
+
+async def group_request(address, path, code=GET, query=None, payload=b"",
+                        window=DISCOVERY_WINDOW):
+    """Sends one NON request to a multicast address and collects the
+    responses for a window. Returns {device address: [(code, payload)]}."""
+    host, port = split_address(address)
+    family = socket.AF_INET6 if ":" in host else socket.AF_INET
+    sock = socket.socket(family, socket.SOCK_DGRAM)
+    if family == socket.AF_INET6:
+        sock.setsockopt(socket.IPPROTO_IPV6, socket.IPV6_MULTICAST_HOPS, 8)
+        if DISCOVERY_INTERFACE:
+            sock.setsockopt(socket.IPPROTO_IPV6, socket.IPV6_MULTICAST_IF,
+                            socket.if_nametoindex(DISCOVERY_INTERFACE))
+        sock.bind(("::", 0))
+    else:
+        if DISCOVERY_INTERFACE:
+            sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_IF,
+                            socket.inet_aton(DISCOVERY_INTERFACE))
+        sock.bind(("0.0.0.0", 0))
+
+    token = os.urandom(4)
+    loop = asyncio.get_running_loop()
+    transport, collector = await loop.create_datagram_endpoint(
+        lambda: _Collector(token), sock=sock)
+    try:
+        transport.sendto(coap_request(code, random.randrange(0x10000), token,
+                                      path, query, payload), (host, port))
+        await asyncio.sleep(window)
+    finally:
+        transport.close()
+    return collector.answers
+
+
+class Registry:
+    def __init__(self, rooms_file=None):
+        self.devices = {}
+        self.rooms_of = {}
+        self.zones = {}
+        if rooms_file is not None and os.path.exists(rooms_file):
+            self.load_rooms(rooms_file)
+
+    def load_rooms(self, path):
+        """Lines of "<address> <room>", the address as the device answers."""
+        with open(path) as f:
+            for line in f:
+                fields = line.split("#")[0].split()
+                if len(fields) == 2:
+                    self.rooms_of[fields[0]] = fields[1]
+
+    def add(self, address, links):
+        device = self.devices.get(address)
+        if device is None:
+            device = Device(address, links,
+                            self.rooms_of.get(address, DEFAULT_ROOM))
+            self.devices[address] = device
+            logger.info("new device %s in %s: %s", address, device.room,
+                        " ".join(uri for uri, _ in links))
+        else:
+            device.links = links
+            device.misses = 0
+        return device
+
+    def rooms(self):
+        """The rooms with devices, by name."""
+        rooms = {}
+        for device in self.devices.values():
+            rooms.setdefault(device.room, Room(device.room)).devices.append(device)
+        return [rooms[name] for name in sorted(rooms)]
+
+    def having(self, rt):
+        return [d for d in self.devices.values() if d.resource(rt) is not None]
+
+    def zone(self, room):
+        """Zone number of a room, kept for the life of the registry."""
+        if room not in self.zones:
+            self.zones[room] = len(self.zones) + 1
+        return self.zones[room]
+
+    async def discover(self, query=None, window=DISCOVERY_WINDOW):
+        """One discovery round, returns the number of devices that answered.
+        Devices that missed DISCOVERY_MISSES rounds are dropped."""
+        answers = await group_request(DISCOVERY_ADDRESS, "/.well-known/core",
+                                      query=query, window=window)
+        found = {}
+        for address, responses in answers.items():
+            for code, payload in responses:
+                if code == CONTENT:
+                    found.setdefault(address, []).extend(
+                        parse_link_format(payload.decode("utf-8", "replace")))
+
+        for address, links in found.items():
+            self.add(address, links)
+        if query is None:
+            for address in list(self.devices):
+                device = self.devices[address]
+                if address not in found:
+                    device.misses += 1
+                    if device.misses >= DISCOVERY_MISSES:
+                        logger.info("device %s gone", address)
+                        del self.devices[address]
+        return len(found)
+
+
+async def _main():
+    import sys
+    logging.basicConfig(level=logging.INFO)
+    registry = Registry(sys.argv[1] if len(sys.argv) > 1 else None)
+    t0 = time.monotonic()
+    count = await registry.discover()
+    print("%d devices in %.1f s" % (count, time.monotonic() - t0))
+    for room in registry.rooms():
+        print(room.name)
+        for device in room.devices:
+            print("  %s %s" % (device.address,
+                               " ".join(uri for uri, _ in device.links)))
+
+
+if __name__ == "__main__":
+    asyncio.run(_main())
@@ -1,14 +1,82 @@
 import threading
 import time
 import subprocess
+import metrics
+import ipaddress
+import select
+import socket
+import struct
 
 timeout = 15
 interface = 'enp1s0'
 c = threading.Condition()
 flag = False
 devices = []
+
+# A device silent for PROBE_START * timeout is probed, at half the time it
+# has left before the timeout, at most every PROBE_MIN s. An absent device
+# is probed every PROBE_ABSENT s, at the addresses it had last.
+PROBE_START = 0.5
+PROBE_MIN = 1.0
+PROBE_ABSENT = 10.0
+
+# Period the neighbor tables are read at, s, and the addresses probed per
+# device and family, the most recent ones
+NEIGHBOR_PERIOD = 5.0
+PROBE_ADDRESSES = 2
+
+# A device seen again within FLAP_WINDOW s of its timeout was not gone
+FLAP_WINDOW = 120
+
+FRAMES = metrics.registry.counter(
+    "sniffer_frames_total", "Frames seen by the sniffer")
+MATCHED_FRAMES = metrics.registry.counter(
+    "sniffer_matched_frames_total", "Frames from a device of mac.conf")
+PROBES = metrics.registry.counter(
+    "sniffer_probes_total", "ARP requests and neighbor solicitations sent", ("proto",))
+PROBE_REPLIES = metrics.registry.counter(
+    "sniffer_probe_replies_total", "Replies to the probes", ("proto",))
+PROBE_RTT = metrics.registry.histogram(
+    "sniffer_probe_rtt_seconds", "Time from the first unanswered probe to a reply", ("proto",))
+DETECT_SECONDS = metrics.registry.histogram(
+    "sniffer_detect_seconds",
+    "Time from a device's entry in the neighbor table to its detection, on arrival",
+    ("source",), buckets=(0.1, 0.5, 1, 2, 5, 10, 15, 30, 60, 120))
+UNTIMED_DETECTIONS = metrics.registry.counter(
+    "sniffer_untimed_detections_total",
+    "Arrivals detected before the neighbor table had the device, not in sniffer_detect_seconds",
+    ("source",))
+DEVICE_FLAPS = metrics.registry.counter(
+    "sniffer_presence_flaps_total",
+    "Devices timed out and seen again within FLAP_WINDOW")
 configFile = ""
 detectionFile = ""
+onChange = None
+
+
+def set_flag(value):
+    """Sets the detection, with c held, and tells a change to onChange."""
+    global flag
+    if value != flag:
+        flag = value
+        if onChange is not None:
+            onChange()
+
+
+def seen(device, source, now=None):
+    """A sign of life of a device, a frame or a probe reply, with c held."""
+    now = time.time() if now is None else now
+    if device['time'] == 0:
+        print('Find device: ' + device['mac'] + ' by ' + source)
+        if now - device.get('gone', 0) < FLAP_WINDOW:
+            DEVICE_FLAPS.inc()
+        appeared = device.get('appeared', 0)
+        if appeared:
+            DETECT_SECONDS.observe(max(0.0, now - appeared), source)
+        else:
+            UNTIMED_DETECTIONS.inc(source)
+    device['time'] = now
+    set_flag(True)
 
 
 class TsharkSniffer(threading.Thread):
@@ -23,11 +91,12 @@ class TsharkSniffer(threading.Thread):
         
         allMacs = []
         
-        self.tshark = subprocess.Popen(['tshark -e eth.src -Tfields -j "eth.src" -i enp1s0'], shell=True, stdout=subprocess.PIPE, bufsize=1, universal_newlines=True)
+        self.tshark = subprocess.Popen(['tshark -e eth.src -Tfields -j "eth.src" -i ' + interface], shell=True, stdout=subprocess.PIPE, bufsize=1, universal_newlines=True)
         while self.tshark.poll() is None and not self._stopevent.isSet(  ):
             mymac = self.tshark.stdout.readline().replace('\n', '')
             if len(mymac) !=17:
                 continue
+            FRAMES.inc()
             c.acquire()
             
             if mymac not in allMacs:
@@ -36,11 +105,8 @@ class TsharkSniffer(threading.Thread):
             
             for device in devices:
                 if device['mac'] == mymac:
-                    if device['time'] == 0:
-                        print('Find device: ' + mymac)
-                    now = time.time()
-                    device['time'] = now
-                    flag = True
+                    MATCHED_FRAMES.inc()
+                    seen(device, 'frame')
             c.release()
             
             with open(detectionFile, 'w') as f:
@@ -95,14 +161,17 @@ class ListCleaner(threading.Thread):
                 devices.append({'mac': mac, 'time': 0})
             
             c.acquire()
-            flag = False
+            present = False
             for device in devices:
                 if device['time'] > earlistPopUp:
-                    flag = True
+                    present = True
                 else:
                     if device['time'] > 0:
                         device['time'] = 0
+                        device['gone'] = now
+                        device['appeared'] = 0
                         print('Device is gone: ' + device['mac'])
+            set_flag(present)
             c.release()
             
             with open(detectionFile, 'w') as f:
@@ -118,14 +187,242 @@ class ListCleaner(threading.Thread):
         threading.Thread.join(self, timeout)
 
 
+ETH_P_ARP = 0x0806
+ETH_P_IPV6 = 0x86DD
+ICMPV6_SOLICIT, ICMPV6_ADVERT = 135, 136
+
+
+def mac_bytes(mac):
+    return bytes(int(b, 16) for b in mac.split(':'))
+
+
+def mac_str(data):
+    return ':'.join('%02x' % b for b in data)
+
+
+def read_neighbors(iface):
+    """The neighbor tables of an interface: [(address, mac, state)]."""
+    try:
+        out = subprocess.run(['ip', 'neigh', 'show', 'dev', iface],
+                             stdout=subprocess.PIPE, universal_newlines=True,
+                             timeout=5).stdout
+    except (OSError, subprocess.SubprocessError):
+        return []
+    neighbors = []
+    for line in out.splitlines():
+        fields = line.split()
+        if 'lladdr' in fields and fields.index('lladdr') + 1 < len(fields):
+            neighbors.append((fields[0], fields[fields.index('lladdr') + 1].lower(),
+                              fields[-1]))
+    return neighbors
+
+
+def checksum(data):
+    if len(data) % 2:
+        data += b'\0'
+    total = sum(struct.unpack('!%dH' % (len(data) // 2), data))
+    while total >> 16:
+        total = (total & 0xffff) + (total >> 16)
+    return ~total & 0xffff
+
+
+class ActiveProber(threading.Thread):
+    """Probes the devices of mac.conf at the IPv4 and IPv6 addresses the
+    neighbor tables give them, with a unicast ARP request or neighbor
+    solicitation to their MAC. A phone that sleeps its radio answers at its
+    next beacon, well before it would send a frame of its own. A reply is a
+    sign of life as a frame is, see seen(). The addresses are also learnt
+    from the ARP and ICMPv6 frames of the devices, as the table of this
+    host may not have them on a switched network."""
+
+    def __init__(self, iface=None):
+        threading.Thread.__init__(self)
+        self._stopevent = threading.Event()
+        self.iface = iface or interface
+        self.addresses = {}     # mac: {address: time last in the table}
+        self.states = {}        # address: its state in the table last
+        self.next = {}          # mac: time of its next probe
+        self.sent = {}          # (proto, mac): time of the first unanswered probe
+        self.neighborsRead = 0
+
+    def open(self):
+        self.arp = socket.socket(socket.AF_PACKET, socket.SOCK_RAW, socket.htons(ETH_P_ARP))
+        self.arp.bind((self.iface, ETH_P_ARP))
+        self.ipv6 = socket.socket(socket.AF_PACKET, socket.SOCK_RAW, socket.htons(ETH_P_IPV6))
+        self.ipv6.bind((self.iface, ETH_P_IPV6))
+        with open('/sys/class/net/%s/address' % self.iface) as f:
+            self.mac = mac_bytes(f.read().strip())
+        self.linkLocal = None
+        with open('/proc/net/if_inet6') as f:
+            for line in f:
+                fields = line.split()
+                if fields[5] == self.iface and fields[3] == '20':
+                    self.linkLocal = bytes.fromhex(fields[0])
+
+    def run(self):
+        try:
+            self.open()
+        except OSError as e:
+            # needs CAP_NET_RAW, as the capture does
+            print('no active probing on', self.iface, e)
+            return
+        while not self._stopevent.is_set():
+            now = time.time()
+            if now - self.neighborsRead >= NEIGHBOR_PERIOD:
+                self.neighborsRead = now
+                self.read_neighbors(now)
+            self.probe(now)
+            ready, _, _ = select.select([self.arp, self.ipv6], [], [], 0.5)
+            for sock in ready:
+                self.receive(sock)
+        self.arp.close()
+        self.ipv6.close()
+
+    def tracked(self):
+        c.acquire()
+        byMac = {d['mac'].lower(): d for d in devices}
+        c.release()
+        return byMac
+
+    def read_neighbors(self, now):
+        byMac = self.tracked()
+        for address, mac, state in read_neighbors(self.iface):
+            if mac not in byMac:
+                continue
+            known = self.addresses.setdefault(mac, {})
+            known[address] = now
+            # An address that becomes reachable while the device is absent
+            # is its arrival, the detection is timed from there
+            if state == 'REACHABLE' and self.states.get(address) != 'REACHABLE':
+                c.acquire()
+                device = byMac[mac]
+                if device['time'] == 0 and not device.get('appeared'):
+                    device['appeared'] = now
+                c.release()
+            self.states[address] = state
+        for mac in list(self.addresses):
+            if mac not in byMac:
+                del self.addresses[mac]
+
+    def probe(self, now):
+        for mac, device in self.tracked().items():
+            last = device['time']
+            if last > 0 and now - last < PROBE_START * timeout:
+                self.next.pop(mac, None)
+                continue
+            if now < self.next.get(mac, 0):
+                continue
+            if last > 0:
+                self.next[mac] = now + max(PROBE_MIN, (timeout - (now - last)) / 2)
+            else:
+                self.next[mac] = now + PROBE_ABSENT
+            known = sorted(self.addresses.get(mac, {}).items(), key=lambda a: -a[1])
+            for family in (4, 6):
+                addresses = [a for a, _ in known
+                             if ipaddress.ip_address(a).version == family][:PROBE_ADDRESSES]
+                for address in addresses:
+                    try:
+                        if family == 4:
+                            self.send_arp(mac, address)
+                        else:
+                            self.send_solicit(mac, address)
+                    except OSError as e:
+                        print('probe of', mac, address, 'failed:', e)
+                        continue
+                    proto = 'arp' if family == 4 else 'ndp'
+                    PROBES.inc(proto)
+                    self.sent.setdefault((proto, mac), now)
+
+    def source_address(self, address, family):
+        """The address of the host on the way to another, None if none."""
+        s = socket.socket(family, socket.SOCK_DGRAM)
+        try:
+            if family == socket.AF_INET6:
+                s.connect((address, 9, 0, socket.if_nametoindex(self.iface)))
+            else:
+                s.connect((address, 9))
+            return s.getsockname()[0]
+        except OSError:
+            return None
+        finally:
+            s.close()
+
+    def send_arp(self, mac, address):
+        source = self.source_address(address, socket.AF_INET)
+        if source is None:
+            return
+        arp = struct.pack('!HHBBH6s4s6s4s', 1, 0x0800, 6, 4, 1,
+                          self.mac, socket.inet_aton(source),
+                          b'\0' * 6, socket.inet_aton(address))
+        self.arp.send(mac_bytes(mac) + self.mac + struct.pack('!H', ETH_P_ARP) + arp)
+
+    def send_solicit(self, mac, address):
+        target = ipaddress.IPv6Address(address).packed
+        source = self.linkLocal
+        if source is None:
+            return
+        # type, code, checksum, reserved, target, source link-layer option
+        icmp = struct.pack('!BBHI16sBB6s', ICMPV6_SOLICIT, 0, 0, 0, target, 1, 1, self.mac)
+        pseudo = source + target + struct.pack('!I3xB', len(icmp), socket.IPPROTO_ICMPV6)
+        icmp = icmp[:2] + struct.pack('!H', checksum(pseudo + icmp)) + icmp[4:]
+        ipv6 = struct.pack('!IHBB16s16s', 6 << 28, len(icmp), socket.IPPROTO_ICMPV6, 255,
+                           source, target)
+        self.ipv6.send(mac_bytes(mac) + self.mac + struct.pack('!H', ETH_P_IPV6) + ipv6 + icmp)
+
+    def receive(self, sock):
+        try:
+            frame = sock.recv(2048)
+        except OSError:
+            return
+        if len(frame) < 14 or frame[6:12] == self.mac:
+            return
+        mac = mac_str(frame[6:12])
+        if sock is self.arp:
+            # any ARP from the device counts, a reply is an answer
+            if len(frame) < 42:
+                return
+            proto = 'arp'
+            answer = struct.unpack('!H', frame[20:22])[0] == 2
+            address = socket.inet_ntoa(frame[28:32])
+        else:
+            # ICMPv6 without extension headers, an advertisement is an answer
+            if len(frame) < 55 or frame[20] != socket.IPPROTO_ICMPV6:
+                return
+            proto = 'ndp'
+            answer = frame[54] == ICMPV6_ADVERT
+            address = str(ipaddress.IPv6Address(frame[22:38]))
+        device = self.tracked().get(mac)
+        if device is None:
+            return
+        now = time.time()
+        if address not in ('0.0.0.0', '::'):
+            self.addresses.setdefault(mac, {})[address] = now
+        if answer:
+            start = self.sent.pop((proto, mac), None)
+            if start is not None:
+                PROBE_REPLIES.inc(proto)
+                PROBE_RTT.observe(now - start, proto)
+        c.acquire()
+        seen(device, proto)
+        c.release()
+        self.next.pop(mac, None)
+
+    def join(self, timeout=None):
+        """ Stop the thread. """
+        self._stopevent.set()
+        threading.Thread.join(self, timeout)
+
+
 class MACSniffer(object):
-    def __init__(self, confile, detectFile): 
+    def __init__(self, confile, detectFile, changed=None):
         global devices
         global configFile
         global detectionFile
+        global onChange
         
         detectionFile = detectFile
         configFile = confile
+        onChange = changed
         
         print("read MAC-Addresses from file " + configFile)
         confFile = open(configFile, "r")
@@ -141,8 +438,10 @@ class MACSniffer(object):
         confFile.close()
         self.sniffer = TsharkSniffer()
         self.cleaner = ListCleaner()
+        self.prober = ActiveProber()
         self.sniffer.start()
         self.cleaner.start()
+        self.prober.start()
 
     
     def detect_mac(self):
@@ -156,5 +455,6 @@ class MACSniffer(object):
     def exit(self):
         self.sniffer.join()
         self.cleaner.join()
+        self.prober.join()
 
 
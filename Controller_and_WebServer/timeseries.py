@@ -0,0 +1,291 @@
+# Time-series store of the controller's inputs and actuations
+# PR Sensor Networks, TU Berlin
+#
+# Each series, "<room>/<name>", is a directory of segments. A segment is an
+# append-only file of fixed-size records, (time s, value) as two doubles in
+# the byte order of the host, named by the time of its first record in ms.
+# The writer starts a new segment when one is full or old, and drops the
+# segments past the retention. Readers map the segments and search and
+# aggregate them in place, so a query does not copy the records, and can
+# run in another process than the writer, as asynchttpserver.py does.
+
+import bisect
+import mmap
+import os
+import re
+import struct
+import time
+
+# Where the store is, relative to the working directory of the controller
+TIMESERIES_DIR = os.environ.get("TIMESERIES_DIR", "timeseries")
+
+# A segment is sealed at SEGMENT_RECORDS records or SEGMENT_SECONDS s
+SEGMENT_RECORDS = int(os.environ.get("TIMESERIES_SEGMENT_RECORDS", "65536"))
+SEGMENT_SECONDS = float(os.environ.get("TIMESERIES_SEGMENT_SECONDS", "86400"))
+
+# Segments wholly older than RETENTION_DAYS are deleted, and a series keeps
+# MAX_SEGMENTS at most
+RETENTION_DAYS = float(os.environ.get("TIMESERIES_RETENTION_DAYS", "90"))
+MAX_SEGMENTS = int(os.environ.get("TIMESERIES_MAX_SEGMENTS", "400"))
+
+# Most buckets a query returns
+MAX_BUCKETS = 2000
+
+RECORD = struct.Struct("=dd")
+SEGMENT_SUFFIX = ".seg"
+
+_NAME = re.compile(r"^[\w.-]+(/[\w.-]+)*$")
+
+
+def valid_name(name):
+    return bool(_NAME.match(name)) and ".." not in name.split("/")
+
+
+class _Segment:
+    """A segment mapped for reading. The records are seen as one array of
+    doubles, time at even indexes and value at odd ones."""
+
+    def __init__(self, path, start):
+        self.path = path
+        self.start = start
+        self.map = None
+        self.values = memoryview(b"").cast("d")
+        self.times = self.values
+        self.size = 0
+
+    def refresh(self):
+        """Maps the records appended since the last call, if any."""
+        size = os.path.getsize(self.path)
+        size -= size % RECORD.size
+        if size == self.size:
+            return
+        self.close()
+        if size > 0:
+            with open(self.path, "rb") as f:
+                self.map = mmap.mmap(f.fileno(), size, access=mmap.ACCESS_READ)
+            array = memoryview(self.map).cast("d")
+            self.times = array[0::2]
+            self.values = array[1::2]
+        self.size = size
+
+    def close(self):
+        if self.map is not None:
+            self.times.release()
+            self.values.release()
+            self.times = self.values = memoryview(b"").cast("d")
+            self.map.close()
+            self.map = None
+        self.size = 0
+
+    def __len__(self):
+        return len(self.times)
+
+
+class _Series:
+    def __init__(self, path):
+        self.path = path
+        self.segments = []
+        self.fd = None
+        self.count = 0       # records in the segment written to
+        self.last = None     # last record written, (time, value)
+
+    def scan(self):
+        """Picks up the segments on disk, keeping the ones mapped already."""
+        mapped = {s.path: s for s in self.segments}
+        segments = []
+        try:
+            names = sorted(n for n in os.listdir(self.path) if n.endswith(SEGMENT_SUFFIX))
+        except FileNotFoundError:
+            names = []
+        for name in names:
+            path = os.path.join(self.path, name)
+            segment = mapped.pop(path, None)
+            if segment is None:
+                segment = _Segment(path, int(name[:-len(SEGMENT_SUFFIX)]) / 1000.0)
+            segments.append(segment)
+        for segment in mapped.values():
+            segment.close()
+        self.segments = segments
+
+    def close(self):
+        if self.fd is not None:
+            os.close(self.fd)
+            self.fd = None
+        for segment in self.segments:
+            segment.close()
+
+
+class TimeSeriesStore:
+    def __init__(self, directory=TIMESERIES_DIR):
+        self.directory = directory
+        self.series = {}
+
+    def _series(self, name):
+        if not valid_name(name):
+            raise ValueError("bad series name: %r" % name)
+        series = self.series.get(name)
+        if series is None:
+            series = _Series(os.path.join(self.directory, *name.split("/")))
+            self.series[name] = series
+        return series
+
+    def names(self):
+        """The series in the store."""
+        names = []
+        for root, dirs, files in os.walk(self.directory):
+            dirs.sort()
+            if any(f.endswith(SEGMENT_SUFFIX) for f in files):
+                names.append(os.path.relpath(root, self.directory).replace(os.sep, "/"))
+        return names
+
+    # Writing
+
+    def _open_tail(self, series):
+        """Opens the last segment of a series to append to, after a torn
+        record a crash may have left is cut off."""
+        os.makedirs(series.path, exist_ok=True)
+        series.scan()
+        if not series.segments:
+            return
+        path = series.segments[-1].path
+        size = os.path.getsize(path)
+        if size % RECORD.size:
+            size -= size % RECORD.size
+            os.truncate(path, size)
+        series.fd = os.open(path, os.O_WRONLY | os.O_APPEND)
+        series.count = size // RECORD.size
+        if size:
+            with open(path, "rb") as f:
+                f.seek(size - RECORD.size)
+                series.last = RECORD.unpack(f.read(RECORD.size))
+
+    def _rotate(self, series, t):
+        if series.fd is not None:
+            os.close(series.fd)
+        path = os.path.join(series.path, "%013d%s" % (int(t * 1000), SEGMENT_SUFFIX))
+        series.fd = os.open(path, os.O_WRONLY | os.O_APPEND | os.O_CREAT, 0o644)
+        series.count = 0
+        series.scan()
+        self._expire(series, t)
+
+    def _expire(self, series, now):
+        """Deletes the segments past the retention. A segment is past it
+        when the next one starts before the limit."""
+        limit = now - RETENTION_DAYS * 86400
+        segments = series.segments
+        drop = 0
+        while drop < len(segments) - 1 and (segments[drop + 1].start <= limit or
+                                            len(segments) - drop > MAX_SEGMENTS):
+            drop += 1
+        for segment in segments[:drop]:
+            segment.close()
+            os.remove(segment.path)
+        del segments[:drop]
+
+    def append(self, name, value, t=None, changes_only=False):
+        """Appends a record to a series, at the time t or now. With
+        changes_only, a value equal to the last one is not recorded.
+        Returns whether a record was written."""
+        series = self._series(name)
+        if series.fd is None:
+            self._open_tail(series)
+        value = float(value)
+        t = time.time() if t is None else float(t)
+        if series.last is not None:
+            if changes_only and series.last[1] == value:
+                return False
+            # A series is kept in time order, for the searches
+            t = max(t, series.last[0])
+        if (series.fd is None or series.count >= SEGMENT_RECORDS or
+                (series.segments and t - series.segments[-1].start >= SEGMENT_SECONDS)):
+            self._rotate(series, t)
+        os.write(series.fd, RECORD.pack(t, value))
+        series.count += 1
+        series.last = (t, value)
+        return True
+
+    # Reading
+
+    def query(self, name, start, end, buckets):
+        """Downsamples a series over [start, end) to a number of buckets of
+        equal length. Returns the value held at start (None if there is no
+        record before it) and, for each bucket with records, (bucket start,
+        min, max, avg, count). A bucket's min and max include the value held
+        at its start, as a series records changes."""
+        series = self._series(name)
+        series.scan()
+        buckets = max(1, min(int(buckets), MAX_BUCKETS))
+        step = (end - start) / buckets
+        if step <= 0:
+            raise ValueError("empty time range")
+        for segment in series.segments:
+            segment.refresh()
+
+        initial = held = self._held_at(series, start)
+        out = []
+        for segment in series.segments:
+            times, values = segment.times, segment.values
+            if not len(times) or times[-1] < start or times[0] >= end:
+                continue
+            lo = bisect.bisect_left(times, start)
+            hi = bisect.bisect_left(times, end, lo)
+            while lo < hi:
+                b = min(int((times[lo] - start) // step), buckets - 1)
+                j = max(bisect.bisect_left(times, start + (b + 1) * step, lo, hi), lo + 1)
+                chunk = values[lo:j]
+                low, high, total, count = min(chunk), max(chunk), sum(chunk), j - lo
+                if out and out[-1][0] == start + b * step:
+                    # the bucket began in the segment before
+                    _, pl, ph, pa, pc = out.pop()
+                    low, high = min(low, pl), max(high, ph)
+                    total, count = total + pa * pc, count + pc
+                elif held is not None:
+                    low, high = min(low, held), max(high, held)
+                out.append((start + b * step, low, high, total / count, count))
+                held = values[j - 1]
+                lo = j
+        return initial, out
+
+    def _held_at(self, series, t):
+        """The value of a series just before time t, None if none."""
+        for segment in reversed(series.segments):
+            if len(segment) and segment.times[0] < t:
+                return segment.values[bisect.bisect_left(segment.times, t) - 1]
+        return None
+
+    def close(self):
+        for series in self.series.values():
+            series.close()
+        self.series = {}
+
+
+def _bench(directory, days=31, period=5.0):
+    """Writes days of a series changing every period s, then times queries."""
+    store = TimeSeriesStore(directory)
+    end = time.time()
+    start = end - days * 86400
+    t0 = time.monotonic()
+    count = int(days * 86400 / period)
+    for i in range(count):
+        store.append("bench/lux", (i * 37) % 1000, start + i * period)
+    print("wrote %d records in %.1f s, %d segments" % (
+        count, time.monotonic() - t0, len(store.series["bench/lux"].segments)))
+    store.close()
+
+    reader = TimeSeriesStore(directory)
+    for span, buckets in ((days * 86400, 200), (days * 86400, 2000), (86400, 288), (3600, 60)):
+        times = []
+        for _ in range(5):
+            t0 = time.monotonic()
+            held, out = reader.query("bench/lux", end - span, end, buckets)
+            times.append(time.monotonic() - t0)
+        print("%8d s in %4d buckets: %3d with records, %.1f ms" % (
+            span, buckets, len(out), 1000 * sorted(times)[len(times) // 2]))
+    reader.close()
+
+
+if __name__ == "__main__":
+    import sys
+    import tempfile
+    with tempfile.TemporaryDirectory() as directory:
+        _bench(sys.argv[1] if len(sys.argv) > 1 else directory)
@@ -0,0 +1,548 @@
+/******************************************************************************
+
+ @file  alarmsim.c
+
+ @brief Host simulation of the platform alarm modules under OpenThread timers
+
+ Runs platform/alarm.c and platform/alarm_micro.c on simulated time, or the
+ POSIX timer modules they replaced when built with SIM_POSIX. A model of
+ the OpenThread timer scheduler keeps the ms and us alarms set for the
+ earliest of its timers, and the timers of a scenario re-arm themselves as
+ the stack's do.
+
+   alarmsim [-s scenario] [-t seconds] [-o seconds] [-p us] [-c]
+
+   -s  sed     a sleepy end device: data poll every 4 s with a 2 ms
+               receive window on the us alarm, a report every 30 s and
+               supervision every 240 s (default)
+       router  trickle and retransmission timers of 0.1 to 4 s, and a
+               chain of us alarms of 0.2 to 5 ms
+       long    one timer every 90 minutes, longer than the clock is set for
+   -t  simulated run time, 3600 by default
+   -o  RTC time at the start, to cross the 32 bit wrap of the ms or us count
+   -p  time the stack task runs for each alarm signal, 20 us by default
+   -c  check the run: no timer fired early, none late by more than
+       SIM_LATE_BOUND us, every periodic timer fired as often as it should
+
+ *****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <openthread/platform/alarm-micro.h>
+#include <openthread/platform/alarm-milli.h>
+
+#include "platform.h"
+#include "simrtc.h"
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+// Most a timer may be late in a checked run, in us
+#define SIM_LATE_BOUND      100
+
+// Past the run time, for the events due right at its end
+#define SIM_MARGIN_NS       500000000ULL
+
+#define SIM_MAX_TIMERS      4
+
+typedef struct StackTimer StackTimer;
+
+struct StackTimer
+{
+    const char *name;
+    bool        micro;
+    uint32_t    period;     // fixed period in the alarm's unit, or 0
+    uint32_t    fire;       // in the alarm's unit, wraps
+    uint64_t    fireNs;     // when the alarm's count reaches fire
+    bool        armed;
+    uint32_t    fired;
+    void        (*handler)(StackTimer *aTimer);
+};
+
+typedef struct
+{
+    float   *late;          // us
+    size_t   count;
+    size_t   size;
+    uint32_t early;
+} LateLog;
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static StackTimer  timers[SIM_MAX_TIMERS];
+static int         timerCount;
+
+static bool     pendingMilli;
+static bool     pendingMicro;
+static bool     progress;
+static uint64_t taskRuns;
+static uint64_t spins;
+
+static LateLog  lateMilli;
+static LateLog  lateMicro;
+
+static uint32_t randState = 1;
+
+//*****************************************************************************
+// Simulated OpenThread timer scheduler
+//*****************************************************************************
+
+static uint32_t simRand(uint32_t low, uint32_t high)
+{
+    randState = randState * 1103515245U + 12345U;
+    return (low + (randState >> 8) % (high - low + 1));
+}
+
+static uint32_t alarmNow(bool micro)
+{
+    return (micro ? otPlatAlarmMicroGetNow() : otPlatAlarmMilliGetNow());
+}
+
+/* Time in ns at which the alarm's count reaches a value near the current */
+static uint64_t alarmTimeNs(bool micro, uint32_t value)
+{
+    uint64_t unit = micro ? 1000U : 1000000U;
+    uint32_t now  = alarmNow(micro);
+    uint64_t est  = simNow / unit;
+    uint64_t now64;
+
+    // The count is the time truncated to 32 bits, and may trail it a bit
+    now64 = est + (int32_t)(now - (uint32_t)est);
+    return ((now64 + (int32_t)(value - now)) * unit);
+}
+
+static StackTimer *timerAdd(const char *name, bool micro, uint32_t period,
+                            void (*handler)(StackTimer *aTimer))
+{
+    StackTimer *timer = &timers[timerCount++];
+
+    timer->name    = name;
+    timer->micro   = micro;
+    timer->period  = period;
+    timer->handler = handler;
+    return (timer);
+}
+
+/* As TimerScheduler::SetAlarm() */
+static void schedulerSetAlarm(bool micro)
+{
+    StackTimer *first = NULL;
+    uint32_t    now;
+    int         i;
+
+    for (i = 0; i < timerCount; i++)
+    {
+        StackTimer *timer = &timers[i];
+
+        if (timer->armed && timer->micro == micro &&
+            (first == NULL || (int32_t)(timer->fire - first->fire) < 0))
+        {
+            first = timer;
+        }
+    }
+
+    if (first == NULL)
+    {
+        if (micro)
+        {
+            otPlatAlarmMicroStop(NULL);
+        }
+        else
+        {
+            otPlatAlarmMilliStop(NULL);
+        }
+        return;
+    }
+
+    now = alarmNow(micro);
+    if (micro)
+    {
+        otPlatAlarmMicroStartAt(NULL, now, ((int32_t)(first->fire - now) > 0)
+                                               ? first->fire - now : 0);
+    }
+    else
+    {
+        otPlatAlarmMilliStartAt(NULL, now, ((int32_t)(first->fire - now) > 0)
+                                               ? first->fire - now : 0);
+    }
+}
+
+static void timerStartAt(StackTimer *aTimer, uint32_t aFire)
+{
+    aTimer->fire   = aFire;
+    aTimer->fireNs = alarmTimeNs(aTimer->micro, aFire);
+    aTimer->armed  = true;
+    schedulerSetAlarm(aTimer->micro);
+}
+
+static void timerStart(StackTimer *aTimer, uint32_t aDt)
+{
+    timerStartAt(aTimer, alarmNow(aTimer->micro) + aDt);
+}
+
+static void lateAdd(LateLog *aLog, int64_t aLateNs)
+{
+    if (aLateNs < 0)
+    {
+        aLog->early++;
+    }
+    if (aLog->count == aLog->size)
+    {
+        aLog->size = aLog->size ? aLog->size * 2 : 4096;
+        aLog->late = realloc(aLog->late, aLog->size * sizeof(*aLog->late));
+        if (aLog->late == NULL)
+        {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    aLog->late[aLog->count++] = aLateNs / 1000.0f;
+}
+
+/* As TimerScheduler::ProcessTimers(), one expired timer per alarm */
+static void schedulerFired(bool micro)
+{
+    StackTimer *first = NULL;
+    uint32_t    now   = alarmNow(micro);
+    int         i;
+
+    progress = true;
+
+    for (i = 0; i < timerCount; i++)
+    {
+        StackTimer *timer = &timers[i];
+
+        if (timer->armed && timer->micro == micro &&
+            (first == NULL || (int32_t)(timer->fire - first->fire) < 0))
+        {
+            first = timer;
+        }
+    }
+
+    if (first != NULL && (int32_t)(now - first->fire) >= 0)
+    {
+        first->armed = false;
+        first->fired++;
+        lateAdd(micro ? &lateMicro : &lateMilli,
+                (int64_t)(simNow - first->fireNs));
+        first->handler(first);
+    }
+
+    schedulerSetAlarm(micro);
+}
+
+void otPlatAlarmMilliFired(otInstance *aInstance)
+{
+    (void)aInstance;
+    schedulerFired(false);
+}
+
+void otPlatAlarmMicroFired(otInstance *aInstance)
+{
+    (void)aInstance;
+    schedulerFired(true);
+}
+
+void otPlatDiagAlarmFired(otInstance *aInstance)
+{
+    (void)aInstance;
+}
+
+//*****************************************************************************
+// Stack task
+//*****************************************************************************
+
+void platformAlarmSignal(void)
+{
+    pendingMilli = true;
+}
+
+void platformAlarmMicroSignal(void)
+{
+    pendingMicro = true;
+}
+
+/* Runs the stack task until it has nothing left to process */
+static void taskRun(int processUs)
+{
+    while (pendingMilli || pendingMicro)
+    {
+        simNow += processUs * 1000ULL;
+        taskRuns++;
+
+        progress = false;
+        if (pendingMilli)
+        {
+            pendingMilli = false;
+            platformAlarmProcess(NULL);
+        }
+        if (pendingMicro)
+        {
+            pendingMicro = false;
+            platformAlarmMicroProcess(NULL);
+        }
+        if (!progress)
+        {
+            spins++;
+        }
+    }
+}
+
+//*****************************************************************************
+// Scenarios
+//*****************************************************************************
+
+static StackTimer *rxWindow;
+
+static void periodic(StackTimer *aTimer)
+{
+    timerStartAt(aTimer, aTimer->fire + aTimer->period);
+}
+
+static void dataPoll(StackTimer *aTimer)
+{
+    periodic(aTimer);
+    timerStart(rxWindow, 2000);
+}
+
+static void nothing(StackTimer *aTimer)
+{
+    (void)aTimer;
+}
+
+static void trickle(StackTimer *aTimer)
+{
+    timerStart(aTimer, simRand(100, 1000));
+}
+
+static void retransmit(StackTimer *aTimer)
+{
+    timerStart(aTimer, simRand(2000, 4000));
+}
+
+static void macChain(StackTimer *aTimer)
+{
+    timerStart(aTimer, simRand(200, 5000));
+}
+
+static int scenarioStart(const char *aName)
+{
+    if (strcmp(aName, "sed") == 0)
+    {
+        rxWindow = timerAdd("rx window", true, 0, nothing);
+        timerStart(timerAdd("data poll", false, 4000, dataPoll), 4000);
+        timerStart(timerAdd("report", false, 30000, periodic), 30000);
+        timerStart(timerAdd("supervision", false, 240000, periodic), 240000);
+    }
+    else if (strcmp(aName, "router") == 0)
+    {
+        trickle(timerAdd("trickle", false, 0, trickle));
+        retransmit(timerAdd("retransmit", false, 0, retransmit));
+        macChain(timerAdd("mac", true, 0, macChain));
+    }
+    else if (strcmp(aName, "long") == 0)
+    {
+        timerStart(timerAdd("long", false, 5400000, periodic), 5400000);
+    }
+    else
+    {
+        return (-1);
+    }
+    return (0);
+}
+
+//*****************************************************************************
+// Results
+//*****************************************************************************
+
+static int floatCompare(const void *a, const void *b)
+{
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+
+    return ((x > y) - (x < y));
+}
+
+static void latePrint(const char *aName, LateLog *aLog)
+{
+    double sum = 0;
+    size_t i;
+
+    if (aLog->count == 0)
+    {
+        printf("  %-4s alarms      0\n", aName);
+        return;
+    }
+    qsort(aLog->late, aLog->count, sizeof(*aLog->late), floatCompare);
+    for (i = 0; i < aLog->count; i++)
+    {
+        sum += aLog->late[i];
+    }
+    printf("  %-4s alarms %6zu  late us mean %6.1f  p99 %6.1f  max %6.1f"
+           "  early %u\n", aName, aLog->count, sum / aLog->count,
+           aLog->late[(aLog->count * 99) / 100],
+           aLog->late[aLog->count - 1], aLog->early);
+}
+
+static int check(double aSeconds)
+{
+    int errors = 0;
+    int i;
+
+    for (i = 0; i < timerCount; i++)
+    {
+        StackTimer *timer = &timers[i];
+
+        if (timer->period != 0)
+        {
+            uint32_t expected = (uint32_t)(aSeconds * 1000 / timer->period);
+
+            if (timer->fired != expected)
+            {
+                printf("%s: fired %u times, expected %u\n", timer->name,
+                       timer->fired, expected);
+                errors++;
+            }
+        }
+    }
+    if (rxWindow != NULL && rxWindow->fired != timers[1].fired)
+    {
+        printf("rx window: fired %u times for %u polls\n", rxWindow->fired,
+               timers[1].fired);
+        errors++;
+    }
+    if (lateMilli.early != 0 || lateMicro.early != 0)
+    {
+        printf("timers fired early\n");
+        errors++;
+    }
+    if ((lateMilli.count != 0 &&
+         lateMilli.late[lateMilli.count - 1] > SIM_LATE_BOUND) ||
+        (lateMicro.count != 0 &&
+         lateMicro.late[lateMicro.count - 1] > SIM_LATE_BOUND))
+    {
+        printf("timers late by more than %d us\n", SIM_LATE_BOUND);
+        errors++;
+    }
+
+#ifndef SIM_POSIX
+    {
+        PlatformAlarm_Stats stats;
+
+        platformAlarmGetStats(&stats);
+        if (stats.wakeups != simClockExpiries)
+        {
+            printf("alarm module counted %u wakeups of %llu\n", stats.wakeups,
+                   (unsigned long long)simClockExpiries);
+            errors++;
+        }
+    }
+#endif
+
+    return (errors);
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: alarmsim [-s sed|router|long] [-t seconds] "
+                    "[-o seconds] [-p us] [-c]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    const char *scenario  = "sed";
+    double      seconds   = 3600;
+    double      offset    = 0;
+    int         processUs = 20;
+    bool        checkRun  = false;
+    uint64_t    start;
+    uint64_t    end;
+    uint64_t    next;
+    double      hours;
+    int         opt;
+
+    while ((opt = getopt(argc, argv, "s:t:o:p:c")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            scenario = optarg;
+            break;
+        case 't':
+            seconds = atof(optarg);
+            break;
+        case 'o':
+            offset = atof(optarg);
+            break;
+        case 'p':
+            processUs = atoi(optarg);
+            break;
+        case 'c':
+            checkRun = true;
+            break;
+        default:
+            usage();
+        }
+    }
+
+    start  = (uint64_t)(offset * 1e9);
+    end    = start + (uint64_t)(seconds * 1e9) + SIM_MARGIN_NS;
+    simNow = start;
+
+    platformAlarmInit();
+    platformAlarmMicroInit();
+    if (scenarioStart(scenario) != 0)
+    {
+        usage();
+    }
+    taskRun(processUs);
+
+    while (simClockNext(&next) && next <= end)
+    {
+        if (next > simNow)
+        {
+            simNow = next;
+        }
+        simClockRun();
+        taskRun(processUs);
+    }
+
+    hours = seconds / 3600;
+#ifdef SIM_POSIX
+    printf("%s, posix timers:\n", scenario);
+#else
+    printf("%s, rtc alarm:\n", scenario);
+#endif
+    printf("  wakeups per hour %8.0f  task runs per hour %8.0f"
+           "  spins %llu\n", simClockExpiries / hours, taskRuns / hours,
+           (unsigned long long)spins);
+    latePrint("ms", &lateMilli);
+    latePrint("us", &lateMicro);
+#ifndef SIM_POSIX
+    {
+        PlatformAlarm_Stats stats;
+
+        platformAlarmGetStats(&stats);
+        printf("  diag alarm: wakeups %u early %u fired %u clock sets %u"
+               " late mean %u max %u\n", stats.wakeups, stats.early,
+               stats.fired, stats.clockSets,
+               stats.fired ? stats.lateTotal / stats.fired : 0,
+               stats.lateMax);
+    }
+#endif
+
+    if (checkRun)
+    {
+        return (check(seconds) ? 1 : 0);
+    }
+    return (0);
+}
@@ -0,0 +1,19 @@
+/*
+ * Host stand-in for the OpenThread us alarm platform API.
+ */
+#ifndef OPENTHREAD_PLATFORM_ALARM_MICRO_H
+#define OPENTHREAD_PLATFORM_ALARM_MICRO_H
+
+#include <stdint.h>
+
+#include <openthread/instance.h>
+
+void otPlatAlarmMicroStartAt(otInstance *aInstance, uint32_t aT0,
+                             uint32_t aDt);
+void otPlatAlarmMicroStop(otInstance *aInstance);
+uint32_t otPlatAlarmMicroGetNow(void);
+
+/* Implemented by the simulated stack */
+extern void otPlatAlarmMicroFired(otInstance *aInstance);
+
+#endif /* OPENTHREAD_PLATFORM_ALARM_MICRO_H */
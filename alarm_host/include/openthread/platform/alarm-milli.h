@@ -0,0 +1,19 @@
+/*
+ * Host stand-in for the OpenThread ms alarm platform API.
+ */
+#ifndef OPENTHREAD_PLATFORM_ALARM_MILLI_H
+#define OPENTHREAD_PLATFORM_ALARM_MILLI_H
+
+#include <stdint.h>
+
+#include <openthread/instance.h>
+
+void otPlatAlarmMilliStartAt(otInstance *aInstance, uint32_t aT0,
+                             uint32_t aDt);
+void otPlatAlarmMilliStop(otInstance *aInstance);
+uint32_t otPlatAlarmMilliGetNow(void);
+
+/* Implemented by the simulated stack */
+extern void otPlatAlarmMilliFired(otInstance *aInstance);
+
+#endif /* OPENTHREAD_PLATFORM_ALARM_MILLI_H */
@@ -0,0 +1,19 @@
+/*
+ * Host stand-in for the OpenThread diagnostics platform API, diagnostics
+ * mode is never entered on the host.
+ */
+#ifndef OPENTHREAD_PLATFORM_DIAG_H
+#define OPENTHREAD_PLATFORM_DIAG_H
+
+#include <stdbool.h>
+
+#include <openthread/instance.h>
+
+static inline bool otPlatDiagModeGet(void)
+{
+    return (false);
+}
+
+extern void otPlatDiagAlarmFired(otInstance *aInstance);
+
+#endif /* OPENTHREAD_PLATFORM_DIAG_H */
@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for the driverlib always-on RTC, read from the simulated
+ * time of simrtc.c.
+ */
+#ifndef AON_RTC_H
+#define AON_RTC_H
+
+#include <stdint.h>
+
+/* Seconds in the upper 32 bits, fraction of a second in the lower */
+extern uint64_t AONRTCCurrent64BitValueGet(void);
+
+#endif /* AON_RTC_H */
@@ -0,0 +1,55 @@
+/*
+ * Host stand-in for the TI-RTOS Clock module, run on the simulated time of
+ * simrtc.c. Ticks come from the RTC as in TickMode_DYNAMIC.
+ */
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef FALSE
+#define FALSE   0
+#define TRUE    1
+#endif
+
+typedef uintptr_t UArg;
+typedef void (*Clock_FuncPtr)(UArg arg);
+
+/* As Clock.tickPeriod in release.cfg, us */
+#define Clock_tickPeriod    ((uint32_t)10)
+
+typedef struct Clock_Struct
+{
+    Clock_FuncPtr        fxn;
+    UArg                 arg;
+    uint32_t             timeout;
+    uint64_t             expiryTick;
+    bool                 active;
+    struct Clock_Struct *next;
+} Clock_Struct;
+
+typedef Clock_Struct *Clock_Handle;
+
+typedef struct
+{
+    uint32_t period;
+    bool     startFlag;
+    UArg     arg;
+} Clock_Params;
+
+extern void Clock_Params_init(Clock_Params *params);
+extern void Clock_construct(Clock_Struct *clock, Clock_FuncPtr fxn,
+                            uint32_t timeout, const Clock_Params *params);
+extern void Clock_setTimeout(Clock_Handle handle, uint32_t timeout);
+extern void Clock_start(Clock_Handle handle);
+extern void Clock_stop(Clock_Handle handle);
+extern bool Clock_isActive(Clock_Handle handle);
+extern uint32_t Clock_getTicks(void);
+
+static inline Clock_Handle Clock_handle(Clock_Struct *clock)
+{
+    return (clock);
+}
+
+#endif /* CLOCK_H */
@@ -0,0 +1,27 @@
+/*
+ * Included ahead of the POSIX timer alarm modules. Their clock and timer
+ * calls go to the TI-RTOS POSIX layer, modelled in simrtc.c on simulated
+ * Clock objects.
+ */
+#ifndef SIMPOSIX_H
+#define SIMPOSIX_H
+
+#include <signal.h>
+#include <time.h>
+
+#define clock_gettime   simClockGettime
+#define clock_settime   simClockSettime
+#define timer_create    simTimerCreate
+#define timer_settime   simTimerSettime
+#define timer_gettime   simTimerGettime
+
+extern int simClockGettime(clockid_t clockId, struct timespec *tp);
+extern int simClockSettime(clockid_t clockId, const struct timespec *tp);
+extern int simTimerCreate(clockid_t clockId, struct sigevent *evp,
+                          timer_t *timerId);
+extern int simTimerSettime(timer_t timerId, int flags,
+                           const struct itimerspec *value,
+                           struct itimerspec *ovalue);
+extern int simTimerGettime(timer_t timerId, struct itimerspec *value);
+
+#endif /* SIMPOSIX_H */
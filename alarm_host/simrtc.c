@@ -0,0 +1,270 @@
+/******************************************************************************
+
+ @file  simrtc.c
+
+ @brief Simulated time for host builds of the platform alarm modules
+
+ *****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/devices/DeviceFamily.h>
+#include DeviceFamily_constructPath(driverlib/aon_rtc.h)
+
+#include "posix/simposix.h"
+#include "simrtc.h"
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+#define RTC_HZ          32768U
+#define NS_PER_SEC      1000000000ULL
+
+// Clock ticks per second
+#define TICK_HZ         (1000000U / Clock_tickPeriod)
+
+#define SIM_TIMERS      4
+
+typedef struct
+{
+    Clock_Struct clock;
+    void         (*notify)(union sigval val);
+    union sigval value;
+} SimTimer;
+
+//*****************************************************************************
+// Global and local variables
+//*****************************************************************************
+
+uint64_t simNow;
+uint64_t simClockExpiries;
+
+static Clock_Struct *clockList;
+
+static SimTimer simTimers[SIM_TIMERS];
+static int      simTimerCount;
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+/* RTC periods counted by a time */
+static uint64_t rtcCount(uint64_t ns)
+{
+    return ((ns / NS_PER_SEC) * RTC_HZ + (ns % NS_PER_SEC) * RTC_HZ /
+            NS_PER_SEC);
+}
+
+/* Time of an RTC edge */
+static uint64_t rtcEdge(uint64_t count)
+{
+    unsigned __int128 ns = (unsigned __int128)count * NS_PER_SEC;
+
+    return ((uint64_t)((ns + RTC_HZ - 1) / RTC_HZ));
+}
+
+/* Clock ticks at a time, as the Clock module derives them from the RTC */
+static uint64_t tickAt(uint64_t ns)
+{
+    return (rtcCount(ns) * TICK_HZ / RTC_HZ);
+}
+
+/* Time a Clock set for a tick expires, on the first RTC edge of the tick */
+static uint64_t tickExpiry(uint64_t tick)
+{
+    return (rtcEdge((tick * RTC_HZ + TICK_HZ - 1) / TICK_HZ));
+}
+
+//*****************************************************************************
+// Driverlib and Clock stand-ins
+//*****************************************************************************
+
+uint64_t AONRTCCurrent64BitValueGet(void)
+{
+    // 2^32 / 32768, the fraction counts in steps of one RTC period
+    return (rtcCount(simNow) << 17);
+}
+
+void Clock_Params_init(Clock_Params *params)
+{
+    memset(params, 0, sizeof(*params));
+}
+
+void Clock_construct(Clock_Struct *clock, Clock_FuncPtr fxn, uint32_t timeout,
+                     const Clock_Params *params)
+{
+    memset(clock, 0, sizeof(*clock));
+    clock->fxn     = fxn;
+    clock->arg     = params->arg;
+    clock->timeout = timeout;
+    clock->next    = clockList;
+    clockList      = clock;
+}
+
+void Clock_setTimeout(Clock_Handle handle, uint32_t timeout)
+{
+    handle->timeout = timeout;
+}
+
+void Clock_start(Clock_Handle handle)
+{
+    handle->expiryTick = tickAt(simNow) + handle->timeout;
+    handle->active     = true;
+}
+
+void Clock_stop(Clock_Handle handle)
+{
+    handle->active = false;
+}
+
+bool Clock_isActive(Clock_Handle handle)
+{
+    return (handle->active);
+}
+
+uint32_t Clock_getTicks(void)
+{
+    return ((uint32_t)tickAt(simNow));
+}
+
+bool simClockNext(uint64_t *aNext)
+{
+    Clock_Struct *clock;
+    bool          found = false;
+
+    for (clock = clockList; clock != NULL; clock = clock->next)
+    {
+        if (clock->active)
+        {
+            uint64_t expiry = tickExpiry(clock->expiryTick);
+
+            if (!found || expiry < *aNext)
+            {
+                *aNext = expiry;
+                found  = true;
+            }
+        }
+    }
+    return (found);
+}
+
+void simClockRun(void)
+{
+    Clock_Struct *clock;
+    bool          ran;
+
+    do
+    {
+        ran = false;
+        for (clock = clockList; clock != NULL; clock = clock->next)
+        {
+            if (clock->active && tickExpiry(clock->expiryTick) <= simNow)
+            {
+                clock->active = false;
+                simClockExpiries++;
+                clock->fxn(clock->arg);
+                ran = true;
+            }
+        }
+    } while (ran);
+}
+
+//*****************************************************************************
+// TI-RTOS POSIX layer stand-ins
+//*****************************************************************************
+
+static void simTimerFxn(UArg arg)
+{
+    SimTimer *timer = (SimTimer *)arg;
+
+    timer->notify(timer->value);
+}
+
+int simClockGettime(clockid_t clockId, struct timespec *tp)
+{
+    uint64_t us = tickAt(simNow) * Clock_tickPeriod;
+
+    (void)clockId;
+
+    tp->tv_sec  = us / 1000000U;
+    tp->tv_nsec = (us % 1000000U) * 1000U;
+    return (0);
+}
+
+int simClockSettime(clockid_t clockId, const struct timespec *tp)
+{
+    // Only CLOCK_REALTIME can be set
+    (void)clockId;
+    (void)tp;
+    return (-1);
+}
+
+int simTimerCreate(clockid_t clockId, struct sigevent *evp, timer_t *timerId)
+{
+    SimTimer    *timer;
+    Clock_Params params;
+
+    (void)clockId;
+
+    if (simTimerCount == SIM_TIMERS)
+    {
+        return (-1);
+    }
+    timer = &simTimers[simTimerCount++];
+    timer->notify = evp->sigev_notify_function;
+    timer->value  = evp->sigev_value;
+
+    Clock_Params_init(&params);
+    params.arg = (UArg)timer;
+    Clock_construct(&timer->clock, simTimerFxn, 0, &params);
+
+    *timerId = (timer_t)timer;
+    return (0);
+}
+
+int simTimerSettime(timer_t timerId, int flags, const struct itimerspec *value,
+                    struct itimerspec *ovalue)
+{
+    SimTimer *timer = (SimTimer *)timerId;
+    uint64_t  us;
+
+    (void)flags;
+    (void)ovalue;
+
+    Clock_stop(&timer->clock);
+
+    us = (uint64_t)value->it_value.tv_sec * 1000000U +
+         (value->it_value.tv_nsec + 999) / 1000;
+    if (us != 0)
+    {
+        Clock_setTimeout(&timer->clock,
+                         (uint32_t)((us + Clock_tickPeriod - 1) /
+                                    Clock_tickPeriod));
+        Clock_start(&timer->clock);
+    }
+    return (0);
+}
+
+int simTimerGettime(timer_t timerId, struct itimerspec *value)
+{
+    SimTimer *timer = (SimTimer *)timerId;
+    uint64_t  us    = 0;
+
+    memset(value, 0, sizeof(*value));
+    if (timer->clock.active)
+    {
+        uint64_t now = tickAt(simNow);
+
+        if (timer->clock.expiryTick > now)
+        {
+            us = (timer->clock.expiryTick - now) * Clock_tickPeriod;
+        }
+    }
+    value->it_value.tv_sec  = us / 1000000U;
+    value->it_value.tv_nsec = (us % 1000000U) * 1000U;
+    return (0);
+}
@@ -0,0 +1,51 @@
+/******************************************************************************
+
+ @file  simrtc.h
+
+ @brief Simulated time for host builds of the platform alarm modules
+
+ Time advances only when the simulation moves it. The always-on RTC counts
+ the 32768 Hz clock, the TI-RTOS Clock counts 10 us ticks taken from it as
+ in TickMode_DYNAMIC, and a Clock expires on the first RTC edge at or after
+ its tick. The POSIX timers of the TI-RTOS POSIX layer are built on Clock
+ objects.
+
+ *****************************************************************************/
+#ifndef SIMRTC_H
+#define SIMRTC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//*****************************************************************************
+// Global variables
+//*****************************************************************************
+
+// Simulated time in ns since the RTC was started
+extern uint64_t simNow;
+
+// Clock expiries, each one a wakeup of the device
+extern uint64_t simClockExpiries;
+
+//*****************************************************************************
+// Global functions
+//*****************************************************************************
+
+/**
+ * @brief Time of the earliest active Clock expiry.
+ *
+ * @param aNext set to the time in ns
+ *
+ * @return false if no Clock is active
+ */
+extern bool simClockNext(uint64_t *aNext);
+
+/**
+ * @brief Runs the functions of the Clocks that expired by simNow, as the
+ *        Clock Swi would.
+ *
+ * @return None
+ */
+extern void simClockRun(void);
+
+#endif /* SIMRTC_H */
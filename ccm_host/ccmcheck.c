@@ -0,0 +1,609 @@
+/******************************************************************************
+
+ @file  ccmcheck.c
+
+ @brief Host check and benchmark of the AES-CCM* platform module
+
+ Runs crypto/aes_ccm.c and crypto/aes_alt.c of an example application on
+ Linux. The AESCCM and AESECB drivers run on OpenSSL and count what they
+ are asked to do.
+
+   ccmcheck check
+       Secures frames of every MIC length, header and payload length that
+       matter to CCM*, on both paths and with the accelerator refused. Checks
+       each against OpenSSL, decrypts it back, and checks that a changed
+       MIC, header or payload is refused.
+
+   ccmcheck bench [frames]
+       Secures MAC frames on both paths and shows, per frame, the
+       accelerator jobs, the AES blocks and the AESECB driver opens each
+       path takes, and the host time. The device times come from
+       diag crypto bench.
+
+ *****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <openssl/evp.h>
+
+#include <ti/drivers/AESCCM.h>
+#include <ti/drivers/AESECB.h>
+
+#include "platform.h"
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+#define CHECK_KEY_LEN       16
+#define CHECK_NONCE_LEN     13
+#define CHECK_MAX_HEADER    64
+#define CHECK_MAX_PAYLOAD   128
+
+// A MAC data frame with short addresses and the auxiliary security header
+#define BENCH_HEADER        23
+#define BENCH_MIC           4
+#define BENCH_FRAMES        10000
+
+#define ARRAY_LEN(a)        (sizeof(a) / sizeof((a)[0]))
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+// What the drivers were asked to do
+static struct
+{
+    unsigned long ecbOpens;
+    unsigned long ecbCloses;
+    unsigned long ecbBlocks;
+    unsigned long ccmOpens;
+    unsigned long ccmJobs;
+} drivers;
+
+// Set to have AESCCM_open() refuse, as when the driver is not in the image
+static bool ccmUnavailable;
+
+static int ecbHandle;
+static int ccmHandle;
+
+static int failures;
+
+#define FAIL(...) do { fprintf(stderr, __VA_ARGS__); \
+                       fputc('\n', stderr); \
+                       failures++; } while (0)
+
+//*****************************************************************************
+// Driver stand-ins
+//*****************************************************************************
+
+void AESECB_Params_init(AESECB_Params *params)
+{
+    params->returnBehavior = AESECB_RETURN_BEHAVIOR_BLOCKING;
+}
+
+AESECB_Handle AESECB_open(uint_least8_t index, AESECB_Params *params)
+{
+    (void)index;
+    (void)params;
+
+    drivers.ecbOpens++;
+    return ((AESECB_Handle)&ecbHandle);
+}
+
+void AESECB_close(AESECB_Handle handle)
+{
+    (void)handle;
+
+    drivers.ecbCloses++;
+}
+
+void AESECB_Operation_init(AESECB_Operation *operationStruct)
+{
+    memset(operationStruct, 0, sizeof(*operationStruct));
+}
+
+int_fast16_t AESECB_oneStepEncrypt(AESECB_Handle handle,
+                                   AESECB_Operation *operation)
+{
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    int len;
+    int ok;
+
+    if (handle == NULL)
+    {
+        FAIL("AESECB_oneStepEncrypt() on a closed driver");
+    }
+    drivers.ecbBlocks += operation->inputLength / 16;
+
+    ok = EVP_EncryptInit_ex(ctx, EVP_aes_128_ecb(), NULL,
+                            operation->key->u.plaintext.keyMaterial, NULL) &&
+         EVP_CIPHER_CTX_set_padding(ctx, 0) &&
+         EVP_EncryptUpdate(ctx, operation->output, &len, operation->input,
+                           operation->inputLength);
+    EVP_CIPHER_CTX_free(ctx);
+    return (ok ? AESECB_STATUS_SUCCESS : AESECB_STATUS_ERROR);
+}
+
+void AESCCM_Params_init(AESCCM_Params *params)
+{
+    params->returnBehavior = AESCCM_RETURN_BEHAVIOR_BLOCKING;
+}
+
+AESCCM_Handle AESCCM_open(uint_least8_t index, AESCCM_Params *params)
+{
+    (void)index;
+    (void)params;
+
+    if (ccmUnavailable)
+    {
+        return (NULL);
+    }
+    drivers.ccmOpens++;
+    return ((AESCCM_Handle)&ccmHandle);
+}
+
+void AESCCM_close(AESCCM_Handle handle)
+{
+    (void)handle;
+}
+
+void AESCCM_Operation_init(AESCCM_Operation *operationStruct)
+{
+    memset(operationStruct, 0, sizeof(*operationStruct));
+}
+
+static int_fast16_t ccmJob(AESCCM_Operation *operation, bool encrypt)
+{
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    uint8_t unused;
+    int len;
+    int ok;
+
+    drivers.ccmJobs++;
+
+    ok = EVP_CipherInit_ex(ctx, EVP_aes_128_ccm(), NULL, NULL, NULL,
+                           encrypt) &&
+         EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_CCM_SET_IVLEN,
+                             operation->nonceLength, NULL) &&
+         EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_CCM_SET_TAG, operation->macLength,
+                             encrypt ? NULL : operation->mac) &&
+         EVP_CipherInit_ex(ctx, NULL, NULL,
+                           operation->key->u.plaintext.keyMaterial,
+                           operation->nonce, encrypt) &&
+         EVP_CipherUpdate(ctx, NULL, &len, NULL, operation->inputLength) &&
+         (operation->aadLength == 0 ||
+          EVP_CipherUpdate(ctx, NULL, &len, operation->aad,
+                           operation->aadLength));
+    if (!ok)
+    {
+        EVP_CIPHER_CTX_free(ctx);
+        return (AESCCM_STATUS_ERROR);
+    }
+
+    // OpenSSL checks the MAC as it decrypts
+    if (EVP_CipherUpdate(ctx, operation->output ? operation->output : &unused,
+                         &len, operation->input ? operation->input : &unused,
+                         operation->inputLength) <= 0)
+    {
+        EVP_CIPHER_CTX_free(ctx);
+        return (encrypt ? AESCCM_STATUS_ERROR : AESCCM_STATUS_MAC_INVALID);
+    }
+    if (encrypt)
+    {
+        ok = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_CCM_GET_TAG,
+                                 operation->macLength, operation->mac);
+    }
+    EVP_CIPHER_CTX_free(ctx);
+    return (ok ? AESCCM_STATUS_SUCCESS : AESCCM_STATUS_ERROR);
+}
+
+int_fast16_t AESCCM_oneStepEncrypt(AESCCM_Handle handle,
+                                   AESCCM_Operation *operation)
+{
+    (void)handle;
+
+    return (ccmJob(operation, true));
+}
+
+int_fast16_t AESCCM_oneStepDecrypt(AESCCM_Handle handle,
+                                   AESCCM_Operation *operation)
+{
+    (void)handle;
+
+    return (ccmJob(operation, false));
+}
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+static double nowSec(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec + now.tv_nsec / 1e9);
+}
+
+static void fill(uint8_t *buf, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        buf[i] = (uint8_t)rand();
+    }
+}
+
+/*
+ * CCM* by OpenSSL, written apart from the module under test. OpenSSL has no
+ * CCM without a MIC, that is counter mode from A_1.
+ */
+static void reference(const PlatformAesCcm_Frame *frame, const uint8_t *plain,
+                      uint8_t *secured, uint8_t *tag)
+{
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    uint8_t counter[16];
+    uint8_t unused;
+    int len;
+    int ok;
+
+    if (frame->tagLength == 0)
+    {
+        counter[0] = 1;
+        memcpy(&counter[1], frame->nonce, CHECK_NONCE_LEN);
+        counter[14] = 0;
+        counter[15] = 1;
+        ok = EVP_EncryptInit_ex(ctx, EVP_aes_128_ctr(), NULL, frame->key,
+                                counter) &&
+             EVP_EncryptUpdate(ctx, secured, &len, plain,
+                               frame->payloadLength);
+    }
+    else
+    {
+        ok = EVP_EncryptInit_ex(ctx, EVP_aes_128_ccm(), NULL, NULL, NULL) &&
+             EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_CCM_SET_IVLEN, CHECK_NONCE_LEN,
+                                 NULL) &&
+             EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_CCM_SET_TAG, frame->tagLength,
+                                 NULL) &&
+             EVP_EncryptInit_ex(ctx, NULL, NULL, frame->key, frame->nonce) &&
+             EVP_EncryptUpdate(ctx, NULL, &len, NULL, frame->payloadLength) &&
+             (frame->headerLength == 0 ||
+              EVP_EncryptUpdate(ctx, NULL, &len, frame->header,
+                                frame->headerLength)) &&
+             EVP_EncryptUpdate(ctx, frame->payloadLength ? secured : &unused,
+                               &len, plain, frame->payloadLength) &&
+             EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_CCM_GET_TAG, frame->tagLength,
+                                 tag);
+    }
+    EVP_CIPHER_CTX_free(ctx);
+
+    if (!ok)
+    {
+        fprintf(stderr, "OpenSSL reference failed\n");
+        exit(1);
+    }
+}
+
+static const char *pathName(PlatformAesCcm_Path path)
+{
+    return ((path == PlatformAesCcm_auto) ? "auto" : "per block");
+}
+
+/* Decrypts a copy of a secured frame with one byte changed at *where */
+static void checkTamper(PlatformAesCcm_Frame *frame, PlatformAesCcm_Path path,
+                        const uint8_t *secured, const uint8_t *tag,
+                        uint8_t *where, const char *what)
+{
+    PlatformAesCcm_Stats before;
+    PlatformAesCcm_Stats after;
+    otError error;
+
+    memcpy(frame->payload, secured, frame->payloadLength);
+    memcpy(frame->tag, tag, frame->tagLength);
+    *where ^= 0x20;
+
+    platformAesCcmGetStats(&before);
+    error = platformAesCcmDecrypt(frame, path);
+    platformAesCcmGetStats(&after);
+    *where ^= 0x20;
+
+    if (error != OT_ERROR_SECURITY)
+    {
+        FAIL("%s, mic %u header %u payload %u: changed %s decrypts, "
+             "status %d", pathName(path), frame->tagLength,
+             frame->headerLength, frame->payloadLength, what, error);
+    }
+    if (after.micFailures != before.micFailures + 1)
+    {
+        FAIL("%s: mic failure not counted", pathName(path));
+    }
+}
+
+static void checkFrame(uint8_t tagLength, uint16_t headerLength,
+                       uint16_t payloadLength, PlatformAesCcm_Path path)
+{
+    uint8_t key[CHECK_KEY_LEN];
+    uint8_t nonce[CHECK_NONCE_LEN];
+    uint8_t header[CHECK_MAX_HEADER];
+    uint8_t plain[CHECK_MAX_PAYLOAD];
+    uint8_t payload[CHECK_MAX_PAYLOAD];
+    uint8_t expected[CHECK_MAX_PAYLOAD];
+    uint8_t expectedTag[16];
+    uint8_t tag[16];
+    PlatformAesCcm_Frame frame;
+    PlatformAesCcm_Stats before;
+    PlatformAesCcm_Stats after;
+    unsigned long jobs;
+    bool job;
+    otError error;
+
+    fill(key, sizeof(key));
+    fill(nonce, sizeof(nonce));
+    fill(header, headerLength);
+    fill(plain, payloadLength);
+
+    frame.key           = key;
+    frame.nonce         = nonce;
+    frame.header        = header;
+    frame.headerLength  = headerLength;
+    frame.payload       = payload;
+    frame.payloadLength = payloadLength;
+    frame.tag           = tag;
+    frame.tagLength     = tagLength;
+
+    reference(&frame, plain, expected, expectedTag);
+
+    // A job when the accelerator is asked and takes the frame
+    job = (path == PlatformAesCcm_auto && !ccmUnavailable &&
+           tagLength >= 4 && payloadLength > 0);
+
+    memcpy(payload, plain, payloadLength);
+    platformAesCcmGetStats(&before);
+    jobs = drivers.ccmJobs;
+    error = platformAesCcmEncrypt(&frame, path);
+    platformAesCcmGetStats(&after);
+
+    if (error != OT_ERROR_NONE ||
+        memcmp(payload, expected, payloadLength) != 0 ||
+        memcmp(tag, expectedTag, tagLength) != 0)
+    {
+        FAIL("%s%s, mic %u header %u payload %u: encrypt differs from "
+             "OpenSSL, status %d", pathName(path),
+             ccmUnavailable ? " unavailable" : "", tagLength, headerLength,
+             payloadLength, error);
+        return;
+    }
+    if ((drivers.ccmJobs - jobs) != (job ? 1 : 0) ||
+        after.jobs - before.jobs != (job ? 1 : 0) ||
+        after.perBlock - before.perBlock != (job ? 0 : 1))
+    {
+        FAIL("%s, mic %u payload %u: ran on the wrong path", pathName(path),
+             tagLength, payloadLength);
+    }
+    if (path == PlatformAesCcm_auto && ccmUnavailable &&
+        tagLength >= 4 && payloadLength > 0 &&
+        after.fallbacks != before.fallbacks + 1)
+    {
+        FAIL("fallback not counted");
+    }
+
+    error = platformAesCcmDecrypt(&frame, path);
+    if (error != OT_ERROR_NONE || memcmp(payload, plain, payloadLength) != 0)
+    {
+        FAIL("%s, mic %u header %u payload %u: decrypt does not give the "
+             "plaintext back, status %d", pathName(path), tagLength,
+             headerLength, payloadLength, error);
+    }
+
+    if (tagLength > 0)
+    {
+        checkTamper(&frame, path, expected, expectedTag, &tag[tagLength - 1],
+                    "mic");
+        if (headerLength > 0)
+        {
+            checkTamper(&frame, path, expected, expectedTag,
+                        &header[headerLength / 2], "header");
+        }
+        if (payloadLength > 0)
+        {
+            checkTamper(&frame, path, expected, expectedTag,
+                        &payload[payloadLength - 1], "payload");
+        }
+    }
+}
+
+static void checkInvalid(void)
+{
+    static const uint8_t badTags[] = { 2, 3, 5, 18 };
+    uint8_t key[CHECK_KEY_LEN] = { 0 };
+    uint8_t nonce[CHECK_NONCE_LEN] = { 0 };
+    uint8_t payload[16] = { 0 };
+    uint8_t tag[32];
+    PlatformAesCcm_Frame frame;
+    size_t i;
+
+    frame.key           = key;
+    frame.nonce         = nonce;
+    frame.header        = NULL;
+    frame.headerLength  = 0;
+    frame.payload       = payload;
+    frame.payloadLength = sizeof(payload);
+    frame.tag           = tag;
+
+    for (i = 0; i < ARRAY_LEN(badTags); i++)
+    {
+        frame.tagLength = badTags[i];
+        if (platformAesCcmEncrypt(&frame, PlatformAesCcm_auto) !=
+            OT_ERROR_INVALID_ARGS)
+        {
+            FAIL("mic length %u accepted", badTags[i]);
+        }
+    }
+
+    frame.tagLength    = 4;
+    frame.headerLength = 5;
+    if (platformAesCcmEncrypt(&frame, PlatformAesCcm_auto) !=
+        OT_ERROR_INVALID_ARGS)
+    {
+        FAIL("header length without a header accepted");
+    }
+
+    if (platformAesCcmDecrypt(NULL, PlatformAesCcm_perBlock) !=
+        OT_ERROR_INVALID_ARGS)
+    {
+        FAIL("no frame accepted");
+    }
+}
+
+static int runCheck(void)
+{
+    static const uint8_t tagLengths[] = { 0, 4, 6, 8, 10, 12, 14, 16 };
+    static const uint16_t headerLengths[] = { 0, 1, 13, 14, 15, 23, 30, 46 };
+    static const uint16_t payloadLengths[] = {
+        0, 1, 15, 16, 17, 31, 32, 64, 100, CHECK_MAX_PAYLOAD
+    };
+    static const PlatformAesCcm_Path paths[] = {
+        PlatformAesCcm_auto, PlatformAesCcm_perBlock
+    };
+    PlatformAesCcm_Stats stats;
+    unsigned long frames = 0;
+    size_t t, h, p, r;
+    int unavailable;
+
+    srand(1);
+
+    // The module keeps the driver open once it has it, refuse it first
+    for (unavailable = 1; unavailable >= 0; unavailable--)
+    {
+        ccmUnavailable = unavailable;
+        for (t = 0; t < ARRAY_LEN(tagLengths); t++)
+        {
+            for (h = 0; h < ARRAY_LEN(headerLengths); h++)
+            {
+                for (p = 0; p < ARRAY_LEN(payloadLengths); p++)
+                {
+                    for (r = 0; r < ARRAY_LEN(paths); r++)
+                    {
+                        checkFrame(tagLengths[t], headerLengths[h],
+                                   payloadLengths[p], paths[r]);
+                        frames++;
+                    }
+                }
+            }
+        }
+    }
+    ccmUnavailable = false;
+
+    checkInvalid();
+
+    // The AESECB driver is opened once, or around each per block frame
+    platformAesCcmGetStats(&stats);
+    if (AES_ALT_KEEP_OPEN ? (drivers.ecbOpens != 1 || drivers.ecbCloses != 0)
+                          : (drivers.ecbOpens != stats.perBlock ||
+                             drivers.ecbCloses != stats.perBlock))
+    {
+        FAIL("AESECB opened %lu and closed %lu times for %lu frames",
+             drivers.ecbOpens, drivers.ecbCloses,
+             (unsigned long)stats.perBlock);
+    }
+    if (drivers.ccmOpens != 1)
+    {
+        FAIL("AESCCM opened %lu times", drivers.ccmOpens);
+    }
+
+    printf("%lu frames, %lu jobs, %lu per block, %lu fallbacks, "
+           "%lu mic failures: %s\n", frames, (unsigned long)stats.jobs,
+           (unsigned long)stats.perBlock, (unsigned long)stats.fallbacks,
+           (unsigned long)stats.micFailures, failures ? "FAILED" : "ok");
+    return (failures ? 1 : 0);
+}
+
+static void benchPath(uint16_t payloadLength, PlatformAesCcm_Path path,
+                      int frames)
+{
+    static const uint8_t key[CHECK_KEY_LEN] = { 0xc0, 0xc1, 0xc2, 0xc3 };
+    static const uint8_t nonce[CHECK_NONCE_LEN] = { 0xac, 0xde, 0x48 };
+    uint8_t header[BENCH_HEADER] = { 0x41, 0xd8 };
+    uint8_t payload[CHECK_MAX_PAYLOAD] = { 0 };
+    uint8_t tag[BENCH_MIC];
+    PlatformAesCcm_Frame frame;
+    unsigned long jobs = drivers.ccmJobs;
+    unsigned long blocks = drivers.ecbBlocks;
+    unsigned long opens = drivers.ecbOpens;
+    double t0, t1;
+    int i;
+
+    frame.key           = key;
+    frame.nonce         = nonce;
+    frame.header        = header;
+    frame.headerLength  = sizeof(header);
+    frame.payload       = payload;
+    frame.payloadLength = payloadLength;
+    frame.tag           = tag;
+    frame.tagLength     = sizeof(tag);
+
+    // Decrypting what was just encrypted gives the plaintext back
+    t0 = nowSec();
+    for (i = 0; i < frames; i++)
+    {
+        if (platformAesCcmEncrypt(&frame, path) != OT_ERROR_NONE ||
+            platformAesCcmDecrypt(&frame, path) != OT_ERROR_NONE)
+        {
+            fprintf(stderr, "frame %d failed\n", i);
+            exit(1);
+        }
+    }
+    t1 = nowSec();
+
+    printf("%-10s %4u %8.2f %8.2f %8.2f %9.0f\n", pathName(path),
+           payloadLength, (double)(drivers.ccmJobs - jobs) / (2 * frames),
+           (double)(drivers.ecbBlocks - blocks) / (2 * frames),
+           (double)(drivers.ecbOpens - opens) / (2 * frames),
+           (t1 - t0) * 1e9 / (2 * frames));
+}
+
+static int runBench(int frames)
+{
+    static const uint16_t payloadLengths[] = { 16, 64, 100 };
+    size_t i;
+
+    printf("AES_ALT_KEEP_OPEN %d, %u byte header, MIC-%u, per frame:\n",
+           AES_ALT_KEEP_OPEN, BENCH_HEADER, BENCH_MIC * 8);
+    printf("%-10s %4s %8s %8s %8s %9s\n", "path", "B", "jobs", "blocks",
+           "opens", "host ns");
+    for (i = 0; i < ARRAY_LEN(payloadLengths); i++)
+    {
+        benchPath(payloadLengths[i], PlatformAesCcm_auto, frames);
+        benchPath(payloadLengths[i], PlatformAesCcm_perBlock, frames);
+    }
+    return (0);
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: ccmcheck check\n"
+            "       ccmcheck bench [frames]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 2 && strcmp(argv[1], "check") == 0)
+    {
+        return (runCheck());
+    }
+    if ((argc == 2 || argc == 3) && strcmp(argv[1], "bench") == 0)
+    {
+        return (runBench((argc == 3) ? atoi(argv[2]) : BENCH_FRAMES));
+    }
+    usage();
+    return (2);
+}
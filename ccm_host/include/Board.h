@@ -0,0 +1,9 @@
+/*
+ * Host stand-in for the board file, only the AESCCM index is used.
+ */
+#ifndef BOARD_H
+#define BOARD_H
+
+#define Board_AESCCM0   0
+
+#endif /* BOARD_H */
@@ -0,0 +1,18 @@
+/*
+ * Host stand-in for the AES context of the hardware AES module, as
+ * crypto/aes_alt.c uses it.
+ */
+#ifndef AES_ALT_H
+#define AES_ALT_H
+
+#include <stdint.h>
+
+#include <ti/drivers/cryptoutils/cryptokey/CryptoKey.h>
+
+typedef struct
+{
+    CryptoKey cryptoKey;
+    uint8_t   keyMaterial[32];
+} mbedtls_aes_context;
+
+#endif /* AES_ALT_H */
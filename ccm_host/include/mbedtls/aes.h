@@ -0,0 +1,29 @@
+/*
+ * Host stand-in for the mbedtls AES module, built with the hardware AES of
+ * crypto/aes_alt.c as the examples are.
+ */
+#ifndef MBEDTLS_AES_H
+#define MBEDTLS_AES_H
+
+#define MBEDTLS_AES_ALT
+
+#define MBEDTLS_AES_ENCRYPT     1
+#define MBEDTLS_AES_DECRYPT     0
+
+#include "aes_alt.h"
+
+void mbedtls_aes_init(mbedtls_aes_context *ctx);
+
+void mbedtls_aes_free(mbedtls_aes_context *ctx);
+
+int mbedtls_aes_setkey_enc(mbedtls_aes_context *ctx, const unsigned char *key,
+                           unsigned int keybits);
+
+int mbedtls_aes_setkey_dec(mbedtls_aes_context *ctx, const unsigned char *key,
+                           unsigned int keybits);
+
+int mbedtls_aes_crypt_ecb(mbedtls_aes_context *ctx, int mode,
+                          const unsigned char input[16],
+                          unsigned char output[16]);
+
+#endif /* MBEDTLS_AES_H */
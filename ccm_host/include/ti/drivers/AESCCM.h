@@ -0,0 +1,59 @@
+/*
+ * Host stand-in for the TI AESCCM driver, ccmcheck.c runs it on OpenSSL.
+ */
+#ifndef AESCCM_H
+#define AESCCM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ti/drivers/cryptoutils/cryptokey/CryptoKey.h>
+
+#define AESCCM_STATUS_SUCCESS               0
+#define AESCCM_STATUS_ERROR                 (-1)
+#define AESCCM_STATUS_RESOURCE_UNAVAILABLE  (-2)
+#define AESCCM_STATUS_MAC_INVALID           (-3)
+
+typedef struct AESCCM_Config *AESCCM_Handle;
+
+typedef enum
+{
+    AESCCM_RETURN_BEHAVIOR_CALLBACK = 1,
+    AESCCM_RETURN_BEHAVIOR_BLOCKING = 2,
+    AESCCM_RETURN_BEHAVIOR_POLLING  = 4,
+} AESCCM_ReturnBehavior;
+
+typedef struct
+{
+    AESCCM_ReturnBehavior returnBehavior;
+} AESCCM_Params;
+
+typedef struct
+{
+    CryptoKey *key;
+    uint8_t   *aad;
+    uint8_t   *input;
+    uint8_t   *output;
+    uint8_t   *nonce;
+    uint8_t   *mac;
+    size_t    aadLength;
+    size_t    inputLength;
+    uint8_t   nonceLength;
+    uint8_t   macLength;
+} AESCCM_Operation;
+
+void AESCCM_Params_init(AESCCM_Params *params);
+
+AESCCM_Handle AESCCM_open(uint_least8_t index, AESCCM_Params *params);
+
+void AESCCM_close(AESCCM_Handle handle);
+
+void AESCCM_Operation_init(AESCCM_Operation *operationStruct);
+
+int_fast16_t AESCCM_oneStepEncrypt(AESCCM_Handle handle,
+                                   AESCCM_Operation *operation);
+
+int_fast16_t AESCCM_oneStepDecrypt(AESCCM_Handle handle,
+                                   AESCCM_Operation *operation);
+
+#endif /* AESCCM_H */
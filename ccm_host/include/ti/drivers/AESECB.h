@@ -0,0 +1,48 @@
+/*
+ * Host stand-in for the TI AESECB driver, ccmcheck.c runs it on OpenSSL.
+ */
+#ifndef AESECB_H
+#define AESECB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ti/drivers/cryptoutils/cryptokey/CryptoKey.h>
+
+#define AESECB_STATUS_SUCCESS   0
+#define AESECB_STATUS_ERROR     (-1)
+
+typedef struct AESECB_Config *AESECB_Handle;
+
+typedef enum
+{
+    AESECB_RETURN_BEHAVIOR_CALLBACK = 1,
+    AESECB_RETURN_BEHAVIOR_BLOCKING = 2,
+    AESECB_RETURN_BEHAVIOR_POLLING  = 4,
+} AESECB_ReturnBehavior;
+
+typedef struct
+{
+    AESECB_ReturnBehavior returnBehavior;
+} AESECB_Params;
+
+typedef struct
+{
+    CryptoKey *key;
+    uint8_t   *input;
+    uint8_t   *output;
+    size_t    inputLength;
+} AESECB_Operation;
+
+void AESECB_Params_init(AESECB_Params *params);
+
+AESECB_Handle AESECB_open(uint_least8_t index, AESECB_Params *params);
+
+void AESECB_close(AESECB_Handle handle);
+
+void AESECB_Operation_init(AESECB_Operation *operationStruct);
+
+int_fast16_t AESECB_oneStepEncrypt(AESECB_Handle handle,
+                                   AESECB_Operation *operation);
+
+#endif /* AESECB_H */
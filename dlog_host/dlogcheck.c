@@ -0,0 +1,408 @@
+/******************************************************************************
+
+ @file  dlogcheck.c
+
+ @brief Host check and benchmark of the deferred binary log
+
+ Runs dlog.c of an example application on Linux. The UART is a file, the
+ interrupt lock a mutex and the log task a thread.
+
+   dlogcheck check <log> <expected>
+       Logs a set of records, and writes the binary log and the text that
+       dlogdecode.py should print for it. Covers records queued before the
+       log task runs, a full ring, argument types, strings and records cut
+       at DLOG_MAXRECORD.
+
+   dlogcheck stress <log> <threads> <records>
+       Logs from several threads at once while the log task drains the
+       ring. Prints the number of records logged, the decoded log must
+       account for each one as sent or dropped.
+
+   dlogcheck bench
+       Times a call to the log against formatting the same text, the work
+       a synchronous print does before it waits for the UART. Shows the
+       bytes each puts on the UART and how long the synchronous print
+       holds its caller for them. Build with a ring large enough for the
+       whole run.
+
+ *****************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <ti/drivers/UART.h>
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#include "dlog.h"
+#include "task_config.h"
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+// Length of a record header, see dlog.c
+#define CHECK_HEADER_LEN    11
+
+// OpenThread level and region of the stack records
+#define CHECK_LEVEL_INFO    4
+#define CHECK_REGION_MLE    2
+
+#define BENCH_CALLS         200000
+#define BENCH_RUNS          5
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+pthread_mutex_t HwiP_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int uartFd = -1;
+
+// Bytes written to the UART, and set to hold the log task in UART_write()
+static volatile size_t uartBytes;
+static volatile int uartHold;
+
+static FILE *expected;
+
+// Logs a record and the text it should decode to
+#define CHECK(...) do { DLog_printf(__VA_ARGS__); \
+                        fprintf(expected, __VA_ARGS__); \
+                        fputc('\n', expected); } while (0)
+
+//*****************************************************************************
+// Driver stand-ins
+//*****************************************************************************
+
+void UART_init(void)
+{
+}
+
+void UART_Params_init(UART_Params *params)
+{
+    memset(params, 0, sizeof(*params));
+    params->baudRate = 115200;
+}
+
+UART_Handle UART_open(uint_least8_t index, UART_Params *params)
+{
+    (void)index;
+    (void)params;
+
+    return ((UART_Handle)&uartFd);
+}
+
+int_fast32_t UART_write(UART_Handle handle, const void *buffer, size_t size)
+{
+    (void)handle;
+
+    while (uartHold)
+    {
+        usleep(1000);
+    }
+    uartBytes += size;
+    if (write(uartFd, buffer, size) != (ssize_t)size)
+    {
+        perror("write");
+        exit(1);
+    }
+    return (size);
+}
+
+uint32_t Clock_getTicks(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint32_t)((now.tv_sec * 1000000ULL + now.tv_nsec / 1000) /
+                       Clock_tickPeriod));
+}
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+static double nowSec(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec + now.tv_nsec / 1e9);
+}
+
+static void openLog(const char *path)
+{
+    uartFd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (uartFd < 0)
+    {
+        perror(path);
+        exit(1);
+    }
+}
+
+/* Gives the log task time to empty the ring */
+static void drain(void)
+{
+    usleep(200 * 1000);
+}
+
+/* As otPlatLog() of the examples */
+static void stackLog(uint8_t level, uint8_t region, const char *format, ...)
+{
+    va_list ap;
+
+    va_start(ap, format);
+    DLog_vprintf(level, region, format, ap);
+    va_end(ap);
+}
+
+static int runCheck(const char *logPath, const char *expectedPath)
+{
+    static const char longString[] = "a string longer than DLOG_MAXSTRING";
+    char text[256];
+    unsigned used;
+    unsigned len;
+    int fits;
+    int i;
+
+    openLog(logPath);
+    expected = fopen(expectedPath, "w");
+    if (expected == NULL)
+    {
+        perror(expectedPath);
+        return (1);
+    }
+
+    // Before the log task runs, the ring fills and the rest is dropped.
+    // The argument is a zigzag varint, a byte up to 63.
+    used = 0;
+    for (fits = 0; ; fits++)
+    {
+        len = CHECK_HEADER_LEN + ((fits < 64) ? 1 : 2);
+        if (used + len > DLOG_RINGSIZE)
+        {
+            break;
+        }
+        used += len;
+    }
+    for (i = 0; i < fits + 32; i++)
+    {
+        DLog_printf("queued %d", i);
+        if (i < fits)
+        {
+            fprintf(expected, "queued %d\n", i);
+        }
+    }
+    fprintf(expected, "(32 records dropped)\n");
+
+    DLog_taskCreate();
+    drain();
+
+    CHECK("Lightsensor init!");
+    CHECK("GET!");
+    CHECK("Lightvalue %f", 312.25);
+    CHECK("new thresh min %d", -150);
+    CHECK("pskd: %s", "J01NME");
+    CHECK("EUI64: 0x%02x%02x%02x%02x%02x%02x%02x%02x",
+          0x00, 0x12, 0x4b, 0x00, 0x14, 0xf7, 0xd3, 0x2a);
+    CHECK("%u%% of %lu, %lld and %llx", 42u, 4000000000ul, -5000000000ll,
+          0x123456789abcull);
+    CHECK("[%5d] [%-5d] [%05d] [%+d]", 7, 7, 7, 7);
+    CHECK("[%*d] [%.*f]", 6, 99, 3, 2.0 / 3.0);
+    CHECK("%c%c%c", 'o', 'k', '!');
+    CHECK("%e %g %.2f", 1234.5, 0.0001, -1.005);
+    CHECK("%s|%s", "", "ab");
+    CHECK("escapes %x %x", 0x7e7e7e7e, 0x7d7d7d7d);
+
+    // Strings are cut at DLOG_MAXSTRING, without a mark
+    DLog_printf("long: %s", longString);
+    fprintf(expected, "long: %.*s\n", DLOG_MAXSTRING, longString);
+
+    // Arguments past DLOG_MAXRECORD are left out. Large values take five
+    // bytes, ten of them fit.
+    DLog_printf("%u %u %u %u %u %u %u %u %u %u %u %u",
+                4000000001u, 4000000002u, 4000000003u, 4000000004u,
+                4000000005u, 4000000006u, 4000000007u, 4000000008u,
+                4000000009u, 4000000010u, 4000000011u, 4000000012u);
+    text[0] = '\0';
+    for (i = 1; i <= 10; i++)
+    {
+        snprintf(text + strlen(text), sizeof(text) - strlen(text), "%u ",
+                 4000000000u + i);
+    }
+    fprintf(expected, "%s? ? (truncated)\n", text);
+
+    // OpenThread records carry their level and region
+    stackLog(CHECK_LEVEL_INFO, CHECK_REGION_MLE, "Role %s -> %s",
+             "detached", "child");
+    fprintf(expected, "INFO MLE: Role detached -> child\n");
+
+    drain();
+    fclose(expected);
+    close(uartFd);
+    return (0);
+}
+
+typedef struct
+{
+    int thread;
+    int records;
+} stressArg_t;
+
+static void *stressThread(void *arg)
+{
+    stressArg_t *s = arg;
+    int i;
+
+    for (i = 0; i < s->records; i++)
+    {
+        DLog_printf("stress %d %d", s->thread, i);
+        if ((i & 63) == 0)
+        {
+            sched_yield();
+        }
+    }
+    return (NULL);
+}
+
+static int runStress(const char *logPath, int threads, int records)
+{
+    pthread_t thread[16];
+    stressArg_t args[16];
+    int i;
+
+    if (threads < 1 || threads > 16)
+    {
+        return (1);
+    }
+
+    openLog(logPath);
+    DLog_taskCreate();
+
+    for (i = 0; i < threads; i++)
+    {
+        args[i].thread  = i;
+        args[i].records = records;
+        pthread_create(&thread[i], NULL, stressThread, &args[i]);
+    }
+    for (i = 0; i < threads; i++)
+    {
+        pthread_join(thread[i], NULL);
+    }
+
+    // The count of records dropped at the end goes with the next one
+    drain();
+    DLog_printf("stress done");
+    drain();
+
+    printf("%d\n", threads * records);
+    close(uartFd);
+    return (0);
+}
+
+/* Formats as Display_printf() does before it writes to the UART */
+static int __attribute__((noinline)) textPrintf(char *buf, size_t size,
+                                                 const char *format, ...)
+{
+    va_list ap;
+    int n;
+
+    va_start(ap, format);
+    n = vsnprintf(buf, size, format, ap);
+    va_end(ap);
+    return (n);
+}
+
+#define BENCH(name, ...) do { \
+        double t0, t1, t2; \
+        size_t wire; \
+        int textLen = 0; \
+        int n; \
+        uartHold = 0; \
+        drain(); \
+        wire = uartBytes; \
+        DLog_printf(__VA_ARGS__); \
+        drain(); \
+        wire = uartBytes - wire; \
+        uartHold = 1; \
+        t0 = nowSec(); \
+        for (n = 0; n < BENCH_CALLS; n++) \
+        { \
+            DLog_printf(__VA_ARGS__); \
+        } \
+        t1 = nowSec(); \
+        for (n = 0; n < BENCH_CALLS; n++) \
+        { \
+            textLen = textPrintf(text, sizeof(text), __VA_ARGS__); \
+        } \
+        t2 = nowSec(); \
+        /* Display adds a line end, ten bit times per byte */ \
+        textLen += 2; \
+        printf("%-24s %7.1f %9.1f %6d %6zu %9.0f\n", name, \
+               (t1 - t0) * 1e9 / BENCH_CALLS, (t2 - t1) * 1e9 / BENCH_CALLS, \
+               textLen, wire, textLen * 10 * 1e6 / DLOG_BAUD_RATE); \
+    } while (0)
+
+static int runBench(void)
+{
+    char text[128];
+
+    if ((size_t)DLOG_RINGSIZE <
+        (size_t)BENCH_RUNS * BENCH_CALLS * DLOG_MAXRECORD)
+    {
+        fprintf(stderr, "build with a larger DLOG_RINGSIZE\n");
+        return (1);
+    }
+
+    // The first record of each run sizes it on the UART, the log task then
+    // stays held in UART_write() so only the callers are timed
+    openLog("/dev/null");
+    DLog_taskCreate();
+
+    printf("%-24s %7s %9s %6s %6s %9s\n", "", "dlog ns", "format ns",
+           "text B", "dlog B", "uart us");
+    BENCH("GET!", "GET!");
+    BENCH("Lightvalue %f", "Lightvalue %f\n", 312.25);
+    BENCH("new thresh min %d", "new thresh min %d\n", 150);
+    BENCH("pskd: %s", "pskd: %s", "J01NME");
+    BENCH("EUI64: 0x%02x x8", "EUI64: 0x%02x%02x%02x%02x%02x%02x%02x%02x",
+          0x00, 0x12, 0x4b, 0x00, 0x14, 0xf7, 0xd3, 0x2a);
+
+    return (0);
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: dlogcheck check <log> <expected>\n"
+            "       dlogcheck stress <log> <threads> <records>\n"
+            "       dlogcheck bench\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 4 && strcmp(argv[1], "check") == 0)
+    {
+        return (runCheck(argv[2], argv[3]));
+    }
+    if (argc == 5 && strcmp(argv[1], "stress") == 0)
+    {
+        return (runStress(argv[2], atoi(argv[3]), atoi(argv[4])));
+    }
+    if (argc == 2 && strcmp(argv[1], "bench") == 0)
+    {
+        return (runBench());
+    }
+    usage();
+    return (2);
+}
@@ -0,0 +1,282 @@
+#!/usr/bin/env python3
+"""Decode the deferred binary log of the example applications.
+
+The firmware sends each log record as the address of its format and the raw
+arguments, see dlog.c. This looks the formats up in the firmware image and
+prints the records as text.
+
+    dlogdecode.py -e light_sensor.out /dev/ttyACM0
+
+Set the serial port to the DLOG_BAUD_RATE of the firmware first, for
+example with `stty -F /dev/ttyACM0 115200 raw`.
+"""
+
+import argparse
+import struct
+import sys
+
+FLAG = 0x7E
+ESCAPE = 0x7D
+ESCAPE_XOR = 0x20
+
+HEADER_LEN = 11
+TRUNCATED = 0x80
+REGION_APP = 0xFF
+
+LEVELS = {1: "CRIT", 2: "WARN", 3: "NOTE", 4: "INFO", 5: "DEBG"}
+
+REGIONS = {
+    1: "API", 2: "MLE", 3: "ARP", 4: "NETD", 5: "ICMP", 6: "IP6", 7: "MAC",
+    8: "MEM", 9: "NCP", 10: "MCOP", 11: "NDG", 12: "PLAT", 13: "COAP",
+    14: "CLI", 15: "CORE", 16: "UTIL",
+}
+
+
+class Image:
+    """Read only data of an ELF image, by address."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        self.sections = []
+        self.cache = {}
+
+        ident = self.data[:16]
+        if ident[:4] != b"\x7fELF" or ident[5] != 1:
+            raise ValueError("%s: not a little endian ELF file" % path)
+        if ident[4] == 1:
+            shoff, = struct.unpack_from("<I", self.data, 0x20)
+            shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+            shfmt = "<IIIIII"
+        else:
+            shoff, = struct.unpack_from("<Q", self.data, 0x28)
+            shentsize, shnum = struct.unpack_from("<HH", self.data, 0x3A)
+            shfmt = "<IIQQQQ"
+
+        for i in range(shnum):
+            _, shtype, flags, addr, offset, size = struct.unpack_from(
+                shfmt, self.data, shoff + i * shentsize)
+            # allocated, with contents in the file
+            if flags & 0x2 and shtype != 8 and size > 0:
+                self.sections.append((addr, offset, size))
+
+    def string(self, addr):
+        if addr in self.cache:
+            return self.cache[addr]
+        text = None
+        for base, offset, size in self.sections:
+            if base <= addr < base + size:
+                start = offset + addr - base
+                end = self.data.find(b"\0", start, offset + size)
+                if end >= 0:
+                    text = self.data[start:end].decode("latin-1")
+                break
+        self.cache[addr] = text
+        return text
+
+
+class Args:
+    """Raw arguments of a record, taken in format order."""
+
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def take(self, fmt, size):
+        if self.pos + size > len(self.data):
+            return None
+        value, = struct.unpack_from(fmt, self.data, self.pos)
+        self.pos += size
+        return value
+
+    def varint(self, signed):
+        value = 0
+        shift = 0
+        while self.pos < len(self.data):
+            b = self.data[self.pos]
+            self.pos += 1
+            value |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                if signed:
+                    value = (value >> 1) ^ -(value & 1)
+                return value
+        return None
+
+    def string(self):
+        if self.pos >= len(self.data):
+            return None
+        n = self.data[self.pos]
+        if self.pos + 1 + n > len(self.data):
+            return None
+        text = self.data[self.pos + 1:self.pos + 1 + n].decode("latin-1")
+        self.pos += 1 + n
+        return text
+
+
+def render(fmt, args):
+    """Formats as printf would, parsing the format the same way dlog.c does."""
+    out = []
+    i = 0
+    n = len(fmt)
+
+    while i < n:
+        c = fmt[i]
+        i += 1
+        if c != "%":
+            out.append(c)
+            continue
+
+        flags = ""
+        while i < n and fmt[i] in "-+ #0":
+            flags += fmt[i]
+            i += 1
+        spec = ""
+        while i < n and (fmt[i].isdigit() or fmt[i] in ".*"):
+            if fmt[i] == "*":
+                value = args.varint(True)
+                spec += "0" if value is None else str(value)
+            else:
+                spec += fmt[i]
+            i += 1
+        # lengths only matter to the sender, integers are varints
+        while i < n and fmt[i] in "hljztL":
+            i += 1
+        if i >= n:
+            break
+        conv = fmt[i]
+        i += 1
+        pyfmt = "%" + flags + spec
+
+        if conv == "%":
+            out.append("%")
+        elif conv in "diuoxXc":
+            value = args.varint(conv in "di")
+            if value is None:
+                out.append("?")
+            elif conv == "c":
+                out.append((pyfmt + "c") % (value & 0xFF))
+            else:
+                out.append((pyfmt + ("d" if conv == "u" else conv)) % value)
+        elif conv == "p":
+            value = args.varint(False)
+            out.append("?" if value is None else "0x%x" % value)
+        elif conv in "fFeEgGaA":
+            value = args.take("<d", 8)
+            if value is None:
+                out.append("?")
+            elif conv in "aA":
+                out.append(value.hex())
+            else:
+                out.append((pyfmt + conv) % value)
+        elif conv == "s":
+            value = args.string()
+            out.append("?" if value is None else (pyfmt + "s") % value)
+        else:
+            # %n or not a conversion, dlog.c stops here as well
+            break
+
+    return "".join(out)
+
+
+class Decoder:
+    def __init__(self, image, timestamps=True):
+        self.image = image
+        self.timestamps = timestamps
+        self.frame = bytearray()
+        self.escaped = False
+        self.synced = False
+        self.lastTime = None
+        self.base = 0
+        self.bad = 0
+
+    def feed(self, data):
+        lines = []
+        for b in data:
+            if b == FLAG:
+                if self.synced and self.frame:
+                    lines.append(self.record(bytes(self.frame)))
+                self.synced = True
+                self.frame = bytearray()
+                self.escaped = False
+            elif not self.synced:
+                continue
+            elif b == ESCAPE:
+                self.escaped = True
+            else:
+                if self.escaped:
+                    b ^= ESCAPE_XOR
+                    self.escaped = False
+                self.frame.append(b)
+        return lines
+
+    def seconds(self, time):
+        # microseconds since boot in 32 bits, wraps every 71 minutes.
+        # Records from different tasks may be a little out of order.
+        if self.lastTime is not None and time + (1 << 31) < self.lastTime:
+            self.base += 1 << 32
+        self.lastTime = time
+        return (self.base + time) / 1e6
+
+    def record(self, frame):
+        if len(frame) < HEADER_LEN or frame[0] != len(frame) - 1:
+            self.bad += 1
+            return "(bad record)"
+
+        level, region, fmtAddr, time = struct.unpack_from("<BBII", frame, 1)
+        args = Args(frame[HEADER_LEN:])
+
+        if fmtAddr == 0:
+            count = args.take("<I", 4)
+            text = "(%s records dropped)" % count
+        else:
+            fmt = self.image.string(fmtAddr)
+            if fmt is None:
+                text = "(unknown format 0x%08x)" % fmtAddr
+            else:
+                text = render(fmt, args).rstrip("\r\n")
+                if level & TRUNCATED:
+                    text += " (truncated)"
+
+        if region != REGION_APP:
+            level &= ~TRUNCATED
+            text = "%s %s: %s" % (LEVELS.get(level, level),
+                                  REGIONS.get(region, region), text)
+        if self.timestamps:
+            text = "[%12.6f] %s" % (self.seconds(time), text)
+        return text
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Decode the deferred binary log of the examples")
+    parser.add_argument("-e", "--elf", required=True,
+                        help="firmware image the log comes from")
+    parser.add_argument("-T", "--no-time", action="store_true",
+                        help="leave out the timestamps")
+    parser.add_argument("input", nargs="?", default="-",
+                        help="serial port or file with the log, - for stdin")
+    opts = parser.parse_args()
+
+    decoder = Decoder(Image(opts.elf), not opts.no_time)
+
+    if opts.input == "-":
+        stream = sys.stdin.buffer
+    else:
+        stream = open(opts.input, "rb", buffering=0)
+
+    try:
+        while True:
+            data = stream.read(4096)
+            if not data:
+                break
+            for line in decoder.feed(data):
+                print(line, flush=True)
+    except KeyboardInterrupt:
+        pass
+
+    return 1 if decoder.bad else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
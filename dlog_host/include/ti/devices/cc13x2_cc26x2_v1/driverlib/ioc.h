@@ -0,0 +1,4 @@
+/*
+ * Host stand-in for the driverlib IO controller header, only the board
+ * header includes it.
+ */
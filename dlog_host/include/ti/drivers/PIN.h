@@ -0,0 +1,11 @@
+/*
+ * Host stand-in for the TI PIN driver, only the board header needs it.
+ */
+#ifndef PIN_H
+#define PIN_H
+
+#include <stdint.h>
+
+typedef uint32_t PIN_Config;
+
+#endif /* PIN_H */
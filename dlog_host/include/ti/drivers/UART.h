@@ -0,0 +1,33 @@
+/*
+ * Host stand-in for the TI UART driver API used by dlog.c. The
+ * implementation in dlogcheck.c writes to a file.
+ */
+#ifndef UART_H
+#define UART_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct UART_Config_ *UART_Handle;
+
+typedef enum { UART_DATA_BINARY, UART_DATA_TEXT } UART_DataMode;
+typedef enum { UART_ECHO_OFF, UART_ECHO_ON } UART_Echo;
+
+typedef struct
+{
+    UART_DataMode   readDataMode;
+    UART_DataMode   writeDataMode;
+    UART_Echo       readEcho;
+    uint32_t        baudRate;
+} UART_Params;
+
+extern void UART_init(void);
+
+extern void UART_Params_init(UART_Params *params);
+
+extern UART_Handle UART_open(uint_least8_t index, UART_Params *params);
+
+extern int_fast32_t UART_write(UART_Handle handle, const void *buffer,
+                               size_t size);
+
+#endif /* UART_H */
@@ -0,0 +1,14 @@
+/*
+ * Host stand-in for the TI-RTOS clock, 10 us ticks as in the examples'
+ * release.cfg. Implemented in dlogcheck.c on the monotonic clock.
+ */
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+
+#define Clock_tickPeriod    ((uint32_t)10)
+
+extern uint32_t Clock_getTicks(void);
+
+#endif /* CLOCK_H */
@@ -0,0 +1,1162 @@
+/******************************************************************************
+
+ @file  ecjpakecheck.c
+
+ @brief Host check and benchmark of the EC-JPAKE module
+
+ Runs crypto/ecjpake_alt.c of an example application on Linux, with the
+ ECJPAKE driver on OpenSSL. Its peer in a handshake is either another
+ context of the module, or a reference written here from the protocol as
+ mbedtls puts it on the wire: big endian, on OpenSSL's big numbers, without
+ the driver or any of the module's encodings.
+
+   ecjpakecheck check [handshakes]
+       Runs handshakes with the module as client, as server and on both
+       sides, and checks that both sides derive the same secret. Checks
+       that a wrong password gives another secret, and that bad ZKPs,
+       points and scalar lengths are refused.
+
+   ecjpakecheck bench [handshakes]
+       Runs handshakes against the reference and shows, per handshake on
+       each side, the scalar multiplications asked of the driver, the round
+       two key generations and the host time spent outside the driver.
+       Build with SIM_ORIG to run the module as it was.
+
+ *****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/obj_mac.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+
+#include "mbedtls/ecjpake.h"
+
+#ifndef SIM_ORIG
+#include "platform.h"
+#endif
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+#define LEN                 32
+#define POINT_LEN           65
+#define MSG_LEN             512
+
+#define CHECK_HANDSHAKES    300
+#define BENCH_HANDSHAKES    200
+
+#define ARRAY_LEN(a)        (sizeof(a) / sizeof((a)[0]))
+
+static const unsigned char password[] = "J01NME";
+#ifndef SIM_ORIG
+static const unsigned char otherPassword[] = "J01NMF";
+#endif
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static EC_GROUP *group;
+static BN_CTX *bnCtx;
+static const BIGNUM *order;
+
+// What the driver was asked to do
+static struct
+{
+    unsigned long scalarMults;
+    unsigned long roundTwoKeys;
+    double        sec;
+} driver;
+
+// Reference r values sent shorter than 32 bytes
+static unsigned long refShortR;
+
+static int failures;
+
+#define FAIL(...) do { fprintf(stderr, __VA_ARGS__); \
+                       fputc('\n', stderr); \
+                       failures++; } while (0)
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+static double nowSec(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec + now.tv_nsec / 1e9);
+}
+
+static int rng(void *p_rng, unsigned char *buf, size_t len)
+{
+    (void)p_rng;
+
+    return ((RAND_bytes(buf, len) == 1) ? 0 : -1);
+}
+
+/* Multiplies and counts the scalar multiplications, r = G*n + P*m */
+static void mul(EC_POINT *r, const BIGNUM *n, const EC_POINT *p,
+                const BIGNUM *m)
+{
+    driver.scalarMults += (n != NULL) + (p != NULL);
+    EC_POINT_mul(group, r, n, p, m, bnCtx);
+}
+
+//*****************************************************************************
+// Stand-ins for mbedtls
+//*****************************************************************************
+
+static const int sha256Info;
+
+const mbedtls_md_info_t *mbedtls_md_info_from_type(mbedtls_md_type_t md_type)
+{
+    return ((md_type == MBEDTLS_MD_SHA256) ?
+            (const mbedtls_md_info_t *)&sha256Info : NULL);
+}
+
+unsigned char mbedtls_md_get_size(const mbedtls_md_info_t *md_info)
+{
+    (void)md_info;
+
+    return (SHA256_DIGEST_LENGTH);
+}
+
+int mbedtls_md(const mbedtls_md_info_t *md_info, const unsigned char *input,
+               size_t ilen, unsigned char *output)
+{
+    (void)md_info;
+
+    SHA256(input, ilen, output);
+    return (0);
+}
+
+void mbedtls_ecp_group_init(mbedtls_ecp_group *grp)
+{
+    grp->id = MBEDTLS_ECP_DP_NONE;
+}
+
+int mbedtls_ecp_group_load(mbedtls_ecp_group *grp, mbedtls_ecp_group_id id)
+{
+    if (id != MBEDTLS_ECP_DP_SECP256R1)
+    {
+        return (MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE);
+    }
+    grp->id = id;
+    return (0);
+}
+
+int mbedtls_ecp_tls_write_group(const mbedtls_ecp_group *grp, size_t *olen,
+                                unsigned char *buf, size_t blen)
+{
+    (void)grp;
+
+    if (blen < 3)
+    {
+        return (MBEDTLS_ERR_ECP_BUFFER_TOO_SMALL);
+    }
+    buf[0] = MBEDTLS_ECP_TLS_NAMED_CURVE;
+    buf[1] = 0;
+    buf[2] = 23;
+    *olen = 3;
+    return (0);
+}
+
+#ifndef SIM_ORIG
+uint64_t platformAlarmGetNowUs(void)
+{
+    return ((uint64_t)(nowSec() * 1e6));
+}
+#endif
+
+//*****************************************************************************
+// ECJPAKE driver stand-in, little endian keys and points
+//*****************************************************************************
+
+static uint8_t generatorLe[2 * LEN];
+
+const ECCParams_CurveParams ECCParams_NISTP256 = {
+    .length     = LEN,
+    .generatorX = generatorLe,
+    .generatorY = generatorLe + LEN,
+};
+
+static int ecjpakeHandle;
+
+void ECJPAKE_Params_init(ECJPAKE_Params *params)
+{
+    memset(params, 0, sizeof(*params));
+}
+
+ECJPAKE_Handle ECJPAKE_open(uint_least8_t index, ECJPAKE_Params *params)
+{
+    (void)index;
+    (void)params;
+
+    return ((ECJPAKE_Handle)&ecjpakeHandle);
+}
+
+void ECJPAKE_close(ECJPAKE_Handle handle)
+{
+    (void)handle;
+}
+
+#define OPERATION_INIT(type) \
+    void type##_init(type *operation) \
+    { \
+        memset(operation, 0, sizeof(*operation)); \
+    }
+
+OPERATION_INIT(ECJPAKE_OperationRoundOneGenerateKeys)
+OPERATION_INIT(ECJPAKE_OperationGenerateZKP)
+OPERATION_INIT(ECJPAKE_OperationVerifyZKP)
+OPERATION_INIT(ECJPAKE_OperationRoundTwoGenerateKeys)
+OPERATION_INIT(ECJPAKE_OperationComputeSharedSecret)
+
+static BIGNUM *scalarGet(const CryptoKey *key)
+{
+    return (BN_lebin2bn(key->u.plaintext.keyMaterial,
+                        key->u.plaintext.keyLength, NULL));
+}
+
+static void scalarPut(const BIGNUM *n, CryptoKey *key)
+{
+    BN_bn2lebinpad(n, key->u.plaintext.keyMaterial, LEN);
+}
+
+/* NULL if the key is not a point on the curve */
+static EC_POINT *pointGet(const CryptoKey *key)
+{
+    const uint8_t *m = key->u.plaintext.keyMaterial;
+    BIGNUM *x = BN_lebin2bn(m, LEN, NULL);
+    BIGNUM *y = BN_lebin2bn(m + LEN, LEN, NULL);
+    EC_POINT *p = EC_POINT_new(group);
+
+    if (!EC_POINT_set_affine_coordinates(group, p, x, y, bnCtx))
+    {
+        EC_POINT_free(p);
+        p = NULL;
+    }
+    BN_free(x);
+    BN_free(y);
+    return (p);
+}
+
+static void pointPut(const EC_POINT *p, CryptoKey *key)
+{
+    BIGNUM *x = BN_new();
+    BIGNUM *y = BN_new();
+
+    EC_POINT_get_affine_coordinates(group, p, x, y, bnCtx);
+    BN_bn2lebinpad(x, key->u.plaintext.keyMaterial, LEN);
+    BN_bn2lebinpad(y, key->u.plaintext.keyMaterial + LEN, LEN);
+    BN_free(x);
+    BN_free(y);
+}
+
+static void publicFromPrivate(const CryptoKey *privateKey,
+                              CryptoKey *publicKey)
+{
+    BIGNUM *k = scalarGet(privateKey);
+    EC_POINT *p = EC_POINT_new(group);
+
+    mul(p, k, NULL, NULL);
+    pointPut(p, publicKey);
+    EC_POINT_free(p);
+    BN_free(k);
+}
+
+int_fast16_t ECJPAKE_roundOneGenerateKeys(
+    ECJPAKE_Handle handle, ECJPAKE_OperationRoundOneGenerateKeys *operation)
+{
+    double t0 = nowSec();
+
+    (void)handle;
+
+    publicFromPrivate(operation->myPrivateKey1, operation->myPublicKey1);
+    publicFromPrivate(operation->myPrivateKey2, operation->myPublicKey2);
+    publicFromPrivate(operation->myPrivateV1, operation->myPublicV1);
+    publicFromPrivate(operation->myPrivateV2, operation->myPublicV2);
+
+    driver.sec += nowSec() - t0;
+    return (ECJPAKE_STATUS_SUCCESS);
+}
+
+int_fast16_t ECJPAKE_generateZKP(ECJPAKE_Handle handle,
+                                 ECJPAKE_OperationGenerateZKP *operation)
+{
+    double t0 = nowSec();
+    BIGNUM *x = scalarGet(operation->myPrivateKey);
+    BIGNUM *v = scalarGet(operation->myPrivateV);
+    BIGNUM *h = BN_lebin2bn(operation->hash, LEN, NULL);
+    BIGNUM *r = BN_new();
+
+    (void)handle;
+
+    // r = v - x * h mod n
+    BN_mod_mul(r, x, h, order, bnCtx);
+    BN_mod_sub(r, v, r, order, bnCtx);
+    BN_bn2lebinpad(r, operation->r, LEN);
+
+    BN_free(x);
+    BN_free(v);
+    BN_free(h);
+    BN_free(r);
+    driver.sec += nowSec() - t0;
+    return (ECJPAKE_STATUS_SUCCESS);
+}
+
+int_fast16_t ECJPAKE_verifyZKP(ECJPAKE_Handle handle,
+                               ECJPAKE_OperationVerifyZKP *operation)
+{
+    double t0 = nowSec();
+    EC_POINT *g = pointGet(operation->theirGenerator);
+    EC_POINT *x = pointGet(operation->theirPublicKey);
+    EC_POINT *v = pointGet(operation->theirPublicV);
+    BIGNUM *h = BN_lebin2bn(operation->hash, LEN, NULL);
+    BIGNUM *r = BN_lebin2bn(operation->r, LEN, NULL);
+    EC_POINT *t = EC_POINT_new(group);
+    EC_POINT *u = EC_POINT_new(group);
+    int_fast16_t status = ECJPAKE_STATUS_ERROR;
+
+    (void)handle;
+
+    // V = G * r + X * h
+    if (g != NULL && x != NULL && v != NULL)
+    {
+        BN_mod(h, h, order, bnCtx);
+        mul(t, NULL, g, r);
+        mul(u, NULL, x, h);
+        EC_POINT_add(group, t, t, u, bnCtx);
+        if (EC_POINT_cmp(group, t, v, bnCtx) == 0)
+        {
+            status = ECJPAKE_STATUS_SUCCESS;
+        }
+    }
+
+    EC_POINT_free(g);
+    EC_POINT_free(x);
+    EC_POINT_free(v);
+    EC_POINT_free(t);
+    EC_POINT_free(u);
+    BN_free(h);
+    BN_free(r);
+    driver.sec += nowSec() - t0;
+    return (status);
+}
+
+int_fast16_t ECJPAKE_roundTwoGenerateKeys(
+    ECJPAKE_Handle handle, ECJPAKE_OperationRoundTwoGenerateKeys *operation)
+{
+    double t0 = nowSec();
+    EC_POINT *myPublic1 = pointGet(operation->myPublicKey1);
+    EC_POINT *myPublic2 = pointGet(operation->myPublicKey2);
+    EC_POINT *theirPublic1 = pointGet(operation->theirPublicKey1);
+    EC_POINT *theirPublic2 = pointGet(operation->theirPublicKey2);
+    EC_POINT *p = EC_POINT_new(group);
+    EC_POINT *myGenerator = EC_POINT_new(group);
+    BIGNUM *x2 = scalarGet(operation->myPrivateKey2);
+    BIGNUM *s = scalarGet(operation->preSharedSecret);
+    BIGNUM *v = scalarGet(operation->myPrivateV);
+    BIGNUM *xs = BN_new();
+
+    (void)handle;
+
+    driver.roundTwoKeys++;
+
+    // Mine is X1 + X3 + X4, theirs X3 + X1 + X2, in my numbering
+    EC_POINT_add(group, myGenerator, myPublic1, theirPublic1, bnCtx);
+    EC_POINT_add(group, myGenerator, myGenerator, theirPublic2, bnCtx);
+    pointPut(myGenerator, operation->myNewGenerator);
+
+    EC_POINT_add(group, p, myPublic1, myPublic2, bnCtx);
+    EC_POINT_add(group, p, p, theirPublic1, bnCtx);
+    pointPut(p, operation->theirNewGenerator);
+
+    BN_mod_mul(xs, x2, s, order, bnCtx);
+    scalarPut(xs, operation->myCombinedPrivateKey);
+
+    mul(p, NULL, myGenerator, xs);
+    pointPut(p, operation->myCombinedPublicKey);
+
+    mul(p, NULL, myGenerator, v);
+    pointPut(p, operation->myPublicV);
+
+    EC_POINT_free(myPublic1);
+    EC_POINT_free(myPublic2);
+    EC_POINT_free(theirPublic1);
+    EC_POINT_free(theirPublic2);
+    EC_POINT_free(p);
+    EC_POINT_free(myGenerator);
+    BN_free(x2);
+    BN_free(s);
+    BN_free(v);
+    BN_free(xs);
+    driver.sec += nowSec() - t0;
+    return (ECJPAKE_STATUS_SUCCESS);
+}
+
+int_fast16_t ECJPAKE_computeSharedSecret(
+    ECJPAKE_Handle handle, ECJPAKE_OperationComputeSharedSecret *operation)
+{
+    double t0 = nowSec();
+    EC_POINT *theirCombined = pointGet(operation->theirCombinedPublicKey);
+    EC_POINT *theirPublic2 = pointGet(operation->theirPublicKey2);
+    EC_POINT *k = EC_POINT_new(group);
+    BIGNUM *xs = scalarGet(operation->myCombinedPrivateKey);
+    BIGNUM *x2 = scalarGet(operation->myPrivateKey2);
+
+    (void)handle;
+
+    // K = (Xp - X4 * x2 * s) * x2
+    mul(k, NULL, theirPublic2, xs);
+    EC_POINT_invert(group, k, bnCtx);
+    EC_POINT_add(group, k, theirCombined, k, bnCtx);
+    mul(k, NULL, k, x2);
+    pointPut(k, operation->sharedSecret);
+
+    EC_POINT_free(theirCombined);
+    EC_POINT_free(theirPublic2);
+    EC_POINT_free(k);
+    BN_free(xs);
+    BN_free(x2);
+    driver.sec += nowSec() - t0;
+    return (ECJPAKE_STATUS_SUCCESS);
+}
+
+//*****************************************************************************
+// Reference EC-JPAKE, big endian as on the wire
+//*****************************************************************************
+
+typedef struct
+{
+    mbedtls_ecjpake_role role;
+    BIGNUM *s;
+    BIGNUM *x1;
+    BIGNUM *x2;
+    EC_POINT *X1;
+    EC_POINT *X2;
+    EC_POINT *X3;
+    EC_POINT *X4;
+    EC_POINT *Xp;
+} refPeer_t;
+
+static const char *refId(mbedtls_ecjpake_role role)
+{
+    return ((role == MBEDTLS_ECJPAKE_CLIENT) ? "client" : "server");
+}
+
+static void refSetup(refPeer_t *ref, mbedtls_ecjpake_role role,
+                     const unsigned char *secret, size_t len)
+{
+    memset(ref, 0, sizeof(*ref));
+    ref->role = role;
+    ref->s  = BN_bin2bn(secret, len, NULL);
+    ref->x1 = BN_new();
+    ref->x2 = BN_new();
+    ref->X1 = EC_POINT_new(group);
+    ref->X2 = EC_POINT_new(group);
+    ref->X3 = EC_POINT_new(group);
+    ref->X4 = EC_POINT_new(group);
+    ref->Xp = EC_POINT_new(group);
+}
+
+static void refFree(refPeer_t *ref)
+{
+    BN_free(ref->s);
+    BN_free(ref->x1);
+    BN_free(ref->x2);
+    EC_POINT_free(ref->X1);
+    EC_POINT_free(ref->X2);
+    EC_POINT_free(ref->X3);
+    EC_POINT_free(ref->X4);
+    EC_POINT_free(ref->Xp);
+}
+
+static void refRandom(BIGNUM *k)
+{
+    do
+    {
+        BN_rand_range(k, order);
+    } while (BN_is_zero(k));
+}
+
+/* h = H(G || V || X || id) mod n, each with a 4 byte length */
+static BIGNUM *refHash(const EC_POINT *g, const EC_POINT *v,
+                       const EC_POINT *x, const char *id)
+{
+    const EC_POINT *points[] = { g, v, x };
+    unsigned char buf[3 * (4 + POINT_LEN) + 4 + 6];
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    unsigned char *p = buf;
+    size_t idLen = strlen(id);
+    size_t len;
+    size_t i;
+    BIGNUM *h;
+
+    for (i = 0; i < ARRAY_LEN(points); i++)
+    {
+        len = EC_POINT_point2oct(group, points[i],
+                                 POINT_CONVERSION_UNCOMPRESSED, p + 4,
+                                 POINT_LEN, bnCtx);
+        p[0] = 0;
+        p[1] = 0;
+        p[2] = 0;
+        p[3] = (unsigned char)len;
+        p += 4 + len;
+    }
+    p[0] = 0;
+    p[1] = 0;
+    p[2] = 0;
+    p[3] = (unsigned char)idLen;
+    memcpy(p + 4, id, idLen);
+    p += 4 + idLen;
+
+    SHA256(buf, p - buf, hash);
+    h = BN_bin2bn(hash, sizeof(hash), NULL);
+    BN_mod(h, h, order, bnCtx);
+    return (h);
+}
+
+static void refWritePoint(unsigned char **p, const EC_POINT *point)
+{
+    size_t len = EC_POINT_point2oct(group, point,
+                                    POINT_CONVERSION_UNCOMPRESSED, *p + 1,
+                                    POINT_LEN, bnCtx);
+
+    (*p)[0] = (unsigned char)len;
+    *p += 1 + len;
+}
+
+static bool refReadPoint(const unsigned char **p, const unsigned char *end,
+                         EC_POINT *point)
+{
+    size_t len;
+
+    if (end - *p < 1)
+    {
+        return (false);
+    }
+    len = *(*p)++;
+    if ((size_t)(end - *p) < len ||
+        !EC_POINT_oct2point(group, point, *p, len, bnCtx))
+    {
+        return (false);
+    }
+    *p += len;
+    return (true);
+}
+
+/* Writes X and its ZKP over generator g, r without its leading zeros */
+static void refWriteKeyKp(unsigned char **p, const EC_POINT *g,
+                          const BIGNUM *x, const EC_POINT *X, const char *id)
+{
+    BIGNUM *v = BN_new();
+    BIGNUM *r = BN_new();
+    BIGNUM *h;
+    EC_POINT *V = EC_POINT_new(group);
+    int len;
+
+    refRandom(v);
+    EC_POINT_mul(group, V, NULL, g, v, bnCtx);
+    h = refHash(g, V, X, id);
+
+    BN_mod_mul(r, x, h, order, bnCtx);
+    BN_mod_sub(r, v, r, order, bnCtx);
+
+    refWritePoint(p, X);
+    refWritePoint(p, V);
+    len = BN_num_bytes(r);
+    if (len < LEN)
+    {
+        refShortR++;
+    }
+    (*p)[0] = (unsigned char)len;
+    BN_bn2bin(r, *p + 1);
+    *p += 1 + len;
+
+    BN_free(v);
+    BN_free(r);
+    BN_free(h);
+    EC_POINT_free(V);
+}
+
+static bool refReadKeyKp(const unsigned char **p, const unsigned char *end,
+                         const EC_POINT *g, EC_POINT *X, const char *id)
+{
+    EC_POINT *V = EC_POINT_new(group);
+    EC_POINT *t = EC_POINT_new(group);
+    EC_POINT *u = EC_POINT_new(group);
+    BIGNUM *r = NULL;
+    BIGNUM *h = NULL;
+    bool ok = false;
+    size_t len;
+
+    if (refReadPoint(p, end, X) && refReadPoint(p, end, V) &&
+        end - *p >= 1)
+    {
+        len = *(*p)++;
+        if ((size_t)(end - *p) >= len)
+        {
+            r = BN_bin2bn(*p, len, NULL);
+            *p += len;
+            h = refHash(g, V, X, id);
+
+            // V = G * r + X * h
+            EC_POINT_mul(group, t, NULL, g, r, bnCtx);
+            EC_POINT_mul(group, u, NULL, X, h, bnCtx);
+            EC_POINT_add(group, t, t, u, bnCtx);
+            ok = (EC_POINT_cmp(group, t, V, bnCtx) == 0);
+        }
+    }
+
+    EC_POINT_free(V);
+    EC_POINT_free(t);
+    EC_POINT_free(u);
+    BN_free(r);
+    BN_free(h);
+    return (ok);
+}
+
+static size_t refWriteRoundOne(refPeer_t *ref, unsigned char *buf)
+{
+    const EC_POINT *g = EC_GROUP_get0_generator(group);
+    unsigned char *p = buf;
+
+    refRandom(ref->x1);
+    refRandom(ref->x2);
+    EC_POINT_mul(group, ref->X1, ref->x1, NULL, NULL, bnCtx);
+    EC_POINT_mul(group, ref->X2, ref->x2, NULL, NULL, bnCtx);
+    refWriteKeyKp(&p, g, ref->x1, ref->X1, refId(ref->role));
+    refWriteKeyKp(&p, g, ref->x2, ref->X2, refId(ref->role));
+    return (p - buf);
+}
+
+static bool refReadRoundOne(refPeer_t *ref, const unsigned char *buf,
+                            size_t len)
+{
+    const EC_POINT *g = EC_GROUP_get0_generator(group);
+    const unsigned char *p = buf;
+    const char *id = refId(1 - ref->role);
+
+    return (refReadKeyKp(&p, buf + len, g, ref->X3, id) &&
+            refReadKeyKp(&p, buf + len, g, ref->X4, id) &&
+            p == buf + len);
+}
+
+static size_t refWriteRoundTwo(refPeer_t *ref, unsigned char *buf)
+{
+    EC_POINT *g = EC_POINT_new(group);
+    EC_POINT *X = EC_POINT_new(group);
+    BIGNUM *xs = BN_new();
+    unsigned char *p = buf;
+
+    if (ref->role == MBEDTLS_ECJPAKE_SERVER)
+    {
+        *p++ = MBEDTLS_ECP_TLS_NAMED_CURVE;
+        *p++ = 0;
+        *p++ = 23;
+    }
+
+    // G = X1 + X3 + X4, x = x2 * s
+    EC_POINT_add(group, g, ref->X1, ref->X3, bnCtx);
+    EC_POINT_add(group, g, g, ref->X4, bnCtx);
+    BN_mod_mul(xs, ref->x2, ref->s, order, bnCtx);
+    EC_POINT_mul(group, X, NULL, g, xs, bnCtx);
+    refWriteKeyKp(&p, g, xs, X, refId(ref->role));
+
+    EC_POINT_free(g);
+    EC_POINT_free(X);
+    BN_free(xs);
+    return (p - buf);
+}
+
+static bool refReadRoundTwo(refPeer_t *ref, const unsigned char *buf,
+                            size_t len)
+{
+    EC_POINT *g = EC_POINT_new(group);
+    const unsigned char *p = buf;
+    bool ok;
+
+    if (ref->role == MBEDTLS_ECJPAKE_CLIENT)
+    {
+        if (len < 3 || p[0] != MBEDTLS_ECP_TLS_NAMED_CURVE || p[1] != 0 ||
+            p[2] != 23)
+        {
+            EC_POINT_free(g);
+            return (false);
+        }
+        p += 3;
+    }
+
+    // Their generator, X3 + X1 + X2 in their numbering
+    EC_POINT_add(group, g, ref->X3, ref->X1, bnCtx);
+    EC_POINT_add(group, g, g, ref->X2, bnCtx);
+    ok = refReadKeyKp(&p, buf + len, g, ref->Xp, refId(1 - ref->role)) &&
+         p == buf + len;
+
+    EC_POINT_free(g);
+    return (ok);
+}
+
+static void refDerive(refPeer_t *ref, unsigned char *pms)
+{
+    EC_POINT *k = EC_POINT_new(group);
+    BIGNUM *xs = BN_new();
+    BIGNUM *x = BN_new();
+    unsigned char kx[LEN];
+
+    // K = (Xp - X4 * x2 * s) * x2, the secret is the hash of its X
+    BN_mod_mul(xs, ref->x2, ref->s, order, bnCtx);
+    EC_POINT_mul(group, k, NULL, ref->X4, xs, bnCtx);
+    EC_POINT_invert(group, k, bnCtx);
+    EC_POINT_add(group, k, ref->Xp, k, bnCtx);
+    EC_POINT_mul(group, k, NULL, k, ref->x2, bnCtx);
+    EC_POINT_get_affine_coordinates(group, k, x, NULL, bnCtx);
+    BN_bn2binpad(x, kx, LEN);
+    SHA256(kx, LEN, pms);
+
+    EC_POINT_free(k);
+    BN_free(xs);
+    BN_free(x);
+}
+
+//*****************************************************************************
+// Handshakes
+//*****************************************************************************
+
+typedef struct
+{
+    bool alt;
+    mbedtls_ecjpake_context ctx;
+    refPeer_t ref;
+    double sec;         // Time spent in the module
+    double driverSec;   // Of which in the driver
+} peer_t;
+
+static void peerSetup(peer_t *peer, bool alt, mbedtls_ecjpake_role role,
+                      const unsigned char *secret, size_t len)
+{
+    peer->alt = alt;
+    peer->sec = 0;
+    peer->driverSec = 0;
+    if (alt)
+    {
+        mbedtls_ecjpake_init(&peer->ctx);
+        if (mbedtls_ecjpake_setup(&peer->ctx, role, MBEDTLS_MD_SHA256,
+                                  MBEDTLS_ECP_DP_SECP256R1, secret,
+                                  len) != 0 ||
+            mbedtls_ecjpake_check(&peer->ctx) != 0)
+        {
+            FAIL("setup failed");
+        }
+    }
+    else
+    {
+        refSetup(&peer->ref, role, secret, len);
+    }
+}
+
+static void peerFree(peer_t *peer)
+{
+    if (peer->alt)
+    {
+        mbedtls_ecjpake_free(&peer->ctx);
+    }
+    else
+    {
+        refFree(&peer->ref);
+    }
+}
+
+// Runs a step of the module and keeps the time it took
+#define ALT_STEP(peer, call) ({ \
+        double t0 = nowSec(); \
+        double d0 = driver.sec; \
+        int ret = (call); \
+        (peer)->sec += nowSec() - t0; \
+        (peer)->driverSec += driver.sec - d0; \
+        ret; })
+
+static int peerWrite(peer_t *peer, int round, unsigned char *buf,
+                     size_t *len)
+{
+    if (!peer->alt)
+    {
+        *len = (round == 1) ? refWriteRoundOne(&peer->ref, buf)
+                            : refWriteRoundTwo(&peer->ref, buf);
+        return (0);
+    }
+    if (round == 1)
+    {
+        return (ALT_STEP(peer, mbedtls_ecjpake_write_round_one(
+                             &peer->ctx, buf, MSG_LEN, len, rng, NULL)));
+    }
+    return (ALT_STEP(peer, mbedtls_ecjpake_write_round_two(
+                         &peer->ctx, buf, MSG_LEN, len, rng, NULL)));
+}
+
+static int peerRead(peer_t *peer, int round, const unsigned char *buf,
+                    size_t len)
+{
+    if (!peer->alt)
+    {
+        return (((round == 1) ? refReadRoundOne(&peer->ref, buf, len)
+                              : refReadRoundTwo(&peer->ref, buf, len)) ?
+                0 : -1);
+    }
+    if (round == 1)
+    {
+        return (ALT_STEP(peer, mbedtls_ecjpake_read_round_one(&peer->ctx,
+                                                              buf, len)));
+    }
+    return (ALT_STEP(peer, mbedtls_ecjpake_read_round_two(&peer->ctx, buf,
+                                                          len)));
+}
+
+static int peerDerive(peer_t *peer, unsigned char *pms)
+{
+    size_t len;
+
+    if (!peer->alt)
+    {
+        refDerive(&peer->ref, pms);
+        return (0);
+    }
+    return (ALT_STEP(peer, mbedtls_ecjpake_derive_secret(
+                         &peer->ctx, pms, LEN, &len, rng, NULL)));
+}
+
+/*
+ * Runs the steps in the order of a DTLS handshake: ClientHello,
+ * ServerHello with ServerKeyExchange, then ClientKeyExchange. Returns the
+ * step that failed, 0 if none did.
+ */
+static int handshake(peer_t *client, peer_t *server,
+                     unsigned char *clientPms, unsigned char *serverPms)
+{
+    unsigned char buf[MSG_LEN];
+    size_t len;
+
+    if (peerWrite(client, 1, buf, &len) != 0)
+        return (1);
+    if (peerRead(server, 1, buf, len) != 0)
+        return (2);
+    if (peerWrite(server, 1, buf, &len) != 0)
+        return (3);
+    if (peerRead(client, 1, buf, len) != 0)
+        return (4);
+    if (peerWrite(server, 2, buf, &len) != 0)
+        return (5);
+    if (peerRead(client, 2, buf, len) != 0)
+        return (6);
+    if (peerWrite(client, 2, buf, &len) != 0)
+        return (7);
+    if (peerDerive(client, clientPms) != 0)
+        return (8);
+    if (peerRead(server, 2, buf, len) != 0)
+        return (9);
+    if (peerDerive(server, serverPms) != 0)
+        return (10);
+    return (0);
+}
+
+static void init(void)
+{
+    BIGNUM *x = BN_new();
+    BIGNUM *y = BN_new();
+
+    group = EC_GROUP_new_by_curve_name(NID_X9_62_prime256v1);
+    bnCtx = BN_CTX_new();
+    order = EC_GROUP_get0_order(group);
+
+    EC_POINT_get_affine_coordinates(group, EC_GROUP_get0_generator(group),
+                                    x, y, bnCtx);
+    BN_bn2lebinpad(x, generatorLe, LEN);
+    BN_bn2lebinpad(y, generatorLe + LEN, LEN);
+    BN_free(x);
+    BN_free(y);
+}
+
+//*****************************************************************************
+// Check
+//*****************************************************************************
+
+#ifndef SIM_ORIG
+static void checkPairs(int handshakes)
+{
+    static const struct
+    {
+        const char *name;
+        bool clientAlt;
+        bool serverAlt;
+    } pairs[] = {
+        { "module client, reference server", true,  false },
+        { "reference client, module server", false, true  },
+        { "module client, module server",    true,  true  },
+    };
+    unsigned char clientPms[LEN];
+    unsigned char serverPms[LEN];
+    peer_t client;
+    peer_t server;
+    size_t i;
+    int n;
+    int step;
+
+    for (i = 0; i < ARRAY_LEN(pairs); i++)
+    {
+        for (n = 0; n < handshakes; n++)
+        {
+            peerSetup(&client, pairs[i].clientAlt, MBEDTLS_ECJPAKE_CLIENT,
+                      password, sizeof(password) - 1);
+            peerSetup(&server, pairs[i].serverAlt, MBEDTLS_ECJPAKE_SERVER,
+                      password, sizeof(password) - 1);
+
+            step = handshake(&client, &server, clientPms, serverPms);
+            if (step != 0)
+            {
+                FAIL("%s: handshake %d failed at step %d", pairs[i].name, n,
+                     step);
+            }
+            else if (memcmp(clientPms, serverPms, LEN) != 0)
+            {
+                FAIL("%s: handshake %d, secrets differ", pairs[i].name, n);
+            }
+
+            peerFree(&client);
+            peerFree(&server);
+        }
+        printf("%-34s %d handshakes\n", pairs[i].name, handshakes);
+    }
+}
+
+static void checkWrongPassword(void)
+{
+    unsigned char clientPms[LEN];
+    unsigned char serverPms[LEN];
+    peer_t client;
+    peer_t server;
+
+    peerSetup(&client, true, MBEDTLS_ECJPAKE_CLIENT, password,
+              sizeof(password) - 1);
+    peerSetup(&server, false, MBEDTLS_ECJPAKE_SERVER, otherPassword,
+              sizeof(otherPassword) - 1);
+
+    if (handshake(&client, &server, clientPms, serverPms) != 0 ||
+        memcmp(clientPms, serverPms, LEN) == 0)
+    {
+        FAIL("wrong password: handshake should run and secrets differ");
+    }
+
+    peerFree(&client);
+    peerFree(&server);
+}
+
+/*
+ * Makes a round one message of the reference, changes it and checks that
+ * the module refuses it. Offsets are into the first ECJPAKEKeyKP:
+ * X at 0, V at 66, r length at 132, r at 133.
+ */
+static void checkBadRoundOne(const char *what, int offset, int value,
+                             int insert)
+{
+    unsigned char buf[MSG_LEN];
+    peer_t server;
+    refPeer_t ref;
+    size_t len;
+    int i;
+
+    refSetup(&ref, MBEDTLS_ECJPAKE_CLIENT, password, sizeof(password) - 1);
+    do
+    {
+        len = refWriteRoundOne(&ref, buf);
+    } while (buf[132] != LEN);
+
+    // Bytes inserted at offset, to make a field longer
+    memmove(buf + offset + insert, buf + offset, len - offset);
+    for (i = 0; i < insert; i++)
+    {
+        buf[offset + i] = 0;
+    }
+    len += insert;
+    if (value >= 0)
+    {
+        buf[offset] = (unsigned char)value;
+    }
+    else
+    {
+        buf[offset] ^= 0x01;
+    }
+
+    peerSetup(&server, true, MBEDTLS_ECJPAKE_SERVER, password,
+              sizeof(password) - 1);
+    if (mbedtls_ecjpake_read_round_one(&server.ctx, buf, len) == 0)
+    {
+        FAIL("%s accepted", what);
+    }
+    peerFree(&server);
+    refFree(&ref);
+}
+
+static void checkProfile(int handshakesBefore)
+{
+    PlatformEcjpake_Profile profile;
+    unsigned char clientPms[LEN];
+    unsigned char serverPms[LEN];
+    peer_t client;
+    peer_t server;
+    int i;
+
+    peerSetup(&client, true, MBEDTLS_ECJPAKE_CLIENT, password,
+              sizeof(password) - 1);
+    peerSetup(&server, false, MBEDTLS_ECJPAKE_SERVER, password,
+              sizeof(password) - 1);
+    handshake(&client, &server, clientPms, serverPms);
+
+    platformEcjpakeGetProfile(&profile);
+    if ((int)profile.handshakes != handshakesBefore + 1)
+    {
+        FAIL("profile counts %lu handshakes, %d set up",
+             (unsigned long)profile.handshakes, handshakesBefore + 1);
+    }
+    for (i = 0; i < PlatformEcjpake_opCount; i++)
+    {
+        if (profile.start[i] == 0 ||
+            (i > 0 && profile.start[i] < profile.start[i - 1]))
+        {
+            FAIL("profile step %d not recorded in order", i);
+        }
+    }
+
+    peerFree(&client);
+    peerFree(&server);
+}
+
+static int runCheck(int handshakes)
+{
+    PlatformEcjpake_Profile profile;
+
+    checkPairs(handshakes);
+    checkWrongPassword();
+
+    checkBadRoundOne("changed r", 140, -1, 0);
+    checkBadRoundOne("changed V", 100, -1, 0);
+    checkBadRoundOne("r longer than 32 bytes", 132, 40, 8);
+    checkBadRoundOne("r of 0 bytes", 132, 0, 0);
+    checkBadRoundOne("point of 1 byte", 0, 1, 0);
+    checkBadRoundOne("compressed point", 1, 0x02, 0);
+    checkBadRoundOne("point longer than 65 bytes", 0, 66, 1);
+
+    platformEcjpakeGetProfile(&profile);
+    checkProfile(profile.handshakes);
+
+    if (refShortR == 0)
+    {
+        FAIL("no r shorter than 32 bytes was sent, run more handshakes");
+    }
+
+    printf("%lu r values shorter than 32 bytes read: %s\n", refShortR,
+           failures ? "FAILED" : "ok");
+    return (failures ? 1 : 0);
+}
+#endif /* !SIM_ORIG */
+
+//*****************************************************************************
+// Bench
+//*****************************************************************************
+
+static void benchSide(bool moduleIsClient, int handshakes)
+{
+    unsigned char clientPms[LEN];
+    unsigned char serverPms[LEN];
+    unsigned long mults = 0;
+    unsigned long keys = 0;
+    unsigned long before;
+    unsigned long keysBefore;
+    double outside = 0;
+    int failed = 0;
+    peer_t client;
+    peer_t server;
+    peer_t *module;
+    int n;
+
+    for (n = 0; n < handshakes; n++)
+    {
+        peerSetup(&client, moduleIsClient, MBEDTLS_ECJPAKE_CLIENT, password,
+                  sizeof(password) - 1);
+        peerSetup(&server, !moduleIsClient, MBEDTLS_ECJPAKE_SERVER, password,
+                  sizeof(password) - 1);
+        module = moduleIsClient ? &client : &server;
+
+        // Only the module's side calls the driver
+        before = driver.scalarMults;
+        keysBefore = driver.roundTwoKeys;
+        if (handshake(&client, &server, clientPms, serverPms) != 0 ||
+            memcmp(clientPms, serverPms, LEN) != 0)
+        {
+            failed++;
+        }
+        mults += driver.scalarMults - before;
+        keys += driver.roundTwoKeys - keysBefore;
+        outside += module->sec - module->driverSec;
+
+        peerFree(&client);
+        peerFree(&server);
+    }
+
+    printf("%-8s %12.1f %12.2f %14.1f %8d\n",
+           moduleIsClient ? "client" : "server",
+           (double)mults / handshakes, (double)keys / handshakes,
+           outside * 1e6 / handshakes, failed);
+}
+
+static int runBench(int handshakes)
+{
+#ifdef SIM_ORIG
+    printf("module as it was, %d handshakes against the reference:\n",
+           handshakes);
+#else
+    printf("module, %d handshakes against the reference:\n", handshakes);
+#endif
+    printf("%-8s %12s %12s %14s %8s\n", "side", "scalar mults",
+           "round 2 keys", "us outside drv", "failed");
+    benchSide(true, handshakes);
+    benchSide(false, handshakes);
+    return (0);
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: ecjpakecheck check [handshakes]\n"
+            "       ecjpakecheck bench [handshakes]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    init();
+
+#ifndef SIM_ORIG
+    if ((argc == 2 || argc == 3) && strcmp(argv[1], "check") == 0)
+    {
+        return (runCheck((argc == 3) ? atoi(argv[2]) : CHECK_HANDSHAKES));
+    }
+#endif
+    if ((argc == 2 || argc == 3) && strcmp(argv[1], "bench") == 0)
+    {
+        return (runBench((argc == 3) ? atoi(argv[2]) : BENCH_HANDSHAKES));
+    }
+    usage();
+    return (2);
+}
@@ -0,0 +1,66 @@
+/*
+ * Host stand-in for the EC-JPAKE context of the hardware EC-JPAKE module,
+ * as crypto/ecjpake_alt.c uses it. Keys are little endian, points X then Y.
+ */
+#ifndef ECJPAKE_ALT_H
+#define ECJPAKE_ALT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <ti/drivers/ECJPAKE.h>
+#include <ti/drivers/cryptoutils/cryptokey/CryptoKey.h>
+
+#define ECC_SECP256R1_LENGTH    32
+
+typedef struct
+{
+    const mbedtls_md_info_t *md_info;
+    mbedtls_ecp_group grp;
+    mbedtls_ecjpake_role role;
+    int point_format;
+
+    ECJPAKE_Handle handle;
+    bool roundTwoGenerated;
+
+    CryptoKey nistP256GeneratorCryptoKey;
+    CryptoKey preSharedSecretCryptoKey;
+    CryptoKey myPrivateCryptoKey1;
+    CryptoKey myPrivateCryptoKey2;
+    CryptoKey myPrivateCryptoV1;
+    CryptoKey myPrivateCryptoV2;
+    CryptoKey myPrivateCryptoV3;
+    CryptoKey myPublicCryptoKey1;
+    CryptoKey myPublicCryptoKey2;
+    CryptoKey myPublicCryptoV1;
+    CryptoKey myPublicCryptoV2;
+    CryptoKey myPublicCryptoV3;
+    CryptoKey myCombinedPrivateKey;
+    CryptoKey myCombinedPublicKey;
+    CryptoKey myGeneratorKey;
+    CryptoKey theirPublicCryptoKey1;
+    CryptoKey theirPublicCryptoKey2;
+    CryptoKey theirCombinedPublicKey;
+    CryptoKey theirGeneratorKey;
+
+    uint8_t preSharedSecretKeyingMaterial[32];
+    uint8_t myPrivateKeyMaterial1[32];
+    uint8_t myPrivateKeyMaterial2[32];
+    uint8_t myPrivateVMaterial1[32];
+    uint8_t myPrivateVMaterial2[32];
+    uint8_t myPrivateVMaterial3[32];
+    uint8_t myPublicKeyMaterial1[64];
+    uint8_t myPublicKeyMaterial2[64];
+    uint8_t myPublicVMaterial1[64];
+    uint8_t myPublicVMaterial2[64];
+    uint8_t myPublicVMaterial3[64];
+    uint8_t myCombinedPrivateKeyMaterial1[32];
+    uint8_t myCombinedPublicKeyMaterial1[64];
+    uint8_t myGenerator[64];
+    uint8_t theirPublicKeyMaterial1[64];
+    uint8_t theirPublicKeyMaterial2[64];
+    uint8_t theirCombinedPublicKeyMaterial1[64];
+    uint8_t theirGenerator[64];
+} mbedtls_ecjpake_context;
+
+#endif /* ECJPAKE_ALT_H */
@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for the mbedtls configuration of the examples, with the
+ * hardware EC-JPAKE of crypto/ecjpake_alt.c.
+ */
+#ifndef MBEDTLS_CONFIG_H
+#define MBEDTLS_CONFIG_H
+
+#define MBEDTLS_ECJPAKE_ALT
+
+#endif /* MBEDTLS_CONFIG_H */
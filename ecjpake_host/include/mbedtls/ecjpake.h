@@ -0,0 +1,104 @@
+/*
+ * Host stand-in for the mbedtls EC-JPAKE module, with the parts of the md
+ * and ecp modules crypto/ecjpake_alt.c uses. ecjpakecheck.c runs them on
+ * OpenSSL.
+ */
+#ifndef MBEDTLS_ECJPAKE_H
+#define MBEDTLS_ECJPAKE_H
+
+#include <stddef.h>
+
+#define MBEDTLS_ERR_ECP_BAD_INPUT_DATA          -0x4F80
+#define MBEDTLS_ERR_ECP_BUFFER_TOO_SMALL        -0x4F00
+#define MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE     -0x4E80
+#define MBEDTLS_ERR_ECP_VERIFY_FAILED           -0x4E00
+#define MBEDTLS_ERR_ECP_RANDOM_FAILED           -0x4D00
+#define MBEDTLS_ERR_ECP_INVALID_KEY             -0x4C80
+#define MBEDTLS_ERR_MD_FEATURE_UNAVAILABLE      -0x5080
+
+#define MBEDTLS_ECP_PF_UNCOMPRESSED     0
+#define MBEDTLS_ECP_TLS_NAMED_CURVE     3
+#define MBEDTLS_ECP_MAX_PT_LEN          133
+
+typedef enum
+{
+    MBEDTLS_MD_NONE = 0,
+    MBEDTLS_MD_SHA256 = 6,
+} mbedtls_md_type_t;
+
+typedef struct mbedtls_md_info_t mbedtls_md_info_t;
+
+typedef enum
+{
+    MBEDTLS_ECP_DP_NONE = 0,
+    MBEDTLS_ECP_DP_SECP256R1 = 3,
+} mbedtls_ecp_group_id;
+
+typedef struct
+{
+    mbedtls_ecp_group_id id;
+} mbedtls_ecp_group;
+
+typedef enum
+{
+    MBEDTLS_ECJPAKE_CLIENT = 0,
+    MBEDTLS_ECJPAKE_SERVER,
+} mbedtls_ecjpake_role;
+
+#include "ecjpake_alt.h"
+
+const mbedtls_md_info_t *mbedtls_md_info_from_type(mbedtls_md_type_t md_type);
+
+unsigned char mbedtls_md_get_size(const mbedtls_md_info_t *md_info);
+
+int mbedtls_md(const mbedtls_md_info_t *md_info, const unsigned char *input,
+               size_t ilen, unsigned char *output);
+
+void mbedtls_ecp_group_init(mbedtls_ecp_group *grp);
+
+int mbedtls_ecp_group_load(mbedtls_ecp_group *grp, mbedtls_ecp_group_id id);
+
+int mbedtls_ecp_tls_write_group(const mbedtls_ecp_group *grp, size_t *olen,
+                                unsigned char *buf, size_t blen);
+
+void mbedtls_ecjpake_init(mbedtls_ecjpake_context *ctx);
+
+void mbedtls_ecjpake_free(mbedtls_ecjpake_context *ctx);
+
+int mbedtls_ecjpake_setup(mbedtls_ecjpake_context *ctx,
+                          mbedtls_ecjpake_role role,
+                          mbedtls_md_type_t hash,
+                          mbedtls_ecp_group_id curve,
+                          const unsigned char *secret,
+                          size_t len);
+
+int mbedtls_ecjpake_check(const mbedtls_ecjpake_context *ctx);
+
+int mbedtls_ecjpake_write_round_one(mbedtls_ecjpake_context *ctx,
+                                    unsigned char *buf, size_t len,
+                                    size_t *olen,
+                                    int (*f_rng)(void *, unsigned char *,
+                                                 size_t),
+                                    void *p_rng);
+
+int mbedtls_ecjpake_read_round_one(mbedtls_ecjpake_context *ctx,
+                                   const unsigned char *buf, size_t len);
+
+int mbedtls_ecjpake_write_round_two(mbedtls_ecjpake_context *ctx,
+                                    unsigned char *buf, size_t len,
+                                    size_t *olen,
+                                    int (*f_rng)(void *, unsigned char *,
+                                                 size_t),
+                                    void *p_rng);
+
+int mbedtls_ecjpake_read_round_two(mbedtls_ecjpake_context *ctx,
+                                   const unsigned char *buf, size_t len);
+
+int mbedtls_ecjpake_derive_secret(mbedtls_ecjpake_context *ctx,
+                                  unsigned char *buf, size_t len,
+                                  size_t *olen,
+                                  int (*f_rng)(void *, unsigned char *,
+                                               size_t),
+                                  void *p_rng);
+
+#endif /* MBEDTLS_ECJPAKE_H */
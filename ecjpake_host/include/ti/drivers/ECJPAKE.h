@@ -0,0 +1,126 @@
+/*
+ * Host stand-in for the TI ECJPAKE driver, ecjpakecheck.c runs it on
+ * OpenSSL. Scalars and points are little endian, points X then Y.
+ */
+#ifndef ECJPAKE_H
+#define ECJPAKE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ti/drivers/cryptoutils/cryptokey/CryptoKey.h>
+
+#define ECJPAKE_STATUS_SUCCESS      0
+#define ECJPAKE_STATUS_ERROR        (-1)
+
+typedef struct
+{
+    size_t length;
+    const uint8_t *order;
+    const uint8_t *generatorX;
+    const uint8_t *generatorY;
+} ECCParams_CurveParams;
+
+extern const ECCParams_CurveParams ECCParams_NISTP256;
+
+typedef struct ECJPAKE_Config *ECJPAKE_Handle;
+
+typedef struct
+{
+    int returnBehavior;
+} ECJPAKE_Params;
+
+typedef struct
+{
+    const ECCParams_CurveParams *curve;
+    CryptoKey *myPrivateKey1;
+    CryptoKey *myPrivateKey2;
+    CryptoKey *myPublicKey1;
+    CryptoKey *myPublicKey2;
+    CryptoKey *myPrivateV1;
+    CryptoKey *myPrivateV2;
+    CryptoKey *myPublicV1;
+    CryptoKey *myPublicV2;
+} ECJPAKE_OperationRoundOneGenerateKeys;
+
+typedef struct
+{
+    const ECCParams_CurveParams *curve;
+    CryptoKey *myPrivateKey;
+    CryptoKey *myPrivateV;
+    const uint8_t *hash;
+    uint8_t *r;
+} ECJPAKE_OperationGenerateZKP;
+
+typedef struct
+{
+    const ECCParams_CurveParams *curve;
+    CryptoKey *theirGenerator;
+    CryptoKey *theirPublicKey;
+    CryptoKey *theirPublicV;
+    const uint8_t *hash;
+    const uint8_t *r;
+} ECJPAKE_OperationVerifyZKP;
+
+typedef struct
+{
+    const ECCParams_CurveParams *curve;
+    CryptoKey *myPrivateKey2;
+    CryptoKey *myPublicKey1;
+    CryptoKey *myPublicKey2;
+    CryptoKey *theirPublicKey1;
+    CryptoKey *theirPublicKey2;
+    CryptoKey *preSharedSecret;
+    CryptoKey *theirNewGenerator;
+    CryptoKey *myNewGenerator;
+    CryptoKey *myCombinedPrivateKey;
+    CryptoKey *myCombinedPublicKey;
+    CryptoKey *myPrivateV;
+    CryptoKey *myPublicV;
+} ECJPAKE_OperationRoundTwoGenerateKeys;
+
+typedef struct
+{
+    const ECCParams_CurveParams *curve;
+    CryptoKey *myCombinedPrivateKey;
+    CryptoKey *theirCombinedPublicKey;
+    CryptoKey *theirPublicKey2;
+    CryptoKey *myPrivateKey2;
+    CryptoKey *sharedSecret;
+} ECJPAKE_OperationComputeSharedSecret;
+
+void ECJPAKE_Params_init(ECJPAKE_Params *params);
+
+ECJPAKE_Handle ECJPAKE_open(uint_least8_t index, ECJPAKE_Params *params);
+
+void ECJPAKE_close(ECJPAKE_Handle handle);
+
+void ECJPAKE_OperationRoundOneGenerateKeys_init(
+    ECJPAKE_OperationRoundOneGenerateKeys *operation);
+
+void ECJPAKE_OperationGenerateZKP_init(ECJPAKE_OperationGenerateZKP *operation);
+
+void ECJPAKE_OperationVerifyZKP_init(ECJPAKE_OperationVerifyZKP *operation);
+
+void ECJPAKE_OperationRoundTwoGenerateKeys_init(
+    ECJPAKE_OperationRoundTwoGenerateKeys *operation);
+
+void ECJPAKE_OperationComputeSharedSecret_init(
+    ECJPAKE_OperationComputeSharedSecret *operation);
+
+int_fast16_t ECJPAKE_roundOneGenerateKeys(
+    ECJPAKE_Handle handle, ECJPAKE_OperationRoundOneGenerateKeys *operation);
+
+int_fast16_t ECJPAKE_generateZKP(ECJPAKE_Handle handle,
+                                 ECJPAKE_OperationGenerateZKP *operation);
+
+int_fast16_t ECJPAKE_verifyZKP(ECJPAKE_Handle handle,
+                               ECJPAKE_OperationVerifyZKP *operation);
+
+int_fast16_t ECJPAKE_roundTwoGenerateKeys(
+    ECJPAKE_Handle handle, ECJPAKE_OperationRoundTwoGenerateKeys *operation);
+
+int_fast16_t ECJPAKE_computeSharedSecret(
+    ECJPAKE_Handle handle, ECJPAKE_OperationComputeSharedSecret *operation);
+
+#endif /* ECJPAKE_H */
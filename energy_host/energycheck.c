@@ -0,0 +1,267 @@
+/******************************************************************************
+
+ @file  energycheck.c
+
+ @brief Host check of the energy accounting module
+
+ Runs platform/energy.c of an example application on Linux, on a simulated
+ clock and power driver. The idle loop calls the policy the module set,
+ which runs the board policy: it idles, or enters standby and wakes with the
+ notifications the power driver sends. A sleepy device is scripted on it,
+ waking to poll its parent and send a report, and the time and charge the
+ module counts in each state are checked against the script.
+
+   energycheck [cycles]
+
+ *****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ti/drivers/Power.h>
+#include <ti/drivers/power/PowerCC26X2.h>
+
+#include "platform.h"
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+#define CYCLES              100
+
+/* Currents of energy.c, the defaults */
+#define RX_NA               6900000U
+#define TX_NA               7100000U
+#define ACTIVE_NA           2900000U
+#define IDLE_NA             961000U
+#define STANDBY_NA          850U
+
+/* One cycle of the script, in us */
+#define WAKE_ACTIVE_US      1500U   // Wake up and run the stack
+#define POLL_RX_US          4000U   // Radio on for the data poll and reply
+#define POLL_FRAME_LEN      14U     // Data request, FCS included
+#define REPORT_ACTIVE_US    800U    // Build the report
+#define REPORT_RX_US        6000U   // Radio on to send it and get the ack
+#define REPORT_FRAME_LEN    67U
+#define IDLE_US             300U    // Idle between the two, radio off
+#define STANDBY_US          999000U // Until the next poll
+#define STANDBY_ENTRY_US    120U    // Idle in the policy before standby
+#define STANDBY_EXIT_US     80U     // And after waking
+
+#define AIRTIME_US(len)     (192U + 32U * (len))
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static uint64_t nowUs = 1000000U;
+
+static Power_PolicyFxn policy;
+static Power_NotifyObj *notifyObj;
+
+/* What the board policy does the next time it runs */
+static uint32_t sleepUs;
+static bool sleepStandby;
+
+static int failures;
+
+#define FAIL(...) do { fprintf(stderr, __VA_ARGS__); \
+                       fputc('\n', stderr); \
+                       failures++; } while (0)
+
+//*****************************************************************************
+// Simulated clock and power driver
+//*****************************************************************************
+
+uint64_t platformAlarmGetNowUs(void)
+{
+    return (nowUs);
+}
+
+int_fast16_t Power_registerNotify(Power_NotifyObj *pNotifyObj,
+                                  unsigned int eventTypes,
+                                  Power_NotifyFxn notifyFxn,
+                                  uintptr_t clientArg)
+{
+    pNotifyObj->eventTypes = eventTypes;
+    pNotifyObj->notifyFxn = notifyFxn;
+    pNotifyObj->clientArg = clientArg;
+    notifyObj = pNotifyObj;
+    return (0);
+}
+
+void Power_setPolicy(Power_PolicyFxn aPolicy)
+{
+    policy = aPolicy;
+}
+
+static void notify(unsigned int eventType)
+{
+    if (notifyObj != NULL && (notifyObj->eventTypes & eventType))
+    {
+        notifyObj->notifyFxn(eventType, 0, notifyObj->clientArg);
+    }
+}
+
+static void boardPolicy(void)
+{
+    if (sleepStandby)
+    {
+        nowUs += STANDBY_ENTRY_US;
+        notify(PowerCC26XX_ENTERING_STANDBY);
+        nowUs += sleepUs - STANDBY_ENTRY_US - STANDBY_EXIT_US;
+        notify(PowerCC26XX_AWAKE_STANDBY);
+        nowUs += STANDBY_EXIT_US;
+    }
+    else
+    {
+        nowUs += sleepUs;
+    }
+}
+
+const PowerCC26X2_Config PowerCC26X2_config = {
+    .policyFxn    = boardPolicy,
+    .enablePolicy = true,
+};
+
+/* The idle loop runs the power policy until the next interrupt */
+static void idle(uint32_t us, bool standby)
+{
+    sleepUs = us;
+    sleepStandby = standby;
+    if (policy != NULL)
+    {
+        policy();
+    }
+    else
+    {
+        boardPolicy();
+    }
+}
+
+//*****************************************************************************
+// Script
+//*****************************************************************************
+
+/* The radio is on for rxUs and sends a frame, the MCU idles meanwhile */
+static void radio(uint32_t rxUs, uint16_t frameLen)
+{
+    platformEnergyRadioOn(true);
+    nowUs += 200U;
+    idle(rxUs - 400U, false);
+    platformEnergyRadioTx(frameLen);
+    nowUs += 200U;
+    platformEnergyRadioOn(false);
+}
+
+static void cycle(void)
+{
+    nowUs += WAKE_ACTIVE_US;
+    radio(POLL_RX_US, POLL_FRAME_LEN);
+    nowUs += REPORT_ACTIVE_US;
+    idle(IDLE_US, false);
+    radio(REPORT_RX_US, REPORT_FRAME_LEN);
+    idle(STANDBY_US, true);
+}
+
+static void expect(const char *what, uint64_t got, uint64_t want)
+{
+    if (got != want)
+    {
+        FAIL("%s: %llu, expected %llu", what, (unsigned long long)got,
+             (unsigned long long)want);
+    }
+}
+
+static void check(int cycles)
+{
+    static const char *names[PlatformEnergy_stateCount] = {
+        "rx", "tx", "active", "idle", "standby"
+    };
+    uint64_t want[PlatformEnergy_stateCount];
+    uint64_t chargePc = 0;
+    uint64_t totalMs = 0;
+    PlatformEnergy_Stats stats;
+    int i;
+
+    platformEnergyGetStats(&stats);
+
+    want[PlatformEnergy_tx] = (uint64_t)cycles *
+        (AIRTIME_US(POLL_FRAME_LEN) + AIRTIME_US(REPORT_FRAME_LEN));
+    want[PlatformEnergy_rx] = (uint64_t)cycles *
+        (POLL_RX_US + REPORT_RX_US) - want[PlatformEnergy_tx];
+    want[PlatformEnergy_active] = (uint64_t)cycles *
+        (WAKE_ACTIVE_US + REPORT_ACTIVE_US);
+    want[PlatformEnergy_idle] = (uint64_t)cycles *
+        (IDLE_US + STANDBY_ENTRY_US + STANDBY_EXIT_US);
+    want[PlatformEnergy_standby] = (uint64_t)cycles *
+        (STANDBY_US - STANDBY_ENTRY_US - STANDBY_EXIT_US);
+
+    for (i = 0; i < PlatformEnergy_stateCount; i++)
+    {
+        expect(names[i], stats.ms[i], want[i] / 1000U);
+    }
+
+    chargePc = (want[0] / 1000U) * RX_NA + (want[1] / 1000U) * TX_NA +
+               (want[2] / 1000U) * ACTIVE_NA + (want[3] / 1000U) * IDLE_NA +
+               (want[4] / 1000U) * STANDBY_NA;
+    for (i = 0; i < PlatformEnergy_stateCount; i++)
+    {
+        totalMs += want[i] / 1000U;
+    }
+    expect("charge uC", stats.chargeUc, chargePc / 1000000U);
+    expect("average nA", stats.averageNa, chargePc / totalMs);
+    expect("tx frames", stats.txFrames, 2U * cycles);
+    expect("radio starts", stats.radioStarts, 2U * cycles);
+
+    printf("%d cycles of %u ms:\n", cycles,
+           (unsigned)((WAKE_ACTIVE_US + POLL_RX_US + REPORT_ACTIVE_US +
+                       IDLE_US + REPORT_RX_US + STANDBY_US) / 1000U));
+    for (i = 0; i < PlatformEnergy_stateCount; i++)
+    {
+        printf("  %-8s %8lu ms\n", names[i], (unsigned long)stats.ms[i]);
+    }
+    printf("  charge   %8lu uC\n  average  %8lu nA\n",
+           (unsigned long)stats.chargeUc, (unsigned long)stats.averageNa);
+}
+
+int main(int argc, char **argv)
+{
+    int cycles = (argc > 1) ? atoi(argv[1]) : CYCLES;
+    PlatformEnergy_Stats stats;
+    int n;
+
+    /* Time before the module starts is not counted */
+    idle(5000U, true);
+    platformEnergyInit();
+    if (policy == NULL || notifyObj == NULL)
+    {
+        FAIL("policy or standby notification not registered");
+    }
+
+    for (n = 0; n < cycles; n++)
+    {
+        cycle();
+    }
+    check(cycles);
+
+    /* Cleared counters start again from zero */
+    platformEnergyClear();
+    platformEnergyGetStats(&stats);
+    for (n = 0; n < PlatformEnergy_stateCount; n++)
+    {
+        expect("cleared", stats.ms[n], 0);
+    }
+    expect("cleared tx frames", stats.txFrames, 0);
+    for (n = 0; n < cycles; n++)
+    {
+        cycle();
+    }
+    check(cycles);
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return (failures ? 1 : 0);
+}
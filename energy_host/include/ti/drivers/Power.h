@@ -0,0 +1,32 @@
+/*
+ * Host stand-in for the TI Power driver, energycheck.c implements the
+ * calls the energy module makes.
+ */
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+#define Power_NOTIFYDONE    0
+
+typedef void (*Power_PolicyFxn)(void);
+
+typedef int_fast16_t (*Power_NotifyFxn)(unsigned int eventType,
+                                        uintptr_t eventArg,
+                                        uintptr_t clientArg);
+
+typedef struct
+{
+    unsigned int eventTypes;
+    Power_NotifyFxn notifyFxn;
+    uintptr_t clientArg;
+} Power_NotifyObj;
+
+int_fast16_t Power_registerNotify(Power_NotifyObj *pNotifyObj,
+                                  unsigned int eventTypes,
+                                  Power_NotifyFxn notifyFxn,
+                                  uintptr_t clientArg);
+
+void Power_setPolicy(Power_PolicyFxn policy);
+
+#endif /* POWER_H */
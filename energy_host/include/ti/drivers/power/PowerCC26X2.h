@@ -0,0 +1,23 @@
+/*
+ * Host stand-in for the CC26X2 Power driver configuration and its standby
+ * notifications.
+ */
+#ifndef POWERCC26X2_H
+#define POWERCC26X2_H
+
+#include <stdbool.h>
+
+#include <ti/drivers/Power.h>
+
+#define PowerCC26XX_ENTERING_STANDBY    0x1
+#define PowerCC26XX_AWAKE_STANDBY       0x4
+
+typedef struct
+{
+    Power_PolicyFxn policyFxn;
+    bool enablePolicy;
+} PowerCC26X2_Config;
+
+extern const PowerCC26X2_Config PowerCC26X2_config;
+
+#endif /* POWERCC26X2_H */
@@ -0,0 +1,21 @@
+/*
+ * Host stand-in for the OpenThread core configuration of the examples,
+ * the options the applications test. The platform modules need nothing
+ * from it.
+ */
+#ifndef OPENTHREAD_CORE_CONFIG_H
+#define OPENTHREAD_CORE_CONFIG_H
+
+#define OPENTHREAD_ENABLE_APPLICATION_COAP              1
+#define OPENTHREAD_ENABLE_DIAG                          0
+#define OPENTHREAD_CONFIG_ENABLE_PLATFORM_USEC_TIMER    0
+
+#define OPENTHREAD_CONFIG_LOG_OUTPUT_NONE               0
+#define OPENTHREAD_CONFIG_LOG_OUTPUT_APP                2
+#define OPENTHREAD_CONFIG_LOG_OUTPUT    OPENTHREAD_CONFIG_LOG_OUTPUT_APP
+
+#define PACKAGE_NAME                    "OPENTHREAD"
+#define PACKAGE_VERSION                 "sim"
+#define OPENTHREAD_CONFIG_PLATFORM_INFO "SIM"
+
+#endif /* OPENTHREAD_CORE_CONFIG_H */
@@ -0,0 +1,11 @@
+/*
+ * Host stand-in for the OpenThread build configuration.
+ */
+#ifndef OPENTHREAD_CONFIG_H
+#define OPENTHREAD_CONFIG_H
+
+#ifndef OPENTHREAD_PROJECT_CORE_CONFIG_FILE
+#define OPENTHREAD_PROJECT_CORE_CONFIG_FILE "openthread-core-config.h"
+#endif
+
+#endif /* OPENTHREAD_CONFIG_H */
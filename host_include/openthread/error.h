@@ -0,0 +1,27 @@
+/*
+ * Host stand-in for the OpenThread error codes, values as in OpenThread.
+ */
+#ifndef OPENTHREAD_ERROR_H
+#define OPENTHREAD_ERROR_H
+
+typedef enum
+{
+    OT_ERROR_NONE             = 0,
+    OT_ERROR_FAILED           = 1,
+    OT_ERROR_DROP             = 2,
+    OT_ERROR_NO_BUFS          = 3,
+    OT_ERROR_NO_ROUTE         = 4,
+    OT_ERROR_BUSY             = 5,
+    OT_ERROR_PARSE            = 6,
+    OT_ERROR_INVALID_ARGS     = 7,
+    OT_ERROR_SECURITY         = 8,
+    OT_ERROR_NO_ADDRESS       = 10,
+    OT_ERROR_ABORT            = 11,
+    OT_ERROR_NOT_IMPLEMENTED  = 12,
+    OT_ERROR_INVALID_STATE    = 13,
+    OT_ERROR_NOT_FOUND        = 23,
+    OT_ERROR_ALREADY          = 24,
+    OT_ERROR_RESPONSE_TIMEOUT = 28,
+} otError;
+
+#endif /* OPENTHREAD_ERROR_H */
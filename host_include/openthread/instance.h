@@ -0,0 +1,29 @@
+/*
+ * Host stand-in for the OpenThread instance API. sim_host implements it in
+ * simot.c, the other harnesses only need the types.
+ */
+#ifndef OPENTHREAD_INSTANCE_H
+#define OPENTHREAD_INSTANCE_H
+
+#include <openthread/types.h>
+
+#define OT_CHANGED_IP6_ADDRESS_ADDED    (1U << 0)
+#define OT_CHANGED_IP6_ADDRESS_REMOVED  (1U << 1)
+#define OT_CHANGED_THREAD_ROLE          (1U << 2)
+#define OT_CHANGED_THREAD_LL_ADDR       (1U << 3)
+#define OT_CHANGED_THREAD_ML_ADDR       (1U << 4)
+#define OT_CHANGED_THREAD_RLOC_ADDED    (1U << 5)
+#define OT_CHANGED_THREAD_RLOC_REMOVED  (1U << 6)
+#define OT_CHANGED_THREAD_PARTITION_ID  (1U << 7)
+#define OT_CHANGED_THREAD_KEY_SEQUENCE_COUNTER (1U << 8)
+#define OT_CHANGED_THREAD_NETDATA       (1U << 9)
+
+typedef void (*otStateChangedCallback)(uint32_t aFlags, void *aContext);
+
+otInstance *otInstanceInitSingle(void);
+void otInstanceFactoryReset(otInstance *aInstance);
+otError otSetStateChangedCallback(otInstance *aInstance,
+                                  otStateChangedCallback aCallback,
+                                  void *aContext);
+
+#endif /* OPENTHREAD_INSTANCE_H */
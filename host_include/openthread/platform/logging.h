@@ -0,0 +1,21 @@
+/*
+ * Host stand-in for the OpenThread logging platform API.
+ */
+#ifndef OPENTHREAD_PLATFORM_LOGGING_H
+#define OPENTHREAD_PLATFORM_LOGGING_H
+
+#include <stdarg.h>
+#include <stdint.h>
+
+typedef uint8_t otLogLevel;
+
+typedef enum
+{
+    OT_LOG_REGION_API = 1,
+    OT_LOG_REGION_PLATFORM = 16,
+} otLogRegion;
+
+void otPlatLog(otLogLevel aLogLevel, otLogRegion aLogRegion,
+               const char *aFormat, ...);
+
+#endif /* OPENTHREAD_PLATFORM_LOGGING_H */
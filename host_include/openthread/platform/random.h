@@ -0,0 +1,18 @@
+/*
+ * Host stand-in for the OpenThread random number platform API.
+ */
+#ifndef OPENTHREAD_PLATFORM_RANDOM_H
+#define OPENTHREAD_PLATFORM_RANDOM_H
+
+#include <stdint.h>
+
+#include <openthread/error.h>
+
+uint32_t otPlatRandomGet(void);
+
+otError otPlatRandomSecureGet(uint16_t aInputLength, uint8_t *aOutput,
+                              uint16_t *aOutputLength);
+
+otError otPlatRandomGetTrue(uint8_t *aOutput, uint16_t aOutputLength);
+
+#endif /* OPENTHREAD_PLATFORM_RANDOM_H */
@@ -0,0 +1,25 @@
+/*
+ * Host stand-in for the OpenThread settings platform API. nvoctp_host builds
+ * the implementation in settings.c, sim_host keeps no settings.
+ */
+#ifndef OPENTHREAD_PLATFORM_SETTINGS_H
+#define OPENTHREAD_PLATFORM_SETTINGS_H
+
+#include <stdint.h>
+
+#include <openthread/types.h>
+
+void otPlatSettingsInit(otInstance *aInstance);
+otError otPlatSettingsBeginChange(otInstance *aInstance);
+otError otPlatSettingsCommitChange(otInstance *aInstance);
+otError otPlatSettingsAbandonChange(otInstance *aInstance);
+otError otPlatSettingsGet(otInstance *aInstance, uint16_t aKey, int aIndex,
+                          uint8_t *aValue, uint16_t *aValueLength);
+otError otPlatSettingsSet(otInstance *aInstance, uint16_t aKey,
+                          const uint8_t *aValue, uint16_t aValueLength);
+otError otPlatSettingsAdd(otInstance *aInstance, uint16_t aKey,
+                          const uint8_t *aValue, uint16_t aValueLength);
+otError otPlatSettingsDelete(otInstance *aInstance, uint16_t aKey, int aIndex);
+void otPlatSettingsWipe(otInstance *aInstance);
+
+#endif /* OPENTHREAD_PLATFORM_SETTINGS_H */
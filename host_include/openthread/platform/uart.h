@@ -0,0 +1,18 @@
+/*
+ * Host stand-in for the OpenThread uart platform API. The platform uart.c
+ * implements the first half, the applications the callbacks.
+ */
+#ifndef OPENTHREAD_PLATFORM_UART_H
+#define OPENTHREAD_PLATFORM_UART_H
+
+#include <stdint.h>
+
+#include <openthread/instance.h>
+
+otError otPlatUartEnable(void);
+otError otPlatUartDisable(void);
+otError otPlatUartSend(const uint8_t *aBuf, uint16_t aBufLength);
+void otPlatUartSendDone(void);
+void otPlatUartReceived(const uint8_t *aBuf, uint16_t aBufLength);
+
+#endif /* OPENTHREAD_PLATFORM_UART_H */
@@ -0,0 +1,89 @@
+/*
+ * Host stand-in for the OpenThread types the applications use. The
+ * layouts of the public structures follow OpenThread, the opaque ones are
+ * defined in simot.c.
+ */
+#ifndef OPENTHREAD_TYPES_H
+#define OPENTHREAD_TYPES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <openthread/error.h>
+
+typedef struct otInstance otInstance;
+typedef struct otMessage otMessage;
+
+typedef uint16_t otPanId;
+
+#define OT_EXT_ADDRESS_SIZE     8
+#define OT_EXT_PAN_ID_SIZE      8
+#define OT_IP6_ADDRESS_SIZE     16
+
+typedef struct otExtAddress
+{
+    uint8_t m8[OT_EXT_ADDRESS_SIZE];
+} otExtAddress;
+
+typedef struct otExtendedPanId
+{
+    uint8_t m8[OT_EXT_PAN_ID_SIZE];
+} otExtendedPanId;
+
+typedef struct otIp6Address
+{
+    union
+    {
+        uint8_t  m8[OT_IP6_ADDRESS_SIZE];
+        uint16_t m16[OT_IP6_ADDRESS_SIZE / sizeof(uint16_t)];
+        uint32_t m32[OT_IP6_ADDRESS_SIZE / sizeof(uint32_t)];
+    } mFields;
+} otIp6Address;
+
+typedef struct otNetifAddress
+{
+    otIp6Address           mAddress;
+    uint8_t                mPrefixLength;
+    bool                   mPreferred : 1;
+    bool                   mValid : 1;
+    bool                   mScopeOverrideValid : 1;
+    unsigned int           mScopeOverride : 4;
+    bool                   mRloc : 1;
+    struct otNetifAddress *mNext;
+} otNetifAddress;
+
+typedef enum
+{
+    OT_NETIF_INTERFACE_ID_HOST   = -1,
+    OT_NETIF_INTERFACE_ID_THREAD = 1,
+} otNetifInterfaceId;
+
+typedef struct otMessageInfo
+{
+    otIp6Address mSockAddr;
+    otIp6Address mPeerAddr;
+    uint16_t     mSockPort;
+    uint16_t     mPeerPort;
+    int8_t       mInterfaceId;
+    uint8_t      mHopLimit;
+    const void  *mLinkInfo;
+} otMessageInfo;
+
+typedef struct otLinkModeConfig
+{
+    bool mRxOnWhenIdle : 1;
+    bool mSecureDataRequests : 1;
+    bool mDeviceType : 1;
+    bool mNetworkData : 1;
+} otLinkModeConfig;
+
+typedef enum
+{
+    OT_DEVICE_ROLE_DISABLED = 0,
+    OT_DEVICE_ROLE_DETACHED = 1,
+    OT_DEVICE_ROLE_CHILD    = 2,
+    OT_DEVICE_ROLE_ROUTER   = 3,
+    OT_DEVICE_ROLE_LEADER   = 4,
+} otDeviceRole;
+
+#endif /* OPENTHREAD_TYPES_H */
@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for the TI device family selection, driverlib headers come
+ * from the include directory of the harness.
+ */
+#ifndef DEVICEFAMILY_H
+#define DEVICEFAMILY_H
+
+#define DeviceFamily_constructPath(x) <ti/devices/cc13x2_cc26x2_v1/x>
+
+#endif /* DEVICEFAMILY_H */
@@ -0,0 +1,24 @@
+/*
+ * Host stand-in for the TI crypto key, plaintext keys only.
+ */
+#ifndef CRYPTOKEY_H
+#define CRYPTOKEY_H
+
+#include <stdint.h>
+
+typedef struct
+{
+    uint8_t  *keyMaterial;
+    uint16_t keyLength;
+} CryptoKey_Plaintext;
+
+typedef struct
+{
+    uint8_t encoding;
+    union
+    {
+        CryptoKey_Plaintext plaintext;
+    } u;
+} CryptoKey;
+
+#endif /* CRYPTOKEY_H */
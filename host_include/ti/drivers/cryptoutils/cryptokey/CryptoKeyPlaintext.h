@@ -0,0 +1,35 @@
+/*
+ * Host stand-in for the TI plaintext crypto key calls.
+ */
+#ifndef CRYPTOKEYPLAINTEXT_H
+#define CRYPTOKEYPLAINTEXT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ti/drivers/cryptoutils/cryptokey/CryptoKey.h>
+
+#define CryptoKey_PLAINTEXT         0x02
+#define CryptoKey_BLANK_PLAINTEXT   0x04
+
+static inline int_fast16_t CryptoKeyPlaintext_initKey(CryptoKey *keyHandle,
+                                                      uint8_t *key,
+                                                      size_t keyLength)
+{
+    keyHandle->encoding = CryptoKey_PLAINTEXT;
+    keyHandle->u.plaintext.keyMaterial = key;
+    keyHandle->u.plaintext.keyLength = keyLength;
+    return (0);
+}
+
+static inline int_fast16_t CryptoKeyPlaintext_initBlankKey(CryptoKey *keyHandle,
+                                                           uint8_t *keyLocation,
+                                                           size_t keyLength)
+{
+    keyHandle->encoding = CryptoKey_BLANK_PLAINTEXT;
+    keyHandle->u.plaintext.keyMaterial = keyLocation;
+    keyHandle->u.plaintext.keyLength = keyLength;
+    return (0);
+}
+
+#endif /* CRYPTOKEYPLAINTEXT_H */
@@ -0,0 +1,40 @@
+/*
+ * Host stand-in for the TI driver porting layer interrupt lock.
+ *
+ * By default simulated interrupts are only taken between steps of the
+ * simulation, so the lock does nothing. Harnesses whose callers run as
+ * threads build with HWIP_HOST_THREADS set to 1 and define HwiP_lock,
+ * masking interrupts is then a mutex.
+ */
+#ifndef HWIP_H
+#define HWIP_H
+
+#include <stdint.h>
+
+#ifndef HWIP_HOST_THREADS
+#define HWIP_HOST_THREADS 0
+#endif
+
+#if HWIP_HOST_THREADS
+#include <pthread.h>
+
+extern pthread_mutex_t HwiP_lock;
+#endif
+
+static inline uintptr_t HwiP_disable(void)
+{
+#if HWIP_HOST_THREADS
+    pthread_mutex_lock(&HwiP_lock);
+#endif
+    return (0);
+}
+
+static inline void HwiP_restore(uintptr_t key)
+{
+    (void)key;
+#if HWIP_HOST_THREADS
+    pthread_mutex_unlock(&HwiP_lock);
+#endif
+}
+
+#endif /* HWIP_H */
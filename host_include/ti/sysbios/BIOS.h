@@ -0,0 +1,23 @@
+/*
+ * Host stand-in for the TI-RTOS BIOS module, the types and constants the
+ * applications use.
+ */
+#ifndef BIOS_H
+#define BIOS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef FALSE
+#define FALSE   0
+#define TRUE    1
+#endif
+
+typedef unsigned int UInt;
+typedef uintptr_t    UArg;
+typedef bool         Bool;
+
+#define BIOS_WAIT_FOREVER   (~(UInt)0)
+#define BIOS_NO_WAIT        ((UInt)0)
+
+#endif /* BIOS_H */
@@ -0,0 +1,15 @@
+/*
+ * Host stand-in for the OpenThread example code utilities.
+ */
+#ifndef CODE_UTILS_H
+#define CODE_UTILS_H
+
+#include <stddef.h>
+
+#define otEXPECT(aCondition) \
+    do { if (!(aCondition)) { goto exit; } } while (0)
+
+#define otEXPECT_ACTION(aCondition, aAction) \
+    do { if (!(aCondition)) { aAction; goto exit; } } while (0)
+
+#endif /* CODE_UTILS_H */
@@ -64,6 +64,8 @@
 #include <ti/display/DisplayExt.h>
 #include <ti/grlib/grlib.h>
 
+#include "dlog.h"
+
 
 /******************************************************************************
  Local variables
@@ -88,7 +90,10 @@ void DispUtils_open(void)
 #if BOARD_DISPLAY_USE_LCD
     lcdHandle = Display_open(Display_Type_LCD, &params);
 #endif /* BOARD_DISPLAY_USE_LCD */
+#if !DLOG_ENABLE
+    /* The deferred log owns the UART otherwise */
     serialHandle = Display_open(Display_Type_UART, &params);
+#endif
 }
 
 #if BOARD_DISPLAY_USE_LCD
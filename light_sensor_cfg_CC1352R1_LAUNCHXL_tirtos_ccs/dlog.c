@@ -0,0 +1,569 @@
+/******************************************************************************
+
+ @file dlog.c
+
+ @brief Deferred binary logging
+
+ PR Sensor Networks, TU Berlin
+
+ *****************************************************************************/
+
+/*
+ * Callers only copy the format address and the raw arguments into a RAM
+ * ring, interrupts are masked for the copy of the finished record alone.
+ * Formatting and the UART are left to a task at the lowest priority, and
+ * to the host: dlog_host/dlogdecode.py looks the formats up in the
+ * firmware image.
+ *
+ * Each record is, little endian:
+ *
+ *   len     u8   bytes that follow
+ *   level   u8   OpenThread level, DLOG_TRUNCATED if arguments were left out
+ *   region  u8   OpenThread region or DLOG_REGION_APP
+ *   format  u32  address of the format, 0 for a count of dropped records
+ *   time    u32  microseconds since boot
+ *   args         in format order: integers as base 128 varints, zigzag
+ *                encoded when signed, floating point double, strings a u8
+ *                length and the characters
+ *
+ * On the UART each record is HDLC escaped and followed by a 0x7E flag.
+ */
+
+/******************************************************************************
+ Includes
+ *****************************************************************************/
+#include "dlog.h"
+
+#if DLOG_ENABLE
+
+/* Standard Library Header files */
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+/* POSIX Header files */
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+
+/* TIRTOS specific header files */
+#include <ti/drivers/UART.h>
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/sysbios/knl/Clock.h>
+
+/* Board Header files */
+#include "Board.h"
+
+/* Private configuration Header files */
+#include "task_config.h"
+
+/******************************************************************************
+ Constants and definitions
+ *****************************************************************************/
+
+#if (DLOG_RINGSIZE & (DLOG_RINGSIZE - 1))
+#error "DLOG_RINGSIZE must be a power of 2"
+#endif
+
+#if (DLOG_MAXRECORD > 256)
+#error "DLOG_MAXRECORD is at most 256, the length is a byte"
+#endif
+
+/* record header length */
+#define DLOG_HEADER_LEN     11
+
+/* longest varint of a 32 and a 64 bit integer */
+#define DLOG_VARINT_MAX     5
+#define DLOG_VARINT64_MAX   10
+
+/* level flag for a record with arguments left out */
+#define DLOG_TRUNCATED      0x80
+
+/* HDLC flag and escape */
+#define DLOG_FLAG           0x7E
+#define DLOG_ESCAPE         0x7D
+#define DLOG_ESCAPE_XOR     0x20
+
+/* UART writes hold a few records, each may double when escaped */
+#define DLOG_TXBUFSIZE      (4 * DLOG_MAXRECORD)
+
+/******************************************************************************
+ Local variables
+ *****************************************************************************/
+
+/* record ring, indexes run free and wrap with the ring */
+static uint8_t sRing[DLOG_RINGSIZE];
+static uint32_t sRingHead;
+static uint32_t sRingTail;
+
+/* records dropped for a full ring, since the last count was logged */
+static uint32_t sDropped;
+
+/* posted when a record goes into an empty ring */
+static sem_t sDLogSem;
+static bool sDLogReady;
+
+static uint8_t sTxBuf[DLOG_TXBUFSIZE];
+
+static char sDLogStack[TASK_CONFIG_DLOG_TASK_STACK_SIZE];
+
+/******************************************************************************
+ Local Functions
+ *****************************************************************************/
+
+static uint8_t *put32(uint8_t *aBuf, uint32_t aValue)
+{
+    aBuf[0] = (uint8_t)aValue;
+    aBuf[1] = (uint8_t)(aValue >> 8);
+    aBuf[2] = (uint8_t)(aValue >> 16);
+    aBuf[3] = (uint8_t)(aValue >> 24);
+    return (aBuf + 4);
+}
+
+static uint8_t *put64(uint8_t *aBuf, uint64_t aValue)
+{
+    put32(aBuf, (uint32_t)aValue);
+    return (put32(aBuf + 4, (uint32_t)(aValue >> 32)));
+}
+
+/* Small values, the common case, take a byte */
+static uint8_t *putVarint(uint8_t *aBuf, uint32_t aValue)
+{
+    while (aValue >= 0x80)
+    {
+        *aBuf++ = (uint8_t)aValue | 0x80;
+        aValue >>= 7;
+    }
+    *aBuf++ = (uint8_t)aValue;
+    return (aBuf);
+}
+
+static uint8_t *putVarint64(uint8_t *aBuf, uint64_t aValue)
+{
+    while (aValue >= 0x80)
+    {
+        *aBuf++ = (uint8_t)aValue | 0x80;
+        aValue >>= 7;
+    }
+    *aBuf++ = (uint8_t)aValue;
+    return (aBuf);
+}
+
+/* Zigzag, so small negative values stay small */
+static uint32_t zigzag(int32_t aValue)
+{
+    return (((uint32_t)aValue << 1) ^ (uint32_t)(aValue >> 31));
+}
+
+static uint64_t zigzag64(int64_t aValue)
+{
+    return (((uint64_t)aValue << 1) ^ (uint64_t)(aValue >> 63));
+}
+
+static void putHeader(uint8_t *aRecord, uint8_t aLevel, uint8_t aRegion,
+                      const char *aFormat, uint32_t aTime)
+{
+    aRecord[1] = aLevel;
+    aRecord[2] = aRegion;
+    put32(&aRecord[3], (uint32_t)(uintptr_t)aFormat);
+    put32(&aRecord[7], aTime);
+}
+
+static uint32_t timeNow(void)
+{
+    return (Clock_getTicks() * Clock_tickPeriod);
+}
+
+/* Copies into the ring at its head, the caller has checked for room */
+static void ringPut(const uint8_t *aData, size_t aLen)
+{
+    size_t offset = sRingHead & (DLOG_RINGSIZE - 1);
+    size_t first  = DLOG_RINGSIZE - offset;
+
+    if (first > aLen)
+    {
+        first = aLen;
+    }
+    memcpy(&sRing[offset], aData, first);
+    memcpy(sRing, aData + first, aLen - first);
+    sRingHead += aLen;
+}
+
+/* Queues a finished record, or counts it as dropped */
+static void ringWrite(const uint8_t *aRecord, size_t aLen, uint32_t aTime)
+{
+    uint8_t dropRecord[DLOG_HEADER_LEN + 4];
+    uintptr_t key;
+    uint32_t used;
+    size_t need = aLen;
+    bool wake = false;
+
+    key  = HwiP_disable();
+    used = sRingHead - sRingTail;
+
+    /* A count of the records dropped goes in first, in order */
+    if (sDropped > 0)
+    {
+        need += sizeof(dropRecord);
+    }
+
+    if (DLOG_RINGSIZE - used >= need)
+    {
+        if (sDropped > 0)
+        {
+            dropRecord[0] = sizeof(dropRecord) - 1;
+            putHeader(dropRecord, 0, DLOG_REGION_APP, NULL, aTime);
+            put32(&dropRecord[DLOG_HEADER_LEN], sDropped);
+            ringPut(dropRecord, sizeof(dropRecord));
+            sDropped = 0;
+        }
+        ringPut(aRecord, aLen);
+        wake = (used == 0);
+    }
+    else
+    {
+        sDropped++;
+    }
+
+    HwiP_restore(key);
+
+    if (wake && sDLogReady)
+    {
+        sem_post(&sDLogSem);
+    }
+}
+
+/* Takes the oldest record out of the ring, returns its length or 0 */
+static size_t ringRead(uint8_t *aRecord)
+{
+    uintptr_t key;
+    size_t offset;
+    size_t first;
+    size_t len = 0;
+
+    key = HwiP_disable();
+
+    if (sRingHead != sRingTail)
+    {
+        offset = sRingTail & (DLOG_RINGSIZE - 1);
+        len    = sRing[offset] + 1;
+        first  = DLOG_RINGSIZE - offset;
+        if (first > len)
+        {
+            first = len;
+        }
+        memcpy(aRecord, &sRing[offset], first);
+        memcpy(aRecord + first, sRing, len - first);
+        sRingTail += len;
+    }
+
+    HwiP_restore(key);
+
+    return (len);
+}
+
+/* Fills the transmit buffer with escaped records, returns its length */
+static size_t txFill(void)
+{
+    uint8_t record[DLOG_MAXRECORD];
+    size_t txLen = 0;
+    size_t len;
+    size_t i;
+
+    while (txLen + (2 * DLOG_MAXRECORD) + 1 <= sizeof(sTxBuf))
+    {
+        len = ringRead(record);
+        if (len == 0)
+        {
+            break;
+        }
+
+        for (i = 0; i < len; i++)
+        {
+            if (record[i] == DLOG_FLAG || record[i] == DLOG_ESCAPE)
+            {
+                sTxBuf[txLen++] = DLOG_ESCAPE;
+                sTxBuf[txLen++] = record[i] ^ DLOG_ESCAPE_XOR;
+            }
+            else
+            {
+                sTxBuf[txLen++] = record[i];
+            }
+        }
+        sTxBuf[txLen++] = DLOG_FLAG;
+    }
+
+    return (txLen);
+}
+
+/* Sends the records on the UART, below every other task */
+static void *DLog_task(void *arg0)
+{
+    UART_Handle uart;
+    UART_Params params;
+    size_t len;
+
+    (void)arg0;
+
+    UART_init();
+    UART_Params_init(&params);
+    params.baudRate      = DLOG_BAUD_RATE;
+    params.writeDataMode = UART_DATA_BINARY;
+    params.readDataMode  = UART_DATA_BINARY;
+    params.readEcho      = UART_ECHO_OFF;
+    uart = UART_open(Board_UART0, &params);
+    assert(uart != NULL);
+
+    /* The decoder syncs on the first flag */
+    sTxBuf[0] = DLOG_FLAG;
+    UART_write(uart, sTxBuf, 1);
+
+    while (1)
+    {
+        while ((len = txFill()) > 0)
+        {
+            UART_write(uart, sTxBuf, len);
+        }
+
+        sem_wait(&sDLogSem);
+    }
+}
+
+/******************************************************************************
+ External Functions
+ *****************************************************************************/
+
+/* Documented in dlog.h */
+void DLog_vprintf(uint8_t aLevel, uint8_t aRegion, const char *aFormat,
+                  va_list aArgs)
+{
+    uint8_t record[DLOG_MAXRECORD];
+    uint8_t *pos = &record[DLOG_HEADER_LEN];
+    uint8_t *end = &record[DLOG_MAXRECORD];
+    const char *fmt = aFormat;
+    uint32_t time = timeNow();
+    uint8_t level = aLevel;
+    unsigned longs;
+    bool isLongDouble;
+    const char *str;
+    size_t strLen;
+
+    while (*fmt != '\0')
+    {
+        if (*fmt++ != '%')
+        {
+            continue;
+        }
+
+        /* flags, width and precision */
+        while (*fmt == '-' || *fmt == '+' || *fmt == ' ' || *fmt == '#' ||
+               *fmt == '0')
+        {
+            fmt++;
+        }
+        while ((*fmt >= '0' && *fmt <= '9') || *fmt == '.' || *fmt == '*')
+        {
+            if (*fmt++ == '*')
+            {
+                if (end - pos < DLOG_VARINT_MAX)
+                {
+                    goto truncated;
+                }
+                pos = putVarint(pos, zigzag(va_arg(aArgs, int)));
+            }
+        }
+
+        /* length, %ll and %j are the 64 bit ones */
+        longs = 0;
+        isLongDouble = false;
+        while (*fmt == 'h' || *fmt == 'l' || *fmt == 'j' || *fmt == 'z' ||
+               *fmt == 't' || *fmt == 'L')
+        {
+            if (*fmt == 'l')
+            {
+                longs++;
+            }
+            else if (*fmt == 'j')
+            {
+                longs = 2;
+            }
+            else if (*fmt == 'z' || *fmt == 't')
+            {
+                longs = (sizeof(size_t) > sizeof(int)) ? 1 : 0;
+            }
+            else if (*fmt == 'L')
+            {
+                isLongDouble = true;
+            }
+            fmt++;
+        }
+
+        switch (*fmt++)
+        {
+        case '%':
+            break;
+
+        case 'd':
+        case 'i':
+            if (longs >= 2)
+            {
+                if (end - pos < DLOG_VARINT64_MAX)
+                {
+                    goto truncated;
+                }
+                pos = putVarint64(pos, zigzag64(va_arg(aArgs, long long)));
+            }
+            else
+            {
+                if (end - pos < DLOG_VARINT_MAX)
+                {
+                    goto truncated;
+                }
+                pos = putVarint(pos, zigzag((longs == 1) ?
+                                            (int32_t)va_arg(aArgs, long) :
+                                            (int32_t)va_arg(aArgs, int)));
+            }
+            break;
+
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+        case 'c':
+            if (longs >= 2)
+            {
+                if (end - pos < DLOG_VARINT64_MAX)
+                {
+                    goto truncated;
+                }
+                pos = putVarint64(pos, va_arg(aArgs, unsigned long long));
+            }
+            else
+            {
+                if (end - pos < DLOG_VARINT_MAX)
+                {
+                    goto truncated;
+                }
+                pos = putVarint(pos, (longs == 1) ?
+                                     (uint32_t)va_arg(aArgs, unsigned long) :
+                                     (uint32_t)va_arg(aArgs, unsigned int));
+            }
+            break;
+
+        case 'p':
+            if (end - pos < DLOG_VARINT_MAX)
+            {
+                goto truncated;
+            }
+            pos = putVarint(pos, (uint32_t)(uintptr_t)va_arg(aArgs, void *));
+            break;
+
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+        {
+            union
+            {
+                double   d;
+                uint64_t u;
+            } value;
+
+            if (end - pos < 8)
+            {
+                goto truncated;
+            }
+            value.d = isLongDouble ? (double)va_arg(aArgs, long double) :
+                                     va_arg(aArgs, double);
+            pos = put64(pos, value.u);
+            break;
+        }
+
+        case 's':
+            str = va_arg(aArgs, const char *);
+            if (str == NULL)
+            {
+                str = "(null)";
+            }
+            for (strLen = 0; strLen < DLOG_MAXSTRING && str[strLen] != '\0';
+                 strLen++)
+            {
+            }
+            if ((size_t)(end - pos) < strLen + 1)
+            {
+                goto truncated;
+            }
+            *pos++ = (uint8_t)strLen;
+            memcpy(pos, str, strLen);
+            pos += strLen;
+            break;
+
+        default:
+            /* %n or not a conversion, the decoder stops here as well */
+            goto done;
+        }
+    }
+    goto done;
+
+truncated:
+    level |= DLOG_TRUNCATED;
+
+done:
+    record[0] = (uint8_t)(pos - record - 1);
+    putHeader(record, level, aRegion, aFormat, time);
+    ringWrite(record, pos - record, time);
+}
+
+/* Documented in dlog.h */
+void DLog_printf(const char *aFormat, ...)
+{
+    va_list ap;
+
+    va_start(ap, aFormat);
+    DLog_vprintf(0, DLOG_REGION_APP, aFormat, ap);
+    va_end(ap);
+}
+
+/**
+ * Documented in task_config.h.
+ */
+void DLog_taskCreate(void)
+{
+    pthread_t           thread;
+    pthread_attr_t      pAttrs;
+    struct sched_param  priParam;
+    int                 retc;
+
+    retc = sem_init(&sDLogSem, 0, 0);
+    assert(retc == 0);
+    sDLogReady = true;
+
+    retc = pthread_attr_init(&pAttrs);
+    assert(retc == 0);
+
+    retc = pthread_attr_setdetachstate(&pAttrs, PTHREAD_CREATE_DETACHED);
+    assert(retc == 0);
+
+    priParam.sched_priority = sched_get_priority_min(SCHED_OTHER);
+    retc = pthread_attr_setschedparam(&pAttrs, &priParam);
+    assert(retc == 0);
+
+    retc = pthread_attr_setstack(&pAttrs, (void *)sDLogStack,
+                                 TASK_CONFIG_DLOG_TASK_STACK_SIZE);
+    assert(retc == 0);
+
+    retc = pthread_create(&thread, &pAttrs, DLog_task, NULL);
+    assert(retc == 0);
+
+    retc = pthread_attr_destroy(&pAttrs);
+    assert(retc == 0);
+
+    (void)retc;
+}
+
+#endif /* DLOG_ENABLE */
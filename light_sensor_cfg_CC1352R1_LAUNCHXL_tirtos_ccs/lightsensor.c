@@ -54,6 +54,8 @@
 #include <assert.h>
 #include <lightsensor.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /* OpenThread public API Header files */
@@ -86,6 +88,7 @@
 #include "disp_utils.h"
 #include "keys_utils.h"
 #include "otstack.h"
+#include "platform/platform.h"
 
 /* Private configuration Header files */
 #include "task_config.h"
@@ -105,9 +108,13 @@
 /* report attribute */
 #define ATTR_REPORT   0x04
 /* Number of attributes in  application */
-#define ATTR_COUNT  3
+#define ATTR_COUNT  5
 /* Maximum number of characters for displayed temp including null terminator*/
 #define TEMP_MAX_CHARS 11
+/* Maximum number of characters of the energy counters including null terminator*/
+#define ENERGY_MAX_CHARS 112
+/* Maximum number of characters of the poll policy including null terminator*/
+#define POLL_MAX_CHARS 72
 
 /* coap attribute descriptor */
 typedef struct
@@ -138,6 +145,8 @@ static char stack[TASK_CONFIG_LIGHTSENSOR_TASK_STACK_SIZE];
 static otCoapResource coapResource;
 static otCoapResource coapResourceThresholdMin;
 static otCoapResource coapResourceThresholdMax;
+static otCoapResource coapResourceEnergy;
+static otCoapResource coapResourcePoll;
 
 /* coap attribute state of the application */
 static char attrState[TEMP_MAX_CHARS] = LIGHTSENSOR_STATE_BRIGHT;
@@ -149,6 +158,12 @@ static char attrStateTresholdMax[TEMP_MAX_CHARS] = "2500";
 static int tresholdMax = 2500;
 static bool daylight = 0;
 
+/* energy counters, formatted when read */
+static char attrEnergy[ENERGY_MAX_CHARS];
+
+/* data poll policy, formatted when read */
+static char attrPoll[POLL_MAX_CHARS];
+
 /* coap attribute discriptor for the application */
 static attrDesc_t coapAttrs[ATTR_COUNT] = {
 {
@@ -168,9 +183,30 @@ static attrDesc_t coapAttrs[ATTR_COUNT] = {
     .type = (ATTR_READ|ATTR_WRITE),
     .pValue = attrStateTresholdMax,
     .pAttrCoapResource = &coapResourceThresholdMax
+},
+{
+    .uriPath = LIGHTSENSOR_ENERGY_URI,
+    .type = (ATTR_READ|ATTR_WRITE),
+    .pValue = attrEnergy,
+    .pAttrCoapResource = &coapResourceEnergy
+},
+{
+    .uriPath = LIGHTSENSOR_POLL_URI,
+    .type = (ATTR_READ|ATTR_WRITE),
+    .pValue = attrPoll,
+    .pAttrCoapResource = &coapResourcePoll
 }
 };
 
+/* resources listed in /.well-known/core */
+static const OtStack_CoreLink coreLinks[] = {
+    { LIGHTSENSOR_STATE_URI, ";rt=\"light.daylight\";if=\"core.s\";ct=0" },
+    { LIGHTSENSOR_THRESHOLD_MIN_URI, ";rt=\"light.threshold\";if=\"core.p\";ct=0" },
+    { LIGHTSENSOR_THRESHOLD_MAX_URI, ";rt=\"light.threshold\";if=\"core.p\";ct=0" },
+    { LIGHTSENSOR_ENERGY_URI, ";rt=\"energy\";if=\"core.p\";ct=0" },
+    { LIGHTSENSOR_POLL_URI, ";rt=\"poll\";if=\"core.p\";ct=0" },
+};
+
 /* Holds the server setup state: True indicates CoAP server has been setup */
 static bool serverSetup;
 
@@ -264,6 +300,8 @@ static void coapHandleServer(void *aContext, otCoapHeader *aHeader,
     otCoapCode responseCode = OT_COAP_CODE_CHANGED;
     otCoapCode messageCode = otCoapHeaderGetCode(aHeader);
 
+    OtStack_pollActivity();
+
     otCoapHeaderInit(&responseHeader, OT_COAP_TYPE_ACKNOWLEDGMENT, responseCode);
     otCoapHeaderSetMessageId(&responseHeader, otCoapHeaderGetMessageId(aHeader));
     otCoapHeaderSetToken(&responseHeader, otCoapHeaderGetToken(aHeader),
@@ -297,83 +335,164 @@ exit:
 }
 
 /**
- * @brief Callback function registered with the Coap server.
- *        Processes the coap request from the clients.
+ * @brief Entity tag of a threshold, the FNV-1a hash of its text.
+ *
+ * @param  aAttr  The text of the threshold.
+ * @param  aTag   Filled with the tag, 4 bytes.
+ *
+ * @return None
+ */
+static void thresholdETag(const char *aAttr, uint8_t *aTag)
+{
+    uint32_t hash = 2166136261UL;
+
+    while (*aAttr != '\0')
+    {
+        hash = (hash ^ (uint8_t)*aAttr++) * 16777619UL;
+    }
+
+    aTag[0] = (uint8_t)(hash >> 24);
+    aTag[1] = (uint8_t)(hash >> 16);
+    aTag[2] = (uint8_t)(hash >> 8);
+    aTag[3] = (uint8_t)hash;
+}
+
+/**
+ * @brief Processes a request to a threshold resource. A GET is answered
+ *        2.05 with the threshold, its ETag and a Max-Age of
+ *        LIGHTSENSOR_THRESHOLD_MAX_AGE, or 2.03 without a payload when the
+ *        request has the current ETag. A POST sets the threshold and is
+ *        answered 2.04 with it.
  *
  * @param  aContext      A pointer to the context information.
  * @param  aHeader       A pointer to the CoAP header.
  * @param  aMessage      A pointer to the message.
  * @param  aMessageInfo  A pointer to the message info.
+ * @param  aAttr         The text of the threshold, TEMP_MAX_CHARS long.
+ * @param  aThreshold    The threshold.
  *
  * @return None
  */
-static void coapHandleThresholdMin(void *aContext, otCoapHeader *aHeader,
-                             otMessage *aMessage,
-                             const otMessageInfo *aMessageInfo)
+static void coapHandleThreshold(void *aContext, otCoapHeader *aHeader,
+                                otMessage *aMessage,
+                                const otMessageInfo *aMessageInfo,
+                                char *aAttr, int *aThreshold)
 {
     otError error = OT_ERROR_NONE;
     otCoapHeader responseHeader;
     otMessage *responseMessage = NULL;
-    otCoapCode responseCode = OT_COAP_CODE_CHANGED;
     otCoapCode messageCode = otCoapHeaderGetCode(aHeader);
+    otCoapCode responseCode;
+    const otCoapOption *option;
+    otCoapOption eTagOption;
+    uint8_t eTag[4];
+    bool valid = false;
 
-    otCoapHeaderInit(&responseHeader, OT_COAP_TYPE_ACKNOWLEDGMENT, responseCode);
-    otCoapHeaderSetMessageId(&responseHeader, otCoapHeaderGetMessageId(aHeader));
-    otCoapHeaderSetToken(&responseHeader, otCoapHeaderGetToken(aHeader),
-                         otCoapHeaderGetTokenLength(aHeader));
-    otCoapHeaderSetPayloadMarker(&responseHeader);
-
-    if(OT_COAP_CODE_GET == messageCode)
-    {
-        OtRtosApi_lock();
-        responseMessage = otCoapNewMessage((otInstance*)aContext,
-                                           &responseHeader);
+    OtStack_pollActivity();
 
-        otEXPECT_ACTION(responseMessage != NULL, error = OT_ERROR_NO_BUFS);
-        error = otMessageAppend(responseMessage, attrStateTresholdMin,strlen((const char*)attrStateTresholdMin));
-        otEXPECT(OT_ERROR_NONE == error);
+    otEXPECT(OT_COAP_CODE_GET == messageCode ||
+             OT_COAP_CODE_POST == messageCode);
 
+    OtRtosApi_lock();
 
-        DISPUTILS_SERIALPRINTF(0, 0, "old thresh min %d\n", tresholdMin);
-        error = otCoapSendResponse((otInstance*)aContext, responseMessage,
-                                   aMessageInfo);
-        OtRtosApi_unlock();
-        otEXPECT(OT_ERROR_NONE == error);
-    }
-    else if(OT_COAP_CODE_POST == messageCode)
+    if (OT_COAP_CODE_POST == messageCode)
     {
-        char data[32];
         uint16_t offset = otMessageGetOffset(aMessage);
-        uint16_t read = otMessageRead(aMessage, offset, data, sizeof(data) - 1);
-        data[read] = '\0';
+        uint16_t read = otMessageRead(aMessage, offset, aAttr,
+                                      TEMP_MAX_CHARS - 1);
 
         /* update the attribute state */
-        strcpy((char *)attrStateTresholdMin, data);
-        tresholdMin = atoi (data);
+        aAttr[read] = '\0';
+        *aThreshold = atoi(aAttr);
+        responseCode = OT_COAP_CODE_CHANGED;
 
-        DISPUTILS_SERIALPRINTF(0, 0, "new thresh min %s\n", data);
-        DISPUTILS_SERIALPRINTF(0, 0, "new thresh min %d\n", tresholdMin);
+        DISPUTILS_SERIALPRINTF(0, 0, "new thresh %d\n", *aThreshold);
+    }
+    else
+    {
+        thresholdETag(aAttr, eTag);
 
-        OtRtosApi_lock();
-        responseMessage = otCoapNewMessage((otInstance*)aContext,
-                                           &responseHeader);
+        for (option = otCoapHeaderGetFirstOption(aHeader); option != NULL;
+             option = otCoapHeaderGetNextOption(aHeader))
+        {
+            if (option->mNumber == OT_COAP_OPTION_E_TAG &&
+                option->mLength == sizeof(eTag) &&
+                memcmp(option->mValue, eTag, sizeof(eTag)) == 0)
+            {
+                valid = true;
+            }
+        }
+        responseCode = valid ? OT_COAP_CODE_VALID : OT_COAP_CODE_CONTENT;
+    }
 
-        otEXPECT_ACTION(responseMessage != NULL, error = OT_ERROR_NO_BUFS);
-        error = otMessageAppend(responseMessage, attrStateTresholdMin, strlen((const char*)attrStateTresholdMin));
-        otEXPECT(OT_ERROR_NONE == error);
+    otCoapHeaderInit(&responseHeader, OT_COAP_TYPE_ACKNOWLEDGMENT, responseCode);
+    otCoapHeaderSetMessageId(&responseHeader, otCoapHeaderGetMessageId(aHeader));
+    otCoapHeaderSetToken(&responseHeader, otCoapHeaderGetToken(aHeader),
+                         otCoapHeaderGetTokenLength(aHeader));
 
-        error = otCoapSendResponse((otInstance*)aContext,
-                                   responseMessage, aMessageInfo);
-        OtRtosApi_unlock();
-        otEXPECT(OT_ERROR_NONE == error);
+    if (OT_COAP_CODE_GET == messageCode)
+    {
+        eTagOption.mNumber = OT_COAP_OPTION_E_TAG;
+        eTagOption.mLength = sizeof(eTag);
+        eTagOption.mValue = eTag;
+        error = otCoapHeaderAppendOption(&responseHeader, &eTagOption);
+        if (OT_ERROR_NONE == error)
+        {
+            error = otCoapHeaderAppendMaxAgeOption(&responseHeader,
+                                                   LIGHTSENSOR_THRESHOLD_MAX_AGE);
+        }
+    }
+    if (!valid)
+    {
+        otCoapHeaderSetPayloadMarker(&responseHeader);
     }
 
-exit:
-
+    if (OT_ERROR_NONE == error)
+    {
+        responseMessage = otCoapNewMessage((otInstance*)aContext,
+                                           &responseHeader);
+        if (responseMessage == NULL)
+        {
+            error = OT_ERROR_NO_BUFS;
+        }
+    }
+    if (OT_ERROR_NONE == error && !valid)
+    {
+        error = otMessageAppend(responseMessage, aAttr, strlen(aAttr));
+    }
+    if (OT_ERROR_NONE == error)
+    {
+        error = otCoapSendResponse((otInstance*)aContext, responseMessage,
+                                   aMessageInfo);
+    }
     if (error != OT_ERROR_NONE && responseMessage != NULL)
     {
         otMessageFree(responseMessage);
     }
+
+    OtRtosApi_unlock();
+
+exit:
+    return;
+}
+
+/**
+ * @brief Callback function registered with the Coap server.
+ *        Processes the coap request from the clients.
+ *
+ * @param  aContext      A pointer to the context information.
+ * @param  aHeader       A pointer to the CoAP header.
+ * @param  aMessage      A pointer to the message.
+ * @param  aMessageInfo  A pointer to the message info.
+ *
+ * @return None
+ */
+static void coapHandleThresholdMin(void *aContext, otCoapHeader *aHeader,
+                             otMessage *aMessage,
+                             const otMessageInfo *aMessageInfo)
+{
+    coapHandleThreshold(aContext, aHeader, aMessage, aMessageInfo,
+                        attrStateTresholdMin, &tresholdMin);
 }
 
 /**
@@ -390,63 +509,194 @@ exit:
 static void coapHandleThresholdMax(void *aContext, otCoapHeader *aHeader,
                              otMessage *aMessage,
                              const otMessageInfo *aMessageInfo)
+{
+    coapHandleThreshold(aContext, aHeader, aMessage, aMessageInfo,
+                        attrStateTresholdMax, &tresholdMax);
+}
+
+/**
+ * @brief Formats the energy counters into their attribute: ms in rx, tx,
+ *        MCU active, idle and standby, then the charge drawn in uC and the
+ *        average current in nA.
+ *
+ * @return None
+ */
+static void updateEnergy(void)
+{
+    PlatformEnergy_Stats stats;
+
+    platformEnergyGetStats(&stats);
+    snprintf(attrEnergy, sizeof(attrEnergy),
+             "rx=%lu tx=%lu act=%lu idle=%lu sb=%lu uC=%lu nA=%lu",
+             (unsigned long)stats.ms[PlatformEnergy_rx],
+             (unsigned long)stats.ms[PlatformEnergy_tx],
+             (unsigned long)stats.ms[PlatformEnergy_active],
+             (unsigned long)stats.ms[PlatformEnergy_idle],
+             (unsigned long)stats.ms[PlatformEnergy_standby],
+             (unsigned long)stats.chargeUc,
+             (unsigned long)stats.averageNa);
+}
+
+/**
+ * @brief Callback function registered with the Coap server.
+ *        Reads the energy counters on a GET, clears them on a POST.
+ *
+ * @param  aContext      A pointer to the context information.
+ * @param  aHeader       A pointer to the CoAP header.
+ * @param  aMessage      A pointer to the message.
+ * @param  aMessageInfo  A pointer to the message info.
+ *
+ * @return None
+ */
+static void coapHandleEnergy(void *aContext, otCoapHeader *aHeader,
+                             otMessage *aMessage,
+                             const otMessageInfo *aMessageInfo)
 {
     otError error = OT_ERROR_NONE;
     otCoapHeader responseHeader;
     otMessage *responseMessage = NULL;
-    otCoapCode responseCode = OT_COAP_CODE_CHANGED;
+    otCoapCode responseCode = OT_COAP_CODE_CONTENT;
     otCoapCode messageCode = otCoapHeaderGetCode(aHeader);
 
+    (void)aMessage;
+
+    OtStack_pollActivity();
+
+    otEXPECT(OT_COAP_CODE_GET == messageCode ||
+             OT_COAP_CODE_POST == messageCode);
+
+    if(OT_COAP_CODE_POST == messageCode)
+    {
+        platformEnergyClear();
+        responseCode = OT_COAP_CODE_CHANGED;
+    }
+    updateEnergy();
+
     otCoapHeaderInit(&responseHeader, OT_COAP_TYPE_ACKNOWLEDGMENT, responseCode);
     otCoapHeaderSetMessageId(&responseHeader, otCoapHeaderGetMessageId(aHeader));
     otCoapHeaderSetToken(&responseHeader, otCoapHeaderGetToken(aHeader),
                          otCoapHeaderGetTokenLength(aHeader));
     otCoapHeaderSetPayloadMarker(&responseHeader);
 
-    if(OT_COAP_CODE_GET == messageCode)
+    OtRtosApi_lock();
+    responseMessage = otCoapNewMessage((otInstance*)aContext, &responseHeader);
+    if (responseMessage == NULL)
+    {
+        error = OT_ERROR_NO_BUFS;
+    }
+    else
+    {
+        error = otMessageAppend(responseMessage, attrEnergy, strlen(attrEnergy));
+    }
+    if (error == OT_ERROR_NONE)
     {
-        OtRtosApi_lock();
-        responseMessage = otCoapNewMessage((otInstance*)aContext,
-                                           &responseHeader);
-
-        otEXPECT_ACTION(responseMessage != NULL, error = OT_ERROR_NO_BUFS);
-        error = otMessageAppend(responseMessage, attrStateTresholdMax,strlen((const char*)attrStateTresholdMax));
-        otEXPECT(OT_ERROR_NONE == error);
-
-
-        DISPUTILS_SERIALPRINTF(0, 0, "old thresh max %d\n", tresholdMax);
         error = otCoapSendResponse((otInstance*)aContext, responseMessage,
                                    aMessageInfo);
-        OtRtosApi_unlock();
-        otEXPECT(OT_ERROR_NONE == error);
     }
-    else if(OT_COAP_CODE_POST == messageCode)
+    OtRtosApi_unlock();
+
+exit:
+
+    if (error != OT_ERROR_NONE && responseMessage != NULL)
     {
-        char data[32];
+        otMessageFree(responseMessage);
+    }
+}
+
+/**
+ * @brief Formats the data poll policy into its attribute: the fast period,
+ *        fast window and slow period, then the period in use, all in ms.
+ *
+ * @return None
+ */
+static void updatePoll(void)
+{
+    OtStack_PollPolicy policy;
+    uint32_t period = OtStack_getPollPolicy(&policy);
+
+    snprintf(attrPoll, sizeof(attrPoll), "fast=%lu window=%lu slow=%lu now=%lu",
+             (unsigned long)policy.fastPeriod,
+             (unsigned long)policy.fastWindow,
+             (unsigned long)policy.slowPeriod,
+             (unsigned long)period);
+}
+
+/**
+ * @brief Callback function registered with the Coap server.
+ *        Reads the data poll policy on a GET. Sets it on a POST of
+ *        "fast=<ms> window=<ms> slow=<ms>", the form a GET returns.
+ *
+ * @param  aContext      A pointer to the context information.
+ * @param  aHeader       A pointer to the CoAP header.
+ * @param  aMessage      A pointer to the message.
+ * @param  aMessageInfo  A pointer to the message info.
+ *
+ * @return None
+ */
+static void coapHandlePoll(void *aContext, otCoapHeader *aHeader,
+                           otMessage *aMessage,
+                           const otMessageInfo *aMessageInfo)
+{
+    otError error = OT_ERROR_NONE;
+    otCoapHeader responseHeader;
+    otMessage *responseMessage = NULL;
+    otCoapCode responseCode = OT_COAP_CODE_CONTENT;
+    otCoapCode messageCode = otCoapHeaderGetCode(aHeader);
+
+    OtStack_pollActivity();
+
+    otEXPECT(OT_COAP_CODE_GET == messageCode ||
+             OT_COAP_CODE_POST == messageCode);
+
+    if(OT_COAP_CODE_POST == messageCode)
+    {
+        OtStack_PollPolicy policy;
+        unsigned long fast, window, slow;
+        char data[POLL_MAX_CHARS];
         uint16_t offset = otMessageGetOffset(aMessage);
         uint16_t read = otMessageRead(aMessage, offset, data, sizeof(data) - 1);
         data[read] = '\0';
 
-        /* update the attribute state */
-        strcpy((char *)attrStateTresholdMax, data);
-        tresholdMin = atoi (data);
-
-        DISPUTILS_SERIALPRINTF(0, 0, "new thresh max %s\n", data);
-        DISPUTILS_SERIALPRINTF(0, 0, "new thresh max %d\n", tresholdMax);
-
-        OtRtosApi_lock();
-        responseMessage = otCoapNewMessage((otInstance*)aContext,
-                                           &responseHeader);
+        responseCode = OT_COAP_CODE_BAD_REQUEST;
+        if(sscanf(data, "fast=%lu window=%lu slow=%lu", &fast, &window,
+                  &slow) == 3)
+        {
+            policy.fastPeriod = fast;
+            policy.fastWindow = window;
+            policy.slowPeriod = slow;
+            if(OtStack_setPollPolicy(&policy) == OT_ERROR_NONE)
+            {
+                responseCode = OT_COAP_CODE_CHANGED;
+            }
+        }
+        DISPUTILS_SERIALPRINTF(0, 0, "poll policy %s: %s\n",
+                               (responseCode == OT_COAP_CODE_CHANGED) ?
+                               "set" : "refused", data);
+    }
+    updatePoll();
 
-        otEXPECT_ACTION(responseMessage != NULL, error = OT_ERROR_NO_BUFS);
-        error = otMessageAppend(responseMessage, attrStateTresholdMax, strlen((const char*)attrStateTresholdMax));
-        otEXPECT(OT_ERROR_NONE == error);
+    otCoapHeaderInit(&responseHeader, OT_COAP_TYPE_ACKNOWLEDGMENT, responseCode);
+    otCoapHeaderSetMessageId(&responseHeader, otCoapHeaderGetMessageId(aHeader));
+    otCoapHeaderSetToken(&responseHeader, otCoapHeaderGetToken(aHeader),
+                         otCoapHeaderGetTokenLength(aHeader));
+    otCoapHeaderSetPayloadMarker(&responseHeader);
 
-        error = otCoapSendResponse((otInstance*)aContext,
-                                   responseMessage, aMessageInfo);
-        OtRtosApi_unlock();
-        otEXPECT(OT_ERROR_NONE == error);
+    OtRtosApi_lock();
+    responseMessage = otCoapNewMessage((otInstance*)aContext, &responseHeader);
+    if (responseMessage == NULL)
+    {
+        error = OT_ERROR_NO_BUFS;
     }
+    else
+    {
+        error = otMessageAppend(responseMessage, attrPoll, strlen(attrPoll));
+    }
+    if (error == OT_ERROR_NONE)
+    {
+        error = otCoapSendResponse((otInstance*)aContext, responseMessage,
+                                   aMessageInfo);
+    }
+    OtRtosApi_unlock();
 
 exit:
 
@@ -600,11 +850,16 @@ static void processEvents(void)
             coapAttrs[0].pAttrHandlerCB = &coapHandleServer;
             coapAttrs[1].pAttrHandlerCB = &coapHandleThresholdMin;
             coapAttrs[2].pAttrHandlerCB = &coapHandleThresholdMax;
+            coapAttrs[3].pAttrHandlerCB = &coapHandleEnergy;
+            coapAttrs[4].pAttrHandlerCB = &coapHandlePoll;
             /* register coap attributes */
             (void)setupCoapServer(OtInstance_get(), &coapAttrs[0]);
             (void)setupCoapServer(OtInstance_get(), &coapAttrs[1]);
             (void)setupCoapServer(OtInstance_get(), &coapAttrs[2]);
-
+            (void)setupCoapServer(OtInstance_get(), &coapAttrs[3]);
+            (void)setupCoapServer(OtInstance_get(), &coapAttrs[4]);
+            (void)OtStack_setupCoreLinks(coreLinks,
+                                         sizeof(coreLinks) / sizeof(coreLinks[0]));
 
             /* display unlock image on LCD */
             DISPUTILS_SERIALPRINTF(1, 0, "CoAP server setup done");
@@ -672,10 +927,18 @@ static void resetPriority(void)
  */
 void otPlatLog(otLogLevel aLogLevel, otLogRegion aLogRegion, const char *aFormat, ...)
 {
+#if DLOG_ENABLE
+    va_list ap;
+
+    va_start(ap, aFormat);
+    DLog_vprintf((uint8_t)aLogLevel, (uint8_t)aLogRegion, aFormat, ap);
+    va_end(ap);
+#else
     (void)aLogLevel;
     (void)aLogRegion;
     (void)aFormat;
     /* Do nothing. */
+#endif
 }
 #endif
 
@@ -71,6 +71,21 @@ extern "C"
 /** Lightsensor state string */
 #define LIGHTSENSOR_THRESHOLD_MAX_URI    "lightsensor/threshold/max"
 
+/** Lightsensor energy counters, a POST clears them */
+#define LIGHTSENSOR_ENERGY_URI    "lightsensor/energy"
+
+/** Lightsensor data poll policy, a POST sets it */
+#define LIGHTSENSOR_POLL_URI    "lightsensor/poll"
+
+/**
+ * Max-Age of a threshold read, in s. Only a POST changes a threshold, so a
+ * gateway may serve it from its cache that long, and revalidates it with
+ * its ETag after.
+ */
+#ifndef LIGHTSENSOR_THRESHOLD_MAX_AGE
+#define LIGHTSENSOR_THRESHOLD_MAX_AGE   60
+#endif
+
 
 /**
  * Lightsensor events.
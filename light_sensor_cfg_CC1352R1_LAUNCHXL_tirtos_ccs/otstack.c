@@ -63,12 +63,14 @@
 /* RTOS header files */
 #include <ti/drivers/GPIO.h>
 #include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Event.h>
 
 /* OpenThread public API Header files */
 #include <openthread/coap.h>
 #include <openthread/diag.h>
 #include <openthread/joiner.h>
+#include <openthread/link.h>
 #include <openthread/platform/settings.h>
 #include <openthread/tasklet.h>
 #include <openthread/thread.h>
@@ -80,6 +82,7 @@
 
 /* Example/Board Header files */
 #include "Board.h"
+#include "disp_utils.h"
 #include "otstack.h"
 #include "task_config.h"
 #include "utils/code_utils.h"
@@ -101,6 +104,7 @@ extern void *OtStack_task(void *arg0);
 #define OT_STACK_EVENT_SIGNAL_UART_PROCESS    Event_Id_03
 #define OT_STACK_EVENT_SIGNAL_RANDOM_PROCESS  Event_Id_04
 #define OT_STACK_EVENT_SIGNAL_ALARMU_PROCESS  Event_Id_05
+#define OT_STACK_EVENT_SIGNAL_POLL_PROCESS    Event_Id_06
 
 /******************************************************************************
  Local variables
@@ -126,9 +130,37 @@ static OtStack_EventsCallback_t appEventHandler = NULL;
 
 static otNetifAddress addresses[OT_STACK_MAX_ADDRESSES];
 
+/* Resources listed in /.well-known/core */
+static const OtStack_CoreLink *OtStack_coreLinks;
+static uint8_t OtStack_coreLinkCount;
+static otCoapResource OtStack_coreResource;
+
 /* Holds the stack events related to network */
 static volatile uint8_t otStackEvents = OT_STACK_EVENT_NWK_NOT_JOINED;
 
+/* Time the joiner was started, 0 when not joining */
+static uint64_t OtStack_joinStartUs;
+
+/* Time the joiner finished, until the first attach after it */
+static uint64_t OtStack_joinDoneUs;
+
+/* EC-JPAKE handshakes set up before the joiner was started */
+static uint32_t OtStack_joinHandshakes;
+
+/* Data poll policy */
+static OtStack_PollPolicy OtStack_pollPolicy = {
+    .fastPeriod = OT_STACK_POLL_FAST_PERIOD,
+    .fastWindow = OT_STACK_POLL_FAST_WINDOW,
+    .slowPeriod = OT_STACK_POLL_SLOW_PERIOD,
+};
+
+/* Clock running for the fast window */
+static Clock_Struct OtStack_pollClockStruct;
+static Clock_Handle OtStack_pollClock;
+
+/* Activity reported since the poll period was last set */
+static volatile bool OtStack_pollWake;
+
 /******************************************************************************
  Local Functions
  *****************************************************************************/
@@ -148,12 +180,361 @@ static otError createIid(otInstance *aInstance, otNetifAddress *aAddress, void *
     (void) aInstance;
     (void) aContext;
 
+#if OT_STACK_IID_FROM_EUI64
+    otExtAddress eui64;
+
+    /* The first byte of the EUI-64 is the same on all TI parts */
+    otLinkGetFactoryAssignedIeeeEui64(aInstance, &eui64);
+    memcpy(&aAddress->mAddress.mFields.m8[OT_IP6_ADDRESS_SIZE -
+                                          OT_EXT_ADDRESS_SIZE],
+           &eui64.m8[1], OT_EXT_ADDRESS_SIZE - 1);
+#endif
+
     aAddress->mAddress.mFields.m8[OT_IP6_ADDRESS_SIZE - 1] =
         OT_STACK_IID_ADDRESS_LSB;
 
     return OT_ERROR_NONE;
 }
 
+/**
+ * @brief Compares an attribute value to the value of a query filter.
+ *
+ * @param aValue        value of the attribute.
+ * @param aLength       length of aValue.
+ * @param aFilter       value of the filter.
+ * @param aFilterLength length of aFilter.
+ * @param aPrefix       true if the filter ended in '*'.
+ * @return true if they match.
+ */
+static bool coreValueMatches(const char *aValue, size_t aLength,
+                             const char *aFilter, size_t aFilterLength,
+                             bool aPrefix)
+{
+    if (aPrefix)
+    {
+        return (aLength >= aFilterLength &&
+                memcmp(aValue, aFilter, aFilterLength) == 0);
+    }
+
+    return (aLength == aFilterLength &&
+            memcmp(aValue, aFilter, aFilterLength) == 0);
+}
+
+/**
+ * @brief Checks a link against the query filter of a discovery request,
+ *        RFC 6690 section 4.1. href filters on the URI.
+ *
+ * @param aLink    link to check.
+ * @param aQuery   the filter, "<attribute>=<value>".
+ * @param aLength  length of aQuery.
+ * @return true if the link matches, or if the query is not a filter.
+ */
+static bool coreLinkMatches(const OtStack_CoreLink *aLink, const char *aQuery,
+                            uint16_t aLength)
+{
+    const char *equals = memchr(aQuery, '=', aLength);
+    const char *filter;
+    const char *attr;
+    size_t nameLength;
+    size_t filterLength;
+    bool prefix;
+
+    if (equals == NULL)
+    {
+        return true;
+    }
+
+    nameLength = equals - aQuery;
+    filter = equals + 1;
+    filterLength = aLength - nameLength - 1;
+    prefix = (filterLength > 0 && filter[filterLength - 1] == '*');
+    if (prefix)
+    {
+        filterLength--;
+    }
+
+    if (nameLength == 4 && memcmp(aQuery, "href", 4) == 0)
+    {
+        if (filterLength > 0 && filter[0] == '/')
+        {
+            filter++;
+            filterLength--;
+        }
+        return coreValueMatches(aLink->uriPath, strlen(aLink->uriPath),
+                                filter, filterLength, prefix);
+    }
+
+    for (attr = strchr(aLink->attributes, ';'); attr != NULL;
+         attr = strchr(attr + 1, ';'))
+    {
+        const char *name = attr + 1;
+        const char *value = name + nameLength + 1;
+        size_t length = strcspn(name, ";");
+
+        if (length <= nameLength || name[nameLength] != '=' ||
+            memcmp(name, aQuery, nameLength) != 0)
+        {
+            continue;
+        }
+
+        length -= nameLength + 1;
+        if (length >= 2 && value[0] == '"' && value[length - 1] == '"')
+        {
+            value++;
+            length -= 2;
+        }
+        if (coreValueMatches(value, length, filter, filterLength, prefix))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Handles the discovery requests, a GET of /.well-known/core.
+ *
+ * @param aContext      A pointer to the context information.
+ * @param aHeader       A pointer to the CoAP header.
+ * @param aMessage      A pointer to the message.
+ * @param aMessageInfo  A pointer to the message info.
+ * @return None
+ */
+static void coapHandleCore(void *aContext, otCoapHeader *aHeader,
+                           otMessage *aMessage,
+                           const otMessageInfo *aMessageInfo)
+{
+    otError error = OT_ERROR_NONE;
+    otCoapHeader responseHeader;
+    otMessage *responseMessage = NULL;
+    const otCoapOption *option;
+    char query[OT_STACK_CORE_QUERY_MAX_LENGTH];
+    uint16_t queryLength = 0;
+    bool multicast = (aMessageInfo->mSockAddr.mFields.m8[0] == 0xff);
+    bool first = true;
+    uint8_t i;
+
+    (void)aMessage;
+
+    otEXPECT(OT_COAP_CODE_GET == otCoapHeaderGetCode(aHeader));
+
+    for (option = otCoapHeaderGetFirstOption(aHeader); option != NULL;
+         option = otCoapHeaderGetNextOption(aHeader))
+    {
+        if (option->mNumber == OT_COAP_OPTION_URI_QUERY &&
+            option->mLength <= sizeof(query))
+        {
+            memcpy(query, option->mValue, option->mLength);
+            queryLength = option->mLength;
+        }
+    }
+
+    /* Devices that have nothing to list stay quiet on a multicast */
+    for (i = 0; i < OtStack_coreLinkCount; i++)
+    {
+        if (coreLinkMatches(&OtStack_coreLinks[i], query, queryLength))
+        {
+            break;
+        }
+    }
+    otEXPECT(!multicast || i < OtStack_coreLinkCount);
+
+    otCoapHeaderInit(&responseHeader,
+                     (OT_COAP_TYPE_CONFIRMABLE == otCoapHeaderGetType(aHeader)) ?
+                     OT_COAP_TYPE_ACKNOWLEDGMENT : OT_COAP_TYPE_NON_CONFIRMABLE,
+                     OT_COAP_CODE_CONTENT);
+    otCoapHeaderSetMessageId(&responseHeader, otCoapHeaderGetMessageId(aHeader));
+    otCoapHeaderSetToken(&responseHeader, otCoapHeaderGetToken(aHeader),
+                         otCoapHeaderGetTokenLength(aHeader));
+    error = otCoapHeaderAppendContentFormatOption(&responseHeader,
+                OT_COAP_OPTION_CONTENT_FORMAT_LINK_FORMAT);
+    otEXPECT(OT_ERROR_NONE == error);
+    otCoapHeaderSetPayloadMarker(&responseHeader);
+
+    responseMessage = otCoapNewMessage((otInstance*)aContext, &responseHeader);
+    otEXPECT_ACTION(responseMessage != NULL, error = OT_ERROR_NO_BUFS);
+
+    for (; i < OtStack_coreLinkCount && OT_ERROR_NONE == error; i++)
+    {
+        const OtStack_CoreLink *link = &OtStack_coreLinks[i];
+
+        if (!coreLinkMatches(link, query, queryLength))
+        {
+            continue;
+        }
+
+        error = otMessageAppend(responseMessage, first ? "</" : ",</",
+                                first ? 2 : 3);
+        if (OT_ERROR_NONE == error)
+        {
+            error = otMessageAppend(responseMessage, link->uriPath,
+                                    strlen(link->uriPath));
+        }
+        if (OT_ERROR_NONE == error)
+        {
+            error = otMessageAppend(responseMessage, ">", 1);
+        }
+        if (OT_ERROR_NONE == error)
+        {
+            error = otMessageAppend(responseMessage, link->attributes,
+                                    strlen(link->attributes));
+        }
+        first = false;
+    }
+    otEXPECT(OT_ERROR_NONE == error);
+
+    error = otCoapSendResponse((otInstance*)aContext, responseMessage,
+                               aMessageInfo);
+
+exit:
+
+    if (error != OT_ERROR_NONE && responseMessage != NULL)
+    {
+        otMessageFree(responseMessage);
+    }
+}
+
+/**
+ * @brief Logs the time taken by each phase of the commissioning, when the
+ *        joiner finishes. Discovery runs from the start of the joiner to
+ *        the first EC-JPAKE step, the DTLS handshake from there to the
+ *        derived secret, and the commissioning that follows until the
+ *        joiner reports. The EC-JPAKE steps are timed in crypto/ecjpake_alt.c.
+ *
+ * @param aError result of the joiner
+ * @return None
+ */
+static void logJoinPhases(otError aError)
+{
+    PlatformEcjpake_Profile profile;
+    uint64_t now = platformAlarmGetNowUs();
+    uint64_t handshakeStart;
+    uint64_t handshakeEnd;
+    uint32_t ecjpakeUs = 0;
+    uint32_t tries;
+    int i;
+
+    if (OtStack_joinStartUs == 0)
+    {
+        return;
+    }
+
+    DISPUTILS_SERIALPRINTF(0, 0, "join: result %d after %lu ms\n", aError,
+                           (unsigned long)((now - OtStack_joinStartUs) / 1000));
+
+    platformEcjpakeGetProfile(&profile);
+    tries = profile.handshakes - OtStack_joinHandshakes;
+    handshakeStart = profile.start[PlatformEcjpake_writeRoundOne];
+    handshakeEnd = profile.start[PlatformEcjpake_deriveSecret] +
+                   profile.us[PlatformEcjpake_deriveSecret];
+
+    /* No handshake of this join got as far as the secret */
+    if (handshakeStart < OtStack_joinStartUs ||
+        profile.start[PlatformEcjpake_deriveSecret] < handshakeStart)
+    {
+        DISPUTILS_SERIALPRINTF(0, 0, "join: no ec-jpake secret, %lu tries\n",
+                               (unsigned long)tries);
+        return;
+    }
+
+    for (i = 0; i < PlatformEcjpake_opCount; i++)
+    {
+        ecjpakeUs += profile.us[i];
+    }
+
+    DISPUTILS_SERIALPRINTF(0, 0, "join: discover %lu handshake %lu finalize %lu ms\n",
+                           (unsigned long)((handshakeStart - OtStack_joinStartUs) / 1000),
+                           (unsigned long)((handshakeEnd - handshakeStart) / 1000),
+                           (unsigned long)((now - handshakeEnd) / 1000));
+    DISPUTILS_SERIALPRINTF(0, 0, "join: ec-jpake %lu ms, %lu tries\n",
+                           (unsigned long)(ecjpakeUs / 1000),
+                           (unsigned long)tries);
+    DISPUTILS_SERIALPRINTF(0, 0, "join: ec-jpake w1 %lu r1 %lu r2 %lu w2 %lu sk %lu us\n",
+                           (unsigned long)profile.us[PlatformEcjpake_writeRoundOne],
+                           (unsigned long)profile.us[PlatformEcjpake_readRoundOne],
+                           (unsigned long)profile.us[PlatformEcjpake_readRoundTwo],
+                           (unsigned long)profile.us[PlatformEcjpake_writeRoundTwo],
+                           (unsigned long)profile.us[PlatformEcjpake_deriveSecret]);
+}
+
+/**
+ * @brief Logs the time from the end of the joiner to the first attach
+ *        after it, and from the start of the joiner.
+ *
+ * @return None
+ */
+static void logJoinAttached(void)
+{
+    uint64_t now;
+
+    if (OtStack_joinDoneUs == 0)
+    {
+        return;
+    }
+
+    now = platformAlarmGetNowUs();
+    DISPUTILS_SERIALPRINTF(0, 0, "join: attached after %lu ms, %lu ms in all\n",
+                           (unsigned long)((now - OtStack_joinDoneUs) / 1000),
+                           (unsigned long)((now - OtStack_joinStartUs) / 1000));
+    OtStack_joinStartUs = 0;
+    OtStack_joinDoneUs = 0;
+}
+
+/**
+ * @brief Handler for the clock of the fast window, which has ended.
+ *
+ * @param arg unused.
+ * @return None
+ */
+static void pollClockHandler(UArg arg)
+{
+    (void)arg;
+
+    Event_post(Event_handle(&OtStack_events), OT_STACK_EVENT_SIGNAL_POLL_PROCESS);
+}
+
+/**
+ * @brief Sets the poll period for the policy: the fast period while the
+ *        window runs, restarting it on activity, else the slow period.
+ *        Called with the stack locked. A shorter period takes effect from
+ *        the last poll, so activity after a long sleep polls at once.
+ *
+ * @return None
+ */
+static void processPoll(void)
+{
+    otLinkModeConfig linkMode = otThreadGetLinkMode(OtStack_instance);
+    bool wake = OtStack_pollWake;
+    uint32_t period;
+
+    OtStack_pollWake = false;
+    if (linkMode.mRxOnWhenIdle)
+    {
+        return;
+    }
+
+    if (wake)
+    {
+        Clock_stop(OtStack_pollClock);
+        if (OtStack_pollPolicy.fastWindow > 0)
+        {
+            Clock_setTimeout(OtStack_pollClock,
+                             ((OtStack_pollPolicy.fastWindow * 1000U) +
+                              Clock_tickPeriod - 1) / Clock_tickPeriod);
+            Clock_start(OtStack_pollClock);
+        }
+    }
+
+    period = Clock_isActive(OtStack_pollClock) ? OtStack_pollPolicy.fastPeriod
+                                               : OtStack_pollPolicy.slowPeriod;
+
+    if (otLinkGetPollPeriod(OtStack_instance) != period)
+    {
+        otLinkSetPollPeriod(OtStack_instance, period);
+    }
+}
+
 /**
  * @brief Callback function registered with the netif.
  *
@@ -197,11 +578,13 @@ void handleNetifStateChanged(uint32_t aFlags, void *aContext)
             case OT_DEVICE_ROLE_ROUTER:
                 GPIO_write(Board_GPIO_GLED, Board_GPIO_LED_ON);
                 GPIO_write(Board_GPIO_RLED, Board_GPIO_LED_OFF);
+                logJoinAttached();
                 break;
 
             case OT_DEVICE_ROLE_LEADER:
                 GPIO_write(Board_GPIO_GLED, Board_GPIO_LED_ON);
                 GPIO_write(Board_GPIO_RLED, Board_GPIO_LED_ON);
+                logJoinAttached();
                 break;
 
             default:
@@ -225,13 +608,17 @@ void joinerCallback(otError aError, void *aContext)
 {
     (void)aContext;
 
+    logJoinPhases(aError);
+
     if(aError == OT_ERROR_NONE)
     {
         otStackEvents = OT_STACK_EVENT_NWK_JOINED;
+        OtStack_joinDoneUs = platformAlarmGetNowUs();
     }
     else
     {
         otStackEvents = OT_STACK_EVENT_NWK_JOINED_FAILURE;
+        OtStack_joinStartUs = 0;
     }
 
     if (appEventHandler)
@@ -259,8 +646,14 @@ uint8_t OtStack_joinState(void)
 /* Documented in otstack.h */
 void OtStack_joinNetwork(const char* pskd)
 {
+    PlatformEcjpake_Profile profile;
+
     OtRtosApi_lock();
     otIp6SetEnabled(OtStack_instance, true);
+    platformEcjpakeGetProfile(&profile);
+    OtStack_joinHandshakes = profile.handshakes;
+    OtStack_joinStartUs = platformAlarmGetNowUs();
+    DISPUTILS_SERIALPRINTF(0, 0, "join: start\n");
     if (OT_ERROR_NONE == otJoinerStart(OtStack_instance, pskd, NULL, PACKAGE_NAME, OPENTHREAD_CONFIG_PLATFORM_INFO,
                   PACKAGE_VERSION, NULL, joinerCallback, NULL))
     {
@@ -289,6 +682,64 @@ bool OtStack_setupNetwork(void)
     return status;
 }
 
+/* Documented in otstack.h */
+otError OtStack_setupCoreLinks(const OtStack_CoreLink *aLinks, uint8_t aCount)
+{
+    otError error;
+
+    OtRtosApi_lock();
+    OtStack_coreLinks = aLinks;
+    OtStack_coreLinkCount = aCount;
+    OtStack_coreResource.mUriPath = OT_STACK_CORE_URI;
+    OtStack_coreResource.mHandler = coapHandleCore;
+    OtStack_coreResource.mContext = OtStack_instance;
+    error = otCoapAddResource(OtStack_instance, &OtStack_coreResource);
+    OtRtosApi_unlock();
+
+    return error;
+}
+
+/* Documented in otstack.h */
+void OtStack_pollActivity(void)
+{
+    OtStack_pollWake = true;
+    Event_post(Event_handle(&OtStack_events), OT_STACK_EVENT_SIGNAL_POLL_PROCESS);
+}
+
+/* Documented in otstack.h */
+otError OtStack_setPollPolicy(const OtStack_PollPolicy *aPolicy)
+{
+    otError error = OT_ERROR_NONE;
+
+    OtRtosApi_lock();
+    otEXPECT_ACTION(aPolicy->fastPeriod >= OT_STACK_POLL_MIN_PERIOD &&
+                    aPolicy->fastPeriod <= aPolicy->slowPeriod &&
+                    aPolicy->fastWindow <= OT_STACK_POLL_MAX_WINDOW &&
+                    aPolicy->slowPeriod / 1000U <
+                    otThreadGetChildTimeout(OtStack_instance),
+                    error = OT_ERROR_INVALID_ARGS);
+
+    OtStack_pollPolicy = *aPolicy;
+    processPoll();
+
+exit:
+    OtRtosApi_unlock();
+    return error;
+}
+
+/* Documented in otstack.h */
+uint32_t OtStack_getPollPolicy(OtStack_PollPolicy *aPolicy)
+{
+    uint32_t period;
+
+    OtRtosApi_lock();
+    *aPolicy = OtStack_pollPolicy;
+    period = otLinkGetPollPeriod(OtStack_instance);
+    OtRtosApi_unlock();
+
+    return period;
+}
+
 /**
  * Documented in task_config.h.
  */
@@ -410,14 +861,47 @@ static void resetPriority(void)
     (void) ret;	
 }
 
+#if OT_STACK_SLEEPY
+/**
+ * @brief Sets the link to polling mode, at the slow period until there is
+ *        activity.
+ *
+ * @param OtStack_instance pointer to the otInstance
+ * @return None
+ */
+static void setLinkMode(otInstance *OtStack_instance)
+{
+    otLinkModeConfig linkMode = {0};
+
+    /* set the link mode rx_on_when_idle to off and device type to MTD.
+     * Also, set link mode to one requesting full network data and
+     * performing secured data request.
+     */
+    linkMode.mNetworkData = 1;
+    linkMode.mSecureDataRequests = 1;
+    otThreadSetLinkMode(OtStack_instance, linkMode);
+
+    otLinkSetPollPeriod(OtStack_instance, OtStack_pollPolicy.slowPeriod);
+}
+#endif /* OT_STACK_SLEEPY */
+
 /**
  * Main processing thread for OpenThread Stack.
  */
 void *OtStack_task(void *arg0)
 {
+    Clock_Params clockParams;
+
     /* Initialize the processing loop event structure */
     Event_construct(&OtStack_events, NULL);
 
+    /* Initialize the clock of the fast poll window */
+    Clock_Params_init(&clockParams);
+    clockParams.period    = 0;
+    clockParams.startFlag = FALSE;
+    Clock_construct(&OtStack_pollClockStruct, pollClockHandler, 1, &clockParams);
+    OtStack_pollClock = Clock_handle(&OtStack_pollClockStruct);
+
     /* Initialize the platform */
     PlatformInit(0, NULL);
 
@@ -426,6 +910,10 @@ void *OtStack_task(void *arg0)
     OtStack_instance = otInstanceInitSingle();
     assert(OtStack_instance);
 
+#if OT_STACK_SLEEPY
+    setLinkMode(OtStack_instance);
+#endif
+
 #if OPENTHREAD_ENABLE_DIAG
     otDiagInit(OtStack_instance);
 #endif
@@ -474,7 +962,8 @@ void *OtStack_task(void *arg0)
                              | OT_STACK_EVENT_SIGNAL_RADIO_PROCESS
                              | OT_STACK_EVENT_SIGNAL_TASLETS_PENDING
                              | OT_STACK_EVENT_SIGNAL_UART_PROCESS
-                             | OT_STACK_EVENT_SIGNAL_RANDOM_PROCESS),
+                             | OT_STACK_EVENT_SIGNAL_RANDOM_PROCESS
+                             | OT_STACK_EVENT_SIGNAL_POLL_PROCESS),
                             BIOS_WAIT_FOREVER);
 
         if (events & OT_STACK_EVENT_SIGNAL_ALARM_PROCESS)
@@ -518,6 +1007,13 @@ void *OtStack_task(void *arg0)
             OtRtosApi_unlock();
         }
 
+        if (events & OT_STACK_EVENT_SIGNAL_POLL_PROCESS)
+        {
+            OtRtosApi_lock();
+            processPoll();
+            OtRtosApi_unlock();
+        }
+
     }
 }
 
@@ -54,8 +54,13 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-/* POSIX Header files */
-#include <time.h>
+/* RTOS Header files */
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/sysbios/knl/Clock.h>
+
+/* Driverlib Header files */
+#include <ti/devices/DeviceFamily.h>
+#include DeviceFamily_constructPath(driverlib/aon_rtc.h)
 
 /* OpenThread public API Header files */
 #include <openthread/platform/alarm-milli.h>
@@ -63,39 +68,256 @@
 
 #include "platform.h"
 
+/******************************************************************************
+ Constants and definitions
+ *****************************************************************************/
+
+/**
+ * Longest the alarm clock is set for, in us. A deadline further out is
+ * reached in steps, the clock timeout is 32 bits of ticks.
+ */
+#ifndef PLATFORM_ALARM_MAX_SLEEP
+#define PLATFORM_ALARM_MAX_SLEEP    (3600U * 1000000U)
+#endif
+
+/**
+ * An alarm waiting in the deadline queue.
+ */
+typedef struct
+{
+    uint64_t deadline;      // us since the RTC was started
+    bool     queued;
+    void     (*signal)(void);
+} Alarm_Entry;
+
 /******************************************************************************
  Local variables
  *****************************************************************************/
 
 static uint32_t Alarm_time0   = 0;
 static uint32_t Alarm_time    = 0;
-static timer_t  Alarm_timerid = 0;
 static bool     Alarm_running = false;
 
+/* One clock for the ms and us alarms, set for the earliest deadline */
+static Clock_Struct Alarm_clockStruct;
+static Clock_Handle Alarm_clock;
+static uint64_t     Alarm_clockDeadline;
+
+static Alarm_Entry Alarm_queue[PlatformAlarm_count] =
+{
+    [PlatformAlarm_milli] = { .signal = platformAlarmSignal },
+    [PlatformAlarm_micro] = { .signal = platformAlarmMicroSignal },
+};
+
+static PlatformAlarm_Stats Alarm_stats;
+
+/******************************************************************************
+ Local Functions
+ *****************************************************************************/
+
+/**
+ * @brief Reads the always-on RTC.
+ *
+ * @return Seconds in the upper 32 bits, fraction of a second in the lower.
+ */
+static inline uint64_t Alarm_rtcGet(void)
+{
+    return (AONRTCCurrent64BitValueGet());
+}
+
 /**
- * Handler for the POSIX clock callback.
+ * @brief Converts an RTC value to ms. Truncated to 32 bits, it wraps as
+ *        otPlatAlarmMilliGetNow() should.
+ *
+ * @param aRtc value of the RTC
+ *
+ * @return ms since the RTC was started
  */
-void Alarm_handler(union sigval val)
+static inline uint64_t Alarm_rtcToMs(uint64_t aRtc)
 {
-    (void)val;
-    platformAlarmSignal();
+    uint32_t sec  = (uint32_t)(aRtc >> 32);
+    uint32_t frac = (uint32_t)aRtc;
+
+    return (((uint64_t)sec * 1000U) + (((uint64_t)frac * 1000U) >> 32));
+}
+
+/**
+ * @brief Converts an RTC value to us.
+ *
+ * @param aRtc value of the RTC
+ *
+ * @return us since the RTC was started
+ */
+static inline uint64_t Alarm_rtcToUs(uint64_t aRtc)
+{
+    uint32_t sec  = (uint32_t)(aRtc >> 32);
+    uint32_t frac = (uint32_t)aRtc;
+
+    return (((uint64_t)sec * 1000000U) + (((uint64_t)frac * 1000000U) >> 32));
+}
+
+/**
+ * @brief Signals the alarms that are due and sets the clock for the earliest
+ *        of the others. Called with interrupts disabled.
+ *
+ * @param aNow   current time in us
+ * @param aClock true when called from the clock
+ *
+ * @return None
+ */
+static void Alarm_schedule(uint64_t aNow, bool aClock)
+{
+    uint64_t next = UINT64_MAX;
+    uint32_t wait;
+    unsigned i;
+
+    for (i = 0; i < PlatformAlarm_count; i++)
+    {
+        Alarm_Entry *entry = &Alarm_queue[i];
+
+        if (!entry->queued)
+        {
+            continue;
+        }
+        if (entry->deadline <= aNow)
+        {
+            if (aClock)
+            {
+                uint32_t late = (uint32_t)(aNow - entry->deadline);
+
+                Alarm_stats.fired++;
+                Alarm_stats.lateTotal += late;
+                if (late > Alarm_stats.lateMax)
+                {
+                    Alarm_stats.lateMax = late;
+                }
+            }
+            entry->queued = false;
+            entry->signal();
+        }
+        else if (entry->deadline < next)
+        {
+            next = entry->deadline;
+        }
+    }
+
+    if (next == UINT64_MAX)
+    {
+        Clock_stop(Alarm_clock);
+        return;
+    }
+    if (next == Alarm_clockDeadline && Clock_isActive(Alarm_clock))
+    {
+        return;
+    }
+
+    wait = (next - aNow > PLATFORM_ALARM_MAX_SLEEP) ? PLATFORM_ALARM_MAX_SLEEP
+                                                    : (uint32_t)(next - aNow);
+
+    /*
+     * The clock counts from the current tick, which started up to a tick
+     * ago, so one more tick keeps it from expiring before the deadline.
+     */
+    Clock_stop(Alarm_clock);
+    Clock_setTimeout(Alarm_clock,
+                     ((wait + Clock_tickPeriod - 1) / Clock_tickPeriod) + 1);
+    Clock_start(Alarm_clock);
+
+    Alarm_clockDeadline = next;
+    Alarm_stats.clockSets++;
 }
 
+/**
+ * Handler for the alarm clock.
+ */
+static void Alarm_clockHandler(UArg arg)
+{
+    uint64_t  now = Alarm_rtcToUs(Alarm_rtcGet());
+    uintptr_t key;
+
+    (void)arg;
+
+    key = HwiP_disable();
+
+    Alarm_stats.wakeups++;
+    if (now < Alarm_clockDeadline)
+    {
+        /* A step of a long sleep */
+        Alarm_stats.early++;
+    }
+    Alarm_schedule(now, true);
+
+    HwiP_restore(key);
+}
+
+/******************************************************************************
+ External Functions
+ *****************************************************************************/
+
 /**
  * Function documented in platform.h
  */
-void platformAlarmInit(void)
+uint64_t platformAlarmGetNowUs(void)
+{
+    return (Alarm_rtcToUs(Alarm_rtcGet()));
+}
+
+/**
+ * Function documented in platform.h
+ */
+void platformAlarmQueueStart(PlatformAlarm_Id aId, uint64_t aDeadline)
+{
+    uintptr_t key = HwiP_disable();
+
+    Alarm_queue[aId].deadline = aDeadline;
+    Alarm_queue[aId].queued   = true;
+    Alarm_schedule(platformAlarmGetNowUs(), false);
+
+    HwiP_restore(key);
+}
+
+/**
+ * Function documented in platform.h
+ */
+void platformAlarmQueueStop(PlatformAlarm_Id aId)
 {
-    struct timespec zeroTime = {0};
-    struct sigevent event =
+    uintptr_t key = HwiP_disable();
+
+    if (Alarm_queue[aId].queued)
     {
-        .sigev_notify_function = Alarm_handler,
-        .sigev_notify = SIGEV_SIGNAL,
-    };
+        Alarm_queue[aId].queued = false;
+        Alarm_schedule(platformAlarmGetNowUs(), false);
+    }
+
+    HwiP_restore(key);
+}
+
+/**
+ * Function documented in platform.h
+ */
+void platformAlarmGetStats(PlatformAlarm_Stats *aStats)
+{
+    uint64_t  now = platformAlarmGetNowUs();
+    uintptr_t key = HwiP_disable();
 
-    clock_settime(CLOCK_MONOTONIC, &zeroTime);
+    *aStats = Alarm_stats;
+    aStats->uptime = (uint32_t)(now / 1000000U);
 
-    timer_create(CLOCK_MONOTONIC, &event, &Alarm_timerid);
+    HwiP_restore(key);
+}
+
+/**
+ * Function documented in platform.h
+ */
+void platformAlarmInit(void)
+{
+    Clock_Params clockParams;
+
+    Clock_Params_init(&clockParams);
+    clockParams.period    = 0;
+    clockParams.startFlag = FALSE;
+    Clock_construct(&Alarm_clockStruct, Alarm_clockHandler, 1, &clockParams);
+    Alarm_clock = Clock_handle(&Alarm_clockStruct);
 
     Alarm_running = false;
 }
@@ -105,11 +327,7 @@ void platformAlarmInit(void)
  */
 uint32_t otPlatAlarmMilliGetNow(void)
 {
-    struct timespec now;
-
-    clock_gettime(CLOCK_MONOTONIC, &now);
-
-    return (now.tv_sec * 1000U) + ((now.tv_nsec / 1000000U) % 1000);
+    return ((uint32_t)Alarm_rtcToMs(Alarm_rtcGet()));
 }
 
 /**
@@ -118,8 +336,8 @@ uint32_t otPlatAlarmMilliGetNow(void)
 void otPlatAlarmMilliStartAt(otInstance *aInstance, uint32_t aT0, uint32_t aDt)
 {
     (void)aInstance;
-    struct itimerspec timerspec = {0};
-    uint32_t          delta     = (otPlatAlarmMilliGetNow() - aT0);
+    uint64_t now   = Alarm_rtcToMs(Alarm_rtcGet());
+    uint32_t delta = ((uint32_t)now - aT0);
 
     Alarm_time0   = aT0;
     Alarm_time    = aDt;
@@ -128,14 +346,14 @@ void otPlatAlarmMilliStartAt(otInstance *aInstance, uint32_t aT0, uint32_t aDt)
     if (delta >= aDt)
     {
         // alarm is in the past
+        platformAlarmQueueStop(PlatformAlarm_milli);
         platformAlarmSignal();
     }
     else
     {
-        timerspec.it_value.tv_sec  = ((aDt - delta) / 1000U);
-        timerspec.it_value.tv_nsec = (((aDt - delta) % 1000U) * 1000000U);
-
-        timer_settime(Alarm_timerid, 0, &timerspec, NULL);
+        /* Due when the ms count reaches aT0 + aDt, not aDt from now */
+        platformAlarmQueueStart(PlatformAlarm_milli,
+                                (now + (aDt - delta)) * 1000U);
     }
 }
 
@@ -145,9 +363,8 @@ void otPlatAlarmMilliStartAt(otInstance *aInstance, uint32_t aT0, uint32_t aDt)
 void otPlatAlarmMilliStop(otInstance *aInstance)
 {
     (void)aInstance;
-    struct itimerspec zeroTime = {0};
 
-    timer_settime(Alarm_timerid, TIMER_ABSTIME, &zeroTime, NULL);
+    platformAlarmQueueStop(PlatformAlarm_milli);
     Alarm_running = false;
 }
 
@@ -175,16 +392,5 @@ void platformAlarmProcess(otInstance *aInstance)
                 otPlatAlarmMilliFired(aInstance);
             }
         }
-        else
-        {
-            struct itimerspec timerspec = {0};
-
-            timer_gettime(Alarm_timerid, &timerspec);
-            if (0U == timerspec.it_value.tv_sec && 0U == timerspec.it_value.tv_nsec)
-            {
-                /* Timer fired a bit early, notify we still need processing. */
-                platformAlarmSignal();
-            }
-        }
     }
 }
@@ -58,6 +58,18 @@
 #include <ti/drivers/AESECB.h>
 #include <ti/drivers/cryptoutils/cryptokey/CryptoKeyPlaintext.h>
 
+/**
+ * Keep the driver open once the first context is initialized. The stack
+ * secures each MAC frame with a context of its own, opening the driver for
+ * every frame costs more than the block it runs. Set to 0 to power the
+ * crypto core off between contexts. The sleepy light sensor and reed sensor
+ * projects define it to 0: an open driver holds its power dependency on the
+ * crypto core for as long as the image runs.
+ */
+#ifndef AES_ALT_KEEP_OPEN
+#define AES_ALT_KEEP_OPEN 1
+#endif
+
 /**
  * number of active contexts, used for power on/off of the crypto core
  */
@@ -75,7 +87,7 @@ void mbedtls_aes_init(mbedtls_aes_context *ctx)
 {
     AESECB_Params AESECBParams;
 
-    if (ref_num++ == 0)
+    if (ref_num++ == 0 && AESECB_handle == NULL)
     {
         AESECB_Params_init(&AESECBParams);
         AESECBParams.returnBehavior = AESECB_RETURN_BEHAVIOR_POLLING;
@@ -91,7 +103,7 @@ void mbedtls_aes_init(mbedtls_aes_context *ctx)
  */
 void mbedtls_aes_free(mbedtls_aes_context *ctx)
 {
-    if (--ref_num == 0)
+    if (--ref_num == 0 && !AES_ALT_KEEP_OPEN)
     {
         AESECB_close(AESECB_handle);
 
@@ -60,6 +60,7 @@
 #include <common/logging.hpp>
 #include <utils/code_utils.h>
 
+#include "platform.h"
 #include "radio.h"
 
 /**
@@ -80,6 +81,17 @@
  */
 #define PLAT_DIAG_TX_PACKETSIZE   30
 
+/**
+ * Default number of frames timed by the crypto bench, per payload and path.
+ */
+#define PLAT_DIAG_CRYPTO_FRAMES   100
+
+/**
+ * MAC header and largest payload of the frames timed by the crypto bench.
+ */
+#define PLAT_DIAG_CRYPTO_HEADER       23
+#define PLAT_DIAG_CRYPTO_PAYLOAD_MAX  100
+
 /**
  * Diagnostics mode variables.
  */
@@ -417,6 +429,418 @@ exit:
     return retval;
 }
 
+/**
+ * Diagnostic function to print the uart transport counters.
+ *
+ * @param[in]  aInstance        OpenThread instance structure.
+ * @param[in]  argc             Count of command arguments.
+ * @param[in]  argv             Array of command arguments.
+ * @param[out] aOutput          Output buffer used for user interaction.
+ * @param[in]  aOutputMaxLen    Size of the Output buffer.
+ *
+ * @return Error value from parsing or executing the command.
+ */
+otError PlatDiag_processUart(otInstance *aInstance, int argc, char *argv[],
+                             char *aOutput, size_t aOutputMaxLen)
+{
+    otError retval = OT_ERROR_INVALID_ARGS;
+
+    (void)aInstance;
+    (void)argv;
+
+    if (argc == 0)
+    {
+        PlatformUart_Stats stats;
+
+        platformUartGetStats(&stats);
+        retval = OT_ERROR_NONE;
+
+        snprintf(aOutput, aOutputMaxLen,
+                 "rx bytes: %lu\r\n"
+                 "tx bytes: %lu\r\n"
+                 "rx overruns: %lu\r\n"
+                 "rx errors: %lu\r\n"
+                 "rx stalls: %lu\r\n"
+                 "tx partial: %lu\r\n"
+                 "rx high water: %u\r\n"
+                 "tx high water: %u\r\n"
+                 "status 0x%02x\r\n",
+                 (unsigned long)stats.rxBytes, (unsigned long)stats.txBytes,
+                 (unsigned long)stats.rxOverruns,
+                 (unsigned long)stats.rxErrors,
+                 (unsigned long)stats.rxStalls,
+                 (unsigned long)stats.txPartial, stats.rxHighWater,
+                 stats.txHighWater, retval);
+    }
+
+    return retval;
+}
+
+/**
+ * Diagnostic function to print the alarm counters.
+ *
+ * @param[in]  aInstance        OpenThread instance structure.
+ * @param[in]  argc             Count of command arguments.
+ * @param[in]  argv             Array of command arguments.
+ * @param[out] aOutput          Output buffer used for user interaction.
+ * @param[in]  aOutputMaxLen    Size of the Output buffer.
+ *
+ * @return Error value from parsing or executing the command.
+ */
+otError PlatDiag_processAlarm(otInstance *aInstance, int argc, char *argv[],
+                              char *aOutput, size_t aOutputMaxLen)
+{
+    otError retval = OT_ERROR_INVALID_ARGS;
+
+    (void)aInstance;
+    (void)argv;
+
+    if (argc == 0)
+    {
+        PlatformAlarm_Stats stats;
+        unsigned long       perHour = 0;
+        unsigned long       lateMean = 0;
+
+        platformAlarmGetStats(&stats);
+        retval = OT_ERROR_NONE;
+
+        if (stats.uptime != 0)
+        {
+            perHour = (unsigned long)(((uint64_t)stats.wakeups * 3600U) /
+                                      stats.uptime);
+        }
+        if (stats.fired != 0)
+        {
+            lateMean = (unsigned long)(stats.lateTotal / stats.fired);
+        }
+
+        snprintf(aOutput, aOutputMaxLen,
+                 "uptime: %lu\r\n"
+                 "wakeups: %lu\r\n"
+                 "wakeups per hour: %lu\r\n"
+                 "early: %lu\r\n"
+                 "fired: %lu\r\n"
+                 "clock sets: %lu\r\n"
+                 "late mean us: %lu\r\n"
+                 "late max us: %lu\r\n"
+                 "status 0x%02x\r\n",
+                 (unsigned long)stats.uptime, (unsigned long)stats.wakeups,
+                 perHour, (unsigned long)stats.early,
+                 (unsigned long)stats.fired, (unsigned long)stats.clockSets,
+                 lateMean, (unsigned long)stats.lateMax, retval);
+    }
+
+    return retval;
+}
+
+/**
+ * Diagnostic function to print the random number counters.
+ *
+ * @param[in]  aInstance        OpenThread instance structure.
+ * @param[in]  argc             Count of command arguments.
+ * @param[in]  argv             Array of command arguments.
+ * @param[out] aOutput          Output buffer used for user interaction.
+ * @param[in]  aOutputMaxLen    Size of the Output buffer.
+ *
+ * @return Error value from parsing or executing the command.
+ */
+otError PlatDiag_processRandom(otInstance *aInstance, int argc, char *argv[],
+                               char *aOutput, size_t aOutputMaxLen)
+{
+    otError retval = OT_ERROR_INVALID_ARGS;
+
+    (void)aInstance;
+    (void)argv;
+
+    if (argc == 0)
+    {
+        PlatformRandom_Stats stats;
+
+        platformRandomGetStats(&stats);
+        retval = OT_ERROR_NONE;
+
+        snprintf(aOutput, aOutputMaxLen,
+                 "requests: %lu\r\n"
+                 "reseeds: %lu\r\n"
+                 "entropy bytes: %lu\r\n"
+                 "pool: %lu\r\n"
+                 "waits: %lu\r\n"
+                 "trng errors: %lu\r\n"
+                 "status 0x%02x\r\n",
+                 (unsigned long)stats.requests, (unsigned long)stats.reseeds,
+                 (unsigned long)stats.entropyBytes,
+                 (unsigned long)stats.poolCount, (unsigned long)stats.waits,
+                 (unsigned long)stats.trngErrors, retval);
+    }
+
+    return retval;
+}
+
+/**
+ * Diagnostic function to print or clear the energy counters.
+ *
+ * @param[in]  aInstance        OpenThread instance structure.
+ * @param[in]  argc             Count of command arguments.
+ * @param[in]  argv             Array of command arguments.
+ * @param[out] aOutput          Output buffer used for user interaction.
+ * @param[in]  aOutputMaxLen    Size of the Output buffer.
+ *
+ * @return Error value from parsing or executing the command.
+ */
+otError PlatDiag_processEnergy(otInstance *aInstance, int argc, char *argv[],
+                               char *aOutput, size_t aOutputMaxLen)
+{
+    otError retval = OT_ERROR_INVALID_ARGS;
+
+    (void)aInstance;
+
+    if (argc == 0)
+    {
+        PlatformEnergy_Stats stats;
+
+        platformEnergyGetStats(&stats);
+        retval = OT_ERROR_NONE;
+
+        snprintf(aOutput, aOutputMaxLen,
+                 "rx ms: %lu\r\n"
+                 "tx ms: %lu\r\n"
+                 "active ms: %lu\r\n"
+                 "idle ms: %lu\r\n"
+                 "standby ms: %lu\r\n"
+                 "charge uC: %lu\r\n"
+                 "average nA: %lu\r\n"
+                 "tx frames: %lu\r\n"
+                 "radio starts: %lu\r\n"
+                 "status 0x%02x\r\n",
+                 (unsigned long)stats.ms[PlatformEnergy_rx],
+                 (unsigned long)stats.ms[PlatformEnergy_tx],
+                 (unsigned long)stats.ms[PlatformEnergy_active],
+                 (unsigned long)stats.ms[PlatformEnergy_idle],
+                 (unsigned long)stats.ms[PlatformEnergy_standby],
+                 (unsigned long)stats.chargeUc,
+                 (unsigned long)stats.averageNa,
+                 (unsigned long)stats.txFrames,
+                 (unsigned long)stats.radioStarts, retval);
+    }
+    else if (argc == 1 && strcmp(argv[0], "clear") == 0)
+    {
+        platformEnergyClear();
+        retval = OT_ERROR_NONE;
+
+        snprintf(aOutput, aOutputMaxLen, "status 0x%02x\r\n", retval);
+    }
+
+    return retval;
+}
+
+/**
+ * Times AES-CCM* of a frame on a path, restoring the frame before each run.
+ *
+ * @param[in]  aPayloadLength   Length of the payload to secure.
+ * @param[in]  aPath            Path to run the frames on.
+ * @param[in]  aFrames          Number of frames to time.
+ * @param[out] aEncryptUs       us per frame to encrypt.
+ * @param[out] aDecryptUs       us per frame to decrypt.
+ *
+ * @return Error value from the first frame that failed.
+ */
+static otError PlatDiag_benchCrypto(uint16_t aPayloadLength,
+                                    PlatformAesCcm_Path aPath, long aFrames,
+                                    unsigned long *aEncryptUs,
+                                    unsigned long *aDecryptUs)
+{
+    static const uint8_t key[16] = {
+        0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+        0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf
+    };
+    static const uint8_t nonce[13] = {
+        0xac, 0xde, 0x48, 0x00, 0x00, 0x00, 0x00, 0x01,
+        0x00, 0x00, 0x00, 0x05, 0x05
+    };
+    static uint8_t header[PLAT_DIAG_CRYPTO_HEADER];
+    static uint8_t plain[PLAT_DIAG_CRYPTO_PAYLOAD_MAX];
+    static uint8_t secured[PLAT_DIAG_CRYPTO_PAYLOAD_MAX + 4];
+    PlatformAesCcm_Frame frame;
+    otError retval = OT_ERROR_NONE;
+    uint64_t start;
+    long i;
+
+    for (i = 0; i < (long)sizeof(plain); i++)
+    {
+        plain[i] = (uint8_t)i;
+    }
+    memset(header, 0x41, sizeof(header));
+
+    frame.key           = key;
+    frame.nonce         = nonce;
+    frame.header        = header;
+    frame.headerLength  = sizeof(header);
+    frame.payload       = secured;
+    frame.payloadLength = aPayloadLength;
+    frame.tag           = &secured[aPayloadLength];
+    frame.tagLength     = 4;
+
+    start = platformAlarmGetNowUs();
+    for (i = 0; i < aFrames && retval == OT_ERROR_NONE; i++)
+    {
+        memcpy(secured, plain, aPayloadLength);
+        retval = platformAesCcmEncrypt(&frame, aPath);
+    }
+    *aEncryptUs = (unsigned long)((platformAlarmGetNowUs() - start) / aFrames);
+    otEXPECT(retval == OT_ERROR_NONE);
+
+    // secured holds the encrypted frame and its MIC, kept in plain
+    memcpy(plain, secured, aPayloadLength + frame.tagLength);
+
+    start = platformAlarmGetNowUs();
+    for (i = 0; i < aFrames && retval == OT_ERROR_NONE; i++)
+    {
+        memcpy(secured, plain, aPayloadLength + frame.tagLength);
+        retval = platformAesCcmDecrypt(&frame, aPath);
+    }
+    *aDecryptUs = (unsigned long)((platformAlarmGetNowUs() - start) / aFrames);
+
+exit:
+    return retval;
+}
+
+/**
+ * Diagnostic function to print the AES-CCM* counters, or to time securing
+ * MAC frames on the accelerator and one block at a time.
+ *
+ * @param[in]  aInstance        OpenThread instance structure.
+ * @param[in]  argc             Count of command arguments.
+ * @param[in]  argv             Array of command arguments.
+ * @param[out] aOutput          Output buffer used for user interaction.
+ * @param[in]  aOutputMaxLen    Size of the Output buffer.
+ *
+ * @return Error value from parsing or executing the command.
+ */
+otError PlatDiag_processCrypto(otInstance *aInstance, int argc, char *argv[],
+                               char *aOutput, size_t aOutputMaxLen)
+{
+    static const uint16_t payloadLengths[] = {
+        16, 64, PLAT_DIAG_CRYPTO_PAYLOAD_MAX
+    };
+    otError retval = OT_ERROR_INVALID_ARGS;
+
+    (void)aInstance;
+
+    if (argc == 0)
+    {
+        PlatformAesCcm_Stats stats;
+
+        platformAesCcmGetStats(&stats);
+        retval = OT_ERROR_NONE;
+
+        snprintf(aOutput, aOutputMaxLen,
+                 "jobs: %lu\r\n"
+                 "per block: %lu\r\n"
+                 "fallbacks: %lu\r\n"
+                 "mic failures: %lu\r\n"
+                 "status 0x%02x\r\n",
+                 (unsigned long)stats.jobs, (unsigned long)stats.perBlock,
+                 (unsigned long)stats.fallbacks,
+                 (unsigned long)stats.micFailures, retval);
+    }
+    else if (strcmp(argv[0], "bench") == 0 && argc <= 2)
+    {
+        long   frames = PLAT_DIAG_CRYPTO_FRAMES;
+        size_t len    = 0;
+        size_t i;
+
+        retval = OT_ERROR_NONE;
+        if (argc == 2)
+        {
+            retval = PlatDiag_parseLong(argv[1], &frames);
+            otEXPECT(retval == OT_ERROR_NONE);
+            otEXPECT_ACTION(frames > 0 && frames <= 10000,
+                            retval = OT_ERROR_INVALID_ARGS);
+        }
+
+        len += snprintf(aOutput, aOutputMaxLen,
+                        "us per frame, enc/dec job block\r\n");
+        for (i = 0; i < sizeof(payloadLengths) / sizeof(payloadLengths[0]); i++)
+        {
+            unsigned long jobEnc, jobDec, blockEnc, blockDec;
+
+            retval = PlatDiag_benchCrypto(payloadLengths[i],
+                                          PlatformAesCcm_auto, frames,
+                                          &jobEnc, &jobDec);
+            otEXPECT(retval == OT_ERROR_NONE);
+            retval = PlatDiag_benchCrypto(payloadLengths[i],
+                                          PlatformAesCcm_perBlock, frames,
+                                          &blockEnc, &blockDec);
+            otEXPECT(retval == OT_ERROR_NONE);
+
+            if (len < aOutputMaxLen)
+            {
+                len += snprintf(aOutput + len, aOutputMaxLen - len,
+                                "%3u B: %lu/%lu %lu/%lu\r\n",
+                                payloadLengths[i], jobEnc, jobDec, blockEnc,
+                                blockDec);
+            }
+        }
+        if (len < aOutputMaxLen)
+        {
+            snprintf(aOutput + len, aOutputMaxLen - len,
+                     "status 0x%02x\r\n", retval);
+        }
+    }
+
+exit:
+    return retval;
+}
+
+#if OPENTHREAD_ENABLE_NCP_SPI
+/**
+ * Diagnostic function to print the spi transport counters.
+ *
+ * @param[in]  aInstance        OpenThread instance structure.
+ * @param[in]  argc             Count of command arguments.
+ * @param[in]  argv             Array of command arguments.
+ * @param[out] aOutput          Output buffer used for user interaction.
+ * @param[in]  aOutputMaxLen    Size of the Output buffer.
+ *
+ * @return Error value from parsing or executing the command.
+ */
+otError PlatDiag_processSpi(otInstance *aInstance, int argc, char *argv[],
+                            char *aOutput, size_t aOutputMaxLen)
+{
+    otError retval = OT_ERROR_INVALID_ARGS;
+
+    (void)aInstance;
+    (void)argv;
+
+    if (argc == 0)
+    {
+        PlatformSpi_Stats stats;
+
+        platformSpiGetStats(&stats);
+        retval = OT_ERROR_NONE;
+
+        snprintf(aOutput, aOutputMaxLen,
+                 "transactions: %lu\r\n"
+                 "host ints: %lu\r\n"
+                 "crc errors: %lu\r\n"
+                 "rx short: %lu\r\n"
+                 "tx short: %lu\r\n"
+                 "busy: %lu\r\n"
+                 "failed: %lu\r\n"
+                 "max length: %u\r\n"
+                 "status 0x%02x\r\n",
+                 (unsigned long)stats.transactions,
+                 (unsigned long)stats.hostInts,
+                 (unsigned long)stats.crcErrors,
+                 (unsigned long)stats.rxShort, (unsigned long)stats.txShort,
+                 (unsigned long)stats.busy, (unsigned long)stats.failed,
+                 stats.maxLength, retval);
+    }
+
+    return retval;
+}
+#endif
+
 /**
  * Documented in <openthread/platform/diag.h>
  */
@@ -451,6 +875,44 @@ void otPlatDiagProcess(otInstance *aInstance, int argc, char *argv[],
                                  (argc > 1) ? &argv[1] : NULL, aOutput,
                                  aOutputMaxLen);
         }
+        else if (strcmp(argv[0], "uart") == 0)
+        {
+            retval = PlatDiag_processUart(aInstance, argc - 1,
+                                 (argc > 1) ? &argv[1] : NULL, aOutput,
+                                 aOutputMaxLen);
+        }
+        else if (strcmp(argv[0], "alarm") == 0)
+        {
+            retval = PlatDiag_processAlarm(aInstance, argc - 1,
+                                 (argc > 1) ? &argv[1] : NULL, aOutput,
+                                 aOutputMaxLen);
+        }
+        else if (strcmp(argv[0], "random") == 0)
+        {
+            retval = PlatDiag_processRandom(aInstance, argc - 1,
+                                 (argc > 1) ? &argv[1] : NULL, aOutput,
+                                 aOutputMaxLen);
+        }
+        else if (strcmp(argv[0], "energy") == 0)
+        {
+            retval = PlatDiag_processEnergy(aInstance, argc - 1,
+                                 (argc > 1) ? &argv[1] : NULL, aOutput,
+                                 aOutputMaxLen);
+        }
+        else if (strcmp(argv[0], "crypto") == 0)
+        {
+            retval = PlatDiag_processCrypto(aInstance, argc - 1,
+                                 (argc > 1) ? &argv[1] : NULL, aOutput,
+                                 aOutputMaxLen);
+        }
+#if OPENTHREAD_ENABLE_NCP_SPI
+        else if (strcmp(argv[0], "spi") == 0)
+        {
+            retval = PlatDiag_processSpi(aInstance, argc - 1,
+                                 (argc > 1) ? &argv[1] : NULL, aOutput,
+                                 aOutputMaxLen);
+        }
+#endif
         else
         {
             snprintf(aOutput, aOutputMaxLen,
@@ -71,12 +71,24 @@
  * Note that the order of NV items on the page may change on any write
  * operation as allowed by the settings.h API. This means that setting order is
  * unreliable after a write operation.
+ *
+ * When the NVOCTP RAM index is available, the Nth setting of a key is looked
+ * up in RAM in ascending sub ID order instead of with doNext(). Get and Delete
+ * both go through findSubId() so they always agree on the order.
+ *
+ * Page compaction is done by a low priority task a few items at a time, so
+ * that settings writes from the OpenThread task do not stall on it. NVOCTP
+ * wakes the task when the active page runs low on free space.
  */
 
 #include <stdlib.h>
 #include <stddef.h>
 #include <assert.h>
 
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+
 #include <openthread-core-config.h>
 #include <openthread/platform/settings.h>
 
@@ -86,12 +98,212 @@
 /* CONSTANTS AND MACROS */
 #define SUBIDMAX    ((2 << 10) - 1)
 
+/* Background compaction task, set to 0 to compact on the write path only */
+#ifndef SETTINGS_COMPACT_TASK
+#define SETTINGS_COMPACT_TASK   1
+#endif
+
+#ifndef SETTINGS_COMPACT_TASK_STACK_SIZE
+#define SETTINGS_COMPACT_TASK_STACK_SIZE    1024
+#endif
+
 /* Static local variables */
 static NVINTF_nvFuncts_t sNvoctpFps = { 0 };
 
+#if SETTINGS_COMPACT_TASK
+static sem_t sCompactSem;
+static char sCompactStack[SETTINGS_COMPACT_TASK_STACK_SIZE];
+#endif
+
+/* Local functions */
+
+/* Finds the sub ID of the nth setting of aKey */
+static uint8_t findSubId(uint16_t aKey, int aIndex, uint16_t *aSubId)
+{
+    uint8_t status;
+    int count = 0;
+    NVINTF_nvProxy_t nvProxy = {0};
+
+    /* Ask the NVOCTP RAM index first, no page traversal needed */
+    status = NVOCTP_getNthSubId(NVINTF_SYSID_TIOP, aKey, (uint16_t)aIndex,
+                                aSubId);
+    if (NVINTF_NOTREADY != status)
+    {
+        return(status);
+    }
+
+    /* doNext search for nth item */
+    status         = NVINTF_SUCCESS;
+    nvProxy.sysid  = NVINTF_SYSID_TIOP;
+    nvProxy.itemid = aKey;
+    nvProxy.flag   = NVINTF_DOSTART | NVINTF_DOITMID | NVINTF_DOFIND;
+
+    /* Lock and call doNext to find nth item of "aKey" */
+    intptr_t key = sNvoctpFps.lockNV();
+    while(!status && (count <= aIndex))
+    {
+        status = sNvoctpFps.doNext(&nvProxy);
+        count++;
+    }
+    sNvoctpFps.unlockNV(key);
+
+    *aSubId = nvProxy.subid;
+
+    return(status);
+}
+
+/* Finds a sub ID of aKey that is not in use */
+static uint8_t findFreeSubId(uint16_t aKey, uint16_t *aSubId)
+{
+    NVINTF_itemID_t nvID;
+    NVINTF_nvProxy_t nvProxy = {0};
+    uint8_t status           = NVINTF_SUCCESS;
+    uint32_t itemLen         = 1;
+    uint16_t maxSubId        = 0;
+    uint16_t minSubId        = 0;
+
+    /* Ask the NVOCTP RAM index first, no page traversal needed */
+    status = NVOCTP_getFreeSubId(NVINTF_SYSID_TIOP, aKey, aSubId);
+    if (NVINTF_NOTREADY != status)
+    {
+        return(status);
+    }
+
+    /* Setup doNext call */
+    status         = NVINTF_SUCCESS;
+    nvProxy.sysid  = NVINTF_SYSID_TIOP;
+    nvProxy.itemid = aKey;
+    nvProxy.subid  = 0;
+    nvProxy.flag   = NVINTF_DOSTART | NVINTF_DOITMID | NVINTF_DOFIND;
+
+    /* Lock and call doNext to iterate through all items of itemID "aKey" */
+    /* Store min/max of sub id's found */
+    intptr_t key = sNvoctpFps.lockNV();
+    while(!status)
+    {
+        status    = sNvoctpFps.doNext(&nvProxy);
+        maxSubId  = (nvProxy.subid > maxSubId ? nvProxy.subid : maxSubId);
+        minSubId  = (nvProxy.subid < minSubId ? nvProxy.subid : minSubId);
+    }
+    sNvoctpFps.unlockNV(key);
+
+    /* Populate item ID */
+    nvID.systemID = NVINTF_SYSID_TIOP;
+    nvID.itemID   = aKey;
+
+    /* Look for an unused subid */
+    uint16_t count = 0;
+    bool looking   = TRUE;
+    while(looking && (count < SUBIDMAX))
+    {
+        if (maxSubId < SUBIDMAX)
+        {
+            nvID.subID = ++maxSubId;
+            itemLen    = sNvoctpFps.getItemLen(nvID);
+            if (!itemLen)
+            {
+                looking = false;
+            }
+        }
+        else
+        {
+            maxSubId = 0;
+        }
+        if (minSubId > 0 && looking)
+        {
+            nvID.subID = --minSubId;
+            itemLen    = sNvoctpFps.getItemLen(nvID);
+            if (!itemLen)
+            {
+                looking = false;
+            }
+        }
+        else
+        {
+            minSubId = SUBIDMAX;
+        }
+        count++;
+    }
+
+    *aSubId = nvID.subID;
+
+    return(itemLen ? NVINTF_BADSUBID : NVINTF_SUCCESS);
+}
+
+#if SETTINGS_COMPACT_TASK
+/* Called by NVOCTP with the NV lock held when compaction work is pending */
+static void compactNotify(void)
+{
+    sem_post(&sCompactSem);
+}
+
+/* Compacts the NV page one step at a time, below every other task */
+static void *compactTask(void *arg)
+{
+    (void)arg;
+
+    while (1)
+    {
+        sem_wait(&sCompactSem);
+
+        while (NVOCTP_compactStep())
+        {
+        }
+    }
+}
+
+/* Creates the compaction task once, before NVOCTP is initialized */
+static void compactTaskCreate(void)
+{
+    static bool created = false;
+    pthread_t           thread;
+    pthread_attr_t      pAttrs;
+    struct sched_param  priParam;
+    int                 retc;
+
+    if (created)
+    {
+        return;
+    }
+    created = true;
+
+    retc = sem_init(&sCompactSem, 0, 0);
+    assert(retc == 0);
+
+    retc = pthread_attr_init(&pAttrs);
+    assert(retc == 0);
+
+    retc = pthread_attr_setdetachstate(&pAttrs, PTHREAD_CREATE_DETACHED);
+    assert(retc == 0);
+
+    priParam.sched_priority = sched_get_priority_min(SCHED_OTHER);
+    retc = pthread_attr_setschedparam(&pAttrs, &priParam);
+    assert(retc == 0);
+
+    retc = pthread_attr_setstack(&pAttrs, (void *)sCompactStack,
+                                 SETTINGS_COMPACT_TASK_STACK_SIZE);
+    assert(retc == 0);
+
+    retc = pthread_create(&thread, &pAttrs, compactTask, NULL);
+    assert(retc == 0);
+
+    retc = pthread_attr_destroy(&pAttrs);
+    assert(retc == 0);
+
+    (void) retc;
+
+    NVOCTP_setCompactNotify((void *)compactNotify);
+}
+#endif
+
 /* settings API */
 void otPlatSettingsInit(otInstance *aInstance)
 {
+#if SETTINGS_COMPACT_TASK
+    /* Compaction notify must be in place to resume an interrupted compaction */
+    compactTaskCreate();
+#endif
+
     /* Load NVOCTP function pointers, extended API */
     NVOCTP_loadApiPtrsExt(&sNvoctpFps);
 
@@ -118,25 +330,13 @@ otError otPlatSettingsGet(otInstance *aInstance, uint16_t aKey, int aIndex,
                           uint8_t *aValue, uint16_t *aValueLength)
 {
     NVINTF_itemID_t nvID;
-    uint8_t status = NVINTF_SUCCESS;
-    uint16_t count = 0;
+    uint8_t status;
+    uint16_t subId;
     otError error  = OT_ERROR_NOT_FOUND;
     uint32_t itemLen;
 
-    /* doNext search for nth item */
-    NVINTF_nvProxy_t nvProxy = {0};
-    nvProxy.sysid  = NVINTF_SYSID_TIOP;
-    nvProxy.itemid = aKey;
-    nvProxy.flag   = NVINTF_DOSTART | NVINTF_DOITMID | NVINTF_DOFIND;
-
-    /* Lock and call doNext to find nth item of "aKey" */
-    intptr_t key = sNvoctpFps.lockNV();
-    while(!status && (count <= aIndex))
-    {
-        status = sNvoctpFps.doNext(&nvProxy);
-        count++;
-    }
-    sNvoctpFps.unlockNV(key);
+    /* Find nth item of "aKey" */
+    status = findSubId(aKey, aIndex, &subId);
 
     /* If we didn't find the nth item, return */
     if (NVINTF_NOTFOUND == status)
@@ -147,7 +347,7 @@ otError otPlatSettingsGet(otInstance *aInstance, uint16_t aKey, int aIndex,
     /* Make item ID */
     nvID.systemID = NVINTF_SYSID_TIOP;
     nvID.itemID   = aKey;
-    nvID.subID    = nvProxy.subid;
+    nvID.subID    = subId;
 
     /* Get length */
     itemLen = sNvoctpFps.getItemLen(nvID);
@@ -235,74 +435,24 @@ otError otPlatSettingsAdd(otInstance *aInstance, uint16_t aKey,
                           const uint8_t *aValue, uint16_t aValueLength)
 {
     NVINTF_itemID_t nvID;
-    NVINTF_nvProxy_t nvProxy = {0};
-    uint8_t status           = NVINTF_SUCCESS;
-    otError error            = OT_ERROR_FAILED;
-    uint32_t itemLen         = 1;
-    uint16_t maxSubId        = 0;
-    uint16_t minSubId        = 0;
-
-    /* Setup doNext call */
-    nvProxy.sysid  = NVINTF_SYSID_TIOP;
-    nvProxy.itemid = aKey;
-    nvProxy.subid  = 0;
-    nvProxy.flag   = NVINTF_DOSTART | NVINTF_DOITMID | NVINTF_DOFIND;
-
-    /* Lock and call doNext to iterate through all items of itemID "aKey" */
-    /* Store min/max of sub id's found */
-    intptr_t key = sNvoctpFps.lockNV();
-    while(!status)
-    {
-        status    = sNvoctpFps.doNext(&nvProxy);
-        maxSubId  = (nvProxy.subid > maxSubId ? nvProxy.subid : maxSubId);
-        minSubId  = (nvProxy.subid < minSubId ? nvProxy.subid : minSubId);
-    }
-    sNvoctpFps.unlockNV(key);
+    uint8_t status;
+    otError error = OT_ERROR_FAILED;
 
     /* Populate item ID */
     nvID.systemID = NVINTF_SYSID_TIOP;
     nvID.itemID   = aKey;
 
-    /* Look for an unused subid */
-    uint16_t count = 0;
-    bool looking   = TRUE;
-    while(looking && (count < SUBIDMAX))
-    {
-        if (maxSubId < SUBIDMAX)
-        {
-            nvID.subID = ++maxSubId;
-            itemLen    = sNvoctpFps.getItemLen(nvID);
-            if (!itemLen)
-            {
-                looking = false;
-            }
-        }
-        else
-        {
-            maxSubId = 0;
-        }
-        if (minSubId > 0 && looking)
-        {
-            nvID.subID = --minSubId;
-            itemLen    = sNvoctpFps.getItemLen(nvID);
-            if (!itemLen)
-            {
-                looking = false;
-            }
-        }
-        else
-        {
-            minSubId = SUBIDMAX;
-        }
-        count++;
-    }
+    /* Hold the lock so the free sub ID is still free when written */
+    intptr_t key = sNvoctpFps.lockNV();
+    status = findFreeSubId(aKey, &nvID.subID);
 
     /* Write item */
-    if (!itemLen)
+    if (NVINTF_SUCCESS == status)
     {
         status = sNvoctpFps.writeItem(nvID, aValueLength, (void *)aValue);
         error = (status == NVINTF_SUCCESS ? OT_ERROR_NONE : OT_ERROR_FAILED);
     }
+    sNvoctpFps.unlockNV(key);
 
     return(error);
 }
@@ -331,27 +481,16 @@ otError otPlatSettingsDelete(otInstance *aInstance, uint16_t aKey, int aIndex)
     }
     else
     {
-        /* Setup doNext call */
-        nvProxy.sysid  = NVINTF_SYSID_TIOP;
-        nvProxy.itemid = aKey;
-        nvProxy.flag   = NVINTF_DOSTART | NVINTF_DOITMID | NVINTF_DOFIND;
-
-        /* Call doNext to find nth matching item, where n = (aIndex - 1) */
-        int itemCount = 0;
-        intptr_t key  = sNvoctpFps.lockNV();
-        while(!status && (itemCount <= aIndex))
-        {
-           status = sNvoctpFps.doNext(&nvProxy);
-           itemCount++;
-        }
-        sNvoctpFps.unlockNV(key);
+        /* Find nth matching item, same order as otPlatSettingsGet */
+        uint16_t subId;
+        status = findSubId(aKey, aIndex, &subId);
 
         /* If we found our nth item, delete it */
         if (!status)
         {
             nvID.systemID = NVINTF_SYSID_TIOP;
             nvID.itemID   = aKey;
-            nvID.subID    = nvProxy.subid;
+            nvID.subID    = subId;
             status = sNvoctpFps.deleteItem(nvID);
         }
 
@@ -61,5 +61,6 @@ void PlatformInit(int argc, char *argv[])
     platformAlarmInit();
     platformAlarmMicroInit();
     platformRandomInit();
+    platformEnergyInit();
     platformRadioInit();
 }
@@ -813,6 +813,11 @@ static void rfCommonCallback(RF_Handle aRfHandle,
         if (sTransmitCmd.pPayload != NULL)
         {
             was_tx = true;
+            if (sTransmitCmd.status == IEEE_DONE_OK)
+            {
+                /* payload plus the FCS added by the radio */
+                platformEnergyRadioTx(sTransmitCmd.payloadLen + 2);
+            }
             if (sTransmitCmd.pPayload[0] & IEEE802154_ACK_REQUEST)
             {
                 need_ack = true;
@@ -1288,6 +1293,7 @@ otError otPlatRadioDisable(otInstance *aInstance)
     else if (sState == platformRadio_phyState_Sleep)
     {
         RF_close(sRfHandle);
+        platformEnergyRadioOn(false);
         sState = platformRadio_phyState_Disabled;
         error = OT_ERROR_NONE;
     }
@@ -1318,6 +1324,7 @@ otError otPlatRadioEnergyScan(otInstance *aInstance, uint8_t aScanChannel,
         /* fall through */
     case platformRadio_phyState_Sleep:
         sState = platformRadio_phyState_EdScan;
+        platformEnergyRadioOn(true);
         otEXPECT_ACTION(rfCoreSendEdScanCmd(sRfHandle, aScanChannel,
                                             aScanDuration) >= 0,
                         error = OT_ERROR_FAILED);
@@ -1387,6 +1394,7 @@ otError otPlatRadioReceive(otInstance *aInstance, uint8_t aChannel)
         sReceiveCmdHandle = rfCoreSendReceiveCmd(sRfHandle);
         otEXPECT_ACTION(sReceiveCmdHandle >= 0, error = OT_ERROR_FAILED);
         sState = platformRadio_phyState_Receive;
+        platformEnergyRadioOn(true);
         error = OT_ERROR_NONE;
     }
     else if (sState == platformRadio_phyState_Receive)
@@ -2390,6 +2398,7 @@ void platformRadioProcess(otInstance *aInstance)
                  */
                 clearRxQueue();
                 RF_yield(sRfHandle);
+                platformEnergyRadioOn(false);
             }
             if (events & (RF_EVENT_RX_DONE | RF_EVENT_RX_ACK_DONE))
             {
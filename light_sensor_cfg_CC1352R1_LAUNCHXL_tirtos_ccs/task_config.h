@@ -85,6 +85,13 @@ extern "C"
 #define TASK_CONFIG_LIGHTSENSOR_TASK_STACK_SIZE 2048
 #endif
 
+/**
+ * Size of the deferred log task call stack.
+ */
+#ifndef TASK_CONFIG_DLOG_TASK_STACK_SIZE
+#define TASK_CONFIG_DLOG_TASK_STACK_SIZE    768
+#endif
+
 /******************************************************************************
  External functions
  *****************************************************************************/
@@ -99,6 +106,11 @@ extern void OtStack_taskCreate(void);
  */
 extern void Lightsensor_taskCreate(void);
 
+/**
+ * Create function for the deferred log task, it runs at the lowest priority.
+ */
+extern void DLog_taskCreate(void);
+
 #ifdef __cplusplus
 }
 #endif
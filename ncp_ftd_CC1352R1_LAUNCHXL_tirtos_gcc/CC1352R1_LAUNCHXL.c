@@ -923,9 +923,23 @@ const uint_least8_t SPI_count = CC1352R1_LAUNCHXL_SPICOUNT;
 #include <ti/drivers/UART.h>
 #include <ti/drivers/uart/UARTCC26XX.h>
 
+/*
+ * UART0 carries the NCP link. Its driver ring buffer bridges the time until
+ * the next read is queued, so it is sized for high baud rates. Hardware flow
+ * control should be enabled for rates above 115200 baud.
+ */
+#ifndef CC1352R1_LAUNCHXL_UART0_RINGBUF_SIZE
+#define CC1352R1_LAUNCHXL_UART0_RINGBUF_SIZE    256
+#endif
+
+#ifndef CC1352R1_LAUNCHXL_UART0_FLOWCONTROL
+#define CC1352R1_LAUNCHXL_UART0_FLOWCONTROL     0
+#endif
+
 UARTCC26XX_Object uartCC26XXObjects[CC1352R1_LAUNCHXL_UARTCOUNT];
 
-uint8_t uartCC26XXRingBuffer[CC1352R1_LAUNCHXL_UARTCOUNT][32];
+uint8_t uartCC26XXRingBuffer0[CC1352R1_LAUNCHXL_UART0_RINGBUF_SIZE];
+uint8_t uartCC26XXRingBuffer1[32];
 
 const UARTCC26XX_HWAttrsV2 uartCC26XXHWAttrs[CC1352R1_LAUNCHXL_UARTCOUNT] = {
     {
@@ -936,10 +950,15 @@ const UARTCC26XX_HWAttrsV2 uartCC26XXHWAttrs[CC1352R1_LAUNCHXL_UARTCOUNT] = {
         .swiPriority    = 0,
         .txPin          = CC1352R1_LAUNCHXL_UART0_TX,
         .rxPin          = CC1352R1_LAUNCHXL_UART0_RX,
+#if CC1352R1_LAUNCHXL_UART0_FLOWCONTROL
+        .ctsPin         = CC1352R1_LAUNCHXL_UART0_CTS,
+        .rtsPin         = CC1352R1_LAUNCHXL_UART0_RTS,
+#else
         .ctsPin         = PIN_UNASSIGNED,
         .rtsPin         = PIN_UNASSIGNED,
-        .ringBufPtr     = uartCC26XXRingBuffer[CC1352R1_LAUNCHXL_UART0],
-        .ringBufSize    = sizeof(uartCC26XXRingBuffer[CC1352R1_LAUNCHXL_UART0]),
+#endif
+        .ringBufPtr     = uartCC26XXRingBuffer0,
+        .ringBufSize    = sizeof(uartCC26XXRingBuffer0),
         .txIntFifoThr   = UARTCC26XX_FIFO_THRESHOLD_1_8,
         .rxIntFifoThr   = UARTCC26XX_FIFO_THRESHOLD_4_8,
         .errorFxn       = NULL
@@ -954,8 +973,8 @@ const UARTCC26XX_HWAttrsV2 uartCC26XXHWAttrs[CC1352R1_LAUNCHXL_UARTCOUNT] = {
         .rxPin          = CC1352R1_LAUNCHXL_UART1_RX,
         .ctsPin         = PIN_UNASSIGNED,
         .rtsPin         = PIN_UNASSIGNED,
-        .ringBufPtr     = uartCC26XXRingBuffer[CC1352R1_LAUNCHXL_UART1],
-        .ringBufSize    = sizeof(uartCC26XXRingBuffer[CC1352R1_LAUNCHXL_UART1]),
+        .ringBufPtr     = uartCC26XXRingBuffer1,
+        .ringBufSize    = sizeof(uartCC26XXRingBuffer1),
         .txIntFifoThr   = UARTCC26XX_FIFO_THRESHOLD_1_8,
         .rxIntFifoThr   = UARTCC26XX_FIFO_THRESHOLD_4_8,
         .errorFxn       = NULL
@@ -62,7 +62,9 @@
 
 #include <ti/drivers/ECJPAKE.h>
 #include <ti/drivers/AESECB.h>
+#include <ti/drivers/AESCCM.h>
 #include <ti/drivers/SHA2.h>
+#include <ti/drivers/TRNG.h>
 
 /* Example/Board Header files */
 #include "Board.h"
@@ -96,8 +98,12 @@ int main(void)
 
     AESECB_init();
 
+    AESCCM_init();
+
     SHA2_init();
 
+    TRNG_init();
+
     ncp_taskCreate();
 
     OtStack_taskCreate();
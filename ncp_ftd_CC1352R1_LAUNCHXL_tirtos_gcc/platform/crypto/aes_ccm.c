@@ -0,0 +1,363 @@
+/******************************************************************************
+
+ @file aes_ccm.c
+
+ @brief AES-CCM* of 802.15.4 frames on the AES accelerator
+
+ PR Sensor Networks, TU Berlin
+
+ *****************************************************************************/
+
+#include <openthread/config.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <utils/code_utils.h>
+
+#include <ti/drivers/AESCCM.h>
+#include <ti/drivers/cryptoutils/cryptokey/CryptoKeyPlaintext.h>
+
+#include "mbedtls/aes.h"
+
+#include "Board.h"
+#include "platform.h"
+
+/*
+ * A frame is secured in one job of the AESCCM driver, MIC and CTR together,
+ * when the accelerator takes its shape. Otherwise it is run one AES block
+ * at a time through the mbedtls AES module, as the stack's own CCM* does.
+ */
+
+#define AESCCM_BLOCK_LEN    16
+#define AESCCM_KEY_LEN      16
+/* Nonce length of 802.15.4, the length field takes the rest of a block */
+#define AESCCM_NONCE_LEN    13
+#define AESCCM_L            (AESCCM_BLOCK_LEN - 1 - AESCCM_NONCE_LEN)
+
+/* AESCCM driver handle, opened on the first job and kept open */
+static AESCCM_Handle AesCcm_handle = NULL;
+
+/* Counters for diag crypto */
+static PlatformAesCcm_Stats AesCcm_stats;
+
+/**
+ * @brief Check if the accelerator takes a frame in one job.
+ *
+ * @param aFrame Frame to secure.
+ *
+ * @return true if it does.
+ */
+static bool AesCcm_jobSupported(const PlatformAesCcm_Frame *aFrame)
+{
+    /* CCM* without a MIC is CTR only, the driver always makes a MIC */
+    return (aFrame->tagLength >= 4 && aFrame->tagLength <= 16 &&
+            (aFrame->tagLength & 1) == 0 && aFrame->payloadLength > 0);
+}
+
+/**
+ * @brief Run a frame in one job of the AESCCM driver.
+ *
+ * @param aFrame   Frame to secure.
+ * @param aEncrypt true to encrypt, false to decrypt.
+ *
+ * @return Status of the driver, or AESCCM_STATUS_RESOURCE_UNAVAILABLE if the
+ *         driver could not be opened.
+ */
+static int_fast16_t AesCcm_job(PlatformAesCcm_Frame *aFrame, bool aEncrypt)
+{
+    AESCCM_Params    params;
+    AESCCM_Operation operation;
+    CryptoKey        cryptoKey;
+
+    if (AesCcm_handle == NULL)
+    {
+        AESCCM_Params_init(&params);
+        params.returnBehavior = AESCCM_RETURN_BEHAVIOR_POLLING;
+        AesCcm_handle = AESCCM_open(Board_AESCCM0, &params);
+    }
+    if (AesCcm_handle == NULL)
+    {
+        return AESCCM_STATUS_RESOURCE_UNAVAILABLE;
+    }
+
+    CryptoKeyPlaintext_initKey(&cryptoKey, (uint8_t *)aFrame->key,
+                               AESCCM_KEY_LEN);
+
+    AESCCM_Operation_init(&operation);
+    operation.key         = &cryptoKey;
+    operation.aad         = (uint8_t *)aFrame->header;
+    operation.aadLength   = aFrame->headerLength;
+    operation.input       = aFrame->payload;
+    operation.output      = aFrame->payload;
+    operation.inputLength = aFrame->payloadLength;
+    operation.nonce       = (uint8_t *)aFrame->nonce;
+    operation.nonceLength = AESCCM_NONCE_LEN;
+    operation.mac         = aFrame->tag;
+    operation.macLength   = aFrame->tagLength;
+
+    if (aEncrypt)
+    {
+        return AESCCM_oneStepEncrypt(AesCcm_handle, &operation);
+    }
+    return AESCCM_oneStepDecrypt(AesCcm_handle, &operation);
+}
+
+/**
+ * @brief Fill a counter block, A_i of CCM*.
+ *
+ * @param aBlock   Block to fill.
+ * @param aNonce   Nonce of the frame.
+ * @param aCounter Counter i.
+ */
+static void AesCcm_counterBlock(uint8_t *aBlock, const uint8_t *aNonce,
+                                uint16_t aCounter)
+{
+    aBlock[0] = AESCCM_L - 1;
+    memcpy(&aBlock[1], aNonce, AESCCM_NONCE_LEN);
+    aBlock[14] = (uint8_t)(aCounter >> 8);
+    aBlock[15] = (uint8_t)aCounter;
+}
+
+/**
+ * @brief Add data to the CBC-MAC, padded with zeros to a block.
+ *
+ * @param ctx    AES context keyed with the frame key.
+ * @param aMac   CBC-MAC state.
+ * @param aFill  Bytes of the current block already in aMac.
+ * @param aData  Data to add.
+ * @param aLen   Length of the data.
+ */
+static void AesCcm_macAdd(mbedtls_aes_context *ctx, uint8_t *aMac,
+                          size_t aFill, const uint8_t *aData, size_t aLen)
+{
+    while (aLen > 0)
+    {
+        aMac[aFill++] ^= *aData++;
+        aLen--;
+
+        if (aFill == AESCCM_BLOCK_LEN || aLen == 0)
+        {
+            mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_ENCRYPT, aMac, aMac);
+            aFill = 0;
+        }
+    }
+}
+
+/**
+ * @brief Compute the CBC-MAC of a frame, T of CCM*.
+ *
+ * @param ctx     AES context keyed with the frame key.
+ * @param aFrame  Frame with its payload in plaintext.
+ * @param aMac    Block to place the MAC in.
+ */
+static void AesCcm_mac(mbedtls_aes_context *ctx,
+                       const PlatformAesCcm_Frame *aFrame, uint8_t *aMac)
+{
+    uint8_t header[2];
+
+    /* B_0, flags, nonce and payload length */
+    aMac[0] = ((aFrame->headerLength > 0) ? 0x40 : 0) |
+              (((aFrame->tagLength - 2) / 2) << 3) | (AESCCM_L - 1);
+    memcpy(&aMac[1], aFrame->nonce, AESCCM_NONCE_LEN);
+    aMac[14] = (uint8_t)(aFrame->payloadLength >> 8);
+    aMac[15] = (uint8_t)aFrame->payloadLength;
+    mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_ENCRYPT, aMac, aMac);
+
+    /* header with its length in front, 802.15.4 headers are below 2^16-2^8 */
+    if (aFrame->headerLength > 0)
+    {
+        header[0] = (uint8_t)(aFrame->headerLength >> 8);
+        header[1] = (uint8_t)aFrame->headerLength;
+        aMac[0] ^= header[0];
+        aMac[1] ^= header[1];
+        AesCcm_macAdd(ctx, aMac, sizeof(header), aFrame->header,
+                      aFrame->headerLength);
+    }
+
+    AesCcm_macAdd(ctx, aMac, 0, aFrame->payload, aFrame->payloadLength);
+}
+
+/**
+ * @brief Encrypt or decrypt the payload in counter mode, from A_1.
+ *
+ * @param ctx     AES context keyed with the frame key.
+ * @param aFrame  Frame to run.
+ */
+static void AesCcm_ctr(mbedtls_aes_context *ctx, PlatformAesCcm_Frame *aFrame)
+{
+    uint8_t  block[AESCCM_BLOCK_LEN];
+    uint16_t counter = 1;
+    size_t   offset;
+    size_t   i;
+
+    for (offset = 0; offset < aFrame->payloadLength;
+         offset += AESCCM_BLOCK_LEN)
+    {
+        AesCcm_counterBlock(block, aFrame->nonce, counter++);
+        mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_ENCRYPT, block, block);
+
+        for (i = 0; i < AESCCM_BLOCK_LEN &&
+                    offset + i < aFrame->payloadLength; i++)
+        {
+            aFrame->payload[offset + i] ^= block[i];
+        }
+    }
+}
+
+/**
+ * @brief Run a frame one AES block at a time.
+ *
+ * @param aFrame   Frame to secure.
+ * @param aEncrypt true to encrypt, false to decrypt.
+ *
+ * @return OT_ERROR_NONE, or OT_ERROR_SECURITY if the MIC does not match.
+ */
+static otError AesCcm_perBlock(PlatformAesCcm_Frame *aFrame, bool aEncrypt)
+{
+    mbedtls_aes_context ctx;
+    otError             error = OT_ERROR_NONE;
+    uint8_t             mac[AESCCM_BLOCK_LEN];
+    uint8_t             s0[AESCCM_BLOCK_LEN];
+    uint8_t             diff = 0;
+    uint8_t             i;
+
+    mbedtls_aes_init(&ctx);
+    mbedtls_aes_setkey_enc(&ctx, aFrame->key, AESCCM_KEY_LEN * 8);
+
+    if (aEncrypt && aFrame->tagLength > 0)
+    {
+        AesCcm_mac(&ctx, aFrame, mac);
+    }
+
+    AesCcm_ctr(&ctx, aFrame);
+
+    if (aFrame->tagLength > 0)
+    {
+        if (!aEncrypt)
+        {
+            AesCcm_mac(&ctx, aFrame, mac);
+        }
+
+        /* the MIC is T encrypted with S_0 */
+        AesCcm_counterBlock(s0, aFrame->nonce, 0);
+        mbedtls_aes_crypt_ecb(&ctx, MBEDTLS_AES_ENCRYPT, s0, s0);
+
+        for (i = 0; i < aFrame->tagLength; i++)
+        {
+            if (aEncrypt)
+            {
+                aFrame->tag[i] = mac[i] ^ s0[i];
+            }
+            else
+            {
+                diff |= aFrame->tag[i] ^ mac[i] ^ s0[i];
+            }
+        }
+
+        if (diff != 0)
+        {
+            error = OT_ERROR_SECURITY;
+        }
+    }
+
+    mbedtls_aes_free(&ctx);
+    memset(mac, 0, sizeof(mac));
+    memset(s0, 0, sizeof(s0));
+
+    return error;
+}
+
+/**
+ * @brief Secure a frame, in one job if the accelerator takes it.
+ *
+ * @param aFrame   Frame to secure.
+ * @param aPath    Path to run it on.
+ * @param aEncrypt true to encrypt, false to decrypt.
+ *
+ * @return OT_ERROR_NONE, OT_ERROR_SECURITY if the MIC does not match, or
+ *         OT_ERROR_FAILED if the accelerator failed.
+ */
+static otError AesCcm_run(PlatformAesCcm_Frame *aFrame,
+                          PlatformAesCcm_Path aPath, bool aEncrypt)
+{
+    otError      error = OT_ERROR_NONE;
+    int_fast16_t status;
+    bool         ran = false;
+
+    otEXPECT_ACTION(aFrame != NULL && aFrame->key != NULL &&
+                    aFrame->nonce != NULL &&
+                    (aFrame->header != NULL || aFrame->headerLength == 0) &&
+                    (aFrame->payload != NULL || aFrame->payloadLength == 0) &&
+                    (aFrame->tag != NULL || aFrame->tagLength == 0) &&
+                    aFrame->tagLength <= AESCCM_BLOCK_LEN &&
+                    aFrame->tagLength != 2 && (aFrame->tagLength & 1) == 0,
+                    error = OT_ERROR_INVALID_ARGS);
+
+    if (aPath == PlatformAesCcm_auto && AesCcm_jobSupported(aFrame))
+    {
+        status = AesCcm_job(aFrame, aEncrypt);
+
+        /* the payload is only written by a job that ran */
+        if (status != AESCCM_STATUS_RESOURCE_UNAVAILABLE)
+        {
+            AesCcm_stats.jobs++;
+            ran = true;
+
+            if (status == AESCCM_STATUS_MAC_INVALID)
+            {
+                AesCcm_stats.micFailures++;
+                error = OT_ERROR_SECURITY;
+            }
+            else if (status != AESCCM_STATUS_SUCCESS)
+            {
+                error = OT_ERROR_FAILED;
+            }
+        }
+        else
+        {
+            AesCcm_stats.fallbacks++;
+        }
+    }
+
+    if (!ran)
+    {
+        AesCcm_stats.perBlock++;
+        error = AesCcm_perBlock(aFrame, aEncrypt);
+
+        if (error == OT_ERROR_SECURITY)
+        {
+            AesCcm_stats.micFailures++;
+        }
+    }
+
+exit:
+    return error;
+}
+
+/**
+ * Function documented in platform.h
+ */
+otError platformAesCcmEncrypt(PlatformAesCcm_Frame *aFrame,
+                              PlatformAesCcm_Path aPath)
+{
+    return AesCcm_run(aFrame, aPath, true);
+}
+
+/**
+ * Function documented in platform.h
+ */
+otError platformAesCcmDecrypt(PlatformAesCcm_Frame *aFrame,
+                              PlatformAesCcm_Path aPath)
+{
+    return AesCcm_run(aFrame, aPath, false);
+}
+
+/**
+ * Function documented in platform.h
+ */
+void platformAesCcmGetStats(PlatformAesCcm_Stats *aStats)
+{
+    *aStats = AesCcm_stats;
+}
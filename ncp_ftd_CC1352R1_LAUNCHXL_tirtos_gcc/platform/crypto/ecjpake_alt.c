@@ -56,6 +56,16 @@
 #include <ti/drivers/cryptoutils/cryptokey/CryptoKeyPlaintext.h>
 #include <string.h>
 
+#include "platform.h"
+
+/*
+ * The ECJPAKE driver takes scalars and points little endian, the wire and
+ * the ZKP hashes carry them big endian. Keys stay in the context in the
+ * driver's order, and are turned around only once, on their way to or from
+ * the wire. The ZKP hashes are computed over the points as they are on the
+ * wire, so a point sent or received is not encoded a second time.
+ */
+
 /*
  * Convert a mbedtls_ecjpake_role to identifier string
  */
@@ -67,11 +77,16 @@ static const char * const ecjpake_id[] = {
 #define ID_MINE     ( ecjpake_id[ ctx->role ] )
 #define ID_PEER     ( ecjpake_id[ 1 - ctx->role ] )
 
+/*
+ * Length of an uncompressed point, 0x04 then X and Y
+ */
+#define ECJPAKE_POINT_LEN       ( 2 * ECC_SECP256R1_LENGTH + 1 )
+
 /*
  * Size of the temporary buffer for ecjpake_hash:
  * 3 EC points plus their length, plus ID and its length (4 + 6 bytes)
  */
-#define ECJPAKE_HASH_BUF_LEN    ( 3 * ( 4 + MBEDTLS_ECP_MAX_PT_LEN ) + 4 + 6 )
+#define ECJPAKE_HASH_BUF_LEN    ( 3 * ( 4 + ECJPAKE_POINT_LEN ) + 4 + 6 )
 
 #define ECJPAKE_ALT_CHK(f) do { if( ( ret = f ) != 0 ) goto cleanup; } while( 0 )
 
@@ -80,6 +95,54 @@ static const char * const ecjpake_id[] = {
  */
 #define TLS_CURVE_SECP256R1_ID          (23)
 
+/*
+ * Generator of NIST P-256 as it goes into the round one hashes
+ */
+static const unsigned char ecjpake_generator[ECJPAKE_POINT_LEN] = {
+    0x04,
+    0x6b, 0x17, 0xd1, 0xf2, 0xe1, 0x2c, 0x42, 0x47,
+    0xf8, 0xbc, 0xe6, 0xe5, 0x63, 0xa4, 0x40, 0xf2,
+    0x77, 0x03, 0x7d, 0x81, 0x2d, 0xeb, 0x33, 0xa0,
+    0xf4, 0xa1, 0x39, 0x45, 0xd8, 0x98, 0xc2, 0x96,
+    0x4f, 0xe3, 0x42, 0xe2, 0xfe, 0x1a, 0x7f, 0x9b,
+    0x8e, 0xe7, 0xeb, 0x4a, 0x7c, 0x0f, 0x9e, 0x16,
+    0x2b, 0xce, 0x33, 0x57, 0x6b, 0x31, 0x5e, 0xce,
+    0xcb, 0xb6, 0x40, 0x68, 0x37, 0xbf, 0x51, 0xf5
+};
+
+/*
+ * Order of NIST P-256, big endian
+ */
+static const unsigned char ecjpake_order[ECC_SECP256R1_LENGTH] = {
+    0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xbc, 0xe6, 0xfa, 0xad, 0xa7, 0x17, 0x9e, 0x84,
+    0xf3, 0xb9, 0xca, 0xc2, 0xfc, 0x63, 0x25, 0x51
+};
+
+/*
+ * Time spent in each step of the last handshake, for the join profile
+ */
+static PlatformEcjpake_Profile ecjpake_profile;
+
+/**
+ * @brief records a step of the handshake in the profile.
+ *
+ * @param op    step of the handshake.
+ * @param start time the step started, see platformAlarmGetNowUs().
+ * @param ret   result of the step.
+ */
+static void ecjpake_profile_step(PlatformEcjpake_Op op, uint64_t start,
+                                 int ret)
+{
+    ecjpake_profile.start[op] = start;
+    ecjpake_profile.us[op] = (uint32_t)( platformAlarmGetNowUs() - start );
+
+    if( ret != 0 )
+    {
+        ecjpake_profile.failures++;
+    }
+}
 
 /**
  * @brief checks if the elliptical point is zero or not
@@ -89,27 +152,24 @@ static const char * const ecjpake_id[] = {
  *
  * @return return true if the point is zero otherwise false.
  */
-static bool ec_point_is_zero(unsigned char *pt, int len)
+static bool ec_point_is_zero(const unsigned char *pt, int len)
 {
-    unsigned long* point = (unsigned long*)pt;
+    unsigned char bits = 0;
+    int i;
 
-    /* check if point is equal to zero */
-    for (int i = 0; i < (len/sizeof(unsigned long)); i++)
+    for (i = 0; i < len; i++)
     {
-      if ( point[i] != 0 )
-      {
-          break;
-      }
-      return (true);
+        bits |= pt[i];
     }
 
-    return (false);
+    return (bits == 0);
 }
 
 /**
  * @brief generates a private key using the random number generator function.
+ *        The key is in [1, n-1], n the order of the curve.
  *
- * @param private_key   pointer to the private key
+ * @param private_key   pointer to the private key, little endian
  * @param f_rng         random number function
  * @param p_rng         input parameter to the random number function
  *
@@ -119,29 +179,58 @@ static int gen_private_key(unsigned char* private_key,
                            int (*f_rng)(void *, unsigned char *, size_t),
                            void *p_rng)
 {
-    bool zero = false;
-    int i,j;
-    size_t n_size = ECC_SECP256R1_LENGTH;
-    unsigned long* pkey = (unsigned long*)private_key;
+    int ret;
+    int tries;
+    int i;
 
-    j = 0;
-    do
+    for (tries = 0; tries < 3; tries++)
     {
-        f_rng(p_rng, private_key, n_size);
+        if( ( ret = f_rng(p_rng, private_key, ECC_SECP256R1_LENGTH) ) != 0 )
+        {
+            return( ret );
+        }
 
-        /* check if private_key is equal to zero */
-        for (i = 0; i < 8; i++)
+        if( ec_point_is_zero(private_key, ECC_SECP256R1_LENGTH) )
         {
-          if ( pkey[0] != 0 )
-          {
-              break;
-          }
-          zero = true;
+            continue;
         }
-        j++;
-    } while ( (zero) && (j < 3) );
 
-   return ((zero)==false ? 0 : -1);
+        /* compare with the order from the most significant byte */
+        for (i = 0; i < ECC_SECP256R1_LENGTH; i++)
+        {
+            if( private_key[ECC_SECP256R1_LENGTH - 1 - i] != ecjpake_order[i] )
+            {
+                break;
+            }
+        }
+
+        if( i < ECC_SECP256R1_LENGTH &&
+            private_key[ECC_SECP256R1_LENGTH - 1 - i] < ecjpake_order[i] )
+        {
+            return( 0 );
+        }
+    }
+
+    return( MBEDTLS_ERR_ECP_RANDOM_FAILED );
+}
+
+/**
+ * @brief copies a big number, turning its byte order around.
+ *
+ * @param dst   pointer to the destination.
+ * @param src   pointer to the big number, must not overlap dst.
+ * @param len   length of the big number
+ * @return None
+ */
+static void copy_reversed(unsigned char *dst, const unsigned char *src,
+                          size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        dst[i] = src[len - 1 - i];
+    }
 }
 
 /**
@@ -169,80 +258,42 @@ static void big_num_reverse(unsigned char *s, int len)
 }
 
 /**
- * @brief writes the big number into the buffer.
+ * @brief reads a big endian number of up to ECC_SECP256R1_LENGTH bytes
+ *        into a little endian one, padded with zeros.
  *
- * @param buf   pointer to the buffer where the big number point
- *              needs to be written.
- * @param ilen  available length of the buffer.
- * @param pt    pointer to the big number.
- *
- * @return int   zero if succcessful otherwise negative value.
- */
-static int write_binary(unsigned char *buf, size_t ilen, unsigned char* pt)
-{
-    if( ilen < ECC_SECP256R1_LENGTH )
-    {
-        return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
-    }
-
-    memcpy((void *)buf, pt, ECC_SECP256R1_LENGTH);
-    big_num_reverse(buf, ECC_SECP256R1_LENGTH);
-
-    return (0);
-}
-
-/**
- * @brief reads the binary date from the buffer and into the
- *        provided point.
- *
- * @param buf pointer to the buffer.
- * @param ilen length of the buffer
- * @param pt pointer to the point.
+ * @param buf   pointer to the big endian number.
+ * @param ilen  length of the number.
+ * @param num   pointer to the little endian number.
  *
  * @return int zero if successful otherwise negative value.
  */
 static int read_binary(const unsigned char *buf, size_t ilen,
-                       unsigned char* pt)
+                       unsigned char* num)
 {
-    if( ilen < 1 )
+    if( ilen < 1 || ilen > ECC_SECP256R1_LENGTH )
     {
         return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
     }
 
-    memcpy( pt, buf, ilen );
-    big_num_reverse( pt, ilen );
+    copy_reversed(num, buf, ilen);
+    memset(num + ilen, 0, ECC_SECP256R1_LENGTH - ilen);
 
     return (0);
 }
 
 /**
- * @brief reads the key value from the buffer.
+ * @brief encodes a point as an uncompressed point.
  *
- * @param buf   pointer to the buffer.
- * @param ilen  input length of the buffer.
- * @param key   pointer to the key.
- *
- * @return zero if successful otherwise negative values.
+ * @param buf   pointer to ECJPAKE_POINT_LEN bytes.
+ * @param point pointer to the point, X and Y little endian.
  */
-static int read_key(const unsigned char *buf, size_t ilen, unsigned char* key)
+static void point_encode(unsigned char *buf, const unsigned char *point)
 {
     size_t plen = ECC_SECP256R1_LENGTH;
 
-    if( ilen < 1 )
-    {
-        return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
-    }
-
-    if( buf[0] != 0x04 )
-    {
-        return( MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE );
-    }
-
-    memcpy(key, buf + 1, plen*2);
-    big_num_reverse(key, plen);
-    big_num_reverse(key + plen, plen);
-
-    return (0);
+    buf[0] = 0x04; /* uncompressed point format  */
+    copy_reversed(buf + 1, point, plen);
+    copy_reversed(buf + 1 + plen, point + plen, plen);
 }
 
 /**
@@ -250,16 +301,19 @@ static int read_key(const unsigned char *buf, size_t ilen, unsigned char* key)
  *
  * @param buf       pointer to the buffer containing the tls
  *                  structure.
- * @param point     pointer to the ec point.
+ * @param point     pointer to the ec point, X and Y little endian.
+ * @param encoded   set to the uncompressed point in the buffer.
  * @param buf_len   length of the buffer.
  *
  * @return zero if successful otherwise negative values.
  */
 static int read_tls_point(const unsigned char **buf,
-                          unsigned char * point, size_t buf_len)
+                          unsigned char *point,
+                          const unsigned char **encoded,
+                          size_t buf_len)
 {
+    size_t plen = ECC_SECP256R1_LENGTH;
     unsigned char data_len;
-    const unsigned char *buf_start;
 
     /*
      * at least two bytes (1 for length, at least one for data)
@@ -276,87 +330,81 @@ static int read_tls_point(const unsigned char **buf,
         return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
     }
 
-    buf_start = *buf;
+    if( (*buf)[0] != 0x04 )
+    {
+        return( MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE );
+    }
+
+    if( data_len != ECJPAKE_POINT_LEN )
+    {
+        return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
+    }
+
+    *encoded = *buf;
+    copy_reversed(point, *buf + 1, plen);
+    copy_reversed(point + plen, *buf + 1 + plen, plen);
     *buf += data_len;
 
-    return read_key(buf_start, data_len, point);
+    return( 0 );
 }
 
 /**
  * @brief writes the value of the ec point in the required tls
  *        point structure.
  *
- * @param point pointer to the value of the point to be written.
- * @param olen  total length consumed by the point.
- * @param buf   pointer to the buffer.
- * @param blen  length of the buffer.
+ * @param point     pointer to the value of the point to be written.
+ * @param encoded   set to the uncompressed point in the buffer.
+ * @param olen      total length consumed by the point.
+ * @param buf       pointer to the buffer.
+ * @param blen      length of the buffer.
  *
  * @return zero if successful otherwise negative value.
  */
 static int tls_write_point(const unsigned char *point,
+                           const unsigned char **encoded,
                            size_t *olen,
                            unsigned char *buf, size_t blen)
 {
-    size_t plen = ECC_SECP256R1_LENGTH;
-
-    if( blen < 66 )
+    if( blen < ECJPAKE_POINT_LEN + 1 )
     {
-        return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
+        return( MBEDTLS_ERR_ECP_BUFFER_TOO_SMALL );
     }
 
-    buf[1] = 0x04; /* uncompressed point format  */
-    memcpy(buf + 2, point, plen*2);
-    big_num_reverse(buf + 2, plen);
-    big_num_reverse(buf + plen + 2, plen);
-    *olen = 65;
-
     /*
-     * write length to the first byte and update total length
+     * write length to the first byte
      */
-    buf[0] = (unsigned char) *olen;
-    ++*olen;
+    buf[0] = ECJPAKE_POINT_LEN;
+    point_encode(buf + 1, point);
+
+    *encoded = buf + 1;
+    *olen = ECJPAKE_POINT_LEN + 1;
 
     return( 0 );
 }
 
 /**
- * @brief write the ec point (public) to the buffer.
+ * @brief writes a scalar with its length byte.
  *
- * @param ecpoint pointer to the ec point (public).
- * @param format  format of the ec point.
- * @param olen    output length consumed.
- * @param buf     pointer to the buffer.
- * @param buflen  length of the buffer.
+ * @param num   pointer to the scalar, little endian.
+ * @param olen  total length written.
+ * @param buf   pointer to the buffer.
+ * @param blen  length of the buffer.
  *
  * @return zero if successful otherwise negative value.
  */
-static int ec_point_write_binary(const unsigned char* ecpoint,
-                                 int format,
-                                 size_t *olen,
-                                 unsigned char *buf,
-                                 size_t buflen)
+static int tls_write_scalar(const unsigned char *num, size_t *olen,
+                            unsigned char *buf, size_t blen)
 {
-    int ret = 0;
-    size_t plen = ECC_SECP256R1_LENGTH;
-
-    if( format != MBEDTLS_ECP_PF_UNCOMPRESSED )
-    {
-        return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
-    }
-
-    *olen = 2 * plen + 1;
-
-    if( buflen < *olen )
+    if( blen < ECC_SECP256R1_LENGTH + 1 )
     {
         return( MBEDTLS_ERR_ECP_BUFFER_TOO_SMALL );
     }
 
-    buf[0] = 0x04;
-    memcpy(buf + 1, ecpoint, plen*2);
-    big_num_reverse(buf + 1, plen);
-    big_num_reverse(buf + 1 + plen, plen);
+    buf[0] = ECC_SECP256R1_LENGTH;
+    copy_reversed(buf + 1, num, ECC_SECP256R1_LENGTH);
+    *olen = ECC_SECP256R1_LENGTH + 1;
 
-    return( ret );
+    return( 0 );
 }
 
 /*
@@ -417,6 +465,10 @@ int mbedtls_ecjpake_setup(mbedtls_ecjpake_context *ctx,
 
     ECJPAKE_ALT_CHK( mbedtls_ecp_group_load(&ctx->grp, curve) );
 
+    ecjpake_profile.handshakes++;
+    memset(ecjpake_profile.start, 0, sizeof(ecjpake_profile.start));
+    memset(ecjpake_profile.us, 0, sizeof(ecjpake_profile.us));
+
     if (ctx->handle)
     {
         ctx->roundTwoGenerated = false;
@@ -427,7 +479,8 @@ int mbedtls_ecjpake_setup(mbedtls_ecjpake_context *ctx,
                                    (ECCParams_NISTP256.length * 2));
 
         /* Pre-shared secret */
-        read_binary(secret, len, &ctx->preSharedSecretKeyingMaterial[0]);
+        ECJPAKE_ALT_CHK(read_binary(secret, len,
+                                    &ctx->preSharedSecretKeyingMaterial[0]));
 
         CryptoKeyPlaintext_initKey(&ctx->preSharedSecretCryptoKey,
                                    ctx->preSharedSecretKeyingMaterial,
@@ -511,61 +564,22 @@ int mbedtls_ecjpake_check(const mbedtls_ecjpake_context *ctx)
     return( 0 );
 }
 
-/**
- * @brief write a point plus its length to a buffer
- *
- * @param p     pointer to the buffer.
- * @param end   end of the buffer.
- * @param pf    point format.
- * @param point pointer to the ec point to be written.
- *
- * @return zero if successfule otherwise negative values.
- */
-static int ecjpake_write_len_point(unsigned char **p,
-                                   const unsigned char *end,
-                                   const int pf,
-                                   const unsigned char *point)
-{
-    int ret;
-    size_t len;
-
-    /* Need at least 4 for length plus 1 for point */
-    if( end < *p || end - *p < 5 )
-    {
-        return( MBEDTLS_ERR_ECP_BUFFER_TOO_SMALL );
-    }
-
-    ret = ec_point_write_binary( point, pf, &len, *p + 4, end - ( *p + 4 ) );
-    if( ret != 0 )
-    {
-        return( ret );
-    }
-
-    (*p)[0] = (unsigned char)( ( len >> 24 ) & 0xFF );
-    (*p)[1] = (unsigned char)( ( len >> 16 ) & 0xFF );
-    (*p)[2] = (unsigned char)( ( len >>  8 ) & 0xFF );
-    (*p)[3] = (unsigned char)( ( len       ) & 0xFF );
-
-    *p += 4 + len;
-
-    return (0);
-}
 
 /**
  * @brief Computes hash for the ZKP.
  *
  * @param md_info   hash info.
- * @param pf        point format
- * @param G         generator point.
- * @param V         emphereal point for ZKP.
- * @param X         emphereal point for which hash needs to be generated.
+ * @param G         generator point, uncompressed.
+ * @param V         emphereal point for ZKP, uncompressed.
+ * @param X         emphereal point for which hash needs to be generated,
+ *                  uncompressed.
  * @param id        identity of the device.
- * @param hash      pointer to the hash buffer.
+ * @param hash      pointer to the hash buffer, the hash is little endian
+ *                  for the driver.
  *
  * @return zero if successful otherwise negative value.
  */
 static int ecjpake_hash(const mbedtls_md_info_t *md_info,
-                        const int pf,
                         const unsigned char *G,
                         const unsigned char *V,
                         const unsigned char *X,
@@ -575,34 +589,37 @@ static int ecjpake_hash(const mbedtls_md_info_t *md_info,
     int ret;
     unsigned char buf[ECJPAKE_HASH_BUF_LEN];
     unsigned char *p = buf;
-    const unsigned char *end = buf + sizeof( buf );
+    const unsigned char *points[] = { G, V, X };
     const size_t id_len = strlen( id );
+    size_t i;
 
-    /* Write things to temporary buffer */
-    ECJPAKE_ALT_CHK(ecjpake_write_len_point(&p, end, pf, G));
-    ECJPAKE_ALT_CHK(ecjpake_write_len_point(&p, end, pf, V));
-    ECJPAKE_ALT_CHK(ecjpake_write_len_point(&p, end, pf, X));
-
-    if( end - p < 4 )
+    if( id_len > sizeof( buf ) - 3 * ( 4 + ECJPAKE_POINT_LEN ) - 4 )
     {
         return( MBEDTLS_ERR_ECP_BUFFER_TOO_SMALL );
     }
 
+    /* Write things to temporary buffer, each with its length */
+    for (i = 0; i < 3; i++)
+    {
+        *p++ = 0;
+        *p++ = 0;
+        *p++ = 0;
+        *p++ = ECJPAKE_POINT_LEN;
+        memcpy( p, points[i], ECJPAKE_POINT_LEN );
+        p += ECJPAKE_POINT_LEN;
+    }
+
     *p++ = (unsigned char)( ( id_len >> 24 ) & 0xFF );
     *p++ = (unsigned char)( ( id_len >> 16 ) & 0xFF );
     *p++ = (unsigned char)( ( id_len >>  8 ) & 0xFF );
     *p++ = (unsigned char)( ( id_len       ) & 0xFF );
 
-    if( end < p || (size_t)( end - p ) < id_len )
-    {
-        return( MBEDTLS_ERR_ECP_BUFFER_TOO_SMALL );
-    }
-
     memcpy( p, id, id_len );
     p += id_len;
 
     /* Compute hash */
     ECJPAKE_ALT_CHK(mbedtls_md(md_info, buf, p - buf, hash));
+    big_num_reverse(hash, ECC_SECP256R1_LENGTH);
 
 cleanup:
     return( ret );
@@ -613,8 +630,8 @@ cleanup:
  *
  * @param ctx               pointer to context.
  * @param generator_key     pointer to the generator crypto key.
- * @param generator_point   pointer to the generator point.
- * @param X                 pointer to the emphereal public key.
+ * @param generator_point   generator point, uncompressed.
+ * @param X                 emphereal public key, uncompressed.
  * @param public_key        public key.
  * @param id                device identity
  * @param p                 pointer to the buffer.
@@ -624,8 +641,8 @@ cleanup:
  */
 static int ecjpake_zkp_read(mbedtls_ecjpake_context *ctx,
                             CryptoKey* generator_key,
-                            unsigned char* generator_point,
-                            unsigned char* X,
+                            const unsigned char* generator_point,
+                            const unsigned char* X,
                             CryptoKey* public_key,
                             const char *id,
                             const unsigned char **p,
@@ -636,6 +653,7 @@ static int ecjpake_zkp_read(mbedtls_ecjpake_context *ctx,
     ECJPAKE_OperationVerifyZKP operation_verify_zkp;
     CryptoKey their_public_v;
     unsigned char their_public_v_material[64];
+    const unsigned char *V;
     unsigned char r[ECC_SECP256R1_LENGTH];
     unsigned char hash[ECC_SECP256R1_LENGTH];
 
@@ -650,7 +668,8 @@ static int ecjpake_zkp_read(mbedtls_ecjpake_context *ctx,
         return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
     }
 
-    ECJPAKE_ALT_CHK(read_tls_point(p, their_public_v_material, end - *p));
+    ECJPAKE_ALT_CHK(read_tls_point(p, their_public_v_material, &V,
+                                   end - *p));
 
     if( end < *p || (size_t)( end - *p ) < 1 )
     {
@@ -670,6 +689,7 @@ static int ecjpake_zkp_read(mbedtls_ecjpake_context *ctx,
         goto cleanup;
     }
 
+    /* r is sent without its leading zeros */
     ECJPAKE_ALT_CHK(read_binary( *p, r_len, r ));
 
     *p += r_len;
@@ -677,12 +697,8 @@ static int ecjpake_zkp_read(mbedtls_ecjpake_context *ctx,
     /*
      * Verification
      */
-    ECJPAKE_ALT_CHK(ecjpake_hash(ctx->md_info,
-                                  ctx->point_format,
-                                  generator_point,
-                                  their_public_v_material,
-                                  X, id, hash));
-    big_num_reverse(hash, ECC_SECP256R1_LENGTH);
+    ECJPAKE_ALT_CHK(ecjpake_hash(ctx->md_info, generator_point, V, X, id,
+                                 hash));
 
     ECJPAKE_OperationVerifyZKP_init(&operation_verify_zkp);
     operation_verify_zkp.curve                = &ECCParams_NISTP256;
@@ -704,7 +720,7 @@ cleanup:
  *
  * @param ctx               pointer to the context.
  * @param G                 generator key
- * @param generator_point   generator key value.
+ * @param generator_point   generator point, uncompressed.
  * @param X                 input public key which needs to be verified
  * @param public_key        public key
  * @param id                device identifier.
@@ -715,7 +731,7 @@ cleanup:
  */
 static int ecjpake_k_zkp_read( mbedtls_ecjpake_context *ctx,
                              CryptoKey* G,
-                             unsigned char* generator_point,
+                             const unsigned char* generator_point,
                              unsigned char* X,
                              CryptoKey* public_key,
                              const char *id,
@@ -723,6 +739,7 @@ static int ecjpake_k_zkp_read( mbedtls_ecjpake_context *ctx,
                              const unsigned char *end )
 {
     int ret;
+    const unsigned char *encoded;
 
     if( end < *p )
     {
@@ -735,15 +752,14 @@ static int ecjpake_k_zkp_read( mbedtls_ecjpake_context *ctx,
      *     ECSchnorrZKP zkp;
      * } ECJPAKEKeyKP;
      */
-    ECJPAKE_ALT_CHK( read_tls_point(p, X, end - *p) );
-    if( ec_point_is_zero(X,ECC_SECP256R1_LENGTH) &&
-        ec_point_is_zero(X + ECC_SECP256R1_LENGTH, ECC_SECP256R1_LENGTH) )
+    ECJPAKE_ALT_CHK( read_tls_point(p, X, &encoded, end - *p) );
+    if( ec_point_is_zero(X, 2 * ECC_SECP256R1_LENGTH) )
     {
         ret = MBEDTLS_ERR_ECP_INVALID_KEY;
         goto cleanup;
     }
 
-    ECJPAKE_ALT_CHK( ecjpake_zkp_read( ctx, G, generator_point, X,
+    ECJPAKE_ALT_CHK( ecjpake_zkp_read( ctx, G, generator_point, encoded,
                                        public_key, id, p, end ) );
 
 cleanup:
@@ -756,7 +772,7 @@ cleanup:
  *
  * @param ctx               pointer to the context.
  * @param G                 generator cryptokey
- * @param generator_point   generator point value.
+ * @param generator_point   generator point, uncompressed.
  * @param Xa                pointer to the emphereal public key 1 from peer.
  * @param publicCryptoKey1  correponding public key cryptokey of Xa.
  * @param Xb                pointer to the emphereal public key 1 from peer.
@@ -769,7 +785,7 @@ cleanup:
  */
 static int ecjpake_kzkp_kzkp_read(mbedtls_ecjpake_context *ctx,
                                   CryptoKey* G,
-                                  unsigned char* generator_point,
+                                  const unsigned char* generator_point,
                                   unsigned char* Xa,
                                   CryptoKey* publicCryptoKey1,
                                   unsigned char* Xb,
@@ -792,11 +808,69 @@ cleanup:
 
 }
 
+/**
+ * @brief   writes an emphereal public key and its ZKP.
+ *
+ * @param ctx           pointer to the context.
+ * @param G             generator point, uncompressed.
+ * @param public_key    emphereal public key.
+ * @param private_key   its private key.
+ * @param public_v      public V of the ZKP.
+ * @param private_v     its private key.
+ * @param id            identifier.
+ * @param p             pointer to the buffer, moved past what is written.
+ * @param end           end of the buffer.
+ *
+ * @return zero if successful otherwise failure.
+ */
+static int ecjpake_kzkp_write(mbedtls_ecjpake_context *ctx,
+                              const unsigned char *G,
+                              const unsigned char *public_key,
+                              CryptoKey *private_key,
+                              const unsigned char *public_v,
+                              CryptoKey *private_v,
+                              const char *id,
+                              unsigned char **p,
+                              const unsigned char *end)
+{
+    int ret;
+    size_t len;
+    const unsigned char *X;
+    const unsigned char *V;
+    unsigned char hash[ECC_SECP256R1_LENGTH];
+    unsigned char r[ECC_SECP256R1_LENGTH];
+    ECJPAKE_OperationGenerateZKP operationGenerateZKP;
+
+    /* write X, then the ZKP for X (V and r) */
+    ECJPAKE_ALT_CHK(tls_write_point(public_key, &X, &len, *p, end - *p));
+    *p += len;
+
+    ECJPAKE_ALT_CHK(tls_write_point(public_v, &V, &len, *p, end - *p));
+    *p += len;
+
+    /* the hash is over the points as just written */
+    ECJPAKE_ALT_CHK(ecjpake_hash(ctx->md_info, G, V, X, id, hash));
+
+    ECJPAKE_OperationGenerateZKP_init(&operationGenerateZKP);
+    operationGenerateZKP.curve              = &ECCParams_NISTP256;
+    operationGenerateZKP.myPrivateKey       = private_key;
+    operationGenerateZKP.myPrivateV         = private_v;
+    operationGenerateZKP.hash               = hash;
+    operationGenerateZKP.r                  = r;
+
+    ECJPAKE_ALT_CHK(ECJPAKE_generateZKP(ctx->handle, &operationGenerateZKP));
+
+    ECJPAKE_ALT_CHK(tls_write_scalar(r, &len, *p, end - *p));
+    *p += len;
+
+cleanup:
+    return( ret );
+}
+
 /**
  * @brief   writes two sets of emphereal public key and its ZKP.
  *
  * @param ctx   pointer to the context.
- * @param G     generator point.
  * @param id    identifier.
  * @param buf   buffer to write to.
  * @param len   length of the buffer.
@@ -807,7 +881,6 @@ cleanup:
  * @return zero if successful otherwise failure.
  */
 static int ecjpake_kzkp_kzkp_write(mbedtls_ecjpake_context *ctx,
-                                   const unsigned char *G,
                                    const char *id,
                                    unsigned char *buf,
                                    size_t len,
@@ -818,18 +891,9 @@ static int ecjpake_kzkp_kzkp_write(mbedtls_ecjpake_context *ctx,
     int ret;
     unsigned char *p = buf;
     const unsigned char *end = buf + len;
-    unsigned char hash[ECC_SECP256R1_LENGTH];
-    unsigned char r[ECC_SECP256R1_LENGTH];
 
     /* Generate round one keys */
     ECJPAKE_OperationRoundOneGenerateKeys   roundOneGenerateKeys;
-    ECJPAKE_OperationGenerateZKP            operationGenerateZKP;
-
-
-    if( end < p )
-    {
-        return( MBEDTLS_ERR_ECP_BUFFER_TOO_SMALL );
-    }
 
     /* Generate private keys */
     ECJPAKE_ALT_CHK(gen_private_key(ctx->myPrivateKeyMaterial1, f_rng, p_rng));
@@ -838,7 +902,6 @@ static int ecjpake_kzkp_kzkp_write(mbedtls_ecjpake_context *ctx,
     ECJPAKE_ALT_CHK(gen_private_key(ctx->myPrivateVMaterial2, f_rng, p_rng));
     ECJPAKE_ALT_CHK(gen_private_key(ctx->myPrivateVMaterial3, f_rng, p_rng));
 
-
     ECJPAKE_OperationRoundOneGenerateKeys_init(&roundOneGenerateKeys);
     roundOneGenerateKeys.curve             = &ECCParams_NISTP256;
     roundOneGenerateKeys.myPrivateKey1     = &ctx->myPrivateCryptoKey1;
@@ -852,72 +915,60 @@ static int ecjpake_kzkp_kzkp_write(mbedtls_ecjpake_context *ctx,
 
     ECJPAKE_ALT_CHK(ECJPAKE_roundOneGenerateKeys(ctx->handle, &roundOneGenerateKeys));
 
-     /* write X1 */
-    ECJPAKE_ALT_CHK(tls_write_point( ctx->myPublicKeyMaterial1, &len, p, end - p));
-    p += len;
-
-    ECJPAKE_ALT_CHK(ecjpake_hash(ctx->md_info,
-                                 ctx->point_format,
-                                 ECCParams_NISTP256.generatorX,
-                                 ctx->myPublicVMaterial1,
-                                 ctx->myPublicKeyMaterial1,
-                                 id,
-                                 hash));
+    /* X1 and its ZKP, then X2 and its ZKP */
+    ECJPAKE_ALT_CHK(ecjpake_kzkp_write(ctx, ecjpake_generator,
+                                       ctx->myPublicKeyMaterial1,
+                                       &ctx->myPrivateCryptoKey1,
+                                       ctx->myPublicVMaterial1,
+                                       &ctx->myPrivateCryptoV1,
+                                       id, &p, end));
+    ECJPAKE_ALT_CHK(ecjpake_kzkp_write(ctx, ecjpake_generator,
+                                       ctx->myPublicKeyMaterial2,
+                                       &ctx->myPrivateCryptoKey2,
+                                       ctx->myPublicVMaterial2,
+                                       &ctx->myPrivateCryptoV2,
+                                       id, &p, end));
 
-    big_num_reverse(hash, ECC_SECP256R1_LENGTH);
-
-    /* generate round one ZKPs */
-    ECJPAKE_OperationGenerateZKP_init(&operationGenerateZKP);
-    operationGenerateZKP.curve              = &ECCParams_NISTP256;
-    operationGenerateZKP.myPrivateKey       = &ctx->myPrivateCryptoKey1;
-    operationGenerateZKP.myPrivateV         = &ctx->myPrivateCryptoV1;
-    operationGenerateZKP.hash               = hash;
-    operationGenerateZKP.r                  = r;
-
-    ECJPAKE_ALT_CHK(ECJPAKE_generateZKP(ctx->handle, &operationGenerateZKP));
-
-    /* write ZKP for X1 (V1 and r1) */
-    ECJPAKE_ALT_CHK(tls_write_point(ctx->myPublicVMaterial1, &len, p, end - p));
-    p += len;
-
-    *p++ = ECC_SECP256R1_LENGTH;
-
-    ECJPAKE_ALT_CHK(write_binary(p, end - p, r));
-    p += ECC_SECP256R1_LENGTH;
-
-    ECJPAKE_ALT_CHK(ecjpake_hash(ctx->md_info,
-                                 ctx->point_format,
-                                 ECCParams_NISTP256.generatorX,
-                                 ctx->myPublicVMaterial2,
-                                 ctx->myPublicKeyMaterial2,
-                                 id,
-                                 hash));
-
-    big_num_reverse(hash, ECC_SECP256R1_LENGTH);
-
-    ECJPAKE_OperationGenerateZKP_init(&operationGenerateZKP);
-    operationGenerateZKP.curve              = &ECCParams_NISTP256;
-    operationGenerateZKP.myPrivateKey       = &ctx->myPrivateCryptoKey2;
-    operationGenerateZKP.myPrivateV         = &ctx->myPrivateCryptoV2;
-    operationGenerateZKP.hash               = hash;
-    operationGenerateZKP.r                  = r;
-
-    ECJPAKE_ALT_CHK(ECJPAKE_generateZKP(ctx->handle, &operationGenerateZKP));
-
-    /* write X2 */
-    ECJPAKE_ALT_CHK(tls_write_point(ctx->myPublicKeyMaterial2, &len, p, end - p));
-    p += len;
+    *olen = p - buf;
 
-    /* write ZKP for X2 */
-    ECJPAKE_ALT_CHK(tls_write_point(ctx->myPublicVMaterial2, &len, p, end - p));
-    p += len;
+cleanup:
+    return( ret );
+}
 
-    *p++ = ECC_SECP256R1_LENGTH;
-    ECJPAKE_ALT_CHK(write_binary(p, end - p, r));
+/**
+ * @brief Generates the round two keys, once per handshake. Both reading and
+ *        writing round two need them, in either order.
+ *
+ * @param ctx   pointer to the context.
+ *
+ * @return zero if successful otherwise failure.
+ */
+static int ecjpake_round_two_keys(mbedtls_ecjpake_context *ctx)
+{
+    int ret = 0;
+    ECJPAKE_OperationRoundTwoGenerateKeys   roundTwoGenerateKeys;
 
-    p += ECC_SECP256R1_LENGTH;
+    if (ctx->roundTwoGenerated == false)
+    {
+        ECJPAKE_OperationRoundTwoGenerateKeys_init(&roundTwoGenerateKeys);
+        roundTwoGenerateKeys.curve                = &ECCParams_NISTP256;
+        roundTwoGenerateKeys.myPrivateKey2        = &ctx->myPrivateCryptoKey2;
+        roundTwoGenerateKeys.myPublicKey1         = &ctx->myPublicCryptoKey1;
+        roundTwoGenerateKeys.myPublicKey2         = &ctx->myPublicCryptoKey2;
+        roundTwoGenerateKeys.theirPublicKey1      = &ctx->theirPublicCryptoKey1;
+        roundTwoGenerateKeys.theirPublicKey2      = &ctx->theirPublicCryptoKey2;
+        roundTwoGenerateKeys.preSharedSecret      = &ctx->preSharedSecretCryptoKey;
+        roundTwoGenerateKeys.theirNewGenerator    = &ctx->theirGeneratorKey;
+        roundTwoGenerateKeys.myNewGenerator       = &ctx->myGeneratorKey;
+        roundTwoGenerateKeys.myCombinedPrivateKey = &ctx->myCombinedPrivateKey;
+        roundTwoGenerateKeys.myCombinedPublicKey  = &ctx->myCombinedPublicKey;
+        roundTwoGenerateKeys.myPrivateV           = &ctx->myPrivateCryptoV3;
+        roundTwoGenerateKeys.myPublicV            = &ctx->myPublicCryptoV3;
 
-    *olen = p - buf;
+        ECJPAKE_ALT_CHK(ECJPAKE_roundTwoGenerateKeys(ctx->handle,
+                                                     &roundTwoGenerateKeys));
+        ctx->roundTwoGenerated = true;
+    }
 
 cleanup:
     return( ret );
@@ -930,16 +981,22 @@ int mbedtls_ecjpake_read_round_one( mbedtls_ecjpake_context *ctx,
                                     const unsigned char *buf,
                                     size_t len )
 {
-    return ecjpake_kzkp_kzkp_read(ctx,
-                                  &ctx->nistP256GeneratorCryptoKey,
-                                  (uint8_t*)ECCParams_NISTP256.generatorX,
-                                  ctx->theirPublicKeyMaterial1,
-                                  &ctx->theirPublicCryptoKey1,
-                                  ctx->theirPublicKeyMaterial2,
-                                  &ctx->theirPublicCryptoKey2,
-                                  ID_PEER,
-                                  buf,
-                                  len);
+    uint64_t start = platformAlarmGetNowUs();
+    int ret;
+
+    ret = ecjpake_kzkp_kzkp_read(ctx,
+                                 &ctx->nistP256GeneratorCryptoKey,
+                                 ecjpake_generator,
+                                 ctx->theirPublicKeyMaterial1,
+                                 &ctx->theirPublicCryptoKey1,
+                                 ctx->theirPublicKeyMaterial2,
+                                 &ctx->theirPublicCryptoKey2,
+                                 ID_PEER,
+                                 buf,
+                                 len);
+
+    ecjpake_profile_step(PlatformEcjpake_readRoundOne, start, ret);
+    return( ret );
 }
 
 /*
@@ -950,8 +1007,13 @@ int mbedtls_ecjpake_write_round_one(mbedtls_ecjpake_context *ctx,
                                     int (*f_rng)(void *, unsigned char *, size_t),
                                     void *p_rng)
 {
-    return( ecjpake_kzkp_kzkp_write(ctx, ECCParams_NISTP256.generatorX,
-                                    ID_MINE, buf, len, olen, f_rng, p_rng));
+    uint64_t start = platformAlarmGetNowUs();
+    int ret;
+
+    ret = ecjpake_kzkp_kzkp_write(ctx, ID_MINE, buf, len, olen, f_rng, p_rng);
+
+    ecjpake_profile_step(PlatformEcjpake_writeRoundOne, start, ret);
+    return( ret );
 }
 
 /*
@@ -961,30 +1023,13 @@ int mbedtls_ecjpake_read_round_two( mbedtls_ecjpake_context *ctx,
                                     const unsigned char *buf,
                                     size_t len )
 {
+    uint64_t start = platformAlarmGetNowUs();
     int ret;
     const unsigned char *p = buf;
     const unsigned char *end = buf + len;
+    unsigned char generator[ECJPAKE_POINT_LEN];
 
-    // Generate round two keys
-    ECJPAKE_OperationRoundTwoGenerateKeys   roundTwoGenerateKeys;
-
-    ECJPAKE_OperationRoundTwoGenerateKeys_init(&roundTwoGenerateKeys);
-    roundTwoGenerateKeys.curve                 = &ECCParams_NISTP256;
-    roundTwoGenerateKeys.myPrivateKey2         = &ctx->myPrivateCryptoKey2;
-    roundTwoGenerateKeys.myPublicKey1          = &ctx->myPublicCryptoKey1;
-    roundTwoGenerateKeys.myPublicKey2          = &ctx->myPublicCryptoKey2;
-    roundTwoGenerateKeys.theirPublicKey1       = &ctx->theirPublicCryptoKey1;
-    roundTwoGenerateKeys.theirPublicKey2       = &ctx->theirPublicCryptoKey2;
-    roundTwoGenerateKeys.preSharedSecret       = &ctx->preSharedSecretCryptoKey;
-    roundTwoGenerateKeys.theirNewGenerator     = &ctx->theirGeneratorKey;
-    roundTwoGenerateKeys.myNewGenerator        = &ctx->myGeneratorKey;
-    roundTwoGenerateKeys.myCombinedPrivateKey  = &ctx->myCombinedPrivateKey;
-    roundTwoGenerateKeys.myCombinedPublicKey   = &ctx->myCombinedPublicKey;
-    roundTwoGenerateKeys.myPrivateV            = &ctx->myPrivateCryptoV3;
-    roundTwoGenerateKeys.myPublicV             = &ctx->myPublicCryptoV3;
-
-    ECJPAKE_ALT_CHK(ECJPAKE_roundTwoGenerateKeys(ctx->handle,
-                                                 &roundTwoGenerateKeys));
+    ECJPAKE_ALT_CHK(ecjpake_round_two_keys(ctx));
 
     /*
      * struct {
@@ -1026,13 +1071,17 @@ int mbedtls_ecjpake_read_round_two( mbedtls_ecjpake_context *ctx,
         }
     }
 
+    /* their generator is not on the wire, it goes into the hash once */
+    point_encode(generator, ctx->theirGenerator);
+
     ECJPAKE_ALT_CHK(ecjpake_k_zkp_read(ctx, &ctx->theirGeneratorKey,
-                                       ctx->theirGenerator,
+                                       generator,
                                        ctx->theirCombinedPublicKeyMaterial1,
                                        &ctx->theirCombinedPublicKey,
                                        ID_PEER, &p, end));
 
 cleanup:
+    ecjpake_profile_step(PlatformEcjpake_readRoundTwo, start, ret);
     return( ret );
 
 }
@@ -1045,57 +1094,17 @@ int mbedtls_ecjpake_write_round_two( mbedtls_ecjpake_context *ctx,
                             int (*f_rng)(void *, unsigned char *, size_t),
                             void *p_rng )
 {
+    uint64_t start = platformAlarmGetNowUs();
     int ret;
-    unsigned char hash[ECC_SECP256R1_LENGTH];
-    unsigned char r[ECC_SECP256R1_LENGTH];
     unsigned char *p = buf;
     const unsigned char *end = buf + len;
+    unsigned char generator[ECJPAKE_POINT_LEN];
     size_t ec_len;
 
-    ECJPAKE_OperationGenerateZKP            operationGenerateZKP;
+    (void)f_rng;
+    (void)p_rng;
 
-    if (ctx->roundTwoGenerated == false)
-    {
-        ECJPAKE_OperationRoundTwoGenerateKeys   roundTwoGenerateKeys;
-
-        ECJPAKE_OperationRoundTwoGenerateKeys_init(&roundTwoGenerateKeys);
-        roundTwoGenerateKeys.curve                = &ECCParams_NISTP256;
-        roundTwoGenerateKeys.myPrivateKey2        = &ctx->myPrivateCryptoKey2;
-        roundTwoGenerateKeys.myPublicKey1         = &ctx->myPublicCryptoKey1;
-        roundTwoGenerateKeys.myPublicKey2         = &ctx->myPublicCryptoKey2;
-        roundTwoGenerateKeys.theirPublicKey1      = &ctx->theirPublicCryptoKey1;
-        roundTwoGenerateKeys.theirPublicKey2      = &ctx->theirPublicCryptoKey2;
-        roundTwoGenerateKeys.preSharedSecret      = &ctx->preSharedSecretCryptoKey;
-        roundTwoGenerateKeys.theirNewGenerator    = &ctx->theirGeneratorKey;
-        roundTwoGenerateKeys.myNewGenerator       = &ctx->myGeneratorKey;
-        roundTwoGenerateKeys.myCombinedPrivateKey = &ctx->myCombinedPrivateKey;
-        roundTwoGenerateKeys.myCombinedPublicKey  = &ctx->myCombinedPublicKey;
-        roundTwoGenerateKeys.myPrivateV           = &ctx->myPrivateCryptoV3;
-        roundTwoGenerateKeys.myPublicV            = &ctx->myPublicCryptoV3;
-
-        ECJPAKE_ALT_CHK(ECJPAKE_roundTwoGenerateKeys(ctx->handle,
-                                                     &roundTwoGenerateKeys));
-        ctx->roundTwoGenerated = true;
-    }
-
-    ECJPAKE_ALT_CHK(ecjpake_hash(ctx->md_info,
-                                 ctx->point_format,
-                                 ctx->myGenerator,
-                                 ctx->myPublicVMaterial3,
-                                 ctx->myCombinedPublicKeyMaterial1,
-                                 ID_MINE,
-                                 hash));
-    big_num_reverse(hash, ECC_SECP256R1_LENGTH);
-
-
-    ECJPAKE_OperationGenerateZKP_init(&operationGenerateZKP);
-    operationGenerateZKP.curve              = &ECCParams_NISTP256;
-    operationGenerateZKP.myPrivateKey       = &ctx->myCombinedPrivateKey;
-    operationGenerateZKP.myPrivateV         = &ctx->myPrivateCryptoV3;
-    operationGenerateZKP.hash               = hash;
-    operationGenerateZKP.r                  = r;
-
-    ECJPAKE_ALT_CHK(ECJPAKE_generateZKP(ctx->handle, &operationGenerateZKP));
+    ECJPAKE_ALT_CHK(ecjpake_round_two_keys(ctx));
 
      /*
      * Now write things out
@@ -1124,25 +1133,20 @@ int mbedtls_ecjpake_write_round_two( mbedtls_ecjpake_context *ctx,
         goto cleanup;
     }
 
-    /* write public key X */
-    ECJPAKE_ALT_CHK(tls_write_point(ctx->myCombinedPublicKeyMaterial1,
-                                    &ec_len,
-                                    p,
-                                    end - p));
-    p += ec_len;
+    /* public key X and its ZKP (V and r), over my new generator */
+    point_encode(generator, ctx->myGenerator);
 
-    /* write ZKP for X (V and r) */
-    ECJPAKE_ALT_CHK(tls_write_point(ctx->myPublicVMaterial3, &len, p, end - p));
-    p += len;
-
-    *p = ECC_SECP256R1_LENGTH;
-    p++;
-    ECJPAKE_ALT_CHK(write_binary(p, end - p, r));
-    p += ECC_SECP256R1_LENGTH;
+    ECJPAKE_ALT_CHK(ecjpake_kzkp_write(ctx, generator,
+                                       ctx->myCombinedPublicKeyMaterial1,
+                                       &ctx->myCombinedPrivateKey,
+                                       ctx->myPublicVMaterial3,
+                                       &ctx->myPrivateCryptoV3,
+                                       ID_MINE, &p, end));
 
     *olen = p - buf;
 
 cleanup:
+    ecjpake_profile_step(PlatformEcjpake_writeRoundTwo, start, ret);
     return( ret );
 }
 
@@ -1154,12 +1158,16 @@ int mbedtls_ecjpake_derive_secret( mbedtls_ecjpake_context *ctx,
                             int (*f_rng)(void *, unsigned char *, size_t),
                             void *p_rng )
 {
+    uint64_t start = platformAlarmGetNowUs();
     int ret;
-    unsigned char kx[ECC_SECP256R1_LENGTH] = {0};
+    unsigned char kx[ECC_SECP256R1_LENGTH];
     ECJPAKE_OperationComputeSharedSecret    computeSharedSecret;
     CryptoKey                               sharedSecretCryptoKey;
     uint8_t                                 sharedSecretKeyingMaterial1[64];
 
+    (void)f_rng;
+    (void)p_rng;
+
     *olen = mbedtls_md_get_size( ctx->md_info );
     if( len < *olen )
     {
@@ -1183,14 +1191,27 @@ int mbedtls_ecjpake_derive_secret( mbedtls_ecjpake_context *ctx,
     ECJPAKE_ALT_CHK(ECJPAKE_computeSharedSecret(ctx->handle,
                                                 &computeSharedSecret));
 
-    memcpy(kx, sharedSecretKeyingMaterial1, ECC_SECP256R1_LENGTH);
-    big_num_reverse(kx, 32);
+    /* the premaster secret is the hash of X, big endian */
+    copy_reversed(kx, sharedSecretKeyingMaterial1, ECC_SECP256R1_LENGTH);
     ECJPAKE_ALT_CHK(mbedtls_md(ctx->md_info, kx, ECC_SECP256R1_LENGTH, buf));
 
 cleanup:
+    memset(kx, 0, sizeof(kx));
+    memset(sharedSecretKeyingMaterial1, 0,
+           sizeof(sharedSecretKeyingMaterial1));
+
+    ecjpake_profile_step(PlatformEcjpake_deriveSecret, start, ret);
     return ret;
 }
 
+/**
+ * Function documented in platform.h
+ */
+void platformEcjpakeGetProfile(PlatformEcjpake_Profile *aProfile)
+{
+    *aProfile = ecjpake_profile;
+}
+
 #undef ID_MINE
 #undef ID_PEER
 
@@ -47,8 +47,10 @@
 #ifndef RTOS_PLATFORM_H_
 #define RTOS_PLATFORM_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#include <openthread/error.h>
 #include <openthread/instance.h>
 
 #ifdef __cplusplus
@@ -104,6 +106,63 @@ void platformAlarmMicroSignal(void);
  */
 void platformAlarmMicroProcess(otInstance *aInstance);
 
+/**
+ * Alarms sharing the clock of the alarm module, each has one deadline in
+ * its queue.
+ */
+typedef enum
+{
+    PlatformAlarm_milli,
+    PlatformAlarm_micro,
+    PlatformAlarm_count
+} PlatformAlarm_Id;
+
+/**
+ * This method gets the time the alarms are kept in, read from the always-on
+ * RTC. It counts in steps of one RTC period, about 31 us.
+ *
+ * @return us since the RTC was started.
+ */
+uint64_t platformAlarmGetNowUs(void);
+
+/**
+ * This method queues an alarm. The alarm module signals it once the time
+ * reaches the deadline, and sets its clock for the earliest deadline queued.
+ * An alarm already due is signalled at once.
+ *
+ * @param[in] aId        Alarm to queue, replaces its previous deadline.
+ * @param[in] aDeadline  Time to signal it at, see platformAlarmGetNowUs().
+ */
+void platformAlarmQueueStart(PlatformAlarm_Id aId, uint64_t aDeadline);
+
+/**
+ * This method removes an alarm from the queue.
+ *
+ * @param[in] aId        Alarm to remove.
+ */
+void platformAlarmQueueStop(PlatformAlarm_Id aId);
+
+/**
+ * Counters kept by the alarm module since it was initialized.
+ */
+typedef struct
+{
+    uint32_t wakeups;       // Times the alarm clock expired
+    uint32_t early;         // Expiries before any deadline, long sleeps
+    uint32_t fired;         // Alarms signalled by the clock
+    uint32_t clockSets;     // Times the clock was set for a new deadline
+    uint32_t lateMax;       // Most us an alarm was signalled after its deadline
+    uint32_t lateTotal;     // Sum of the us each alarm was signalled late
+    uint32_t uptime;        // Seconds since the RTC was started
+} PlatformAlarm_Stats;
+
+/**
+ * This method gets a snapshot of the alarm module counters.
+ *
+ * @param[out] aStats   Counters structure to fill in.
+ */
+void platformAlarmGetStats(PlatformAlarm_Stats *aStats);
+
 /**
  * This method initializes the radio service used by OpenThread.
  *
@@ -138,6 +197,190 @@ void platformRandomSignal(void);
  */
 void platformRandomProcess(void);
 
+/**
+ * Counters kept by the random module since it was initialized.
+ */
+typedef struct
+{
+    uint32_t requests;      // Requests served by the DRBG
+    uint32_t reseeds;       // Times the DRBG was reseeded after its first seed
+    uint32_t entropyBytes;  // Bytes of entropy gathered by the TRNG
+    uint32_t waits;         // Times a caller waited for the TRNG
+    uint32_t trngErrors;    // TRNG requests that failed
+    uint32_t poolCount;     // Bytes of entropy in the pool
+} PlatformRandom_Stats;
+
+/**
+ * This method gets a snapshot of the random module counters.
+ *
+ * @param[out] aStats   Counters structure to fill in.
+ */
+void platformRandomGetStats(PlatformRandom_Stats *aStats);
+
+/**
+ * An 802.15.4 frame to secure with AES-CCM*, with a 13 byte nonce.
+ */
+typedef struct
+{
+    const uint8_t *key;         // 128 bit key
+    const uint8_t *nonce;       // 13 byte nonce
+    const uint8_t *header;      // Authenticated, not encrypted
+    uint8_t *payload;           // Encrypted or decrypted in place
+    uint8_t *tag;               // MIC, written on encrypt, checked on decrypt
+    uint16_t headerLength;
+    uint16_t payloadLength;
+    uint8_t tagLength;          // 0, 4, 6, 8, 10, 12, 14 or 16
+} PlatformAesCcm_Frame;
+
+/**
+ * How the AES-CCM* module runs a frame.
+ */
+typedef enum
+{
+    PlatformAesCcm_auto,        // One accelerator job, else per block
+    PlatformAesCcm_perBlock     // One AES block at a time
+} PlatformAesCcm_Path;
+
+/**
+ * This method encrypts a frame and computes its MIC.
+ *
+ * @param[in,out] aFrame    Frame to encrypt.
+ * @param[in]     aPath     Path to run it on.
+ *
+ * @retval OT_ERROR_NONE          The frame was encrypted.
+ * @retval OT_ERROR_INVALID_ARGS  The frame is not valid for CCM*.
+ * @retval OT_ERROR_FAILED        The accelerator failed.
+ */
+otError platformAesCcmEncrypt(PlatformAesCcm_Frame *aFrame,
+                              PlatformAesCcm_Path aPath);
+
+/**
+ * This method decrypts a frame and checks its MIC.
+ *
+ * @param[in,out] aFrame    Frame to decrypt.
+ * @param[in]     aPath     Path to run it on.
+ *
+ * @retval OT_ERROR_NONE          The frame was decrypted and its MIC matches.
+ * @retval OT_ERROR_SECURITY      The MIC does not match.
+ * @retval OT_ERROR_INVALID_ARGS  The frame is not valid for CCM*.
+ * @retval OT_ERROR_FAILED        The accelerator failed.
+ */
+otError platformAesCcmDecrypt(PlatformAesCcm_Frame *aFrame,
+                              PlatformAesCcm_Path aPath);
+
+/**
+ * Counters kept by the AES-CCM* module since boot.
+ */
+typedef struct
+{
+    uint32_t jobs;          // Frames run in one accelerator job
+    uint32_t perBlock;      // Frames run one AES block at a time
+    uint32_t fallbacks;     // Jobs the accelerator could not take
+    uint32_t micFailures;   // Decrypted frames with a wrong MIC
+} PlatformAesCcm_Stats;
+
+/**
+ * This method gets a snapshot of the AES-CCM* module counters.
+ *
+ * @param[out] aStats   Counters structure to fill in.
+ */
+void platformAesCcmGetStats(PlatformAesCcm_Stats *aStats);
+
+/**
+ * Steps of an EC-JPAKE handshake, as the DTLS handshake of the joiner runs
+ * them.
+ */
+typedef enum
+{
+    PlatformEcjpake_writeRoundOne,
+    PlatformEcjpake_readRoundOne,
+    PlatformEcjpake_readRoundTwo,
+    PlatformEcjpake_writeRoundTwo,
+    PlatformEcjpake_deriveSecret,
+    PlatformEcjpake_opCount
+} PlatformEcjpake_Op;
+
+/**
+ * Time the EC-JPAKE module spent on the last handshake.
+ */
+typedef struct
+{
+    uint32_t handshakes;    // Handshakes set up since boot
+    uint32_t failures;      // Steps that failed since boot
+    uint64_t start[PlatformEcjpake_opCount];    // When each step started, 0
+                                                // if it did not run
+    uint32_t us[PlatformEcjpake_opCount];       // us each step took
+} PlatformEcjpake_Profile;
+
+/**
+ * This method gets the profile of the last EC-JPAKE handshake.
+ *
+ * @param[out] aProfile Profile structure to fill in.
+ */
+void platformEcjpakeGetProfile(PlatformEcjpake_Profile *aProfile);
+
+/**
+ * States the energy module accounts time in. While the radio is on the
+ * device is in rx or tx, otherwise in the state of the MCU.
+ */
+typedef enum
+{
+    PlatformEnergy_rx,
+    PlatformEnergy_tx,
+    PlatformEnergy_active,
+    PlatformEnergy_idle,
+    PlatformEnergy_standby,
+    PlatformEnergy_stateCount
+} PlatformEnergy_State;
+
+/**
+ * This method starts the energy accounting. It takes over the power policy
+ * of the board, running it from its own to time the idle and standby
+ * states.
+ */
+void platformEnergyInit(void);
+
+/**
+ * This method tells the energy module the radio core was turned on or off.
+ *
+ * @param[in] aOn   true when the radio was turned on.
+ */
+void platformEnergyRadioOn(bool aOn);
+
+/**
+ * This method tells the energy module a frame was sent. Its time on the
+ * air is counted as tx instead of rx. May be called from the radio
+ * callbacks.
+ *
+ * @param[in] aLength   Length of the PSDU sent, FCS included.
+ */
+void platformEnergyRadioTx(uint16_t aLength);
+
+/**
+ * Time spent in each state since the energy counters were cleared, and the
+ * charge drawn estimated from the current of each state.
+ */
+typedef struct
+{
+    uint32_t ms[PlatformEnergy_stateCount]; // ms in each state
+    uint32_t chargeUc;      // Charge drawn in uC
+    uint32_t averageNa;     // Average current in nA
+    uint32_t txFrames;      // Frames sent, retries included
+    uint32_t radioStarts;   // Times the radio was turned on
+} PlatformEnergy_Stats;
+
+/**
+ * This method gets a snapshot of the energy counters.
+ *
+ * @param[out] aStats   Counters structure to fill in.
+ */
+void platformEnergyGetStats(PlatformEnergy_Stats *aStats);
+
+/**
+ * This method clears the energy counters, to measure from now on.
+ */
+void platformEnergyClear(void);
+
 /**
  * Signal the processing loop to process the uart module.
  *
@@ -150,6 +393,28 @@ void platformUartSignal(void);
  */
 void platformUartProcess(void);
 
+/**
+ * Counters kept by the uart module since it was enabled.
+ */
+typedef struct
+{
+    uint32_t rxBytes;       // Bytes received
+    uint32_t txBytes;       // Bytes sent
+    uint32_t rxOverruns;    // Reads that lost bytes to a hardware overrun
+    uint32_t rxErrors;      // Reads with framing, parity or break errors
+    uint32_t rxStalls;      // Times reception paused on a full buffer
+    uint32_t txPartial;     // Writes that ended short and were continued
+    uint16_t rxHighWater;   // Most bytes waiting for the stack
+    uint16_t txHighWater;   // Most bytes waiting for the uart
+} PlatformUart_Stats;
+
+/**
+ * This method gets a snapshot of the uart module counters.
+ *
+ * @param[out] aStats   Counters structure to fill in.
+ */
+void platformUartGetStats(PlatformUart_Stats *aStats);
+
 /**
  * Signal the processing loop to process the spi module.
  *
@@ -161,6 +426,28 @@ void platformSpiSignal(void);
  *
  */
 void platformSpiProcess(void);
+
+/**
+ * Counters kept by the spi module since it was enabled.
+ */
+typedef struct
+{
+    uint32_t transactions;  // Transactions clocked by the host
+    uint32_t hostInts;      // Times the host interrupt line was asserted
+    uint32_t crcErrors;     // Host frames dropped for a bad CRC
+    uint32_t rxShort;       // Transactions ended inside the host frame
+    uint32_t txShort;       // Transactions ended inside our frame
+    uint32_t busy;          // Prepares refused, a transaction was pending
+    uint32_t failed;        // Prepares the driver did not queue
+    uint16_t maxLength;     // Longest transaction in bytes
+} PlatformSpi_Stats;
+
+/**
+ * This method gets a snapshot of the spi module counters.
+ *
+ * @param[out] aStats   Counters structure to fill in.
+ */
+void platformSpiGetStats(PlatformSpi_Stats *aStats);
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -56,7 +56,9 @@
 
 #include <ti/devices/DeviceFamily.h>
 
+#include <ti/drivers/GPIO.h>
 #include <ti/drivers/SPI.h>
+#include <ti/drivers/dpl/HwiP.h>
 #include <ti/drivers/spi/SPICC26X2DMA.h>
 #include <ti/sysbios/BIOS.h>
 #include <ti/sysbios/knl/Event.h>
@@ -64,8 +66,23 @@
 #include "Board.h"
 #include "platform.h"
 
+/*
+ * Clock rate of the host. The SSI module follows the host clock in slave
+ * mode, up to a twelfth of the 48 MHz system clock.
+ */
+#ifndef PLATFORM_SPI_FREQ
+#define PLATFORM_SPI_FREQ               4000000
+#endif
+
+/*
+ * Host interrupt line, driven low while a frame is waiting for the host to
+ * clock it out so that the host does not have to poll.
+ */
+#ifndef PLATFORM_SPI_HOST_INT
+#define PLATFORM_SPI_HOST_INT           Board_SPI_SLAVE_READY
+#endif
+
 #define PLATFORM_SPI_DATA_SIZE          8
-#define PLATFORM_SPI_FREQ               1000000
 #define PLATFORM_SPI_MODE               SPI_SLAVE
 #define PLATFORM_SPI_TRANSFER_MODE      SPI_MODE_CALLBACK
 #define PLATFORM_SPI_FRAME_FORMAT       SPI_POL0_PHA1
@@ -79,6 +96,8 @@
 #define PLATFORM_SPI_GET_CCF(X)         (X[0] & 0x20)
 #define PLATFORM_SPI_SET_CCF(X)         (X[0] = X[0] | 0x20)
 #define PLATFORM_SPI_GET_LEN(X)         (X[3] | (X[4] << 8))
+#define PLATFORM_SPI_HEADER_LEN         5
+#define PLATFORM_SPI_CRC_LEN            2
 
 otPlatSpiSlaveTransactionCompleteCallback sCompleteCallback = NULL;
 otPlatSpiSlaveTransactionProcessCallback sProcessCallback  = NULL;
@@ -86,12 +105,17 @@ void *sContext         = NULL;
 
 SPI_Handle sSpiHandle;
 SPI_Transaction sSpiTransaction[PLATFORM_SPI_MAX_TRANSACTIONS];
-uint32_t spiTransactions = 0;
-uint32_t spiCallbacks = 0;
-uint32_t spiCrcErrors = 0;
 size_t spiTxSize = 0;
 size_t spiRxSize = 0;
 
+/* Bytes the driver may write to the input buffer, with room for a CRC */
+static size_t spiRxCount = 0;
+
+/* Host interrupt line is asserted */
+static bool spiHostIntAsserted = false;
+
+static PlatformSpi_Stats spiStats;
+
 #ifdef PLATFORM_SPI_CRC_SUPPORT
 /**
  * Function to calculater CRC.
@@ -136,7 +160,7 @@ static uint16_t otPlatSpiFcs(uint8_t *buffer)
     };
 
     uint16_t fcs = 0xFFFF;
-    uint32_t length = PLATFORM_SPI_GET_LEN(buffer) + 5;
+    uint32_t length = PLATFORM_SPI_GET_LEN(buffer) + PLATFORM_SPI_HEADER_LEN;
     uint16_t i;
 
     if (length > OPENTHREAD_CONFIG_NCP_SPI_BUFFER_SIZE - 2)
@@ -154,6 +178,25 @@ static uint16_t otPlatSpiFcs(uint8_t *buffer)
 }
 #endif
 
+/**
+ * Drives the host interrupt line, active low.
+ */
+static void spiHostInt(bool assert)
+{
+    uintptr_t key = HwiP_disable();
+
+    if (assert != spiHostIntAsserted)
+    {
+        spiHostIntAsserted = assert;
+        GPIO_write(PLATFORM_SPI_HOST_INT, assert ? 0 : 1);
+        if (assert)
+        {
+            spiStats.hostInts++;
+        }
+    }
+    HwiP_restore(key);
+}
+
 /**
  * This method performs spi driver processing.
  *
@@ -166,6 +209,16 @@ void platformSpiProcess(void)
     }
 }
 
+/**
+ * Function documented in platform.h
+ */
+void platformSpiGetStats(PlatformSpi_Stats *aStats)
+{
+    uintptr_t key = HwiP_disable();
+    *aStats = spiStats;
+    HwiP_restore(key);
+}
+
 /**
  * Callback for when the SPI driver finishes transaction.
  */
@@ -182,14 +235,15 @@ void platSpiCallback(SPI_Handle handle, SPI_Transaction *transaction)
         uint8_t  *aInputBuf          = sSpiTransaction[0].rxBuf;
         uint16_t  aInputBufLen       = spiRxSize;
         uint16_t  aTransactionLength = 0;
+        uint32_t  offset;
+        uint32_t  frameEnd;
 #ifdef PLATFORM_SPI_CRC_SUPPORT
         uint16_t fcs;
         uint16_t fcsRx;
-        uint16_t offset;
 #endif
 
         transferComplete = false;
-        nTransactions = ((uint32_t)transaction - (uint32_t)&sSpiTransaction[0])
+        nTransactions = ((uintptr_t)transaction - (uintptr_t)&sSpiTransaction[0])
                        / sizeof(SPI_Transaction) + 1;
         for (i = 0; !transferComplete && (i < nTransactions); i++)
         {
@@ -200,36 +254,70 @@ void platSpiCallback(SPI_Handle handle, SPI_Transaction *transaction)
             }
         }
 
-#ifdef PLATFORM_SPI_CRC_SUPPORT
-    /* check RX crc, if bad, aTransactionLength = 0 */
-    if (transferComplete && PLATFORM_SPI_GET_CRC(aInputBuf))
-    {
-        fcs = otPlatSpiFcs(aInputBuf);
-        if (fcs != 0xFFFF)
+        if (!transferComplete)
         {
-            offset = PLATFORM_SPI_GET_LEN(aInputBuf) + 5;
-            fcsRx = aInputBuf[offset] | (aInputBuf[offset + 1] << 8);
-            if (fcs != fcsRx)
-            {
-                aTransactionLength = 0;
-                spiCrcErrors++;
-            }
+            return;
         }
-        else
+
+        /* the host has clocked the frame it was asked for */
+        spiHostInt(false);
+
+        spiStats.transactions++;
+        if (aTransactionLength > spiStats.maxLength)
         {
-            aTransactionLength = 0;
-            spiCrcErrors++;
+            spiStats.maxLength = aTransactionLength;
         }
-    }
+
+        /* our frame did not fit, the host has to clock it again */
+        if (aOutputBufLen >= PLATFORM_SPI_HEADER_LEN
+            && PLATFORM_SPI_GET_LEN(aOutputBuf) > 0
+            && aOutputBufLen > aTransactionLength)
+        {
+            spiStats.txShort++;
+        }
+
+        if (aTransactionLength >= PLATFORM_SPI_HEADER_LEN
+            && aInputBufLen >= PLATFORM_SPI_HEADER_LEN)
+        {
+            offset = PLATFORM_SPI_GET_LEN(aInputBuf) + PLATFORM_SPI_HEADER_LEN;
+            frameEnd = offset;
+#ifdef PLATFORM_SPI_CRC_SUPPORT
+            if (PLATFORM_SPI_GET_CRC(aInputBuf))
+            {
+                frameEnd += PLATFORM_SPI_CRC_LEN;
+            }
 #endif
+            if (offset > PLATFORM_SPI_HEADER_LEN && frameEnd > aTransactionLength)
+            {
+                /* the host ended the transaction inside its own frame */
+                spiStats.rxShort++;
+                if (offset <= aTransactionLength)
+                {
+                    /* only the CRC is missing, do not pass the frame on */
+                    aTransactionLength = 0;
+                }
+            }
+#ifdef PLATFORM_SPI_CRC_SUPPORT
+            /* check RX crc, if bad, aTransactionLength = 0 */
+            else if (frameEnd > offset && frameEnd <= aTransactionLength
+                     && frameEnd <= spiRxCount)
+            {
+                fcs = otPlatSpiFcs(aInputBuf);
+                fcsRx = aInputBuf[offset] | (aInputBuf[offset + 1] << 8);
+                if (fcs == 0xFFFF || fcs != fcsRx)
+                {
+                    aTransactionLength = 0;
+                    spiStats.crcErrors++;
+                }
+            }
+#endif
+        }
 
-        if (transferComplete && sCompleteCallback(sContext, aOutputBuf, aOutputBufLen, aInputBuf,
+        if (sCompleteCallback(sContext, aOutputBuf, aOutputBufLen, aInputBuf,
                               aInputBufLen, aTransactionLength))
         {
             platformSpiSignal();
         }
-        spiCallbacks++;
-
     }
 }
 
@@ -260,6 +348,11 @@ otError otPlatSpiSlaveEnable(otPlatSpiSlaveTransactionCompleteCallback aComplete
 
     SPI_control(sSpiHandle, SPICC26X2DMA_CMD_RETURN_PARTIAL_ENABLE, NULL);
 
+    /* host interrupt line starts deasserted */
+    GPIO_setConfig(PLATFORM_SPI_HOST_INT, GPIO_CFG_OUT_STD | GPIO_CFG_OUT_HIGH);
+    spiHostIntAsserted = false;
+    memset(&spiStats, 0, sizeof(spiStats));
+
     sCompleteCallback = aCompleteCallback;
     sProcessCallback  = aProcessCallback;
     sContext          = aContext;
@@ -272,6 +365,7 @@ otError otPlatSpiSlaveEnable(otPlatSpiSlaveTransactionCompleteCallback aComplete
     sSpiTransaction[0].arg    = (void *) PLATFORM_SPI_LAST_TRANSACTION;
     spiTxSize = 0;
     spiRxSize = 0;
+    spiRxCount = 0;
 
     transferOk = SPI_transfer(sSpiHandle, (SPI_Transaction *)&sSpiTransaction[0]);
     if (!transferOk)
@@ -294,6 +388,8 @@ void otPlatSpiSlaveDisable(void)
     {
         SPI_transferCancel(sSpiHandle);
         SPI_close(sSpiHandle);
+        sSpiHandle = NULL;
+        spiHostInt(false);
 
         sCompleteCallback = NULL;
         sProcessCallback  = NULL;
@@ -313,7 +409,7 @@ otError otPlatSpiSlavePrepareTransaction(uint8_t *aOutputBuf, uint16_t aOutputBu
     uint16_t fcs;
     uint16_t offset;
 #endif
-    
+
     otEXPECT_ACTION(sSpiTransaction[0].status != SPI_TRANSFER_STARTED, retval = OT_ERROR_BUSY);
     otEXPECT_ACTION(!(sSpiTransaction[0].status != SPI_TRANSFER_PEND_CSN_ASSERT
                    && sSpiTransaction[1].status == SPI_TRANSFER_STARTED),
@@ -328,7 +424,8 @@ otError otPlatSpiSlavePrepareTransaction(uint8_t *aOutputBuf, uint16_t aOutputBu
 #if 0 // TIDRIVERS-1816 issue
         SPI_transferCancel(sSpiHandle);
 #else
-        return OT_ERROR_BUSY;
+        retval = OT_ERROR_BUSY;
+        goto exit;
 #endif
     }
 
@@ -338,7 +435,6 @@ otError otPlatSpiSlavePrepareTransaction(uint8_t *aOutputBuf, uint16_t aOutputBu
         aInputBuf = sSpiTransaction[0].rxBuf;
         aInputBufLen = spiRxSize;
     }
-    spiTransactions++;
     spiTxSize = aOutputBufLen;
     spiRxSize = aInputBufLen;
     spiIndex = 0;
@@ -354,17 +450,22 @@ otError otPlatSpiSlavePrepareTransaction(uint8_t *aOutputBuf, uint16_t aOutputBu
         aOutputBuf[offset + 1] = (fcs >> 8) & 0xFF;
         aOutputBufLen = (aOutputBufLen + 2 > OPENTHREAD_CONFIG_NCP_SPI_BUFFER_SIZE)
                        ? OPENTHREAD_CONFIG_NCP_SPI_BUFFER_SIZE : aOutputBufLen + 2;
-        aInputBufLen = (aInputBufLen + 2 > OPENTHREAD_CONFIG_NCP_SPI_BUFFER_SIZE)
-                      ? OPENTHREAD_CONFIG_NCP_SPI_BUFFER_SIZE : aInputBufLen + 2;
+        /* a header only input buffer has no room for a CRC */
+        if (aInputBufLen > PLATFORM_SPI_HEADER_LEN)
+        {
+            aInputBufLen = (aInputBufLen + 2 > OPENTHREAD_CONFIG_NCP_SPI_BUFFER_SIZE)
+                          ? OPENTHREAD_CONFIG_NCP_SPI_BUFFER_SIZE : aInputBufLen + 2;
+        }
     }
     else
     {
         PLATFORM_SPI_UNSET_CRC(aOutputBuf);
     }
 #endif
+    spiRxCount = aInputBufLen;
 
     memset(&sSpiTransaction[0], 0, PLATFORM_SPI_MAX_TRANSACTIONS * sizeof(SPI_Transaction));
-    
+
     if (aInputBufLen && aOutputBufLen)
     {
         sSpiTransaction[0].count  = aOutputBufLen > aInputBufLen ? aInputBufLen : aOutputBufLen;
@@ -423,10 +524,24 @@ otError otPlatSpiSlavePrepareTransaction(uint8_t *aOutputBuf, uint16_t aOutputBu
 exit:
     if (retval == OT_ERROR_FAILED)
     {
+        spiStats.failed++;
 #if 0 // TIDRIVERS-1816 issue      
         SPI_transferCancel(sSpiHandle);
 #endif 
     }
-    
+    else if (retval == OT_ERROR_BUSY)
+    {
+        spiStats.busy++;
+    }
+
+    /*
+     * A busy transaction still gets the host to clock the one that is
+     * pending, the stack prepares its frame again when that completes.
+     */
+    if (aRequestTransactionFlag && retval != OT_ERROR_FAILED)
+    {
+        spiHostInt(true);
+    }
+
     return retval;
 }
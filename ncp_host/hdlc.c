@@ -0,0 +1,193 @@
+/******************************************************************************
+
+ @file  hdlc.c
+
+ @brief HDLC-lite framing as used by the OpenThread NCP uart transport
+
+ The FCS is the 16-bit PPP frame check sequence (RFC 1662), sent least
+ significant byte first.
+
+ *****************************************************************************/
+
+#include "hdlc.h"
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+#define HDLC_XON        0x11
+#define HDLC_XOFF       0x13
+#define HDLC_SPECIAL    0xF8
+
+#define HDLC_FCSINIT    0xFFFF
+#define HDLC_FCSGOOD    0xF0B8
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static uint16_t fcsTable[256];
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+static uint16_t fcsUpdate(uint16_t fcs, uint8_t byte)
+{
+    if (fcsTable[1] == 0)
+    {
+        unsigned i, b;
+
+        for (i = 0; i < 256; i++)
+        {
+            uint16_t v = (uint16_t)i;
+
+            for (b = 0; b < 8; b++)
+            {
+                v = (v & 1) ? ((v >> 1) ^ 0x8408) : (v >> 1);
+            }
+            fcsTable[i] = v;
+        }
+    }
+    return ((fcs >> 8) ^ fcsTable[(fcs ^ byte) & 0xFF]);
+}
+
+static int needsEscape(uint8_t byte)
+{
+    return (byte == HDLC_FLAG || byte == HDLC_ESCAPE || byte == HDLC_XON ||
+            byte == HDLC_XOFF || byte == HDLC_SPECIAL);
+}
+
+static uint8_t *putByte(uint8_t *out, uint8_t byte)
+{
+    if (needsEscape(byte))
+    {
+        *out++ = HDLC_ESCAPE;
+        byte ^= 0x20;
+    }
+    *out++ = byte;
+    return (out);
+}
+
+//*****************************************************************************
+// API
+//*****************************************************************************
+
+size_t hdlc_encodeBegin(hdlc_encoder_t *enc, uint8_t *out)
+{
+    enc->fcs = HDLC_FCSINIT;
+    out[0] = HDLC_FLAG;
+    return (1);
+}
+
+size_t hdlc_encodeByte(hdlc_encoder_t *enc, uint8_t byte, uint8_t *out)
+{
+    enc->fcs = fcsUpdate(enc->fcs, byte);
+    return ((size_t)(putByte(out, byte) - out));
+}
+
+size_t hdlc_encodeEnd(hdlc_encoder_t *enc, uint8_t *out)
+{
+    uint16_t fcs = enc->fcs ^ 0xFFFF;
+    uint8_t *p = out;
+
+    p = putByte(p, (uint8_t)fcs);
+    p = putByte(p, (uint8_t)(fcs >> 8));
+    *p++ = HDLC_FLAG;
+
+    return ((size_t)(p - out));
+}
+
+size_t hdlc_encode(const uint8_t *frame, size_t len, uint8_t *out)
+{
+    hdlc_encoder_t enc;
+    uint8_t *p = out;
+    size_t i;
+
+    p += hdlc_encodeBegin(&enc, p);
+    for (i = 0; i < len; i++)
+    {
+        p += hdlc_encodeByte(&enc, frame[i], p);
+    }
+    p += hdlc_encodeEnd(&enc, p);
+
+    return ((size_t)(p - out));
+}
+
+uint16_t hdlc_fcs(const uint8_t *data, size_t len)
+{
+    uint16_t fcs = HDLC_FCSINIT;
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        fcs = fcsUpdate(fcs, data[i]);
+    }
+    return (fcs ^ 0xFFFF);
+}
+
+void hdlc_decoderInit(hdlc_decoder_t *dec, uint8_t *buf, size_t size)
+{
+    dec->buf      = buf;
+    dec->size     = size;
+    dec->len      = 0;
+    dec->fcs      = HDLC_FCSINIT;
+    dec->escaped  = 0;
+    dec->overflow = 0;
+}
+
+unsigned hdlc_decode(hdlc_decoder_t *dec, const uint8_t *data, size_t len,
+                     hdlc_frameFn_t frameFn)
+{
+    unsigned dropped = 0;
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        uint8_t byte = data[i];
+
+        if (byte == HDLC_FLAG)
+        {
+            if (dec->len > 0 || dec->overflow)
+            {
+                // Shortest frame is the FCS alone
+                if (!dec->overflow && !dec->escaped && dec->len >= 2 &&
+                    dec->fcs == HDLC_FCSGOOD)
+                {
+                    frameFn(dec->buf, dec->len - 2);
+                }
+                else
+                {
+                    dropped += 1;
+                }
+            }
+            dec->len      = 0;
+            dec->fcs      = HDLC_FCSINIT;
+            dec->escaped  = 0;
+            dec->overflow = 0;
+        }
+        else if (byte == HDLC_ESCAPE)
+        {
+            dec->escaped = 1;
+        }
+        else
+        {
+            if (dec->escaped)
+            {
+                byte ^= 0x20;
+                dec->escaped = 0;
+            }
+            if (dec->len < dec->size)
+            {
+                dec->buf[dec->len++] = byte;
+                dec->fcs = fcsUpdate(dec->fcs, byte);
+            }
+            else
+            {
+                dec->overflow = 1;
+            }
+        }
+    }
+
+    return (dropped);
+}
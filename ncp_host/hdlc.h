@@ -0,0 +1,152 @@
+/******************************************************************************
+
+ @file  hdlc.h
+
+ @brief HDLC-lite framing as used by the OpenThread NCP uart transport
+
+ Frames are delimited by 0x7E flags and end in a 16-bit FCS. Flag, escape,
+ XON, XOFF and 0xF8 bytes are sent as 0x7D followed by the byte XOR 0x20.
+ Both ends of the benchmark link use this module.
+
+ *****************************************************************************/
+#ifndef HDLC_H
+#define HDLC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+#define HDLC_FLAG       0x7E
+#define HDLC_ESCAPE     0x7D
+
+// Largest encoded frame for a given payload length: every byte and the FCS
+// escaped, plus the two flags
+#define HDLC_MAXENCODED(len)    (2 * ((len) + 2) + 2)
+
+// Most bytes written by hdlc_encodeEnd()
+#define HDLC_MAXEND             5
+
+//*****************************************************************************
+// Typedefs
+//*****************************************************************************
+
+// Receive state of a decoder
+typedef struct
+{
+    uint8_t *buf;       // Frame buffer supplied by the owner
+    size_t   size;      // Size of buf
+    size_t   len;       // Bytes in buf so far, including the FCS
+    uint16_t fcs;       // Running FCS over buf
+    uint8_t  escaped;   // Last byte was an escape
+    uint8_t  overflow;  // Frame did not fit in buf, drop it
+} hdlc_decoder_t;
+
+// Encoder state of a frame being encoded a byte at a time
+typedef struct
+{
+    uint16_t fcs;       // Running FCS over the frame
+} hdlc_encoder_t;
+
+// Called by the decoder for each good frame, without the FCS
+typedef void (*hdlc_frameFn_t)(const uint8_t *frame, size_t len);
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+/**
+ * @fn      hdlc_encode
+ *
+ * @brief   Encode a frame with leading and trailing flags
+ *
+ * @param   frame - frame to encode
+ * @param   len   - length of frame
+ * @param   out   - output buffer of at least HDLC_MAXENCODED(len) bytes
+ *
+ * @return  number of bytes written to out
+ */
+extern size_t hdlc_encode(const uint8_t *frame, size_t len, uint8_t *out);
+
+/**
+ * @fn      hdlc_encodeBegin
+ *
+ * @brief   Start encoding a frame a byte at a time
+ *
+ * @param   enc - encoder
+ * @param   out - output buffer of at least 1 byte
+ *
+ * @return  number of bytes written to out
+ */
+extern size_t hdlc_encodeBegin(hdlc_encoder_t *enc, uint8_t *out);
+
+/**
+ * @fn      hdlc_encodeByte
+ *
+ * @brief   Encode the next byte of a frame
+ *
+ * @param   enc  - encoder
+ * @param   byte - frame byte
+ * @param   out  - output buffer of at least 2 bytes
+ *
+ * @return  number of bytes written to out
+ */
+extern size_t hdlc_encodeByte(hdlc_encoder_t *enc, uint8_t byte,
+                              uint8_t *out);
+
+/**
+ * @fn      hdlc_encodeEnd
+ *
+ * @brief   Finish a frame with its FCS and a flag
+ *
+ * @param   enc - encoder
+ * @param   out - output buffer of at least HDLC_MAXEND bytes
+ *
+ * @return  number of bytes written to out
+ */
+extern size_t hdlc_encodeEnd(hdlc_encoder_t *enc, uint8_t *out);
+
+/**
+ * @fn      hdlc_fcs
+ *
+ * @brief   FCS of a buffer as it is sent after a frame, least significant
+ *          byte first. The spinel SPI frame CRC uses the same FCS.
+ *
+ * @param   data - bytes to cover
+ * @param   len  - number of bytes
+ *
+ * @return  FCS
+ */
+extern uint16_t hdlc_fcs(const uint8_t *data, size_t len);
+
+/**
+ * @fn      hdlc_decoderInit
+ *
+ * @brief   Set up a decoder on a frame buffer
+ *
+ * @param   dec  - decoder
+ * @param   buf  - frame buffer, a frame and its FCS must fit
+ * @param   size - size of buf
+ *
+ * @return  none
+ */
+extern void hdlc_decoderInit(hdlc_decoder_t *dec, uint8_t *buf, size_t size);
+
+/**
+ * @fn      hdlc_decode
+ *
+ * @brief   Feed received bytes to a decoder
+ *
+ * @param   dec     - decoder
+ * @param   data    - received bytes
+ * @param   len     - number of bytes
+ * @param   frameFn - called for each frame with a good FCS
+ *
+ * @return  number of frames dropped for a bad FCS or overflow
+ */
+extern unsigned hdlc_decode(hdlc_decoder_t *dec, const uint8_t *data,
+                            size_t len, hdlc_frameFn_t frameFn);
+
+#endif /* HDLC_H */
@@ -0,0 +1,12 @@
+/*
+ * Host stand-in for the board header. The simulated uart and spi have one
+ * instance each, the spi host interrupt line is the one GPIO pin.
+ */
+#ifndef BOARD_H
+#define BOARD_H
+
+#define Board_UART0             0
+#define Board_SPI1              1
+#define Board_SPI_SLAVE_READY   0
+
+#endif /* BOARD_H */
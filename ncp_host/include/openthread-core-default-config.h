@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for the OpenThread core configuration defaults used by
+ * spi_slave.c.
+ */
+#ifndef OPENTHREAD_CORE_DEFAULT_CONFIG_H
+#define OPENTHREAD_CORE_DEFAULT_CONFIG_H
+
+#define OPENTHREAD_CONFIG_NCP_SPI_BUFFER_SIZE   1300
+
+#endif /* OPENTHREAD_CORE_DEFAULT_CONFIG_H */
@@ -0,0 +1,33 @@
+/*
+ * Host stand-in for the OpenThread SPI slave platform API. spi_slave.c
+ * implements the platform side, the simulated NCP in simncp.c the stack
+ * side.
+ */
+#ifndef OPENTHREAD_PLATFORM_SPI_SLAVE_H
+#define OPENTHREAD_PLATFORM_SPI_SLAVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <openthread/instance.h>
+
+typedef bool (*otPlatSpiSlaveTransactionCompleteCallback)(
+    void *aContext, uint8_t *aOutputBuf, uint16_t aOutputBufLen,
+    uint8_t *aInputBuf, uint16_t aInputBufLen, uint16_t aTransactionLength);
+
+typedef void (*otPlatSpiSlaveTransactionProcessCallback)(void *aContext);
+
+otError otPlatSpiSlaveEnable(
+    otPlatSpiSlaveTransactionCompleteCallback aCompleteCallback,
+    otPlatSpiSlaveTransactionProcessCallback aProcessCallback,
+    void *aContext);
+
+void otPlatSpiSlaveDisable(void);
+
+otError otPlatSpiSlavePrepareTransaction(uint8_t *aOutputBuf,
+                                         uint16_t aOutputBufLen,
+                                         uint8_t *aInputBuf,
+                                         uint16_t aInputBufLen,
+                                         bool aRequestTransactionFlag);
+
+#endif /* OPENTHREAD_PLATFORM_SPI_SLAVE_H */
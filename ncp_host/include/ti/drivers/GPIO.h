@@ -0,0 +1,19 @@
+/*
+ * Host stand-in for the TI GPIO driver API used by spi_slave.c. The one
+ * output pin is the host interrupt line of the simulated spi in simspi.c.
+ */
+#ifndef GPIO_H
+#define GPIO_H
+
+#include <stdint.h>
+
+typedef uint32_t GPIO_PinConfig;
+
+#define GPIO_CFG_OUT_STD    0x00000000
+#define GPIO_CFG_OUT_HIGH   0x00010000
+#define GPIO_CFG_OUT_LOW    0x00000000
+
+int_fast16_t GPIO_setConfig(uint_least8_t index, GPIO_PinConfig pinConfig);
+void GPIO_write(uint_least8_t index, unsigned int value);
+
+#endif /* GPIO_H */
@@ -0,0 +1,74 @@
+/*
+ * Host stand-in for the TI SPI driver API used by spi_slave.c. The
+ * implementation is the simulated spi slave in simspi.c.
+ */
+#ifndef SPI_H
+#define SPI_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct SPI_Config_
+{
+    void const *fxnTablePtr;
+    void *object;
+    void const *hwAttrs;
+} SPI_Config;
+
+typedef SPI_Config *SPI_Handle;
+
+typedef enum
+{
+    SPI_TRANSFER_COMPLETED = 0,
+    SPI_TRANSFER_STARTED,
+    SPI_TRANSFER_CANCELED,
+    SPI_TRANSFER_FAILED,
+    SPI_TRANSFER_CSN_DEASSERT,
+    SPI_TRANSFER_PEND_CSN_ASSERT,
+    SPI_TRANSFER_QUEUED
+} SPI_Status;
+
+typedef struct
+{
+    size_t count;
+    void *txBuf;
+    void *rxBuf;
+    void *arg;
+    volatile SPI_Status status;
+    void *nextPtr;
+} SPI_Transaction;
+
+typedef void (*SPI_CallbackFxn)(SPI_Handle handle,
+                                SPI_Transaction *transaction);
+
+typedef enum { SPI_MASTER = 0, SPI_SLAVE = 1 } SPI_Mode;
+typedef enum { SPI_MODE_BLOCKING, SPI_MODE_CALLBACK } SPI_TransferMode;
+typedef enum
+{
+    SPI_POL0_PHA0 = 0,
+    SPI_POL0_PHA1 = 1,
+    SPI_POL1_PHA0 = 2,
+    SPI_POL1_PHA1 = 3
+} SPI_FrameFormat;
+
+typedef struct
+{
+    SPI_TransferMode transferMode;
+    uint32_t transferTimeout;
+    SPI_CallbackFxn transferCallbackFxn;
+    SPI_Mode mode;
+    uint32_t bitRate;
+    uint32_t dataSize;
+    SPI_FrameFormat frameFormat;
+    void *custom;
+} SPI_Params;
+
+void SPI_Params_init(SPI_Params *params);
+SPI_Handle SPI_open(uint_least8_t index, SPI_Params *params);
+void SPI_close(SPI_Handle handle);
+int_fast16_t SPI_control(SPI_Handle handle, uint_fast16_t cmd, void *arg);
+bool SPI_transfer(SPI_Handle handle, SPI_Transaction *transaction);
+void SPI_transferCancel(SPI_Handle handle);
+
+#endif /* SPI_H */
@@ -0,0 +1,62 @@
+/*
+ * Host stand-in for the TI UART driver API used by uart.c. The
+ * implementation is the simulated uart in simuart.c.
+ */
+#ifndef UART_H
+#define UART_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct UART_Config_
+{
+    void const *fxnTablePtr;
+    void *object;
+    void const *hwAttrs;
+} UART_Config;
+
+typedef UART_Config *UART_Handle;
+
+typedef void (*UART_Callback)(UART_Handle handle, void *buf, size_t count);
+
+typedef enum { UART_MODE_BLOCKING, UART_MODE_CALLBACK } UART_Mode;
+typedef enum { UART_DATA_BINARY, UART_DATA_TEXT } UART_DataMode;
+typedef enum { UART_ECHO_OFF, UART_ECHO_ON } UART_Echo;
+typedef enum { UART_LEN_5, UART_LEN_6, UART_LEN_7, UART_LEN_8 } UART_LEN;
+typedef enum { UART_STOP_ONE, UART_STOP_TWO } UART_STOP;
+typedef enum { UART_PAR_NONE, UART_PAR_EVEN, UART_PAR_ODD } UART_PAR;
+
+typedef struct
+{
+    UART_Mode       readMode;
+    UART_Mode       writeMode;
+    uint32_t        readTimeout;
+    uint32_t        writeTimeout;
+    UART_Callback   readCallback;
+    UART_Callback   writeCallback;
+    int             readReturnMode;
+    UART_DataMode   readDataMode;
+    UART_DataMode   writeDataMode;
+    UART_Echo       readEcho;
+    uint32_t        baudRate;
+    UART_LEN        dataLength;
+    UART_STOP       stopBits;
+    UART_PAR        parityType;
+    void           *custom;
+} UART_Params;
+
+extern void UART_Params_init(UART_Params *params);
+
+extern UART_Handle UART_open(uint_least8_t index, UART_Params *params);
+
+extern void UART_close(UART_Handle handle);
+
+extern int_fast16_t UART_control(UART_Handle handle, uint_fast16_t cmd,
+                                 void *arg);
+
+extern int_fast32_t UART_read(UART_Handle handle, void *buffer, size_t size);
+
+extern int_fast32_t UART_write(UART_Handle handle, const void *buffer,
+                               size_t size);
+
+#endif /* UART_H */
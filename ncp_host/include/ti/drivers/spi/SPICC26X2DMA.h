@@ -0,0 +1,12 @@
+/*
+ * Host stand-in for the SPICC26X2DMA driver commands. Only the partial
+ * return command that spi_slave.c sets is defined.
+ */
+#ifndef SPICC26X2DMA_H
+#define SPICC26X2DMA_H
+
+#include <ti/drivers/SPI.h>
+
+#define SPICC26X2DMA_CMD_RETURN_PARTIAL_ENABLE  (0x20)
+
+#endif /* SPICC26X2DMA_H */
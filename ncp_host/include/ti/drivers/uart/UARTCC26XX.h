@@ -0,0 +1,27 @@
+/*
+ * Host stand-in for the UARTCC26XX driver object. Only the receive status
+ * that uart.c reads back is modelled.
+ */
+#ifndef UARTCC26XX_H
+#define UARTCC26XX_H
+
+#include <ti/drivers/UART.h>
+
+#define UARTCC26XX_CMD_RETURN_PARTIAL_ENABLE    (0x20)
+
+typedef enum UART_Status
+{
+    UART_TIMED_OUT     = 0x10,
+    UART_PARITY_ERROR  = 0x02,
+    UART_BRAKE_ERROR   = 0x04,
+    UART_OVERRUN_ERROR = 0x08,
+    UART_FRAMING_ERROR = 0x01,
+    UART_OK            = 0x00
+} UART_Status;
+
+typedef struct
+{
+    UART_Status status;
+} UARTCC26XX_Object;
+
+#endif /* UARTCC26XX_H */
@@ -0,0 +1,55 @@
+/*
+ * Host stand-in for the TI-RTOS event object. The simulated NCP runs one
+ * thread, so an event is a set of flags that Event_pend() takes and clears.
+ */
+#ifndef EVENT_H
+#define EVENT_H
+
+#include <ti/sysbios/BIOS.h>
+
+#define Event_Id_NONE   (0)
+#define Event_Id_00     (0x1)
+#define Event_Id_01     (0x2)
+#define Event_Id_02     (0x4)
+#define Event_Id_03     (0x8)
+
+typedef struct
+{
+    UInt posted;
+} Event_Struct;
+
+typedef Event_Struct *Event_Handle;
+
+static inline void Event_construct(Event_Struct *obj, void *params)
+{
+    (void)params;
+    obj->posted = 0;
+}
+
+static inline void Event_destruct(Event_Struct *obj)
+{
+    obj->posted = 0;
+}
+
+static inline Event_Handle Event_handle(Event_Struct *obj)
+{
+    return (obj);
+}
+
+static inline void Event_post(Event_Handle handle, UInt eventMask)
+{
+    handle->posted |= eventMask;
+}
+
+static inline UInt Event_pend(Event_Handle handle, UInt andMask, UInt orMask,
+                              UInt timeout)
+{
+    UInt events = handle->posted & orMask;
+
+    (void)andMask;
+    (void)timeout;
+    handle->posted &= ~events;
+    return (events);
+}
+
+#endif /* EVENT_H */
@@ -0,0 +1,551 @@
+/******************************************************************************
+
+ @file  simncp.c
+
+ @brief Simulated NCP for host builds of the platform transport modules
+
+ Transmit queues whole spinel frames in a frame buffer for either
+ transport, the paths below are those of the OpenThread NCP transports with
+ their default buffer sizes.
+
+ uart: receive decodes into one frame buffer and handles each frame as
+ soon as its closing flag is in. Transmit HDLC encodes queued frames into a
+ small chunk buffer, which is handed to otPlatUartSend() and refilled on
+ otPlatUartSendDone().
+
+ spi: each transaction carries at most one frame each way behind a five
+ byte header of flags, accept length and data length. The frame at the
+ head of the frame buffer is copied to the send frame and offered until a
+ transaction carries it whole to a host that accepts it. A received frame
+ is handled in the process callback. Until then the receive buffer is
+ busy, so the header tells the host that nothing is accepted.
+
+ *****************************************************************************/
+
+#include <string.h>
+#include <time.h>
+
+#include <openthread/platform/spi-slave.h>
+#include <openthread/platform/uart.h>
+
+#include "hdlc.h"
+#include "simncp.h"
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+// OPENTHREAD_CONFIG_NCP_UART_RX_BUFFER_SIZE
+#define SIMNCP_RXBUF_SIZE       1300
+
+// OPENTHREAD_CONFIG_NCP_TX_BUFFER_SIZE
+#define SIMNCP_TXBUF_SIZE       2048
+
+// OPENTHREAD_CONFIG_NCP_UART_TX_CHUNK_SIZE
+#define SIMNCP_TXCHUNK_SIZE     128
+
+// Frame buffer space taken by the length of each frame
+#define SIMNCP_FRAMEHDR_LEN     2
+
+// Spinel header, command, property and a STREAM_NET data length
+#define SIMNCP_STREAMHDR_LEN    5
+
+// OPENTHREAD_CONFIG_NCP_SPI_BUFFER_SIZE
+#define SIMNCP_SPIBUF_SIZE      1300
+
+// Spi frame header: flags, accept length and data length
+#define SIMNCP_SPIHDR_LEN       5
+#define SIMNCP_SPIHDR_PATTERN   0x02
+#define SIMNCP_SPIHDR_MASK      0x03
+
+// Spi send states
+#define SIMNCP_SPI_IDLE         0
+#define SIMNCP_SPI_SENDING      1
+#define SIMNCP_SPI_SENT         2
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static const simncp_config_t *ncpConfig;
+
+static simncp_stats_t *ncpStats;
+
+// The uart module asked for its processing loop to run
+static int uartSignalled;
+
+static uint8_t rxBuffer[SIMNCP_RXBUF_SIZE];
+
+static hdlc_decoder_t decoder;
+
+// Transmit frame buffer, free running head and tail
+static uint8_t txBuffer[SIMNCP_TXBUF_SIZE];
+static size_t txHead;
+static size_t txTail;
+
+// Encoding of the frame at the tail of the frame buffer
+static hdlc_encoder_t encoder;
+static int encoding;
+static size_t encodeLeft;
+
+static uint8_t txChunk[SIMNCP_TXCHUNK_SIZE];
+
+// A chunk is with the uart module
+static int sending;
+
+// The spi module asked for its processing loop to run
+static int spiSignalled;
+
+// Spi frames. The send frame leaves room for the CRC spi_slave.c adds.
+static uint8_t spiSendFrame[SIMNCP_SPIBUF_SIZE];
+static uint16_t spiSendLen;
+static uint8_t spiRecvFrame[SIMNCP_SPIBUF_SIZE];
+static uint8_t spiEmptyFullAccept[SIMNCP_SPIHDR_LEN];
+static uint8_t spiEmptyZeroAccept[SIMNCP_SPIHDR_LEN];
+static uint8_t spiEmptyRecv[SIMNCP_SPIHDR_LEN];
+
+// Spi send state, changed by the transaction callback
+static volatile int spiTxState;
+
+// A received frame waits in spiRecvFrame for the process callback
+static volatile int spiHandlingRx;
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+static double nowUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((ts.tv_sec * 1e6) + (ts.tv_nsec / 1e3));
+}
+
+/* Keeps the CPU for us microseconds, the driver interrupts still run */
+static void busyFor(uint32_t us)
+{
+    double end = nowUs() + us;
+
+    while (us > 0 && nowUs() < end)
+    {
+        if (ncpConfig->spi)
+        {
+            simspi_poll();
+        }
+        else
+        {
+            simuart_poll();
+        }
+    }
+}
+
+static size_t txFree(void)
+{
+    return (SIMNCP_TXBUF_SIZE - (txHead - txTail));
+}
+
+static void txPut(const uint8_t *data, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        txBuffer[txHead++ % SIMNCP_TXBUF_SIZE] = data[i];
+    }
+}
+
+/* Queues a frame of a header and a body, returns 0 if it does not fit */
+static int txFrame(const uint8_t *hdr, size_t hdrLen, const uint8_t *body,
+                   size_t bodyLen)
+{
+    size_t len = hdrLen + bodyLen;
+    uint8_t frameLen[SIMNCP_FRAMEHDR_LEN];
+
+    if (SIMNCP_FRAMEHDR_LEN + len > txFree())
+    {
+        return (0);
+    }
+
+    frameLen[0] = (uint8_t)len;
+    frameLen[1] = (uint8_t)(len >> 8);
+    txPut(frameLen, sizeof(frameLen));
+    txPut(hdr, hdrLen);
+    txPut(body, bodyLen);
+
+    if (txHead - txTail > ncpStats->txBufHighWater)
+    {
+        ncpStats->txBufHighWater = txHead - txTail;
+    }
+    return (1);
+}
+
+/* Encodes queued frames into the chunk buffer and sends it */
+static void txEncode(void)
+{
+    size_t len = 0;
+
+    if (sending)
+    {
+        return;
+    }
+
+    while (encoding || txTail != txHead)
+    {
+        if (!encoding)
+        {
+            if (len + 1 > SIMNCP_TXCHUNK_SIZE)
+            {
+                break;
+            }
+            encodeLeft  = txBuffer[txTail++ % SIMNCP_TXBUF_SIZE];
+            encodeLeft |= txBuffer[txTail++ % SIMNCP_TXBUF_SIZE] << 8;
+            len += hdlc_encodeBegin(&encoder, &txChunk[len]);
+            encoding = 1;
+        }
+
+        // Room for an escaped byte
+        while (encodeLeft > 0 && len + 2 <= SIMNCP_TXCHUNK_SIZE)
+        {
+            len += hdlc_encodeByte(&encoder,
+                                   txBuffer[txTail++ % SIMNCP_TXBUF_SIZE],
+                                   &txChunk[len]);
+            encodeLeft -= 1;
+        }
+        if (encodeLeft > 0 || len + HDLC_MAXEND > SIMNCP_TXCHUNK_SIZE)
+        {
+            break;
+        }
+
+        len += hdlc_encodeEnd(&encoder, &txChunk[len]);
+        encoding = 0;
+    }
+
+    if (len > 0)
+    {
+        if (otPlatUartSend(txChunk, len) == OT_ERROR_NONE)
+        {
+            sending = 1;
+        }
+        else
+        {
+            ncpStats->busy += 1;
+        }
+    }
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return ((uint16_t)(p[0] | (p[1] << 8)));
+}
+
+static void spiSetHeader(uint8_t *frame, uint16_t acceptLen, uint16_t dataLen)
+{
+    frame[0] = SIMNCP_SPIHDR_PATTERN;
+    frame[1] = (uint8_t)acceptLen;
+    frame[2] = (uint8_t)(acceptLen >> 8);
+    frame[3] = (uint8_t)dataLen;
+    frame[4] = (uint8_t)(dataLen >> 8);
+}
+
+/* Offers the frame at the head of the frame buffer to the host */
+static void spiSendNext(void)
+{
+    size_t len;
+    size_t i;
+    otError error;
+
+    if (spiTxState != SIMNCP_SPI_IDLE || txTail == txHead)
+    {
+        return;
+    }
+
+    len  = txBuffer[txTail % SIMNCP_TXBUF_SIZE];
+    len |= txBuffer[(txTail + 1) % SIMNCP_TXBUF_SIZE] << 8;
+    for (i = 0; i < len; i++)
+    {
+        spiSendFrame[SIMNCP_SPIHDR_LEN + i] =
+            txBuffer[(txTail + SIMNCP_FRAMEHDR_LEN + i) % SIMNCP_TXBUF_SIZE];
+    }
+    spiSetHeader(spiSendFrame,
+                 spiHandlingRx ? 0 : SIMNCP_SPIBUF_SIZE - SIMNCP_SPIHDR_LEN,
+                 (uint16_t)len);
+    spiSendLen = (uint16_t)(SIMNCP_SPIHDR_LEN + len);
+    spiTxState = SIMNCP_SPI_SENDING;
+
+    // Busy is fine, the transaction callback prepares the frame once the
+    // pending transaction is through
+    error = otPlatSpiSlavePrepareTransaction(spiSendFrame, spiSendLen, NULL, 0,
+                                             true);
+    if (error != OT_ERROR_NONE && error != OT_ERROR_BUSY)
+    {
+        ncpStats->busy += 1;
+    }
+}
+
+/* Starts sending what was queued */
+static void txKick(void)
+{
+    if (ncpConfig->spi)
+    {
+        spiSendNext();
+    }
+    else
+    {
+        txEncode();
+    }
+}
+
+/* Answers a STREAM_NET packet and loops it back */
+static void handleFrame(const uint8_t *frame, size_t len)
+{
+    uint8_t status[4];
+    uint8_t echo[SIMNCP_STREAMHDR_LEN];
+    size_t pktLen;
+
+    ncpStats->frames += 1;
+
+    if (len < SIMNCP_STREAMHDR_LEN || !(frame[0] & SPINEL_HEADER_FLAG) ||
+        frame[1] != SPINEL_CMD_PROP_VALUE_SET ||
+        frame[2] != SPINEL_PROP_STREAM_NET)
+    {
+        return;
+    }
+
+    pktLen = frame[3] | (frame[4] << 8);
+    if (SIMNCP_STREAMHDR_LEN + pktLen > len)
+    {
+        ncpStats->badFrames += 1;
+        return;
+    }
+
+    // The stack forwards the packet to the mesh
+    busyFor(ncpConfig->frameCostUs);
+
+    status[0] = SPINEL_HEADER_FLAG | (frame[0] & SPINEL_HEADER_TIDMASK);
+    status[1] = SPINEL_CMD_PROP_VALUE_IS;
+    status[2] = SPINEL_PROP_LAST_STATUS;
+    status[3] = SPINEL_STATUS_OK;
+
+    // Unsolicited, as a packet from the mesh would be
+    echo[0] = SPINEL_HEADER_FLAG;
+    echo[1] = SPINEL_CMD_PROP_VALUE_IS;
+    echo[2] = SPINEL_PROP_STREAM_NET;
+    echo[3] = frame[3];
+    echo[4] = frame[4];
+
+    if (txFree() < 2 * SIMNCP_FRAMEHDR_LEN + sizeof(status) + sizeof(echo) +
+                   pktLen)
+    {
+        ncpStats->drops += 1;
+        status[3] = SPINEL_STATUS_NOMEM;
+        txFrame(status, sizeof(status), NULL, 0);
+    }
+    else
+    {
+        txFrame(status, sizeof(status), NULL, 0);
+        txFrame(echo, sizeof(echo), &frame[SIMNCP_STREAMHDR_LEN], pktLen);
+    }
+
+    txKick();
+}
+
+//*****************************************************************************
+// OpenThread stack side of the uart platform API
+//*****************************************************************************
+
+void otPlatUartSendDone(void)
+{
+    sending = 0;
+    txEncode();
+}
+
+void otPlatUartReceived(const uint8_t *aBuf, uint16_t aBufLength)
+{
+    ncpStats->badFrames += hdlc_decode(&decoder, aBuf, aBufLength,
+                                       handleFrame);
+}
+
+void platformUartSignal(void)
+{
+    uartSignalled = 1;
+}
+
+/* Called from the transaction callback, an interrupt on the device */
+static bool spiTransactionComplete(void *aContext, uint8_t *aOutputBuf,
+                                   uint16_t aOutputBufLen, uint8_t *aInputBuf,
+                                   uint16_t aInputBufLen,
+                                   uint16_t aTransactionLength)
+{
+    bool process = false;
+    uint16_t dataLen;
+    uint8_t *out;
+    uint8_t *in;
+    uint16_t outLen;
+    uint16_t inLen;
+
+    (void)aContext;
+
+    if (aTransactionLength >= SIMNCP_SPIHDR_LEN &&
+        aOutputBufLen >= SIMNCP_SPIHDR_LEN &&
+        aInputBufLen >= SIMNCP_SPIHDR_LEN &&
+        (aInputBuf[0] & SIMNCP_SPIHDR_MASK) == SIMNCP_SPIHDR_PATTERN &&
+        (aOutputBuf[0] & SIMNCP_SPIHDR_MASK) == SIMNCP_SPIHDR_PATTERN)
+    {
+        dataLen = aTransactionLength - SIMNCP_SPIHDR_LEN;
+
+        // A host frame within our accept length came in whole
+        if (get16(&aInputBuf[3]) > 0 &&
+            get16(&aInputBuf[3]) <= get16(&aOutputBuf[1]) &&
+            get16(&aInputBuf[3]) <= dataLen)
+        {
+            spiHandlingRx = 1;
+            process = true;
+        }
+
+        // Our frame went out whole to a host that accepted it
+        if (spiTxState == SIMNCP_SPI_SENDING && aOutputBuf == spiSendFrame &&
+            get16(&aOutputBuf[3]) <= get16(&aInputBuf[1]) &&
+            get16(&aOutputBuf[3]) <= dataLen)
+        {
+            spiTxState = SIMNCP_SPI_SENT;
+            process = true;
+        }
+    }
+
+    // Set up the next transaction for the state we are in now
+    if (spiTxState == SIMNCP_SPI_SENDING)
+    {
+        out    = spiSendFrame;
+        outLen = spiSendLen;
+    }
+    else
+    {
+        out    = spiHandlingRx ? spiEmptyZeroAccept : spiEmptyFullAccept;
+        outLen = SIMNCP_SPIHDR_LEN;
+    }
+    if (spiHandlingRx)
+    {
+        in    = spiEmptyRecv;
+        inLen = SIMNCP_SPIHDR_LEN;
+    }
+    else
+    {
+        in    = spiRecvFrame;
+        inLen = SIMNCP_SPIBUF_SIZE;
+    }
+    spiSendFrame[1] = (uint8_t)(inLen - SIMNCP_SPIHDR_LEN);
+    spiSendFrame[2] = (uint8_t)((inLen - SIMNCP_SPIHDR_LEN) >> 8);
+
+    otPlatSpiSlavePrepareTransaction(out, outLen, in, inLen,
+                                     spiTxState == SIMNCP_SPI_SENDING);
+
+    return (process);
+}
+
+/* Called from the processing loop */
+static void spiTransactionProcess(void *aContext)
+{
+    (void)aContext;
+
+    if (spiTxState == SIMNCP_SPI_SENT)
+    {
+        txTail += SIMNCP_FRAMEHDR_LEN + spiSendLen - SIMNCP_SPIHDR_LEN;
+        spiTxState = SIMNCP_SPI_IDLE;
+        spiSendNext();
+    }
+
+    if (spiHandlingRx)
+    {
+        handleFrame(&spiRecvFrame[SIMNCP_SPIHDR_LEN],
+                    get16(&spiRecvFrame[3]));
+
+        // Clear first, a transaction completing now sets up the next one
+        // with the receive buffer in either case
+        spiHandlingRx = 0;
+        if (spiTxState != SIMNCP_SPI_SENDING)
+        {
+            otPlatSpiSlavePrepareTransaction(spiEmptyFullAccept,
+                                             SIMNCP_SPIHDR_LEN, spiRecvFrame,
+                                             SIMNCP_SPIBUF_SIZE, false);
+        }
+    }
+}
+
+void platformSpiSignal(void)
+{
+    spiSignalled = 1;
+}
+
+//*****************************************************************************
+// API
+//*****************************************************************************
+
+void simncp_run(int fd, const simncp_config_t *cfg, simncp_stats_t *stats)
+{
+    ncpConfig = cfg;
+    ncpStats  = stats;
+    memset(ncpStats, 0, sizeof(*ncpStats));
+
+    hdlc_decoderInit(&decoder, rxBuffer, sizeof(rxBuffer));
+    txHead   = 0;
+    txTail   = 0;
+    encoding = 0;
+    sending  = 0;
+
+    if (cfg->spi)
+    {
+        spiSetHeader(spiEmptyFullAccept,
+                     SIMNCP_SPIBUF_SIZE - SIMNCP_SPIHDR_LEN, 0);
+        spiSetHeader(spiEmptyZeroAccept, 0, 0);
+        spiTxState    = SIMNCP_SPI_IDLE;
+        spiHandlingRx = 0;
+
+        simspi_init(fd);
+        otPlatSpiSlaveEnable(spiTransactionComplete, spiTransactionProcess,
+                             NULL);
+        otPlatSpiSlavePrepareTransaction(spiEmptyFullAccept,
+                                         SIMNCP_SPIHDR_LEN, spiRecvFrame,
+                                         SIMNCP_SPIBUF_SIZE, false);
+
+        while (simspi_poll())
+        {
+            if (spiSignalled)
+            {
+                spiSignalled = 0;
+                platformSpiProcess();
+            }
+            else
+            {
+                simspi_wait();
+            }
+
+            platformSpiGetStats(&ncpStats->spi);
+            ncpStats->bus = *simspi_stats();
+        }
+
+        otPlatSpiSlaveDisable();
+        return;
+    }
+
+    simuart_init(fd, &cfg->uart);
+    otPlatUartEnable();
+
+    while (simuart_poll())
+    {
+        if (uartSignalled)
+        {
+            uartSignalled = 0;
+            platformUartProcess();
+        }
+        else
+        {
+            simuart_wait();
+        }
+
+        platformUartGetStats(&ncpStats->uart);
+        ncpStats->line = *simuart_stats();
+    }
+
+    otPlatUartDisable();
+}
@@ -0,0 +1,83 @@
+/******************************************************************************
+
+ @file  simncp.h
+
+ @brief Simulated NCP for host builds of the platform transport modules
+
+ Stands in for the OpenThread NCP on top of platform/uart.c or
+ platform/spi_slave.c. Frames are received and sent the way the OpenThread
+ NCP uart and spi transports do it, with the same buffer sizes. A spinel STREAM_NET packet from the host is
+ answered with a LAST_STATUS and looped back to the host as if it had come
+ in from the mesh. When the transmit frame buffer has no room for the
+ packet it is dropped and the status says so.
+
+ *****************************************************************************/
+#ifndef SIMNCP_H
+#define SIMNCP_H
+
+#include <stdint.h>
+
+#include "platform.h"
+#include "simspi.h"
+#include "simuart.h"
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+// Spinel commands, properties and status values used on the link
+#define SPINEL_HEADER_FLAG          0x80
+#define SPINEL_HEADER_TIDMASK       0x0F
+#define SPINEL_CMD_PROP_VALUE_SET   3
+#define SPINEL_CMD_PROP_VALUE_IS    6
+#define SPINEL_PROP_LAST_STATUS     0
+#define SPINEL_PROP_STREAM_NET      0x72
+#define SPINEL_STATUS_OK            0
+#define SPINEL_STATUS_NOMEM         11
+
+//*****************************************************************************
+// Typedefs
+//*****************************************************************************
+
+// NCP configuration
+typedef struct
+{
+    simuart_config_t uart;      // Line the NCP is on, uart transport
+    uint32_t frameCostUs;       // Processing time per packet
+    int spi;                    // Use the spi transport instead
+} simncp_config_t;
+
+// NCP counters, kept in memory shared with the host side
+typedef struct
+{
+    PlatformUart_Stats uart;    // Counters of platform/uart.c
+    simuart_stats_t line;       // Counters of the simulated line
+    PlatformSpi_Stats spi;      // Counters of platform/spi_slave.c
+    simspi_stats_t bus;         // Counters of the simulated spi bus
+    uint32_t frames;            // Good frames received
+    uint32_t badFrames;         // Frames dropped for a bad FCS or size
+    uint32_t drops;             // Packets dropped for a full frame buffer
+    uint32_t busy;              // Sends the transport failed
+    uint16_t txBufHighWater;    // Most bytes in the frame buffer
+} simncp_stats_t;
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+/**
+ * @fn      simncp_run
+ *
+ * @brief   Run the NCP until the host end hangs up
+ *
+ * @param   fd    - device end of the pseudo-terminal, in raw mode, or of
+ *                  the socket pair for the spi transport
+ * @param   cfg   - NCP configuration
+ * @param   stats - counters to keep up to date
+ *
+ * @return  none
+ */
+extern void simncp_run(int fd, const simncp_config_t *cfg,
+                       simncp_stats_t *stats);
+
+#endif /* SIMNCP_H */
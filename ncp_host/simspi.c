@@ -0,0 +1,311 @@
+/******************************************************************************
+
+ @file  simspi.c
+
+ @brief Simulated SPI slave driver for host builds of the platform spi module
+
+ Queued transactions are served in order. The first one waits for chip
+ select, the rest are queued behind it. A transaction completes when its
+ count of bytes has been clocked. When the host deasserts chip select, the
+ transaction in progress completes with SPI_TRANSFER_CSN_DEASSERT and the
+ count it got to, and the ones behind it are cancelled. Callbacks, the
+ simulated interrupts, run before the MISO bytes go back to the host, so
+ the host sees the interrupt line as the callbacks left it.
+
+ *****************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <ti/drivers/GPIO.h>
+#include <ti/drivers/SPI.h>
+
+#include "simspi.h"
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+// Transactions the driver queues
+#define SIMSPI_MAXQUEUE     4
+
+// Sent for bytes without a transmit buffer, defaultTxBufValue
+#define SIMSPI_DEFAULTTX    0xFF
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static int busFd = -1;
+
+static simspi_stats_t stats;
+
+static int hungUp;
+
+static SPI_Config spiConfig = {NULL, NULL, NULL};
+
+static SPI_Params openParams;
+
+static int isOpen;
+
+// Transaction queue, the head is the one chip select starts
+static SPI_Transaction *queue[SIMSPI_MAXQUEUE];
+static unsigned queueLen;
+
+// Level of the host interrupt line
+static int intLevel = 1;
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+static void sendMsg(uint8_t type, const uint8_t *data, size_t len)
+{
+    uint8_t msg[1 + SIMSPI_MAXXFER];
+
+    msg[0] = type;
+    memcpy(&msg[1], data, len);
+    if (send(busFd, msg, 1 + len, MSG_NOSIGNAL) < 0)
+    {
+        hungUp = 1;
+    }
+}
+
+/* Ends transactions from the head of the queue, runs their callbacks */
+static void complete(unsigned n)
+{
+    SPI_Transaction *done[SIMSPI_MAXQUEUE];
+    unsigned i;
+
+    // Callbacks may queue the next transactions
+    memcpy(done, queue, n * sizeof(done[0]));
+    memmove(queue, &queue[n], (queueLen - n) * sizeof(queue[0]));
+    queueLen -= n;
+    if (queueLen > 0)
+    {
+        queue[0]->status = SPI_TRANSFER_PEND_CSN_ASSERT;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        openParams.transferCallbackFxn(&spiConfig, done[i]);
+    }
+}
+
+/* Clocks a transaction from the host and answers with the MISO bytes */
+static void transfer(const uint8_t *mosi, size_t len)
+{
+    uint8_t miso[SIMSPI_MAXXFER];
+    SPI_Transaction *t = NULL;
+    size_t pos = 0;
+    size_t i;
+    unsigned n;
+
+    stats.xfers += 1;
+    stats.bytes += len;
+
+    for (i = 0; i < len; i++)
+    {
+        if (t == NULL && queueLen > 0)
+        {
+            t = queue[0];
+            t->status = SPI_TRANSFER_STARTED;
+            pos = 0;
+        }
+        if (t == NULL)
+        {
+            miso[i] = SIMSPI_DEFAULTTX;
+            stats.underruns += 1;
+            continue;
+        }
+
+        miso[i] = t->txBuf ? ((uint8_t *)t->txBuf)[pos] : SIMSPI_DEFAULTTX;
+        if (t->rxBuf)
+        {
+            ((uint8_t *)t->rxBuf)[pos] = mosi[i];
+        }
+        if (++pos == t->count)
+        {
+            t->status = SPI_TRANSFER_COMPLETED;
+            t = NULL;
+            complete(1);
+        }
+    }
+
+    // Chip select deasserted
+    if (t != NULL)
+    {
+        t->count  = pos;
+        t->status = SPI_TRANSFER_CSN_DEASSERT;
+        for (n = 1; n < queueLen; n++)
+        {
+            queue[n]->count  = 0;
+            queue[n]->status = SPI_TRANSFER_CANCELED;
+        }
+        complete(queueLen);
+    }
+
+    sendMsg(SIMSPI_MSG_REPLY, miso, len);
+}
+
+//*****************************************************************************
+// SPI driver API
+//*****************************************************************************
+
+void SPI_Params_init(SPI_Params *params)
+{
+    memset(params, 0, sizeof(*params));
+    params->transferMode = SPI_MODE_BLOCKING;
+    params->bitRate      = 1000000;
+    params->dataSize     = 8;
+}
+
+SPI_Handle SPI_open(uint_least8_t index, SPI_Params *params)
+{
+    (void)index;
+
+    if (isOpen || params->mode != SPI_SLAVE ||
+        params->transferMode != SPI_MODE_CALLBACK)
+    {
+        return (NULL);
+    }
+    openParams = *params;
+    queueLen   = 0;
+    isOpen     = 1;
+
+    return (&spiConfig);
+}
+
+void SPI_close(SPI_Handle handle)
+{
+    (void)handle;
+
+    queueLen = 0;
+    isOpen   = 0;
+}
+
+int_fast16_t SPI_control(SPI_Handle handle, uint_fast16_t cmd, void *arg)
+{
+    (void)handle;
+    (void)cmd;
+    (void)arg;
+
+    // Transfers always return on chip select deassert, the only mode
+    // spi_slave.c uses
+    return (0);
+}
+
+bool SPI_transfer(SPI_Handle handle, SPI_Transaction *transaction)
+{
+    (void)handle;
+
+    if (!isOpen || queueLen == SIMSPI_MAXQUEUE || transaction->count == 0)
+    {
+        return (false);
+    }
+
+    transaction->status = (queueLen == 0) ? SPI_TRANSFER_PEND_CSN_ASSERT :
+                                            SPI_TRANSFER_QUEUED;
+    queue[queueLen++] = transaction;
+    return (true);
+}
+
+void SPI_transferCancel(SPI_Handle handle)
+{
+    unsigned n;
+
+    (void)handle;
+
+    for (n = 0; n < queueLen; n++)
+    {
+        queue[n]->count  = 0;
+        queue[n]->status = SPI_TRANSFER_CANCELED;
+    }
+    complete(queueLen);
+}
+
+//*****************************************************************************
+// GPIO driver API
+//*****************************************************************************
+
+int_fast16_t GPIO_setConfig(uint_least8_t index, GPIO_PinConfig pinConfig)
+{
+    GPIO_write(index, (pinConfig & GPIO_CFG_OUT_HIGH) ? 1 : 0);
+    return (0);
+}
+
+void GPIO_write(uint_least8_t index, unsigned int value)
+{
+    uint8_t level = (value != 0);
+
+    (void)index;
+
+    if (level != intLevel)
+    {
+        intLevel = level;
+        sendMsg(SIMSPI_MSG_INT, &level, 1);
+    }
+}
+
+//*****************************************************************************
+// Simulation API
+//*****************************************************************************
+
+void simspi_init(int fd)
+{
+    busFd    = fd;
+    hungUp   = 0;
+    intLevel = 1;
+    memset(&stats, 0, sizeof(stats));
+}
+
+int simspi_poll(void)
+{
+    uint8_t msg[1 + SIMSPI_MAXXFER];
+    ssize_t n;
+
+    while (!hungUp)
+    {
+        n = recv(busFd, msg, sizeof(msg), MSG_DONTWAIT);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            hungUp = 1;
+        }
+        if (n <= 0)
+        {
+            break;
+        }
+        if (msg[0] == SIMSPI_MSG_XFER)
+        {
+            transfer(&msg[1], n - 1);
+        }
+    }
+
+    return (!hungUp);
+}
+
+void simspi_wait(void)
+{
+    struct pollfd pfd;
+    struct timespec ts;
+
+    pfd.fd     = busFd;
+    pfd.events = POLLIN;
+
+    ts.tv_sec  = 0;
+    ts.tv_nsec = 100 * 1000 * 1000;
+
+    ppoll(&pfd, 1, &ts, NULL);
+}
+
+const simspi_stats_t *simspi_stats(void)
+{
+    return (&stats);
+}
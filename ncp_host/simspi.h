@@ -0,0 +1,92 @@
+/******************************************************************************
+
+ @file  simspi.h
+
+ @brief Simulated SPI slave driver for host builds of the platform spi module
+
+ Implements the TI SPI and GPIO driver calls made by platform/spi_slave.c
+ on top of a SOCK_SEQPACKET socket. Each message from the host is one
+ transaction, the bytes it clocks out on MOSI between asserting and
+ deasserting chip select. The driver answers with the same number of MISO
+ bytes, taken from the queued transactions as the SPICC26X2DMA would, and
+ runs their callbacks. The host interrupt line is sent to the host as a
+ message each time it changes.
+
+ The host paces the transactions at its clock rate, the slave follows it.
+
+ *****************************************************************************/
+#ifndef SIMSPI_H
+#define SIMSPI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+// Message types on the socket
+#define SIMSPI_MSG_XFER     'T'     // Host to slave: MOSI bytes
+#define SIMSPI_MSG_REPLY    'R'     // Slave to host: MISO bytes
+#define SIMSPI_MSG_INT      'I'     // Slave to host: interrupt line level
+
+// Longest transaction
+#define SIMSPI_MAXXFER      2048
+
+//*****************************************************************************
+// Typedefs
+//*****************************************************************************
+
+// Bus counters
+typedef struct
+{
+    uint64_t xfers;         // Transactions clocked by the host
+    uint64_t bytes;         // Bytes clocked each way
+    uint64_t underruns;     // Bytes clocked with no transaction queued
+} simspi_stats_t;
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+/**
+ * @fn      simspi_init
+ *
+ * @brief   Attach the simulated SPI slave to the device end of a socket.
+ *          Call before otPlatSpiSlaveEnable().
+ *
+ * @param   fd - device end of a SOCK_SEQPACKET socket pair
+ *
+ * @return  none
+ */
+extern void simspi_init(int fd);
+
+/**
+ * @fn      simspi_poll
+ *
+ * @brief   Run the transactions the host has clocked and the driver
+ *          callbacks that come with them
+ *
+ * @return  0 once the host has hung up, 1 otherwise
+ */
+extern int simspi_poll(void);
+
+/**
+ * @fn      simspi_wait
+ *
+ * @brief   Sleep until the host clocks a transaction
+ *
+ * @return  none
+ */
+extern void simspi_wait(void);
+
+/**
+ * @fn      simspi_stats
+ *
+ * @brief   Get the bus counters
+ *
+ * @return  pointer to the counters
+ */
+extern const simspi_stats_t *simspi_stats(void);
+
+#endif /* SIMSPI_H */
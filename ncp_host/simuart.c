@@ -0,0 +1,428 @@
+/******************************************************************************
+
+ @file  simuart.c
+
+ @brief Simulated UART driver for host builds of the platform uart module
+
+ Line pacing is done with byte credits. A direction earns baudRate / 10
+ bytes per second while it has bytes to move, 8-N-1 being ten bit times a
+ byte, and spends one credit per byte. Reads end when the buffer is full or
+ the line goes idle, as with UARTCC26XX_CMD_RETURN_PARTIAL_ENABLE. Writes
+ end when the last byte is on the line.
+
+ *****************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include <ti/drivers/UART.h>
+#include <ti/drivers/uart/UARTCC26XX.h>
+
+#include "simuart.h"
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+// Longest sleep while the line is busy, in microseconds
+#define SIMUART_TICKUS  250
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static int lineFd = -1;
+
+static simuart_config_t config;
+
+static simuart_stats_t stats;
+
+static int hungUp;
+
+static UARTCC26XX_Object uartObject;
+
+static UART_Config uartConfig = {NULL, &uartObject, NULL};
+
+static UART_Params openParams;
+
+// Driver ring buffer, free running head and tail
+static uint8_t *ring;
+static size_t ringHead;
+static size_t ringTail;
+
+// Bytes were lost since the last read ended
+static int overrun;
+
+// Read in progress
+static uint8_t *readBuf;
+static size_t readSize;
+static size_t readCount;
+
+// Write in progress
+static const uint8_t *writeBuf;
+static size_t writeSize;
+static size_t writeCount;
+
+// No write was chained from the last write callback
+static int txIdle;
+
+// Line credits in bytes, and when they were last topped up
+static double rxCredit;
+static double txCredit;
+static double rxLast;
+static double txLast;
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+static double nowSec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + (ts.tv_nsec / 1e9));
+}
+
+/* Bytes waiting on the line from the other end */
+static size_t lineWaiting(void)
+{
+    int n = 0;
+
+    if (ioctl(lineFd, FIONREAD, &n) < 0)
+    {
+        n = 0;
+    }
+    return ((size_t)n);
+}
+
+/* Takes what the line delivered since the last call into the ring buffer */
+static size_t lineReceive(double now)
+{
+    uint8_t chunk[4096];
+    size_t waiting = lineWaiting();
+    size_t n = waiting;
+    size_t free = config.ringSize - (ringHead - ringTail);
+    ssize_t got;
+    size_t i;
+
+    if (config.baudRate != 0)
+    {
+        // Credit is only earned while bytes are on their way
+        rxCredit = (waiting > 0) ?
+                   rxCredit + ((now - rxLast) * config.baudRate / 10) : 0;
+        if (n > (size_t)rxCredit)
+        {
+            n = (size_t)rxCredit;
+        }
+    }
+    rxLast = now;
+
+    // An unpaced line would overrun any ring, it is always flow controlled
+    if ((config.flowControl || config.baudRate == 0) && n > free)
+    {
+        // RTS is deasserted, the sender waits and earns no credit
+        n = free;
+        if (rxCredit > n)
+        {
+            rxCredit = n;
+        }
+    }
+    if (n > sizeof(chunk))
+    {
+        n = sizeof(chunk);
+    }
+    if (n == 0)
+    {
+        return (waiting);
+    }
+
+    got = read(lineFd, chunk, n);
+    if (got <= 0)
+    {
+        return (waiting);
+    }
+    if (config.baudRate != 0)
+    {
+        rxCredit -= got;
+    }
+    stats.rxWire += got;
+
+    for (i = 0; i < (size_t)got; i++)
+    {
+        if (ringHead - ringTail < config.ringSize)
+        {
+            ring[ringHead++ % config.ringSize] = chunk[i];
+        }
+        else
+        {
+            stats.rxLost += 1;
+            overrun = 1;
+        }
+    }
+
+    return (waiting - got);
+}
+
+/* Moves ring bytes to the read in progress, ends it if due */
+static int readService(size_t lineLeft)
+{
+    void *buf;
+    size_t count;
+
+    if (readBuf == NULL)
+    {
+        return (0);
+    }
+
+    while (readCount < readSize && ringTail != ringHead)
+    {
+        readBuf[readCount++] = ring[ringTail++ % config.ringSize];
+    }
+
+    // A partial read returns once the line goes quiet
+    if (readCount == 0 || (readCount < readSize && lineLeft > 0))
+    {
+        return (0);
+    }
+
+    uartObject.status = overrun ? UART_OVERRUN_ERROR : UART_OK;
+    overrun = 0;
+
+    buf     = readBuf;
+    count   = readCount;
+    readBuf = NULL;
+    openParams.readCallback(&uartConfig, buf, count);
+
+    return (1);
+}
+
+/* Puts as much of the write in progress on the line as is due */
+static int writeService(double now)
+{
+    size_t n;
+    ssize_t put;
+    const void *buf;
+
+    if (writeBuf == NULL)
+    {
+        return (0);
+    }
+
+    n = writeSize - writeCount;
+    if (config.baudRate != 0)
+    {
+        txCredit += (now - txLast) * config.baudRate / 10;
+        txLast = now;
+        if (n > (size_t)txCredit)
+        {
+            n = (size_t)txCredit;
+        }
+    }
+
+    if (n > 0)
+    {
+        put = write(lineFd, &writeBuf[writeCount], n);
+        if (put > 0)
+        {
+            writeCount += put;
+            stats.txWire += put;
+            if (config.baudRate != 0)
+            {
+                txCredit -= put;
+            }
+        }
+        else if (put < 0 && errno != EAGAIN)
+        {
+            hungUp = 1;
+        }
+    }
+
+    if (writeCount < writeSize)
+    {
+        return (0);
+    }
+
+    buf      = writeBuf;
+    writeBuf = NULL;
+    openParams.writeCallback(&uartConfig, (void *)buf, writeSize);
+    txIdle = (writeBuf == NULL);
+
+    return (1);
+}
+
+//*****************************************************************************
+// UART driver API
+//*****************************************************************************
+
+void UART_Params_init(UART_Params *params)
+{
+    memset(params, 0, sizeof(*params));
+    params->baudRate   = 115200;
+    params->dataLength = UART_LEN_8;
+}
+
+UART_Handle UART_open(uint_least8_t index, UART_Params *params)
+{
+    (void)index;
+
+    openParams = *params;
+    ringHead   = 0;
+    ringTail   = 0;
+    overrun    = 0;
+    readBuf    = NULL;
+    writeBuf   = NULL;
+    txIdle     = 1;
+    rxCredit   = 0;
+    txCredit   = 0;
+    rxLast     = nowSec();
+    uartObject.status = UART_OK;
+
+    return (&uartConfig);
+}
+
+void UART_close(UART_Handle handle)
+{
+    (void)handle;
+
+    readBuf  = NULL;
+    writeBuf = NULL;
+}
+
+int_fast16_t UART_control(UART_Handle handle, uint_fast16_t cmd, void *arg)
+{
+    (void)handle;
+    (void)cmd;
+    (void)arg;
+
+    // Reads always return partial, the only mode uart.c uses
+    return (0);
+}
+
+int_fast32_t UART_read(UART_Handle handle, void *buffer, size_t size)
+{
+    (void)handle;
+
+    if (readBuf != NULL)
+    {
+        return (-1);
+    }
+    readBuf   = buffer;
+    readSize  = size;
+    readCount = 0;
+    return (0);
+}
+
+int_fast32_t UART_write(UART_Handle handle, const void *buffer, size_t size)
+{
+    (void)handle;
+
+    if (writeBuf != NULL)
+    {
+        return (-1);
+    }
+
+    // A write chained from the last one's callback keeps the line busy,
+    // otherwise the line was idle and starts earning credit now
+    if (txIdle)
+    {
+        txIdle   = 0;
+        txCredit = 0;
+        txLast   = nowSec();
+    }
+
+    writeBuf   = buffer;
+    writeSize  = size;
+    writeCount = 0;
+    return (0);
+}
+
+//*****************************************************************************
+// Simulation API
+//*****************************************************************************
+
+void simuart_init(int fd, const simuart_config_t *cfg)
+{
+    lineFd = fd;
+    config = *cfg;
+    if (config.ringSize == 0)
+    {
+        config.ringSize = SIMUART_RINGBUF_SIZE;
+    }
+
+    free(ring);
+    ring = malloc(config.ringSize);
+    if (ring == NULL)
+    {
+        perror("simuart: malloc");
+        exit(1);
+    }
+
+    hungUp = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+int simuart_poll(void)
+{
+    int again = 1;
+
+    while (again && !hungUp)
+    {
+        double now = nowSec();
+
+        again  = readService(lineReceive(now));
+        again |= writeService(now);
+    }
+
+    return (!hungUp);
+}
+
+void simuart_wait(void)
+{
+    struct pollfd pfd;
+    struct timespec ts;
+    int ret;
+
+    pfd.fd     = lineFd;
+    pfd.events = 0;
+
+    // Incoming bytes matter unless they are held off by flow control
+    if ((!config.flowControl && config.baudRate != 0) ||
+        ringHead - ringTail < config.ringSize)
+    {
+        pfd.events |= POLLIN;
+    }
+    if (writeBuf != NULL && config.baudRate == 0)
+    {
+        pfd.events |= POLLOUT;
+    }
+
+    // A paced line moves bytes with time, not only when the fd is ready
+    ts.tv_sec  = 0;
+    ts.tv_nsec = SIMUART_TICKUS * 1000;
+    if (config.baudRate == 0 ||
+        (writeBuf == NULL && lineWaiting() == 0))
+    {
+        ts.tv_nsec = 100 * 1000 * 1000;
+    }
+
+    ret = ppoll(&pfd, 1, &ts, NULL);
+    if (ret > 0 && (pfd.revents & (POLLHUP | POLLERR)) &&
+        lineWaiting() == 0)
+    {
+        hungUp = 1;
+    }
+}
+
+const simuart_stats_t *simuart_stats(void)
+{
+    return (&stats);
+}
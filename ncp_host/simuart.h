@@ -0,0 +1,96 @@
+/******************************************************************************
+
+ @file  simuart.h
+
+ @brief Simulated UART driver for host builds of the platform uart module
+
+ Implements the TI UART driver calls made by platform/uart.c on top of a
+ pseudo-terminal. The line runs at a set baud rate in each direction, or
+ unpaced. Received bytes go through a driver ring buffer as on the
+ UARTCC26XX. With flow control the sender is held off when the ring is
+ full, without it the bytes that do not fit are lost as an overrun.
+
+ There are no threads. Driver callbacks, the simulated interrupts, are only
+ taken in simuart_poll(), which the processing loop calls between steps.
+
+ *****************************************************************************/
+#ifndef SIMUART_H
+#define SIMUART_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+// Default driver ring buffer size, as CC1352R1_LAUNCHXL_UART0_RINGBUF_SIZE
+#define SIMUART_RINGBUF_SIZE    256
+
+//*****************************************************************************
+// Typedefs
+//*****************************************************************************
+
+// Line configuration
+typedef struct
+{
+    uint32_t baudRate;      // Line rate in each direction, 0 for unpaced
+    int      flowControl;   // Hold off the sender when the ring is full,
+                            // always on for an unpaced line
+    size_t   ringSize;      // Driver ring buffer size
+} simuart_config_t;
+
+// Line counters
+typedef struct
+{
+    uint64_t rxWire;        // Bytes taken off the line
+    uint64_t txWire;        // Bytes put on the line
+    uint64_t rxLost;        // Bytes lost to a full ring buffer
+} simuart_stats_t;
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+/**
+ * @fn      simuart_init
+ *
+ * @brief   Attach the simulated UART to the device end of a pseudo-terminal.
+ *          Call before otPlatUartEnable().
+ *
+ * @param   fd  - pseudo-terminal file descriptor, in raw mode
+ * @param   cfg - line configuration
+ *
+ * @return  none
+ */
+extern void simuart_init(int fd, const simuart_config_t *cfg);
+
+/**
+ * @fn      simuart_poll
+ *
+ * @brief   Move bytes on and off the line as far as the baud rate allows
+ *          and run the driver callbacks that are due
+ *
+ * @return  0 once the other end of the line has hung up, 1 otherwise
+ */
+extern int simuart_poll(void);
+
+/**
+ * @fn      simuart_wait
+ *
+ * @brief   Sleep until the line could need servicing again
+ *
+ * @return  none
+ */
+extern void simuart_wait(void);
+
+/**
+ * @fn      simuart_stats
+ *
+ * @brief   Get the line counters
+ *
+ * @return  pointer to the counters
+ */
+extern const simuart_stats_t *simuart_stats(void);
+
+#endif /* SIMUART_H */
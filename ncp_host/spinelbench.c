@@ -0,0 +1,904 @@
+/******************************************************************************
+
+ @file  spinelbench.c
+
+ @brief Spinel throughput benchmark of the NCP uart and spi transports
+
+ Runs platform/uart.c under the simulated NCP at the device end of a
+ pseudo-terminal and plays the host at the other end. With -s it runs
+ platform/spi_slave.c instead, on a simulated spi bus that the host clocks
+ as an spi master. For each packet size
+ the host keeps a window of spinel STREAM_NET packets in flight, the way
+ wpantund feeds IPv6 traffic to the NCP, and the NCP loops each one back as
+ a packet from the mesh. Reports packets and bytes per second, round trip
+ latency percentiles, and the buffer exhaustion events on the NCP side:
+ packets dropped for a full frame buffer, bytes lost to driver ring
+ overruns and receive stalls of platform/uart.c, or the transactions per
+ packet and CRC errors of platform/spi_slave.c.
+
+ The spi host works as spi-hdlc-adapter does. Each transaction carries the
+ next host frame, if any, and is at least long enough for a small frame
+ from the NCP. A longer NCP frame is clocked out by a second transaction of
+ the length its header announced. Without a frame to send, the host waits
+ for the NCP to assert the host interrupt line, or polls with -n.
+
+ With a baud rate or spi clock set, the throughput is compared with what
+ the link can carry. A run that gets close to the line rate is limited by the link,
+ anything less by the NCP. The NCP runs on the host CPU, so set a
+ processing time per packet with -p to model the device.
+
+ Each packet size runs in a fork()ed child with a fresh NCP.
+
+ Usage: spinelbench [-b baud] [-f] [-s hz] [-n us] [-p us] [-w window]
+                    [-t seconds] [size ...]
+
+ *****************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "hdlc.h"
+#include "simncp.h"
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+#define BENCH_BAUD          115200  // Default line rate
+#define BENCH_WINDOW        4       // Default packets in flight
+#define BENCH_SECONDS       2.0     // Default sending time per packet size
+#define BENCH_DRAINSEC      2.0     // Wait for packets still on the way
+#define BENCH_STATUSSEC     1.0     // A packet without a status is lost
+#define BENCH_EXITMS        2000    // Time for the NCP to exit on hang up
+
+// Spinel transaction IDs 1..15, 0 is for unsolicited frames
+#define BENCH_MAXWINDOW     15
+
+// IPv6 header, then the sequence number of the packet
+#define BENCH_IP6HDR_LEN    40
+#define BENCH_MINPKT        (BENCH_IP6HDR_LEN + 4)
+#define BENCH_MAXPKT        1280
+
+// Share of the line rate at which the link is the limit
+#define BENCH_LINKLIMIT     0.9
+
+// Spi host, as spi-hdlc-adapter with its default small packet size
+#define BENCH_SPIHDR_LEN    5
+#define BENCH_SPICRC_LEN    2
+#define BENCH_SPIPATTERN    0x02
+#define BENCH_SPIMASK       0x03
+#define BENCH_SPICRCFLAG    0x40
+#define BENCH_SPISMALLPKT   32
+#define BENCH_SPIACCEPT     2043    // Host receive buffer less the header
+#define BENCH_SPIGAPUS      20      // Chip select and driver time per transfer
+#define BENCH_SPIRETRYUS    200     // Wait after the NCP refused a frame
+
+// Spinel header, command, property and the data length
+#define BENCH_STREAMHDR_LEN 5
+
+// Packet states
+#define BENCH_PENDING       0
+#define BENCH_RECEIVED      1
+#define BENCH_DROPPED       2
+
+//*****************************************************************************
+// Typedefs
+//*****************************************************************************
+
+// Packet waiting for its status, by transaction ID
+typedef struct
+{
+    int      inUse;
+    uint32_t seq;
+    double   sentAt;
+} bench_tid_t;
+
+// Results of one packet size
+typedef struct
+{
+    uint32_t sent;
+    uint32_t received;
+    uint32_t dropped;
+    uint32_t lost;
+    uint32_t corrupt;
+    uint32_t badFrames;
+    uint64_t upBytes;       // Bytes written to the line by the host
+    uint64_t downBytes;     // Bytes read from the line by the host
+    uint64_t xfers;         // Spi transactions clocked by the host
+    double   elapsed;       // First to last packet received
+    double  *latency;       // Round trip of each received packet, ms
+} bench_result_t;
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static const unsigned defaultSizes[] = {64, 128, 256, 512, 1024, 1280};
+
+static simncp_config_t ncpConfig =
+{
+    {BENCH_BAUD, 0, SIMUART_RINGBUF_SIZE},
+    0,
+    0
+};
+
+// Spi clock, 0 to run the uart
+static uint32_t spiClock;
+
+// Spi host polls at this interval instead of using the interrupt line
+static uint32_t spiPollUs;
+
+static unsigned window = BENCH_WINDOW;
+
+static double seconds = BENCH_SECONDS;
+
+static simncp_stats_t *ncpStats;
+
+// State of the run in progress
+static unsigned pktSize;
+static bench_result_t result;
+static bench_tid_t tids[BENCH_MAXWINDOW + 1];
+static uint8_t *pktState;
+static double *pktSentAt;
+static uint32_t pktCap;
+static double firstRx;
+static double lastRx;
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+static double nowSec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + (ts.tv_nsec / 1e9));
+}
+
+static int cmpDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return ((x > y) - (x < y));
+}
+
+static double percentile(const double *sorted, uint32_t n, double p)
+{
+    return (n ? sorted[(uint32_t)((n - 1) * p)] : 0);
+}
+
+/* Fills in the IPv6 packet with sequence number seq */
+static void makePacket(uint32_t seq, unsigned size, uint8_t *pkt)
+{
+    uint32_t x = seq * 2654435761u + 1;
+    unsigned i;
+
+    memset(pkt, 0, BENCH_IP6HDR_LEN);
+    pkt[0] = 0x60;
+    pkt[4] = (uint8_t)((size - BENCH_IP6HDR_LEN) >> 8);
+    pkt[5] = (uint8_t)(size - BENCH_IP6HDR_LEN);
+    pkt[6] = 17;                                // UDP
+    pkt[7] = 64;
+    pkt[8] = 0xFE; pkt[9] = 0x80; pkt[23] = 1;  // fe80::1
+    pkt[24] = 0xFE; pkt[25] = 0x80; pkt[39] = 2; // fe80::2
+
+    pkt[40] = (uint8_t)(seq >> 24);
+    pkt[41] = (uint8_t)(seq >> 16);
+    pkt[42] = (uint8_t)(seq >> 8);
+    pkt[43] = (uint8_t)seq;
+
+    // Random payload, so flag and escape bytes turn up as in real traffic
+    for (i = BENCH_MINPKT; i < size; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        pkt[i] = (uint8_t)x;
+    }
+}
+
+/* Handles a frame from the NCP */
+static void hostFrame(const uint8_t *frame, size_t len)
+{
+    uint8_t expect[BENCH_MAXPKT];
+    unsigned tid;
+    uint32_t seq;
+    size_t pktLen;
+
+    if (len < 4 || !(frame[0] & SPINEL_HEADER_FLAG) ||
+        frame[1] != SPINEL_CMD_PROP_VALUE_IS)
+    {
+        result.corrupt += 1;
+        return;
+    }
+
+    tid = frame[0] & SPINEL_HEADER_TIDMASK;
+
+    if (frame[2] == SPINEL_PROP_LAST_STATUS)
+    {
+        if (tid != 0 && tids[tid].inUse)
+        {
+            tids[tid].inUse = 0;
+            if (frame[3] != SPINEL_STATUS_OK &&
+                pktState[tids[tid].seq] == BENCH_PENDING)
+            {
+                pktState[tids[tid].seq] = BENCH_DROPPED;
+                result.dropped += 1;
+            }
+        }
+        return;
+    }
+
+    pktLen = (len >= BENCH_STREAMHDR_LEN) ? (frame[3] | (frame[4] << 8)) : 0;
+    if (frame[2] != SPINEL_PROP_STREAM_NET || pktLen != pktSize ||
+        len != BENCH_STREAMHDR_LEN + pktLen)
+    {
+        result.corrupt += 1;
+        return;
+    }
+
+    frame += BENCH_STREAMHDR_LEN;
+    seq = ((uint32_t)frame[40] << 24) | (frame[41] << 16) |
+          (frame[42] << 8) | frame[43];
+    if (seq >= result.sent)
+    {
+        result.corrupt += 1;
+        return;
+    }
+
+    makePacket(seq, pktSize, expect);
+    if (memcmp(frame, expect, pktSize) != 0)
+    {
+        result.corrupt += 1;
+    }
+    else if (pktState[seq] == BENCH_PENDING)
+    {
+        lastRx = nowSec();
+        if (result.received == 0)
+        {
+            firstRx = lastRx;
+        }
+        pktState[seq] = BENCH_RECEIVED;
+        result.latency[result.received++] = (lastRx - pktSentAt[seq]) * 1e3;
+    }
+}
+
+/* Builds the spinel frame of the next packet under transaction tid */
+static size_t hostSend(unsigned tid, uint8_t *frame)
+{
+    uint32_t seq = result.sent;
+
+    if (seq == pktCap)
+    {
+        pktCap = pktCap ? pktCap * 2 : 4096;
+        pktState  = realloc(pktState, pktCap);
+        pktSentAt = realloc(pktSentAt, pktCap * sizeof(double));
+        result.latency = realloc(result.latency, pktCap * sizeof(double));
+        if (!pktState || !pktSentAt || !result.latency)
+        {
+            perror("spinelbench: realloc");
+            exit(1);
+        }
+    }
+
+    frame[0] = SPINEL_HEADER_FLAG | tid;
+    frame[1] = SPINEL_CMD_PROP_VALUE_SET;
+    frame[2] = SPINEL_PROP_STREAM_NET;
+    frame[3] = (uint8_t)pktSize;
+    frame[4] = (uint8_t)(pktSize >> 8);
+    makePacket(seq, pktSize, &frame[BENCH_STREAMHDR_LEN]);
+
+    pktState[seq]    = BENCH_PENDING;
+    pktSentAt[seq]   = nowSec();
+    tids[tid].inUse  = 1;
+    tids[tid].seq    = seq;
+    tids[tid].sentAt = pktSentAt[seq];
+    result.sent += 1;
+
+    return (BENCH_STREAMHDR_LEN + pktSize);
+}
+
+/* Frees the transaction IDs of lost packets, returns the packets in flight */
+static unsigned hostInFlight(double now)
+{
+    unsigned inFlight = 0;
+    unsigned tid;
+
+    for (tid = 1; tid <= window; tid++)
+    {
+        // The NCP never saw it, its frame was lost on the line
+        if (tids[tid].inUse && now - tids[tid].sentAt > BENCH_STATUSSEC)
+        {
+            tids[tid].inUse = 0;
+        }
+        inFlight += tids[tid].inUse;
+    }
+    return (inFlight);
+}
+
+/* Returns 1 once every packet is back or the drain time is up */
+static int hostDone(double now, double end)
+{
+    uint32_t i, waiting = 0;
+
+    if (now < end)
+    {
+        return (0);
+    }
+
+    for (i = 0; i < result.sent; i++)
+    {
+        waiting += (pktState[i] == BENCH_PENDING);
+    }
+    if (waiting == 0 || now > end + BENCH_DRAINSEC)
+    {
+        result.lost = waiting;
+        return (1);
+    }
+    return (0);
+}
+
+/* Plays the host on the master end of the line until the run is over */
+static void hostRun(int fd)
+{
+    static uint8_t txq[BENCH_MAXWINDOW * HDLC_MAXENCODED(BENCH_STREAMHDR_LEN +
+                                                          BENCH_MAXPKT)];
+    uint8_t frame[BENCH_STREAMHDR_LEN + BENCH_MAXPKT];
+    uint8_t rxBuf[4096];
+    uint8_t rxFrame[BENCH_STREAMHDR_LEN + BENCH_MAXPKT + 2];
+    hdlc_decoder_t dec;
+    size_t txqLen = 0;
+    double start = nowSec();
+    double end = start + seconds;
+    unsigned tid;
+
+    hdlc_decoderInit(&dec, rxFrame, sizeof(rxFrame));
+
+    for (;;)
+    {
+        struct pollfd pfd;
+        double now = nowSec();
+        unsigned inFlight = hostInFlight(now);
+        ssize_t n;
+
+        for (tid = 1; now < end && inFlight < window && tid <= window; tid++)
+        {
+            if (!tids[tid].inUse)
+            {
+                txqLen += hdlc_encode(frame, hostSend(tid, frame),
+                                      &txq[txqLen]);
+                inFlight += 1;
+            }
+        }
+
+        if (txqLen > 0)
+        {
+            n = write(fd, txq, txqLen);
+            if (n > 0)
+            {
+                memmove(txq, &txq[n], txqLen - n);
+                txqLen -= n;
+                result.upBytes += n;
+            }
+        }
+
+        pfd.fd     = fd;
+        pfd.events = POLLIN | (txqLen ? POLLOUT : 0);
+        poll(&pfd, 1, 1);
+
+        n = read(fd, rxBuf, sizeof(rxBuf));
+        if (n > 0)
+        {
+            result.downBytes += n;
+            result.badFrames += hdlc_decode(&dec, rxBuf, n, hostFrame);
+        }
+
+        if (hostDone(now, end))
+        {
+            break;
+        }
+    }
+
+    // Steady state, without the time to fill the pipeline
+    result.elapsed = lastRx - firstRx;
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return ((uint16_t)(p[0] | (p[1] << 8)));
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+/* Reads one message from the NCP, returns its type or 0 if there is none */
+static int spiRecv(int fd, uint8_t *msg, size_t size, ssize_t *len,
+                   int *intAsserted)
+{
+    *len = recv(fd, msg, size, MSG_DONTWAIT);
+    if (*len <= 0)
+    {
+        return (0);
+    }
+    if (msg[0] == SIMSPI_MSG_INT && *len == 2)
+    {
+        *intAsserted = (msg[1] == 0);
+    }
+    return (msg[0]);
+}
+
+/* Clocks one transaction, returns the MISO bytes in miso */
+static void spiTransfer(int fd, const uint8_t *mosi, size_t len, uint8_t *miso,
+                        int *intAsserted)
+{
+    uint8_t msg[1 + SIMSPI_MAXXFER];
+    struct pollfd pfd;
+    struct timespec ts;
+    double done = nowSec() + (len * 8.0 / spiClock) + (BENCH_SPIGAPUS / 1e6);
+    ssize_t n;
+
+    msg[0] = SIMSPI_MSG_XFER;
+    memcpy(&msg[1], mosi, len);
+    if (send(fd, msg, 1 + len, MSG_NOSIGNAL) < 0)
+    {
+        memset(miso, 0xFF, len);
+        return;
+    }
+    result.xfers += 1;
+
+    // The NCP answers as the bytes are clocked, take the bus time after
+    pfd.fd     = fd;
+    pfd.events = POLLIN;
+    while (spiRecv(fd, msg, sizeof(msg), &n, intAsserted) != SIMSPI_MSG_REPLY)
+    {
+        if (n == 0 || poll(&pfd, 1, BENCH_EXITMS) <= 0)
+        {
+            memset(miso, 0xFF, len);
+            return;
+        }
+    }
+    memcpy(miso, &msg[1], (n - 1 < (ssize_t)len) ? n - 1 : len);
+
+    ts.tv_sec  = (time_t)done;
+    ts.tv_nsec = (long)((done - ts.tv_sec) * 1e9);
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+/* Plays the host as spi master until the run is over */
+static void hostRunSpi(int fd)
+{
+    static uint8_t txq[BENCH_MAXWINDOW][BENCH_STREAMHDR_LEN + BENCH_MAXPKT];
+    size_t txqLen[BENCH_MAXWINDOW];
+    unsigned txqHead = 0;
+    unsigned txqCount = 0;
+    uint8_t mosi[SIMSPI_MAXXFER];
+    uint8_t miso[SIMSPI_MAXXFER];
+    uint8_t msg[1 + SIMSPI_MAXXFER];
+    double start = nowSec();
+    double end = start + seconds;
+    double nextPoll = start;
+    double retryAt = start;
+    int intAsserted = 0;
+    size_t ncpLen = 0;
+    unsigned tid;
+
+    for (;;)
+    {
+        double now = nowSec();
+        unsigned inFlight = hostInFlight(now);
+        size_t dataLen, len, ncpData;
+        int clockIn;
+        ssize_t n;
+
+        for (tid = 1; now < end && inFlight < window && tid <= window; tid++)
+        {
+            if (!tids[tid].inUse)
+            {
+                unsigned slot = (txqHead + txqCount++) % BENCH_MAXWINDOW;
+
+                txqLen[slot] = hostSend(tid, txq[slot]);
+                inFlight += 1;
+            }
+        }
+
+        while (spiRecv(fd, msg, sizeof(msg), &n, &intAsserted) != 0)
+        {
+        }
+
+        clockIn = (spiPollUs != 0) ? (now >= nextPoll) : intAsserted;
+        if (!(ncpLen > 0 || clockIn || (txqCount > 0 && now >= retryAt)))
+        {
+            struct pollfd pfd;
+            struct timespec ts;
+            double wait = 1e-3;
+
+            if (hostDone(now, end))
+            {
+                break;
+            }
+
+            // Until the interrupt line, the next poll or the next retry
+            if (spiPollUs != 0 && nextPoll - now < wait)
+            {
+                wait = nextPoll - now;
+            }
+            if (txqCount > 0 && retryAt - now < wait)
+            {
+                wait = retryAt - now;
+            }
+            ts.tv_sec  = 0;
+            ts.tv_nsec = (long)(wait * 1e9);
+            pfd.fd     = fd;
+            pfd.events = POLLIN;
+            ppoll(&pfd, 1, &ts, NULL);
+            continue;
+        }
+
+        // Our frame, and room for as much of the NCP frame as we know of
+        dataLen = (txqCount > 0 && now >= retryAt) ? txqLen[txqHead] : 0;
+        len = dataLen + BENCH_SPICRC_LEN;
+        if (len < ncpLen)
+        {
+            len = ncpLen;
+        }
+        if (len < BENCH_SPISMALLPKT)
+        {
+            len = BENCH_SPISMALLPKT;
+        }
+        len += BENCH_SPIHDR_LEN;
+
+        memset(mosi, 0xFF, len);
+        mosi[0] = BENCH_SPIPATTERN | BENCH_SPICRCFLAG;
+        put16(&mosi[1], BENCH_SPIACCEPT);
+        put16(&mosi[3], (uint16_t)dataLen);
+        if (dataLen > 0)
+        {
+            memcpy(&mosi[BENCH_SPIHDR_LEN], txq[txqHead], dataLen);
+        }
+        put16(&mosi[BENCH_SPIHDR_LEN + dataLen],
+              hdlc_fcs(mosi, BENCH_SPIHDR_LEN + dataLen));
+
+        spiTransfer(fd, mosi, len, miso, &intAsserted);
+        nextPoll = nowSec() + (spiPollUs / 1e6);
+        ncpLen = 0;
+
+        if ((miso[0] & BENCH_SPIMASK) != BENCH_SPIPATTERN)
+        {
+            // Nothing prepared on the NCP side
+            retryAt = nowSec() + (BENCH_SPIRETRYUS / 1e6);
+        }
+        else
+        {
+            if (dataLen > 0)
+            {
+                if (get16(&miso[1]) >= dataLen)
+                {
+                    result.upBytes += BENCH_SPIHDR_LEN + dataLen +
+                                      BENCH_SPICRC_LEN;
+                    txqHead = (txqHead + 1) % BENCH_MAXWINDOW;
+                    txqCount -= 1;
+                }
+                else
+                {
+                    retryAt = nowSec() + (BENCH_SPIRETRYUS / 1e6);
+                }
+            }
+
+            ncpData = get16(&miso[3]);
+            if (ncpData > 0)
+            {
+                size_t need = BENCH_SPIHDR_LEN + ncpData +
+                              ((miso[0] & BENCH_SPICRCFLAG) ?
+                               BENCH_SPICRC_LEN : 0);
+
+                if (need > len)
+                {
+                    // Clock it out whole with the next transaction
+                    ncpLen = need - BENCH_SPIHDR_LEN;
+                }
+                else if ((miso[0] & BENCH_SPICRCFLAG) &&
+                         hdlc_fcs(miso, BENCH_SPIHDR_LEN + ncpData) !=
+                         get16(&miso[BENCH_SPIHDR_LEN + ncpData]))
+                {
+                    result.badFrames += 1;
+                }
+                else
+                {
+                    result.downBytes += need;
+                    hostFrame(&miso[BENCH_SPIHDR_LEN], ncpData);
+                }
+            }
+        }
+
+        if (hostDone(nowSec(), end))
+        {
+            break;
+        }
+    }
+
+    result.elapsed = lastRx - firstRx;
+}
+
+/* Runs one packet size against a fresh NCP and prints its table row */
+static int benchSize(unsigned size)
+{
+    struct termios tio;
+    simncp_stats_t *s = ncpStats;
+    double pps, linePps = 0, lineShare = 0, lineRate = 0;
+    uint32_t n;
+    int master, slave;
+    int sv[2];
+    pid_t pid;
+    int hung;
+    int ok;
+
+    if (ncpConfig.spi)
+    {
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0)
+        {
+            perror("spinelbench: socketpair");
+            exit(1);
+        }
+        master = sv[0];
+        slave  = sv[1];
+        lineRate = spiClock / 8.0;
+    }
+    else
+    {
+        master = posix_openpt(O_RDWR | O_NOCTTY);
+        if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0 ||
+            (slave = open(ptsname(master), O_RDWR | O_NOCTTY)) < 0)
+        {
+            perror("spinelbench: pty");
+            exit(1);
+        }
+        tcgetattr(slave, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(slave, TCSANOW, &tio);
+        lineRate = ncpConfig.uart.baudRate / 10.0;
+    }
+
+    fflush(stdout);
+    pid = fork();
+    if (pid == 0)
+    {
+        close(master);
+        fcntl(slave, F_SETFL, O_NONBLOCK);
+        simncp_run(slave, &ncpConfig, ncpStats);
+        _exit(0);
+    }
+    close(slave);
+    fcntl(master, F_SETFL, O_NONBLOCK);
+
+    pktSize = size;
+    free(result.latency);
+    memset(&result, 0, sizeof(result));
+    memset(tids, 0, sizeof(tids));
+    free(pktState);
+    free(pktSentAt);
+    pktState  = NULL;
+    pktSentAt = NULL;
+    pktCap    = 0;
+
+    if (ncpConfig.spi)
+    {
+        hostRunSpi(master);
+    }
+    else
+    {
+        hostRun(master);
+    }
+
+    // Hang up, the NCP exits
+    close(master);
+    for (hung = 1; hung <= BENCH_EXITMS && waitpid(pid, NULL, WNOHANG) == 0;
+         hung++)
+    {
+        usleep(1000);
+    }
+    hung = (hung > BENCH_EXITMS);
+    if (hung)
+    {
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+    }
+
+    n = result.received;
+    qsort(result.latency, n, sizeof(double), cmpDouble);
+    pps = (n > 1 && result.elapsed > 0) ? (n - 1) / result.elapsed : 0;
+
+    if (lineRate != 0 && n > 0)
+    {
+        // The busier direction of the line sets the ceiling, both
+        // directions move at once on either link
+        double up   = (double)result.upBytes / result.sent;
+        double down = (double)result.downBytes / (n + result.dropped);
+
+        linePps   = lineRate / ((up > down) ? up : down);
+        lineShare = pps / linePps;
+    }
+
+    printf("%5u %8.1f %8.1f %8.0f %7.1f %7.1f %7.1f %7.1f %6u %6u ",
+           size, pps, pps * size / 1e3,
+           (n > 0) ? pps * result.downBytes / (n + result.dropped) : 0,
+           percentile(result.latency, n, 0.5),
+           percentile(result.latency, n, 0.9),
+           percentile(result.latency, n, 0.99),
+           percentile(result.latency, n, 1.0),
+           s->drops, result.lost);
+    if (ncpConfig.spi)
+    {
+        printf("%6.1f %6u ", (result.sent > 0) ?
+               (double)result.xfers / result.sent : 0, s->spi.crcErrors);
+    }
+    else
+    {
+        printf("%6u %6u ", s->uart.rxOverruns, s->uart.rxStalls);
+    }
+    printf("%6.0f %6s\n", lineShare * 100,
+           (linePps == 0) ? "-" :
+           (lineShare >= BENCH_LINKLIMIT) ? "link" : "ncp");
+
+    // Lost packets and bad frames are only expected after an overrun, the
+    // spi link has none
+    ok = (!hung && result.corrupt == 0 && result.badFrames == 0 &&
+          s->busy == 0 &&
+          ((result.lost == 0 && s->badFrames == 0) || s->line.rxLost > 0) &&
+          s->spi.crcErrors == 0 && s->spi.failed == 0);
+    if (!ok)
+    {
+        printf("      %u corrupt, %u bad frames, %u lost, %u NCP bad frames, "
+               "%u busy sends, %u crc errors%s\n", result.corrupt,
+               result.badFrames, result.lost, s->badFrames, s->busy,
+               s->spi.crcErrors, hung ? ", NCP hung" : "");
+    }
+    return (ok);
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: spinelbench [-b baud] [-f] [-s hz] [-n us] [-p us] "
+            "[-w window] [-t seconds] [size ...]\n"
+            "  -b baud     line rate, 0 for unpaced and flow controlled (%u)\n"
+            "  -f          hardware flow control\n"
+            "  -s hz       use the spi transport at this clock rate\n"
+            "  -n us       spi host polls instead of using the interrupt\n"
+            "  -p us       NCP processing time per packet (0)\n"
+            "  -w window   packets in flight, 1 to %u (%u)\n"
+            "  -t seconds  sending time per packet size (%.0f)\n"
+            "  size        IPv6 packet sizes, %u to %u\n",
+            BENCH_BAUD, BENCH_MAXWINDOW, BENCH_WINDOW, BENCH_SECONDS,
+            BENCH_MINPKT, BENCH_MAXPKT);
+    exit(2);
+}
+
+//*****************************************************************************
+// Main
+//*****************************************************************************
+
+int main(int argc, char **argv)
+{
+    int opt;
+    int failed = 0;
+
+    while ((opt = getopt(argc, argv, "b:fs:n:p:w:t:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b':
+                ncpConfig.uart.baudRate = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'f':
+                ncpConfig.uart.flowControl = 1;
+                break;
+            case 's':
+                spiClock = (uint32_t)strtoul(optarg, NULL, 0);
+                ncpConfig.spi = 1;
+                break;
+            case 'n':
+                spiPollUs = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'p':
+                ncpConfig.frameCostUs = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'w':
+                window = (unsigned)strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                seconds = strtod(optarg, NULL);
+                break;
+            default:
+                usage();
+        }
+    }
+    if (window < 1 || window > BENCH_MAXWINDOW || seconds <= 0 ||
+        (ncpConfig.spi && spiClock == 0))
+    {
+        usage();
+    }
+
+    // Transactions are timed with sleeps, they should not run long
+    prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0);
+
+    ncpStats = mmap(NULL, sizeof(*ncpStats), PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (ncpStats == MAP_FAILED)
+    {
+        perror("spinelbench: mmap");
+        return (1);
+    }
+
+    if (ncpConfig.spi)
+    {
+        printf("spinelbench: spi at %u Hz, ", spiClock);
+        if (spiPollUs != 0)
+        {
+            printf("polled every %u us, ", spiPollUs);
+        }
+        else
+        {
+            printf("host interrupt, ");
+        }
+    }
+    else if (ncpConfig.uart.baudRate != 0)
+    {
+        printf("spinelbench: %u baud, flow control %s, ",
+               ncpConfig.uart.baudRate,
+               ncpConfig.uart.flowControl ? "on" : "off");
+    }
+    else
+    {
+        printf("spinelbench: unpaced line, flow control on, ");
+    }
+    printf("%u us per packet, window %u\n\n", ncpConfig.frameCostUs, window);
+
+    printf("%5s %8s %8s %8s %7s %7s %7s %7s %6s %6s %6s %6s %6s %6s\n",
+           "size", "pkt/s", "kB/s", "line B/s", "p50 ms", "p90 ms", "p99 ms",
+           "max ms", "drops", "lost",
+           ncpConfig.spi ? "xfr/pk" : "ovr", ncpConfig.spi ? "crc" : "stalls",
+           "line%", "limit");
+
+    if (optind < argc)
+    {
+        for (; optind < argc; optind++)
+        {
+            unsigned size = (unsigned)strtoul(argv[optind], NULL, 0);
+
+            if (size < BENCH_MINPKT || size > BENCH_MAXPKT)
+            {
+                usage();
+            }
+            failed |= !benchSize(size);
+        }
+    }
+    else
+    {
+        unsigned i;
+
+        for (i = 0; i < sizeof(defaultSizes) / sizeof(defaultSizes[0]); i++)
+        {
+            failed |= !benchSize(defaultSizes[i]);
+        }
+    }
+
+    return (failed ? 1 : 0);
+}
@@ -0,0 +1,41 @@
+/*
+ * Host stand-in for the TI NVS driver API used by the NV driver. The
+ * implementation is the simulated flash in simflash.c.
+ */
+#ifndef NVS_H
+#define NVS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NVS_STATUS_SUCCESS      (0)
+#define NVS_STATUS_ERROR        (-1)
+
+#define NVS_WRITE_ERASE         (0x1)
+#define NVS_WRITE_PRE_VERIFY    (0x2)
+#define NVS_WRITE_POST_VERIFY   (0x4)
+
+typedef struct NVS_Config_ *NVS_Handle;
+
+typedef struct
+{
+    void *regionBase;
+    size_t regionSize;
+    size_t sectorSize;
+} NVS_Attrs;
+
+extern void NVS_init(void);
+
+extern NVS_Handle NVS_open(uint_least8_t index, void *params);
+
+extern void NVS_getAttrs(NVS_Handle handle, NVS_Attrs *attrs);
+
+extern int_fast16_t NVS_read(NVS_Handle handle, size_t offset, void *buffer,
+                             size_t bufferSize);
+
+extern int_fast16_t NVS_write(NVS_Handle handle, size_t offset, void *buffer,
+                              size_t bufferSize, uint_fast16_t flags);
+
+extern int_fast16_t NVS_erase(NVS_Handle handle, size_t offset, size_t size);
+
+#endif /* NVS_H */
@@ -0,0 +1,42 @@
+/*
+ * Host stand-in for the TI-RTOS priority gate. The host harness drives the
+ * NV driver from a single thread, so the gate does nothing.
+ */
+#ifndef GATEMUTEXPRI_H
+#define GATEMUTEXPRI_H
+
+#include <xdc/std.h>
+
+typedef struct
+{
+    int unused;
+} GateMutexPri_Params;
+
+typedef void *GateMutexPri_Handle;
+
+static inline void GateMutexPri_Params_init(GateMutexPri_Params *params)
+{
+    (void)params;
+}
+
+static inline GateMutexPri_Handle GateMutexPri_create(GateMutexPri_Params *params,
+                                                      void *eb)
+{
+    (void)params;
+    (void)eb;
+    return ((GateMutexPri_Handle)1);
+}
+
+static inline IArg GateMutexPri_enter(GateMutexPri_Handle handle)
+{
+    (void)handle;
+    return (0);
+}
+
+static inline void GateMutexPri_leave(GateMutexPri_Handle handle, IArg key)
+{
+    (void)handle;
+    (void)key;
+}
+
+#endif /* GATEMUTEXPRI_H */
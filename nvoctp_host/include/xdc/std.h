@@ -0,0 +1,19 @@
+/*
+ * Host stand-in for the XDC standard types used by the NV driver.
+ */
+#ifndef XDC_STD_H
+#define XDC_STD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef intptr_t IArg;
+
+#ifndef TRUE
+#define TRUE  1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#endif /* XDC_STD_H */
@@ -0,0 +1,254 @@
+/******************************************************************************
+
+ @file  nvbench.c
+
+ @brief Benchmark of the OpenThread settings API on the NVOCTP driver
+
+ For a range of store sizes, reports the rate of otPlatSettingsGet/Set and
+ of Add/Delete pairs, the time of a full compaction, and the flash cost of
+ Set: bytes programmed per payload byte (write amplification) and page
+ erases per thousand Sets. Then compares the worst case flash work of a
+ single Set with compaction done on the write path against compaction done
+ in background steps between writes.
+
+ Times are host times. They show how the cost scales, not what it is on the
+ device. The flash counters are exact.
+
+ Each measurement runs in a fork()ed child, since the driver only
+ initializes once per reset.
+
+ Usage: nvbench
+
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <openthread/platform/settings.h>
+
+#include "nvintf.h"
+#include "nvoctp.h"
+#include "simflash.h"
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+#define BENCH_VALLEN    16      // Bytes per settings value
+#define BENCH_GETS      20000   // Gets per store size
+#define BENCH_SETS      5000    // Sets per store size
+#define BENCH_ADDS      2000    // Add/Delete pairs per store size
+#define BENCH_COMPACTS  50      // Full compactions per store size
+#define BENCH_LATITEMS  64      // Store size for the latency comparison
+
+// Settings key for the Add/Delete pairs, above the populated keys
+#define BENCH_ADDKEY    1000
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static const uint16_t storeSizes[] = {8, 16, 32, 64, 128};
+
+static NVINTF_nvFuncts_t nvFps;
+
+static int compactPending;
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+static double nowUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((ts.tv_sec * 1e6) + (ts.tv_nsec / 1e3));
+}
+
+static void compactNotify(void)
+{
+    compactPending = 1;
+}
+
+/* Boots the driver on a formatted flash holding keys 1..items */
+static void populate(uint16_t items)
+{
+    uint8_t val[BENCH_VALLEN];
+    uint16_t key;
+
+    simflash_format();
+    otPlatSettingsInit(NULL);
+    NVOCTP_loadApiPtrsExt(&nvFps);
+
+    memset(val, 0x5A, sizeof(val));
+    for (key = 1; key <= items; key++)
+    {
+        otPlatSettingsSet(NULL, key, val, sizeof(val));
+    }
+}
+
+/* Measures one store size and prints its table row */
+static void benchStore(uint16_t items)
+{
+    uint8_t val[BENCH_VALLEN];
+    uint16_t len;
+    uint64_t programmed;
+    uint32_t erases;
+    double t, getRate, setRate, addRate, compactUs;
+    int i;
+
+    populate(items);
+    srand(items);
+    memset(val, 0xA5, sizeof(val));
+
+    t = nowUs();
+    for (i = 0; i < BENCH_GETS; i++)
+    {
+        len = sizeof(val);
+        otPlatSettingsGet(NULL, 1 + (rand() % items), 0, val, &len);
+    }
+    getRate = BENCH_GETS / ((nowUs() - t) / 1e6);
+
+    programmed = simflash_stats()->programmed;
+    erases = simflash_stats()->erases[0] + simflash_stats()->erases[1];
+    t = nowUs();
+    for (i = 0; i < BENCH_SETS; i++)
+    {
+        val[0] = (uint8_t)i;
+        otPlatSettingsSet(NULL, 1 + (rand() % items), val, sizeof(val));
+    }
+    setRate = BENCH_SETS / ((nowUs() - t) / 1e6);
+    programmed = simflash_stats()->programmed - programmed;
+    erases = simflash_stats()->erases[0] + simflash_stats()->erases[1] -
+             erases;
+
+    t = nowUs();
+    for (i = 0; i < BENCH_ADDS; i++)
+    {
+        otPlatSettingsAdd(NULL, BENCH_ADDKEY, val, sizeof(val));
+        otPlatSettingsDelete(NULL, BENCH_ADDKEY, 0);
+    }
+    addRate = BENCH_ADDS / ((nowUs() - t) / 1e6);
+
+    t = nowUs();
+    for (i = 0; i < BENCH_COMPACTS; i++)
+    {
+        nvFps.compactNV(0);
+    }
+    compactUs = (nowUs() - t) / BENCH_COMPACTS;
+
+    printf("%5u %10.0f %10.0f %10.0f %10.1f %8.2f %10.2f\n",
+           items, getRate, setRate, addRate, compactUs,
+           (double)programmed / (BENCH_SETS * BENCH_VALLEN),
+           (erases * 1000.0) / BENCH_SETS);
+}
+
+/* Worst Set flash work, compacting in background steps if background set */
+static void benchLatency(int background)
+{
+    uint8_t val[BENCH_VALLEN];
+    uint64_t ops, programmed, opsMax = 0, progMax = 0;
+    uint32_t erases, erasingSets = 0;
+    int i;
+
+    if (background)
+    {
+        // Must be in place before init, as with the settings compact task
+        NVOCTP_setCompactNotify((void *)compactNotify);
+    }
+    populate(BENCH_LATITEMS);
+    srand(BENCH_LATITEMS);
+    memset(val, 0xA5, sizeof(val));
+
+    for (i = 0; i < BENCH_SETS; i++)
+    {
+        val[0] = (uint8_t)i;
+        ops = simflash_stats()->ops;
+        programmed = simflash_stats()->programmed;
+        erases = simflash_stats()->erases[0] + simflash_stats()->erases[1];
+
+        otPlatSettingsSet(NULL, 1 + (rand() % BENCH_LATITEMS), val,
+                          sizeof(val));
+
+        ops = simflash_stats()->ops - ops;
+        programmed = simflash_stats()->programmed - programmed;
+        opsMax  = (ops > opsMax) ? ops : opsMax;
+        progMax = (programmed > progMax) ? programmed : progMax;
+        if (simflash_stats()->erases[0] + simflash_stats()->erases[1] !=
+            erases)
+        {
+            erasingSets += 1;
+        }
+
+        // Low priority task gets the CPU between writes
+        if (compactPending)
+        {
+            compactPending = NVOCTP_compactStep();
+        }
+    }
+
+    printf("%-10s %12llu %12llu %12u %8u\n",
+           background ? "background" : "sync", (unsigned long long)opsMax,
+           (unsigned long long)progMax, erasingSets,
+           simflash_stats()->erases[0] + simflash_stats()->erases[1]);
+}
+
+/* Runs fn(arg) in a child with fresh driver state */
+static void inChild(void (*fn)(int), int arg)
+{
+    pid_t pid;
+
+    // Output buffered so far must not be printed by the child as well
+    fflush(stdout);
+    pid = fork();
+
+    if (pid == 0)
+    {
+        fn(arg);
+        fflush(stdout);
+        _exit(0);
+    }
+    waitpid(pid, NULL, 0);
+}
+
+static void storeChild(int items)
+{
+    benchStore((uint16_t)items);
+}
+
+//*****************************************************************************
+// Main
+//*****************************************************************************
+
+int main(int argc, char **argv)
+{
+    unsigned i;
+
+    simflash_init();
+
+#if defined (NVOCTP_RAMINDEX) && !NVOCTP_RAMINDEX
+    printf("nvbench: RAM index off, %u byte values\n\n", BENCH_VALLEN);
+#else
+    printf("nvbench: RAM index on, %u byte values\n\n", BENCH_VALLEN);
+#endif
+
+    printf("%5s %10s %10s %10s %10s %8s %10s\n", "items", "get/s", "set/s",
+           "add+del/s", "compact us", "wr amp", "erases/1k");
+    for (i = 0; i < sizeof(storeSizes) / sizeof(storeSizes[0]); i++)
+    {
+        inChild(storeChild, storeSizes[i]);
+    }
+
+    printf("\n%u Sets on %u items\n", BENCH_SETS, BENCH_LATITEMS);
+    printf("%-10s %12s %12s %12s %8s\n", "compaction", "max set ops",
+           "max set prog", "erasing sets", "erases");
+    inChild(benchLatency, 0);
+    inChild(benchLatency, 1);
+
+    return (0);
+}
@@ -0,0 +1,282 @@
+/******************************************************************************
+
+ @file  nvfuzz.c
+
+ @brief Power cut fuzzer for the NVOCTP driver
+
+ Each trial formats the flash and boots the driver a few times in fork()ed
+ children. Every boot checks the items against a model of what was written,
+ then runs random writes, deletes and background compaction steps until the
+ power is cut at a random flash write or erase. The last boot of a trial
+ runs to completion.
+
+ An item write or delete that was in progress when power was lost may land
+ or not, but must be atomic. Everything completed before the cut must read
+ back exactly.
+
+ Usage: nvfuzz [trials] [first seed]
+
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "nvintf.h"
+#include "nvoctp.h"
+#include "simflash.h"
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+#define FUZZ_ITEMIDS    8       // Item IDs 1..8
+#define FUZZ_SUBIDS     4       // Sub IDs 0..3
+#define FUZZ_SLOTS      (FUZZ_ITEMIDS * FUZZ_SUBIDS)
+#define FUZZ_MAXLEN     80      // Item lengths 1..80
+#define FUZZ_BOOTS      4       // Boots per trial, last one is not cut
+#define FUZZ_OPS        400     // Operations per boot
+#define FUZZ_MAXCUT     600     // Flash ops before the cut, at most
+
+// Exit status of a boot that found a bad item
+#define FUZZ_FAILEXIT   1
+
+//*****************************************************************************
+// Typedefs
+//*****************************************************************************
+
+// What the flash should hold, kept in shared memory across boots
+typedef struct
+{
+    uint8_t len[FUZZ_SLOTS];                // 0 if the item does not exist
+    uint8_t val[FUZZ_SLOTS][FUZZ_MAXLEN];
+    int     pendSlot;                       // Slot of the op in progress, -1
+    uint8_t pendLen;                        // New length, 0 for a delete
+    uint8_t pendVal[FUZZ_MAXLEN];
+} fuzz_model_t;
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static fuzz_model_t *model;
+
+static NVINTF_nvFuncts_t nvFps;
+
+static int compactPending;
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+static NVINTF_itemID_t slotId(int slot)
+{
+    NVINTF_itemID_t id;
+
+    id.systemID = NVINTF_SYSID_TIOP;
+    id.itemID   = 1 + (slot / FUZZ_SUBIDS);
+    id.subID    = slot % FUZZ_SUBIDS;
+    return (id);
+}
+
+static void compactNotify(void)
+{
+    compactPending = 1;
+}
+
+/* Returns 1 if the item in slot reads back as len/val */
+static int slotIs(int slot, uint8_t len, const uint8_t *val)
+{
+    uint8_t buf[FUZZ_MAXLEN];
+    uint32_t nvLen = nvFps.getItemLen(slotId(slot));
+
+    if (nvLen != len)
+    {
+        return (0);
+    }
+    if (len == 0)
+    {
+        return (1);
+    }
+    return ((nvFps.readItem(slotId(slot), 0, len, buf) == NVINTF_SUCCESS) &&
+            (memcmp(buf, val, len) == 0));
+}
+
+/* Checks every item against the model, settling the op that was cut */
+static int verify(unsigned seed, int boot)
+{
+    int slot;
+
+    for (slot = 0; slot < FUZZ_SLOTS; slot++)
+    {
+        if (slot == model->pendSlot &&
+            slotIs(slot, model->pendLen, model->pendVal))
+        {
+            // Interrupted op made it
+            model->len[slot] = model->pendLen;
+            memcpy(model->val[slot], model->pendVal, model->pendLen);
+        }
+        else if (!slotIs(slot, model->len[slot], model->val[slot]))
+        {
+            printf("seed %u boot %d: item %d/%d expected len %u%s, "
+                   "found len %u\n", seed, boot, slotId(slot).itemID,
+                   slotId(slot).subID, model->len[slot],
+                   (slot == model->pendSlot) ? " (or the cut op)" : "",
+                   (unsigned)nvFps.getItemLen(slotId(slot)));
+            return (0);
+        }
+    }
+    model->pendSlot = -1;
+    return (1);
+}
+
+/* One boot of the device, returns the process exit status */
+static int boot(unsigned seed, int bootNum, int cut)
+{
+    int op;
+
+    srand(seed * FUZZ_BOOTS + bootNum);
+
+    // Odd seeds compact in the background, even ones on the write path
+    if (seed & 1)
+    {
+        NVOCTP_setCompactNotify((void *)compactNotify);
+    }
+    NVOCTP_loadApiPtrsExt(&nvFps);
+    nvFps.initNV(NULL);
+
+    if (!verify(seed, bootNum))
+    {
+        return (FUZZ_FAILEXIT);
+    }
+
+    if (cut)
+    {
+        simflash_armCut(1 + (rand() % FUZZ_MAXCUT), rand());
+    }
+
+    for (op = 0; op < FUZZ_OPS; op++)
+    {
+        int slot = rand() % FUZZ_SLOTS;
+        uint8_t status;
+
+        if (compactPending && (rand() & 1))
+        {
+            compactPending = NVOCTP_compactStep();
+        }
+
+        if (rand() % 4)
+        {
+            uint8_t i;
+
+            model->pendLen = 1 + (rand() % FUZZ_MAXLEN);
+            for (i = 0; i < model->pendLen; i++)
+            {
+                model->pendVal[i] = (uint8_t)rand();
+            }
+            model->pendSlot = slot;
+            status = nvFps.writeItem(slotId(slot), model->pendLen,
+                                     model->pendVal);
+        }
+        else
+        {
+            model->pendLen  = 0;
+            model->pendSlot = slot;
+            status = nvFps.deleteItem(slotId(slot));
+            if (status == NVINTF_NOTFOUND && model->len[slot] == 0)
+            {
+                status = NVINTF_SUCCESS;
+            }
+        }
+
+        if (status != NVINTF_SUCCESS)
+        {
+            printf("seed %u boot %d: op %d on item %d/%d failed with %u\n",
+                   seed, bootNum, op, slotId(slot).itemID,
+                   slotId(slot).subID, status);
+            return (FUZZ_FAILEXIT);
+        }
+
+        model->len[slot] = model->pendLen;
+        memcpy(model->val[slot], model->pendVal, model->pendLen);
+        model->pendSlot = -1;
+    }
+
+    simflash_armCut(0, 0);
+
+    return (verify(seed, bootNum) ? 0 : FUZZ_FAILEXIT);
+}
+
+/* Runs one trial, returns 1 if it passed */
+static int trial(unsigned seed, unsigned *pCuts)
+{
+    int b;
+
+    simflash_format();
+    memset(model, 0, sizeof(*model));
+    model->pendSlot = -1;
+
+    for (b = 0; b < FUZZ_BOOTS; b++)
+    {
+        int status;
+        int cut = (b < FUZZ_BOOTS - 1);
+        pid_t pid = fork();
+
+        if (pid == 0)
+        {
+            status = boot(seed, b, cut);
+            fflush(stdout);
+            _exit(status);
+        }
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status))
+        {
+            printf("seed %u boot %d: crashed\n", seed, b);
+            return (0);
+        }
+
+        // Power is back, the next boot is only cut if it arms a cut itself
+        simflash_armCut(0, 0);
+
+        status = WEXITSTATUS(status);
+        if (status == SIMFLASH_CUTEXIT)
+        {
+            *pCuts += 1;
+        }
+        else if (status != 0)
+        {
+            return (0);
+        }
+    }
+    return (1);
+}
+
+//*****************************************************************************
+// Main
+//*****************************************************************************
+
+int main(int argc, char **argv)
+{
+    unsigned trials = (argc > 1) ? (unsigned)atoi(argv[1]) : 1000;
+    unsigned first  = (argc > 2) ? (unsigned)atoi(argv[2]) : 1;
+    unsigned seed;
+    unsigned cuts = 0;
+    unsigned failed = 0;
+
+    simflash_init();
+    model = (fuzz_model_t *)simflash_shared(sizeof(*model));
+
+    for (seed = first; seed < first + trials; seed++)
+    {
+        if (!trial(seed, &cuts))
+        {
+            failed += 1;
+        }
+    }
+
+    printf("nvfuzz: %u trials, %u power cuts, %u failed\n",
+           trials, cuts, failed);
+
+    return (failed ? 1 : 0);
+}
@@ -0,0 +1,200 @@
+/******************************************************************************
+
+ @file  simflash.c
+
+ @brief Simulated NVS flash for host builds of the NV driver
+
+ Models NOR flash as used by NVOCTP: an erase sets a whole page to 0xFF,
+ programming can only clear bits, and a write is verified after
+ programming. A power cut can be injected at any write or erase. A cut write
+ programs a random number of leading bytes, the next one possibly only
+ partly. A cut erase leaves each byte either erased or untouched.
+
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <ti/drivers/NVS.h>
+
+#include "simflash.h"
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static uint8_t *flash;
+
+static simflash_stats_t *stats;
+
+static NVS_Attrs attrs =
+{
+    (void *)SIMFLASH_BASE,
+    SIMFLASH_PAGES * SIMFLASH_PAGESIZE,
+    SIMFLASH_PAGESIZE
+};
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+/* Returns true if this write or erase is the one that loses power */
+static int powerCut(void)
+{
+    stats->ops += 1;
+    return (stats->cutAt != 0 && stats->ops >= stats->cutAt);
+}
+
+/* Ends the process the way a reset would, nothing else gets to run */
+static void powerOff(void)
+{
+    _exit(SIMFLASH_CUTEXIT);
+}
+
+//*****************************************************************************
+// Simulation API
+//*****************************************************************************
+
+void *simflash_shared(size_t size)
+{
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    if (p == MAP_FAILED)
+    {
+        perror("simflash: mmap");
+        exit(1);
+    }
+    return (p);
+}
+
+void simflash_init(void)
+{
+    void *p = mmap((void *)SIMFLASH_BASE, attrs.regionSize,
+                   PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+
+    if (p == MAP_FAILED)
+    {
+        perror("simflash: mmap flash region");
+        exit(1);
+    }
+    flash = (uint8_t *)p;
+    stats = (simflash_stats_t *)simflash_shared(sizeof(*stats));
+
+    simflash_format();
+}
+
+void simflash_format(void)
+{
+    memset(flash, 0xFF, attrs.regionSize);
+    memset(stats, 0, sizeof(*stats));
+}
+
+simflash_stats_t *simflash_stats(void)
+{
+    return (stats);
+}
+
+void simflash_armCut(uint64_t ops, uint32_t seed)
+{
+    stats->cutAt   = ops ? (stats->ops + ops) : 0;
+    stats->cutSeed = seed;
+}
+
+//*****************************************************************************
+// NVS driver API
+//*****************************************************************************
+
+void NVS_init(void)
+{
+}
+
+NVS_Handle NVS_open(uint_least8_t index, void *params)
+{
+    (void)index;
+    (void)params;
+    return ((NVS_Handle)&attrs);
+}
+
+void NVS_getAttrs(NVS_Handle handle, NVS_Attrs *pAttrs)
+{
+    (void)handle;
+    *pAttrs = attrs;
+}
+
+int_fast16_t NVS_read(NVS_Handle handle, size_t offset, void *buffer,
+                      size_t bufferSize)
+{
+    (void)handle;
+    stats->reads += 1;
+    memcpy(buffer, flash + offset, bufferSize);
+    return (NVS_STATUS_SUCCESS);
+}
+
+int_fast16_t NVS_write(NVS_Handle handle, size_t offset, void *buffer,
+                       size_t bufferSize, uint_fast16_t flags)
+{
+    const uint8_t *src = (const uint8_t *)buffer;
+    size_t i;
+
+    (void)handle;
+    stats->writes += 1;
+
+    if (powerCut())
+    {
+        srand(stats->cutSeed);
+        size_t done = (size_t)rand() % (bufferSize + 1);
+
+        for (i = 0; i < done; i++)
+        {
+            flash[offset + i] &= src[i];
+        }
+        if (done < bufferSize)
+        {
+            // Some bits of the byte being programmed made it
+            flash[offset + done] &= (src[done] | (uint8_t)rand());
+        }
+        powerOff();
+    }
+
+    for (i = 0; i < bufferSize; i++)
+    {
+        flash[offset + i] &= src[i];
+    }
+    stats->programmed += bufferSize;
+
+    if ((flags & NVS_WRITE_POST_VERIFY) &&
+        memcmp(flash + offset, src, bufferSize))
+    {
+        return (NVS_STATUS_ERROR);
+    }
+    return (NVS_STATUS_SUCCESS);
+}
+
+int_fast16_t NVS_erase(NVS_Handle handle, size_t offset, size_t size)
+{
+    (void)handle;
+
+    if (powerCut())
+    {
+        size_t i;
+
+        srand(stats->cutSeed);
+        for (i = 0; i < size; i++)
+        {
+            if (rand() & 1)
+            {
+                flash[offset + i] = 0xFF;
+            }
+        }
+        powerOff();
+    }
+
+    memset(flash + offset, 0xFF, size);
+    stats->erases[offset / SIMFLASH_PAGESIZE] += 1;
+    return (NVS_STATUS_SUCCESS);
+}
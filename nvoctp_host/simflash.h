@@ -0,0 +1,101 @@
+/******************************************************************************
+
+ @file  simflash.h
+
+ @brief Simulated NVS flash for host builds of the NV driver
+
+ The two NV pages are mapped at the address the NV driver derives its page
+ numbers from, so reads through the memory mapping work as on the device.
+ The mapping is shared, so flash contents survive a fork()ed child that is
+ power cut, which is how the fuzz harness models a reset.
+
+ *****************************************************************************/
+#ifndef SIMFLASH_H
+#define SIMFLASH_H
+
+#include <stdint.h>
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+// Flash region as seen by the NV driver
+#define SIMFLASH_BASE       0x52000
+#define SIMFLASH_PAGESIZE   0x2000
+#define SIMFLASH_PAGES      2
+
+// Exit status of a process whose power was cut
+#define SIMFLASH_CUTEXIT    42
+
+//*****************************************************************************
+// Typedefs
+//*****************************************************************************
+
+// Flash activity counters, kept in shared memory
+typedef struct
+{
+    uint32_t erases[SIMFLASH_PAGES];    // Erases per page
+    uint64_t writes;                    // NVS_write() calls
+    uint64_t reads;                     // NVS_read() calls
+    uint64_t programmed;                // Bytes programmed
+    uint64_t ops;                       // Writes and erases so far
+    uint64_t cutAt;                     // Op that loses power, 0 for never
+    uint32_t cutSeed;                   // Seed for the partial operation
+} simflash_stats_t;
+
+//*****************************************************************************
+// Functions
+//*****************************************************************************
+
+/**
+ * @fn      simflash_init
+ *
+ * @brief   Map the simulated flash and erase it. Call once at startup.
+ *
+ * @return  none
+ */
+extern void simflash_init(void);
+
+/**
+ * @fn      simflash_format
+ *
+ * @brief   Erase both pages and clear the counters
+ *
+ * @return  none
+ */
+extern void simflash_format(void);
+
+/**
+ * @fn      simflash_stats
+ *
+ * @brief   Get the flash activity counters
+ *
+ * @return  pointer to the shared counters
+ */
+extern simflash_stats_t *simflash_stats(void);
+
+/**
+ * @fn      simflash_armCut
+ *
+ * @brief   Lose power part way through a future write or erase. The op is
+ *          left partially done and the process exits with SIMFLASH_CUTEXIT.
+ *
+ * @param   ops  - number of writes/erases from now, 0 to disarm
+ * @param   seed - seed for how much of the op completes
+ *
+ * @return  none
+ */
+extern void simflash_armCut(uint64_t ops, uint32_t seed);
+
+/**
+ * @fn      simflash_shared
+ *
+ * @brief   Allocate memory that is shared with fork()ed children
+ *
+ * @param   size - number of bytes
+ *
+ * @return  pointer to zeroed memory
+ */
+extern void *simflash_shared(size_t size);
+
+#endif /* SIMFLASH_H */
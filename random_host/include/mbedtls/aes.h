@@ -0,0 +1,29 @@
+/*
+ * Host stand-in for the mbedtls AES module of the examples, the hardware
+ * AES of crypto/aes_alt.c. simtrng.c runs it on OpenSSL, opening the
+ * accelerator driver with the first context as aes_alt.c does.
+ */
+#ifndef MBEDTLS_AES_H
+#define MBEDTLS_AES_H
+
+#define MBEDTLS_AES_ENCRYPT     1
+#define MBEDTLS_AES_DECRYPT     0
+
+typedef struct
+{
+    unsigned char keyMaterial[32];
+    void *cipher;
+} mbedtls_aes_context;
+
+void mbedtls_aes_init(mbedtls_aes_context *ctx);
+
+void mbedtls_aes_free(mbedtls_aes_context *ctx);
+
+int mbedtls_aes_setkey_enc(mbedtls_aes_context *ctx, const unsigned char *key,
+                           unsigned int keybits);
+
+int mbedtls_aes_crypt_ecb(mbedtls_aes_context *ctx, int mode,
+                          const unsigned char input[16],
+                          unsigned char output[16]);
+
+#endif /* MBEDTLS_AES_H */
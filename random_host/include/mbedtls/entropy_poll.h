@@ -0,0 +1,4 @@
+/*
+ * Host stand-in for the mbedtls entropy header the polled module includes,
+ * it uses nothing from it.
+ */
@@ -0,0 +1,4 @@
+/*
+ * Host stand-in for the driverlib power and clock header the polled module
+ * includes, it uses nothing from it.
+ */
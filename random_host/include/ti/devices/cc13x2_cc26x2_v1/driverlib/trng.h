@@ -0,0 +1,33 @@
+/*
+ * Host stand-in for the driverlib TRNG, the registers the polled module
+ * reads. The register block is memory in simtrng.c, and TRNGStatusGet()
+ * makes a number ready once the sampling time has passed since the last
+ * one was read.
+ */
+#ifndef TRNG_DRIVERLIB_H
+#define TRNG_DRIVERLIB_H
+
+#include <stdint.h>
+
+#define HWREG(x)                (*((volatile uint32_t *)(x)))
+
+extern uint32_t simTrngRegs[8];
+
+#define TRNG_BASE               ((uintptr_t)simTrngRegs)
+#define TRNG_O_OUT0             0x00
+#define TRNG_O_OUT1             0x04
+#define TRNG_O_IRQFLAGCLR       0x10
+#define TRNG_O_CTL              0x14
+
+#define TRNG_CTL_TRNG_EN        0x00000400
+#define TRNG_NUMBER_READY       0x00000001
+
+void TRNGConfigure(uint32_t ui32MinSamplesPerCycle,
+                   uint32_t ui32MaxSamplesPerCycle,
+                   uint32_t ui32ClocksPerSample);
+
+void TRNGEnable(void);
+
+uint32_t TRNGStatusGet(void);
+
+#endif /* TRNG_DRIVERLIB_H */
@@ -0,0 +1,21 @@
+/*
+ * Host stand-in for the TI power driver, dependencies are not tracked.
+ */
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+static inline int_fast16_t Power_setDependency(unsigned int resourceId)
+{
+    (void)resourceId;
+    return (0);
+}
+
+static inline int_fast16_t Power_releaseDependency(unsigned int resourceId)
+{
+    (void)resourceId;
+    return (0);
+}
+
+#endif /* POWER_H */
@@ -0,0 +1,46 @@
+/*
+ * Host stand-in for the TI TRNG driver, callback mode only. simtrng.c
+ * gathers the entropy on a thread that plays the driver's Swi.
+ */
+#ifndef TRNG_H
+#define TRNG_H
+
+#include <stdint.h>
+
+#include <ti/drivers/cryptoutils/cryptokey/CryptoKey.h>
+
+#define TRNG_STATUS_SUCCESS                  0
+#define TRNG_STATUS_ERROR                   -1
+#define TRNG_STATUS_RESOURCE_UNAVAILABLE    -2
+
+typedef struct TRNG_Config *TRNG_Handle;
+
+typedef enum
+{
+    TRNG_RETURN_BEHAVIOR_CALLBACK = 1,
+    TRNG_RETURN_BEHAVIOR_BLOCKING = 2,
+    TRNG_RETURN_BEHAVIOR_POLLING  = 4,
+} TRNG_ReturnBehavior;
+
+typedef void (*TRNG_CallbackFxn)(TRNG_Handle handle, int_fast16_t returnValue,
+                                 CryptoKey *entropy);
+
+typedef struct
+{
+    TRNG_ReturnBehavior returnBehavior;
+    TRNG_CallbackFxn    callbackFxn;
+    uint32_t            timeout;
+    void                *custom;
+} TRNG_Params;
+
+void TRNG_init(void);
+
+void TRNG_Params_init(TRNG_Params *params);
+
+TRNG_Handle TRNG_open(uint_least8_t index, TRNG_Params *params);
+
+void TRNG_close(TRNG_Handle handle);
+
+int_fast16_t TRNG_generateEntropy(TRNG_Handle handle, CryptoKey *entropy);
+
+#endif /* TRNG_H */
@@ -0,0 +1,25 @@
+/*
+ * Host stand-in for the TI driver porting layer semaphore, binary only.
+ */
+#ifndef SEMAPHOREP_H
+#define SEMAPHOREP_H
+
+#include <stdint.h>
+
+#define SemaphoreP_WAIT_FOREVER     (~(0U))
+
+typedef enum
+{
+    SemaphoreP_OK      = 0,
+    SemaphoreP_TIMEOUT = -1,
+} SemaphoreP_Status;
+
+typedef void *SemaphoreP_Handle;
+
+SemaphoreP_Handle SemaphoreP_createBinary(unsigned int count);
+
+SemaphoreP_Status SemaphoreP_pend(SemaphoreP_Handle handle, uint32_t timeout);
+
+void SemaphoreP_post(SemaphoreP_Handle handle);
+
+#endif /* SEMAPHOREP_H */
@@ -0,0 +1,9 @@
+/*
+ * Host stand-in for the CC26XX power resource names.
+ */
+#ifndef POWERCC26XX_H
+#define POWERCC26XX_H
+
+#define PowerCC26XX_PERIPH_TRNG     5
+
+#endif /* POWERCC26XX_H */
@@ -0,0 +1,55 @@
+/*
+ * Host stand-in for the TI driver ring buffer.
+ */
+#ifndef RINGBUF_H
+#define RINGBUF_H
+
+#include <stddef.h>
+
+typedef struct
+{
+    unsigned char *buffer;
+    size_t        length;
+    size_t        count;
+    size_t        head;
+    size_t        tail;
+} RingBuf_Object, *RingBuf_Handle;
+
+static inline void RingBuf_construct(RingBuf_Handle object,
+                                     unsigned char *bufPtr, size_t bufSize)
+{
+    object->buffer = bufPtr;
+    object->length = bufSize;
+    object->count  = 0;
+    object->head   = bufSize - 1;
+    object->tail   = 0;
+}
+
+static inline int RingBuf_getCount(RingBuf_Handle object)
+{
+    return ((int)object->count);
+}
+
+static inline int RingBuf_get(RingBuf_Handle object, unsigned char *data)
+{
+    if (object->count == 0)
+    {
+        return (-1);
+    }
+    *data = object->buffer[object->tail];
+    object->tail = (object->tail + 1) % object->length;
+    return ((int)--object->count);
+}
+
+static inline int RingBuf_put(RingBuf_Handle object, unsigned char data)
+{
+    if (object->count == object->length)
+    {
+        return (-1);
+    }
+    object->head = (object->head + 1) % object->length;
+    object->buffer[object->head] = data;
+    return ((int)++object->count);
+}
+
+#endif /* RINGBUF_H */
@@ -0,0 +1,535 @@
+/******************************************************************************
+
+ @file  randomsim.c
+
+ @brief Host check and benchmark of the platform random module
+
+ Runs platform/random.c of the examples on Linux with the TRNG and AES of
+ simtrng.c. The stack task is the main thread, it runs
+ platformRandomProcess() when the module signals it, as otstack.c does.
+
+   randomsim [-e us] [-n requests] [-c]
+
+   -e  sampling time of 64 bits of entropy in us, default 5.3
+   -n  requests of each size in the benchmark, default 2000
+   -c  check the DRBG output against a reference CTR_DRBG, AES-128
+       without a derivation function, seeded and reseeded from the same
+       TRNG stream, and that true random requests get the TRNG stream
+       itself. TRNG requests fail now and then on the way. The reference
+       is first checked against the CTR-DRBG of OpenSSL.
+
+ Without -c, times requests of each size and prints the latency of the
+ call and the time the stack task spends per request, calls and refills.
+ Built with -DSIM_POLLED this runs the module the examples used before,
+ kept in polled/.
+
+ *****************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <openthread/platform/random.h>
+
+#include "platform.h"
+#include "simtrng.h"
+
+#ifndef SIM_POLLED
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#endif
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+// Gap between requests of the benchmark
+#define BENCH_GAP_US        200
+
+// Operations of the check
+#define CHECK_OPS           20000
+
+// Size of a request for otPlatRandomGet()
+#define SIZE_GET            0
+
+#define SEED_LEN            32
+
+// Default of random.c, the check build sets it lower
+#ifndef PLATFORM_RANDOM_RESEED_INTERVAL
+#define PLATFORM_RANDOM_RESEED_INTERVAL 1024
+#endif
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static volatile int signalled;
+
+// Time the stack task spent in platformRandomProcess()
+static uint64_t processNs;
+
+static const int benchSizes[] = { SIZE_GET, 8, 16, 32, 64, 128 };
+
+//*****************************************************************************
+// Stack task
+//*****************************************************************************
+
+void platformRandomSignal(void)
+{
+    __atomic_store_n(&signalled, 1, __ATOMIC_SEQ_CST);
+}
+
+/* Runs the random processing if it was signalled, as the stack task */
+static bool stackTask(void)
+{
+    uint64_t start;
+
+    if (!__atomic_exchange_n(&signalled, 0, __ATOMIC_SEQ_CST))
+    {
+        return (false);
+    }
+
+    start = simNowNs();
+    platformRandomProcess();
+    processNs += simNowNs() - start;
+    return (true);
+}
+
+//*****************************************************************************
+// Benchmark
+//*****************************************************************************
+
+static int compareU64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return ((x > y) - (x < y));
+}
+
+static void request(int aSize)
+{
+    uint8_t  buf[256];
+    uint16_t len;
+
+    if (aSize == SIZE_GET)
+    {
+        (void)otPlatRandomGet();
+    }
+    else if (otPlatRandomSecureGet(aSize, buf, &len) != OT_ERROR_NONE ||
+             len != aSize)
+    {
+        fprintf(stderr, "request of %d failed\n", aSize);
+        exit(1);
+    }
+}
+
+static int runBench(int aRequests)
+{
+    uint64_t *lat = calloc(aRequests, sizeof(*lat));
+    uint64_t start;
+    uint64_t total;
+    uint64_t blocks;
+    size_t   s;
+    int      i;
+
+    start = simNowNs();
+    platformRandomInit();
+    printf("init %.0f us, TRNG %.1f us per 64 bits\n",
+           (simNowNs() - start) / 1e3, simTrngUsPer64);
+    printf("%-6s %9s %9s %9s %9s %11s\n", "size", "mean us", "p99 us",
+           "max us", "task us", "aes blocks");
+
+    for (s = 0; s < sizeof(benchSizes) / sizeof(benchSizes[0]); s++)
+    {
+        total     = 0;
+        processNs = 0;
+        blocks    = simAesBlocks;
+
+        for (i = 0; i < aRequests; i++)
+        {
+            usleep(BENCH_GAP_US);
+            stackTask();
+
+            start = simNowNs();
+            request(benchSizes[s]);
+            lat[i] = simNowNs() - start;
+            total += lat[i];
+
+            stackTask();
+        }
+
+        qsort(lat, aRequests, sizeof(*lat), compareU64);
+        if (benchSizes[s] == SIZE_GET)
+        {
+            printf("%-6s", "get");
+        }
+        else
+        {
+            printf("%-6d", benchSizes[s]);
+        }
+        printf(" %9.2f %9.2f %9.2f %9.2f %11.2f\n",
+               total / 1e3 / aRequests, lat[aRequests * 99 / 100] / 1e3,
+               lat[aRequests - 1] / 1e3,
+               (total + processNs) / 1e3 / aRequests,
+               (double)(simAesBlocks - blocks) / aRequests);
+    }
+
+    free(lat);
+    return (0);
+}
+
+//*****************************************************************************
+// Check
+//*****************************************************************************
+
+#ifndef SIM_POLLED
+
+// Reference DRBG state, and the TRNG stream bytes it has taken
+static uint8_t refKey[16];
+static uint8_t refV[16];
+static uint64_t refStream;
+static uint64_t refRequests;
+
+// Block of reference output left for otPlatRandomGet()
+static uint8_t refBlock[16];
+static size_t refBlockLen;
+
+static void refEntropy(uint8_t *aOutput, size_t aLen)
+{
+    size_t i;
+
+    for (i = 0; i < aLen; i++)
+    {
+        aOutput[i] = simTrngStreamByte(refStream++);
+    }
+}
+
+/* Adds to the 128 bit counter, big endian */
+static void refAdd(uint8_t *aV, uint64_t aCount)
+{
+    int i;
+
+    for (i = 15; i >= 0 && aCount != 0; i--)
+    {
+        aCount += aV[i];
+        aV[i]    = (uint8_t)aCount;
+        aCount >>= 8;
+    }
+}
+
+/* AES-128-CTR key stream from the counter after V, the DRBG blocks */
+static void refStreamOut(uint8_t *aOutput, size_t aLen)
+{
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    uint8_t        iv[16];
+    int            len;
+
+    memcpy(iv, refV, sizeof(iv));
+    refAdd(iv, 1);
+    memset(aOutput, 0, aLen);
+    EVP_EncryptInit_ex(ctx, EVP_aes_128_ctr(), NULL, refKey, iv);
+    EVP_EncryptUpdate(ctx, aOutput, &len, aOutput, aLen);
+    EVP_CIPHER_CTX_free(ctx);
+    refAdd(refV, (aLen + 15) / 16);
+}
+
+/* CTR_DRBG_Update of SP 800-90A */
+static void refUpdate(const uint8_t *aProvided)
+{
+    uint8_t temp[SEED_LEN];
+    int     i;
+
+    refStreamOut(temp, sizeof(temp));
+    for (i = 0; aProvided != NULL && i < SEED_LEN; i++)
+    {
+        temp[i] ^= aProvided[i];
+    }
+    memcpy(refKey, temp, 16);
+    memcpy(refV, &temp[16], 16);
+}
+
+static void refSeed(void)
+{
+    uint8_t seed[SEED_LEN];
+
+    refEntropy(seed, sizeof(seed));
+    refUpdate(seed);
+    refBlockLen = 0;
+}
+
+static void refGenerate(uint8_t *aOutput, size_t aLen)
+{
+    refStreamOut(aOutput, aLen);
+    refUpdate(NULL);
+    refRequests++;
+}
+
+/*
+ * Checks the reference against the CTR-DRBG of OpenSSL, seeded with the
+ * first seed of the stream. OpenSSL takes no entropy from its caller on a
+ * reseed the way SP 800-90A does, so only the first seed and the requests
+ * after it are compared.
+ */
+static bool refCheckOpenSsl(void)
+{
+    static const size_t sizes[] = { 1, 16, 37, 64, 256 };
+    EVP_RAND_CTX        *parent;
+    EVP_RAND_CTX        *drbg;
+    uint8_t             seed[SEED_LEN];
+    uint8_t             out[256];
+    uint8_t             ref[256];
+    unsigned int        strength = 256;
+    unsigned int        zero = 0;
+    int                 useDf = 0;
+    bool                ok;
+    size_t              i;
+    OSSL_PARAM          parentParams[] = {
+        OSSL_PARAM_construct_uint(OSSL_RAND_PARAM_STRENGTH, &strength),
+        OSSL_PARAM_construct_end()
+    };
+    OSSL_PARAM          entropyParams[] = {
+        OSSL_PARAM_construct_octet_string(OSSL_RAND_PARAM_TEST_ENTROPY, seed,
+                                          sizeof(seed)),
+        OSSL_PARAM_construct_end()
+    };
+    OSSL_PARAM          drbgParams[] = {
+        OSSL_PARAM_construct_utf8_string(OSSL_DRBG_PARAM_CIPHER,
+                                         "AES-128-CTR", 0),
+        OSSL_PARAM_construct_int(OSSL_DRBG_PARAM_USE_DF, &useDf),
+        OSSL_PARAM_construct_uint(OSSL_DRBG_PARAM_RESEED_REQUESTS, &zero),
+        OSSL_PARAM_construct_end()
+    };
+
+    for (i = 0; i < sizeof(seed); i++)
+    {
+        seed[i] = simTrngStreamByte(i);
+    }
+
+    parent = EVP_RAND_CTX_new(EVP_RAND_fetch(NULL, "TEST-RAND", NULL), NULL);
+    if (parent == NULL || !EVP_RAND_CTX_set_params(parent, parentParams) ||
+        !EVP_RAND_instantiate(parent, strength, 0, NULL, 0, entropyParams))
+    {
+        return (false);
+    }
+
+    // An empty personalization string, OpenSSL uses its own for NULL
+    drbg = EVP_RAND_CTX_new(EVP_RAND_fetch(NULL, "CTR-DRBG", NULL), parent);
+    if (drbg == NULL || !EVP_RAND_CTX_set_params(drbg, drbgParams) ||
+        !EVP_RAND_instantiate(drbg, 128, 0, (const unsigned char *)"", 0,
+                              NULL))
+    {
+        return (false);
+    }
+
+    refSeed();
+    ok = true;
+    for (i = 0; ok && i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        ok = EVP_RAND_generate(drbg, out, sizes[i], 128, 0, NULL, 0);
+        refGenerate(ref, sizes[i]);
+        ok = ok && memcmp(out, ref, sizes[i]) == 0;
+    }
+
+    EVP_RAND_CTX_free(drbg);
+    EVP_RAND_CTX_free(parent);
+
+    // Back to before the first seed
+    memset(refKey, 0, sizeof(refKey));
+    memset(refV, 0, sizeof(refV));
+    refStream   = 0;
+    refRequests = 0;
+    return (ok);
+}
+
+static uint32_t refGet(void)
+{
+    uint32_t value;
+
+    if (refBlockLen < sizeof(value))
+    {
+        refGenerate(refBlock, sizeof(refBlock));
+        refBlockLen = sizeof(refBlock);
+    }
+    refBlockLen -= sizeof(value);
+    memcpy(&value, &refBlock[refBlockLen], sizeof(value));
+    return (value);
+}
+
+static int fail(int aOp, const char *aWhat)
+{
+    fprintf(stderr, "FAIL at operation %d: %s\n", aOp, aWhat);
+    return (1);
+}
+
+static int runCheck(void)
+{
+    PlatformRandom_Stats stats;
+    uint8_t              out[512];
+    uint8_t              ref[512];
+    uint16_t             len;
+    uint32_t             reseeds = 0;
+    uint32_t             gets = 0;
+    uint32_t             trues = 0;
+    int                  op;
+    int                  kind;
+    int                  size;
+
+    srand(1);
+
+    if (!refCheckOpenSsl())
+    {
+        fprintf(stderr, "reference does not match OpenSSL\n");
+        return (1);
+    }
+
+    platformRandomInit();
+    refSeed();
+
+    for (op = 0; op < CHECK_OPS; op++)
+    {
+        kind = rand() % 100;
+
+        if (kind < 40)
+        {
+            uint32_t value = otPlatRandomGet();
+
+            if (value != refGet())
+            {
+                return (fail(op, "otPlatRandomGet"));
+            }
+            gets++;
+        }
+        else if (kind < 98)
+        {
+            size = 1 + rand() % ((kind < 90) ? 64 : sizeof(out));
+            if (otPlatRandomSecureGet(size, out, &len) != OT_ERROR_NONE ||
+                len != size)
+            {
+                return (fail(op, "otPlatRandomSecureGet"));
+            }
+            refGenerate(ref, size);
+            if (memcmp(out, ref, size) != 0)
+            {
+                return (fail(op, "otPlatRandomSecureGet output"));
+            }
+        }
+        else
+        {
+            size = 1 + rand() % 48;
+            if (otPlatRandomGetTrue(out, size) != OT_ERROR_NONE)
+            {
+                return (fail(op, "otPlatRandomGetTrue"));
+            }
+            refEntropy(ref, size);
+            if (memcmp(out, ref, size) != 0)
+            {
+                return (fail(op, "otPlatRandomGetTrue output"));
+            }
+            trues++;
+        }
+
+        if ((op % 1000) == 999)
+        {
+            simTrngFailNext = 1;
+        }
+        if ((op % 64) == 0)
+        {
+            usleep(500);
+        }
+
+        // A reseed takes the next seed of the stream
+        if (stackTask())
+        {
+            platformRandomGetStats(&stats);
+            if (stats.reseeds != reseeds)
+            {
+                if (stats.reseeds != reseeds + 1)
+                {
+                    return (fail(op, "more than one reseed"));
+                }
+                reseeds = stats.reseeds;
+                refSeed();
+            }
+        }
+    }
+
+    platformRandomGetStats(&stats);
+    printf("%d operations, %u gets, %u true, %lu requests, %u reseeds, "
+           "%u waits, %u trng errors\n", CHECK_OPS, gets, trues,
+           (unsigned long)stats.requests, stats.reseeds, stats.waits,
+           stats.trngErrors);
+
+    if (stats.requests != refRequests)
+    {
+        return (fail(op, "request count"));
+    }
+    if (stats.reseeds < stats.requests / 4 / PLATFORM_RANDOM_RESEED_INTERVAL)
+    {
+        return (fail(op, "too few reseeds"));
+    }
+    if (stats.trngErrors == 0)
+    {
+        return (fail(op, "no trng errors"));
+    }
+    if (stats.entropyBytes != simTrngBytes ||
+        stats.entropyBytes != refStream + stats.poolCount)
+    {
+        return (fail(op, "entropy count"));
+    }
+
+    printf("PASS\n");
+    return (0);
+}
+
+#endif
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: randomsim [-e us] [-n requests] [-c]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int requests = 2000;
+    int check = 0;
+    int c;
+
+    while ((c = getopt(argc, argv, "e:n:c")) != -1)
+    {
+        switch (c)
+        {
+        case 'e':
+            simTrngUsPer64 = atof(optarg);
+            break;
+        case 'n':
+            requests = atoi(optarg);
+            break;
+        case 'c':
+            check = 1;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (optind != argc || requests < 1)
+    {
+        usage();
+    }
+
+    if (check)
+    {
+#ifndef SIM_POLLED
+        return (runCheck());
+#else
+        usage();
+#endif
+    }
+    return (runBench(requests));
+}
@@ -0,0 +1,340 @@
+/******************************************************************************
+
+ @file  simtrng.c
+
+ @brief Simulated TRNG and AES for host builds of the platform random module
+
+ See simtrng.h.
+
+ *****************************************************************************/
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <openssl/evp.h>
+
+#include <ti/devices/DeviceFamily.h>
+#include DeviceFamily_constructPath(driverlib/trng.h)
+#include <ti/drivers/TRNG.h>
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/drivers/dpl/SemaphoreP.h>
+
+#include "mbedtls/aes.h"
+#include "simtrng.h"
+
+//*****************************************************************************
+// Global variables
+//*****************************************************************************
+
+double simTrngUsPer64 = 5.3;
+volatile uint32_t simTrngFailNext;
+volatile uint64_t simTrngBytes;
+
+uint64_t simAesBlocks;
+uint64_t simAesOpens;
+
+pthread_mutex_t HwiP_lock = PTHREAD_MUTEX_INITIALIZER;
+
+uint32_t simTrngRegs[8];
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+// Driver object, requests are handed to the driver thread
+static struct TRNG_Config
+{
+    pthread_t        thread;
+    pthread_mutex_t  lock;
+    pthread_cond_t   cond;
+    TRNG_CallbackFxn callbackFxn;
+    CryptoKey        *entropy;
+    bool             busy;
+} trngObject = { .lock = PTHREAD_MUTEX_INITIALIZER,
+                 .cond = PTHREAD_COND_INITIALIZER };
+
+// Register model, a number is ready at readyAt ns
+static bool     regReady;
+static uint64_t regReadyAt;
+
+// Contexts open on the AES driver
+static unsigned int aesRefs;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    unsigned int    count;
+} simSemaphore;
+
+//*****************************************************************************
+// TRNG stream and time
+//*****************************************************************************
+
+uint8_t simTrngStreamByte(uint64_t aOffset)
+{
+    uint64_t z = (aOffset / 8) + 0x9e3779b97f4a7c15ULL;
+
+    // splitmix64 of the 64 bit word the byte is in
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z = z ^ (z >> 31);
+    return ((uint8_t)(z >> (8 * (aOffset % 8))));
+}
+
+uint64_t simNowNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec);
+}
+
+static uint64_t sampleNs(void)
+{
+    return ((uint64_t)(simTrngUsPer64 * 1000.0));
+}
+
+//*****************************************************************************
+// TRNG driver
+//*****************************************************************************
+
+/* Plays the Swi of the driver, calls back once the entropy is gathered */
+static void *trngThread(void *arg)
+{
+    struct TRNG_Config *object = arg;
+    struct timespec    wait;
+    CryptoKey          *entropy;
+    uint64_t           ns;
+    int_fast16_t       status;
+    size_t             i;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&object->lock);
+        while (object->entropy == NULL)
+        {
+            pthread_cond_wait(&object->cond, &object->lock);
+        }
+        entropy = object->entropy;
+        pthread_mutex_unlock(&object->lock);
+
+        ns = sampleNs() * ((entropy->u.plaintext.keyLength + 7) / 8);
+        wait.tv_sec  = ns / 1000000000ULL;
+        wait.tv_nsec = ns % 1000000000ULL;
+        nanosleep(&wait, NULL);
+
+        if (simTrngFailNext > 0)
+        {
+            simTrngFailNext--;
+            status = TRNG_STATUS_ERROR;
+        }
+        else
+        {
+            for (i = 0; i < entropy->u.plaintext.keyLength; i++)
+            {
+                entropy->u.plaintext.keyMaterial[i] =
+                    simTrngStreamByte(simTrngBytes + i);
+            }
+            simTrngBytes += entropy->u.plaintext.keyLength;
+            status = TRNG_STATUS_SUCCESS;
+        }
+
+        pthread_mutex_lock(&object->lock);
+        object->entropy = NULL;
+        object->busy    = false;
+        pthread_mutex_unlock(&object->lock);
+
+        object->callbackFxn(object, status, entropy);
+    }
+    return (NULL);
+}
+
+void TRNG_init(void)
+{
+}
+
+void TRNG_Params_init(TRNG_Params *params)
+{
+    memset(params, 0, sizeof(*params));
+    params->returnBehavior = TRNG_RETURN_BEHAVIOR_BLOCKING;
+}
+
+TRNG_Handle TRNG_open(uint_least8_t index, TRNG_Params *params)
+{
+    if (index != 0 || params->returnBehavior != TRNG_RETURN_BEHAVIOR_CALLBACK)
+    {
+        return (NULL);
+    }
+
+    trngObject.callbackFxn = params->callbackFxn;
+    pthread_create(&trngObject.thread, NULL, trngThread, &trngObject);
+    return (&trngObject);
+}
+
+void TRNG_close(TRNG_Handle handle)
+{
+    (void)handle;
+}
+
+int_fast16_t TRNG_generateEntropy(TRNG_Handle handle, CryptoKey *entropy)
+{
+    int_fast16_t status = TRNG_STATUS_RESOURCE_UNAVAILABLE;
+
+    pthread_mutex_lock(&handle->lock);
+    if (!handle->busy)
+    {
+        handle->busy    = true;
+        handle->entropy = entropy;
+        pthread_cond_signal(&handle->cond);
+        status = TRNG_STATUS_SUCCESS;
+    }
+    pthread_mutex_unlock(&handle->lock);
+
+    return (status);
+}
+
+//*****************************************************************************
+// TRNG registers
+//*****************************************************************************
+
+void TRNGConfigure(uint32_t ui32MinSamplesPerCycle,
+                   uint32_t ui32MaxSamplesPerCycle,
+                   uint32_t ui32ClocksPerSample)
+{
+    (void)ui32MinSamplesPerCycle;
+    (void)ui32MaxSamplesPerCycle;
+    (void)ui32ClocksPerSample;
+}
+
+void TRNGEnable(void)
+{
+    simTrngRegs[TRNG_O_CTL / 4] |= TRNG_CTL_TRNG_EN;
+    regReady   = false;
+    regReadyAt = simNowNs() + sampleNs();
+}
+
+uint32_t TRNGStatusGet(void)
+{
+    uint64_t now = simNowNs();
+    int      i;
+
+    // Clearing the flag starts the next number
+    if (simTrngRegs[TRNG_O_IRQFLAGCLR / 4] != 0)
+    {
+        simTrngRegs[TRNG_O_IRQFLAGCLR / 4] = 0;
+        regReady   = false;
+        regReadyAt = now + sampleNs();
+    }
+
+    if (!regReady && now >= regReadyAt)
+    {
+        uint8_t out[8];
+
+        for (i = 0; i < 8; i++)
+        {
+            out[i] = simTrngStreamByte(simTrngBytes + i);
+        }
+        memcpy(&simTrngRegs[TRNG_O_OUT0 / 4], &out[0], 4);
+        memcpy(&simTrngRegs[TRNG_O_OUT1 / 4], &out[4], 4);
+        simTrngBytes += 8;
+        regReady = true;
+    }
+
+    return (regReady ? TRNG_NUMBER_READY : 0);
+}
+
+//*****************************************************************************
+// Driver porting layer
+//*****************************************************************************
+
+SemaphoreP_Handle SemaphoreP_createBinary(unsigned int count)
+{
+    simSemaphore *sem = calloc(1, sizeof(*sem));
+
+    pthread_mutex_init(&sem->lock, NULL);
+    pthread_cond_init(&sem->cond, NULL);
+    sem->count = (count != 0);
+    return (sem);
+}
+
+SemaphoreP_Status SemaphoreP_pend(SemaphoreP_Handle handle, uint32_t timeout)
+{
+    simSemaphore *sem = handle;
+
+    (void)timeout;
+
+    pthread_mutex_lock(&sem->lock);
+    while (sem->count == 0)
+    {
+        pthread_cond_wait(&sem->cond, &sem->lock);
+    }
+    sem->count = 0;
+    pthread_mutex_unlock(&sem->lock);
+    return (SemaphoreP_OK);
+}
+
+void SemaphoreP_post(SemaphoreP_Handle handle)
+{
+    simSemaphore *sem = handle;
+
+    pthread_mutex_lock(&sem->lock);
+    sem->count = 1;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->lock);
+}
+
+//*****************************************************************************
+// AES
+//*****************************************************************************
+
+void mbedtls_aes_init(mbedtls_aes_context *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    if (aesRefs++ == 0)
+    {
+        simAesOpens++;
+    }
+}
+
+void mbedtls_aes_free(mbedtls_aes_context *ctx)
+{
+    aesRefs--;
+    EVP_CIPHER_CTX_free(ctx->cipher);
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+int mbedtls_aes_setkey_enc(mbedtls_aes_context *ctx, const unsigned char *key,
+                           unsigned int keybits)
+{
+    if (keybits != 128)
+    {
+        return (-1);
+    }
+    if (ctx->cipher == NULL)
+    {
+        ctx->cipher = EVP_CIPHER_CTX_new();
+    }
+    memcpy(ctx->keyMaterial, key, keybits / 8);
+    EVP_EncryptInit_ex(ctx->cipher, EVP_aes_128_ecb(), NULL, ctx->keyMaterial,
+                       NULL);
+    EVP_CIPHER_CTX_set_padding(ctx->cipher, 0);
+    return (0);
+}
+
+int mbedtls_aes_crypt_ecb(mbedtls_aes_context *ctx, int mode,
+                          const unsigned char input[16],
+                          unsigned char output[16])
+{
+    int len;
+
+    if (mode != MBEDTLS_AES_ENCRYPT)
+    {
+        return (-1);
+    }
+    simAesBlocks++;
+    return (EVP_EncryptUpdate(ctx->cipher, output, &len, input, 16) ? 0 : -1);
+}
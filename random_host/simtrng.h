@@ -0,0 +1,55 @@
+/******************************************************************************
+
+ @file  simtrng.h
+
+ @brief Simulated TRNG and AES for host builds of the platform random module
+
+ The TRNG gives a fixed stream of bytes, so a run can be checked against
+ a reference, and takes its sampling time for every 64 bits. The TRNG
+ driver gathers them on a thread of its own, the driverlib registers read
+ by the polled module make the caller spin for them. AES runs on OpenSSL.
+
+ *****************************************************************************/
+#ifndef SIMTRNG_H
+#define SIMTRNG_H
+
+#include <stdint.h>
+
+//*****************************************************************************
+// Global variables
+//*****************************************************************************
+
+// Sampling time of 64 bits of entropy, in us
+extern double simTrngUsPer64;
+
+// Number of driver requests to fail from the next one on
+extern volatile uint32_t simTrngFailNext;
+
+// Bytes of the stream the TRNG has given
+extern volatile uint64_t simTrngBytes;
+
+// AES blocks encrypted, and times the AES driver was opened
+extern uint64_t simAesBlocks;
+extern uint64_t simAesOpens;
+
+//*****************************************************************************
+// Global functions
+//*****************************************************************************
+
+/**
+ * @brief Byte of the TRNG stream.
+ *
+ * @param aOffset offset of the byte from the start of the stream
+ *
+ * @return the byte
+ */
+extern uint8_t simTrngStreamByte(uint64_t aOffset);
+
+/**
+ * @brief Monotonic time of the host.
+ *
+ * @return time in ns
+ */
+extern uint64_t simNowNs(void);
+
+#endif /* SIMTRNG_H */
@@ -55,6 +55,7 @@ extern "C"
  Includes
  *****************************************************************************/
 #include <openthread/config.h>
+#include <openthread/instance.h>
 
 /******************************************************************************
  Typedefs
@@ -63,6 +64,28 @@ extern "C"
 /* OT Stack event Callback function typedef */
 typedef void (*OtStack_EventsCallback_t)(uint8_t events);
 
+/**
+ * A resource of the application as listed in /.well-known/core.
+ */
+typedef struct
+{
+    const char *uriPath;    /* URI of the resource */
+    const char *attributes; /* Link attributes, each after a ';' */
+} OtStack_CoreLink;
+
+/**
+ * Data poll policy of the sleepy device, in ms. The device polls its parent
+ * every fastPeriod for fastWindow after activity: a state change, a report
+ * sent or a request received. Otherwise it polls every slowPeriod, which
+ * bounds how long a message for it waits at the parent.
+ */
+typedef struct
+{
+    uint32_t fastPeriod;
+    uint32_t fastWindow;
+    uint32_t slowPeriod;
+} OtStack_PollPolicy;
+
 /******************************************************************************
  Constants and definitions
  *****************************************************************************/
@@ -100,7 +123,43 @@ typedef void (*OtStack_EventsCallback_t)(uint8_t events);
 #define OT_STACK_IID_ADDRESS_LSB 9
 #endif
 
-#define OT_STACK_POLL_PERIOD 2000
+/*
+ * Fills the interface identifier from the factory EUI-64, keeping
+ * OT_STACK_IID_ADDRESS_LSB as its last byte, so that devices of one kind
+ * get addresses of their own on the prefix. Off by default, the address
+ * then ends in the LSB alone.
+ */
+#ifndef OT_STACK_IID_FROM_EUI64
+#define OT_STACK_IID_FROM_EUI64 0
+#endif
+
+/* URI of the resource discovery */
+#define OT_STACK_CORE_URI ".well-known/core"
+
+/* Longest query filter of a discovery request */
+#define OT_STACK_CORE_QUERY_MAX_LENGTH 32
+
+/* Poll period in the fast window after activity, in ms */
+#ifndef OT_STACK_POLL_FAST_PERIOD
+#define OT_STACK_POLL_FAST_PERIOD 500
+#endif
+
+/* Length of the fast window, in ms */
+#ifndef OT_STACK_POLL_FAST_WINDOW
+#define OT_STACK_POLL_FAST_WINDOW 1500
+#endif
+
+/* Poll period when idle, in ms */
+#ifndef OT_STACK_POLL_SLOW_PERIOD
+#define OT_STACK_POLL_SLOW_PERIOD 15000
+#endif
+
+/* Shortest poll period accepted, in ms */
+#define OT_STACK_POLL_MIN_PERIOD 10
+
+/* Longest fast window accepted, in ms */
+#define OT_STACK_POLL_MAX_WINDOW 600000
+
 /******************************************************************************
  External functions
  *****************************************************************************/
@@ -140,6 +199,48 @@ extern void OtStack_joinNetwork(const char* pskd);
  */
 bool OtStack_setupNetwork(void);
 
+/**
+ * @brief Reports activity to the poll scheduler: a state change, a report
+ *        sent or a request received. Starts or restarts the fast window.
+ *        May be called from an interrupt.
+ *
+ * @return None
+ */
+extern void OtStack_pollActivity(void);
+
+/**
+ * @brief Sets the data poll policy. Takes effect at once.
+ *
+ * @param aPolicy policy to set.
+ * @return OT_ERROR_INVALID_ARGS if the fast period is below
+ *         OT_STACK_POLL_MIN_PERIOD or above the slow period, if the window
+ *         is above OT_STACK_POLL_MAX_WINDOW, or if the slow period is not
+ *         below the child timeout, else OT_ERROR_NONE.
+ */
+extern otError OtStack_setPollPolicy(const OtStack_PollPolicy *aPolicy);
+
+/**
+ * @brief Gets the data poll policy.
+ *
+ * @param aPolicy filled in with the policy.
+ * @return uint32_t poll period in use, in ms.
+ */
+extern uint32_t OtStack_getPollPolicy(OtStack_PollPolicy *aPolicy);
+
+/**
+ * @brief Serves /.well-known/core, the CoRE link format (RFC 6690) list of
+ *        the resources of the application. A query "<attribute>=<value>"
+ *        lists only the links that have it, a '*' ending the value matches
+ *        any rest. A multicast request that no link matches gets no
+ *        response. Call once the CoAP server is started.
+ *
+ * @param aLinks table of the resources, kept by the caller.
+ * @param aCount number of links in the table.
+ * @return OT_ERROR_NONE, or the error adding the resource.
+ */
+extern otError OtStack_setupCoreLinks(const OtStack_CoreLink *aLinks,
+                                      uint8_t aCount);
+
 #ifdef __cplusplus
 }
 #endif
@@ -53,9 +53,6 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-/* POSIX Header files */
-#include <time.h>
-
 /* OpenThread public API Header files */
 #include <openthread/platform/alarm-micro.h>
 
@@ -67,34 +64,13 @@
 
 static uint32_t AlarmMicro_time0   = 0;
 static uint32_t AlarmMicro_time    = 0;
-static timer_t  AlarmMicro_timerid = 0;
 static bool     AlarmMicro_running = false;
 
-/**
- * Handler for the POSIX clock callback.
- */
-void AlarmMicro_handler(union sigval val)
-{
-    (void)val;
-    platformAlarmMicroSignal();
-}
-
 /**
  * Function documented in platform.h
  */
 void platformAlarmMicroInit(void)
 {
-    struct timespec zeroTime = {0};
-    struct sigevent event =
-    {
-        .sigev_notify_function = AlarmMicro_handler,
-        .sigev_notify = SIGEV_SIGNAL,
-    };
-
-    clock_settime(CLOCK_MONOTONIC, &zeroTime);
-
-    timer_create(CLOCK_MONOTONIC, &event, &AlarmMicro_timerid);
-
     AlarmMicro_running = false;
 }
 /**
@@ -102,11 +78,7 @@ void platformAlarmMicroInit(void)
  */
 uint32_t otPlatAlarmMicroGetNow(void)
 {
-    struct timespec now;
-
-    clock_gettime(CLOCK_MONOTONIC, &now);
-
-    return (now.tv_sec * 1000000U) + ((now.tv_nsec / 1000U) % 1000000);
+    return ((uint32_t)platformAlarmGetNowUs());
 }
 
 /**
@@ -115,8 +87,8 @@ uint32_t otPlatAlarmMicroGetNow(void)
 void otPlatAlarmMicroStartAt(otInstance *aInstance, uint32_t aT0, uint32_t aDt)
 {
     (void)aInstance;
-    struct itimerspec timerspec = {0};
-    uint32_t          delta     = (otPlatAlarmMicroGetNow() - aT0);
+    uint64_t now   = platformAlarmGetNowUs();
+    uint32_t delta = ((uint32_t)now - aT0);
 
     AlarmMicro_time0   = aT0;
     AlarmMicro_time    = aDt;
@@ -125,14 +97,12 @@ void otPlatAlarmMicroStartAt(otInstance *aInstance, uint32_t aT0, uint32_t aDt)
     if (delta >= aDt)
     {
         // alarm is in the past
+        platformAlarmQueueStop(PlatformAlarm_micro);
         platformAlarmMicroSignal();
     }
     else
     {
-        timerspec.it_value.tv_sec  = ((aDt - delta) / 1000000U);
-        timerspec.it_value.tv_nsec = (((aDt - delta) % 1000000U) * 1000U);
-
-        timer_settime(AlarmMicro_timerid, 0, &timerspec, NULL);
+        platformAlarmQueueStart(PlatformAlarm_micro, now + (aDt - delta));
     }
 }
 
@@ -142,9 +112,8 @@ void otPlatAlarmMicroStartAt(otInstance *aInstance, uint32_t aT0, uint32_t aDt)
 void otPlatAlarmMicroStop(otInstance *aInstance)
 {
     (void)aInstance;
-    struct itimerspec zeroTime = {0};
 
-    timer_settime(AlarmMicro_timerid, TIMER_ABSTIME, &zeroTime, NULL);
+    platformAlarmQueueStop(PlatformAlarm_micro);
     AlarmMicro_running = false;
 }
 
@@ -163,16 +132,5 @@ void platformAlarmMicroProcess(otInstance *aInstance)
 
             otPlatAlarmMicroFired(aInstance);
         }
-        else
-        {
-            struct itimerspec timerspec = {0};
-
-            timer_gettime(AlarmMicro_timerid, &timerspec);
-            if (0U == timerspec.it_value.tv_sec && 0U == timerspec.it_value.tv_nsec)
-            {
-                /* Timer fired a bit early, notify we still need processing. */
-                platformAlarmMicroSignal();
-            }
-        }
     }
 }
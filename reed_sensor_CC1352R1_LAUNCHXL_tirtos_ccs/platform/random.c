@@ -46,260 +46,439 @@
 
 #include <openthread/config.h>
 
-#include <utils/code_utils.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 
-#include <ti/devices/DeviceFamily.h>
-#include DeviceFamily_constructPath(driverlib/prcm.h)
-#include DeviceFamily_constructPath(driverlib/trng.h)
+#include <utils/code_utils.h>
 
-#include <ti/drivers/Power.h>
-#include <ti/drivers/power/PowerCC26XX.h>
-#include <ti/drivers/utils/RingBuf.h>
+#include <ti/drivers/TRNG.h>
+#include <ti/drivers/cryptoutils/cryptokey/CryptoKeyPlaintext.h>
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/drivers/dpl/SemaphoreP.h>
 
 #include <openthread/platform/random.h>
 
-#include <mbedtls/entropy_poll.h>
+#include "mbedtls/aes.h"
 
+#include "Board.h"
 #include "platform.h"
 
-enum
-{
-    PLATFORM_TRNG_MIN_SAMPLES_PER_CYCLE = (1 << 8),
-    PLATFORM_TRNG_MAX_SAMPLES_PER_CYCLE = (1 << 8),
-    PLATFORM_TRNG_CLOCKS_PER_SAMPLE     = 1,
-};
+/*
+ * Random numbers for the stack come from a CTR_DRBG of NIST SP 800-90A,
+ * AES-128 without a derivation function, run on the AES accelerator through
+ * the mbedtls AES module. The TRNG only seeds it. Entropy is gathered by the
+ * TRNG driver in the background into a pool, and the DRBG is reseeded from
+ * the pool by the stack task once it has served
+ * PLATFORM_RANDOM_RESEED_INTERVAL requests. A request costs a few AES blocks
+ * and never waits for the TRNG.
+ */
 
 /**
- *  Size of the buffer allocation for the ring buffer.
- *
- *  Please note Larger buffer pool size will impact the start up
- *  time.
+ * Size of the pool of TRNG entropy, at least one seed.
  */
-#define RING_BUFFER_SIZE 32
+#ifndef PLATFORM_RANDOM_POOL_SIZE
+#define PLATFORM_RANDOM_POOL_SIZE       64
+#endif
 
-/* buffer used by the ringbuffer object */
-static unsigned char ringBuf[RING_BUFFER_SIZE];
+/**
+ * Number of requests served by the DRBG before it is reseeded.
+ */
+#ifndef PLATFORM_RANDOM_RESEED_INTERVAL
+#define PLATFORM_RANDOM_RESEED_INTERVAL 1024
+#endif
 
-/* ring buffer object */
-static RingBuf_Object ringBufObject;
+#define RANDOM_BLOCK_LEN    16
+#define RANDOM_KEY_LEN      16
+/* Seed length of the DRBG, key and counter */
+#define RANDOM_SEED_LEN     (RANDOM_KEY_LEN + RANDOM_BLOCK_LEN)
 
 /**
- * @internal
- * @brief Initialize the TRNG module and wait for it to be ready
- *        @note:Power to the module needs to be turned on
- *              before calling this function.
- *
- * @return None
+ * State of the CTR_DRBG.
  */
-static void initTRNG(void)
+typedef struct
 {
-    TRNGConfigure(PLATFORM_TRNG_MIN_SAMPLES_PER_CYCLE,
-                  PLATFORM_TRNG_MAX_SAMPLES_PER_CYCLE,
-                  PLATFORM_TRNG_CLOCKS_PER_SAMPLE);
-    TRNGEnable();
+    uint8_t  key[RANDOM_KEY_LEN];
+    uint8_t  v[RANDOM_BLOCK_LEN];
+    uint32_t requests;      // Requests served since the last (re)seed
+    bool     seeded;
+} Random_Drbg;
+
+/* DRBG state */
+static Random_Drbg Random_drbg;
 
-    /* wait for the TRNG to be ready */
-    while (!(TRNGStatusGet() & TRNG_NUMBER_READY))
+/* Block of DRBG output left for otPlatRandomGet() */
+static uint8_t Random_block[RANDOM_BLOCK_LEN];
+static uint8_t Random_blockLen = 0;
+
+/* TRNG driver handle */
+static TRNG_Handle Random_trng = NULL;
+
+/* Entropy request given to the TRNG driver */
+static CryptoKey Random_entropyKey;
+static uint8_t Random_entropy[RANDOM_SEED_LEN];
+static volatile bool Random_trngBusy = false;
+
+/* Posted by the TRNG callback, for the callers waiting on entropy */
+static SemaphoreP_Handle Random_entropySem = NULL;
+
+/* Entropy pool, taken from the front */
+static uint8_t Random_pool[PLATFORM_RANDOM_POOL_SIZE];
+static volatile size_t Random_poolCount = 0;
+
+/* Counters for diag random */
+static PlatformRandom_Stats Random_stats;
+
+/**
+ * @brief Start the TRNG on a seed worth of entropy, unless it is already
+ *        running or the pool has no room for it.
+ */
+static void Random_refill(void)
+{
+    uintptr_t key;
+    bool      start = false;
+
+    key = HwiP_disable();
+    if (!Random_trngBusy &&
+        (Random_poolCount + sizeof(Random_entropy)) <= sizeof(Random_pool))
+    {
+        Random_trngBusy = true;
+        start = true;
+    }
+    HwiP_restore(key);
+
+    if (start)
     {
-        ;
+        CryptoKeyPlaintext_initBlankKey(&Random_entropyKey, Random_entropy,
+                                        sizeof(Random_entropy));
+
+        if (TRNG_generateEntropy(Random_trng, &Random_entropyKey)
+            != TRNG_STATUS_SUCCESS)
+        {
+            Random_trngBusy = false;
+            Random_stats.trngErrors++;
+        }
     }
 }
 
 /**
- * @internal
- * @brief Fills the ring buffer pool with random data obtained
- *        from the TRNG module
+ * @brief Callback of the TRNG driver, adds the entropy to the pool.
  *
- * @return returns the size of the random bytes written in the
- *         ringbuffer pool.
+ * @param handle      TRNG driver handle.
+ * @param returnValue Status of the request.
+ * @param entropy     Key holding the entropy.
  */
-static uint32_t fillRandomPool(void)
+static void Random_trngCallback(TRNG_Handle handle, int_fast16_t returnValue,
+                                CryptoKey *entropy)
 {
-    size_t fillSize = RING_BUFFER_SIZE -
-                      RingBuf_getCount((RingBuf_Handle)&ringBufObject);
-    size_t length   = 0;
+    uintptr_t key;
 
-    union
+    (void)handle;
+
+    (void)entropy;
+
+    /* Random_refill() left room for the whole request */
+    key = HwiP_disable();
+    if (returnValue == TRNG_STATUS_SUCCESS)
+    {
+        memcpy(&Random_pool[Random_poolCount], Random_entropy,
+               sizeof(Random_entropy));
+        Random_poolCount += sizeof(Random_entropy);
+        Random_stats.entropyBytes += sizeof(Random_entropy);
+    }
+    else
     {
-        uint32_t u32[2];
-        uint8_t u8[8];
-    } buffer;
+        Random_stats.trngErrors++;
+    }
+    Random_trngBusy = false;
+    HwiP_restore(key);
+
+    SemaphoreP_post(Random_entropySem);
+
+    /* the stack task restarts the TRNG and reseeds when due */
+    platformRandomSignal();
+}
 
-    Power_setDependency(PowerCC26XX_PERIPH_TRNG);
+/**
+ * @brief Take entropy from the front of the pool.
+ *
+ * @param aOutput Area to place the entropy.
+ * @param aLen    Most bytes to take.
+ *
+ * @return Number of bytes taken.
+ */
+static size_t Random_poolTake(uint8_t *aOutput, size_t aLen)
+{
+    uintptr_t key;
 
-    /* initialize and enable TRNG if TRNG is not enabled */
-    if (0 == (HWREG(TRNG_BASE + TRNG_O_CTL) & TRNG_CTL_TRNG_EN))
+    key = HwiP_disable();
+    if (aLen > Random_poolCount)
     {
-        initTRNG();
+        aLen = Random_poolCount;
     }
+    memcpy(aOutput, Random_pool, aLen);
+    memmove(Random_pool, &Random_pool[aLen], Random_poolCount - aLen);
+    Random_poolCount -= aLen;
+    HwiP_restore(key);
+
+    return aLen;
+}
 
-    while (length < fillSize)
+/**
+ * @brief Take entropy from the pool, waiting for the TRNG if it runs short.
+ *
+ * @param aOutput Area to place the entropy.
+ * @param aLen    Number of bytes to take.
+ *
+ * @return true if all of it was taken, false on a TRNG error.
+ */
+static bool Random_poolWait(uint8_t *aOutput, size_t aLen)
+{
+    size_t length = 0;
+
+    for (;;)
     {
-        if (length % 8 == 0)
+        length += Random_poolTake(&aOutput[length], aLen - length);
+        Random_refill();
+
+        if (length == aLen)
         {
-            /* we've run to the end of the buffer */
-            while (!(TRNGStatusGet() & TRNG_NUMBER_READY))
-            {
-                ;
-            }
-
-            /*
-             * don't use TRNGNumberGet here because it will tell the TRNG to
-             * refill the entropy pool, instead we do it ourself.
-             */
-            buffer.u32[0] = HWREG(TRNG_BASE + TRNG_O_OUT0);
-            buffer.u32[1] = HWREG(TRNG_BASE + TRNG_O_OUT1);
-            HWREG(TRNG_BASE + TRNG_O_IRQFLAGCLR) = 0x1;
+            break;
         }
 
-        RingBuf_put((RingBuf_Handle)&ringBufObject, buffer.u8[length % 8]);
-        length++;
+        /* an empty pool with the TRNG stopped means it failed to start */
+        if (!Random_trngBusy && Random_poolCount == 0)
+        {
+            break;
+        }
+
+        Random_stats.waits++;
+        SemaphoreP_pend(Random_entropySem, SemaphoreP_WAIT_FOREVER);
     }
 
-    Power_releaseDependency(PowerCC26XX_PERIPH_TRNG);
+    return (length == aLen);
+}
+
+/**
+ * @brief Increment the DRBG counter block, big endian.
+ */
+static void Random_increment(uint8_t *aBlock)
+{
+    int i;
 
-    return length;
+    for (i = RANDOM_BLOCK_LEN - 1; i >= 0; i--)
+    {
+        if (++aBlock[i] != 0)
+        {
+            break;
+        }
+    }
 }
 
 /**
- * Fill an arbitrary area with random data
- *
- * @param [out] aOutput area to place the random data
- * @param [in] aLen size of the area to place random data
- * @param [out] oLen how much of the output was written to
+ * @brief CTR_DRBG_Update, derive a new key and counter.
  *
- * @return indication of error
- * @retval 0 no error occured
+ * @param ctx       AES context keyed with the current key.
+ * @param aProvided Seed length of data to mix in, or NULL.
  */
-static int TRNGPoll(unsigned char *aOutput, size_t aLen, size_t *oLen)
+static void Random_update(mbedtls_aes_context *ctx, const uint8_t *aProvided)
 {
-    size_t length = 0;
-    union
+    uint8_t temp[RANDOM_SEED_LEN];
+    size_t  i;
+
+    for (i = 0; i < sizeof(temp); i += RANDOM_BLOCK_LEN)
     {
-        uint32_t u32[2];
-        uint8_t u8[8];
-    } buffer;
+        Random_increment(Random_drbg.v);
+        mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_ENCRYPT, Random_drbg.v,
+                              &temp[i]);
+    }
 
-    while (length < aLen)
+    if (aProvided != NULL)
     {
-        if (length % 8 == 0)
+        for (i = 0; i < sizeof(temp); i++)
         {
-            /* we've run to the end of the buffer */
-            while (!(TRNGStatusGet() & TRNG_NUMBER_READY))
-            {
-                ;
-            }
-
-            /*
-             * don't use TRNGNumberGet here because it will tell the TRNG to
-             * refill the entropy pool, instead we do it ourself.
-             */
-            buffer.u32[0] = HWREG(TRNG_BASE + TRNG_O_OUT0);
-            buffer.u32[1] = HWREG(TRNG_BASE + TRNG_O_OUT1);
-            HWREG(TRNG_BASE + TRNG_O_IRQFLAGCLR) = 0x1;
+            temp[i] ^= aProvided[i];
         }
+    }
 
-        aOutput[length] = buffer.u8[length % 8];
+    memcpy(Random_drbg.key, temp, RANDOM_KEY_LEN);
+    memcpy(Random_drbg.v, &temp[RANDOM_KEY_LEN], RANDOM_BLOCK_LEN);
+    memset(temp, 0, sizeof(temp));
+}
 
-        length++;
-        *oLen = length;
+/**
+ * @brief Seed the DRBG, CTR_DRBG_Instantiate or CTR_DRBG_Reseed without
+ *        additional input.
+ *
+ * @param aSeed Seed length of entropy.
+ */
+static void Random_seed(const uint8_t *aSeed)
+{
+    mbedtls_aes_context ctx;
+
+    if (!Random_drbg.seeded)
+    {
+        memset(Random_drbg.key, 0, sizeof(Random_drbg.key));
+        memset(Random_drbg.v, 0, sizeof(Random_drbg.v));
     }
-    return 0;
+
+    mbedtls_aes_init(&ctx);
+    mbedtls_aes_setkey_enc(&ctx, Random_drbg.key, RANDOM_KEY_LEN * 8);
+    Random_update(&ctx, aSeed);
+    mbedtls_aes_free(&ctx);
+
+    Random_drbg.requests = 0;
+    Random_drbg.seeded = true;
+    Random_blockLen = 0;
 }
 
 /**
- * @internal
- * @brief Fill an arbitrary area with the random data.
- *        It first gets random from the pool if available else
- *        call the TRNGPoll() to get random data from TRNG
- *        module.
+ * @brief CTR_DRBG_Generate without additional input.
  *
- * @param aOutput area to place the random data
- * @param aLen size if the area to place random data
- * @param oLen how much of the output was written to
+ * @param aOutput Area to place the random data.
+ * @param aLen    Number of bytes, at most the 2^16 a request may ask for.
  *
- * @return returns 0 if no error occurred, -1 if error.
+ * @return true if generated, false if the DRBG was never seeded.
  */
-static int getRandom(unsigned char *aOutput, size_t aLen, size_t *oLen)
+static bool Random_generate(uint8_t *aOutput, size_t aLen)
 {
-    size_t count = RingBuf_getCount((RingBuf_Handle)&ringBufObject);
+    mbedtls_aes_context ctx;
+    uint8_t             block[RANDOM_BLOCK_LEN];
+    size_t              length;
 
-    if (count >= aLen)
+    if (!Random_drbg.seeded)
     {
-        for (int i = 0; i < aLen; i++)
-        {
-            (void)RingBuf_get(&ringBufObject, &aOutput[i]);
-        }
-
-        *oLen = aLen;
+        return false;
     }
-    else
-    {
-        size_t length = 0;
-        size_t tempSize = 0;
 
-        /* jump start the TRNG peripheral since we will be using below */
-        Power_setDependency(PowerCC26XX_PERIPH_TRNG);
+    mbedtls_aes_init(&ctx);
+    mbedtls_aes_setkey_enc(&ctx, Random_drbg.key, RANDOM_KEY_LEN * 8);
+
+    while (aLen > 0)
+    {
+        Random_increment(Random_drbg.v);
 
-        /* initialize and enable TRNG if TRNG is not enabled */
-        if (0 == (HWREG(TRNG_BASE + TRNG_O_CTL) & TRNG_CTL_TRNG_EN))
+        if (aLen >= RANDOM_BLOCK_LEN)
         {
-            initTRNG();
+            mbedtls_aes_crypt_ecb(&ctx, MBEDTLS_AES_ENCRYPT, Random_drbg.v,
+                                  aOutput);
+            length = RANDOM_BLOCK_LEN;
         }
-
-        while (length < count)
+        else
         {
-            (void)RingBuf_get(&ringBufObject, &aOutput[length]);
-            length++;
+            mbedtls_aes_crypt_ecb(&ctx, MBEDTLS_AES_ENCRYPT, Random_drbg.v,
+                                  block);
+            memcpy(aOutput, block, aLen);
+            length = aLen;
         }
 
-        /* and get the rest directly from TRNG */
-        TRNGPoll(&aOutput[length], aLen - count, &tempSize);
-
-        /* release the TRNG power dependency */
-        Power_releaseDependency(PowerCC26XX_PERIPH_TRNG);
+        aOutput += length;
+        aLen    -= length;
+    }
 
-        length += tempSize;
-        *oLen = length;
+    /* backtracking resistance, the key used is gone once this returns */
+    Random_update(&ctx, NULL);
+    mbedtls_aes_free(&ctx);
+    memset(block, 0, sizeof(block));
 
-        /* notify the main loop that we need to replenish the random pool */
+    Random_stats.requests++;
+    if (++Random_drbg.requests == PLATFORM_RANDOM_RESEED_INTERVAL)
+    {
         platformRandomSignal();
     }
 
-    return 0;
+    return true;
 }
 
-
 /**
  * Function documented in platform.h
  */
 void platformRandomInit(void)
 {
-    /* construct a ring buffer to be used for pool of random bytes */
-    RingBuf_construct(&ringBufObject, ringBuf, RING_BUFFER_SIZE);
+    TRNG_Params params;
+    uint8_t     seed[RANDOM_SEED_LEN];
+
+    Random_entropySem = SemaphoreP_createBinary(0);
+
+    TRNG_Params_init(&params);
+    params.returnBehavior = TRNG_RETURN_BEHAVIOR_CALLBACK;
+    params.callbackFxn    = Random_trngCallback;
+    Random_trng = TRNG_open(Board_TRNG0, &params);
+
+    otEXPECT(Random_trng != NULL && Random_entropySem != NULL);
+
+    /* the first seed is waited for, the stack needs it to start */
+    if (Random_poolWait(seed, sizeof(seed)))
+    {
+        Random_seed(seed);
+        memset(seed, 0, sizeof(seed));
+    }
 
-    /* fill the random pool */
-    (void)fillRandomPool();
+exit:
+    return;
 }
 
 /**
- * Function documented in platform/random.h
+ * Function documented in platform.h
  */
-uint32_t otPlatRandomGet(void)
+void platformRandomProcess(void)
 {
-    union
+    uint8_t seed[RANDOM_SEED_LEN];
+
+    otEXPECT(Random_trng != NULL);
+
+    if (Random_drbg.requests >= PLATFORM_RANDOM_RESEED_INTERVAL &&
+        Random_poolCount >= sizeof(seed))
     {
-        uint32_t u32;
-        uint8_t u8[4];
-    } buffer;
+        Random_poolTake(seed, sizeof(seed));
+        Random_seed(seed);
+        memset(seed, 0, sizeof(seed));
+        Random_stats.reseeds++;
+    }
+
+    /* keep the pool full for the next reseed */
+    Random_refill();
 
-    size_t  temp_size = 0;
+exit:
+    return;
+}
 
-    getRandom((unsigned char *)buffer.u8, 4, &temp_size);
+/**
+ * Function documented in platform.h
+ */
+void platformRandomGetStats(PlatformRandom_Stats *aStats)
+{
+    uintptr_t key;
 
-    return buffer.u32;
+    key = HwiP_disable();
+    *aStats = Random_stats;
+    aStats->poolCount = Random_poolCount;
+    HwiP_restore(key);
 }
 
+/**
+ * Function documented in platform/random.h
+ */
+uint32_t otPlatRandomGet(void)
+{
+    uint32_t value = 0;
+
+    if (Random_blockLen < sizeof(value))
+    {
+        if (Random_generate(Random_block, sizeof(Random_block)))
+        {
+            Random_blockLen = sizeof(Random_block);
+        }
+    }
+
+    if (Random_blockLen >= sizeof(value))
+    {
+        Random_blockLen -= sizeof(value);
+        memcpy(&value, &Random_block[Random_blockLen], sizeof(value));
+    }
+
+    return value;
+}
 
 /**
  * Function documented in platform/random.h
@@ -307,46 +486,39 @@ uint32_t otPlatRandomGet(void)
 otError otPlatRandomSecureGet(uint16_t aInputLength, uint8_t *aOutput,
                               uint16_t *aOutputLength)
 {
-    otError error     = OT_ERROR_NONE;
-    size_t  length    = aInputLength;
-    size_t  temp_size = 0;
+    otError  error  = OT_ERROR_NONE;
+    uint16_t length = 0;
 
     otEXPECT_ACTION(aOutput && aOutputLength, error = OT_ERROR_INVALID_ARGS);
 
-    otEXPECT_ACTION(getRandom((unsigned char *)aOutput, length, &temp_size) == 0,
-                     error = OT_ERROR_FAILED);
+    otEXPECT_ACTION(Random_generate(aOutput, aInputLength),
+                    error = OT_ERROR_FAILED);
+    length = aInputLength;
 
 exit:
     if (aOutputLength)
     {
-        *aOutputLength = temp_size;
+        *aOutputLength = length;
     }
     return error;
 }
 
-/**
- * Function documented in platform.h
- */
-void platformRandomProcess(void)
-{
-    /* fill the pool with random bytes from TRNG */
-    (void)fillRandomPool();
-}
-
 /**
  * Function documented in platform/random.h
+ *
+ * This seeds the mbedtls entropy source of the stack, so it is TRNG output
+ * rather than DRBG output. It waits for the TRNG when the pool runs short.
  */
 otError otPlatRandomGetTrue(uint8_t *aOutput, uint16_t aOutputLength)
 {
     otError error = OT_ERROR_NONE;
-    size_t  temp_size = 0;
 
     otEXPECT_ACTION(NULL != aOutput, error = OT_ERROR_INVALID_ARGS);
+    otEXPECT_ACTION(Random_trng != NULL, error = OT_ERROR_FAILED);
 
-    otEXPECT_ACTION(getRandom((unsigned char *)aOutput, aOutputLength, &temp_size) == 0, error = OT_ERROR_FAILED);
-    (void)temp_size;
+    otEXPECT_ACTION(Random_poolWait(aOutput, aOutputLength),
+                    error = OT_ERROR_FAILED);
 
 exit:
     return error;
 }
-
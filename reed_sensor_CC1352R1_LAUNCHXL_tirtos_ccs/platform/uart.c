@@ -46,13 +46,16 @@
 
 #include <openthread/config.h>
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
 
 #include <utils/code_utils.h>
 #include <openthread/platform/uart.h>
 
 #include <ti/drivers/UART.h>
 #include <ti/drivers/uart/UARTCC26XX.h>
+#include <ti/drivers/dpl/HwiP.h>
 
 #include <ti/sysbios/BIOS.h>
 #include <ti/sysbios/knl/Event.h>
@@ -61,11 +64,21 @@
 #include "platform.h"
 
 /**
- * Configure the UART core for 115200 baud 8-N-1, no HW flow control.
+ * Configure the UART core for 8-N-1 at @ref PLATFORM_UART_BAUD_RATE.
  *
- * @note Make sure that data being passed to @ref otPlatUartSend is in
- *       persistent readable memory.
+ * Received bytes land directly in a circular buffer. A new read is queued
+ * from the read callback, so the UART keeps receiving while the stack
+ * processes earlier data. Data passed to @ref otPlatUartSend is copied to a
+ * circular transmit buffer, and the send is reported done as soon as it has
+ * been copied. The transmit buffer is written out in the background.
+ *
+ * For rates above 115200 baud, enable hardware flow control on the board
+ * UART (CTS/RTS pins in the board file) so that the host stops sending when
+ * the buffers are full. The CC13x2 UART runs at up to 3 Mbaud.
  */
+#ifndef PLATFORM_UART_BAUD_RATE
+#define PLATFORM_UART_BAUD_RATE 115200
+#endif
 
 /**
  * Event flags marked in @ref PlatformUart_events.
@@ -74,25 +87,75 @@
 #define PLATFORM_UART_EVENT_RX_DONE  Event_Id_01
 
 /**
- * Size of the statically allocated buffer to pass data from the callback to
- * the processing loop.
+ * Size of the circular receive buffer, a power of two. Holds what arrives
+ * while the processing loop is busy.
+ */
+#ifndef PLATFORM_UART_RECV_BUF_LEN
+#define PLATFORM_UART_RECV_BUF_LEN 512
+#endif
+
+/**
+ * Size of the circular transmit buffer, a power of two.
  */
-#define PLATFORM_UART_RECV_BUF_LEN 32
+#ifndef PLATFORM_UART_SEND_BUF_LEN
+#define PLATFORM_UART_SEND_BUF_LEN 512
+#endif
+
+#if (PLATFORM_UART_RECV_BUF_LEN & (PLATFORM_UART_RECV_BUF_LEN - 1)) || \
+    (PLATFORM_UART_SEND_BUF_LEN & (PLATFORM_UART_SEND_BUF_LEN - 1))
+#error "UART buffer lengths must be powers of two"
+#endif
 
 /**
- * Statically allocated data buffer.
+ * Statically allocated circular receive buffer.
  */
 static uint8_t PlatformUart_receiveBuffer[PLATFORM_UART_RECV_BUF_LEN];
 
 /**
- * Number of bytes in the receive buffer.
+ * Free running counts of bytes received and bytes passed to the stack.
+ * Written by the read callback and the processing loop respectively.
+ */
+static volatile size_t PlatformUart_receiveHead;
+static volatile size_t PlatformUart_receiveTail;
+
+/**
+ * Length of the read in progress, 0 if reception is paused because the
+ * receive buffer is full.
+ */
+static volatile size_t PlatformUart_readLen;
+
+/**
+ * Statically allocated circular transmit buffer.
+ */
+static uint8_t PlatformUart_sendRing[PLATFORM_UART_SEND_BUF_LEN];
+
+/**
+ * Free running counts of bytes queued for and bytes finished by the UART.
+ * Written by the processing loop and the write callback respectively.
+ */
+static volatile size_t PlatformUart_sendHead;
+static volatile size_t PlatformUart_sendTail;
+
+/**
+ * Length of the write in progress, 0 if the UART is idle.
  */
-static size_t PlatformUart_receiveLen;
+static volatile size_t PlatformUart_writeLen;
 
 /**
- * The buffer to be sent.
+ * The part of the buffer being sent that is not yet queued.
  */
 static uint8_t const *PlatformUart_sendBuffer = NULL;
+static uint16_t PlatformUart_sendLen;
+
+/**
+ * A send is in progress and @ref otPlatUartSendDone is still owed.
+ */
+static bool PlatformUart_sending;
+
+/**
+ * Transport counters.
+ */
+static PlatformUart_Stats PlatformUart_stats;
 
 /**
  * TI-RTOS events structure for passing state to the processing loop.
@@ -104,17 +167,147 @@ static Event_Struct PlatformUart_events;
  */
 static UART_Handle PlatformUart_uartHandle;
 
+/**
+ * Queue a read into the free space at the head of the receive buffer.
+ *
+ * Only called when no read is in progress.
+ *
+ * @return true if a read was queued, false if the buffer is full.
+ */
+static bool uartReadStart(void)
+{
+    size_t head = PlatformUart_receiveHead;
+    size_t ofs  = head & (PLATFORM_UART_RECV_BUF_LEN - 1);
+    size_t len  = PLATFORM_UART_RECV_BUF_LEN - (head - PlatformUart_receiveTail);
+
+    /* a read must not wrap around the end of the buffer */
+    if (len > PLATFORM_UART_RECV_BUF_LEN - ofs)
+    {
+        len = PLATFORM_UART_RECV_BUF_LEN - ofs;
+    }
+
+    PlatformUart_readLen = len;
+    if (len > 0)
+    {
+        UART_read(PlatformUart_uartHandle, &PlatformUart_receiveBuffer[ofs],
+                  len);
+    }
+
+    return (len > 0);
+}
+
+/**
+ * Write out the queued data at the tail of the transmit buffer.
+ *
+ * Only called when no write is in progress.
+ */
+static void uartWriteStart(void)
+{
+    size_t tail = PlatformUart_sendTail;
+    size_t ofs  = tail & (PLATFORM_UART_SEND_BUF_LEN - 1);
+    size_t len  = PlatformUart_sendHead - tail;
+
+    /* a write must not wrap around the end of the buffer */
+    if (len > PLATFORM_UART_SEND_BUF_LEN - ofs)
+    {
+        len = PLATFORM_UART_SEND_BUF_LEN - ofs;
+    }
+
+    PlatformUart_writeLen = len;
+    if (len > 0)
+    {
+        UART_write(PlatformUart_uartHandle, &PlatformUart_sendRing[ofs], len);
+    }
+}
+
+/**
+ * Copy as much of the send in progress as fits into the transmit buffer,
+ * and start the UART on it if it is idle.
+ */
+static void uartSendQueue(void)
+{
+    uintptr_t key;
+    bool start;
+
+    while (PlatformUart_sendLen > 0 &&
+           PlatformUart_sendHead - PlatformUart_sendTail <
+           PLATFORM_UART_SEND_BUF_LEN)
+    {
+        size_t head = PlatformUart_sendHead;
+        size_t ofs  = head & (PLATFORM_UART_SEND_BUF_LEN - 1);
+        size_t len  = PLATFORM_UART_SEND_BUF_LEN -
+                      (head - PlatformUart_sendTail);
+
+        if (len > PLATFORM_UART_SEND_BUF_LEN - ofs)
+        {
+            len = PLATFORM_UART_SEND_BUF_LEN - ofs;
+        }
+        if (len > PlatformUart_sendLen)
+        {
+            len = PlatformUart_sendLen;
+        }
+
+        memcpy(&PlatformUart_sendRing[ofs], PlatformUart_sendBuffer, len);
+        PlatformUart_sendBuffer += len;
+        PlatformUart_sendLen    -= len;
+        PlatformUart_sendHead    = head + len;
+
+        if (PlatformUart_sendHead - PlatformUart_sendTail >
+            PlatformUart_stats.txHighWater)
+        {
+            PlatformUart_stats.txHighWater = PlatformUart_sendHead -
+                                             PlatformUart_sendTail;
+        }
+    }
+
+    /* the write callback may be finding the buffer empty right now */
+    key = HwiP_disable();
+    start = (PlatformUart_writeLen == 0);
+    if (start)
+    {
+        /* claim the UART before the callback can */
+        PlatformUart_writeLen = 1;
+    }
+    HwiP_restore(key);
+
+    if (start)
+    {
+        uartWriteStart();
+    }
+}
+
 /**
  * Callback for when the UART driver finishes reading.
  *
- * This is triggered when the buffer is full, or when the UART hardware times
- * out.
+ * This is triggered when the requested length is in, or when the UART
+ * hardware times out. The next read is queued right away.
  */
 static void uartReadCallback(UART_Handle aHandle, void *aBuf, size_t aLen)
 {
-    (void)aHandle;
+    UARTCC26XX_Object *object = aHandle->object;
+
     (void)aBuf;
-    PlatformUart_receiveLen = aLen;
+
+    /* the driver notes receive errors of the read in its status */
+    if (object->status & UART_OVERRUN_ERROR)
+    {
+        PlatformUart_stats.rxOverruns++;
+    }
+    if (object->status &
+        (UART_PARITY_ERROR | UART_FRAMING_ERROR | UART_BRAKE_ERROR))
+    {
+        PlatformUart_stats.rxErrors++;
+    }
+
+    PlatformUart_receiveHead += aLen;
+    PlatformUart_stats.rxBytes += aLen;
+
+    if (!uartReadStart())
+    {
+        /* the processing loop restarts reception once it catches up */
+        PlatformUart_stats.rxStalls++;
+    }
+
     Event_post(Event_handle(&PlatformUart_events),
                PLATFORM_UART_EVENT_RX_DONE);
     platformUartSignal();
@@ -122,14 +315,24 @@ static void uartReadCallback(UART_Handle aHandle, void *aBuf, size_t aLen)
 
 /**
  * Callback for when the UART driver finishes writing a buffer.
+ *
+ * A write can end short, the rest is written out with what follows it.
  */
 static void uartWriteCallback(UART_Handle aHandle, void *aBuf, size_t aLen)
 {
     (void)aHandle;
     (void)aBuf;
-    (void)aLen;
-    /* XXX: partial writes are not handled */
-    PlatformUart_sendBuffer = NULL;
+
+    if (aLen < PlatformUart_writeLen)
+    {
+        PlatformUart_stats.txPartial++;
+    }
+
+    PlatformUart_sendTail += aLen;
+    PlatformUart_stats.txBytes += aLen;
+
+    uartWriteStart();
+
     Event_post(Event_handle(&PlatformUart_events),
                PLATFORM_UART_EVENT_TX_DONE);
     platformUartSignal();
@@ -153,11 +356,21 @@ otError otPlatUartEnable(void)
     params.readDataMode     = UART_DATA_BINARY;
     params.writeDataMode    = UART_DATA_BINARY;
     params.readEcho         = UART_ECHO_OFF;
-    params.baudRate         = 115200;
+    params.baudRate         = PLATFORM_UART_BAUD_RATE;
     params.dataLength       = UART_LEN_8;
     params.stopBits         = UART_STOP_ONE;
     params.parityType       = UART_PAR_NONE;
 
+    PlatformUart_receiveHead = 0;
+    PlatformUart_receiveTail = 0;
+    PlatformUart_sendHead    = 0;
+    PlatformUart_sendTail    = 0;
+    PlatformUart_writeLen    = 0;
+    PlatformUart_sendBuffer  = NULL;
+    PlatformUart_sendLen     = 0;
+    PlatformUart_sending     = false;
+    memset(&PlatformUart_stats, 0, sizeof(PlatformUart_stats));
+
     PlatformUart_uartHandle = UART_open(Board_UART0, &params);
 
     /* allow the uart driver to return before the read buffer is full */
@@ -165,8 +378,7 @@ otError otPlatUartEnable(void)
                  NULL);
 
     /* begin reading from the uart */
-    UART_read(PlatformUart_uartHandle, PlatformUart_receiveBuffer,
-              sizeof(PlatformUart_receiveBuffer));
+    uartReadStart();
 
     return OT_ERROR_NONE;
 }
@@ -189,13 +401,32 @@ otError otPlatUartDisable(void)
 otError otPlatUartSend(const uint8_t *aBuf, uint16_t aBufLength)
 {
     otError error = OT_ERROR_NONE;
-    otEXPECT_ACTION(PlatformUart_sendBuffer == NULL, error = OT_ERROR_BUSY);
-    UART_write(PlatformUart_uartHandle, aBuf, aBufLength);
+    otEXPECT_ACTION(!PlatformUart_sending, error = OT_ERROR_BUSY);
+
+    PlatformUart_sending    = true;
+    PlatformUart_sendBuffer = aBuf;
+    PlatformUart_sendLen    = aBufLength;
+    uartSendQueue();
+
+    /* report the send done from the processing loop */
+    Event_post(Event_handle(&PlatformUart_events),
+               PLATFORM_UART_EVENT_TX_DONE);
+    platformUartSignal();
 
 exit:
     return error;
 }
 
+/**
+ * Function documented in platform.h
+ */
+void platformUartGetStats(PlatformUart_Stats *aStats)
+{
+    uintptr_t key = HwiP_disable();
+    *aStats = PlatformUart_stats;
+    HwiP_restore(key);
+}
+
 /**
  * Function documented in platform.h
  */
@@ -207,15 +438,50 @@ void platformUartProcess(void)
 
     if(events & PLATFORM_UART_EVENT_TX_DONE)
     {
-        otPlatUartSendDone();
+        if (PlatformUart_sendLen > 0)
+        {
+            /* room was made, queue more of the send in progress */
+            uartSendQueue();
+        }
+
+        if (PlatformUart_sending && PlatformUart_sendLen == 0)
+        {
+            PlatformUart_sending    = false;
+            PlatformUart_sendBuffer = NULL;
+            otPlatUartSendDone();
+        }
     }
 
     if(events & PLATFORM_UART_EVENT_RX_DONE)
     {
-        otPlatUartReceived(PlatformUart_receiveBuffer, PlatformUart_receiveLen);
-        PlatformUart_receiveLen = 0;
-        UART_read(PlatformUart_uartHandle, PlatformUart_receiveBuffer,
-                  sizeof(PlatformUart_receiveBuffer));
-
+        size_t head = PlatformUart_receiveHead;
+        size_t tail = PlatformUart_receiveTail;
+
+        if (head - tail > PlatformUart_stats.rxHighWater)
+        {
+            PlatformUart_stats.rxHighWater = head - tail;
+        }
+
+        while (head != tail)
+        {
+            size_t ofs = tail & (PLATFORM_UART_RECV_BUF_LEN - 1);
+            size_t len = head - tail;
+
+            /* hand over the data in at most two pieces around the wrap */
+            if (len > PLATFORM_UART_RECV_BUF_LEN - ofs)
+            {
+                len = PLATFORM_UART_RECV_BUF_LEN - ofs;
+            }
+
+            otPlatUartReceived(&PlatformUart_receiveBuffer[ofs], len);
+            tail += len;
+        }
+        PlatformUart_receiveTail = tail;
+
+        /* no read is in progress while reception is paused */
+        if (PlatformUart_readLen == 0)
+        {
+            uartReadStart();
+        }
     }
 }
@@ -44,6 +44,7 @@
 #include "disp_utils.h"
 #include "keys_utils.h"
 #include "otstack.h"
+#include "platform/platform.h"
 
 /* Private configuration Header files */
 #include "task_config.h"
@@ -68,6 +69,12 @@
 
 #define DEFAULT_COAP_HEADER_TOKEN_LEN 2
 
+/* Maximum number of characters of the energy counters including null terminator*/
+#define ENERGY_MAX_CHARS 112
+
+/* Maximum number of characters of the poll policy including null terminator*/
+#define POLL_MAX_CHARS 72
+
 /* coap attribute descriptor */
 typedef struct
 {
@@ -108,6 +115,18 @@ static char stack[TASK_CONFIG_REEDSWITCH_TASK_STACK_SIZE];
 /* coap resource for the application */
 static otCoapResource coapResource;
 
+/* coap resource of the energy counters */
+static otCoapResource coapResourceEnergy;
+
+/* energy counters, formatted when read */
+static char attrEnergy[ENERGY_MAX_CHARS];
+
+/* coap resource of the data poll policy */
+static otCoapResource coapResourcePoll;
+
+/* data poll policy, formatted when read */
+static char attrPoll[POLL_MAX_CHARS];
+
 /* coap attribute state of the application */
 static uint8_t attrReed[11] = REEDSWITCH_CLOSED;
 //TODO delete this if unused:
@@ -120,6 +139,13 @@ const attrDesc_t coapAttr = {
     attrReed,
 };
 
+/* resources listed in /.well-known/core */
+static const OtStack_CoreLink coreLinks[] = {
+    { REEDSWITCH_URI, ";rt=\"door.state\";if=\"core.s\";ct=0" },
+    { REEDSWITCH_ENERGY_URI, ";rt=\"energy\";if=\"core.p\";ct=0" },
+    { REEDSWITCH_POLL_URI, ";rt=\"poll\";if=\"core.p\";ct=0" },
+};
+
 /* Holds the server setup state: 1 indicates CoAP server has been setup */
 static bool serverSetup;
 
@@ -162,6 +188,9 @@ void gpioReedSwitchFxn(uint_least8_t index)
         GPIO_write(Board_GPIO_LED1, 0);
         //Display_printf(displayHandle, 1, 0, "Reed Switch Event write closed");
      }
+
+    /* The controller may follow up on the change */
+    OtStack_pollActivity();
    
 
   }
@@ -246,7 +275,7 @@ static void reedSwitchReport(void)
 
     /* print the reported value to the terminal */
     DISPUTILS_SERIALPRINTF(0, 0, "Reporting Reed State:");
-    DISPUTILS_SERIALPRINTF(0, 0, (char*)attrReed);
+    DISPUTILS_SERIALPRINTF(0, 0, "%s", (char*)attrReed);
 
 
     OtRtosApi_lock();
@@ -279,6 +308,11 @@ static void reedSwitchReport(void)
                               NULL);
     OtRtosApi_unlock();
 
+    if(OT_ERROR_NONE == error)
+    {
+        OtStack_pollActivity();
+    }
+
     /* Restart the clock */
     if(Clock_isActive(reportClkHandle) == true)
     {
@@ -317,6 +351,8 @@ static void coapHandleServer(void *aContext, otCoapHeader *aHeader,
     otCoapCode responseCode = OT_COAP_CODE_CHANGED;
     otCoapCode messageCode = otCoapHeaderGetCode(aHeader);
 
+    OtStack_pollActivity();
+
     otCoapHeaderInit(&responseHeader, OT_COAP_TYPE_ACKNOWLEDGMENT, responseCode);
     otCoapHeaderSetMessageId(&responseHeader,
                              otCoapHeaderGetMessageId(aHeader));
@@ -347,6 +383,211 @@ exit:
     }
 }
 
+/**
+ * @brief Formats the energy counters into their attribute: ms in rx, tx,
+ *        MCU active, idle and standby, then the charge drawn in uC and the
+ *        average current in nA.
+ *
+ * @return None
+ */
+static void updateEnergy(void)
+{
+    PlatformEnergy_Stats stats;
+
+    platformEnergyGetStats(&stats);
+    snprintf(attrEnergy, sizeof(attrEnergy),
+             "rx=%lu tx=%lu act=%lu idle=%lu sb=%lu uC=%lu nA=%lu",
+             (unsigned long)stats.ms[PlatformEnergy_rx],
+             (unsigned long)stats.ms[PlatformEnergy_tx],
+             (unsigned long)stats.ms[PlatformEnergy_active],
+             (unsigned long)stats.ms[PlatformEnergy_idle],
+             (unsigned long)stats.ms[PlatformEnergy_standby],
+             (unsigned long)stats.chargeUc,
+             (unsigned long)stats.averageNa);
+}
+
+/**
+ * @brief Callback function registered with the Coap server.
+ *        Reads the energy counters on a GET, clears them on a POST.
+ *
+ * @param  aContext      A pointer to the context information.
+ * @param  aHeader       A pointer to the CoAP header.
+ * @param  aMessage      A pointer to the message.
+ * @param  aMessageInfo  A pointer to the message info.
+ *
+ * @return None
+ */
+static void coapHandleEnergy(void *aContext, otCoapHeader *aHeader,
+                             otMessage *aMessage,
+                             const otMessageInfo *aMessageInfo)
+{
+    otError error = OT_ERROR_NONE;
+    otCoapHeader responseHeader;
+    otMessage *responseMessage = NULL;
+    otCoapCode responseCode = OT_COAP_CODE_CONTENT;
+    otCoapCode messageCode = otCoapHeaderGetCode(aHeader);
+
+    (void)aMessage;
+
+    OtStack_pollActivity();
+
+    otEXPECT(OT_COAP_CODE_GET == messageCode ||
+             OT_COAP_CODE_POST == messageCode);
+
+    if(OT_COAP_CODE_POST == messageCode)
+    {
+        platformEnergyClear();
+        responseCode = OT_COAP_CODE_CHANGED;
+    }
+    updateEnergy();
+
+    otCoapHeaderInit(&responseHeader, OT_COAP_TYPE_ACKNOWLEDGMENT, responseCode);
+    otCoapHeaderSetMessageId(&responseHeader, otCoapHeaderGetMessageId(aHeader));
+    otCoapHeaderSetToken(&responseHeader, otCoapHeaderGetToken(aHeader),
+                         otCoapHeaderGetTokenLength(aHeader));
+    otCoapHeaderSetPayloadMarker(&responseHeader);
+
+    responseMessage = otCoapNewMessage((otInstance*)aContext, &responseHeader);
+    otEXPECT_ACTION(responseMessage != NULL, error = OT_ERROR_NO_BUFS);
+
+    error = otMessageAppend(responseMessage, attrEnergy, strlen(attrEnergy));
+    otEXPECT(OT_ERROR_NONE == error);
+
+    error = otCoapSendResponse((otInstance*)aContext, responseMessage,
+                               aMessageInfo);
+    otEXPECT(OT_ERROR_NONE == error);
+
+exit:
+
+    if(error != OT_ERROR_NONE && responseMessage != NULL)
+    {
+        otMessageFree(responseMessage);
+    }
+}
+
+/**
+ * @brief Formats the data poll policy into its attribute: the fast period,
+ *        fast window and slow period, then the period in use, all in ms.
+ *
+ * @return None
+ */
+static void updatePoll(void)
+{
+    OtStack_PollPolicy policy;
+    uint32_t period = OtStack_getPollPolicy(&policy);
+
+    snprintf(attrPoll, sizeof(attrPoll), "fast=%lu window=%lu slow=%lu now=%lu",
+             (unsigned long)policy.fastPeriod,
+             (unsigned long)policy.fastWindow,
+             (unsigned long)policy.slowPeriod,
+             (unsigned long)period);
+}
+
+/**
+ * @brief Callback function registered with the Coap server.
+ *        Reads the data poll policy on a GET. Sets it on a POST of
+ *        "fast=<ms> window=<ms> slow=<ms>", the form a GET returns.
+ *
+ * @param  aContext      A pointer to the context information.
+ * @param  aHeader       A pointer to the CoAP header.
+ * @param  aMessage      A pointer to the message.
+ * @param  aMessageInfo  A pointer to the message info.
+ *
+ * @return None
+ */
+static void coapHandlePoll(void *aContext, otCoapHeader *aHeader,
+                           otMessage *aMessage,
+                           const otMessageInfo *aMessageInfo)
+{
+    otError error = OT_ERROR_NONE;
+    otCoapHeader responseHeader;
+    otMessage *responseMessage = NULL;
+    otCoapCode responseCode = OT_COAP_CODE_CONTENT;
+    otCoapCode messageCode = otCoapHeaderGetCode(aHeader);
+
+    OtStack_pollActivity();
+
+    otEXPECT(OT_COAP_CODE_GET == messageCode ||
+             OT_COAP_CODE_POST == messageCode);
+
+    if(OT_COAP_CODE_POST == messageCode)
+    {
+        OtStack_PollPolicy policy;
+        unsigned long fast, window, slow;
+        char data[POLL_MAX_CHARS];
+        uint16_t offset = otMessageGetOffset(aMessage);
+        uint16_t read = otMessageRead(aMessage, offset, data, sizeof(data) - 1);
+        data[read] = '\0';
+
+        responseCode = OT_COAP_CODE_BAD_REQUEST;
+        if(sscanf(data, "fast=%lu window=%lu slow=%lu", &fast, &window,
+                  &slow) == 3)
+        {
+            policy.fastPeriod = fast;
+            policy.fastWindow = window;
+            policy.slowPeriod = slow;
+            if(OtStack_setPollPolicy(&policy) == OT_ERROR_NONE)
+            {
+                responseCode = OT_COAP_CODE_CHANGED;
+            }
+        }
+        DISPUTILS_SERIALPRINTF(0, 0, "poll policy %s: %s\n",
+                               (responseCode == OT_COAP_CODE_CHANGED) ?
+                               "set" : "refused", data);
+    }
+    updatePoll();
+
+    otCoapHeaderInit(&responseHeader, OT_COAP_TYPE_ACKNOWLEDGMENT, responseCode);
+    otCoapHeaderSetMessageId(&responseHeader, otCoapHeaderGetMessageId(aHeader));
+    otCoapHeaderSetToken(&responseHeader, otCoapHeaderGetToken(aHeader),
+                         otCoapHeaderGetTokenLength(aHeader));
+    otCoapHeaderSetPayloadMarker(&responseHeader);
+
+    responseMessage = otCoapNewMessage((otInstance*)aContext, &responseHeader);
+    otEXPECT_ACTION(responseMessage != NULL, error = OT_ERROR_NO_BUFS);
+
+    error = otMessageAppend(responseMessage, attrPoll, strlen(attrPoll));
+    otEXPECT(OT_ERROR_NONE == error);
+
+    error = otCoapSendResponse((otInstance*)aContext, responseMessage,
+                               aMessageInfo);
+    otEXPECT(OT_ERROR_NONE == error);
+
+exit:
+
+    if(error != OT_ERROR_NONE && responseMessage != NULL)
+    {
+        otMessageFree(responseMessage);
+    }
+}
+
+/**
+ * @brief Adds a resource to the coap server.
+ *
+ * @param aInstance A pointer to the context information.
+ * @param aResource Resource to add.
+ * @param aUriPath  URI of the resource.
+ * @param aHandler  Handler of the requests to it.
+ *
+ * @return OT_ERROR_NONE if successful, else error code
+ */
+static otError setupResource(otInstance *aInstance, otCoapResource *aResource,
+                             const char *aUriPath,
+                             otCoapRequestHandler aHandler)
+{
+    otError error;
+
+    aResource->mHandler = aHandler;
+    aResource->mUriPath = aUriPath;
+    aResource->mContext = aInstance;
+
+    OtRtosApi_lock();
+    error = otCoapAddResource(aInstance, aResource);
+    OtRtosApi_unlock();
+
+    return error;
+}
+
 /**
  * @brief sets up the application coap server.
  *
@@ -460,6 +701,12 @@ static int processEvents(void)
         {
             serverSetup = true;
             (void)setupCoapServer(OtInstance_get(), &coapAttr);
+            (void)setupResource(OtInstance_get(), &coapResourceEnergy,
+                                REEDSWITCH_ENERGY_URI, &coapHandleEnergy);
+            (void)setupResource(OtInstance_get(), &coapResourcePoll,
+                                REEDSWITCH_POLL_URI, &coapHandlePoll);
+            (void)OtStack_setupCoreLinks(coreLinks,
+                                         sizeof(coreLinks) / sizeof(coreLinks[0]));
 
             DISPUTILS_SERIALPRINTF(1, 0, "CoAP server setup done");
 #ifdef TIOP_POWER_DATA_ACK
@@ -537,10 +784,18 @@ static void resetPriority(void)
  */
 void otPlatLog(otLogLevel aLogLevel, otLogRegion aLogRegion, const char *aFormat, ...)
 {
+#if DLOG_ENABLE
+    va_list ap;
+
+    va_start(ap, aFormat);
+    DLog_vprintf((uint8_t)aLogLevel, (uint8_t)aLogRegion, aFormat, ap);
+    va_end(ap);
+#else
     (void)aLogLevel;
     (void)aLogRegion;
     (void)aFormat;
     /* Do nothing. */
+#endif
 }
 #endif
 
@@ -15,6 +15,12 @@ extern "C"
 
 #define THERMOSTAT_TEMP_URI     "thermostat/temperature"
 
+/* Energy counters of the reed switch, a POST clears them */
+#define REEDSWITCH_ENERGY_URI     "door/energy"
+
+/* Data poll policy of the reed switch, a POST sets it */
+#define REEDSWITCH_POLL_URI       "door/poll"
+
 #ifndef THERMOSTAT_ADDRESS_LSB
 #define THERMOSTAT_ADDRESS_LSB  7
 #endif
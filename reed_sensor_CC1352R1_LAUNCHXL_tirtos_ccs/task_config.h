@@ -83,6 +83,13 @@ extern "C"
 #define TASK_CONFIG_REEDSWITCH_TASK_STACK_SIZE 2048
 #endif
 
+/**
+ * Size of the deferred log task call stack.
+ */
+#ifndef TASK_CONFIG_DLOG_TASK_STACK_SIZE
+#define TASK_CONFIG_DLOG_TASK_STACK_SIZE    768
+#endif
+
 /******************************************************************************
  External functions
  *****************************************************************************/
@@ -97,6 +104,11 @@ extern void OtStack_taskCreate(void);
  */
 extern void ReedSwitch_taskCreate(void);
 
+/**
+ * Create function for the deferred log task, it runs at the lowest priority.
+ */
+extern void DLog_taskCreate(void);
+
 #ifdef __cplusplus
 }
 #endif
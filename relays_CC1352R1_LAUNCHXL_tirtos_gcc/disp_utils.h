@@ -51,6 +51,8 @@
 /* TIRTOS specific driver header files */
 #include <ti/display/Display.h>
 
+#include "dlog.h"
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -65,10 +67,15 @@ extern Display_Handle lcdHandle;
 extern Display_Handle serialHandle;
 
 /**
- * Printf functions for the serial interface.
+ * Printf functions for the serial interface. With the deferred log, each
+ * print is a log record and the line and column are not used.
  */
+#if DLOG_ENABLE
+#define DISPUTILS_SERIALPRINTF(line, col, ...) DLog_printf(__VA_ARGS__)
+#else
 #define DISPUTILS_SERIALPRINTF(...) do { if(serialHandle) \
                                            Display_printf(serialHandle, __VA_ARGS__ ); } while (0)
+#endif
 /**
  * Printf function for the lcd interface.
  */
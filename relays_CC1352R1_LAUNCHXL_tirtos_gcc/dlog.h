@@ -0,0 +1,111 @@
+/******************************************************************************
+
+ @file dlog.h
+
+ @brief Deferred binary logging
+
+ PR Sensor Networks, TU Berlin
+
+ *****************************************************************************/
+#ifndef DLOG_H
+#define DLOG_H
+/******************************************************************************
+ Includes
+ *****************************************************************************/
+#include <stdarg.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************
+ Constants and Macro Definitions
+ *****************************************************************************/
+
+/**
+ * Route the serial prints through the deferred log. The log owns the UART
+ * and sends binary records, decode them with dlog_host/dlogdecode.py. Set
+ * to 0 to print text through the serial display as before.
+ */
+#ifndef DLOG_ENABLE
+#define DLOG_ENABLE         1
+#endif
+
+/**
+ * Size of the RAM ring the records wait in, a power of 2.
+ */
+#ifndef DLOG_RINGSIZE
+#define DLOG_RINGSIZE       1024
+#endif
+
+/**
+ * Longest record, arguments past it are left out.
+ */
+#ifndef DLOG_MAXRECORD
+#define DLOG_MAXRECORD      64
+#endif
+
+/**
+ * Longest %s argument kept, in characters.
+ */
+#ifndef DLOG_MAXSTRING
+#define DLOG_MAXSTRING      16
+#endif
+
+/**
+ * Baud rate of the UART the records are sent on.
+ */
+#ifndef DLOG_BAUD_RATE
+#define DLOG_BAUD_RATE      115200
+#endif
+
+/**
+ * Region of the records logged by the application, the ones from
+ * otPlatLog() carry the OpenThread region.
+ */
+#define DLOG_REGION_APP     0xFF
+
+/******************************************************************************
+ External Functions
+ *****************************************************************************/
+
+/**
+ * @brief Log a record with the format and its arguments. The format is not
+ *        expanded here: its address and the raw arguments are copied into
+ *        the ring, and the log task sends them later at the lowest
+ *        priority. Never blocks and may be called from any context. The
+ *        record is dropped if the ring is full.
+ *
+ *        The format must be a string literal, its address is what the
+ *        decoder looks up in the firmware image. Integers are kept up to
+ *        32 bits, %ll up to 64, in as few bytes as their value needs.
+ *        Floating point is kept as double. Strings are copied, up to
+ *        DLOG_MAXSTRING characters.
+ *
+ * @param aFormat printf style format
+ *
+ * @return None
+ */
+extern void DLog_printf(const char *aFormat, ...);
+
+/**
+ * @brief Log a record with an OpenThread level and region, see
+ *        DLog_printf().
+ *
+ * @param aLevel  log level
+ * @param aRegion log region, DLOG_REGION_APP for the application
+ * @param aFormat printf style format
+ * @param aArgs   arguments of the format
+ *
+ * @return None
+ */
+extern void DLog_vprintf(uint8_t aLevel, uint8_t aRegion, const char *aFormat,
+                         va_list aArgs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DLOG_H */
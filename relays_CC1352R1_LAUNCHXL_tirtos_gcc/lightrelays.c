@@ -53,15 +53,20 @@
 /* Standard Library Header files */
 #include <assert.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /* OpenThread public API Header files */
 #include <openthread/coap.h>
+#include <openthread/ip6.h>
 #include <openthread/link.h>
 #include <openthread/platform/logging.h>
+#include <openthread/platform/random.h>
 #include <openthread/platform/uart.h>
 
 /* TIRTOS specific header files */
+#include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Event.h>
 #include <ti/sysbios/BIOS.h>
 
@@ -99,11 +104,25 @@
  Constants and definitions
  *****************************************************************************/
 
-#define LAMPPIN    PINCC26XX_DIO3
-
 #define PIN_ON  1
 #define PIN_OFF 0
 
+/* channels of the bank, bit n of a mask for channel n, up to 32 */
+#define CHANNEL_COUNT (sizeof(channelPins) / sizeof(channelPins[0]))
+#define CHANNELS_ALL  (0xFFFFFFFFUL >> (32 - CHANNEL_COUNT))
+
+/* bank command and report, "<channels> 0x<state> 0x<target>" */
+#define BANK_MAX_CHARS 40
+
+/* longest text of an IPv6 address, with its terminating NUL */
+#define ZONE_MAX_CHARS 40
+
+/* longest zone list, the addresses with a ',' after each */
+#define ZONES_MAX_CHARS (LIGHTRELAYS_MAX_ZONES * ZONE_MAX_CHARS)
+
+/* group command acknowledgement, "<sequence number> <state>" */
+#define GROUP_ACK_MAX_CHARS 24
+
 /* read attribute */
 #define ATTR_READ     0x01
 /* write attribute */
@@ -148,13 +167,52 @@ const attrDesc_t coapAttr = {
     attrState,
 };
 
+static const PIN_Id channelPins[] = { LIGHTRELAYS_CHANNEL_PINS };
+
 static PIN_State relaysPinState;
 static PIN_Handle handleRelaysPin;
-static PIN_Config relaysPinTable[] = {
-                                      LAMPPIN | PINCC26XX_GPIO_OUTPUT_EN | PINCC26XX_GPIO_HIGH,
-                                    PIN_TERMINATE
-                                };
+static PIN_Config relaysPinTable[CHANNEL_COUNT + 1];
+
+/* coap resource of the channel bank */
+static otCoapResource coapResourceBank;
+
+/* channels switched on, as driven and as the last command wants them */
+static uint32_t bankState;
+static uint32_t bankTarget;
 
+/* step between the channels of the command under way, 0 for none */
+static uint32_t bankStepTicks;
+static Clock_Struct bankStepClkStruct;
+
+
+/* resources listed in /.well-known/core */
+static const OtStack_CoreLink coreLinks[] = {
+    { LIGHTRELAYS_STATE_URI, ";rt=\"lamp.state\";if=\"core.a\";ct=0" },
+    { LIGHTRELAYS_GROUP_URI, ";rt=\"lamp.group\";if=\"core.a\";ct=0" },
+    { LIGHTRELAYS_ZONES_URI, ";rt=\"lamp.zones\";if=\"core.p\";ct=0" },
+    { LIGHTRELAYS_BANK_URI, ";rt=\"lamp.bank\";if=\"core.a\";ct=0" },
+};
+
+/* coap resources of the group commands and of the zones */
+static otCoapResource coapResourceGroup;
+static otCoapResource coapResourceZones;
+
+/* zone multicast groups the relay is in, and their text as set */
+static otIp6Address zoneAddresses[LIGHTRELAYS_MAX_ZONES];
+static uint8_t zoneCount;
+static char attrZones[ZONES_MAX_CHARS];
+
+/* sequence number of the last group command applied */
+static uint32_t groupSeq;
+static bool groupSeqValid;
+
+/* acknowledgement of a group command sent to a zone, held for the leisure */
+static otMessageInfo groupAckInfo;
+static uint8_t groupAckToken[OT_COAP_MAX_TOKEN_LENGTH];
+static uint8_t groupAckTokenLength;
+static uint16_t groupAckMessageId;
+static bool groupAckPending;
+static Clock_Struct groupAckClkStruct;
 
 /* Holds the server setup state: True indicates CoAP server has been setup */
 static bool serverSetup;
@@ -258,6 +316,514 @@ exit:
     }
 }
 
+/**
+ * @brief Appends the state of the relay, as an acknowledgement of a group
+ *        command: "<sequence number> <state>".
+ *
+ * @param aMessage message to append to.
+ * @return OT_ERROR_NONE if successful, else error code
+ */
+static otError appendGroupAck(otMessage *aMessage)
+{
+    char ack[GROUP_ACK_MAX_CHARS];
+    int length;
+
+    length = snprintf(ack, sizeof(ack), "%lu %s", (unsigned long)groupSeq,
+                      (const char *)attrState);
+
+    return otMessageAppend(aMessage, ack, (uint16_t)length);
+}
+
+/**
+ * @brief Sends the acknowledgement of a group command.
+ *
+ * @param aInstance     A pointer to the OpenThread instance.
+ * @param aType         ACK piggybacked on a CON, NON otherwise.
+ * @param aMessageId    message id of the request.
+ * @param aToken        token of the request.
+ * @param aTokenLength  length of the token.
+ * @param aMessageInfo  where the request came from.
+ * @return OT_ERROR_NONE if successful, else error code
+ */
+static otError sendGroupAck(otInstance *aInstance, otCoapType aType,
+                            uint16_t aMessageId, const uint8_t *aToken,
+                            uint8_t aTokenLength,
+                            const otMessageInfo *aMessageInfo)
+{
+    otError error = OT_ERROR_NONE;
+    otCoapHeader responseHeader;
+    otMessage *responseMessage = NULL;
+
+    otCoapHeaderInit(&responseHeader, aType, OT_COAP_CODE_CHANGED);
+    otCoapHeaderSetMessageId(&responseHeader, aMessageId);
+    otCoapHeaderSetToken(&responseHeader, aToken, aTokenLength);
+    otCoapHeaderSetPayloadMarker(&responseHeader);
+
+    responseMessage = otCoapNewMessage(aInstance, &responseHeader);
+    otEXPECT_ACTION(responseMessage != NULL, error = OT_ERROR_NO_BUFS);
+    error = appendGroupAck(responseMessage);
+    otEXPECT(OT_ERROR_NONE == error);
+
+    error = otCoapSendResponse(aInstance, responseMessage, aMessageInfo);
+
+exit:
+
+    if (error != OT_ERROR_NONE && responseMessage != NULL)
+    {
+        otMessageFree(responseMessage);
+    }
+    return error;
+}
+
+/**
+ * @brief Clock callback, the leisure of a group acknowledgement is over.
+ *
+ * @param  a0      Argument passed by the clock if set up.
+ *
+ * @return None
+ */
+static void groupAckTimeoutCB(UArg a0)
+{
+    Lightrelays_postEvt(Lightrelays_evtGroupAck);
+}
+
+/**
+ * @brief Callback function registered with the Coap server.
+ *        Processes the group commands, POST "<sequence number> on|off".
+ *        A command only applies if its number is past the last one
+ *        applied, so retries and late copies never undo a newer command.
+ *        Every command is answered with the state and the number it comes
+ *        from. Sent to a zone, the answer is a NON after a random leisure.
+ *
+ * @param  aContext      A pointer to the context information.
+ * @param  aHeader       A pointer to the CoAP header.
+ * @param  aMessage      A pointer to the message.
+ * @param  aMessageInfo  A pointer to the message info.
+ *
+ * @return None
+ */
+static void coapHandleGroup(void *aContext, otCoapHeader *aHeader,
+                            otMessage *aMessage,
+                            const otMessageInfo *aMessageInfo)
+{
+    char data[32];
+    char *state;
+    uint32_t seq;
+    uint16_t read;
+
+    otEXPECT(OT_COAP_CODE_POST == otCoapHeaderGetCode(aHeader));
+
+    read = otMessageRead(aMessage, otMessageGetOffset(aMessage), data,
+                         sizeof(data) - 1);
+    data[read] = '\0';
+    seq = strtoul(data, &state, 10);
+    otEXPECT(state != data && *state == ' ');
+    state++;
+    otEXPECT(strcmp(LIGHTRELAYS_STATE_ON, state) == 0 ||
+             strcmp(LIGHTRELAYS_STATE_OFF, state) == 0);
+
+    if (!groupSeqValid || (int32_t)(seq - groupSeq) > 0)
+    {
+        groupSeq = seq;
+        groupSeqValid = true;
+        strcpy((char *)attrState, state);
+        Lightrelays_postEvt((strcmp(LIGHTRELAYS_STATE_ON, state) == 0) ?
+                            Lightrelays_evtOn : Lightrelays_evtOff);
+    }
+
+    if (aMessageInfo->mSockAddr.mFields.m8[0] == 0xff)
+    {
+        uint32_t leisure = otPlatRandomGet() % (LIGHTRELAYS_GROUP_LEISURE_MS + 1);
+        uint32_t ticks = (leisure * 1000) / Clock_tickPeriod;
+
+        /* a newer command to a zone replaces the answer still held */
+        groupAckInfo = *aMessageInfo;
+        memset(&groupAckInfo.mSockAddr, 0, sizeof(groupAckInfo.mSockAddr));
+        groupAckTokenLength = otCoapHeaderGetTokenLength(aHeader);
+        memcpy(groupAckToken, otCoapHeaderGetToken(aHeader),
+               groupAckTokenLength);
+        groupAckMessageId = otCoapHeaderGetMessageId(aHeader);
+        groupAckPending = true;
+
+        Clock_stop(Clock_handle(&groupAckClkStruct));
+        Clock_setTimeout(Clock_handle(&groupAckClkStruct),
+                         (ticks > 0) ? ticks : 1);
+        Clock_start(Clock_handle(&groupAckClkStruct));
+    }
+    else
+    {
+        (void)sendGroupAck((otInstance*)aContext,
+                           (OT_COAP_TYPE_CONFIRMABLE == otCoapHeaderGetType(aHeader)) ?
+                           OT_COAP_TYPE_ACKNOWLEDGMENT : OT_COAP_TYPE_NON_CONFIRMABLE,
+                           otCoapHeaderGetMessageId(aHeader),
+                           otCoapHeaderGetToken(aHeader),
+                           otCoapHeaderGetTokenLength(aHeader), aMessageInfo);
+    }
+
+exit:
+    return;
+}
+
+/**
+ * @brief Sets the zone multicast groups of the relay from a list of
+ *        addresses, separated by ',' or ' '. Nothing changes if one of
+ *        them is not a multicast address.
+ *
+ * @param aInstance A pointer to the OpenThread instance.
+ * @param aList     the list, changed while parsed.
+ * @return OT_ERROR_NONE, OT_ERROR_INVALID_ARGS for a bad list, or the error
+ *         subscribing.
+ */
+static otError setZones(otInstance *aInstance, char *aList)
+{
+    otError error = OT_ERROR_NONE;
+    otIp6Address addresses[LIGHTRELAYS_MAX_ZONES];
+    uint8_t count = 0;
+    uint8_t i;
+    char *next = aList;
+
+    while (*(next += strspn(next, ", ")) != '\0')
+    {
+        size_t length = strcspn(next, ", ");
+        bool last = (next[length] == '\0');
+
+        next[length] = '\0';
+        otEXPECT_ACTION(count < LIGHTRELAYS_MAX_ZONES,
+                        error = OT_ERROR_INVALID_ARGS);
+        otEXPECT_ACTION(otIp6AddressFromString(next, &addresses[count]) ==
+                        OT_ERROR_NONE && addresses[count].mFields.m8[0] == 0xff,
+                        error = OT_ERROR_INVALID_ARGS);
+        count++;
+        next += last ? length : length + 1;
+    }
+
+    for (i = 0; i < zoneCount; i++)
+    {
+        (void)otIp6UnsubscribeMulticastAddress(aInstance, &zoneAddresses[i]);
+    }
+    zoneCount = 0;
+    attrZones[0] = '\0';
+
+    for (i = 0; i < count && OT_ERROR_NONE == error; i++)
+    {
+        error = otIp6SubscribeMulticastAddress(aInstance, &addresses[i]);
+        if (OT_ERROR_NONE == error)
+        {
+            zoneAddresses[zoneCount++] = addresses[i];
+        }
+    }
+
+    /* the list as set, or as far as it could be */
+    next = aList;
+    for (i = 0; i < zoneCount; i++)
+    {
+        next += strspn(next, ", ");
+        if (i > 0)
+        {
+            strcat(attrZones, ",");
+        }
+        strcat(attrZones, next);
+        next += strlen(next) + 1;
+    }
+
+exit:
+    return error;
+}
+
+/**
+ * @brief Callback function registered with the Coap server.
+ *        GET lists the zone multicast groups of the relay, POST sets them.
+ *
+ * @param  aContext      A pointer to the context information.
+ * @param  aHeader       A pointer to the CoAP header.
+ * @param  aMessage      A pointer to the message.
+ * @param  aMessageInfo  A pointer to the message info.
+ *
+ * @return None
+ */
+static void coapHandleZones(void *aContext, otCoapHeader *aHeader,
+                            otMessage *aMessage,
+                            const otMessageInfo *aMessageInfo)
+{
+    otError error = OT_ERROR_NONE;
+    otCoapHeader responseHeader;
+    otMessage *responseMessage = NULL;
+    otCoapCode responseCode = OT_COAP_CODE_CONTENT;
+    otCoapCode messageCode = otCoapHeaderGetCode(aHeader);
+
+    if (OT_COAP_CODE_POST == messageCode)
+    {
+        char data[ZONES_MAX_CHARS];
+        uint16_t read;
+
+        read = otMessageRead(aMessage, otMessageGetOffset(aMessage), data,
+                             sizeof(data) - 1);
+        data[read] = '\0';
+
+        switch (setZones((otInstance*)aContext, data))
+        {
+        case OT_ERROR_NONE:
+            responseCode = OT_COAP_CODE_CHANGED;
+            break;
+        case OT_ERROR_INVALID_ARGS:
+            responseCode = OT_COAP_CODE_BAD_REQUEST;
+            break;
+        default:
+            responseCode = OT_COAP_CODE_INTERNAL_ERROR;
+            break;
+        }
+    }
+    else if (OT_COAP_CODE_GET != messageCode)
+    {
+        responseCode = OT_COAP_CODE_METHOD_NOT_ALLOWED;
+    }
+
+    otCoapHeaderInit(&responseHeader,
+                     (OT_COAP_TYPE_CONFIRMABLE == otCoapHeaderGetType(aHeader)) ?
+                     OT_COAP_TYPE_ACKNOWLEDGMENT : OT_COAP_TYPE_NON_CONFIRMABLE,
+                     responseCode);
+    otCoapHeaderSetMessageId(&responseHeader, otCoapHeaderGetMessageId(aHeader));
+    otCoapHeaderSetToken(&responseHeader, otCoapHeaderGetToken(aHeader),
+                         otCoapHeaderGetTokenLength(aHeader));
+    otCoapHeaderSetPayloadMarker(&responseHeader);
+
+    responseMessage = otCoapNewMessage((otInstance*)aContext, &responseHeader);
+    otEXPECT_ACTION(responseMessage != NULL, error = OT_ERROR_NO_BUFS);
+    error = otMessageAppend(responseMessage, attrZones, strlen(attrZones));
+    otEXPECT(OT_ERROR_NONE == error);
+
+    error = otCoapSendResponse((otInstance*)aContext, responseMessage,
+                               aMessageInfo);
+
+exit:
+
+    if (error != OT_ERROR_NONE && responseMessage != NULL)
+    {
+        otMessageFree(responseMessage);
+    }
+}
+
+/**
+ * @brief Drives the channels of the bank, all with one port update.
+ *        Called with the OpenThread lock held, which serializes the bank.
+ *
+ * @param aState channels to switch on.
+ * @return None
+ */
+static void bankWrite(uint32_t aState)
+{
+    uint32_t port = 0;
+    uint8_t i;
+
+    for (i = 0; i < CHANNEL_COUNT; i++)
+    {
+        /* the relays are active low */
+        uint32_t level = (aState & (1UL << i)) ? PIN_OFF : PIN_ON;
+
+        port |= level << channelPins[i];
+    }
+    (void)PIN_setPortOutputValue(handleRelaysPin, port);
+
+    bankState = aState;
+    strcpy((char *)attrState, (aState != 0) ? LIGHTRELAYS_STATE_ON :
+                                              LIGHTRELAYS_STATE_OFF);
+}
+
+/**
+ * @brief Moves the bank towards its target: all channels at once, or with
+ *        a step, the lowest channel that differs and the next one a step
+ *        later. Called with the OpenThread lock held.
+ *
+ * @return None
+ */
+static void bankStep(void)
+{
+    uint32_t differ = bankState ^ bankTarget;
+
+    if (0 == bankStepTicks)
+    {
+        bankWrite(bankTarget);
+    }
+    else if (differ != 0)
+    {
+        bankWrite(bankState ^ (differ & (~differ + 1)));
+        if (bankState != bankTarget)
+        {
+            Clock_setTimeout(Clock_handle(&bankStepClkStruct), bankStepTicks);
+            Clock_start(Clock_handle(&bankStepClkStruct));
+        }
+    }
+}
+
+/**
+ * @brief Sets the channels the bank goes to, replacing a command still
+ *        under way. Called with the OpenThread lock held.
+ *
+ * @param aTarget channels to switch on.
+ * @param aStepMs step between the channels in ms, 0 to switch them at once.
+ * @return None
+ */
+static void bankSet(uint32_t aTarget, uint32_t aStepMs)
+{
+    uint32_t ticks = (aStepMs * 1000) / Clock_tickPeriod;
+
+    Clock_stop(Clock_handle(&bankStepClkStruct));
+    bankTarget = aTarget & CHANNELS_ALL;
+    bankStepTicks = (aStepMs > 0 && ticks == 0) ? 1 : ticks;
+    bankStep();
+}
+
+/**
+ * @brief Clock callback, the step of a sequenced bank command is over.
+ *
+ * @param  a0      Argument passed by the clock if set up.
+ *
+ * @return None
+ */
+static void bankStepTimeoutCB(UArg a0)
+{
+    Lightrelays_postEvt(Lightrelays_evtBankStep);
+}
+
+/**
+ * @brief Parses a bank command, "<mask> <values> [<step ms>]", the numbers
+ *        in C notation. The channels of the mask are set to their bits in
+ *        values, the others kept.
+ *
+ * @param aData   the command.
+ * @param aMask   channels to set.
+ * @param aValues their values.
+ * @param aStepMs step between them in ms, 0 if none is given.
+ * @return true if the command is valid
+ */
+static bool bankParse(const char *aData, uint32_t *aMask, uint32_t *aValues,
+                      uint32_t *aStepMs)
+{
+    bool valid = false;
+    const char *field = aData;
+    char *end;
+
+    *aMask = strtoul(field, &end, 0);
+    otEXPECT(end != field && *aMask != 0 && (*aMask & ~CHANNELS_ALL) == 0);
+    field = end;
+    *aValues = strtoul(field, &end, 0);
+    otEXPECT(end != field);
+    field = end;
+    *aStepMs = strtoul(field, &end, 0);
+    otEXPECT(*aStepMs <= LIGHTRELAYS_MAX_STEP_MS);
+    otEXPECT(end[strspn(end, " ")] == '\0');
+    valid = true;
+
+exit:
+    return valid;
+}
+
+/**
+ * @brief Callback function registered with the Coap server.
+ *        POST applies a bank command, GET reads the bank. Both answer
+ *        with one report of all channels, "<channels> 0x<state> 0x<target>",
+ *        the state as driven once the request is applied.
+ *
+ * @param  aContext      A pointer to the context information.
+ * @param  aHeader       A pointer to the CoAP header.
+ * @param  aMessage      A pointer to the message.
+ * @param  aMessageInfo  A pointer to the message info.
+ *
+ * @return None
+ */
+static void coapHandleBank(void *aContext, otCoapHeader *aHeader,
+                           otMessage *aMessage,
+                           const otMessageInfo *aMessageInfo)
+{
+    otError error = OT_ERROR_NONE;
+    otCoapHeader responseHeader;
+    otMessage *responseMessage = NULL;
+    otCoapCode responseCode = OT_COAP_CODE_CONTENT;
+    otCoapCode messageCode = otCoapHeaderGetCode(aHeader);
+    char data[BANK_MAX_CHARS];
+    int length;
+
+    if (OT_COAP_CODE_POST == messageCode)
+    {
+        uint32_t mask;
+        uint32_t values;
+        uint32_t stepMs;
+        uint16_t read;
+
+        read = otMessageRead(aMessage, otMessageGetOffset(aMessage), data,
+                             sizeof(data) - 1);
+        data[read] = '\0';
+
+        if (bankParse(data, &mask, &values, &stepMs))
+        {
+            bankSet((bankTarget & ~mask) | (values & mask), stepMs);
+            responseCode = OT_COAP_CODE_CHANGED;
+        }
+        else
+        {
+            responseCode = OT_COAP_CODE_BAD_REQUEST;
+        }
+    }
+    else if (OT_COAP_CODE_GET != messageCode)
+    {
+        responseCode = OT_COAP_CODE_METHOD_NOT_ALLOWED;
+    }
+
+    otCoapHeaderInit(&responseHeader,
+                     (OT_COAP_TYPE_CONFIRMABLE == otCoapHeaderGetType(aHeader)) ?
+                     OT_COAP_TYPE_ACKNOWLEDGMENT : OT_COAP_TYPE_NON_CONFIRMABLE,
+                     responseCode);
+    otCoapHeaderSetMessageId(&responseHeader, otCoapHeaderGetMessageId(aHeader));
+    otCoapHeaderSetToken(&responseHeader, otCoapHeaderGetToken(aHeader),
+                         otCoapHeaderGetTokenLength(aHeader));
+    otCoapHeaderSetPayloadMarker(&responseHeader);
+
+    responseMessage = otCoapNewMessage((otInstance*)aContext, &responseHeader);
+    otEXPECT_ACTION(responseMessage != NULL, error = OT_ERROR_NO_BUFS);
+    length = snprintf(data, sizeof(data), "%u 0x%lx 0x%lx",
+                      (unsigned)CHANNEL_COUNT, (unsigned long)bankState,
+                      (unsigned long)bankTarget);
+    error = otMessageAppend(responseMessage, data, (uint16_t)length);
+    otEXPECT(OT_ERROR_NONE == error);
+
+    error = otCoapSendResponse((otInstance*)aContext, responseMessage,
+                               aMessageInfo);
+
+exit:
+
+    if (error != OT_ERROR_NONE && responseMessage != NULL)
+    {
+        otMessageFree(responseMessage);
+    }
+}
+
+/**
+ * @brief Adds a resource to the coap server.
+ *
+ * @param aInstance A pointer to the context information.
+ * @param aResource Resource to add.
+ * @param aUriPath  URI of the resource.
+ * @param aHandler  Handler of the requests to it.
+ *
+ * @return OT_ERROR_NONE if successful, else error code
+ */
+static otError setupResource(otInstance *aInstance, otCoapResource *aResource,
+                             const char *aUriPath,
+                             otCoapRequestHandler aHandler)
+{
+    otError error;
+
+    aResource->mHandler = aHandler;
+    aResource->mUriPath = aUriPath;
+    aResource->mContext = aInstance;
+
+    OtRtosApi_lock();
+    error = otCoapAddResource(aInstance, aResource);
+    OtRtosApi_unlock();
+
+    return error;
+}
+
 /**
  * @brief sets up the application coap server.
  *
@@ -358,6 +924,7 @@ static void processEvents(void)
 {
     UInt events = Event_pend(Event_handle(&lightrelaysEvents), Event_Id_NONE,
                              (Lightrelays_evtOn | Lightrelays_evtOff |
+                              Lightrelays_evtGroupAck | Lightrelays_evtBankStep |
                               Lightrelays_evtNwkSetup | Lightrelays_evtKeyLeft |
                               Lightrelays_evtKeyRight | Lightrelays_evtNwkJoined |
                               Lightrelays_evtNwkJoinFailure),
@@ -367,24 +934,56 @@ static void processEvents(void)
     {
         /* perform activity related to the lightrelays open event. */
         DISPUTILS_SERIALPRINTF( 0, 0, "Lightrelays Lamp On received");
-        PIN_setOutputValue(handleRelaysPin, LAMPPIN, PIN_OFF);
+        OtRtosApi_lock();
+        bankSet(CHANNELS_ALL, 0);
+        OtRtosApi_unlock();
         // DispUtils_lcdDraw(&Images_lightrelaysOpen);
     }
 
     if (events & Lightrelays_evtOff)
     {
         /* perform activity related to the lightrelays closed event */
-        PIN_setOutputValue(handleRelaysPin, LAMPPIN, PIN_ON);
+        OtRtosApi_lock();
+        bankSet(0, 0);
+        OtRtosApi_unlock();
         DISPUTILS_SERIALPRINTF( 0, 0, "Lightrelays Lamp Off Event received");
         // DispUtils_lcdDraw(&Images_lightrelaysClosed);
     }
 
+    if (events & Lightrelays_evtGroupAck)
+    {
+        OtRtosApi_lock();
+        if (groupAckPending)
+        {
+            groupAckPending = false;
+            (void)sendGroupAck(OtInstance_get(), OT_COAP_TYPE_NON_CONFIRMABLE,
+                               groupAckMessageId, groupAckToken,
+                               groupAckTokenLength, &groupAckInfo);
+        }
+        OtRtosApi_unlock();
+    }
+
+    if (events & Lightrelays_evtBankStep)
+    {
+        OtRtosApi_lock();
+        bankStep();
+        OtRtosApi_unlock();
+    }
+
     if (events & Lightrelays_evtNwkSetup)
     {
         if (false == serverSetup)
         {
             serverSetup = true;
             (void)setupCoapServer(OtInstance_get(), &coapAttr);
+            (void)setupResource(OtInstance_get(), &coapResourceGroup,
+                                LIGHTRELAYS_GROUP_URI, &coapHandleGroup);
+            (void)setupResource(OtInstance_get(), &coapResourceZones,
+                                LIGHTRELAYS_ZONES_URI, &coapHandleZones);
+            (void)setupResource(OtInstance_get(), &coapResourceBank,
+                                LIGHTRELAYS_BANK_URI, &coapHandleBank);
+            (void)OtStack_setupCoreLinks(coreLinks,
+                                         sizeof(coreLinks) / sizeof(coreLinks[0]));
 
             /* display unlock image on LCD */
             DISPUTILS_SERIALPRINTF(1, 0, "CoAP server setup done");
@@ -406,12 +1005,18 @@ static void processEvents(void)
 
     if (events & Lightrelays_evtKeyLeft)
     {
-        if (PIN_getOutputValue(LAMPPIN))
+        bool on;
+
+        /* the key switches channel 0 */
+        OtRtosApi_lock();
+        bankSet(bankTarget ^ 1UL, 0);
+        on = (bankState & 1UL) != 0;
+        OtRtosApi_unlock();
+
+        if (on)
         {
-            PIN_setOutputValue(handleRelaysPin, LAMPPIN, PIN_OFF);
             DISPUTILS_SERIALPRINTF(1, 0, "Switch lamp manually on");
         } else {
-            PIN_setOutputValue(handleRelaysPin, LAMPPIN, PIN_ON);
             DISPUTILS_SERIALPRINTF(1, 0, "Switch lamp manually off");
         }
     }
@@ -464,10 +1069,18 @@ static void resetPriority(void)
  */
 void otPlatLog(otLogLevel aLogLevel, otLogRegion aLogRegion, const char *aFormat, ...)
 {
+#if DLOG_ENABLE
+    va_list ap;
+
+    va_start(ap, aFormat);
+    DLog_vprintf((uint8_t)aLogLevel, (uint8_t)aLogRegion, aFormat, ap);
+    va_end(ap);
+#else
     (void)aLogLevel;
     (void)aLogRegion;
     (void)aFormat;
     /* Do nothing. */
+#endif
 }
 #endif
 
@@ -534,8 +1147,18 @@ void Lightrelays_taskCreate(void)
 void *Lightrelays_task(void *arg0)
 {
     bool commissioned;
+    Clock_Params clockParams;
+    uint8_t i;
+
     initEvent();
 
+    /* one-shot, started with the leisure of each group command */
+    Clock_Params_init(&clockParams);
+    Clock_construct(&groupAckClkStruct, groupAckTimeoutCB, 1, &clockParams);
+
+    /* one-shot, started for each step of a sequenced bank command */
+    Clock_construct(&bankStepClkStruct, bankStepTimeoutCB, 1, &clockParams);
+
     KeysUtils_initialize(processKeyChangeCB);
 
     OtStack_registerCallback(processOtStackEvents);
@@ -546,6 +1169,14 @@ void *Lightrelays_task(void *arg0)
 
     DISPUTILS_SERIALPRINTF(0, 0, "Lightrelays init!");
 
+    /* all channels off */
+    for (i = 0; i < CHANNEL_COUNT; i++)
+    {
+        relaysPinTable[i] = channelPins[i] | PINCC26XX_GPIO_OUTPUT_EN |
+                            PINCC26XX_GPIO_HIGH;
+    }
+    relaysPinTable[CHANNEL_COUNT] = PIN_TERMINATE;
+
     handleRelaysPin = PIN_open(&relaysPinState, relaysPinTable);
 
 #ifndef ALLOW_PRECOMMISSIONED_NETWORK_JOIN
@@ -65,6 +65,43 @@ extern "C"
 #define LIGHTRELAYS_STATE_OFF  "off"
 /** Lightrelays drawn state string */
 #define LIGHTRELAYS_STATE_DRAWN   "drawn"
+/** Lightrelays group command string, "<sequence number> on|off" */
+#define LIGHTRELAYS_GROUP_URI     "lamp/group"
+/** Lightrelays zone multicast groups string */
+#define LIGHTRELAYS_ZONES_URI     "lamp/zones"
+/** Lightrelays channel bank string, "<mask> <values> [<step ms>]" */
+#define LIGHTRELAYS_BANK_URI      "lamp/bank"
+
+/*
+ * Pins of the relay channels, channel 0 first. Each relay is driven active
+ * low. The channels are written together, with one port update, so the
+ * pins must be DIOs of the one port of the device.
+ */
+#ifndef LIGHTRELAYS_CHANNEL_PINS
+#define LIGHTRELAYS_CHANNEL_PINS PINCC26XX_DIO3
+#endif
+
+/*
+ * Longest step between the channels of a sequenced bank command, in ms.
+ * The step keeps the inrush currents of the loads apart.
+ */
+#ifndef LIGHTRELAYS_MAX_STEP_MS
+#define LIGHTRELAYS_MAX_STEP_MS 10000
+#endif
+
+/* Zone multicast groups a relay is in at once */
+#ifndef LIGHTRELAYS_MAX_ZONES
+#define LIGHTRELAYS_MAX_ZONES 4
+#endif
+
+/*
+ * Longest random wait before the acknowledgement of a group command sent
+ * to a zone, in ms, so that the relays of the zone do not all answer at
+ * once (the leisure of RFC 7252 section 8.2).
+ */
+#ifndef LIGHTRELAYS_GROUP_LEISURE_MS
+#define LIGHTRELAYS_GROUP_LEISURE_MS 500
+#endif
 
 
 /**
@@ -74,11 +111,13 @@ typedef enum
 {
     Lightrelays_evtOn           = Event_Id_00, /* Lightrelays openLock event */
     Lightrelays_evtOff         = Event_Id_01, /* Lightrelays closed event */
+    Lightrelays_evtGroupAck       = Event_Id_02, /* Group command leisure over */
     Lightrelays_evtNwkSetup       = Event_Id_03, /* openthread network is setup */
     Lightrelays_evtKeyLeft        = Event_Id_04, /* Left Key is pressed */
     Lightrelays_evtKeyRight       = Event_Id_05, /* Right key is pressed */
     Lightrelays_evtNwkJoined      = Event_Id_06, /* Joined the network */
-    Lightrelays_evtNwkJoinFailure = Event_Id_07  /* Failed joining network */
+    Lightrelays_evtNwkJoinFailure = Event_Id_07, /* Failed joining network */
+    Lightrelays_evtBankStep       = Event_Id_08  /* Next step of a bank command */
 
 } Lightrelays_evt_t;
 
@@ -59,10 +59,13 @@
 #include <ti/drivers/GPIO.h>
 #include <ti/drivers/ECJPAKE.h>
 #include <ti/drivers/AESECB.h>
+#include <ti/drivers/AESCCM.h>
 #include <ti/drivers/SHA2.h>
+#include <ti/drivers/TRNG.h>
 
 /* Example/Board Header files */
 #include "Board.h"
+#include "dlog.h"
 
 /* Private configuration Header files */
 #include "task_config.h"
@@ -94,8 +97,16 @@ int main(void)
 
     AESECB_init();
 
+    AESCCM_init();
+
     SHA2_init();
 
+    TRNG_init();
+
+#if DLOG_ENABLE
+    DLog_taskCreate();
+#endif
+
     Lightrelays_taskCreate();
 
     OtStack_taskCreate();
@@ -55,6 +55,7 @@ extern "C"
  Includes
  *****************************************************************************/
 #include <openthread/config.h>
+#include <openthread/instance.h>
 
 /******************************************************************************
  Typedefs
@@ -63,6 +64,15 @@ extern "C"
 /* OT Stack event Callback function typedef */
 typedef void (*OtStack_EventsCallback_t)(uint8_t events);
 
+/**
+ * A resource of the application as listed in /.well-known/core.
+ */
+typedef struct
+{
+    const char *uriPath;    /* URI of the resource */
+    const char *attributes; /* Link attributes, each after a ';' */
+} OtStack_CoreLink;
+
 /******************************************************************************
  Constants and definitions
  *****************************************************************************/
@@ -100,6 +110,22 @@ typedef void (*OtStack_EventsCallback_t)(uint8_t events);
 #define OT_STACK_IID_ADDRESS_LSB 3
 #endif
 
+/*
+ * Fills the interface identifier from the factory EUI-64, keeping
+ * OT_STACK_IID_ADDRESS_LSB as its last byte, so that devices of one kind
+ * get addresses of their own on the prefix. Off by default, the address
+ * then ends in the LSB alone.
+ */
+#ifndef OT_STACK_IID_FROM_EUI64
+#define OT_STACK_IID_FROM_EUI64 0
+#endif
+
+/* URI of the resource discovery */
+#define OT_STACK_CORE_URI ".well-known/core"
+
+/* Longest query filter of a discovery request */
+#define OT_STACK_CORE_QUERY_MAX_LENGTH 32
+
 /******************************************************************************
  External functions
  *****************************************************************************/
@@ -139,6 +165,20 @@ extern void OtStack_joinNetwork(const char* pskd);
  */
 bool OtStack_setupNetwork(void);
 
+/**
+ * @brief Serves /.well-known/core, the CoRE link format (RFC 6690) list of
+ *        the resources of the application. A query "<attribute>=<value>"
+ *        lists only the links that have it, a '*' ending the value matches
+ *        any rest. A multicast request that no link matches gets no
+ *        response. Call once the CoAP server is started.
+ *
+ * @param aLinks table of the resources, kept by the caller.
+ * @param aCount number of links in the table.
+ * @return OT_ERROR_NONE, or the error adding the resource.
+ */
+extern otError OtStack_setupCoreLinks(const OtStack_CoreLink *aLinks,
+                                      uint8_t aCount);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,278 @@
+/******************************************************************************
+
+ @file energy.c
+
+ @brief Time and charge spent in each power state of the radio and MCU
+
+ PR Sensor Networks, TU Berlin
+
+ *****************************************************************************/
+
+/******************************************************************************
+ Includes
+ *****************************************************************************/
+
+#include <openthread/config.h>
+
+/* Standard Library Header files */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* RTOS Header files */
+#include <ti/drivers/Power.h>
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/drivers/power/PowerCC26X2.h>
+
+#include "platform.h"
+
+/******************************************************************************
+ Constants and definitions
+ *****************************************************************************/
+
+/**
+ * Current the device draws in each state, in nA. The defaults are the
+ * typical figures of the CC1352R data sheet at 3.0 V: the 2.4 GHz radio
+ * receiving and sending at 0 dBm, the MCU running at 48 MHz, idle with the
+ * supply and RAM powered, and in standby with the RTC running and the RAM
+ * retained. The radio figures are for the whole device and replace the
+ * MCU's while the radio is on. Set them from measurements of the board and
+ * its transmit power for better estimates.
+ */
+#ifndef PLATFORM_ENERGY_RX_NA
+#define PLATFORM_ENERGY_RX_NA       6900000U
+#endif
+
+#ifndef PLATFORM_ENERGY_TX_NA
+#define PLATFORM_ENERGY_TX_NA       7100000U
+#endif
+
+#ifndef PLATFORM_ENERGY_ACTIVE_NA
+#define PLATFORM_ENERGY_ACTIVE_NA   2900000U
+#endif
+
+#ifndef PLATFORM_ENERGY_IDLE_NA
+#define PLATFORM_ENERGY_IDLE_NA     961000U
+#endif
+
+#ifndef PLATFORM_ENERGY_STANDBY_NA
+#define PLATFORM_ENERGY_STANDBY_NA  850U
+#endif
+
+/**
+ * Time on the air of the synchronization header and PHY header of an
+ * 802.15.4 frame, and of each byte of its PSDU, at 250 kbit/s.
+ */
+#define ENERGY_SHR_PHR_US           192U
+#define ENERGY_BYTE_US              32U
+
+/******************************************************************************
+ Local variables
+ *****************************************************************************/
+
+static const uint32_t Energy_currentNa[PlatformEnergy_stateCount] =
+{
+    [PlatformEnergy_rx]      = PLATFORM_ENERGY_RX_NA,
+    [PlatformEnergy_tx]      = PLATFORM_ENERGY_TX_NA,
+    [PlatformEnergy_active]  = PLATFORM_ENERGY_ACTIVE_NA,
+    [PlatformEnergy_idle]    = PLATFORM_ENERGY_IDLE_NA,
+    [PlatformEnergy_standby] = PLATFORM_ENERGY_STANDBY_NA,
+};
+
+/* us spent in each state since the counters were cleared */
+static uint64_t Energy_us[PlatformEnergy_stateCount];
+
+/* Time the current state was entered */
+static uint64_t Energy_last;
+
+/* MCU state, and whether the radio is on */
+static PlatformEnergy_State Energy_mcu = PlatformEnergy_active;
+static bool Energy_radioOn;
+
+static uint32_t Energy_txFrames;
+static uint32_t Energy_radioStarts;
+
+static bool Energy_started;
+
+static Power_NotifyObj Energy_notifyObj;
+
+/******************************************************************************
+ Local Functions
+ *****************************************************************************/
+
+/**
+ * @brief Adds the time since the last change to the state the device was
+ *        in. Called with interrupts disabled.
+ *
+ * @return None
+ */
+static void Energy_update(void)
+{
+    uint64_t now = platformAlarmGetNowUs();
+
+    if (Energy_started)
+    {
+        Energy_us[Energy_radioOn ? PlatformEnergy_rx : Energy_mcu] +=
+            now - Energy_last;
+    }
+    Energy_last = now;
+}
+
+/**
+ * @brief Changes the MCU state.
+ *
+ * @param aState new state of the MCU
+ *
+ * @return None
+ */
+static void Energy_setMcu(PlatformEnergy_State aState)
+{
+    uintptr_t key = HwiP_disable();
+
+    Energy_update();
+    Energy_mcu = aState;
+
+    HwiP_restore(key);
+}
+
+/**
+ * @brief Power policy run by the idle loop. Runs the policy of the board,
+ *        which idles or enters standby until the next interrupt, and
+ *        counts the time spent in it as idle.
+ *
+ * @return None
+ */
+static void Energy_policy(void)
+{
+    Energy_setMcu(PlatformEnergy_idle);
+    PowerCC26X2_config.policyFxn();
+    Energy_setMcu(PlatformEnergy_active);
+}
+
+/**
+ * @brief Power notification of the standby entry and exit, the part of
+ *        the idle time spent in standby.
+ *
+ * @param eventType PowerCC26XX_ENTERING_STANDBY or PowerCC26XX_AWAKE_STANDBY
+ * @param eventArg  unused
+ * @param clientArg unused
+ *
+ * @return Power_NOTIFYDONE
+ */
+static int_fast16_t Energy_standbyNotify(unsigned int eventType,
+                                         uintptr_t eventArg,
+                                         uintptr_t clientArg)
+{
+    (void)eventArg;
+    (void)clientArg;
+
+    Energy_setMcu((eventType == PowerCC26XX_ENTERING_STANDBY) ?
+                  PlatformEnergy_standby : PlatformEnergy_idle);
+
+    return (Power_NOTIFYDONE);
+}
+
+/******************************************************************************
+ External Functions
+ *****************************************************************************/
+
+/**
+ * Function documented in platform.h
+ */
+void platformEnergyInit(void)
+{
+    uintptr_t key = HwiP_disable();
+
+    Energy_update();
+    Energy_started = true;
+
+    HwiP_restore(key);
+
+    Power_registerNotify(&Energy_notifyObj,
+                         PowerCC26XX_ENTERING_STANDBY | PowerCC26XX_AWAKE_STANDBY,
+                         Energy_standbyNotify, 0);
+    Power_setPolicy(Energy_policy);
+}
+
+/**
+ * Function documented in platform.h
+ */
+void platformEnergyRadioOn(bool aOn)
+{
+    uintptr_t key = HwiP_disable();
+
+    Energy_update();
+    if (aOn && !Energy_radioOn)
+    {
+        Energy_radioStarts++;
+    }
+    Energy_radioOn = aOn;
+
+    HwiP_restore(key);
+}
+
+/**
+ * Function documented in platform.h
+ */
+void platformEnergyRadioTx(uint16_t aLength)
+{
+    uint32_t  us = ENERGY_SHR_PHR_US + ((uint32_t)aLength * ENERGY_BYTE_US);
+    uintptr_t key = HwiP_disable();
+
+    /* The frame was counted as receive time while the radio was on */
+    Energy_update();
+    if (Energy_us[PlatformEnergy_rx] < us)
+    {
+        us = (uint32_t)Energy_us[PlatformEnergy_rx];
+    }
+    Energy_us[PlatformEnergy_rx] -= us;
+    Energy_us[PlatformEnergy_tx] += us;
+    Energy_txFrames++;
+
+    HwiP_restore(key);
+}
+
+/**
+ * Function documented in platform.h
+ */
+void platformEnergyGetStats(PlatformEnergy_Stats *aStats)
+{
+    uint64_t  us[PlatformEnergy_stateCount];
+    uint64_t  chargePc = 0;
+    uint64_t  totalMs = 0;
+    uintptr_t key = HwiP_disable();
+    int       i;
+
+    Energy_update();
+    memcpy(us, Energy_us, sizeof(us));
+    aStats->txFrames = Energy_txFrames;
+    aStats->radioStarts = Energy_radioStarts;
+
+    HwiP_restore(key);
+
+    /* ms by nA is pC, a year at the highest current fits in 64 bits */
+    for (i = 0; i < PlatformEnergy_stateCount; i++)
+    {
+        aStats->ms[i] = (uint32_t)(us[i] / 1000U);
+        totalMs += us[i] / 1000U;
+        chargePc += (us[i] / 1000U) * Energy_currentNa[i];
+    }
+
+    aStats->chargeUc = (uint32_t)(chargePc / 1000000U);
+    aStats->averageNa = (totalMs != 0) ? (uint32_t)(chargePc / totalMs) : 0;
+}
+
+/**
+ * Function documented in platform.h
+ */
+void platformEnergyClear(void)
+{
+    uintptr_t key = HwiP_disable();
+
+    Energy_update();
+    memset(Energy_us, 0, sizeof(Energy_us));
+    Energy_txFrames = 0;
+    Energy_radioStarts = 0;
+
+    HwiP_restore(key);
+}
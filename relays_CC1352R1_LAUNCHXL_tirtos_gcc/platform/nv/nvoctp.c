@@ -85,12 +85,26 @@ the driver is forced to search for items by signature and possibly compute
 multiple CRC's to confirm it has found a valid item. Note that any corruption
 event forces a compaction to recover.
 
-Usage Note: Each item operation results in a traversal of the page starting at
-the most recently written item. This makes 'finding' items by 'trying' item IDs
-in order extremely inefficient. The doNext() API call allows the user to find,
+Usage Note: Without the RAM index, each item operation results in a traversal
+of the page starting at the most recently written item. This makes 'finding'
+items by 'trying' item IDs in order extremely inefficient. The RAM index
+(NVOCTP_RAMINDEX) is built with one traversal at initialization and is kept in
+step with every write, delete and compaction, so that operations on a specific
+item go straight to its header. Items beyond NVOCTP_RAMINDEXMAX are counted but
+not held, and only lookups that miss the index then traverse the page. The doNext() API call allows the user to find,
 read, or delete items in one page traversal. However, this call requires the
 user to lock access to NV until the operation is complete so it should be used
 carefully and sparingly.
+
+Compaction copies every active item to the other page and erases a page, which
+stalls the writing task. When a compaction notify function is registered with
+NVOCTP_setCompactNotify(), the driver calls it once free space drops below
+NVOCTP_BGHIGHWATER and a low priority task calls NVOCTP_compactStep() to do the
+work a few items at a time. Items written or deleted in the meantime are kept
+in step on the destination page, and the previous active page is erased in a
+step of its own. The source page is in XFER state for the whole transfer, so a
+reset part way through restarts the compaction from initNV(). A write that no
+longer fits completes the compaction in progress synchronously.
 */
 //*****************************************************************************
 // Use / Configuration
@@ -119,6 +133,16 @@ Configuration:
 NVOCTP_STATS - Places a protected item with driver stats
 NVOCTP_CRCONREAD (on:1 off:0) - item crc is checked on read. Disabling this may
 increase driver speed but safety is reduced.
+NVOCTP_RAMINDEX (on:1 off:0) - keep item header offsets in RAM for lookups.
+NVOCTP_RAMINDEXMAX - Number of items the RAM index can hold. Default is 64.
+Items past this are looked up by traversal until they are deleted or the page
+is compacted.
+NVOCTP_DIRECTREAD (on:1 off:0) - read flash through its memory mapping. Reads
+and CRC checks then skip the NVS driver call per block.
+NVOCTP_BGHIGHWATER - Free bytes on the active page below which a background
+compaction is requested. Default is an eighth of a page.
+NVOCTP_BGSTEPITEMS - Number of items moved per background compaction step.
+Default is 4.
 NVOCTP_NVS_INDEX - The index of the NVS_Config structure which describes the
 flash sector that NVOCTP should use. Default is 0.
 
@@ -179,6 +203,40 @@ static const NVINTF_itemID_t diagId = NVOCTP_NVID_DIAG;
 // When not NULL, reads will result in a CRC check before returning
 #define NVOCTP_CRCONREAD    1
 
+// RAM index options
+// When not 0, a sorted table of item header offsets is kept in RAM so that
+// lookups of a specific item do not have to traverse the active page
+#ifndef NVOCTP_RAMINDEX
+#define NVOCTP_RAMINDEX     1
+#endif
+
+// Maximum number of items held by the RAM index, 8 bytes of RAM each. Items
+// written once the index is full are counted instead of held. A lookup that
+// misses the index then has to traverse the page, so with more items than
+// this, Get/Set of the items left out and every sub ID lookup cost a traversal
+// again. The items left out are taken into the index as they are rewritten
+// after others were deleted, or at the next compaction. Size this to the
+// largest number of settings the image keeps.
+#ifndef NVOCTP_RAMINDEXMAX
+#define NVOCTP_RAMINDEXMAX  64
+#endif
+
+// Read flash straight through its memory mapping rather than via NVS_read()
+#ifndef NVOCTP_DIRECTREAD
+#define NVOCTP_DIRECTREAD   1
+#endif
+
+// Free bytes left on the active page below which the compaction notify
+// function is called to start a background compaction
+#ifndef NVOCTP_BGHIGHWATER
+#define NVOCTP_BGHIGHWATER  (FLASH_PAGE_SIZE / 8)
+#endif
+
+// Maximum number of items moved by one background compaction step
+#ifndef NVOCTP_BGSTEPITEMS
+#define NVOCTP_BGSTEPITEMS  4
+#endif
+
 // findItem search types
 #define NVOCTP_FINDANY      1   // Find any item
 #define NVOCTP_FINDSYSID    2   // Find the first item with spec'd sysid
@@ -193,6 +251,10 @@ static const NVINTF_itemID_t diagId = NVOCTP_NVID_DIAG;
 #define NVOCTP_FLASHOFFSET(base, pg, ofs) ((uint32_t)\
         (((pg) << 13) + (ofs) - (uint32_t)(base)))
 
+// Makes a memory mapped NV Flash address (for 0x2000 page size)
+#define NVOCTP_FLASHADDR(pg, ofs) ((const uint8_t *)\
+        (((uint32_t)(pg) << 13) + (ofs)))
+
 // Optional user provided function is called before writes/erases
 // Intention is to check for sufficient voltage for operation
 #define NVOCTP_FLASHACCESS(err) {if (NVOCTP_voltCheckFptr)\
@@ -283,6 +345,9 @@ typedef struct
 #define NVOCTP_PGACTIVE  0xA5  // Current active page
 #define NVOCTP_PGXFER    0x24  // Active page being compacted
 
+// Bits cleared going from ACTIVE to XFER state
+#define NVOCTP_PGXFERBITS  (NVOCTP_PGACTIVE ^ NVOCTP_PGXFER)
+
 // Page compaction cycle count limits (0x00 and 0xFF not used)
 #define NVOCTP_MINCYCLE  0x01  // Minimum cycle count (after rollover)
 #define NVOCTP_MAXCYCLE  0xFE  // Maximum cycle count (before rollover)
@@ -359,6 +424,15 @@ typedef struct
     uint8_t          *pBuf; // Ptr to data buffer
 } NVOCTP_itemWrp_t;
 
+#if NVOCTP_RAMINDEX
+// RAM index entry, locates the active copy of an item on the active page
+typedef struct
+{
+    uint32_t cmpid; // Compressed ID
+    uint16_t hofs;  // Header offset
+} NVOCTP_idxEnt_t;
+#endif
+
 //*****************************************************************************
 // Local variables
 //*****************************************************************************
@@ -411,11 +485,54 @@ static uint8_t NVOCTP_itemBuffer[NVOCTP_SMALLITEM];
 // Function Pointer to an optional user provided voltage check function
 static bool (*NVOCTP_voltCheckFptr)(void);
 
+// Function Pointer to an optional user provided compaction notify function
+static void (*NVOCTP_compactFptr)(void);
+
+// Destination page of the compaction in progress, NVOCTP_NULLPAGE if none
+static uint8_t NVOCTP_xferPg;
+
+// Compaction in progress: offset of the next source item to transfer, next
+// destination offset, and active page offset when the transfer started. Items
+// written above the start offset are transferred when the compaction ends.
+static uint16_t NVOCTP_xferSrcOff;
+static uint16_t NVOCTP_xferDstOff;
+static uint16_t NVOCTP_xferTopOff;
+
+// Active page offset right after the last compaction
+static uint16_t NVOCTP_xferFloor;
+
+// Previous active page waiting to be erased, and page known to be erased
+static uint8_t NVOCTP_spentPg;
+static uint8_t NVOCTP_erasedPg;
+
+#if defined (NVOCTP_STATS)
+// Number of items transferred and left behind by the compaction in progress
+static uint16_t NVOCTP_xferActive;
+static uint16_t NVOCTP_xferDeleted;
+#endif
+
 // Diagnostic counter for bad CRCs
 #ifdef NVOCTP_STATS
 static uint16_t NVOCTP_badCRCCount = 0;
 #endif
 
+#if NVOCTP_RAMINDEX
+// Active items on the active page, sorted by compressed ID. Sorting by
+// compressed ID keeps all sub IDs of an item ID together and in order.
+static NVOCTP_idxEnt_t NVOCTP_idxTbl[NVOCTP_RAMINDEXMAX];
+
+// Number of entries in use in the RAM index
+static uint16_t NVOCTP_idxCnt;
+
+// Flag to indicate that the RAM index entries match the active page. When
+// cleared, lookups fall back to traversing the active page.
+static bool NVOCTP_idxValid;
+
+// Number of active items on the active page that did not fit in the RAM index.
+// While not 0, an item missing from the index may still be on the page.
+static uint16_t NVOCTP_idxSpill;
+#endif
+
 //*****************************************************************************
 // Local Function Prototypes
 //*****************************************************************************
@@ -464,6 +581,17 @@ static uint8_t NVOCTP_checkItem(NVINTF_itemID_t *id,
 
 static int16_t NVOCTP_compactPage(uint8_t srcPg);
 
+static void NVOCTP_xferBegin(uint8_t srcPg);
+
+static bool NVOCTP_xferItems(uint16_t endOff,
+                             uint16_t maxItems);
+
+static int16_t NVOCTP_xferEnd(void);
+
+static void NVOCTP_xferSetInactive(uint32_t cid);
+
+static bool NVOCTP_xferNeeded(void);
+
 static void NVOCTP_copyItem(uint8_t xPg,
                             uint16_t sOfs,
                             uint16_t dOfs,
@@ -477,6 +605,11 @@ static int16_t NVOCTP_findItem(uint8_t pg,
 static uint16_t NVOCTP_findOffset(uint8_t pg,
                                   uint16_t ofs);
 
+static void NVOCTP_repairTop(void);
+
+static bool NVOCTP_verifyItem(uint16_t hOfs,
+                              NVOCTP_itemHdr_t *pHdr);
+
 static uint8_t NVOCTP_newItem(NVOCTP_itemHdr_t *iHdr,
                               uint8_t *pBuf);
 
@@ -522,6 +655,21 @@ static uint8_t NVOCTP_write(uint8_t dstPg,
 
 static uint8_t NVOCTP_erase(uint8_t dstPg);
 
+#if NVOCTP_RAMINDEX
+// RAM index functions
+static void NVOCTP_idxBuild(void);
+
+static bool NVOCTP_idxSearch(uint32_t cid,
+                             uint16_t *pPos);
+
+static void NVOCTP_idxUpdate(uint32_t cid,
+                             uint16_t hOfs);
+
+static void NVOCTP_idxRemove(uint16_t hOfs);
+
+static void NVOCTP_idxRetire(uint16_t hOfs);
+#endif
+
 //*****************************************************************************
 // API Functions - NV driver
 //*****************************************************************************
@@ -623,6 +771,229 @@ extern void NVOCTP_setCheckVoltage(void *funcPtr)
     NVOCTP_voltCheckFptr = (bool (*)()) funcPtr;
 }
 
+/**
+ * @fn      NVOCTP_getNthSubId
+ *
+ * @brief   Global function to find the sub ID of the n-th active item with the
+ *          given system ID and item ID, in ascending sub ID order. The lookup
+ *          is served from the RAM index without traversing the active page.
+ *
+ * @param   sysid  - NV system ID
+ * @param   itemid - NV item ID
+ * @param   n      - zero based position among the items of sysid/itemid
+ * @param   pSubId - pointer to caller's sub ID, written on success
+ *
+ * @return  NVINTF_SUCCESS, NVINTF_NOTFOUND, or NVINTF_NOTREADY when the RAM
+ *          index is not available or does not hold every item, and the caller
+ *          must use doNext() instead
+ */
+extern uint8_t NVOCTP_getNthSubId(uint8_t sysid,
+                                  uint16_t itemid,
+                                  uint16_t n,
+                                  uint16_t *pSubId)
+{
+#if NVOCTP_RAMINDEX
+    uint8_t err = NVINTF_NOTREADY;
+
+    // Prevent RTOS thread contention
+    NVOCTP_LOCK();
+
+    if((NVOCTP_failF != NVINTF_NOTREADY) && NVOCTP_idxValid &&
+       !NVOCTP_idxSpill)
+    {
+        uint16_t pos;
+        uint32_t cid = NVOCTP_CMPRID(sysid, itemid, 0);
+
+        // First entry of this sysid/itemid, then step n entries forward
+        (void)NVOCTP_idxSearch(cid, &pos);
+
+        if((n < (NVOCTP_idxCnt - pos)) &&
+           ((NVOCTP_idxTbl[pos + n].cmpid >> 12) == (cid >> 12)))
+        {
+            pos += n;
+            *pSubId = NVOCTP_idxTbl[pos].cmpid & NVOCTP_MAXSUBID;
+            err = NVINTF_SUCCESS;
+        }
+        else
+        {
+            err = NVINTF_NOTFOUND;
+        }
+    }
+
+    NVOCTP_UNLOCK(err);
+#else
+    return (NVINTF_NOTREADY);
+#endif
+}
+
+/**
+ * @fn      NVOCTP_getFreeSubId
+ *
+ * @brief   Global function to pick an unused sub ID for a new item with the
+ *          given system ID and item ID. The sub ID after the highest one in
+ *          use is returned, or the lowest unused one once the top of the sub
+ *          ID range is taken. Served from the RAM index without traversing
+ *          the active page. The caller should hold the NV lock until the new
+ *          item has been written.
+ *
+ * @param   sysid  - NV system ID
+ * @param   itemid - NV item ID
+ * @param   pSubId - pointer to caller's sub ID, written on success
+ *
+ * @return  NVINTF_SUCCESS, NVINTF_BADSUBID if every sub ID is in use, or
+ *          NVINTF_NOTREADY when the RAM index is not available
+ */
+extern uint8_t NVOCTP_getFreeSubId(uint8_t sysid,
+                                   uint16_t itemid,
+                                   uint16_t *pSubId)
+{
+#if NVOCTP_RAMINDEX
+    uint8_t err = NVINTF_NOTREADY;
+
+    // Prevent RTOS thread contention
+    NVOCTP_LOCK();
+
+    if((NVOCTP_failF != NVINTF_NOTREADY) && NVOCTP_idxValid &&
+       !NVOCTP_idxSpill)
+    {
+        uint16_t pos, end, sub;
+        uint32_t cid = NVOCTP_CMPRID(sysid, itemid, 0);
+
+        // Entries pos..end-1 hold the sub IDs of sysid/itemid, ascending
+        (void)NVOCTP_idxSearch(cid, &pos);
+        for(end = pos; (end < NVOCTP_idxCnt) &&
+            ((NVOCTP_idxTbl[end].cmpid >> 12) == (cid >> 12)); end++);
+
+        // One past the highest sub ID in use, sub ID 0 is left for set
+        sub = (end > pos) ?
+              ((NVOCTP_idxTbl[end - 1].cmpid & NVOCTP_MAXSUBID) + 1) : 1;
+
+        if(sub > NVOCTP_MAXSUBID)
+        {
+            // Top sub ID is taken, use the lowest gap instead
+            for(sub = 0; (pos < end) &&
+                ((NVOCTP_idxTbl[pos].cmpid & NVOCTP_MAXSUBID) == sub); pos++)
+            {
+                sub++;
+            }
+        }
+
+        if(sub <= NVOCTP_MAXSUBID)
+        {
+            *pSubId = sub;
+            err = NVINTF_SUCCESS;
+        }
+        else
+        {
+            err = NVINTF_BADSUBID;
+        }
+    }
+
+    NVOCTP_UNLOCK(err);
+#else
+    return (NVINTF_NOTREADY);
+#endif
+}
+
+/**
+ * @fn      NVOCTP_setCompactNotify
+ *
+ * @brief   Global function to allow user to provide a function the driver
+ *          calls when the active page should be compacted in the background.
+ *          The function is called with the NV lock held and should only wake
+ *          a low priority task which then calls NVOCTP_compactStep() until it
+ *          returns false. It must be provided before initNV() for an
+ *          interrupted compaction to be resumed in the background. The user
+ *          can withdraw their function by passing a NULL pointer.
+ *
+ * @param   funcPtr - pointer to a function taking no arguments.
+ *
+ * @return  none
+ */
+extern void NVOCTP_setCompactNotify(void *funcPtr)
+{
+    NVOCTP_compactFptr = (void (*)()) funcPtr;
+}
+
+/**
+ * @fn      NVOCTP_compactStep
+ *
+ * @brief   Global function to do a bounded amount of background compaction
+ *          work: erase the previous active page, or start a compaction once
+ *          free space is below NVOCTP_BGHIGHWATER, or move up to
+ *          NVOCTP_BGSTEPITEMS items, or switch to the compacted page. The NV
+ *          lock is only held for the one step, so writes from other tasks go
+ *          ahead in between. A write that does not fit completes the
+ *          compaction in progress synchronously.
+ *
+ * @return  true if there is more work to do, false otherwise
+ */
+extern bool NVOCTP_compactStep(void)
+{
+    bool more = FALSE;
+
+    // Prevent RTOS thread contention
+    NVOCTP_LOCK();
+
+    if(NVOCTP_failF == NVINTF_SUCCESS)
+    {
+        // Reset Flash erase/write fail indicator
+        NVOCTP_failW = NVINTF_SUCCESS;
+
+        if(NVOCTP_spentPg != NVOCTP_NULLPAGE)
+        {
+            // Erase the previous active page ahead of the next compaction
+            NVOCTP_failW = NVOCTP_erase(NVOCTP_spentPg);
+            if(NVOCTP_failW == NVINTF_SUCCESS)
+            {
+                NVOCTP_erasedPg = NVOCTP_spentPg;
+            }
+            NVOCTP_spentPg = NVOCTP_NULLPAGE;
+            more = NVOCTP_xferNeeded();
+        }
+        else if(NVOCTP_xferPg != NVOCTP_NULLPAGE)
+        {
+            // Move the next few items
+            if(NVOCTP_xferItems(NVOCTP_PGHDRLEN + NVOCTP_ITEMHDRLEN - 1,
+                                NVOCTP_BGSTEPITEMS))
+            {
+                // All items moved, switch pages
+                if((NVOCTP_failW == NVINTF_SUCCESS) && (NVOCTP_xferEnd() >= 0))
+                {
+                    more = (NVOCTP_spentPg != NVOCTP_NULLPAGE);
+                }
+            }
+            else
+            {
+                more = TRUE;
+            }
+
+            if(NVOCTP_failW != NVINTF_SUCCESS)
+            {
+                // Give up, the next compaction starts over
+                NVOCTP_ALERT(FALSE, "Background compaction failed.")
+                NVOCTP_xferPg = NVOCTP_NULLPAGE;
+                more = FALSE;
+            }
+        }
+        else if(NVOCTP_xferNeeded())
+        {
+            // Start a compaction of the active page
+            NVOCTP_xferBegin(NVOCTP_activePg);
+            if(NVOCTP_failW == NVINTF_SUCCESS)
+            {
+                more = TRUE;
+            }
+            else
+            {
+                NVOCTP_xferPg = NVOCTP_NULLPAGE;
+            }
+        }
+    }
+
+    NVOCTP_UNLOCK(more);
+}
+
 /******************************************************************************
  * @fn      NVOCTP_initNvApi
  *
@@ -728,8 +1099,9 @@ static uint8_t NVOCTP_initNvApi(void *param)
                     }
                 }
             }
-            else if(pHdr.state == NVOCTP_PGXFER)
+            else if((pHdr.state | NVOCTP_PGXFERBITS) == NVOCTP_PGACTIVE)
             {
+                // XFER state, or reset while it was being written
                 xferPg = pg;
                 if(NVOCTP_pgCycle == 0)
                 {
@@ -759,7 +1131,19 @@ static uint8_t NVOCTP_initNvApi(void *param)
                         " interruption.")
                 NVOCTP_activePg = xferPg;
                 NVOCTP_pgOff    = NVOCTP_findOffset(xferPg, FLASH_PAGE_SIZE);
-                (void)NVOCTP_compactPage(xferPg);
+                if(NVOCTP_compactFptr)
+                {
+                    // Restart the transfer, compactStep() carries it on
+                    NVOCTP_xferBegin(xferPg);
+                    if(NVOCTP_failW != NVINTF_SUCCESS)
+                    {
+                        NVOCTP_xferPg = NVOCTP_NULLPAGE;
+                    }
+                }
+                else
+                {
+                    (void)NVOCTP_compactPage(xferPg);
+                }
             }
         }
         else
@@ -773,6 +1157,21 @@ static uint8_t NVOCTP_initNvApi(void *param)
             NVOCTP_pgOff = NVOCTP_findOffset(NVOCTP_activePg, FLASH_PAGE_SIZE);
         }
 
+        // Finish off an item write interrupted by the last reset
+        NVOCTP_repairTop();
+
+#if NVOCTP_RAMINDEX
+        // One traversal of the active page to locate every active item
+        NVOCTP_idxBuild();
+#endif
+
+        if(NVOCTP_compactFptr &&
+           ((NVOCTP_xferPg != NVOCTP_NULLPAGE) || NVOCTP_xferNeeded()))
+        {
+            // Compaction to resume or start in the background
+            NVOCTP_compactFptr();
+        }
+
 #if defined (NVOCTP_STATS)
         {
             uint8_t err;
@@ -924,12 +1323,26 @@ static uint8_t NVOCTP_deleteItemApi(NVINTF_itemID_t id)
     {
         int16_t hOfs;
 
+#if NVOCTP_RAMINDEX
+        NVOCTP_idxRetire(iHdr.hofs);
+#endif
         // Mark this item as inactive
         NVOCTP_setItemInactive(iHdr.hofs);
 
         // Verify that item has been removed
-        hOfs = NVOCTP_findItem(NVOCTP_activePg, NVOCTP_pgOff,
-                               iHdr.cmpid, NVOCTP_FINDSTRICT);
+#if NVOCTP_RAMINDEX
+        if(NVOCTP_idxValid)
+        {
+            // Only one active copy exists, check its mark directly
+            hOfs = (NVOCTP_readByte(NVOCTP_activePg, iHdr.hofs +
+                    NVOCTP_HDRVLDOFS) & NVOCTP_ACTIVEIDBIT) ? iHdr.hofs : 0;
+        }
+        else
+#endif
+        {
+            hOfs = NVOCTP_findItem(NVOCTP_activePg, NVOCTP_pgOff,
+                                   iHdr.cmpid, NVOCTP_FINDSTRICT);
+        }
 
         // If item did get deleted, report 'failW' status
         err = (hOfs <= 0) ? NVOCTP_failW : NVINTF_FAILURE;
@@ -1026,6 +1439,7 @@ static uint8_t NVOCTP_writeItemApi(NVINTF_itemID_t id,
                                    void *pBuf)
 {
     uint8_t err;
+    uint8_t oPg;
     uint16_t oOfs;
     NVOCTP_itemHdr_t iHdr;
 
@@ -1039,6 +1453,7 @@ static uint8_t NVOCTP_writeItemApi(NVINTF_itemID_t id,
     NVOCTP_LOCK();
 
     oOfs = 0;
+    oPg  = NVOCTP_activePg;
     err  = NVOCTP_checkItem(&id, len, &iHdr, NVOCTP_FINDSTRICT);
 
     if(err == NVINTF_SUCCESS)
@@ -1057,8 +1472,28 @@ static uint8_t NVOCTP_writeItemApi(NVINTF_itemID_t id,
 
     if (err == NVINTF_NOTFOUND)
     {
+#if NVOCTP_RAMINDEX
+        if(oOfs != 0)
+        {
+            // Account for the old copy while the index still points at it
+            NVOCTP_idxRetire(oOfs);
+        }
+#endif
         // Create a new item
         err = NVOCTP_newItem(&iHdr, pBuf);
+        if((oOfs != 0) && (oPg != NVOCTP_activePg))
+        {
+            int16_t hOfs = 0;
+
+            // Compaction moved the old item, find it behind the new one
+            if(err == NVINTF_SUCCESS)
+            {
+                hOfs = NVOCTP_findItem(NVOCTP_activePg, NVOCTP_pgOff -
+                                       (NVOCTP_ITEMHDRLEN + len), iHdr.cmpid,
+                                       NVOCTP_FINDSTRICT);
+            }
+            oOfs = (hOfs > 0) ? (uint16_t)hOfs : 0;
+        }
         if(oOfs != 0)
         {
             // Mark old item as inactive
@@ -1319,7 +1754,42 @@ static uint8_t NVOCTP_checkItem(NVINTF_itemID_t *id,
     // Reset erase/write fail indicator for current transaction
     NVOCTP_failW = NVINTF_SUCCESS;
     cid          = NVOCTP_CMPRID(id->systemID, id->itemID, id->subID);
-    ofs          = NVOCTP_findItem(NVOCTP_activePg, NVOCTP_pgOff, cid, flag);
+
+#if NVOCTP_RAMINDEX
+    if((flag == NVOCTP_FINDSTRICT) && NVOCTP_idxValid)
+    {
+        uint16_t pos;
+
+        // Look up the item in RAM instead of traversing the page
+        ofs = NVOCTP_idxSearch(cid, &pos) ? NVOCTP_idxTbl[pos].hofs : 0;
+        if(ofs > 0)
+        {
+            // Read and decompress item header
+            NVOCTP_readHeader(NVOCTP_activePg, (uint16_t)ofs, pHdr);
+
+            if((pHdr->cmpid == cid) &&
+               (pHdr->stats & NVOCTP_ACTIVEIDBIT) &&
+              !(pHdr->stats & NVOCTP_VALIDIDBIT))
+            {
+                return (NVOCTP_failW);
+            }
+
+            // Index is stale, drop it and search the page
+            NVOCTP_ALERT(FALSE, "RAM index mismatch, traversing page.")
+            NVOCTP_idxValid = FALSE;
+            ofs = NVOCTP_findItem(NVOCTP_activePg, NVOCTP_pgOff, cid, flag);
+        }
+        else if(NVOCTP_idxSpill)
+        {
+            // Item may be one of those that did not fit in the index
+            ofs = NVOCTP_findItem(NVOCTP_activePg, NVOCTP_pgOff, cid, flag);
+        }
+    }
+    else
+#endif
+    {
+        ofs = NVOCTP_findItem(NVOCTP_activePg, NVOCTP_pgOff, cid, flag);
+    }
 
     if(ofs <= 0)
     {
@@ -1371,6 +1841,12 @@ static uint8_t NVOCTP_newItem(NVOCTP_itemHdr_t *iHdr,
     // Create the new NV item
     NVOCTP_writeItem(iHdr, NVOCTP_activePg, pBuf);
 
+    if(NVOCTP_compactFptr && NVOCTP_xferNeeded())
+    {
+        // Running low on space, have the page compacted in the background
+        NVOCTP_compactFptr();
+    }
+
     // Status of writing/erasing Flash
     return (NVOCTP_failW);
 }
@@ -1392,8 +1868,12 @@ static inline void NVOCTP_read(uint8_t pg,
                                uint8_t *pBuf,
                                uint16_t len)
 {
+#if NVOCTP_DIRECTREAD
+    memcpy(pBuf, NVOCTP_FLASHADDR(pg, off), len);
+#else
     NVS_read(NVOCTP_nvsHandle, NVOCTP_FLASHOFFSET
              (NVOCTP_nvsAttrs.regionBase, pg, off), (uint8_t *)pBuf, len);
+#endif
 }
 
 /******************************************************************************
@@ -1575,6 +2055,13 @@ static void NVOCTP_writeItem(NVOCTP_itemHdr_t *pHdr,
         {
             NVOCTP_setItemInactive(hOfs);
         }
+#if NVOCTP_RAMINDEX
+        else if (dstPg == NVOCTP_activePg)
+        {
+            // New copy of the item supersedes any older one
+            NVOCTP_idxUpdate(pHdr->cmpid, hOfs);
+        }
+#endif
     }
     else
     {
@@ -1711,6 +2198,21 @@ static void NVOCTP_setItemInactive(uint16_t iOfs)
 
     // Mark the item as inactive
     NVOCTP_writeByte(NVOCTP_activePg, iOfs + NVOCTP_HDRVLDOFS, tmp);
+
+    if((NVOCTP_xferPg != NVOCTP_NULLPAGE) &&
+       (iOfs >= NVOCTP_xferSrcOff) && (iOfs < NVOCTP_xferTopOff))
+    {
+        NVOCTP_itemHdr_t iHdr;
+
+        // Item was already transferred, its copy must not survive either
+        NVOCTP_readHeader(NVOCTP_activePg, iOfs, &iHdr);
+        NVOCTP_xferSetInactive(iHdr.cmpid);
+    }
+
+#if NVOCTP_RAMINDEX
+    // Item is no longer reachable through the index
+    NVOCTP_idxRemove(iOfs);
+#endif
 }
 
 /******************************************************************************
@@ -1789,6 +2291,81 @@ static uint16_t NVOCTP_findOffset(uint8_t pg,
     return (ofs + j);
 }
 
+/******************************************************************************
+ * @fn      NVOCTP_repairTop
+ *
+ * @brief   Check the most recently written item on the active page at reset.
+ *          A reset during an item write leaves either a partial item on top
+ *          of the page, which is dropped by compacting the page, or a
+ *          complete item whose previous copy was not yet marked inactive.
+ *
+ * @return  none
+ */
+static void NVOCTP_repairTop(void)
+{
+    NVOCTP_itemHdr_t iHdr;
+    uint16_t ofs = NVOCTP_pgOff;
+
+    if(ofs < (NVOCTP_PGDATAOFS + NVOCTP_ITEMHDRLEN))
+    {
+        // Nothing on the page yet
+        return;
+    }
+
+    // Check the last item written
+    ofs -= NVOCTP_ITEMHDRLEN;
+
+    if(NVOCTP_verifyItem(ofs, &iHdr))
+    {
+        if((iHdr.stats & NVOCTP_ACTIVEIDBIT) &&
+          !(iHdr.stats & NVOCTP_VALIDIDBIT))
+        {
+            int16_t oOfs;
+
+            // Complete the update, the older copy must not come back
+            oOfs = NVOCTP_findItem(NVOCTP_activePg, ofs - iHdr.len,
+                                   iHdr.cmpid, NVOCTP_FINDSTRICT);
+            if(oOfs > 0)
+            {
+                NVOCTP_ALERT(FALSE, "Interrupted item update completed.")
+                NVOCTP_setItemInactive((uint16_t)oOfs);
+            }
+        }
+    }
+    else
+    {
+        // Interrupted write, leave the partial item behind
+        NVOCTP_ALERT(FALSE, "Partial item on top of page, compacting.")
+        (void)NVOCTP_compactPage(NVOCTP_activePg);
+    }
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_verifyItem
+ *
+ * @brief   Check that a complete, uncorrupted item has its header at the
+ *          given offset of the active page. An 8-bit CRC alone passes too
+ *          often on random data, so the item must also sit on top of
+ *          another item or at the start of the page.
+ *
+ * @param   hOfs - Offset to item header in active page
+ * @param   pHdr - Pointer to caller's item header buffer
+ *
+ * @return  TRUE if signature, length and CRC check out
+ */
+static bool NVOCTP_verifyItem(uint16_t hOfs,
+                              NVOCTP_itemHdr_t *pHdr)
+{
+    NVOCTP_readHeader(NVOCTP_activePg, hOfs, pHdr);
+
+    return ((pHdr->sig == NVOCTP_SIGNATURE) &&
+            ((pHdr->len + NVOCTP_PGHDRLEN) <= hOfs) &&
+            ((pHdr->stats & NVOCTP_FOLLOWBIT) ||
+             ((hOfs - pHdr->len) == NVOCTP_PGDATAOFS)) &&
+            (NVOCTP_verifyCRC(hOfs - pHdr->len, pHdr->len,
+                              pHdr->crc8) == NVINTF_SUCCESS));
+}
+
 /******************************************************************************
  * @fn      NVOCTP_findItem
  *
@@ -1809,8 +2386,12 @@ static int16_t NVOCTP_findItem(uint8_t pg,
                                uint8_t flag)
 {
     bool found = FALSE;
+    bool fromTop;
     uint16_t items = 0;
 
+    // Only a search of the whole active page can be redone after compaction
+    fromTop = (pg == NVOCTP_activePg) && (ofs == NVOCTP_pgOff);
+
     while(ofs >= (NVOCTP_PGHDRLEN + NVOCTP_ITEMHDRLEN))
     {
         NVOCTP_itemHdr_t iHdr;
@@ -1879,7 +2460,19 @@ static int16_t NVOCTP_findItem(uint8_t pg,
                 // Length is corrupt, mark item invalid and compact
                 NVOCTP_ALERT(FALSE, "Item length corrupted. Deleting item.")
                 NVOCTP_setItemInactive(ofs);
-                NVOCTP_compactPage(NVOCTP_activePg);
+                fromTop = fromTop &&
+                          (NVOCTP_compactPage(NVOCTP_activePg) >= 0);
+                if(!fromTop)
+                {
+                    // Offsets into the old page are meaningless now
+                    break;
+                }
+                // Search the compacted page from the top, once
+                pg = NVOCTP_activePg;
+                ofs = NVOCTP_pgOff;
+                fromTop = FALSE;
+                items = 0;
+                continue;
             }
         }
         else
@@ -1887,7 +2480,18 @@ static int16_t NVOCTP_findItem(uint8_t pg,
             // Something is corrupted, compact to fix
             NVOCTP_ALERT(FALSE, "No item following current item, "
                     "compaction needed.")
-            NVOCTP_compactPage(NVOCTP_activePg);
+            fromTop = fromTop && (NVOCTP_compactPage(NVOCTP_activePg) >= 0);
+            if(!fromTop)
+            {
+                // Offsets into the old page are meaningless now
+                break;
+            }
+            // Search the compacted page from the top, once
+            pg = NVOCTP_activePg;
+            ofs = NVOCTP_pgOff;
+            fromTop = FALSE;
+            items = 0;
+            continue;
         }
         // Running count of items searched
         items += 1;
@@ -1903,13 +2507,15 @@ static int16_t NVOCTP_findItem(uint8_t pg,
  *
  * @brief   Compact specified page by copying active items to other page
  *
- *          Compaction occurs under three circumstances: (1) 'maintenance'
+ *          Compaction occurs under four circumstances: (1) 'maintenance'
  *          activity which is triggered by a user call to compactNvApi(),
  *          (2) 'update' activity where an NV page is packed to make room
  *          for an item being written. The 'update' mode is performed by
  *          writing the item after the rest of the page has been compacted,
- *          and (3) when corruption is detected in the NV page. The compaction
- *          operation will move all active&valid items to the other page.
+ *          (3) when corruption is detected in the NV page, and (4) in the
+ *          background through compactStep(). The compaction operation will
+ *          move all active&valid items to the other page. A background
+ *          compaction in progress is completed rather than restarted.
  *
  * @param   srcPg - Valid NV page to compact from
  *
@@ -1917,166 +2523,291 @@ static int16_t NVOCTP_findItem(uint8_t pg,
  */
 static int16_t NVOCTP_compactPage(uint8_t srcPg)
 {
-    bool needScan = FALSE;
-    uint8_t dstPg;
-    uint16_t dstOff;
-    uint16_t endOff;
-    uint16_t srcOff;
-#if defined (NVOCTP_STATS)
-    uint32_t nvcid;
-    uint16_t aitems = 0;
-    uint16_t ditems = 0;
-#endif
-
     // Reset Flash erase/write fail indicator
     NVOCTP_failW = NVINTF_SUCCESS;
 
+    if(NVOCTP_xferPg == NVOCTP_NULLPAGE)
+    {
+        // Nothing in progress, start transferring from the newest item
+        NVOCTP_xferBegin(srcPg);
+    }
+    NVOCTP_ASSERT(srcPg == NVOCTP_activePg, "Compacting inactive page.")
+
+    if(NVOCTP_failW == NVINTF_SUCCESS)
+    {
+        // Move all remaining items in one go
+        (void)NVOCTP_xferItems(NVOCTP_PGHDRLEN + NVOCTP_ITEMHDRLEN - 1,
+                               UINT16_MAX);
+    }
+
+    if(NVOCTP_failW != NVINTF_SUCCESS)
+    {
+        // Failure during item xfer makes next findItem() unreliable
+        NVOCTP_ASSERT(FALSE, "COMPACTION FAILURE")
+        NVOCTP_xferPg = NVOCTP_NULLPAGE;
+        return (-1);
+    }
+
+    // Tell caller how much room is left on the active page
+    return (NVOCTP_xferEnd());
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_xferBegin
+ *
+ * @brief   Start a compaction of the specified page. The destination page is
+ *          made ready and the source page is put in XFER state, so that an
+ *          interrupted compaction is picked up again at the next reset.
+ *
+ * @param   srcPg - Valid NV page to compact from
+ *
+ * @return  none, NVOCTP_failW holds the status
+ */
+static void NVOCTP_xferBegin(uint8_t srcPg)
+{
+    uint8_t dstPg;
+
     // Select the destination page
     dstPg = (srcPg == NVOCTP_nvBegPage) ? NVOCTP_nvEndPage : NVOCTP_nvBegPage;
 
-    // Ensure that destination page is ready
-    NVOCTP_failW = NVOCTP_erase(dstPg);
+    // Ensure that destination page is ready, unless erased in the background
+    if(NVOCTP_erasedPg != dstPg)
+    {
+        NVOCTP_failW = NVOCTP_erase(dstPg);
+    }
+    NVOCTP_erasedPg = NVOCTP_NULLPAGE;
+    NVOCTP_spentPg  = NVOCTP_NULLPAGE;
+
+    if(NVOCTP_failW == NVINTF_SUCCESS)
+    {
+        // Mark the specified page to be in XFER state
+        NVOCTP_writeByte(srcPg, NVOCTP_PGHDROFS, (uint8_t)NVOCTP_PGXFER);
+    }
 
-    // Mark the specified page to be in XFER state
-    NVOCTP_writeByte(srcPg, NVOCTP_PGHDROFS, (uint8_t)NVOCTP_PGXFER);
+    NVOCTP_xferPg = dstPg;
 
     // Destination items start right after page header
-    dstOff = NVOCTP_PGDATAOFS;
+    NVOCTP_xferDstOff = NVOCTP_PGDATAOFS;
 #if defined (NVOCTP_STATS)
-    // Create a compressed item ID for NV diagnostic
-    nvcid = NVOCTP_CMPRID(NVINTF_SYSID_NVDRVR, 1, 0);
     // Reserved space for NV driver diagnostic item
-    dstOff += NVOCTP_ITEMHDRLEN + sizeof(NVOCTP_diag_t);
+    NVOCTP_xferDstOff += NVOCTP_ITEMHDRLEN + sizeof(NVOCTP_diag_t);
+    NVOCTP_xferActive  = 0;
+    NVOCTP_xferDeleted = 0;
 #endif
-    // Stop looking when we get to this offset
-    endOff = NVOCTP_PGHDRLEN + NVOCTP_ITEMHDRLEN - 1;
 
     // Source items start with the last written item
-    srcOff = NVOCTP_pgOff;
+    NVOCTP_xferSrcOff = NVOCTP_pgOff;
+    NVOCTP_xferTopOff = NVOCTP_pgOff;
 
     NVOCTP_ALERT(FALSE, "Compaction triggered.")
-    while(srcOff > endOff && dstOff < FLASH_PAGE_SIZE)
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_xferItems
+ *
+ * @brief   Copy active items of the compaction in progress to the destination
+ *          page, working down from the transfer source offset
+ *
+ * @param   endOff   - Stop looking when we get to this offset
+ * @param   maxItems - Maximum number of items to look at
+ *
+ * @return  TRUE when no item is left above endOff, FALSE if more remain.
+ *          NVOCTP_failW holds the status.
+ */
+static bool NVOCTP_xferItems(uint16_t endOff,
+                             uint16_t maxItems)
+{
+    bool needScan = FALSE;
+    uint8_t dstPg;
+    uint8_t srcPg;
+    uint16_t dstOff;
+    uint16_t srcOff;
+#if defined (NVOCTP_STATS)
+    uint32_t nvcid;
+
+    // Create a compressed item ID for NV diagnostic
+    nvcid = NVOCTP_CMPRID(NVINTF_SYSID_NVDRVR, 1, 0);
+#endif
+
+    srcPg  = NVOCTP_activePg;
+    dstPg  = NVOCTP_xferPg;
+    srcOff = NVOCTP_xferSrcOff;
+    dstOff = NVOCTP_xferDstOff;
+
+    while(srcOff > endOff && dstOff < FLASH_PAGE_SIZE && maxItems > 0 &&
+          NVOCTP_failW == NVINTF_SUCCESS)
     {
-        if(NVOCTP_failW == NVINTF_SUCCESS)
-        {
-            NVOCTP_itemHdr_t srcHdr;
-            uint16_t dataLen;
-            uint16_t itemSize;
+        NVOCTP_itemHdr_t srcHdr;
+        uint16_t dataLen;
+        uint16_t itemSize;
 
-            // Align to start of item header
-            srcOff -= NVOCTP_ITEMHDRLEN;
+        // Running count of items looked at
+        maxItems -= 1;
 
-            // Read and decompress item header
-            NVOCTP_readHeader(srcPg, srcOff, &srcHdr);
-            dataLen  = srcHdr.len;
-            itemSize = NVOCTP_ITEMHDRLEN + dataLen;
-            
-            // Check if length is safe
-            if (srcOff < (dataLen + NVOCTP_PGHDRLEN) ||
-                    (NVOCTP_SIGNATURE != srcHdr.sig))
-            {
-                needScan = TRUE;
-            }
-            else
-            {
-                needScan = FALSE;
-            }
+        // Align to start of item header
+        srcOff -= NVOCTP_ITEMHDRLEN;
 
-            // Is item valid?
-            if(!(srcHdr.stats & NVOCTP_VALIDIDBIT) &&
-                    srcHdr.stats & NVOCTP_ACTIVEIDBIT &&
-                    !needScan)
-            {
-                uint16_t crcOff;
-                uint8_t crcStatus = NVINTF_FAILURE;
+        // Read and decompress item header
+        NVOCTP_readHeader(srcPg, srcOff, &srcHdr);
+        dataLen  = srcHdr.len;
+        itemSize = NVOCTP_ITEMHDRLEN + dataLen;
 
-                NVOCTP_ALERT(srcOff >= (dataLen + NVOCTP_PGHDRLEN),
-                             "Item header corrupted, data length too long.")
-                crcOff    = srcOff - dataLen;
-                crcStatus = NVOCTP_verifyCRC(crcOff,dataLen,srcHdr.crc8);
+        // Check if length is safe
+        if (srcOff < (dataLen + NVOCTP_PGHDRLEN) ||
+                (NVOCTP_SIGNATURE != srcHdr.sig))
+        {
+            needScan = TRUE;
+        }
+        else if((!(srcHdr.stats & NVOCTP_FOLLOWBIT) ||
+                 ((srcOff + NVOCTP_ITEMHDRLEN) == NVOCTP_xferTopOff)) &&
+                !NVOCTP_verifyItem(srcOff, &srcHdr))
+        {
+            // Nothing vouches for the length of this item, even though it
+            // may read as deleted. The top item can be what is left of an
+            // interrupted write.
+            needScan = TRUE;
+        }
+        else
+        {
+            needScan = FALSE;
+        }
 
-                if (!crcStatus)
-                {
-                    // Copy valid/non-diag item to XFER page
-                    // Unless its the diagnostic item
+        // Is item valid?
+        if(!(srcHdr.stats & NVOCTP_VALIDIDBIT) &&
+                srcHdr.stats & NVOCTP_ACTIVEIDBIT &&
+                !needScan)
+        {
+            uint16_t crcOff;
+            uint8_t crcStatus = NVINTF_FAILURE;
+
+            NVOCTP_ALERT(srcOff >= (dataLen + NVOCTP_PGHDRLEN),
+                         "Item header corrupted, data length too long.")
+            crcOff    = srcOff - dataLen;
+            crcStatus = NVOCTP_verifyCRC(crcOff,dataLen,srcHdr.crc8);
+
+            if (!crcStatus)
+            {
+                // Copy valid/non-diag item to XFER page
+                // Unless its the diagnostic item
 #if defined (NVOCTP_STATS)
-                    if (srcHdr.cmpid != nvcid)
-                    {
+                if (srcHdr.cmpid != nvcid)
+                {
 #endif
-                        NVOCTP_copyItem(dstPg, crcOff, dstOff, itemSize);
-                        dstOff += itemSize;
-                        if (dstOff > FLASH_PAGE_SIZE)
-                        {
-                            // Somehow ran out of space on new page
-                            NVOCTP_ALERT(FALSE, "Offset overflow: dstOff")
-                            NVOCTP_failW = NVINTF_BADLENGTH;
-                        }
-#if defined (NVOCTP_STATS)
-                        aitems += 1;
+                    NVOCTP_copyItem(dstPg, crcOff, dstOff, itemSize);
+                    dstOff += itemSize;
+                    if (dstOff > FLASH_PAGE_SIZE)
+                    {
+                        // Somehow ran out of space on new page
+                        NVOCTP_ALERT(FALSE, "Offset overflow: dstOff")
+                        NVOCTP_failW = NVINTF_BADLENGTH;
                     }
-#endif
-                }
-                else
-                {
-                    // Invalid CRC, corruption
-                    NVOCTP_ALERT(FALSE, "Item CRC incorrect!")
-                    needScan = TRUE;
-                    srcOff--;
+#if defined (NVOCTP_STATS)
+                    NVOCTP_xferActive += 1;
                 }
+#endif
             }
-#ifdef NVOCTP_STATS
             else
             {
-                ditems++;
+                // Invalid CRC, corruption
+                NVOCTP_ALERT(FALSE, "Item CRC incorrect!")
+                needScan = TRUE;
             }
+        }
+#ifdef NVOCTP_STATS
+        else
+        {
+            NVOCTP_xferDeleted++;
+        }
 #endif
-            // Move to next item if no issues
-            if (!needScan)
-            {
-                NVOCTP_ALERT(srcOff > dataLen, "Offset overflow: srcOff")
-                srcOff -= dataLen;
-            }
-            else
+        // Move to next item if no issues
+        if (!needScan)
+        {
+            NVOCTP_ALERT(srcOff > dataLen, "Offset overflow: srcOff")
+            srcOff -= dataLen;
+        }
+        else
+        {
+            // Detected a problem, find next header (scan for signature)
+            bool foundSig = FALSE;
+            NVOCTP_ALERT(FALSE, "Attempting to find signature...")
+            // Look below where the bad header had its signature, a partial
+            // item can be shorter than a header
+            srcOff += NVOCTP_ITEMHDREND;
+            while(!foundSig && srcOff > endOff)
             {
-                // Detected a problem, find next header (scan for signature)
-                bool foundSig = FALSE;
-                NVOCTP_ALERT(FALSE, "Attempting to find signature...")
-                while(!foundSig && srcOff > endOff)
+                // read in NVOCTP_XFERBLKMAX bytes at a time for signature
+                uint16_t i, rdLen;
+                uint8_t readBuffer[NVOCTP_XFERBLKMAX];
+
+                // Check read bounds
+                rdLen   = ((srcOff - endOff) > NVOCTP_XFERBLKMAX) ?
+                        NVOCTP_XFERBLKMAX : srcOff - endOff;
+                srcOff -= rdLen;
+                NVOCTP_read(srcPg, srcOff, readBuffer, rdLen);
+                for(i = rdLen; i > 0; i--)
                 {
-                    // read in NVOCTP_XFERBLKMAX bytes at a time for signature
-                    uint16_t i, rdLen;
-                    uint8_t readBuffer[NVOCTP_XFERBLKMAX];
-
-                    // Check read bounds
-                    rdLen   = (srcOff - NVOCTP_XFERBLKMAX > endOff) ?
-                            NVOCTP_XFERBLKMAX : srcOff - endOff;
-                    srcOff -= rdLen;
-                    NVOCTP_read(srcPg, srcOff, readBuffer, rdLen);
-                    for(i = rdLen; i > 0; i--)
+                    NVOCTP_itemHdr_t sigHdr;
+
+                    // Data bytes can look like a signature, so the item must
+                    // check out before we trust its length
+                    if ((NVOCTP_SIGNATURE == readBuffer[i - 1]) &&
+                        NVOCTP_verifyItem(srcOff + i - NVOCTP_ITEMHDRLEN,
+                                          &sigHdr))
                     {
-                        if (NVOCTP_SIGNATURE == readBuffer[i])
-                        {
-                            // Found possible header, resume normal operation
-                            NVOCTP_ALERT(FALSE, "Found possible signature.")
-                            foundSig = TRUE;
-                            // srcOff is address of [first byte of item]
-                            // after our [found sig]
-                            srcOff += (i + 1);
-                            break;
-                        }
+                        // Found possible header, resume normal operation
+                        NVOCTP_ALERT(FALSE, "Found possible signature.")
+                        foundSig = TRUE;
+                        // srcOff is address of [first byte of item]
+                        // after our [found sig]
+                        srcOff += i;
+                        break;
                     }
                 }
-                // If we get here and foundSig is false, we never found another
-                // item in the page
-                NVOCTP_ALERT(foundSig, "Attempt to find signature failed.")
             }
+            // If we get here and foundSig is false, we never found another
+            // item in the page
+            NVOCTP_ALERT(foundSig, "Attempt to find signature failed.")
         }
-        else
-        {
-            // Failure during item xfer makes next findItem() unreliable
-            NVOCTP_ASSERT(FALSE, "COMPACTION FAILURE")
-            return (-1);
-        }
+    }
+
+    NVOCTP_xferSrcOff = srcOff;
+    NVOCTP_xferDstOff = dstOff;
+
+    return ((srcOff <= endOff) || (dstOff >= FLASH_PAGE_SIZE));
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_xferEnd
+ *
+ * @brief   Complete the compaction in progress. Items written to the source
+ *          page since the transfer started are copied over, then the
+ *          destination page is activated. The previous active page is left
+ *          for compactStep() to erase, or for the next compaction to erase
+ *          before use.
+ *
+ * @return  Number of available bytes on compacted page, -1 if error
+ */
+static int16_t NVOCTP_xferEnd(void)
+{
+    uint8_t srcPg;
+    uint8_t dstPg;
+    uint16_t srcEnd;
+
+    srcPg  = NVOCTP_activePg;
+    dstPg  = NVOCTP_xferPg;
+    srcEnd = NVOCTP_pgOff;
+
+    // Pick up the items written on top of the transferred ones
+    NVOCTP_xferSrcOff = NVOCTP_pgOff;
+    (void)NVOCTP_xferItems(NVOCTP_xferTopOff + NVOCTP_ITEMHDRLEN - 1,
+                           UINT16_MAX);
+    NVOCTP_xferPg = NVOCTP_NULLPAGE;
+
+    if(NVOCTP_failW != NVINTF_SUCCESS)
+    {
+        // Failure during item xfer makes next findItem() unreliable
+        NVOCTP_ASSERT(FALSE, "COMPACTION FAILURE")
+        return (-1);
     }
 
 #if defined (NVOCTP_STATS)
@@ -2087,18 +2818,18 @@ static int16_t NVOCTP_compactPage(uint8_t srcPg)
     // One more erase/compaction is complete
     diags.compacts += 1;
     // Number of items copied
-    diags.active = aitems;
+    diags.active = NVOCTP_xferActive;
     // Number of items left behind
-    diags.deleted = ditems;
+    diags.deleted = NVOCTP_xferDeleted;
     // Number of bad CRCs found
     diags.badCRC += NVOCTP_badCRCCount;
     NVOCTP_badCRCCount = 0;
     // Available space after this item update
-    diags.available = (FLASH_PAGE_SIZE - dstOff);
+    diags.available = (FLASH_PAGE_SIZE - NVOCTP_xferDstOff);
     // Make Diag Header Object
     dHdr.len     = sizeof(diags);
     dHdr.hofs    = 0;
-    dHdr.cmpid   = nvcid;
+    dHdr.cmpid   = NVOCTP_CMPRID(NVINTF_SYSID_NVDRVR, 1, 0);
     dHdr.subid   = diagId.subID;
     dHdr.itemid  = diagId.itemID;
     dHdr.sysid   = diagId.systemID;
@@ -2114,16 +2845,89 @@ static int16_t NVOCTP_compactPage(uint8_t srcPg)
     {
         // Something bad happened when trying to compact the page
         NVOCTP_ASSERT(FALSE, "COMPACTION FAILURE")
+        NVOCTP_pgOff = srcEnd;
         return (-1);
     }
 
     // Next item offset for activePg
-    NVOCTP_pgOff = dstOff;
-    // Erase the previous active page
-    NVOCTP_failW = NVOCTP_erase(srcPg);
+    NVOCTP_pgOff = NVOCTP_xferDstOff;
+    NVOCTP_xferFloor = NVOCTP_xferDstOff;
+
+    // Previous active page is erased off the write path when possible
+    NVOCTP_spentPg = srcPg;
+    if(NVOCTP_compactFptr)
+    {
+        NVOCTP_compactFptr();
+    }
+
+#if NVOCTP_RAMINDEX
+    // Locate the transferred items on the new active page
+    NVOCTP_idxBuild();
+#endif
 
     // Tell caller how much room is left on the active page
-    return (FLASH_PAGE_SIZE - dstOff);
+    return (FLASH_PAGE_SIZE - NVOCTP_xferDstOff);
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_xferSetInactive
+ *
+ * @brief   Mark the destination page copy of an item as inactive. Used when
+ *          an item that has already been transferred by the compaction in
+ *          progress is deleted or superseded on the active page.
+ *
+ * @param   cid - Compressed NV item ID
+ *
+ * @return  none
+ */
+static void NVOCTP_xferSetInactive(uint32_t cid)
+{
+    uint16_t ofs = NVOCTP_xferDstOff;
+
+    while(ofs >= (NVOCTP_PGDATAOFS + NVOCTP_ITEMHDRLEN))
+    {
+        NVOCTP_itemHdr_t iHdr;
+
+        // Align to start of item header
+        ofs -= NVOCTP_ITEMHDRLEN;
+
+        // Items on the destination page were just written, stop at a gap
+        NVOCTP_readHeader(NVOCTP_xferPg, ofs, &iHdr);
+        if((iHdr.sig != NVOCTP_SIGNATURE) ||
+           (iHdr.len > (ofs - NVOCTP_PGDATAOFS)))
+        {
+            break;
+        }
+
+        if((iHdr.cmpid == cid) && (iHdr.stats & NVOCTP_ACTIVEIDBIT))
+        {
+            uint8_t tmp;
+
+            // Remove ACTIVE_IDS_MARK
+            tmp = NVOCTP_readByte(NVOCTP_xferPg, ofs + NVOCTP_HDRVLDOFS);
+            tmp &= ~NVOCTP_ACTIVEIDBIT;
+            NVOCTP_writeByte(NVOCTP_xferPg, ofs + NVOCTP_HDRVLDOFS, tmp);
+            break;
+        }
+
+        ofs -= iHdr.len;
+    }
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_xferNeeded
+ *
+ * @brief   Check whether a background compaction should be started. Free
+ *          space has to be below the high-water mark, and enough has been
+ *          written since the last compaction for another one to pay off.
+ *
+ * @return  TRUE if a background compaction should be started
+ */
+static bool NVOCTP_xferNeeded(void)
+{
+    return ((NVOCTP_xferPg == NVOCTP_NULLPAGE) &&
+            ((FLASH_PAGE_SIZE - NVOCTP_pgOff) < NVOCTP_BGHIGHWATER) &&
+            ((NVOCTP_pgOff - NVOCTP_xferFloor) >= (NVOCTP_BGHIGHWATER / 2)));
 }
 
 /******************************************************************************
@@ -2177,10 +2981,14 @@ static void NVOCTP_copyItem(uint8_t dstPg,
 static uint8_t NVOCTP_readByte(uint8_t pg,
                                uint16_t ofs)
 {
+#if NVOCTP_DIRECTREAD
+    return *NVOCTP_FLASHADDR(pg, ofs);
+#else
     uint8_t byteVal;
     NVOCTP_read(pg, ofs, &byteVal, NVOCTP_ONEBYTE);
 
     return byteVal;
+#endif
 }
 
 
@@ -2221,6 +3029,10 @@ static uint8_t NVOCTP_doNVCRC(uint8_t pg,
                              uint16_t len,
                              uint8_t crc)
 {
+#if NVOCTP_DIRECTREAD
+    // Compute CRC in place, no copy needed
+    return crc_update((crc_t)crc, NVOCTP_FLASHADDR(pg, ofs), len);
+#else
     uint16_t rdLen = 0;
     uint8_t tmp[NVOCTP_XFERBLKMAX];
     crc_t newCRC = (crc_t)crc;
@@ -2236,6 +3048,7 @@ static uint8_t NVOCTP_doNVCRC(uint8_t pg,
     }
 
     return newCRC;
+#endif
 }
 
 /******************************************************************************
@@ -2290,4 +3103,200 @@ static uint8_t NVOCTP_verifyCRC(uint16_t iOfs,
     return (newCRC == crc ? NVINTF_SUCCESS : NVINTF_CORRUPT);
 }
 
+#if NVOCTP_RAMINDEX
+//*****************************************************************************
+// Local RAM Index Functions
+//*****************************************************************************
+
+/******************************************************************************
+ * @fn      NVOCTP_idxBuild
+ *
+ * @brief   Rebuild the RAM index with one traversal of the active page. Items
+ *          found once the index is full are counted in NVOCTP_idxSpill. The
+ *          index is left invalid if the traversal runs into a corrupted item,
+ *          in which case findItem() remains responsible for lookups and
+ *          recovery.
+ *
+ * @return  none
+ */
+static void NVOCTP_idxBuild(void)
+{
+    uint16_t pos;
+    uint16_t ofs = NVOCTP_pgOff;
+
+    NVOCTP_idxCnt   = 0;
+    NVOCTP_idxSpill = 0;
+    NVOCTP_idxValid = TRUE;
+
+    while(NVOCTP_idxValid && ofs >= (NVOCTP_PGHDRLEN + NVOCTP_ITEMHDRLEN))
+    {
+        NVOCTP_itemHdr_t iHdr;
+
+        // Align to start of item header
+        ofs -= NVOCTP_ITEMHDRLEN;
+
+        // Read and decompress item header
+        NVOCTP_readHeader(NVOCTP_activePg, ofs, &iHdr);
+
+        if((iHdr.stats & NVOCTP_ACTIVEIDBIT) &&
+          !(iHdr.stats & NVOCTP_VALIDIDBIT))
+        {
+            // Newest copy is found first, older copies are not indexed. An
+            // older copy of an item left out may be counted again, which only
+            // keeps the index from being treated as complete.
+            if(!NVOCTP_idxSearch(iHdr.cmpid, &pos))
+            {
+                NVOCTP_idxUpdate(iHdr.cmpid, ofs);
+            }
+        }
+
+        if((iHdr.stats & NVOCTP_FOLLOWBIT) && (iHdr.len < ofs))
+        {
+            // Jump to next item
+            ofs -= iHdr.len;
+        }
+        else
+        {
+            // Page needs repair, leave it to findItem()
+            NVOCTP_ALERT(FALSE, "RAM index build stopped at corrupted item.")
+            NVOCTP_idxValid = FALSE;
+        }
+    }
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_idxSearch
+ *
+ * @brief   Binary search of the RAM index for a compressed item ID
+ *
+ * @param   cid  - Compressed NV item ID to search for
+ * @param   pPos - Returns position of the entry, or where it would be inserted
+ *
+ * @return  TRUE if the item is in the index
+ */
+static bool NVOCTP_idxSearch(uint32_t cid,
+                             uint16_t *pPos)
+{
+    uint16_t lo = 0;
+    uint16_t hi = NVOCTP_idxCnt;
+
+    while(lo < hi)
+    {
+        uint16_t mid = (lo + hi) >> 1;
+
+        if(NVOCTP_idxTbl[mid].cmpid < cid)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    *pPos = lo;
+
+    return ((lo < NVOCTP_idxCnt) && (NVOCTP_idxTbl[lo].cmpid == cid));
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_idxUpdate
+ *
+ * @brief   Record the header offset of an item, adding it to the RAM index if
+ *          it is not there yet. An item that does not fit is counted instead.
+ *
+ * @param   cid  - Compressed NV item ID
+ * @param   hOfs - Offset to item header in the active page
+ *
+ * @return  none
+ */
+static void NVOCTP_idxUpdate(uint32_t cid,
+                             uint16_t hOfs)
+{
+    uint16_t pos;
+
+    if(!NVOCTP_idxValid)
+    {
+        return;
+    }
+
+    if(!NVOCTP_idxSearch(cid, &pos))
+    {
+        if(NVOCTP_idxCnt >= NVOCTP_RAMINDEXMAX)
+        {
+            // Out of entries, lookups of this item will traverse the page
+            NVOCTP_idxSpill += 1;
+            return;
+        }
+
+        // Open a slot to keep the table sorted
+        memmove(&NVOCTP_idxTbl[pos + 1], &NVOCTP_idxTbl[pos],
+                (NVOCTP_idxCnt - pos) * sizeof(NVOCTP_idxEnt_t));
+        NVOCTP_idxTbl[pos].cmpid = cid;
+        NVOCTP_idxCnt += 1;
+    }
+
+    NVOCTP_idxTbl[pos].hofs = hOfs;
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_idxRemove
+ *
+ * @brief   Remove the item whose header is at the given offset from the RAM
+ *          index. Nothing is done if no indexed item lives at that offset.
+ *
+ * @param   hOfs - Offset to item header in the active page
+ *
+ * @return  none
+ */
+static void NVOCTP_idxRemove(uint16_t hOfs)
+{
+    uint16_t pos;
+
+    for(pos = 0; pos < NVOCTP_idxCnt; pos++)
+    {
+        if(NVOCTP_idxTbl[pos].hofs == hOfs)
+        {
+            NVOCTP_idxCnt -= 1;
+            memmove(&NVOCTP_idxTbl[pos], &NVOCTP_idxTbl[pos + 1],
+                    (NVOCTP_idxCnt - pos) * sizeof(NVOCTP_idxEnt_t));
+            break;
+        }
+    }
+}
+
+/******************************************************************************
+ * @fn      NVOCTP_idxRetire
+ *
+ * @brief   Account for the newest copy of an item that is about to be marked
+ *          inactive. If the RAM index does not hold it, the item was one of
+ *          those counted in NVOCTP_idxSpill. Only call this for a copy found
+ *          by a strict lookup on the current active page.
+ *
+ * @param   hOfs - Offset to item header in the active page
+ *
+ * @return  none
+ */
+static void NVOCTP_idxRetire(uint16_t hOfs)
+{
+    uint16_t pos;
+
+    if(!NVOCTP_idxValid || !NVOCTP_idxSpill)
+    {
+        return;
+    }
+
+    for(pos = 0; pos < NVOCTP_idxCnt; pos++)
+    {
+        if(NVOCTP_idxTbl[pos].hofs == hOfs)
+        {
+            // Held by the index, setItemInactive() removes it
+            return;
+        }
+    }
+
+    NVOCTP_idxSpill -= 1;
+}
+#endif
+
 //*****************************************************************************
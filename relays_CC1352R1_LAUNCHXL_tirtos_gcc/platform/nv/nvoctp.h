@@ -136,6 +136,75 @@ extern void NVOCTP_loadApiPtrsMin(NVINTF_nvFuncts_t *pfn);
  */
 extern void NVOCTP_setCheckVoltage(void *funcPtr);
 
+/**
+ * @fn      NVOCTP_getNthSubId
+ *
+ * @brief   Global function to find the sub ID of the n-th active item with the
+ *          given system ID and item ID, in ascending sub ID order. The lookup
+ *          is served from the RAM index without traversing the active page.
+ *
+ * @param   sysid  - NV system ID
+ * @param   itemid - NV item ID
+ * @param   n      - zero based position among the items of sysid/itemid
+ * @param   pSubId - pointer to caller's sub ID, written on success
+ *
+ * @return  NVINTF_SUCCESS, NVINTF_NOTFOUND, or NVINTF_NOTREADY when the RAM
+ *          index is not available and the caller must use doNext() instead
+ */
+extern uint8_t NVOCTP_getNthSubId(uint8_t sysid,
+                                  uint16_t itemid,
+                                  uint16_t n,
+                                  uint16_t *pSubId);
+
+/**
+ * @fn      NVOCTP_getFreeSubId
+ *
+ * @brief   Global function to pick an unused sub ID for a new item with the
+ *          given system ID and item ID. The sub ID after the highest one in
+ *          use is returned, or the lowest unused one once the top of the sub
+ *          ID range is taken. Served from the RAM index without traversing
+ *          the active page. The caller should hold the NV lock until the new
+ *          item has been written.
+ *
+ * @param   sysid  - NV system ID
+ * @param   itemid - NV item ID
+ * @param   pSubId - pointer to caller's sub ID, written on success
+ *
+ * @return  NVINTF_SUCCESS, NVINTF_BADSUBID if every sub ID is in use, or
+ *          NVINTF_NOTREADY when the RAM index is not available
+ */
+extern uint8_t NVOCTP_getFreeSubId(uint8_t sysid,
+                                   uint16_t itemid,
+                                   uint16_t *pSubId);
+
+/**
+ * @fn      NVOCTP_setCompactNotify
+ *
+ * @brief   Global function to allow user to provide a function the driver
+ *          calls when the active page should be compacted in the background.
+ *          The function is called with the NV lock held and should only wake
+ *          a low priority task which then calls NVOCTP_compactStep() until it
+ *          returns false. It must be provided before initNV() for an
+ *          interrupted compaction to be resumed in the background. The user
+ *          can withdraw their function by passing a NULL pointer.
+ *
+ * @param   funcPtr - pointer to a function taking no arguments.
+ *
+ * @return  none
+ */
+extern void NVOCTP_setCompactNotify(void *funcPtr);
+
+/**
+ * @fn      NVOCTP_compactStep
+ *
+ * @brief   Global function to do a bounded amount of background compaction
+ *          work. The NV lock is only held for the one step, so writes from
+ *          other tasks go ahead in between.
+ *
+ * @return  true if there is more work to do, false otherwise
+ */
+extern bool NVOCTP_compactStep(void);
+
 // Exception function can be defined to handle NV corruption issues
 // If none provided, NV module attempts to proceed ignoring problem
 #if !defined (NVOCTP_EXCEPTION)
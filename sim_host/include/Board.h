@@ -0,0 +1,28 @@
+/*
+ * Host stand-in for the LaunchPad board file. The indexes name the virtual
+ * pins of simdev.c.
+ */
+#ifndef BOARD_H
+#define BOARD_H
+
+#define Board_GPIO_BTN1         0
+#define Board_GPIO_BTN2         1
+#define Board_GPIO_RLED         2
+#define Board_GPIO_GLED         3
+#define Board_GPIO_SPICS        4
+#define Board_GPIO_COUNT        5
+
+#define Board_GPIO_BUTTON0      Board_GPIO_BTN1
+#define Board_GPIO_BUTTON1      Board_GPIO_BTN2
+#define Board_GPIO_LED0         Board_GPIO_RLED
+#define Board_GPIO_LED1         Board_GPIO_GLED
+
+#define Board_GPIO_LED_ON       1
+#define Board_GPIO_LED_OFF      0
+
+#define Board_I2C0              0
+
+/* Pin of the OPT3001 interrupt on the Sensor BoosterPack */
+#define IOID_3                  3
+
+#endif /* BOARD_H */
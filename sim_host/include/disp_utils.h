@@ -0,0 +1,19 @@
+/*
+ * Host stand-in for the display utilities. Serial output goes to stdout,
+ * with the name of the node in front. The host has no LCD.
+ */
+#ifndef DISP_UTILS_H
+#define DISP_UTILS_H
+
+#include "images.h"
+
+extern void simLog(const char *aFormat, ...)
+    __attribute__((format(printf, 1, 2)));
+
+#define DISPUTILS_SERIALPRINTF(line, col, ...)  simLog(__VA_ARGS__)
+#define DISPUTILS_LCDPRINTF(line, col, ...)     do { } while (0)
+
+extern void DispUtils_open(void);
+extern void DispUtils_lcdDraw(const Graphics_Image *image);
+
+#endif /* DISP_UTILS_H */
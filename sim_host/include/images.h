@@ -0,0 +1,19 @@
+/*
+ * Host stand-in for the LCD images of the examples. The host has no LCD,
+ * drawing an image logs its name.
+ */
+#ifndef IMAGES_H
+#define IMAGES_H
+
+typedef struct
+{
+    const char *name;
+} Graphics_Image;
+
+extern const Graphics_Image Images_lightsensorOpen;
+extern const Graphics_Image Images_lightsensorClosed;
+extern const Graphics_Image Images_lightsensorDrawn;
+extern const Graphics_Image Images_lightrelaysOpen;
+extern const Graphics_Image Images_lightrelaysClosed;
+
+#endif /* IMAGES_H */
@@ -0,0 +1,17 @@
+/*
+ * Host stand-in for the key utilities. Key presses come from the control
+ * input of the node, see simdev.c.
+ */
+#ifndef KEYS_UTILS_H
+#define KEYS_UTILS_H
+
+#include <stdint.h>
+
+#define KEYS_LEFT              0x01
+#define KEYS_RIGHT             0x02
+
+typedef void (*KeyUtils_PressedCB_t)(uint8_t keysPressed);
+
+extern void KeysUtils_initialize(KeyUtils_PressedCB_t keyCb);
+
+#endif /* KEYS_UTILS_H */
@@ -0,0 +1,137 @@
+/*
+ * Host stand-in for the OpenThread application CoAP API of 2018, see
+ * simot.c. A header holds the encoded CoAP header, as in OpenThread.
+ */
+#ifndef OPENTHREAD_COAP_H
+#define OPENTHREAD_COAP_H
+
+#include <openthread/ip6.h>
+#include <openthread/message.h>
+#include <openthread/types.h>
+
+#define OT_DEFAULT_COAP_PORT    5683
+
+#define OT_COAP_MAX_TOKEN_LENGTH    8
+#define OT_COAP_HEADER_MAX_LENGTH   128
+
+typedef enum
+{
+    OT_COAP_TYPE_CONFIRMABLE     = 0,
+    OT_COAP_TYPE_NON_CONFIRMABLE = 1,
+    OT_COAP_TYPE_ACKNOWLEDGMENT  = 2,
+    OT_COAP_TYPE_RESET           = 3,
+} otCoapType;
+
+#define OT_COAP_CODE(c, d)  ((((c) & 0x7) << 5) | ((d) & 0x1f))
+
+typedef enum
+{
+    OT_COAP_CODE_EMPTY              = OT_COAP_CODE(0, 0),
+    OT_COAP_CODE_GET                = OT_COAP_CODE(0, 1),
+    OT_COAP_CODE_POST               = OT_COAP_CODE(0, 2),
+    OT_COAP_CODE_PUT                = OT_COAP_CODE(0, 3),
+    OT_COAP_CODE_DELETE             = OT_COAP_CODE(0, 4),
+    OT_COAP_CODE_RESPONSE_MIN       = OT_COAP_CODE(2, 0),
+    OT_COAP_CODE_CREATED            = OT_COAP_CODE(2, 1),
+    OT_COAP_CODE_DELETED            = OT_COAP_CODE(2, 2),
+    OT_COAP_CODE_VALID              = OT_COAP_CODE(2, 3),
+    OT_COAP_CODE_CHANGED            = OT_COAP_CODE(2, 4),
+    OT_COAP_CODE_CONTENT            = OT_COAP_CODE(2, 5),
+    OT_COAP_CODE_BAD_REQUEST        = OT_COAP_CODE(4, 0),
+    OT_COAP_CODE_UNAUTHORIZED       = OT_COAP_CODE(4, 1),
+    OT_COAP_CODE_BAD_OPTION         = OT_COAP_CODE(4, 2),
+    OT_COAP_CODE_FORBIDDEN          = OT_COAP_CODE(4, 3),
+    OT_COAP_CODE_NOT_FOUND          = OT_COAP_CODE(4, 4),
+    OT_COAP_CODE_METHOD_NOT_ALLOWED = OT_COAP_CODE(4, 5),
+    OT_COAP_CODE_NOT_ACCEPTABLE     = OT_COAP_CODE(4, 6),
+    OT_COAP_CODE_REQUEST_TOO_LARGE  = OT_COAP_CODE(4, 13),
+    OT_COAP_CODE_INTERNAL_ERROR     = OT_COAP_CODE(5, 0),
+    OT_COAP_CODE_NOT_IMPLEMENTED    = OT_COAP_CODE(5, 1),
+    OT_COAP_CODE_SERVICE_UNAVAILABLE = OT_COAP_CODE(5, 3),
+} otCoapCode;
+
+typedef enum
+{
+    OT_COAP_OPTION_E_TAG         = 4,
+    OT_COAP_OPTION_URI_PATH      = 11,
+    OT_COAP_OPTION_CONTENT_FORMAT = 12,
+    OT_COAP_OPTION_MAX_AGE       = 14,
+    OT_COAP_OPTION_URI_QUERY     = 15,
+} otCoapOptionType;
+
+typedef enum
+{
+    OT_COAP_OPTION_CONTENT_FORMAT_TEXT_PLAIN  = 0,
+    OT_COAP_OPTION_CONTENT_FORMAT_LINK_FORMAT = 40,
+    OT_COAP_OPTION_CONTENT_FORMAT_OCTET_STREAM = 42,
+    OT_COAP_OPTION_CONTENT_FORMAT_JSON        = 50,
+} otCoapOptionContentFormat;
+
+typedef struct otCoapOption
+{
+    uint16_t       mNumber;
+    uint16_t       mLength;
+    const uint8_t *mValue;
+} otCoapOption;
+
+typedef struct otCoapHeader
+{
+    uint8_t      mHeader[OT_COAP_HEADER_MAX_LENGTH];
+    uint8_t      mHeaderLength;
+    uint16_t     mOptionLast;
+    uint16_t     mNextOptionOffset;
+    otCoapOption mOption;
+} otCoapHeader;
+
+typedef void (*otCoapResponseHandler)(void *aContext, otCoapHeader *aHeader,
+                                      otMessage *aMessage,
+                                      const otMessageInfo *aMessageInfo,
+                                      otError aResult);
+
+typedef void (*otCoapRequestHandler)(void *aContext, otCoapHeader *aHeader,
+                                     otMessage *aMessage,
+                                     const otMessageInfo *aMessageInfo);
+
+typedef struct otCoapResource
+{
+    const char            *mUriPath;
+    otCoapRequestHandler   mHandler;
+    void                  *mContext;
+    struct otCoapResource *mNext;
+} otCoapResource;
+
+void otCoapHeaderInit(otCoapHeader *aHeader, otCoapType aType,
+                      otCoapCode aCode);
+void otCoapHeaderSetToken(otCoapHeader *aHeader, const uint8_t *aToken,
+                          uint8_t aTokenLength);
+void otCoapHeaderGenerateToken(otCoapHeader *aHeader, uint8_t aTokenLength);
+otError otCoapHeaderAppendOption(otCoapHeader *aHeader,
+                                 const otCoapOption *aOption);
+otError otCoapHeaderAppendMaxAgeOption(otCoapHeader *aHeader, uint32_t aMaxAge);
+otError otCoapHeaderAppendContentFormatOption(otCoapHeader *aHeader,
+                                    otCoapOptionContentFormat aContentFormat);
+otError otCoapHeaderAppendUriPathOptions(otCoapHeader *aHeader,
+                                         const char *aUriPath);
+void otCoapHeaderSetPayloadMarker(otCoapHeader *aHeader);
+void otCoapHeaderSetMessageId(otCoapHeader *aHeader, uint16_t aMessageId);
+otCoapType otCoapHeaderGetType(const otCoapHeader *aHeader);
+otCoapCode otCoapHeaderGetCode(const otCoapHeader *aHeader);
+uint16_t otCoapHeaderGetMessageId(const otCoapHeader *aHeader);
+uint8_t otCoapHeaderGetTokenLength(const otCoapHeader *aHeader);
+const uint8_t *otCoapHeaderGetToken(const otCoapHeader *aHeader);
+const otCoapOption *otCoapHeaderGetFirstOption(otCoapHeader *aHeader);
+const otCoapOption *otCoapHeaderGetNextOption(otCoapHeader *aHeader);
+
+otMessage *otCoapNewMessage(otInstance *aInstance,
+                            const otCoapHeader *aHeader);
+otError otCoapSendRequest(otInstance *aInstance, otMessage *aMessage,
+                          const otMessageInfo *aMessageInfo,
+                          otCoapResponseHandler aHandler, void *aContext);
+otError otCoapStart(otInstance *aInstance, uint16_t aPort);
+otError otCoapStop(otInstance *aInstance);
+otError otCoapAddResource(otInstance *aInstance, otCoapResource *aResource);
+void otCoapRemoveResource(otInstance *aInstance, otCoapResource *aResource);
+otError otCoapSendResponse(otInstance *aInstance, otMessage *aMessage,
+                           const otMessageInfo *aMessageInfo);
+
+#endif /* OPENTHREAD_COAP_H */
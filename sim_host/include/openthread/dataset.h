@@ -0,0 +1,11 @@
+/*
+ * Host stand-in for the OpenThread dataset API, see simot.c.
+ */
+#ifndef OPENTHREAD_DATASET_H
+#define OPENTHREAD_DATASET_H
+
+#include <openthread/types.h>
+
+bool otDatasetIsCommissioned(otInstance *aInstance);
+
+#endif /* OPENTHREAD_DATASET_H */
@@ -0,0 +1,12 @@
+/*
+ * Host stand-in for the OpenThread diagnostics API. The host build has no
+ * diagnostics module.
+ */
+#ifndef OPENTHREAD_DIAG_H
+#define OPENTHREAD_DIAG_H
+
+#include <openthread/types.h>
+
+void otDiagInit(otInstance *aInstance);
+
+#endif /* OPENTHREAD_DIAG_H */
@@ -0,0 +1,25 @@
+/*
+ * Host stand-in for the OpenThread IPv6 API, see simot.c.
+ */
+#ifndef OPENTHREAD_IP6_H
+#define OPENTHREAD_IP6_H
+
+#include <openthread/message.h>
+#include <openthread/types.h>
+
+typedef otError (*otIp6SlaacIidCreate)(otInstance *aInstance,
+                                       otNetifAddress *aAddress,
+                                       void *aContext);
+otError otIp6AddressFromString(const char *aString, otIp6Address *aAddress);
+otError otIp6SubscribeMulticastAddress(otInstance *aInstance,
+                                       const otIp6Address *aAddress);
+otError otIp6UnsubscribeMulticastAddress(otInstance *aInstance,
+                                         const otIp6Address *aAddress);
+
+otError otIp6SetEnabled(otInstance *aInstance, bool aEnabled);
+bool otIp6IsEnabled(otInstance *aInstance);
+void otIp6SlaacUpdate(otInstance *aInstance, otNetifAddress *aAddresses,
+                      uint32_t aNumAddresses, otIp6SlaacIidCreate aIidCreate,
+                      void *aContext);
+
+#endif /* OPENTHREAD_IP6_H */
@@ -0,0 +1,17 @@
+/*
+ * Host stand-in for the OpenThread joiner API, see simot.c.
+ */
+#ifndef OPENTHREAD_JOINER_H
+#define OPENTHREAD_JOINER_H
+
+#include <openthread/types.h>
+
+typedef void (*otJoinerCallback)(otError aError, void *aContext);
+
+otError otJoinerStart(otInstance *aInstance, const char *aPSKd,
+                      const char *aProvisioningUrl, const char *aVendorName,
+                      const char *aVendorModel, const char *aVendorSwVersion,
+                      const char *aVendorData, otJoinerCallback aCallback,
+                      void *aContext);
+
+#endif /* OPENTHREAD_JOINER_H */
@@ -0,0 +1,17 @@
+/*
+ * Host stand-in for the OpenThread link API, see simot.c.
+ */
+#ifndef OPENTHREAD_LINK_H
+#define OPENTHREAD_LINK_H
+
+#include <openthread/dataset.h>
+#include <openthread/types.h>
+
+void otLinkGetFactoryAssignedIeeeEui64(otInstance *aInstance,
+                                       otExtAddress *aEui64);
+otError otLinkSetChannel(otInstance *aInstance, uint8_t aChannel);
+otError otLinkSetPanId(otInstance *aInstance, otPanId aPanId);
+uint32_t otLinkGetPollPeriod(otInstance *aInstance);
+otError otLinkSetPollPeriod(otInstance *aInstance, uint32_t aPollPeriod);
+
+#endif /* OPENTHREAD_LINK_H */
@@ -0,0 +1,17 @@
+/*
+ * Host stand-in for the OpenThread message API, see simot.c.
+ */
+#ifndef OPENTHREAD_MESSAGE_H
+#define OPENTHREAD_MESSAGE_H
+
+#include <openthread/types.h>
+
+void otMessageFree(otMessage *aMessage);
+uint16_t otMessageGetLength(otMessage *aMessage);
+uint16_t otMessageGetOffset(otMessage *aMessage);
+otError otMessageAppend(otMessage *aMessage, const void *aBuf,
+                        uint16_t aLength);
+int otMessageRead(otMessage *aMessage, uint16_t aOffset, void *aBuf,
+                  uint16_t aLength);
+
+#endif /* OPENTHREAD_MESSAGE_H */
@@ -0,0 +1,12 @@
+/*
+ * Host stand-in for the OpenThread tasklet API, see simot.c.
+ */
+#ifndef OPENTHREAD_TASKLET_H
+#define OPENTHREAD_TASKLET_H
+
+#include <openthread/types.h>
+
+void otTaskletsProcess(otInstance *aInstance);
+extern void otTaskletsSignalPending(otInstance *aInstance);
+
+#endif /* OPENTHREAD_TASKLET_H */
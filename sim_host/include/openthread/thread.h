@@ -0,0 +1,19 @@
+/*
+ * Host stand-in for the OpenThread Thread API, see simot.c.
+ */
+#ifndef OPENTHREAD_THREAD_H
+#define OPENTHREAD_THREAD_H
+
+#include <openthread/ip6.h>
+#include <openthread/link.h>
+#include <openthread/types.h>
+
+otError otThreadSetEnabled(otInstance *aInstance, bool aEnabled);
+otDeviceRole otThreadGetDeviceRole(otInstance *aInstance);
+otLinkModeConfig otThreadGetLinkMode(otInstance *aInstance);
+otError otThreadSetLinkMode(otInstance *aInstance, otLinkModeConfig aConfig);
+uint32_t otThreadGetChildTimeout(otInstance *aInstance);
+otError otThreadSetExtendedPanId(otInstance *aInstance,
+                                 const otExtendedPanId *aExtendedPanId);
+
+#endif /* OPENTHREAD_THREAD_H */
@@ -0,0 +1,53 @@
+/*
+ * Host stand-in for the OPT3001 ambient light sensor driver. The lux is
+ * set from the control input of the node, see simdev.c.
+ */
+#ifndef OPT3001_H
+#define OPT3001_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <ti/drivers/I2C.h>
+
+typedef enum
+{
+    OPT3001_SA1 = 0x44,
+    OPT3001_SA2 = 0x45,
+    OPT3001_SA3 = 0x46,
+    OPT3001_SA4 = 0x47
+} OPT3001_SlaveAddress;
+
+typedef struct
+{
+    OPT3001_SlaveAddress slaveAddress;
+    uint32_t             gpioIndex;
+} OPT3001_HWAttrs;
+
+typedef struct
+{
+    I2C_Handle i2cHandle;
+} OPT3001_Object;
+
+typedef struct
+{
+    const OPT3001_HWAttrs *hwAttrs;
+    OPT3001_Object        *object;
+} OPT3001_Config;
+
+typedef OPT3001_Config *OPT3001_Handle;
+
+typedef struct
+{
+    uint32_t conversionReady;
+} OPT3001_Params;
+
+extern OPT3001_Config OPT3001_config[];
+
+extern void OPT3001_init(void);
+extern void OPT3001_Params_init(OPT3001_Params *params);
+extern OPT3001_Handle OPT3001_open(unsigned int index, I2C_Handle i2cHandle,
+                                   OPT3001_Params *params);
+extern bool OPT3001_getLux(OPT3001_Handle handle, float *data);
+
+#endif /* OPT3001_H */
@@ -0,0 +1,31 @@
+/*
+ * Host stand-in for the battery monitor of the always-on domain. The host
+ * reads a fixed temperature and battery voltage.
+ */
+#ifndef AON_BATMON_H
+#define AON_BATMON_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+static inline void AONBatMonEnable(void)
+{
+}
+
+static inline bool AONBatMonNewTempMeasureReady(void)
+{
+    return (true);
+}
+
+static inline int32_t AONBatMonTemperatureGetDegC(void)
+{
+    return (22);
+}
+
+static inline uint32_t AONBatMonBatteryVoltageGet(void)
+{
+    /* 3.0 V, 4.8 fixed point */
+    return (3U << 8);
+}
+
+#endif /* AON_BATMON_H */
@@ -0,0 +1,33 @@
+/*
+ * Host stand-in for the TI GPIO driver, on the virtual pins of simdev.c.
+ */
+#ifndef GPIO_H
+#define GPIO_H
+
+#include <stdint.h>
+
+typedef uint32_t GPIO_PinConfig;
+typedef void (*GPIO_CallbackFxn)(uint_least8_t index);
+
+#define GPIO_CFG_OUTPUT             ((GPIO_PinConfig)1 << 0)
+#define GPIO_CFG_OUT_STD            ((GPIO_PinConfig)1 << 0)
+#define GPIO_CFG_OUT_STR_HIGH       ((GPIO_PinConfig)1 << 1)
+#define GPIO_CFG_OUT_LOW            ((GPIO_PinConfig)0)
+#define GPIO_CFG_OUT_HIGH           ((GPIO_PinConfig)1 << 2)
+#define GPIO_CFG_INPUT              ((GPIO_PinConfig)1 << 3)
+#define GPIO_CFG_IN_PU              (GPIO_CFG_INPUT | ((GPIO_PinConfig)1 << 4))
+#define GPIO_CFG_IN_PD              (GPIO_CFG_INPUT | ((GPIO_PinConfig)1 << 5))
+#define GPIO_CFG_IN_INT_FALLING     ((GPIO_PinConfig)1 << 6)
+#define GPIO_CFG_IN_INT_RISING      ((GPIO_PinConfig)1 << 7)
+#define GPIO_CFG_IN_INT_BOTH_EDGES  (GPIO_CFG_IN_INT_FALLING | \
+                                     GPIO_CFG_IN_INT_RISING)
+
+extern void GPIO_init(void);
+extern int_fast16_t GPIO_setConfig(uint_least8_t index, GPIO_PinConfig pinConfig);
+extern uint_fast8_t GPIO_read(uint_least8_t index);
+extern void GPIO_write(uint_least8_t index, unsigned int value);
+extern void GPIO_setCallback(uint_least8_t index, GPIO_CallbackFxn callback);
+extern void GPIO_enableInt(uint_least8_t index);
+extern void GPIO_disableInt(uint_least8_t index);
+
+#endif /* GPIO_H */
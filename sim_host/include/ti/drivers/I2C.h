@@ -0,0 +1,21 @@
+/*
+ * Host stand-in for the TI I2C driver. The only device on the bus is the
+ * virtual OPT3001 of simdev.c, which does not use it.
+ */
+#ifndef I2C_H
+#define I2C_H
+
+#include <stdint.h>
+
+typedef struct I2C_Config *I2C_Handle;
+
+typedef struct
+{
+    uint32_t bitRate;
+} I2C_Params;
+
+extern void I2C_init(void);
+extern void I2C_Params_init(I2C_Params *params);
+extern I2C_Handle I2C_open(uint_least8_t index, I2C_Params *params);
+
+#endif /* I2C_H */
@@ -0,0 +1,39 @@
+/*
+ * Host stand-in for the TI PIN driver, on the virtual pins of simdev.c.
+ */
+#ifndef PIN_H
+#define PIN_H
+
+#include <stdint.h>
+
+typedef uint32_t PIN_Id;
+typedef uint32_t PIN_Config;
+
+/* Pin id in the low byte of a PIN_Config, attributes above it */
+#define PIN_ID(config)      ((PIN_Id)((config) & 0xFFU))
+#define PIN_TERMINATE       ((PIN_Config)0xFEU)
+
+typedef struct
+{
+    uint64_t pinMask;
+} PIN_State;
+
+typedef PIN_State *PIN_Handle;
+
+typedef enum
+{
+    PIN_SUCCESS = 0,
+    PIN_ALREADY_ALLOCATED = 1,
+    PIN_NO_ACCESS = 2,
+    PIN_UNSUPPORTED = 3
+} PIN_Status;
+
+extern PIN_Handle PIN_open(PIN_State *state, const PIN_Config pinList[]);
+extern PIN_Status PIN_setOutputValue(PIN_Handle handle, PIN_Id pinId,
+                                     unsigned int val);
+extern unsigned int PIN_getOutputValue(PIN_Id pinId);
+extern PIN_Status PIN_setPortOutputValue(PIN_Handle handle,
+                                         uint32_t outputValueMask);
+extern uint32_t PIN_getPortOutputValue(PIN_Handle handle);
+
+#endif /* PIN_H */
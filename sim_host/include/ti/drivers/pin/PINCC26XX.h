@@ -0,0 +1,22 @@
+/*
+ * Host stand-in for the CC26XX pin ids and attributes.
+ */
+#ifndef PINCC26XX_H
+#define PINCC26XX_H
+
+#include <ti/drivers/PIN.h>
+
+#define PINCC26XX_DIO0              ((PIN_Id)0)
+#define PINCC26XX_DIO3              ((PIN_Id)3)
+#define PINCC26XX_DIO5              ((PIN_Id)5)
+#define PINCC26XX_DIO6              ((PIN_Id)6)
+#define PINCC26XX_DIO7              ((PIN_Id)7)
+#define PINCC26XX_DIO12             ((PIN_Id)12)
+#define PINCC26XX_DIO21             ((PIN_Id)21)
+#define PINCC26XX_DIO22             ((PIN_Id)22)
+
+#define PINCC26XX_GPIO_OUTPUT_EN    ((PIN_Config)1 << 8)
+#define PINCC26XX_GPIO_LOW          ((PIN_Config)0)
+#define PINCC26XX_GPIO_HIGH         ((PIN_Config)1 << 9)
+
+#endif /* PINCC26XX_H */
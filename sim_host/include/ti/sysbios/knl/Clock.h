@@ -0,0 +1,52 @@
+/*
+ * Host stand-in for the TI-RTOS Clock module. The clocks run on a timer
+ * thread against CLOCK_MONOTONIC, see simos.c.
+ */
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <ti/sysbios/BIOS.h>
+
+typedef void (*Clock_FuncPtr)(UArg arg);
+
+/* Tick period in us, 1 ms on the host */
+#define Clock_tickPeriod    ((uint32_t)1000)
+
+typedef struct Clock_Struct
+{
+    Clock_FuncPtr        fxn;
+    UArg                 arg;
+    uint32_t             timeout;
+    uint32_t             period;
+    uint64_t             expiryUs;
+    bool                 active;
+    struct Clock_Struct *next;
+} Clock_Struct;
+
+typedef Clock_Struct *Clock_Handle;
+
+typedef struct
+{
+    uint32_t period;
+    bool     startFlag;
+    UArg     arg;
+} Clock_Params;
+
+extern void Clock_Params_init(Clock_Params *params);
+extern void Clock_construct(Clock_Struct *clock, Clock_FuncPtr fxn,
+                            uint32_t timeout, const Clock_Params *params);
+extern void Clock_setTimeout(Clock_Handle handle, uint32_t timeout);
+extern void Clock_start(Clock_Handle handle);
+extern void Clock_stop(Clock_Handle handle);
+extern bool Clock_isActive(Clock_Handle handle);
+extern uint32_t Clock_getTicks(void);
+
+static inline Clock_Handle Clock_handle(Clock_Struct *clock)
+{
+    return (clock);
+}
+
+#endif /* CLOCK_H */
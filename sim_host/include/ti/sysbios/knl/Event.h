@@ -0,0 +1,50 @@
+/*
+ * Host stand-in for the TI-RTOS Event module, on a pthread mutex and
+ * condition. See simos.c.
+ */
+#ifndef EVENT_H
+#define EVENT_H
+
+#include <pthread.h>
+
+#include <ti/sysbios/BIOS.h>
+
+#define Event_Id_NONE   ((UInt)0)
+#define Event_Id_00     ((UInt)1 << 0)
+#define Event_Id_01     ((UInt)1 << 1)
+#define Event_Id_02     ((UInt)1 << 2)
+#define Event_Id_03     ((UInt)1 << 3)
+#define Event_Id_04     ((UInt)1 << 4)
+#define Event_Id_05     ((UInt)1 << 5)
+#define Event_Id_06     ((UInt)1 << 6)
+#define Event_Id_07     ((UInt)1 << 7)
+#define Event_Id_08     ((UInt)1 << 8)
+#define Event_Id_09     ((UInt)1 << 9)
+#define Event_Id_10     ((UInt)1 << 10)
+#define Event_Id_11     ((UInt)1 << 11)
+
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    UInt            posted;
+} Event_Struct;
+
+typedef Event_Struct *Event_Handle;
+
+typedef struct
+{
+    int unused;
+} Event_Params;
+
+extern void Event_construct(Event_Struct *event, const Event_Params *params);
+extern void Event_post(Event_Handle handle, UInt eventMask);
+extern UInt Event_pend(Event_Handle handle, UInt andMask, UInt orMask,
+                       UInt timeout);
+
+static inline Event_Handle Event_handle(Event_Struct *event)
+{
+    return (event);
+}
+
+#endif /* EVENT_H */
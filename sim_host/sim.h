@@ -0,0 +1,99 @@
+/******************************************************************************
+
+ @file  sim.h
+
+ @brief Linux simulation of the example nodes
+
+ A node runs the application, otstack.c and otrtosapi.c of its project
+ unchanged, as threads of one process. simos.c implements the TI-RTOS
+ Event and Clock modules they use on pthreads, simdev.c the board drivers
+ as virtual devices, and simot.c the part of the OpenThread API they call,
+ with CoAP over UDP sockets of the host and a modelled mesh.
+
+ *****************************************************************************/
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <openthread/types.h>
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+/**
+ * Node setup, from the command line.
+ */
+typedef struct
+{
+    const char *name;       // Name in front of the output lines
+    uint16_t    id;         // Node number, in the IID of its address
+    const char *bindAddr;   // Host address the node socket is bound to
+    uint16_t    port;       // UDP port of the node socket
+    uint32_t    delayMs;    // One way mesh delay of each datagram
+    const char *routes;     // File mapping mesh addresses to host sockets
+    bool        commissioned; // Start attached instead of waiting to join
+    uint32_t    joinMs;     // Time the joiner takes
+    const char *group;      // Host multicast group standing for ff03::1
+    uint16_t    groupPort;  // UDP port of the group
+} SimNode_Config;
+
+//*****************************************************************************
+// Global functions
+//*****************************************************************************
+
+/**
+ * @brief Time since the process started.
+ *
+ * @return us on CLOCK_MONOTONIC
+ */
+extern uint64_t simNowUs(void);
+
+/**
+ * @brief Starts the timer thread that runs the Clocks.
+ *
+ * @return None
+ */
+extern void simOsInit(void);
+
+/**
+ * @brief Prints a line to stdout with the node name and the time in
+ *        front. Safe from any thread.
+ *
+ * @param aFormat printf format
+ *
+ * @return None
+ */
+extern void simLog(const char *aFormat, ...)
+    __attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief Sets the virtual devices from a control line.
+ *
+ * @param aLine the line, without the newline
+ *
+ * @return true if the line was a device command
+ */
+extern bool simDevCommand(const char *aLine);
+
+/**
+ * @brief Opens the node socket and starts the thread receiving on it.
+ *
+ * @param aConfig node setup, kept by the caller
+ *
+ * @return 0 on success, -1 with errno set
+ */
+extern int simOtInit(const SimNode_Config *aConfig);
+
+/**
+ * @brief Handles the control lines of the OpenThread shim.
+ *
+ * @param aLine the line, without the newline
+ *
+ * @return true if the line was an OpenThread command
+ */
+extern bool simOtCommand(const char *aLine);
+
+#endif /* SIM_H */
@@ -0,0 +1,402 @@
+/******************************************************************************
+
+ @file  simdev.c
+
+ @brief Virtual devices of the simulated nodes
+
+ Stand-ins for the board drivers the applications use. The inputs are set
+ from control lines, see simDevCommand(), and the outputs print a line
+ when they change:
+
+    lux <value>         light on the OPT3001, in lux
+    reed open|closed    the reed switch on the SPI chip select pin
+    key left|right      a press of the left or right key
+    button <n> 0|1      level of button 1 or 2, 0 is pressed
+
+ An edge on an input with its interrupt enabled calls its callback on the
+ control thread, as the GPIO Hwi would.
+
+ *****************************************************************************/
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ti/drivers/GPIO.h>
+#include <ti/drivers/I2C.h>
+#include <ti/drivers/PIN.h>
+#include <ti/drivers/pin/PINCC26XX.h>
+
+#include "Board.h"
+#include "disp_utils.h"
+#include "images.h"
+#include "keys_utils.h"
+#include "opt3001.h"
+#include "sim.h"
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+#define SIM_PIN_COUNT   64
+
+typedef struct
+{
+    const char      *name;
+    GPIO_PinConfig   config;
+    unsigned int     level;     // Input level, or output value
+    GPIO_CallbackFxn callback;
+    bool             intEnabled;
+} SimGpio;
+
+//*****************************************************************************
+// Global and local variables
+//*****************************************************************************
+
+const Graphics_Image Images_lightsensorOpen   = { "lightsensor open" };
+const Graphics_Image Images_lightsensorClosed = { "lightsensor closed" };
+const Graphics_Image Images_lightsensorDrawn  = { "lightsensor drawn" };
+const Graphics_Image Images_lightrelaysOpen   = { "lightrelays open" };
+const Graphics_Image Images_lightrelaysClosed = { "lightrelays closed" };
+
+static pthread_mutex_t devMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Buttons are pulled up, the reed switch starts closed
+static SimGpio simGpio[Board_GPIO_COUNT] =
+{
+    [Board_GPIO_BTN1]  = { .name = "btn1", .level = 1 },
+    [Board_GPIO_BTN2]  = { .name = "btn2", .level = 1 },
+    [Board_GPIO_RLED]  = { .name = "rled" },
+    [Board_GPIO_GLED]  = { .name = "gled" },
+    [Board_GPIO_SPICS] = { .name = "reed", .level = 0 },
+};
+
+static unsigned int simPin[SIM_PIN_COUNT];
+
+static KeyUtils_PressedCB_t simKeyCb;
+
+// Lux of the OPT3001
+static float simLux = 500.0f;
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+/* Sets the level of an input and runs its callback on a matching edge */
+static void gpioInput(uint_least8_t index, unsigned int level)
+{
+    SimGpio         *gpio = &simGpio[index];
+    GPIO_CallbackFxn callback = NULL;
+
+    pthread_mutex_lock(&devMutex);
+    if (gpio->level != level)
+    {
+        GPIO_PinConfig edge = level ? GPIO_CFG_IN_INT_RISING
+                                    : GPIO_CFG_IN_INT_FALLING;
+
+        gpio->level = level;
+        if (gpio->intEnabled && (gpio->config & edge))
+        {
+            callback = gpio->callback;
+        }
+    }
+    pthread_mutex_unlock(&devMutex);
+
+    if (callback != NULL)
+    {
+        callback(index);
+    }
+}
+
+//*****************************************************************************
+// Global functions
+//*****************************************************************************
+
+bool simDevCommand(const char *aLine)
+{
+    char     word[16];
+    float    lux;
+    unsigned button;
+    unsigned level;
+
+    if (sscanf(aLine, "lux %f", &lux) == 1)
+    {
+        pthread_mutex_lock(&devMutex);
+        simLux = lux;
+        pthread_mutex_unlock(&devMutex);
+    }
+    else if (sscanf(aLine, "reed %15s", word) == 1 &&
+             (strcmp(word, "open") == 0 || strcmp(word, "closed") == 0))
+    {
+        gpioInput(Board_GPIO_SPICS, strcmp(word, "open") == 0);
+    }
+    else if (sscanf(aLine, "key %15s", word) == 1 &&
+             (strcmp(word, "left") == 0 || strcmp(word, "right") == 0))
+    {
+        if (simKeyCb != NULL)
+        {
+            simKeyCb(strcmp(word, "left") == 0 ? KEYS_LEFT : KEYS_RIGHT);
+        }
+    }
+    else if (sscanf(aLine, "button %u %u", &button, &level) == 2 &&
+             button >= 1 && button <= 2)
+    {
+        gpioInput(button == 1 ? Board_GPIO_BTN1 : Board_GPIO_BTN2, level != 0);
+    }
+    else
+    {
+        return (false);
+    }
+
+    return (true);
+}
+
+void GPIO_init(void)
+{
+}
+
+int_fast16_t GPIO_setConfig(uint_least8_t index, GPIO_PinConfig pinConfig)
+{
+    if (index >= Board_GPIO_COUNT)
+    {
+        return (-1);
+    }
+
+    pthread_mutex_lock(&devMutex);
+    simGpio[index].config = pinConfig;
+    if (pinConfig & GPIO_CFG_OUTPUT)
+    {
+        simGpio[index].level = (pinConfig & GPIO_CFG_OUT_HIGH) ? 1 : 0;
+    }
+    pthread_mutex_unlock(&devMutex);
+
+    return (0);
+}
+
+uint_fast8_t GPIO_read(uint_least8_t index)
+{
+    unsigned int level;
+
+    pthread_mutex_lock(&devMutex);
+    level = simGpio[index].level;
+    pthread_mutex_unlock(&devMutex);
+
+    return ((uint_fast8_t)level);
+}
+
+void GPIO_write(uint_least8_t index, unsigned int value)
+{
+    bool changed;
+
+    value = (value != 0);
+
+    pthread_mutex_lock(&devMutex);
+    changed = (simGpio[index].level != value);
+    simGpio[index].level = value;
+    pthread_mutex_unlock(&devMutex);
+
+    if (changed)
+    {
+        simLog("gpio %s %u", simGpio[index].name, value);
+    }
+}
+
+void GPIO_setCallback(uint_least8_t index, GPIO_CallbackFxn callback)
+{
+    pthread_mutex_lock(&devMutex);
+    simGpio[index].callback = callback;
+    pthread_mutex_unlock(&devMutex);
+}
+
+void GPIO_enableInt(uint_least8_t index)
+{
+    pthread_mutex_lock(&devMutex);
+    simGpio[index].intEnabled = true;
+    pthread_mutex_unlock(&devMutex);
+}
+
+void GPIO_disableInt(uint_least8_t index)
+{
+    pthread_mutex_lock(&devMutex);
+    simGpio[index].intEnabled = false;
+    pthread_mutex_unlock(&devMutex);
+}
+
+PIN_Handle PIN_open(PIN_State *state, const PIN_Config pinList[])
+{
+    unsigned i;
+
+    state->pinMask = 0;
+    for (i = 0; pinList[i] != PIN_TERMINATE; i++)
+    {
+        PIN_Id id = PIN_ID(pinList[i]);
+
+        if (id >= SIM_PIN_COUNT)
+        {
+            continue;
+        }
+        state->pinMask |= (uint64_t)1 << id;
+        if (pinList[i] & PINCC26XX_GPIO_OUTPUT_EN)
+        {
+            (void)PIN_setOutputValue(state, id,
+                                     (pinList[i] & PINCC26XX_GPIO_HIGH) != 0);
+        }
+    }
+
+    return (state);
+}
+
+PIN_Status PIN_setOutputValue(PIN_Handle handle, PIN_Id pinId,
+                              unsigned int val)
+{
+    bool changed;
+
+    if (pinId >= SIM_PIN_COUNT || !(handle->pinMask & ((uint64_t)1 << pinId)))
+    {
+        return (PIN_NO_ACCESS);
+    }
+
+    val = (val != 0);
+
+    pthread_mutex_lock(&devMutex);
+    changed = (simPin[pinId] != val);
+    simPin[pinId] = val;
+    pthread_mutex_unlock(&devMutex);
+
+    if (changed)
+    {
+        simLog("pin %u %u", (unsigned)pinId, val);
+    }
+
+    return (PIN_SUCCESS);
+}
+
+unsigned int PIN_getOutputValue(PIN_Id pinId)
+{
+    unsigned int val;
+
+    pthread_mutex_lock(&devMutex);
+    val = (pinId < SIM_PIN_COUNT) ? simPin[pinId] : 0;
+    pthread_mutex_unlock(&devMutex);
+
+    return (val);
+}
+
+PIN_Status PIN_setPortOutputValue(PIN_Handle handle,
+                                  uint32_t outputValueMask)
+{
+    char line[256];
+    size_t length = 0;
+    unsigned pinId;
+
+    /* the pins of the handle change at once, logged on one line */
+    line[0] = '\0';
+    pthread_mutex_lock(&devMutex);
+    for (pinId = 0; pinId < 32; pinId++)
+    {
+        unsigned int val = (outputValueMask >> pinId) & 1U;
+
+        if ((handle->pinMask & ((uint64_t)1 << pinId)) && simPin[pinId] != val)
+        {
+            simPin[pinId] = val;
+            length += snprintf(line + length, sizeof(line) - length,
+                               "%spin %u %u", (length > 0) ? ", " : "",
+                               pinId, val);
+        }
+    }
+    pthread_mutex_unlock(&devMutex);
+
+    if (length > 0)
+    {
+        simLog("%s", line);
+    }
+
+    return (PIN_SUCCESS);
+}
+
+uint32_t PIN_getPortOutputValue(PIN_Handle handle)
+{
+    uint32_t value = 0;
+    unsigned pinId;
+
+    pthread_mutex_lock(&devMutex);
+    for (pinId = 0; pinId < 32; pinId++)
+    {
+        if ((handle->pinMask & ((uint64_t)1 << pinId)) && simPin[pinId])
+        {
+            value |= (uint32_t)1 << pinId;
+        }
+    }
+    pthread_mutex_unlock(&devMutex);
+
+    return (value);
+}
+
+void I2C_init(void)
+{
+}
+
+void I2C_Params_init(I2C_Params *params)
+{
+    params->bitRate = 100000;
+}
+
+I2C_Handle I2C_open(uint_least8_t index, I2C_Params *params)
+{
+    static int bus;
+
+    (void)index;
+    (void)params;
+
+    return ((I2C_Handle)&bus);
+}
+
+void OPT3001_init(void)
+{
+}
+
+void OPT3001_Params_init(OPT3001_Params *params)
+{
+    params->conversionReady = 0;
+}
+
+OPT3001_Handle OPT3001_open(unsigned int index, I2C_Handle i2cHandle,
+                            OPT3001_Params *params)
+{
+    static OPT3001_Object sensorObject;
+    static OPT3001_Config sensor = { NULL, &sensorObject };
+
+    /* The application table is not needed, one sensor is modelled */
+    (void)index;
+    (void)params;
+
+    sensorObject.i2cHandle = i2cHandle;
+    return (&sensor);
+}
+
+bool OPT3001_getLux(OPT3001_Handle handle, float *data)
+{
+    (void)handle;
+
+    pthread_mutex_lock(&devMutex);
+    *data = simLux;
+    pthread_mutex_unlock(&devMutex);
+
+    return (true);
+}
+
+void KeysUtils_initialize(KeyUtils_PressedCB_t keyCb)
+{
+    simKeyCb = keyCb;
+}
+
+void DispUtils_open(void)
+{
+}
+
+void DispUtils_lcdDraw(const Graphics_Image *image)
+{
+    simLog("lcd %s", image->name);
+}
@@ -0,0 +1,622 @@
+#!/usr/bin/env python3
+"""Runs a network of simulated nodes, see README.md.
+
+  simnet.py check             starts one node of each type and checks the
+                              CoAP resources against the virtual devices
+  simnet.py bench -n <nodes>  GET latency and round times over n nodes
+  simnet.py run -n <nodes>    starts the nodes and prints the settings of
+                              controller.py for them, until Ctrl-C
+
+The nodes are light sensors, reed switches and relays in turn. Node i
+listens on UDP port base+i of the loopback and has the mesh address
+fd11:22::<i>:<lsb>, the LSB its type has in the firmware. Each reed switch
+reports to the thermostat address of its prefix, routed to a sink of the
+script that counts the reports. The nodes are in the loopback multicast
+group GROUP on port base-1, which stands for ff03::1 to them. The zone
+groups ff05::1:<n> of the relays are routed to 239.255.1.<n> on port
+base-2.
+"""
+
+import argparse
+import asyncio
+import os
+import random
+import statistics
+import struct
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+# The discovery of the controller is checked as controller.py runs it
+sys.path.insert(0, os.path.join(HERE, '..', 'Controller_and_WebServer'))
+
+GROUP = '239.255.0.1'
+ZONES = 8
+
+TYPES = {
+    # type: (binary, IID LSB, state resource)
+    'light':  ('simnode_light', 4, 'lightsensor/daylight'),
+    'reed':   ('simnode_reed', 9, 'door/state'),
+    'relays': ('simnode_relays', 3, 'lamp/state'),
+}
+ORDER = ('light', 'reed', 'relays')
+
+THERMOSTAT_LSB = 7
+
+# Poll policy the sleepy nodes get once attached, the firmware default
+# slow period of 15 s would make the run long
+POLL_POLICY = 'fast=100 window=1000 slow=1000'
+
+GET, POST = 1, 2
+CON, NON, ACK, RST = 0, 1, 2, 3
+
+
+def mesh_address(node_id, lsb):
+    return 'fd11:22::%x:%x' % (node_id, lsb)
+
+
+def code_str(code):
+    return '%d.%02d' % (code >> 5, code & 0x1f)
+
+
+#
+# CoAP client
+#
+
+def coap_encode(mtype, code, mid, token, path, payload=b'', options=()):
+    """options are (number, value) pairs, numbers below 11 or 15 and up."""
+    out = bytearray([0x40 | (mtype << 4) | len(token), code])
+    out += struct.pack('>H', mid) + token
+    last = 0
+    options = sorted(list(options) +
+                     [(11, s.encode()) for s in path.strip('/').split('/')],
+                     key=lambda o: o[0])
+    for number, value in options:
+        delta = number - last
+        last = number
+        assert delta < 13 and len(value) < 13
+        out.append((delta << 4) | len(value))
+        out += value
+    if payload:
+        out.append(0xff)
+        out += payload
+    return bytes(out)
+
+
+def coap_decode(data):
+    if len(data) < 4 or data[0] >> 6 != 1:
+        return None
+    tkl = data[0] & 0xf
+    mtype = (data[0] >> 4) & 3
+    code = data[1]
+    mid = struct.unpack('>H', data[2:4])[0]
+    token = data[4:4 + tkl]
+    options = {}
+    number, i = 0, 4 + tkl
+    while i < len(data) and data[i] != 0xff:
+        delta, length = data[i] >> 4, data[i] & 0xf
+        i += 1
+        if delta == 13:
+            delta, i = data[i] + 13, i + 1
+        if length == 13:
+            length, i = data[i] + 13, i + 1
+        number += delta
+        options.setdefault(number, []).append(data[i:i + length])
+        i += length
+    payload = data[i + 1:] if i < len(data) else b''
+    return mtype, code, mid, token, payload, options
+
+
+class CoapClient(asyncio.DatagramProtocol):
+    """Confirmable requests, matched to their responses by token."""
+
+    def __init__(self):
+        self.pending = {}
+        self.mid = random.randrange(0x10000)
+        self.transport = None
+
+    def connection_made(self, transport):
+        self.transport = transport
+
+    def datagram_received(self, data, addr):
+        msg = coap_decode(data)
+        if msg is None:
+            return
+        future = self.pending.pop(msg[3], None)
+        if future is not None and not future.done():
+            future.set_result(msg)
+
+    async def request(self, addr, code, path, payload=b'', timeout=5.0):
+        """Returns (code, payload, seconds), code None on a timeout."""
+        code, payload, _, seconds = await self.exchange(addr, code, path,
+                                                        payload, timeout)
+        return code, payload, seconds
+
+    async def exchange(self, addr, code, path, payload=b'', timeout=5.0,
+                       options=()):
+        """Returns (code, payload, {option number: [values]}, seconds),
+        code None on a timeout."""
+        self.mid = (self.mid + 1) & 0xffff
+        token = os.urandom(4)
+        future = asyncio.get_running_loop().create_future()
+        self.pending[token] = future
+        start = time.monotonic()
+        self.transport.sendto(coap_encode(CON, code, self.mid, token, path,
+                                          payload, options), addr)
+        try:
+            msg = await asyncio.wait_for(future, timeout)
+        except asyncio.TimeoutError:
+            self.pending.pop(token, None)
+            return None, b'', {}, time.monotonic() - start
+        return msg[1], msg[4], msg[5], time.monotonic() - start
+
+
+class Sink(asyncio.DatagramProtocol):
+    """The thermostat, counts the reports it gets."""
+
+    def __init__(self):
+        self.reports = []
+
+    def datagram_received(self, data, addr):
+        msg = coap_decode(data)
+        if msg is not None:
+            self.reports.append((addr, msg[4]))
+
+
+#
+# Nodes
+#
+
+class Node:
+    def __init__(self, node_id, node_type, port):
+        self.id = node_id
+        self.type = node_type
+        self.port = port
+        self.name = '%s%d' % (node_type, node_id)
+        self.lsb = TYPES[node_type][1]
+        self.resource = TYPES[node_type][2]
+        self.addr = ('127.0.0.1', port)
+        self.mesh = mesh_address(node_id, self.lsb)
+        self.proc = None
+        self.lines = []
+        self.event = asyncio.Event()
+
+    async def start(self, routes, delay, group_port, verbose):
+        prog = os.path.join(HERE, TYPES[self.type][0])
+        self.proc = await asyncio.create_subprocess_exec(
+            prog, '-n', self.name, '-i', str(self.id), '-a', '127.0.0.1',
+            '-p', str(self.port), '-d', str(delay), '-r', routes, '-j', '200',
+            '-m', GROUP, '-g', str(group_port), '-k', stdin=asyncio.subprocess.PIPE,
+            stdout=asyncio.subprocess.PIPE)
+        asyncio.ensure_future(self.read(verbose))
+
+    async def read(self, verbose):
+        while True:
+            line = await self.proc.stdout.readline()
+            if not line:
+                break
+            line = line.decode(errors='replace').rstrip()
+            if verbose:
+                print(line)
+            self.lines.append(line)
+            self.event.set()
+
+    def send(self, line):
+        self.proc.stdin.write((line + '\n').encode())
+
+    async def wait_line(self, text, start=0, timeout=5.0):
+        """Waits for an output line holding text, from line start on."""
+        deadline = time.monotonic() + timeout
+        index = start
+        while True:
+            while index < len(self.lines):
+                if text in self.lines[index]:
+                    return self.lines[index]
+                index += 1
+            left = deadline - time.monotonic()
+            if left <= 0:
+                return None
+            self.event.clear()
+            try:
+                await asyncio.wait_for(self.event.wait(), left)
+            except asyncio.TimeoutError:
+                pass
+
+    def stop(self):
+        if self.proc is not None and self.proc.returncode is None:
+            self.proc.kill()
+
+
+class Network:
+    def __init__(self, count, base_port, delay, verbose=False):
+        self.nodes = [Node(i + 1, ORDER[i % len(ORDER)], base_port + i + 1)
+                      for i in range(count)]
+        self.base_port = base_port
+        self.delay = delay
+        self.verbose = verbose
+        self.routes = None
+        self.client = None
+        self.sink = None
+
+    async def start(self):
+        loop = asyncio.get_running_loop()
+        _, self.client = await loop.create_datagram_endpoint(
+            CoapClient, local_addr=('127.0.0.1', 0))
+        _, self.sink = await loop.create_datagram_endpoint(
+            Sink, local_addr=('127.0.0.1', self.base_port))
+
+        fd, self.routes = tempfile.mkstemp(prefix='simnet', suffix='.routes')
+        with os.fdopen(fd, 'w') as f:
+            f.write('# mesh address, host address, port\n')
+            for node in self.nodes:
+                f.write('%s 127.0.0.1 %d\n' % (node.mesh, node.port))
+                f.write('%s 127.0.0.1 %d\n' % (
+                    mesh_address(node.id, THERMOSTAT_LSB), self.base_port))
+            for zone in range(1, ZONES + 1):
+                f.write('ff05::1:%x 239.255.1.%d %d\n' % (
+                    zone, zone, self.base_port - 2))
+
+        for node in self.nodes:
+            await node.start(self.routes, self.delay, self.base_port - 1,
+                             self.verbose)
+
+    async def join(self, timeout=20.0):
+        """Joins all nodes, sets the poll policy of the sleepy ones."""
+        # The keys are read once the application printed its EUI64
+        await asyncio.gather(*[node.wait_line('EUI64', timeout=timeout)
+                               for node in self.nodes])
+        for node in self.nodes:
+            node.send('key right')
+        done = await asyncio.gather(*[
+            node.wait_line('CoAP server setup done', timeout=timeout)
+            for node in self.nodes])
+        missing = [n.name for n, line in zip(self.nodes, done) if not line]
+        if missing:
+            raise RuntimeError('not joined: ' + ' '.join(missing))
+
+        # Within the fast poll window that follows the attach
+        sleepy = [n for n in self.nodes if n.type in ('light', 'reed')]
+        prefix = {'light': 'lightsensor/poll', 'reed': 'door/poll'}
+        results = await asyncio.gather(*[
+            self.client.request(n.addr, POST, prefix[n.type],
+                                POLL_POLICY.encode(), timeout=20.0)
+            for n in sleepy])
+        for node, (code, _, _) in zip(sleepy, results):
+            if code != 0x44:
+                raise RuntimeError('%s: poll policy refused' % node.name)
+
+    def discovery_env(self):
+        return {'DISCOVERY_ADDRESS': '%s:%d' % (GROUP, self.base_port - 1),
+                'DISCOVERY_INTERFACE': '127.0.0.1',
+                'ZONE_ADDRESS': '239.255.1.{}:%d' % (self.base_port - 2)}
+
+    async def zone_switch(self, relays, seq, state, window=1.0):
+        """Switches the relays in zone 1 with one group command. Returns
+        the time until the last relay switched, None if one did not, and
+        the acknowledgements that came within the window."""
+        import registry
+        level = 0 if state == 'on' else 1
+
+        async def switched(node, start):
+            line = await node.wait_line('pin 3 %d' % level, start,
+                                        timeout=window)
+            return time.monotonic() if line else None
+
+        t0 = time.monotonic()
+        waits = [asyncio.ensure_future(switched(n, len(n.lines)))
+                 for n in relays]
+        answers = await registry.group_request(
+            registry.zone_address(1), 'lamp/group', code=registry.POST,
+            payload=('%d %s' % (seq, state)).encode(), window=window)
+        times = await asyncio.gather(*waits)
+        last = None if None in times else max(times, default=t0) - t0
+        acks = sum(1 for responses in answers.values()
+                   for code, payload in responses
+                   if code == registry.CHANGED and
+                   payload == ('%d %s' % (seq, state)).encode())
+        return last, acks
+
+    def stop(self):
+        for node in self.nodes:
+            node.stop()
+        if self.routes is not None:
+            os.unlink(self.routes)
+
+
+#
+# Commands
+#
+
+class Check:
+    def __init__(self):
+        self.failed = 0
+
+    def expect(self, what, ok, detail=''):
+        print('%-4s %s%s' % ('ok' if ok else 'FAIL', what,
+                             (': ' + detail) if detail else ''))
+        if not ok:
+            self.failed += 1
+
+
+async def check(args):
+    net = Network(3, args.base_port, args.delay, args.verbose)
+    c = Check()
+    try:
+        await net.start()
+        await net.join()
+        light, reed, relays = net.nodes
+        client = net.client
+
+        code, payload, _ = await client.request(light.addr, GET,
+                                                light.resource)
+        # The application answers its GETs with 2.04
+        c.expect('light GET daylight', code is not None and code >> 5 == 2 and
+                 payload in (b'bright', b'dark'), payload.decode())
+
+        code, _, _ = await client.request(light.addr, POST,
+                                          'lightsensor/threshold/min', b'200')
+        _, payload, _ = await client.request(light.addr, GET,
+                                             'lightsensor/threshold/min')
+        c.expect('light POST threshold/min', code == 0x44 and
+                 payload == b'200', payload.decode())
+
+        # A threshold read carries an ETag (4) and a Max-Age (14), and is
+        # answered 2.03 without a payload when the ETag still matches
+        code, _, options, _ = await client.exchange(
+            light.addr, GET, 'lightsensor/threshold/min')
+        etag = options.get(4, [b''])[0]
+        max_age = int.from_bytes(options.get(14, [b''])[0], 'big')
+        c.expect('light threshold ETag and Max-Age', code == 0x45 and
+                 len(etag) == 4 and max_age > 0,
+                 'etag %s, max-age %d s' % (etag.hex(), max_age))
+        code, payload, _, _ = await client.exchange(
+            light.addr, GET, 'lightsensor/threshold/min', options=[(4, etag)])
+        c.expect('light threshold revalidated', code == 0x43 and not payload,
+                 code_str(code) if code is not None else 'timeout')
+        await client.request(light.addr, POST, 'lightsensor/threshold/min',
+                             b'300')
+        code, payload, _, _ = await client.exchange(
+            light.addr, GET, 'lightsensor/threshold/min', options=[(4, etag)])
+        c.expect('light threshold ETag changes with a POST', code == 0x45 and
+                 payload == b'300', payload.decode())
+
+        code, _, _ = await client.request(light.addr, GET, 'no/such/path')
+        c.expect('light unknown path', code == 0x84,
+                 code_str(code) if code is not None else 'timeout')
+
+        start = len(reed.lines)
+        reports = len(net.sink.reports)
+        reed.send('reed open')
+        await reed.wait_line('reed', start)
+        await asyncio.sleep(0.2)
+        _, payload, _ = await client.request(reed.addr, GET, reed.resource)
+        c.expect('reed open in GET', payload == b'open', payload.decode())
+        deadline = time.monotonic() + 3.0
+        while len(net.sink.reports) == reports and time.monotonic() < deadline:
+            await asyncio.sleep(0.05)
+        c.expect('reed report to the thermostat',
+                 len(net.sink.reports) > reports)
+
+        # The relay is driven active low
+        for state, level in (('on', 0), ('off', 1)):
+            start = len(relays.lines)
+            code, _, _ = await client.request(relays.addr, POST,
+                                              relays.resource, state.encode())
+            line = await relays.wait_line('pin 3 %d' % level, start)
+            c.expect('relays POST %s' % state, code == 0x44 and
+                     line is not None)
+
+        # One multicast finds the resources of all nodes, a query only
+        # the matching ones
+        os.environ.update(net.discovery_env())
+        import registry
+        reg = registry.Registry()
+        found = await reg.discover(window=1.5)
+        c.expect('discovery finds all nodes', found == 3, '%d' % found)
+        lamps = reg.having(registry.RT_LAMP)
+        c.expect('discovery lamp.state link', len(lamps) == 1 and
+                 lamps[0].address == '127.0.0.1:%d' % relays.port and
+                 lamps[0].resource(registry.RT_LAMP) == '/' + relays.resource)
+        reg = registry.Registry()
+        found = await reg.discover(query='rt=door.*', window=1.5)
+        c.expect('discovery query rt=door.*', found == 1 and
+                 len(reg.having(registry.RT_DOOR)) == 1, '%d' % found)
+
+        # Zone commands, with their sequence numbers
+        code, payload, _ = await client.request(
+            relays.addr, POST, 'lamp/zones', registry.zone_group(1).encode())
+        c.expect('relays join zone 1', code == 0x44 and
+                 payload == registry.zone_group(1).encode(), payload.decode())
+        code, _, _ = await client.request(relays.addr, POST, 'lamp/zones',
+                                          b'fd11:22::1')
+        c.expect('relays refuse a unicast zone', code == 0x80,
+                 code_str(code) if code is not None else 'timeout')
+        seconds, acks = await net.zone_switch([relays], 1000, 'on')
+        c.expect('zone command switches and is acknowledged',
+                 seconds is not None and acks == 1, '%d acks' % acks)
+        start = len(relays.lines)
+        answers = await registry.group_request(
+            registry.zone_address(1), 'lamp/group', code=registry.POST,
+            payload=b'999 off', window=1.0)
+        acks = [p for responses in answers.values() for _, p in responses]
+        line = await relays.wait_line('pin 3 1', start, timeout=0.1)
+        c.expect('older zone command not applied', acks == [b'1000 on'] and
+                 line is None, ' '.join(a.decode() for a in acks))
+        code, payload, _ = await client.request(relays.addr, POST,
+                                                'lamp/group', b'1001 off')
+        line = await relays.wait_line('pin 3 1', start)
+        c.expect('unicast retry of a zone command', code == 0x44 and
+                 payload == b'1001 off' and line is not None, payload.decode())
+
+        # Bank commands: the channels of the mask in one port update, or
+        # one channel a step
+        code, payload, _ = await client.request(relays.addr, POST,
+                                                'lamp/bank', b'0x5 0x5')
+        await asyncio.sleep(0.1)
+        lines = [l for l in relays.lines[start:] if 'pin ' in l]
+        c.expect('bank command in one port update', code == 0x44 and
+                 payload == b'4 0x5 0x5' and len(lines) >= 2 and
+                 lines[-1].endswith('pin 3 0, pin 21 0'), payload.decode())
+        start = len(relays.lines)
+        code, payload, _ = await client.request(relays.addr, POST,
+                                                'lamp/bank', b'0xf 0xa 100')
+        await relays.wait_line('pin 22 0', start)
+        _, state, _ = await client.request(relays.addr, GET, 'lamp/bank')
+        lines = [l for l in relays.lines[start:] if 'pin ' in l]
+        c.expect('sequenced bank command', code == 0x44 and
+                 payload == b'4 0x4 0xa' and state == b'4 0xa 0xa' and
+                 len(lines) == 4 and
+                 node_seconds(lines[-1]) - node_seconds(lines[0]) >= 0.29,
+                 '%s, %d steps' % (state.decode(), len(lines)))
+        code, _, _ = await client.request(relays.addr, POST, 'lamp/bank',
+                                          b'0x10 0x10')
+        c.expect('bank refuses a channel it does not have', code == 0x80,
+                 code_str(code) if code is not None else 'timeout')
+
+        # Past the fast window, a request waits for the next slow poll
+        await asyncio.sleep(1.5)
+        _, _, seconds = await client.request(light.addr, GET, light.resource)
+        bound = 1.0 + 2 * args.delay / 1000.0 + 0.2
+        c.expect('sleepy GET within the slow poll period', seconds <= bound,
+                 '%.0f ms' % (seconds * 1000))
+    finally:
+        net.stop()
+
+    print('%s' % ('all passed' if c.failed == 0 else
+                  '%d failed' % c.failed))
+    return 1 if c.failed else 0
+
+
+def node_seconds(line):
+    """Node time of an output line, "[name s.ms] ...", in s."""
+    return float(line.split(']')[0].split()[-1])
+
+
+def percentile(values, p):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100.0))]
+
+
+async def bench(args):
+    net = Network(args.nodes, args.base_port, args.delay, args.verbose)
+    try:
+        await net.start()
+        t0 = time.monotonic()
+        await net.join(timeout=30.0 + args.nodes * 0.1)
+        print('%d nodes, %d ms mesh delay, joined in %.2f s' %
+              (args.nodes, args.delay, time.monotonic() - t0))
+
+        # The rx-on relays answer at once, the sleepy nodes at their poll
+        for kind in ORDER:
+            nodes = [n for n in net.nodes if n.type == kind]
+            if not nodes:
+                continue
+            t0 = time.monotonic()
+            seq = []
+            for node in nodes:
+                code, _, s = await net.client.request(node.addr, GET,
+                                                      node.resource)
+                if code is not None:
+                    seq.append(s)
+            seq_time = time.monotonic() - t0
+
+            t0 = time.monotonic()
+            results = await asyncio.gather(*[
+                net.client.request(n.addr, GET, n.resource) for n in nodes])
+            con_time = time.monotonic() - t0
+            con = [s for code, _, s in results if code is not None]
+
+            lat = seq + con
+            lost = 2 * len(nodes) - len(lat)
+            print('%-6s %4d nodes: GET p50 %6.1f p95 %6.1f max %6.1f ms, '
+                  'round %7.1f ms sequential %7.1f ms concurrent, %d lost' %
+                  (kind, len(nodes),
+                   statistics.median(lat) * 1000 if lat else 0,
+                   percentile(lat, 95) * 1000 if lat else 0,
+                   max(lat) * 1000 if lat else 0,
+                   seq_time * 1000, con_time * 1000, lost))
+
+        # One group command for all relays, against one POST each
+        relays = [n for n in net.nodes if n.type == 'relays']
+        if relays:
+            os.environ.update(net.discovery_env())
+            import registry
+            await asyncio.gather(*[
+                net.client.request(n.addr, POST, 'lamp/zones',
+                                   registry.zone_group(1).encode())
+                for n in relays])
+            zone = []
+            for seq, state in ((1, 'on'), (2, 'off')):
+                zone.append(await net.zone_switch(relays, seq, state))
+
+            t0 = time.monotonic()
+            for node in relays:
+                await net.client.request(node.addr, POST, node.resource, b'on')
+            seq_time = time.monotonic() - t0
+            t0 = time.monotonic()
+            await asyncio.gather(*[
+                net.client.request(n.addr, POST, n.resource, b'off')
+                for n in relays])
+            con_time = time.monotonic() - t0
+
+            switched = [s for s, _ in zone if s is not None]
+            print('zone   %4d relays: switched in %6.1f ms, %d/%d acks in '
+                  '1 s; unicast %7.1f ms one by one %7.1f ms all at once' %
+                  (len(relays),
+                   max(switched) * 1000 if switched else -1,
+                   min(a for _, a in zone), len(relays),
+                   seq_time * 1000, con_time * 1000))
+    finally:
+        net.stop()
+    return 0
+
+
+async def run(args):
+    net = Network(args.nodes, args.base_port, args.delay, args.verbose)
+    try:
+        await net.start()
+        await net.join()
+        first = {}
+        for node in net.nodes:
+            first.setdefault(node.type, node)
+        env = (('LIGHTSENSOR_ID', 'light'), ('DOOR_ID', 'reed'),
+               ('LIGHTSWITCH_ID', 'relays'))
+        for name, kind in env:
+            if kind in first:
+                print('export %s=%s:%d' % (name, first[kind].addr[0],
+                                           first[kind].port))
+        for name, value in sorted(net.discovery_env().items()):
+            print('export %s=%s' % (name, value))
+        print('export DISCOVERY_WINDOW=1.5')
+        sys.stdout.flush()
+        await asyncio.Event().wait()
+    finally:
+        net.stop()
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('command', choices=('check', 'bench', 'run'))
+    parser.add_argument('-n', '--nodes', type=int, default=3)
+    parser.add_argument('-d', '--delay', type=int, default=5,
+                        help='one way mesh delay, ms')
+    parser.add_argument('-b', '--base-port', type=int, default=25683)
+    parser.add_argument('-v', '--verbose', action='store_true',
+                        help='print the output of the nodes')
+    args = parser.parse_args()
+
+    command = {'check': check, 'bench': bench, 'run': run}[args.command]
+    try:
+        return asyncio.run(command(args))
+    except KeyboardInterrupt:
+        return 0
+    except RuntimeError as e:
+        print('simnet: %s' % e, file=sys.stderr)
+        return 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
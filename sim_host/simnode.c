@@ -0,0 +1,216 @@
+/******************************************************************************
+
+ @file  simnode.c
+
+ @brief Main of a simulated node
+
+ Starts the OpenThread task and the application task of the project the
+ node is built from, as main.c does on the board, then reads control lines
+ from stdin:
+
+    <device command>    see simdev.c
+    stats               counters of the OpenThread shim
+    sleep <ms>          waits before the next line
+    quit                ends the node
+
+   simnode_<type> [-n name] [-i id] [-a addr] [-p port] [-d delay ms]
+                  [-r routes] [-c] [-j join ms] [-k]
+                  [-m group] [-g group port]
+
+ -c starts the node commissioned, it attaches when Thread is enabled,
+ otherwise it waits for the joiner ("key right"). -k keeps the node
+ running at the end of stdin. -m joins a multicast group of the host, the
+ datagrams to it reach the node as to ff03::1.
+
+ *****************************************************************************/
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+#ifndef SIM_APP_TASK_CREATE
+#error "SIM_APP_TASK_CREATE names the task create function of the application"
+#endif
+
+extern void OtStack_taskCreate(void);
+extern void SIM_APP_TASK_CREATE(void);
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static SimNode_Config simNode = {
+    .name         = "node",
+    .id           = 0,
+    .bindAddr     = "::1",
+    .port         = 5683,
+    .delayMs      = 0,
+    .routes       = NULL,
+    .commissioned = false,
+    .joinMs       = 1000,
+    .group        = NULL,
+    .groupPort    = 5683,
+};
+
+static pthread_mutex_t simLogMutex = PTHREAD_MUTEX_INITIALIZER;
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+static void usage(const char *aProg)
+{
+    fprintf(stderr,
+            "usage: %s [-n name] [-i id] [-a addr] [-p port] [-d delay ms]\n"
+            "       [-r routes] [-c] [-j join ms] [-k]\n"
+            "       [-m group] [-g group port]\n", aProg);
+    exit(2);
+}
+
+static void sleepMs(unsigned long aMs)
+{
+    struct timespec ts;
+
+    ts.tv_sec  = aMs / 1000U;
+    ts.tv_nsec = (long)(aMs % 1000U) * 1000000L;
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+    {
+    }
+}
+
+//*****************************************************************************
+// Global functions
+//*****************************************************************************
+
+void simLog(const char *aFormat, ...)
+{
+    char     line[512];
+    size_t   length;
+    uint64_t now = simNowUs();
+    va_list  ap;
+
+    va_start(ap, aFormat);
+    vsnprintf(line, sizeof(line), aFormat, ap);
+    va_end(ap);
+
+    length = strlen(line);
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+    {
+        line[--length] = '\0';
+    }
+
+    pthread_mutex_lock(&simLogMutex);
+    printf("[%s %lu.%03lu] %s\n", simNode.name,
+           (unsigned long)(now / 1000000U),
+           (unsigned long)((now / 1000U) % 1000U), line);
+    fflush(stdout);
+    pthread_mutex_unlock(&simLogMutex);
+}
+
+int main(int argc, char *argv[])
+{
+    char line[256];
+    bool keep = false;
+    int  opt;
+
+    while ((opt = getopt(argc, argv, "n:i:a:p:d:r:cj:km:g:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            simNode.name = optarg;
+            break;
+        case 'i':
+            simNode.id = (uint16_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'a':
+            simNode.bindAddr = optarg;
+            break;
+        case 'p':
+            simNode.port = (uint16_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            simNode.delayMs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            simNode.routes = optarg;
+            break;
+        case 'c':
+            simNode.commissioned = true;
+            break;
+        case 'j':
+            simNode.joinMs = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'k':
+            keep = true;
+            break;
+        case 'm':
+            simNode.group = optarg;
+            break;
+        case 'g':
+            simNode.groupPort = (uint16_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (optind != argc)
+    {
+        usage(argv[0]);
+    }
+
+    simOsInit();
+    if (simOtInit(&simNode) != 0)
+    {
+        fprintf(stderr, "%s: %s port %u: %s\n", simNode.name, simNode.bindAddr,
+                simNode.port, strerror(errno));
+        return (1);
+    }
+
+    OtStack_taskCreate();
+    SIM_APP_TASK_CREATE();
+
+    while (fgets(line, sizeof(line), stdin) != NULL)
+    {
+        unsigned long ms;
+
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#')
+        {
+            continue;
+        }
+
+        if (strcmp(line, "quit") == 0)
+        {
+            return (0);
+        }
+        else if (sscanf(line, "sleep %lu", &ms) == 1)
+        {
+            sleepMs(ms);
+        }
+        else if (!simDevCommand(line) && !simOtCommand(line))
+        {
+            simLog("unknown command: %s", line);
+        }
+    }
+
+    while (keep)
+    {
+        pause();
+    }
+
+    return (0);
+}
@@ -0,0 +1,298 @@
+/******************************************************************************
+
+ @file  simos.c
+
+ @brief TI-RTOS Event and Clock modules on pthreads
+
+ The applications and otstack.c pend on Events and run Clocks, and only
+ through the calls below. Events are a mask under a mutex with a condition
+ to wait on. The Clocks expire on CLOCK_MONOTONIC and their functions run
+ one at a time on a timer thread, as the Clock Swi would run them.
+
+ *****************************************************************************/
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Event.h>
+
+#include "sim.h"
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static uint64_t simStartUs;
+
+// Active Clocks, in no order
+static Clock_Struct   *clockList;
+static pthread_mutex_t clockMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  clockCond;
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+/* Raw CLOCK_MONOTONIC in us */
+static uint64_t monotonicUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (((uint64_t)ts.tv_sec * 1000000U) + ((uint64_t)ts.tv_nsec / 1000U));
+}
+
+/* Absolute CLOCK_MONOTONIC time of a simNowUs() value */
+static struct timespec monotonicAt(uint64_t us)
+{
+    struct timespec ts;
+
+    us += simStartUs;
+    ts.tv_sec  = (time_t)(us / 1000000U);
+    ts.tv_nsec = (long)((us % 1000000U) * 1000U);
+    return (ts);
+}
+
+/* Initializes a condition to wait on CLOCK_MONOTONIC */
+static void condInit(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/* Unlinks a Clock from the active list, with clockMutex held */
+static void clockUnlink(Clock_Struct *clock)
+{
+    Clock_Struct **link;
+
+    for (link = &clockList; *link != NULL; link = &(*link)->next)
+    {
+        if (*link == clock)
+        {
+            *link = clock->next;
+            break;
+        }
+    }
+    clock->next   = NULL;
+    clock->active = false;
+}
+
+/* Runs the Clock functions as they expire */
+static void *clockThread(void *arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&clockMutex);
+    while (1)
+    {
+        Clock_Struct *clock;
+        Clock_Struct *first = NULL;
+        uint64_t      now   = simNowUs();
+
+        for (clock = clockList; clock != NULL; clock = clock->next)
+        {
+            if (first == NULL || clock->expiryUs < first->expiryUs)
+            {
+                first = clock;
+            }
+        }
+
+        if (first == NULL)
+        {
+            pthread_cond_wait(&clockCond, &clockMutex);
+        }
+        else if (first->expiryUs > now)
+        {
+            struct timespec ts = monotonicAt(first->expiryUs);
+
+            pthread_cond_timedwait(&clockCond, &clockMutex, &ts);
+        }
+        else
+        {
+            Clock_FuncPtr fxn = first->fxn;
+            UArg          fxnArg = first->arg;
+
+            if (first->period > 0)
+            {
+                first->expiryUs += (uint64_t)first->period * Clock_tickPeriod;
+            }
+            else
+            {
+                clockUnlink(first);
+            }
+
+            pthread_mutex_unlock(&clockMutex);
+            fxn(fxnArg);
+            pthread_mutex_lock(&clockMutex);
+        }
+    }
+
+    return (NULL);
+}
+
+//*****************************************************************************
+// Global functions
+//*****************************************************************************
+
+uint64_t simNowUs(void)
+{
+    return (monotonicUs() - simStartUs);
+}
+
+void simOsInit(void)
+{
+    pthread_t thread;
+    int       ret;
+
+    simStartUs = monotonicUs();
+    condInit(&clockCond);
+
+    ret = pthread_create(&thread, NULL, clockThread, NULL);
+    assert(ret == 0);
+    pthread_detach(thread);
+    (void)ret;
+}
+
+void Event_construct(Event_Struct *event, const Event_Params *params)
+{
+    (void)params;
+
+    pthread_mutex_init(&event->mutex, NULL);
+    condInit(&event->cond);
+    event->posted = Event_Id_NONE;
+}
+
+void Event_post(Event_Handle handle, UInt eventMask)
+{
+    pthread_mutex_lock(&handle->mutex);
+    handle->posted |= eventMask;
+    pthread_cond_broadcast(&handle->cond);
+    pthread_mutex_unlock(&handle->mutex);
+}
+
+UInt Event_pend(Event_Handle handle, UInt andMask, UInt orMask, UInt timeout)
+{
+    struct timespec ts;
+    UInt            events = Event_Id_NONE;
+
+    if (timeout != BIOS_WAIT_FOREVER)
+    {
+        ts = monotonicAt(simNowUs() + (uint64_t)timeout * Clock_tickPeriod);
+    }
+
+    pthread_mutex_lock(&handle->mutex);
+    while (1)
+    {
+        UInt posted = handle->posted;
+
+        if (andMask != Event_Id_NONE && (posted & andMask) == andMask)
+        {
+            events = (posted & orMask) | andMask;
+            break;
+        }
+        if (posted & orMask)
+        {
+            events = posted & orMask;
+            break;
+        }
+        if (timeout == BIOS_NO_WAIT)
+        {
+            break;
+        }
+        if (timeout == BIOS_WAIT_FOREVER)
+        {
+            pthread_cond_wait(&handle->cond, &handle->mutex);
+        }
+        else if (pthread_cond_timedwait(&handle->cond, &handle->mutex, &ts)
+                 == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+    handle->posted &= ~events;
+    pthread_mutex_unlock(&handle->mutex);
+
+    return (events);
+}
+
+void Clock_Params_init(Clock_Params *params)
+{
+    params->period    = 0;
+    params->startFlag = false;
+    params->arg       = 0;
+}
+
+void Clock_construct(Clock_Struct *clock, Clock_FuncPtr fxn, uint32_t timeout,
+                     const Clock_Params *params)
+{
+    clock->fxn      = fxn;
+    clock->arg      = params->arg;
+    clock->timeout  = timeout;
+    clock->period   = params->period;
+    clock->expiryUs = 0;
+    clock->active   = false;
+    clock->next     = NULL;
+
+    if (params->startFlag)
+    {
+        Clock_start(clock);
+    }
+}
+
+void Clock_setTimeout(Clock_Handle handle, uint32_t timeout)
+{
+    pthread_mutex_lock(&clockMutex);
+    handle->timeout = timeout;
+    pthread_mutex_unlock(&clockMutex);
+}
+
+void Clock_start(Clock_Handle handle)
+{
+    pthread_mutex_lock(&clockMutex);
+    if (handle->active)
+    {
+        clockUnlink(handle);
+    }
+    handle->expiryUs = simNowUs() + (uint64_t)handle->timeout * Clock_tickPeriod;
+    handle->active   = true;
+    handle->next     = clockList;
+    clockList        = handle;
+    pthread_cond_signal(&clockCond);
+    pthread_mutex_unlock(&clockMutex);
+}
+
+void Clock_stop(Clock_Handle handle)
+{
+    pthread_mutex_lock(&clockMutex);
+    if (handle->active)
+    {
+        clockUnlink(handle);
+    }
+    pthread_mutex_unlock(&clockMutex);
+}
+
+bool Clock_isActive(Clock_Handle handle)
+{
+    bool active;
+
+    pthread_mutex_lock(&clockMutex);
+    active = handle->active;
+    pthread_mutex_unlock(&clockMutex);
+
+    return (active);
+}
+
+uint32_t Clock_getTicks(void)
+{
+    return ((uint32_t)(simNowUs() / Clock_tickPeriod));
+}
@@ -0,0 +1,1918 @@
+/******************************************************************************
+
+ @file  simot.c
+
+ @brief OpenThread API of the simulated nodes
+
+ The part of the OpenThread API the applications and otstack.c call, with
+ the mesh modelled instead of run. Each node has one UDP socket of the
+ host. It stands for the CoAP port of the node, with the border router and
+ the mesh between it and the peers:
+
+ - A datagram takes the one way mesh delay (-d) to go through, in either
+   direction.
+ - While the link mode is rx-off-when-idle, datagrams for the node wait in
+   its parent until the next data poll, at the poll period the application
+   set. An attached node sends at once.
+ - Datagrams to a mesh address go to the host socket the routes file maps
+   it to. Replies go back to the host socket the request came from.
+
+ The node attaches as a child when Thread is enabled and the node is
+ commissioned, and the joiner succeeds after a set time. SLAAC gives the
+ node an address in fd11:22::/64 with its node number in the IID, see
+ otIp6SlaacUpdate(). CoAP requests are dispatched to the resources by
+ their Uri-Path and unknown paths get 4.04, as in OpenThread. Nothing is
+ retransmitted, the modelled mesh loses no datagrams.
+
+ *****************************************************************************/
+
+#include <arpa/inet.h>
+#include <assert.h>
+#include <errno.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <ti/sysbios/knl/Clock.h>
+
+#include <openthread/coap.h>
+#include <openthread/dataset.h>
+#include <openthread/diag.h>
+#include <openthread/instance.h>
+#include <openthread/ip6.h>
+#include <openthread/joiner.h>
+#include <openthread/link.h>
+#include <openthread/message.h>
+#include <openthread/platform/random.h>
+#include <openthread/tasklet.h>
+#include <openthread/thread.h>
+
+#include <utils/code_utils.h>
+
+#include "platform/platform.h"
+#include "sim.h"
+
+//*****************************************************************************
+// Constants and definitions
+//*****************************************************************************
+
+// Largest datagram, the IPv6 minimum MTU
+#define SIM_MESSAGE_SIZE        1280
+
+// Messages in use at once, OT_ERROR_NO_BUFS past it
+#define SIM_MESSAGE_COUNT       32
+
+#define SIM_MAX_RESOURCES       16
+#define SIM_MAX_ROUTES          1024
+#define SIM_MAX_PENDING         8
+
+// Multicast groups a node is in, ff03::1 and the subscribed ones
+#define SIM_MAX_GROUPS          8
+
+// Time a request sent with a response handler waits for the response, ms
+#define SIM_RESPONSE_TIMEOUT    5000
+
+#define SIM_CHILD_TIMEOUT       240
+
+#define COAP_VERSION            1
+#define COAP_PAYLOAD_MARKER     0xFF
+
+struct otInstance
+{
+    int unused;
+};
+
+struct otMessage
+{
+    uint16_t length;
+    uint16_t offset;
+    uint8_t  buf[SIM_MESSAGE_SIZE];
+};
+
+/**
+ * A datagram on its way through the modelled mesh.
+ */
+typedef struct SimDatagram
+{
+    struct SimDatagram     *next;
+    uint64_t                dueUs;      // When it comes out of the mesh
+    bool                    inbound;    // To the node, else from it
+    bool                    multicast;  // Came in on a group socket
+    otIp6Address            group;      // Mesh address of that group
+    struct sockaddr_storage peer;       // Host socket of the peer
+    socklen_t               peerLen;
+    uint16_t                length;
+    uint8_t                 data[SIM_MESSAGE_SIZE];
+} SimDatagram;
+
+typedef struct
+{
+    otIp6Address            mesh;
+    struct sockaddr_storage host;
+    socklen_t               hostLen;
+} SimRoute;
+
+/**
+ * A multicast group of the mesh, and the host group socket standing for it.
+ */
+typedef struct
+{
+    int          sock;          // -1 if the entry is free
+    otIp6Address mesh;
+} SimGroup;
+
+/**
+ * A request waiting for its response.
+ */
+typedef struct
+{
+    bool                  used;
+    uint8_t               token[OT_COAP_MAX_TOKEN_LENGTH];
+    uint8_t               tokenLength;
+    uint64_t              deadlineUs;
+    otCoapResponseHandler handler;
+    void                 *context;
+} SimPending;
+
+/**
+ * A CoAP message taken apart.
+ */
+typedef struct
+{
+    otCoapType type;
+    otCoapCode code;
+    uint16_t   messageId;
+    uint8_t    tokenLength;
+    uint16_t   headerLength;    // Up to the payload marker
+    uint16_t   payloadOffset;
+    char       uriPath[128];
+} SimCoap;
+
+//*****************************************************************************
+// Local variables
+//*****************************************************************************
+
+static const SimNode_Config *simConfig;
+
+static struct otInstance simInstance;
+
+static int simSock = -1;
+static SimGroup simGroups[SIM_MAX_GROUPS];
+static int simFamily;
+
+// Datagrams in the mesh, and the ones out of it waiting for the stack
+static pthread_mutex_t simMutex = PTHREAD_MUTEX_INITIALIZER;
+static SimDatagram    *simMesh;
+static SimDatagram    *simRxHead;
+static SimDatagram   **simRxTail = &simRxHead;
+static int             simWake[2] = { -1, -1 };
+
+static int simMessages;
+
+static SimRoute simRoutes[SIM_MAX_ROUTES];
+static unsigned simRouteCount;
+
+// Stack state
+static bool             simIp6Enabled;
+static bool             simThreadEnabled;
+static bool             simCommissioned;
+static otDeviceRole     simRole = OT_DEVICE_ROLE_DISABLED;
+static otLinkModeConfig simLinkMode = {
+    .mRxOnWhenIdle       = 1,
+    .mSecureDataRequests = 1,
+    .mDeviceType         = 0,
+    .mNetworkData        = 0,
+};
+static otIp6Address     simAddress;
+
+/* Destination of the datagrams of the group socket, realm-local all nodes */
+static const otIp6Address simAllNodes = {
+    .mFields.m8 = { 0xff, 0x03, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 }
+};
+
+static otStateChangedCallback simStateCb;
+static void                  *simStateContext;
+static uint32_t               simStateFlags;
+
+static otJoinerCallback simJoinerCb;
+static void            *simJoinerContext;
+static bool             simJoinerDone;
+static Clock_Struct     simJoinClockStruct;
+
+static otCoapResource *simResources[SIM_MAX_RESOURCES];
+static SimPending      simPending[SIM_MAX_PENDING];
+static Clock_Struct    simPendingClockStruct;
+
+// Data polls of a sleepy node
+static uint32_t     simPollPeriod;
+static uint64_t     simLastPollUs;
+static Clock_Struct simPollClockStruct;
+
+// Counters for the energy report
+static uint32_t simTxDatagrams;
+static uint32_t simRxDatagrams;
+static uint32_t simPolls;
+
+//*****************************************************************************
+// Local functions
+//*****************************************************************************
+
+/* Wakes the mesh thread to look at the mesh again */
+static void meshWake(void)
+{
+    char c = 0;
+
+    (void)write(simWake[1], &c, 1);
+}
+
+/* Starts a one-shot Clock for a time in ms */
+static void clockStartMs(Clock_Struct *clock, uint32_t ms)
+{
+    Clock_stop(Clock_handle(clock));
+    Clock_setTimeout(Clock_handle(clock),
+                     ((ms * 1000U) + Clock_tickPeriod - 1) / Clock_tickPeriod);
+    Clock_start(Clock_handle(clock));
+}
+
+/* Host socket of an IPv6 address, as the socket family takes it */
+static bool hostAddress(const otIp6Address *aAddr, uint16_t aPort,
+                        struct sockaddr_storage *aHost, socklen_t *aLen)
+{
+    static const uint8_t v4Mapped[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                          0xff, 0xff };
+
+    memset(aHost, 0, sizeof(*aHost));
+    if (simFamily == AF_INET)
+    {
+        struct sockaddr_in *sin = (struct sockaddr_in *)aHost;
+
+        if (memcmp(aAddr->mFields.m8, v4Mapped, sizeof(v4Mapped)) != 0)
+        {
+            return (false);
+        }
+        sin->sin_family = AF_INET;
+        sin->sin_port   = htons(aPort);
+        memcpy(&sin->sin_addr, &aAddr->mFields.m8[12], 4);
+        *aLen = sizeof(*sin);
+    }
+    else
+    {
+        struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)aHost;
+
+        sin6->sin6_family = AF_INET6;
+        sin6->sin6_port   = htons(aPort);
+        memcpy(&sin6->sin6_addr, aAddr->mFields.m8, OT_IP6_ADDRESS_SIZE);
+        *aLen = sizeof(*sin6);
+    }
+
+    return (true);
+}
+
+/* IPv6 address and port of a host socket, IPv4 ones mapped */
+static void peerAddress(const struct sockaddr_storage *aHost,
+                        otIp6Address *aAddr, uint16_t *aPort)
+{
+    memset(aAddr, 0, sizeof(*aAddr));
+    if (aHost->ss_family == AF_INET)
+    {
+        const struct sockaddr_in *sin = (const struct sockaddr_in *)aHost;
+
+        aAddr->mFields.m8[10] = 0xff;
+        aAddr->mFields.m8[11] = 0xff;
+        memcpy(&aAddr->mFields.m8[12], &sin->sin_addr, 4);
+        *aPort = ntohs(sin->sin_port);
+    }
+    else
+    {
+        const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6 *)aHost;
+
+        memcpy(aAddr->mFields.m8, &sin6->sin6_addr, OT_IP6_ADDRESS_SIZE);
+        *aPort = ntohs(sin6->sin6_port);
+    }
+}
+
+/* Parses a host address and port into a socket address of simFamily */
+static bool parseHost(const char *aAddr, unsigned aPort,
+                      struct sockaddr_storage *aHost, socklen_t *aLen)
+{
+    otIp6Address addr;
+    struct in_addr in;
+
+    if (inet_pton(AF_INET6, aAddr, addr.mFields.m8) != 1)
+    {
+        if (inet_pton(AF_INET, aAddr, &in) != 1)
+        {
+            return (false);
+        }
+        memset(&addr, 0, sizeof(addr));
+        addr.mFields.m8[10] = 0xff;
+        addr.mFields.m8[11] = 0xff;
+        memcpy(&addr.mFields.m8[12], &in, 4);
+    }
+
+    return (hostAddress(&addr, (uint16_t)aPort, aHost, aLen));
+}
+
+/* Reads the routes file, lines of "<mesh address> <host address> <port>" */
+static int loadRoutes(const char *aPath)
+{
+    FILE *file = fopen(aPath, "r");
+    char  line[256];
+
+    if (file == NULL)
+    {
+        return (-1);
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        char      mesh[64];
+        char      host[64];
+        unsigned  port;
+        SimRoute *route = &simRoutes[simRouteCount];
+
+        if (line[0] == '#' || sscanf(line, "%63s %63s %u", mesh, host, &port) != 3)
+        {
+            continue;
+        }
+        if (simRouteCount == SIM_MAX_ROUTES ||
+            inet_pton(AF_INET6, mesh, route->mesh.mFields.m8) != 1 ||
+            !parseHost(host, port, &route->host, &route->hostLen))
+        {
+            simLog("routes: skipped %s", mesh);
+            continue;
+        }
+        simRouteCount++;
+    }
+
+    fclose(file);
+    return (0);
+}
+
+/* Opens a group socket, bound to the host group and in it on the
+   loopback, for the datagrams to a multicast group of the mesh */
+static int groupOpen(const struct sockaddr_storage *aHost, socklen_t aLen,
+                     const otIp6Address *aMesh)
+{
+    int      sock;
+    int      on = 1;
+    int      ret;
+    unsigned i;
+
+    sock = socket(simFamily, SOCK_DGRAM, 0);
+    if (sock < 0)
+    {
+        return (-1);
+    }
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0 ||
+        bind(sock, (const struct sockaddr *)aHost, aLen) != 0)
+    {
+        close(sock);
+        return (-1);
+    }
+
+    if (simFamily == AF_INET)
+    {
+        struct ip_mreq mreq;
+
+        mreq.imr_multiaddr        = ((const struct sockaddr_in *)aHost)->sin_addr;
+        mreq.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+        ret = setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq,
+                         sizeof(mreq));
+    }
+    else
+    {
+        struct ipv6_mreq mreq;
+
+        mreq.ipv6mr_multiaddr = ((const struct sockaddr_in6 *)aHost)->sin6_addr;
+        mreq.ipv6mr_interface = if_nametoindex("lo");
+        ret = setsockopt(sock, IPPROTO_IPV6, IPV6_JOIN_GROUP, &mreq,
+                         sizeof(mreq));
+    }
+    if (ret != 0)
+    {
+        close(sock);
+        return (-1);
+    }
+
+    pthread_mutex_lock(&simMutex);
+    for (i = 0; i < SIM_MAX_GROUPS && simGroups[i].sock >= 0; i++)
+    {
+    }
+    if (i < SIM_MAX_GROUPS)
+    {
+        simGroups[i].sock = sock;
+        simGroups[i].mesh = *aMesh;
+    }
+    pthread_mutex_unlock(&simMutex);
+
+    if (i == SIM_MAX_GROUPS)
+    {
+        close(sock);
+        errno = ENOBUFS;
+        return (-1);
+    }
+    meshWake();
+    return (0);
+}
+
+/* The entry of a multicast group of the mesh, NULL if not in it. Called
+   with simMutex held. */
+static SimGroup *groupFind(const otIp6Address *aMesh)
+{
+    unsigned i;
+
+    for (i = 0; i < SIM_MAX_GROUPS; i++)
+    {
+        if (simGroups[i].sock >= 0 &&
+            memcmp(&simGroups[i].mesh, aMesh, sizeof(*aMesh)) == 0)
+        {
+            return (&simGroups[i]);
+        }
+    }
+
+    return (NULL);
+}
+
+/* Host socket a datagram for a mesh address goes to */
+static bool resolve(const otIp6Address *aAddr, uint16_t aPort,
+                    struct sockaddr_storage *aHost, socklen_t *aLen)
+{
+    unsigned i;
+
+    for (i = 0; i < simRouteCount; i++)
+    {
+        if (memcmp(&simRoutes[i].mesh, aAddr, sizeof(*aAddr)) == 0)
+        {
+            *aHost = simRoutes[i].host;
+            *aLen  = simRoutes[i].hostLen;
+            return (true);
+        }
+    }
+
+    /* Not a mesh address, a host socket a request came from */
+    if (aAddr->mFields.m8[0] == 0xfd)
+    {
+        return (false);
+    }
+    return (hostAddress(aAddr, aPort, aHost, aLen));
+}
+
+/* Puts a datagram in the mesh, ordered by the time it comes out */
+static void meshPut(SimDatagram *aDatagram)
+{
+    SimDatagram **link;
+
+    aDatagram->dueUs = simNowUs() + (uint64_t)simConfig->delayMs * 1000U;
+
+    pthread_mutex_lock(&simMutex);
+    for (link = &simMesh; *link != NULL && (*link)->dueUs <= aDatagram->dueUs;
+         link = &(*link)->next)
+    {
+    }
+    aDatagram->next = *link;
+    *link = aDatagram;
+    pthread_mutex_unlock(&simMutex);
+
+    meshWake();
+}
+
+/* Hands the datagrams out of the mesh to the stack, on a data poll when
+   sleepy. Called with simMutex held. */
+static void rxRelease(void)
+{
+    if (simRxHead != NULL)
+    {
+        platformRadioSignal();
+    }
+}
+
+/* Receives from the node socket and moves datagrams through the mesh */
+static void *meshThread(void *arg)
+{
+    (void)arg;
+
+    while (1)
+    {
+        struct pollfd fds[2 + SIM_MAX_GROUPS];
+        otIp6Address  groups[2 + SIM_MAX_GROUPS];
+        int           count = 2;
+        int           i;
+        int           timeout = -1;
+        uint64_t      now = simNowUs();
+        SimDatagram  *datagram;
+
+        pthread_mutex_lock(&simMutex);
+        while (simMesh != NULL && simMesh->dueUs <= now)
+        {
+            datagram = simMesh;
+            simMesh  = datagram->next;
+
+            if (datagram->inbound)
+            {
+                datagram->next = NULL;
+                *simRxTail = datagram;
+                simRxTail  = &datagram->next;
+                if (simLinkMode.mRxOnWhenIdle)
+                {
+                    rxRelease();
+                }
+            }
+            else
+            {
+                (void)sendto(simSock, datagram->data, datagram->length, 0,
+                             (struct sockaddr *)&datagram->peer,
+                             datagram->peerLen);
+                free(datagram);
+            }
+        }
+        if (simMesh != NULL)
+        {
+            timeout = (int)((simMesh->dueUs - now + 999U) / 1000U);
+        }
+        for (i = 0; i < SIM_MAX_GROUPS; i++)
+        {
+            if (simGroups[i].sock >= 0)
+            {
+                fds[count].fd     = simGroups[i].sock;
+                fds[count].events = POLLIN;
+                groups[count]     = simGroups[i].mesh;
+                count++;
+            }
+        }
+        pthread_mutex_unlock(&simMutex);
+
+        fds[0].fd     = simSock;
+        fds[0].events = POLLIN;
+        fds[1].fd     = simWake[0];
+        fds[1].events = POLLIN;
+        if (poll(fds, (nfds_t)count, timeout) <= 0)
+        {
+            continue;
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            char buf[64];
+
+            (void)read(simWake[0], buf, sizeof(buf));
+        }
+
+        for (i = 0; i < count; i = (i == 0) ? 2 : i + 1)
+        {
+            ssize_t length;
+
+            if (!(fds[i].revents & POLLIN))
+            {
+                continue;
+            }
+
+            datagram = malloc(sizeof(*datagram));
+            assert(datagram != NULL);
+            datagram->peerLen = sizeof(datagram->peer);
+            length = recvfrom(fds[i].fd, datagram->data,
+                              sizeof(datagram->data), 0,
+                              (struct sockaddr *)&datagram->peer,
+                              &datagram->peerLen);
+            if (length <= 0)
+            {
+                free(datagram);
+                continue;
+            }
+            datagram->length    = (uint16_t)length;
+            datagram->inbound   = true;
+            datagram->multicast = (i >= 2);
+            datagram->group     = groups[i];
+            meshPut(datagram);
+        }
+    }
+
+    return (NULL);
+}
+
+/* A data poll of the sleepy node */
+static void pollClockHandler(UArg arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&simMutex);
+    simLastPollUs = simNowUs();
+    simPolls++;
+    if (!simLinkMode.mRxOnWhenIdle)
+    {
+        rxRelease();
+        if (simPollPeriod > 0)
+        {
+            clockStartMs(&simPollClockStruct, simPollPeriod);
+        }
+    }
+    pthread_mutex_unlock(&simMutex);
+}
+
+/* Sets the next data poll for the poll period from the last one */
+static void pollSchedule(void)
+{
+    uint64_t now = simNowUs();
+    uint64_t next;
+
+    Clock_stop(Clock_handle(&simPollClockStruct));
+    if (simLinkMode.mRxOnWhenIdle || simPollPeriod == 0 ||
+        simRole != OT_DEVICE_ROLE_CHILD)
+    {
+        return;
+    }
+
+    next = simLastPollUs + (uint64_t)simPollPeriod * 1000U;
+    clockStartMs(&simPollClockStruct,
+                 (next > now) ? (uint32_t)((next - now) / 1000U) : 0);
+}
+
+/* The joiner is done */
+static void joinClockHandler(UArg arg)
+{
+    (void)arg;
+
+    simJoinerDone = true;
+    otTaskletsSignalPending(&simInstance);
+}
+
+/* Checks the requests waiting for a response for the timeout */
+static void pendingClockHandler(UArg arg)
+{
+    (void)arg;
+
+    platformRadioSignal();
+}
+
+/* Flags a state change for the callback, run from the tasklets */
+static void stateChanged(uint32_t aFlags)
+{
+    simStateFlags |= aFlags;
+    otTaskletsSignalPending(&simInstance);
+}
+
+/* Attaches or detaches, as Thread is enabled and commissioned */
+static void updateRole(void)
+{
+    otDeviceRole role = OT_DEVICE_ROLE_DISABLED;
+
+    if (simThreadEnabled)
+    {
+        role = simCommissioned ? OT_DEVICE_ROLE_CHILD : OT_DEVICE_ROLE_DETACHED;
+    }
+    if (role == simRole)
+    {
+        return;
+    }
+
+    simRole = role;
+    if (role == OT_DEVICE_ROLE_CHILD)
+    {
+        simLastPollUs = simNowUs();
+        stateChanged(OT_CHANGED_THREAD_ROLE | OT_CHANGED_THREAD_NETDATA);
+    }
+    else
+    {
+        stateChanged(OT_CHANGED_THREAD_ROLE);
+    }
+    pollSchedule();
+}
+
+/* Reads the delta and length of the option at *aOffset, and moves
+   *aOffset to its value */
+static bool optionParse(const uint8_t *aBuf, uint16_t aLength,
+                        uint16_t *aOffset, uint16_t *aDelta, uint16_t *aValueLength)
+{
+    uint16_t offset = *aOffset;
+    uint16_t delta  = aBuf[offset] >> 4;
+    uint16_t length = aBuf[offset] & 0xf;
+
+    offset++;
+    if (delta == 13)
+    {
+        otEXPECT(offset < aLength);
+        delta = 13 + aBuf[offset++];
+    }
+    else if (delta == 14)
+    {
+        otEXPECT(offset + 1 < aLength);
+        delta = 269 + ((aBuf[offset] << 8) | aBuf[offset + 1]);
+        offset += 2;
+    }
+    if (length == 13)
+    {
+        otEXPECT(offset < aLength);
+        length = 13 + aBuf[offset++];
+    }
+    else if (length == 14)
+    {
+        otEXPECT(offset + 1 < aLength);
+        length = 269 + ((aBuf[offset] << 8) | aBuf[offset + 1]);
+        offset += 2;
+    }
+    otEXPECT(delta != 15 && length != 15 && offset + length <= aLength);
+
+    *aOffset      = offset;
+    *aDelta       = delta;
+    *aValueLength = length;
+    return (true);
+
+exit:
+    return (false);
+}
+
+/* Takes a CoAP message apart */
+static bool coapParse(const uint8_t *aBuf, uint16_t aLength, SimCoap *aCoap)
+{
+    uint16_t offset;
+    uint16_t option = 0;
+    size_t   pathLength = 0;
+
+    if (aLength < 4 || (aBuf[0] >> 6) != COAP_VERSION)
+    {
+        return (false);
+    }
+
+    aCoap->type        = (otCoapType)((aBuf[0] >> 4) & 0x3);
+    aCoap->tokenLength = aBuf[0] & 0xf;
+    aCoap->code        = (otCoapCode)aBuf[1];
+    aCoap->messageId   = (uint16_t)((aBuf[2] << 8) | aBuf[3]);
+    aCoap->uriPath[0]  = '\0';
+
+    offset = 4 + aCoap->tokenLength;
+    if (aCoap->tokenLength > OT_COAP_MAX_TOKEN_LENGTH || offset > aLength)
+    {
+        return (false);
+    }
+
+    while (offset < aLength && aBuf[offset] != COAP_PAYLOAD_MARKER)
+    {
+        uint16_t delta;
+        uint16_t length;
+
+        otEXPECT(optionParse(aBuf, aLength, &offset, &delta, &length));
+
+        option += delta;
+        if (option == OT_COAP_OPTION_URI_PATH)
+        {
+            otEXPECT(pathLength + length + 2 < sizeof(aCoap->uriPath));
+            if (pathLength > 0)
+            {
+                aCoap->uriPath[pathLength++] = '/';
+            }
+            memcpy(&aCoap->uriPath[pathLength], &aBuf[offset], length);
+            pathLength += length;
+            aCoap->uriPath[pathLength] = '\0';
+        }
+        offset += length;
+    }
+
+    aCoap->headerLength  = offset;
+    aCoap->payloadOffset = (offset < aLength) ? offset + 1 : offset;
+    return (true);
+
+exit:
+    return (false);
+}
+
+/* The option at mNextOptionOffset, after mOption */
+static const otCoapOption *optionNext(otCoapHeader *aHeader)
+{
+    uint16_t offset = aHeader->mNextOptionOffset;
+    uint16_t delta;
+    uint16_t length;
+
+    if (offset == 0 || offset >= aHeader->mHeaderLength ||
+        aHeader->mHeader[offset] == COAP_PAYLOAD_MARKER ||
+        !optionParse(aHeader->mHeader, aHeader->mHeaderLength, &offset, &delta,
+                     &length))
+    {
+        aHeader->mNextOptionOffset = 0;
+        return (NULL);
+    }
+
+    aHeader->mOption.mNumber  += delta;
+    aHeader->mOption.mLength   = length;
+    aHeader->mOption.mValue    = &aHeader->mHeader[offset];
+    aHeader->mNextOptionOffset = offset + length;
+    return (&aHeader->mOption);
+}
+
+/* Allocates a message, counted against the message pool */
+static otMessage *messageNew(void)
+{
+    otMessage *message = NULL;
+
+    pthread_mutex_lock(&simMutex);
+    if (simMessages < SIM_MESSAGE_COUNT)
+    {
+        message = malloc(sizeof(*message));
+        if (message != NULL)
+        {
+            simMessages++;
+            message->length = 0;
+            message->offset = 0;
+        }
+    }
+    pthread_mutex_unlock(&simMutex);
+
+    return (message);
+}
+
+/* Sends a CoAP message through the mesh, and frees it */
+static otError coapSend(otMessage *aMessage, const otMessageInfo *aMessageInfo)
+{
+    SimDatagram *datagram;
+    uint16_t     length = aMessage->length;
+
+    datagram = malloc(sizeof(*datagram));
+    if (datagram == NULL)
+    {
+        return (OT_ERROR_NO_BUFS);
+    }
+    if (!resolve(&aMessageInfo->mPeerAddr, aMessageInfo->mPeerPort,
+                 &datagram->peer, &datagram->peerLen))
+    {
+        char addr[INET6_ADDRSTRLEN];
+
+        inet_ntop(AF_INET6, aMessageInfo->mPeerAddr.mFields.m8, addr,
+                  sizeof(addr));
+        simLog("no route to %s", addr);
+        free(datagram);
+        otMessageFree(aMessage);
+        return (OT_ERROR_NONE);
+    }
+
+    /* A payload marker with no payload after it is left out */
+    if (length > 4 && aMessage->buf[length - 1] == COAP_PAYLOAD_MARKER)
+    {
+        SimCoap coap;
+
+        if (coapParse(aMessage->buf, length, &coap) &&
+            coap.payloadOffset == length)
+        {
+            length--;
+        }
+    }
+
+    memcpy(datagram->data, aMessage->buf, length);
+    datagram->length    = length;
+    datagram->inbound   = false;
+    datagram->multicast = false;
+    otMessageFree(aMessage);
+
+    pthread_mutex_lock(&simMutex);
+    simTxDatagrams++;
+    pthread_mutex_unlock(&simMutex);
+
+    meshPut(datagram);
+    return (OT_ERROR_NONE);
+}
+
+/* Replies to a request with an empty message of a code */
+static void coapReply(const uint8_t *aRequest, const SimCoap *aCoap,
+                      otCoapType aType, otCoapCode aCode,
+                      const otMessageInfo *aMessageInfo)
+{
+    otCoapHeader header;
+    otMessage   *message;
+
+    otCoapHeaderInit(&header, aType, aCode);
+    otCoapHeaderSetMessageId(&header, aCoap->messageId);
+    otCoapHeaderSetToken(&header, &aRequest[4], aCoap->tokenLength);
+
+    message = otCoapNewMessage(&simInstance, &header);
+    if (message != NULL && coapSend(message, aMessageInfo) != OT_ERROR_NONE)
+    {
+        otMessageFree(message);
+    }
+}
+
+/* Hands a response to the request waiting for it */
+static void coapResponse(SimDatagram *aDatagram, const SimCoap *aCoap,
+                         otCoapHeader *aHeader, otMessage *aMessage,
+                         const otMessageInfo *aMessageInfo)
+{
+    unsigned i;
+
+    for (i = 0; i < SIM_MAX_PENDING; i++)
+    {
+        SimPending *pending = &simPending[i];
+
+        if (pending->used && pending->tokenLength == aCoap->tokenLength &&
+            memcmp(pending->token, &aDatagram->data[4], aCoap->tokenLength) == 0)
+        {
+            pending->used = false;
+            pending->handler(pending->context, aHeader, aMessage, aMessageInfo,
+                             OT_ERROR_NONE);
+            break;
+        }
+    }
+}
+
+/* Times out the requests that waited too long for a response */
+static void pendingExpire(void)
+{
+    uint64_t now = simNowUs();
+    unsigned i;
+
+    for (i = 0; i < SIM_MAX_PENDING; i++)
+    {
+        SimPending *pending = &simPending[i];
+
+        if (pending->used && pending->deadlineUs <= now)
+        {
+            pending->used = false;
+            pending->handler(pending->context, NULL, NULL, NULL,
+                             OT_ERROR_RESPONSE_TIMEOUT);
+        }
+    }
+}
+
+/* Dispatches a datagram that reached the stack */
+static void receive(SimDatagram *aDatagram)
+{
+    SimCoap       coap;
+    otCoapHeader  header;
+    otMessage    *message;
+    otMessageInfo messageInfo;
+    unsigned      i;
+
+    if (!coapParse(aDatagram->data, aDatagram->length, &coap) ||
+        coap.headerLength > sizeof(header.mHeader))
+    {
+        return;
+    }
+
+    memset(&messageInfo, 0, sizeof(messageInfo));
+    peerAddress(&aDatagram->peer, &messageInfo.mPeerAddr,
+                &messageInfo.mPeerPort);
+    messageInfo.mSockAddr    = aDatagram->multicast ? aDatagram->group
+                                                    : simAddress;
+    messageInfo.mSockPort    = OT_DEFAULT_COAP_PORT;
+    messageInfo.mInterfaceId = OT_NETIF_INTERFACE_ID_THREAD;
+
+    if (coap.code == OT_COAP_CODE_EMPTY)
+    {
+        /* A CoAP ping gets a reset */
+        if (coap.type == OT_COAP_TYPE_CONFIRMABLE)
+        {
+            coapReply(aDatagram->data, &coap, OT_COAP_TYPE_RESET,
+                      OT_COAP_CODE_EMPTY, &messageInfo);
+        }
+        return;
+    }
+
+    memcpy(header.mHeader, aDatagram->data, coap.headerLength);
+    header.mHeaderLength = (uint8_t)coap.headerLength;
+    header.mOptionLast   = 0;
+    header.mNextOptionOffset = 0;
+
+    message = messageNew();
+    if (message == NULL)
+    {
+        return;
+    }
+    memcpy(message->buf, aDatagram->data, aDatagram->length);
+    message->length = aDatagram->length;
+    message->offset = coap.payloadOffset;
+
+    if (coap.code >= OT_COAP_CODE_RESPONSE_MIN)
+    {
+        coapResponse(aDatagram, &coap, &header, message, &messageInfo);
+    }
+    else
+    {
+        otCoapResource *resource = NULL;
+
+        for (i = 0; i < SIM_MAX_RESOURCES; i++)
+        {
+            if (simResources[i] != NULL &&
+                strcmp(simResources[i]->mUriPath, coap.uriPath) == 0)
+            {
+                resource = simResources[i];
+                break;
+            }
+        }
+
+        if (resource != NULL)
+        {
+            resource->mHandler(resource->mContext, &header, message,
+                               &messageInfo);
+        }
+        else
+        {
+            coapReply(aDatagram->data, &coap,
+                      (coap.type == OT_COAP_TYPE_CONFIRMABLE)
+                          ? OT_COAP_TYPE_ACKNOWLEDGMENT
+                          : OT_COAP_TYPE_NON_CONFIRMABLE,
+                      OT_COAP_CODE_NOT_FOUND, &messageInfo);
+        }
+    }
+
+    otMessageFree(message);
+}
+
+//*****************************************************************************
+// Global functions
+//*****************************************************************************
+
+int simOtInit(const SimNode_Config *aConfig)
+{
+    struct sockaddr_storage addr;
+    socklen_t               addrLen;
+    Clock_Params            clockParams;
+    pthread_t               thread;
+    unsigned                i;
+
+    for (i = 0; i < SIM_MAX_GROUPS; i++)
+    {
+        simGroups[i].sock = -1;
+    }
+
+    simConfig       = aConfig;
+    simCommissioned = aConfig->commissioned;
+    srandom((unsigned)getpid() ^ ((unsigned)aConfig->id << 16));
+
+    /* The routes take the family of the node socket */
+    simFamily = AF_INET6;
+    if (strchr(aConfig->bindAddr, ':') == NULL)
+    {
+        simFamily = AF_INET;
+    }
+    if (aConfig->routes != NULL && loadRoutes(aConfig->routes) != 0)
+    {
+        return (-1);
+    }
+    if (!parseHost(aConfig->bindAddr, aConfig->port, &addr, &addrLen))
+    {
+        errno = EINVAL;
+        return (-1);
+    }
+
+    simSock = socket(simFamily, SOCK_DGRAM, 0);
+    if (simSock < 0 || bind(simSock, (struct sockaddr *)&addr, addrLen) != 0 ||
+        pipe(simWake) != 0)
+    {
+        return (-1);
+    }
+    if (aConfig->group != NULL &&
+        (!parseHost(aConfig->group, aConfig->groupPort, &addr, &addrLen) ||
+         groupOpen(&addr, addrLen, &simAllNodes) != 0))
+    {
+        return (-1);
+    }
+
+    Clock_Params_init(&clockParams);
+    Clock_construct(&simPollClockStruct, pollClockHandler, 1, &clockParams);
+    Clock_construct(&simJoinClockStruct, joinClockHandler, 1, &clockParams);
+    Clock_construct(&simPendingClockStruct, pendingClockHandler, 1,
+                    &clockParams);
+
+    if (pthread_create(&thread, NULL, meshThread, NULL) != 0)
+    {
+        return (-1);
+    }
+    pthread_detach(thread);
+
+    return (0);
+}
+
+bool simOtCommand(const char *aLine)
+{
+    if (strcmp(aLine, "stats") == 0)
+    {
+        char addr[INET6_ADDRSTRLEN];
+
+        pthread_mutex_lock(&simMutex);
+        inet_ntop(AF_INET6, simAddress.mFields.m8, addr, sizeof(addr));
+        simLog("stats role=%d addr=%s poll=%lu rx=%lu tx=%lu polls=%lu",
+               (int)simRole, addr, (unsigned long)simPollPeriod,
+               (unsigned long)simRxDatagrams, (unsigned long)simTxDatagrams,
+               (unsigned long)simPolls);
+        pthread_mutex_unlock(&simMutex);
+        return (true);
+    }
+
+    return (false);
+}
+
+/**
+ * Function documented in platform.h
+ */
+void PlatformInit(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+}
+
+/**
+ * Function documented in platform.h
+ */
+uint64_t platformAlarmGetNowUs(void)
+{
+    return (simNowUs());
+}
+
+/**
+ * Function documented in platform.h
+ */
+void platformAlarmProcess(otInstance *aInstance)
+{
+    (void)aInstance;
+}
+
+/**
+ * Function documented in platform.h
+ */
+void platformAlarmMicroProcess(otInstance *aInstance)
+{
+    (void)aInstance;
+}
+
+/**
+ * Function documented in platform.h
+ */
+void platformUartProcess(void)
+{
+}
+
+/**
+ * Function documented in platform.h
+ */
+void platformRandomProcess(void)
+{
+}
+
+/**
+ * Function documented in platform.h
+ */
+void platformRadioProcess(otInstance *aInstance)
+{
+    SimDatagram *datagram;
+
+    (void)aInstance;
+
+    while (1)
+    {
+        pthread_mutex_lock(&simMutex);
+        datagram = simRxHead;
+        if (datagram != NULL)
+        {
+            simRxHead = datagram->next;
+            if (simRxHead == NULL)
+            {
+                simRxTail = &simRxHead;
+            }
+            simRxDatagrams++;
+        }
+        pthread_mutex_unlock(&simMutex);
+
+        if (datagram == NULL)
+        {
+            break;
+        }
+        receive(datagram);
+        free(datagram);
+    }
+
+    pendingExpire();
+}
+
+/**
+ * Function documented in platform.h
+ *
+ * The shim has no radio to time, it counts the datagrams sent and the data
+ * polls.
+ */
+void platformEnergyGetStats(PlatformEnergy_Stats *aStats)
+{
+    memset(aStats, 0, sizeof(*aStats));
+
+    pthread_mutex_lock(&simMutex);
+    aStats->txFrames    = simTxDatagrams + simPolls;
+    aStats->radioStarts = simTxDatagrams + simPolls;
+    pthread_mutex_unlock(&simMutex);
+}
+
+/**
+ * Function documented in platform.h
+ */
+void platformEnergyClear(void)
+{
+    pthread_mutex_lock(&simMutex);
+    simTxDatagrams = 0;
+    simPolls       = 0;
+    pthread_mutex_unlock(&simMutex);
+}
+
+/**
+ * Function documented in platform.h
+ *
+ * The joiner of the shim runs no handshake.
+ */
+void platformEcjpakeGetProfile(PlatformEcjpake_Profile *aProfile)
+{
+    memset(aProfile, 0, sizeof(*aProfile));
+}
+
+uint32_t otPlatRandomGet(void)
+{
+    return ((uint32_t)random());
+}
+
+otInstance *otInstanceInitSingle(void)
+{
+    return (&simInstance);
+}
+
+void otInstanceFactoryReset(otInstance *aInstance)
+{
+    (void)aInstance;
+
+    simCommissioned = false;
+    updateRole();
+}
+
+otError otSetStateChangedCallback(otInstance *aInstance,
+                                  otStateChangedCallback aCallback,
+                                  void *aContext)
+{
+    (void)aInstance;
+
+    simStateCb      = aCallback;
+    simStateContext = aContext;
+    return (OT_ERROR_NONE);
+}
+
+void otTaskletsProcess(otInstance *aInstance)
+{
+    uint32_t flags = simStateFlags;
+
+    simStateFlags = 0;
+    if (flags != 0 && simStateCb != NULL)
+    {
+        simStateCb(flags, simStateContext);
+    }
+
+    if (simJoinerDone)
+    {
+        otJoinerCallback callback = simJoinerCb;
+
+        simJoinerDone   = false;
+        simJoinerCb     = NULL;
+        simCommissioned = true;
+        simLog("joiner: done");
+        if (callback != NULL)
+        {
+            callback(OT_ERROR_NONE, simJoinerContext);
+        }
+    }
+
+    (void)aInstance;
+}
+
+void otDiagInit(otInstance *aInstance)
+{
+    (void)aInstance;
+}
+
+bool otDatasetIsCommissioned(otInstance *aInstance)
+{
+    (void)aInstance;
+
+    return (simCommissioned);
+}
+
+otError otIp6SetEnabled(otInstance *aInstance, bool aEnabled)
+{
+    (void)aInstance;
+
+    simIp6Enabled = aEnabled;
+    if (!aEnabled && simThreadEnabled)
+    {
+        simThreadEnabled = false;
+        updateRole();
+    }
+    return (OT_ERROR_NONE);
+}
+
+bool otIp6IsEnabled(otInstance *aInstance)
+{
+    (void)aInstance;
+
+    return (simIp6Enabled);
+}
+
+/*
+ * The mesh has one on-mesh prefix, fd11:22::/64. The IID is the node
+ * number in its second to last 16 bits, then what aIidCreate sets in the
+ * last byte. Node 0 gets the address of the firmware.
+ */
+void otIp6SlaacUpdate(otInstance *aInstance, otNetifAddress *aAddresses,
+                      uint32_t aNumAddresses, otIp6SlaacIidCreate aIidCreate,
+                      void *aContext)
+{
+    static const uint8_t prefix[8] = { 0xfd, 0x11, 0x00, 0x22 };
+    otNetifAddress *address = &aAddresses[0];
+    char            addr[INET6_ADDRSTRLEN];
+
+    if (aNumAddresses == 0 || address->mValid || simRole != OT_DEVICE_ROLE_CHILD)
+    {
+        return;
+    }
+
+    memset(address, 0, sizeof(*address));
+    memcpy(address->mAddress.mFields.m8, prefix, sizeof(prefix));
+    address->mAddress.mFields.m8[12] = (uint8_t)(simConfig->id >> 8);
+    address->mAddress.mFields.m8[13] = (uint8_t)simConfig->id;
+    address->mPrefixLength = 64;
+    address->mPreferred    = true;
+    address->mValid        = true;
+
+    (void)aIidCreate(aInstance, address, aContext);
+    simAddress = address->mAddress;
+
+    inet_ntop(AF_INET6, simAddress.mFields.m8, addr, sizeof(addr));
+    simLog("address %s", addr);
+}
+
+otError otIp6AddressFromString(const char *aString, otIp6Address *aAddress)
+{
+    return (inet_pton(AF_INET6, aString, aAddress->mFields.m8) == 1)
+               ? OT_ERROR_NONE : OT_ERROR_INVALID_ARGS;
+}
+
+/*
+ * The routes file maps the group to a host group and port, which the node
+ * joins. A group with no route is only logged, nothing reaches it.
+ */
+otError otIp6SubscribeMulticastAddress(otInstance *aInstance,
+                                       const otIp6Address *aAddress)
+{
+    char     addr[INET6_ADDRSTRLEN];
+    bool     found;
+    unsigned i;
+
+    (void)aInstance;
+
+    if (aAddress->mFields.m8[0] != 0xff)
+    {
+        return (OT_ERROR_INVALID_ARGS);
+    }
+
+    pthread_mutex_lock(&simMutex);
+    found = (groupFind(aAddress) != NULL);
+    pthread_mutex_unlock(&simMutex);
+    if (found)
+    {
+        return (OT_ERROR_ALREADY);
+    }
+
+    inet_ntop(AF_INET6, aAddress->mFields.m8, addr, sizeof(addr));
+    for (i = 0; i < simRouteCount; i++)
+    {
+        if (memcmp(&simRoutes[i].mesh, aAddress, sizeof(*aAddress)) == 0)
+        {
+            if (groupOpen(&simRoutes[i].host, simRoutes[i].hostLen,
+                          aAddress) != 0)
+            {
+                simLog("group %s: %s", addr, strerror(errno));
+                return (OT_ERROR_NO_BUFS);
+            }
+            simLog("group %s", addr);
+            return (OT_ERROR_NONE);
+        }
+    }
+
+    simLog("no route to group %s", addr);
+    return (OT_ERROR_NONE);
+}
+
+otError otIp6UnsubscribeMulticastAddress(otInstance *aInstance,
+                                         const otIp6Address *aAddress)
+{
+    SimGroup *group;
+    int       sock = -1;
+
+    (void)aInstance;
+
+    pthread_mutex_lock(&simMutex);
+    group = groupFind(aAddress);
+    if (group != NULL)
+    {
+        sock        = group->sock;
+        group->sock = -1;
+    }
+    pthread_mutex_unlock(&simMutex);
+
+    if (sock < 0)
+    {
+        return (OT_ERROR_NOT_FOUND);
+    }
+    meshWake();
+    close(sock);
+    return (OT_ERROR_NONE);
+}
+
+otError otJoinerStart(otInstance *aInstance, const char *aPSKd,
+                      const char *aProvisioningUrl, const char *aVendorName,
+                      const char *aVendorModel, const char *aVendorSwVersion,
+                      const char *aVendorData, otJoinerCallback aCallback,
+                      void *aContext)
+{
+    (void)aInstance;
+    (void)aPSKd;
+    (void)aProvisioningUrl;
+    (void)aVendorName;
+    (void)aVendorModel;
+    (void)aVendorSwVersion;
+    (void)aVendorData;
+
+    if (!simIp6Enabled || simJoinerCb != NULL)
+    {
+        return (OT_ERROR_INVALID_STATE);
+    }
+
+    simJoinerCb      = aCallback;
+    simJoinerContext = aContext;
+    clockStartMs(&simJoinClockStruct, simConfig->joinMs);
+    return (OT_ERROR_NONE);
+}
+
+void otLinkGetFactoryAssignedIeeeEui64(otInstance *aInstance,
+                                       otExtAddress *aEui64)
+{
+    static const uint8_t oui[3] = { 0x00, 0x12, 0x4b };
+
+    (void)aInstance;
+
+    memset(aEui64, 0, sizeof(*aEui64));
+    memcpy(aEui64->m8, oui, sizeof(oui));
+    aEui64->m8[6] = (uint8_t)(simConfig->id >> 8);
+    aEui64->m8[7] = (uint8_t)simConfig->id;
+}
+
+otError otLinkSetChannel(otInstance *aInstance, uint8_t aChannel)
+{
+    (void)aInstance;
+    (void)aChannel;
+
+    return (OT_ERROR_NONE);
+}
+
+otError otLinkSetPanId(otInstance *aInstance, otPanId aPanId)
+{
+    (void)aInstance;
+    (void)aPanId;
+
+    return (OT_ERROR_NONE);
+}
+
+uint32_t otLinkGetPollPeriod(otInstance *aInstance)
+{
+    (void)aInstance;
+
+    return (simPollPeriod);
+}
+
+/*
+ * As in OpenThread, the next poll is a period after the last one, at once
+ * if that has passed.
+ */
+otError otLinkSetPollPeriod(otInstance *aInstance, uint32_t aPollPeriod)
+{
+    (void)aInstance;
+
+    pthread_mutex_lock(&simMutex);
+    simPollPeriod = aPollPeriod;
+    pthread_mutex_unlock(&simMutex);
+
+    pollSchedule();
+    return (OT_ERROR_NONE);
+}
+
+otError otThreadSetEnabled(otInstance *aInstance, bool aEnabled)
+{
+    (void)aInstance;
+
+    if (aEnabled && !simIp6Enabled)
+    {
+        return (OT_ERROR_INVALID_STATE);
+    }
+    simThreadEnabled = aEnabled;
+    updateRole();
+    return (OT_ERROR_NONE);
+}
+
+otDeviceRole otThreadGetDeviceRole(otInstance *aInstance)
+{
+    (void)aInstance;
+
+    return (simRole);
+}
+
+otLinkModeConfig otThreadGetLinkMode(otInstance *aInstance)
+{
+    (void)aInstance;
+
+    return (simLinkMode);
+}
+
+otError otThreadSetLinkMode(otInstance *aInstance, otLinkModeConfig aConfig)
+{
+    (void)aInstance;
+
+    pthread_mutex_lock(&simMutex);
+    simLinkMode = aConfig;
+    if (aConfig.mRxOnWhenIdle)
+    {
+        rxRelease();
+    }
+    pthread_mutex_unlock(&simMutex);
+
+    pollSchedule();
+    return (OT_ERROR_NONE);
+}
+
+uint32_t otThreadGetChildTimeout(otInstance *aInstance)
+{
+    (void)aInstance;
+
+    return (SIM_CHILD_TIMEOUT);
+}
+
+otError otThreadSetExtendedPanId(otInstance *aInstance,
+                                 const otExtendedPanId *aExtendedPanId)
+{
+    (void)aInstance;
+    (void)aExtendedPanId;
+
+    return (OT_ERROR_NONE);
+}
+
+void otMessageFree(otMessage *aMessage)
+{
+    free(aMessage);
+
+    pthread_mutex_lock(&simMutex);
+    simMessages--;
+    pthread_mutex_unlock(&simMutex);
+}
+
+uint16_t otMessageGetLength(otMessage *aMessage)
+{
+    return (aMessage->length);
+}
+
+uint16_t otMessageGetOffset(otMessage *aMessage)
+{
+    return (aMessage->offset);
+}
+
+otError otMessageAppend(otMessage *aMessage, const void *aBuf, uint16_t aLength)
+{
+    if (aLength > sizeof(aMessage->buf) - aMessage->length)
+    {
+        return (OT_ERROR_NO_BUFS);
+    }
+
+    memcpy(&aMessage->buf[aMessage->length], aBuf, aLength);
+    aMessage->length += aLength;
+    return (OT_ERROR_NONE);
+}
+
+int otMessageRead(otMessage *aMessage, uint16_t aOffset, void *aBuf,
+                  uint16_t aLength)
+{
+    if (aOffset >= aMessage->length)
+    {
+        return (0);
+    }
+    if (aLength > aMessage->length - aOffset)
+    {
+        aLength = aMessage->length - aOffset;
+    }
+
+    memcpy(aBuf, &aMessage->buf[aOffset], aLength);
+    return (aLength);
+}
+
+void otCoapHeaderInit(otCoapHeader *aHeader, otCoapType aType, otCoapCode aCode)
+{
+    memset(aHeader, 0, sizeof(*aHeader));
+    aHeader->mHeader[0]    = (uint8_t)((COAP_VERSION << 6) | (aType << 4));
+    aHeader->mHeader[1]    = (uint8_t)aCode;
+    aHeader->mHeaderLength = 4;
+}
+
+void otCoapHeaderSetToken(otCoapHeader *aHeader, const uint8_t *aToken,
+                          uint8_t aTokenLength)
+{
+    aHeader->mHeader[0] = (uint8_t)((aHeader->mHeader[0] & 0xf0) | aTokenLength);
+    memcpy(&aHeader->mHeader[4], aToken, aTokenLength);
+    aHeader->mHeaderLength = 4 + aTokenLength;
+}
+
+void otCoapHeaderGenerateToken(otCoapHeader *aHeader, uint8_t aTokenLength)
+{
+    uint8_t token[OT_COAP_MAX_TOKEN_LENGTH];
+    uint8_t i;
+
+    for (i = 0; i < aTokenLength; i++)
+    {
+        token[i] = (uint8_t)random();
+    }
+    otCoapHeaderSetToken(aHeader, token, aTokenLength);
+}
+
+static otError appendOption(otCoapHeader *aHeader, uint16_t aNumber,
+                            uint16_t aLength, const void *aValue)
+{
+    uint16_t delta = aNumber - aHeader->mOptionLast;
+    uint8_t  field[5];
+    uint8_t  fieldLength = 1;
+    uint8_t  nibble;
+
+    if (aNumber < aHeader->mOptionLast ||
+        aHeader->mHeaderLength + 5 + aLength > (int)sizeof(aHeader->mHeader))
+    {
+        return (OT_ERROR_NO_BUFS);
+    }
+
+    if (delta < 13)
+    {
+        nibble = (uint8_t)(delta << 4);
+    }
+    else if (delta < 269)
+    {
+        nibble = 13 << 4;
+        field[fieldLength++] = (uint8_t)(delta - 13);
+    }
+    else
+    {
+        nibble = 14 << 4;
+        field[fieldLength++] = (uint8_t)((delta - 269) >> 8);
+        field[fieldLength++] = (uint8_t)(delta - 269);
+    }
+
+    if (aLength < 13)
+    {
+        nibble |= (uint8_t)aLength;
+    }
+    else if (aLength < 269)
+    {
+        nibble |= 13;
+        field[fieldLength++] = (uint8_t)(aLength - 13);
+    }
+    else
+    {
+        nibble |= 14;
+        field[fieldLength++] = (uint8_t)((aLength - 269) >> 8);
+        field[fieldLength++] = (uint8_t)(aLength - 269);
+    }
+    field[0] = nibble;
+
+    memcpy(&aHeader->mHeader[aHeader->mHeaderLength], field, fieldLength);
+    aHeader->mHeaderLength += fieldLength;
+    memcpy(&aHeader->mHeader[aHeader->mHeaderLength], aValue, aLength);
+    aHeader->mHeaderLength += aLength;
+    aHeader->mOptionLast = aNumber;
+
+    return (OT_ERROR_NONE);
+}
+
+otError otCoapHeaderAppendOption(otCoapHeader *aHeader,
+                                 const otCoapOption *aOption)
+{
+    return (appendOption(aHeader, aOption->mNumber, aOption->mLength,
+                         aOption->mValue));
+}
+
+otError otCoapHeaderAppendMaxAgeOption(otCoapHeader *aHeader, uint32_t aMaxAge)
+{
+    uint8_t  value[4];
+    uint16_t length = 0;
+    int      shift;
+
+    /* An unsigned option, in as few bytes as it takes */
+    for (shift = 24; shift >= 0; shift -= 8)
+    {
+        if (length > 0 || (aMaxAge >> shift) != 0)
+        {
+            value[length++] = (uint8_t)(aMaxAge >> shift);
+        }
+    }
+
+    return (appendOption(aHeader, OT_COAP_OPTION_MAX_AGE, length, value));
+}
+
+otError otCoapHeaderAppendContentFormatOption(otCoapHeader *aHeader,
+                                    otCoapOptionContentFormat aContentFormat)
+{
+    uint8_t value = (uint8_t)aContentFormat;
+
+    /* The formats the nodes use fit one byte, 0 is sent empty */
+    return (appendOption(aHeader, OT_COAP_OPTION_CONTENT_FORMAT,
+                         (value != 0) ? 1 : 0, &value));
+}
+
+otError otCoapHeaderAppendUriPathOptions(otCoapHeader *aHeader,
+                                         const char *aUriPath)
+{
+    otError     error = OT_ERROR_NONE;
+    const char *segment = aUriPath;
+
+    while (error == OT_ERROR_NONE && *segment != '\0')
+    {
+        const char *end = strchr(segment, '/');
+        size_t      length = (end != NULL) ? (size_t)(end - segment)
+                                           : strlen(segment);
+
+        if (length > 0)
+        {
+            error = appendOption(aHeader, OT_COAP_OPTION_URI_PATH,
+                                 (uint16_t)length, segment);
+        }
+        segment += length;
+        if (*segment == '/')
+        {
+            segment++;
+        }
+    }
+
+    return (error);
+}
+
+void otCoapHeaderSetPayloadMarker(otCoapHeader *aHeader)
+{
+    if (aHeader->mHeaderLength < sizeof(aHeader->mHeader))
+    {
+        aHeader->mHeader[aHeader->mHeaderLength++] = COAP_PAYLOAD_MARKER;
+    }
+}
+
+void otCoapHeaderSetMessageId(otCoapHeader *aHeader, uint16_t aMessageId)
+{
+    aHeader->mHeader[2] = (uint8_t)(aMessageId >> 8);
+    aHeader->mHeader[3] = (uint8_t)aMessageId;
+}
+
+otCoapType otCoapHeaderGetType(const otCoapHeader *aHeader)
+{
+    return ((otCoapType)((aHeader->mHeader[0] >> 4) & 0x3));
+}
+
+otCoapCode otCoapHeaderGetCode(const otCoapHeader *aHeader)
+{
+    return ((otCoapCode)aHeader->mHeader[1]);
+}
+
+uint16_t otCoapHeaderGetMessageId(const otCoapHeader *aHeader)
+{
+    return ((uint16_t)((aHeader->mHeader[2] << 8) | aHeader->mHeader[3]));
+}
+
+uint8_t otCoapHeaderGetTokenLength(const otCoapHeader *aHeader)
+{
+    return (aHeader->mHeader[0] & 0xf);
+}
+
+const uint8_t *otCoapHeaderGetToken(const otCoapHeader *aHeader)
+{
+    return (&aHeader->mHeader[4]);
+}
+
+const otCoapOption *otCoapHeaderGetFirstOption(otCoapHeader *aHeader)
+{
+    aHeader->mOption.mNumber   = 0;
+    aHeader->mNextOptionOffset = 4 + (aHeader->mHeader[0] & 0xf);
+    return (optionNext(aHeader));
+}
+
+const otCoapOption *otCoapHeaderGetNextOption(otCoapHeader *aHeader)
+{
+    return (optionNext(aHeader));
+}
+
+otMessage *otCoapNewMessage(otInstance *aInstance, const otCoapHeader *aHeader)
+{
+    otMessage *message = messageNew();
+
+    (void)aInstance;
+
+    if (message != NULL)
+    {
+        memcpy(message->buf, aHeader->mHeader, aHeader->mHeaderLength);
+        message->length = aHeader->mHeaderLength;
+        message->offset = aHeader->mHeaderLength;
+    }
+
+    return (message);
+}
+
+otError otCoapSendRequest(otInstance *aInstance, otMessage *aMessage,
+                          const otMessageInfo *aMessageInfo,
+                          otCoapResponseHandler aHandler, void *aContext)
+{
+    (void)aInstance;
+
+    if (aHandler != NULL)
+    {
+        SimPending *pending = NULL;
+        unsigned    i;
+
+        for (i = 0; i < SIM_MAX_PENDING && pending == NULL; i++)
+        {
+            if (!simPending[i].used)
+            {
+                pending = &simPending[i];
+            }
+        }
+        if (pending == NULL)
+        {
+            return (OT_ERROR_NO_BUFS);
+        }
+
+        pending->used        = true;
+        pending->tokenLength = aMessage->buf[0] & 0xf;
+        memcpy(pending->token, &aMessage->buf[4], pending->tokenLength);
+        pending->deadlineUs  = simNowUs() + SIM_RESPONSE_TIMEOUT * 1000U;
+        pending->handler     = aHandler;
+        pending->context     = aContext;
+        clockStartMs(&simPendingClockStruct, SIM_RESPONSE_TIMEOUT);
+    }
+
+    return (coapSend(aMessage, aMessageInfo));
+}
+
+otError otCoapStart(otInstance *aInstance, uint16_t aPort)
+{
+    (void)aInstance;
+    (void)aPort;
+
+    return (OT_ERROR_NONE);
+}
+
+otError otCoapStop(otInstance *aInstance)
+{
+    (void)aInstance;
+
+    return (OT_ERROR_NONE);
+}
+
+otError otCoapAddResource(otInstance *aInstance, otCoapResource *aResource)
+{
+    unsigned i;
+
+    (void)aInstance;
+
+    for (i = 0; i < SIM_MAX_RESOURCES; i++)
+    {
+        if (simResources[i] == aResource)
+        {
+            return (OT_ERROR_ALREADY);
+        }
+    }
+    for (i = 0; i < SIM_MAX_RESOURCES; i++)
+    {
+        if (simResources[i] == NULL)
+        {
+            simResources[i] = aResource;
+            return (OT_ERROR_NONE);
+        }
+    }
+
+    return (OT_ERROR_NO_BUFS);
+}
+
+void otCoapRemoveResource(otInstance *aInstance, otCoapResource *aResource)
+{
+    unsigned i;
+
+    (void)aInstance;
+
+    for (i = 0; i < SIM_MAX_RESOURCES; i++)
+    {
+        if (simResources[i] == aResource)
+        {
+            simResources[i] = NULL;
+        }
+    }
+}
+
+otError otCoapSendResponse(otInstance *aInstance, otMessage *aMessage,
+                           const otMessageInfo *aMessageInfo)
+{
+    (void)aInstance;
+
+    return (coapSend(aMessage, aMessageInfo));
+}